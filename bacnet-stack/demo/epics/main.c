@@ -252,7 +252,7 @@ void MyRejectHandler(
 
 void MyReadPropertyAckHandler(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
@@ -282,7 +282,7 @@ void MyReadPropertyAckHandler(
 
 void MyReadPropertyMultipleAckHandler(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
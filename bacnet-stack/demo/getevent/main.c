@@ -128,7 +128,7 @@ void MyRejectHandler(
  */
 void My_Get_Event_Ack_Handler(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
@@ -52,27 +52,31 @@
 #if defined(BACFILE)
 void handler_atomic_read_file_ack(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
     int len = 0;
     BACNET_ATOMIC_READ_FILE_DATA data;
+    /* the file data is not copied - it points into the service_request */
+    BACNET_OCTET_STRING_VIEW file_data[BACNET_READ_FILE_RECORD_COUNT];
     uint32_t instance = 0;
 
     (void) src;
     /* get the file instance from the tsm data before freeing it */
     instance = bacfile_instance_from_tsm(service_data->invoke_id);
-    len = arf_ack_decode_service_request(service_request, service_len, &data);
+    len =
+        arf_ack_decode_service_request_view(service_request, service_len,
+        &data, file_data);
 #if PRINT_ENABLED
     fprintf(stderr, "Received Read-File Ack!\n");
 #endif
     if ((len > 0) && (instance <= BACNET_MAX_INSTANCE)) {
         /* write the data received to the file specified */
         if (data.access == FILE_STREAM_ACCESS) {
-            bacfile_read_ack_stream_data(instance, &data);
+            bacfile_read_ack_stream_data_view(instance, &data, file_data);
         } else if (data.access == FILE_RECORD_ACCESS) {
-            bacfile_read_ack_record_data(instance, &data);
+            bacfile_read_ack_record_data_view(instance, &data, file_data);
         }
     }
 }
@@ -83,6 +83,8 @@ void handler_atomic_write_file(
     BACNET_CONFIRMED_SERVICE_DATA * service_data)
 {
     BACNET_ATOMIC_WRITE_FILE_DATA data;
+    /* the file data is not copied - it points into the service_request */
+    BACNET_OCTET_STRING_VIEW file_data[BACNET_WRITE_FILE_RECORD_COUNT];
     int len = 0;
     int pdu_len = 0;
     bool error = false;
@@ -111,7 +113,9 @@ void handler_atomic_write_file(
 #endif
         goto AWF_ABORT;
     }
-    len = awf_decode_service_request(service_request, service_len, &data);
+    len =
+        awf_decode_service_request_view(service_request, service_len, &data,
+        file_data);
     /* bad decoding - send an abort */
     if (len < 0) {
         len =
@@ -126,11 +130,11 @@ void handler_atomic_write_file(
         if (!bacfile_valid_instance(data.object_instance)) {
             error = true;
         } else if (data.access == FILE_STREAM_ACCESS) {
-            if (bacfile_write_stream_data(&data)) {
+            if (bacfile_write_stream_data_view(&data, file_data)) {
 #if PRINT_ENABLED
                 fprintf(stderr, "AWF: Stream offset %d, %d bytes\n",
                     data.type.stream.fileStartPosition,
-                    (int)octetstring_length(&data.fileData[0]));
+                    (int) file_data[0].length);
 #endif
                 len =
                     awf_ack_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
@@ -141,7 +145,7 @@ void handler_atomic_write_file(
                 error_code = ERROR_CODE_FILE_ACCESS_DENIED;
             }
         } else if (data.access == FILE_RECORD_ACCESS) {
-            if (bacfile_write_record_data(&data)) {
+            if (bacfile_write_record_data_view(&data, file_data)) {
 #if PRINT_ENABLED
                 fprintf(stderr, "AWF: StartRecord %d, RecordCount %u\n",
                     data.type.record.fileStartRecord,
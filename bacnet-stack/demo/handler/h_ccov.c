@@ -36,6 +36,7 @@
 #include "abort.h"
 /* special for this module */
 #include "cov.h"
+#include "propcache.h"
 #include "bactext.h"
 #include "handlers.h"
 
@@ -45,6 +46,18 @@
 
 /** @file h_ccov.c  Handles Confirmed COV Notifications. */
 
+static cov_notification_function COV_Notification_Function;
+
+/** Set a function to be called with each notification, after the
+ *  property cache has been updated from it.
+ * @param pFunction [in] the function, or NULL for none
+ */
+void handler_ccov_notification_set(
+    cov_notification_function pFunction)
+{
+    COV_Notification_Function = pFunction;
+}
+
 /*  */
 /** Handler for an Confirmed COV Notification.
  * @ingroup DSCOV
@@ -111,6 +124,13 @@ void handler_ccov_notification(
     len =
         cov_notify_decode_service_request(service_request, service_len,
         &cov_data);
+    if (len > 0) {
+        /* the values stay fresh for the rest of the subscription */
+        property_cache_cov(&cov_data);
+        if (COV_Notification_Function) {
+            COV_Notification_Function(&cov_data);
+        }
+    }
 #if PRINT_ENABLED
     if (len > 0) {
         fprintf(stderr, "CCOV: PID=%u ", cov_data.subscriberProcessIdentifier);
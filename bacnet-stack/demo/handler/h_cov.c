@@ -23,6 +23,7 @@
 *
 *********************************************************************/
 #include <stddef.h>
+#include <stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
@@ -40,6 +41,7 @@
 #include "cov.h"
 #include "tsm.h"
 #include "dcc.h"
+#include "hashindex.h"
 #if PRINT_ENABLED
 #include "bactext.h"
 #endif
@@ -49,8 +51,31 @@
 
 /** @file h_cov.c  Handles Change of Value (COV) services. */
 
+/* The subscriptions are indexed by the monitored object:
+   - each monitored object has a list of its subscriptions, and the
+     objects are found in a hash table by object identifier,
+   - objects report a change with handler_cov_object_changed(), which
+     puts the object on the dirty queue if it is subscribed to,
+   - the subscriptions that need a notification sit on the send queue,
+     and those waiting for a confirmation sit on the confirm queue.
+   So handler_cov_task() only does work for the objects that changed.
+   The tables grow as needed, up to the MAX_COV_ limits.
+   The links hold the index plus one, so that zero is "none".
+   When batching is enabled, the notifications queued for the same
+   subscriber are sent together in one COVNotificationMultiple. */
+
+/* does the subscriber support the COVNotificationMultiple services? */
+typedef enum {
+    COV_MULTIPLE_UNKNOWN = 0,
+    COV_MULTIPLE_SUPPORTED,
+    COV_MULTIPLE_UNSUPPORTED
+} BACNET_COV_MULTIPLE_SUPPORT;
+
 typedef struct BACnet_COV_Address {
     bool valid:1;
+    uint8_t multiple;
+    /* number of subscriptions that use this address */
+    unsigned subscriptions;
     BACNET_ADDRESS dest;
 } BACNET_COV_ADDRESS;
 
@@ -60,25 +85,242 @@ typedef struct BACnet_COV_Subscription_Flags {
     bool valid:1;
     bool issueConfirmedNotifications:1; /* optional */
     bool send_requested:1;
+    /* on the send queue or the confirm queue */
+    bool send_queued:1;
+    bool confirm_queued:1;
+    /* sent in the COVNotificationMultiple of another subscription */
+    bool batched:1;
+    /* the COVNotificationMultiple was acknowledged */
+    bool batch_acked:1;
 } BACNET_COV_SUBSCRIPTION_FLAGS;
 
 typedef struct BACnet_COV_Subscription {
     BACNET_COV_SUBSCRIPTION_FLAGS flag;
-    uint8_t dest_index;
+    uint16_t dest_index;
     uint8_t invokeID;   /* for confirmed COV */
     uint32_t subscriberProcessIdentifier;
     uint32_t lifetime;  /* optional */
     BACNET_OBJECT_ID monitoredObjectIdentifier;
+    /* next subscription of the object, or on the free list */
+    unsigned next;
+    /* next subscription on the send queue or the confirm queue */
+    unsigned next_send;
+    unsigned next_confirm;
+    /* next subscription sent in the same COVNotificationMultiple */
+    unsigned next_batch;
 } BACNET_COV_SUBSCRIPTION;
 
+/* a monitored object and the list of its subscriptions */
+typedef struct BACnet_COV_Object {
+    bool valid:1;
+    /* on the dirty queue */
+    bool dirty:1;
+    BACNET_OBJECT_ID object_id;
+    unsigned subscriptions;
+    /* next object in the hash chain, or on the free list */
+    unsigned next;
+    unsigned next_dirty;
+} BACNET_COV_OBJECT;
+
+/* a queue of table entries, linked by index plus one */
+typedef struct BACnet_COV_Queue {
+    unsigned head;
+    unsigned tail;
+} BACNET_COV_QUEUE;
+
 #ifndef MAX_COV_SUBCRIPTIONS
-#define MAX_COV_SUBCRIPTIONS 128
+#define MAX_COV_SUBCRIPTIONS 65535
 #endif
-static BACNET_COV_SUBSCRIPTION COV_Subscriptions[MAX_COV_SUBCRIPTIONS];
 #ifndef MAX_COV_ADDRESSES
-#define MAX_COV_ADDRESSES 16
+#define MAX_COV_ADDRESSES 255
+#endif
+/* the tables start this big, and double when they are full */
+#define COV_TABLE_SIZE_INITIAL 16
+#ifndef COV_BATCH_MAX_NOTIFICATIONS
+#define COV_BATCH_MAX_NOTIFICATIONS 32
+#endif
+/* the largest COVNotificationMultiple, since the max APDU of the
+   subscriber is not known */
+#ifndef COV_BATCH_MAX_APDU
+#if (MAX_APDU < 480)
+#define COV_BATCH_MAX_APDU MAX_APDU
+#else
+#define COV_BATCH_MAX_APDU 480
+#endif
 #endif
-static BACNET_COV_ADDRESS COV_Addresses[MAX_COV_ADDRESSES];
+
+static BACNET_COV_SUBSCRIPTION *COV_Subscriptions;
+static unsigned COV_Subscriptions_Size;
+/* entries from here up have never been used */
+static unsigned COV_Subscriptions_Used;
+static unsigned COV_Subscriptions_Free;
+static BACNET_COV_OBJECT *COV_Objects;
+static unsigned COV_Objects_Size;
+static unsigned COV_Objects_Used;
+static unsigned COV_Objects_Free;
+/* object hash table, the same size as the object table */
+static unsigned *COV_Object_Hash;
+static BACNET_COV_ADDRESS *COV_Addresses;
+static unsigned COV_Addresses_Size;
+static BACNET_COV_QUEUE COV_Dirty_Queue;
+static BACNET_COV_QUEUE COV_Send_Queue;
+static BACNET_COV_QUEUE COV_Confirm_Queue;
+/* batching of the notifications */
+static bool COV_Batching;
+static uint16_t COV_Batch_Window;
+static uint16_t COV_Batch_Timer;
+static BACNET_COV_BATCH_COUNTERS COV_Batch_Counters;
+
+/* doubles the size of a table of entries, up to the limit */
+static bool cov_table_grow(
+    void **table,
+    unsigned *size,
+    size_t entry_size,
+    unsigned limit)
+{
+    unsigned new_size = 0;
+    void *new_table = NULL;
+
+    if (*size >= limit) {
+        return false;
+    }
+    new_size = *size ? (*size * 2) : COV_TABLE_SIZE_INITIAL;
+    if (new_size > limit) {
+        new_size = limit;
+    }
+    new_table = realloc(*table, new_size * entry_size);
+    if (!new_table) {
+        return false;
+    }
+    memset((uint8_t *) new_table + (*size * entry_size), 0,
+        (new_size - *size) * entry_size);
+    *table = new_table;
+    *size = new_size;
+
+    return true;
+}
+
+static unsigned cov_object_hash(
+    BACNET_OBJECT_ID * object_id)
+{
+    uint32_t key = ((uint32_t) object_id->type << 22) | object_id->instance;
+
+    return (unsigned) (hash_index_mix(key) % COV_Objects_Size);
+}
+
+static void cov_object_hash_insert(
+    unsigned index)
+{
+    unsigned hash = cov_object_hash(&COV_Objects[index].object_id);
+
+    COV_Objects[index].next = COV_Object_Hash[hash];
+    COV_Object_Hash[hash] = index + 1;
+}
+
+/* grows the object table, and rebuilds the hash table for its size */
+static bool cov_object_table_grow(
+    void)
+{
+    unsigned *hash_table = NULL;
+    unsigned index = 0;
+    unsigned limit = MAX_COV_SUBCRIPTIONS;
+
+    if (!cov_table_grow((void **) &COV_Objects, &COV_Objects_Size,
+            sizeof(BACNET_COV_OBJECT), limit)) {
+        return false;
+    }
+    hash_table = realloc(COV_Object_Hash, COV_Objects_Size * sizeof(unsigned));
+    if (!hash_table) {
+        return false;
+    }
+    COV_Object_Hash = hash_table;
+    memset(COV_Object_Hash, 0, COV_Objects_Size * sizeof(unsigned));
+    for (index = 0; index < COV_Objects_Used; index++) {
+        if (COV_Objects[index].valid) {
+            cov_object_hash_insert(index);
+        }
+    }
+
+    return true;
+}
+
+/* returns the object index plus one, or zero if not subscribed to */
+static unsigned cov_object_find(
+    BACNET_OBJECT_ID * object_id)
+{
+    unsigned next = 0;
+    BACNET_COV_OBJECT *pObject = NULL;
+
+    if (COV_Objects_Size == 0) {
+        return 0;
+    }
+    next = COV_Object_Hash[cov_object_hash(object_id)];
+    while (next) {
+        pObject = &COV_Objects[next - 1];
+        if ((pObject->object_id.type == object_id->type) &&
+            (pObject->object_id.instance == object_id->instance)) {
+            break;
+        }
+        next = pObject->next;
+    }
+
+    return next;
+}
+
+/* returns the object index plus one, or zero if out of resources */
+static unsigned cov_object_add(
+    BACNET_OBJECT_ID * object_id)
+{
+    unsigned index = 0;
+
+    index = cov_object_find(object_id);
+    if (index) {
+        return index;
+    }
+    if (COV_Objects_Free) {
+        index = COV_Objects_Free - 1;
+        COV_Objects_Free = COV_Objects[index].next;
+    } else {
+        if ((COV_Objects_Used >= COV_Objects_Size) &&
+            (!cov_object_table_grow())) {
+            return 0;
+        }
+        index = COV_Objects_Used++;
+    }
+    COV_Objects[index].valid = true;
+    COV_Objects[index].dirty = false;
+    COV_Objects[index].object_id.type = object_id->type;
+    COV_Objects[index].object_id.instance = object_id->instance;
+    COV_Objects[index].subscriptions = 0;
+    COV_Objects[index].next_dirty = 0;
+    cov_object_hash_insert(index);
+
+    return index + 1;
+}
+
+/* frees an object without subscriptions, unless it is on the dirty
+   queue, where it is freed when it is taken off */
+static void cov_object_remove_unused(
+    unsigned index)
+{
+    unsigned *next = NULL;
+    BACNET_COV_OBJECT *pObject = &COV_Objects[index];
+
+    if ((!pObject->valid) || (pObject->subscriptions) || (pObject->dirty)) {
+        return;
+    }
+    next = &COV_Object_Hash[cov_object_hash(&pObject->object_id)];
+    while (*next) {
+        if (*next == (index + 1)) {
+            *next = pObject->next;
+            break;
+        }
+        next = &COV_Objects[*next - 1].next;
+    }
+    pObject->valid = false;
+    pObject->next = COV_Objects_Free;
+    COV_Objects_Free = index + 1;
+}
 
 /**
 * Gets the address from the list of COV addresses
@@ -89,11 +331,11 @@ static BACNET_COV_ADDRESS COV_Addresses[MAX_COV_ADDRESSES];
 * @return true if valid address, false if not valid or not found
 */
 static BACNET_ADDRESS *cov_address_get(
-    int index)
+    unsigned index)
 {
     BACNET_ADDRESS *cov_dest = NULL;
 
-    if (index < MAX_COV_ADDRESSES) {
+    if (index < COV_Addresses_Size) {
         if (COV_Addresses[index].valid) {
             cov_dest = &COV_Addresses[index].dest;
         }
@@ -103,35 +345,24 @@ static BACNET_ADDRESS *cov_address_get(
 }
 
 /**
- * Removes the address from the list of COV addresses, if it is not
- * used by other COV subscriptions
+ * Removes a subscription from the address, and the address from the
+ * list of COV addresses if no other COV subscriptions use it
  */
-static void cov_address_remove_unused(
-    void)
+static void cov_address_remove(
+    unsigned index)
 {
-    unsigned index = 0;
-    unsigned cov_index = 0;
-    bool found = false;
-
-    for (cov_index = 0; cov_index < MAX_COV_ADDRESSES; cov_index++) {
-        if (COV_Addresses[cov_index].valid) {
-            found = false;
-            for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-                if ((COV_Subscriptions[index].flag.valid) &&
-                    (COV_Subscriptions[index].dest_index == cov_index)) {
-                    found = true;
-                    break;
-                }
-            }
-            if (!found) {
-                COV_Addresses[cov_index].valid = false;
-            }
+    if ((index < COV_Addresses_Size) && (COV_Addresses[index].valid)) {
+        if (COV_Addresses[index].subscriptions) {
+            COV_Addresses[index].subscriptions--;
+        }
+        if (COV_Addresses[index].subscriptions == 0) {
+            COV_Addresses[index].valid = false;
         }
     }
 }
 
 /**
-* Adds the address to the list of COV addresses
+* Adds a subscription to the address in the list of COV addresses
 *
 * @param  dest - address to be added if there is room in the list
 *
@@ -147,7 +378,7 @@ static int cov_address_add(
     BACNET_ADDRESS *cov_dest = NULL;
 
     if (dest) {
-        for (i = 0; i < MAX_COV_ADDRESSES; i++) {
+        for (i = 0; i < COV_Addresses_Size; i++) {
             valid = COV_Addresses[i].valid;
             if (valid) {
                 cov_dest = &COV_Addresses[i].dest;
@@ -160,22 +391,209 @@ static int cov_address_add(
         }
         if (!found) {
             /* find a free place to add a new address */
-            for (i = 0; i < MAX_COV_ADDRESSES; i++) {
-                valid = COV_Addresses[i].valid;
-                if (!valid) {
+            for (i = 0; i < COV_Addresses_Size; i++) {
+                if (!COV_Addresses[i].valid) {
                     index = i;
-                    cov_dest = &COV_Addresses[i].dest;
-                    bacnet_address_copy(cov_dest, dest);
-                    COV_Addresses[i].valid = true;
                     break;
                 }
             }
+            if ((index < 0) && (cov_table_grow((void **) &COV_Addresses,
+                        &COV_Addresses_Size, sizeof(BACNET_COV_ADDRESS),
+                        MAX_COV_ADDRESSES))) {
+                index = i;
+            }
+            if (index >= 0) {
+                cov_dest = &COV_Addresses[index].dest;
+                bacnet_address_copy(cov_dest, dest);
+                COV_Addresses[index].valid = true;
+                COV_Addresses[index].multiple = COV_MULTIPLE_UNKNOWN;
+                COV_Addresses[index].subscriptions = 0;
+            }
+        }
+        if (index >= 0) {
+            COV_Addresses[index].subscriptions++;
         }
     }
 
     return index;
 }
 
+/* takes a free subscription - returns the index plus one, or zero */
+static unsigned cov_subscription_alloc(
+    void)
+{
+    unsigned index = 0;
+
+    if (COV_Subscriptions_Free) {
+        index = COV_Subscriptions_Free - 1;
+        COV_Subscriptions_Free = COV_Subscriptions[index].next;
+    } else {
+        if ((COV_Subscriptions_Used >= COV_Subscriptions_Size) &&
+            (!cov_table_grow((void **) &COV_Subscriptions,
+                    &COV_Subscriptions_Size, sizeof(BACNET_COV_SUBSCRIPTION),
+                    MAX_COV_SUBCRIPTIONS))) {
+            return 0;
+        }
+        index = COV_Subscriptions_Used++;
+    }
+    memset(&COV_Subscriptions[index], 0, sizeof(BACNET_COV_SUBSCRIPTION));
+
+    return index + 1;
+}
+
+/* puts an invalid subscription on the free list, once it is off
+   the queues */
+static void cov_subscription_free_unused(
+    unsigned index)
+{
+    BACNET_COV_SUBSCRIPTION *pSub = &COV_Subscriptions[index];
+
+    if ((!pSub->flag.valid) && (!pSub->flag.send_queued) &&
+        (!pSub->flag.confirm_queued) && (!pSub->flag.batched)) {
+        pSub->next = COV_Subscriptions_Free;
+        COV_Subscriptions_Free = index + 1;
+    }
+}
+
+/* stops the confirmed notification of the subscription, unless it
+   was sent in a COVNotificationMultiple for other subscriptions too */
+static void cov_invoke_id_release(
+    unsigned index)
+{
+    BACNET_COV_SUBSCRIPTION *pSub = &COV_Subscriptions[index];
+
+    if ((pSub->invokeID) && (!pSub->flag.batched) && (!pSub->next_batch)) {
+        tsm_free_invoke_id(pSub->invokeID);
+        pSub->invokeID = 0;
+    }
+}
+
+/* cancels the subscription */
+static void cov_subscription_remove(
+    unsigned index)
+{
+    BACNET_COV_SUBSCRIPTION *pSub = &COV_Subscriptions[index];
+    unsigned object_index = 0;
+    unsigned *next = NULL;
+
+    if (!pSub->flag.valid) {
+        return;
+    }
+    object_index = cov_object_find(&pSub->monitoredObjectIdentifier);
+    if (object_index) {
+        next = &COV_Objects[object_index - 1].subscriptions;
+        while (*next) {
+            if (*next == (index + 1)) {
+                *next = pSub->next;
+                break;
+            }
+            next = &COV_Subscriptions[*next - 1].next;
+        }
+        cov_object_remove_unused(object_index - 1);
+    }
+    cov_address_remove(pSub->dest_index);
+    cov_invoke_id_release(index);
+    pSub->flag.valid = false;
+    pSub->flag.send_requested = false;
+    pSub->next = 0;
+    cov_subscription_free_unused(index);
+}
+
+/* the link of an entry to the next entry on the queue */
+static unsigned *cov_queue_link(
+    BACNET_COV_QUEUE * queue,
+    unsigned index)
+{
+    if (queue == &COV_Dirty_Queue) {
+        return &COV_Objects[index].next_dirty;
+    } else if (queue == &COV_Send_Queue) {
+        return &COV_Subscriptions[index].next_send;
+    }
+
+    return &COV_Subscriptions[index].next_confirm;
+}
+
+static void cov_queue_add(
+    BACNET_COV_QUEUE * queue,
+    unsigned index)
+{
+    *cov_queue_link(queue, index) = 0;
+    if (queue->tail) {
+        *cov_queue_link(queue, queue->tail - 1) = index + 1;
+    } else {
+        queue->head = index + 1;
+    }
+    queue->tail = index + 1;
+}
+
+/* takes the head off the queue - returns the index plus one, or zero */
+static unsigned cov_queue_remove(
+    BACNET_COV_QUEUE * queue)
+{
+    unsigned head = queue->head;
+
+    if (head) {
+        queue->head = *cov_queue_link(queue, head - 1);
+        if (queue->head == 0) {
+            queue->tail = 0;
+        }
+    }
+
+    return head;
+}
+
+static void cov_send_queue_add(
+    unsigned index)
+{
+    BACNET_COV_SUBSCRIPTION *pSub = &COV_Subscriptions[index];
+
+    pSub->flag.send_requested = true;
+    if (!pSub->flag.send_queued) {
+        if (COV_Batching && (COV_Send_Queue.head == 0)) {
+            /* collect the notifications for a while */
+            COV_Batch_Timer = COV_Batch_Window;
+        }
+        pSub->flag.send_queued = true;
+        cov_queue_add(&COV_Send_Queue, index);
+    }
+}
+
+static void cov_confirm_queue_add(
+    unsigned index)
+{
+    BACNET_COV_SUBSCRIPTION *pSub = &COV_Subscriptions[index];
+
+    if (!pSub->flag.confirm_queued) {
+        pSub->flag.confirm_queued = true;
+        cov_queue_add(&COV_Confirm_Queue, index);
+    }
+}
+
+/** Handler for the objects to report that a COV of theirs changed,
+ * so that a notification is sent to their subscribers.
+ * @ingroup DSCOV
+ * Called from the COV detection of the objects when they set their
+ * COV flag, e.g. Analog_Input_COV_Detect().
+ * @param object_type [in] the BACNET_OBJECT_TYPE of the object
+ * @param object_instance [in] the instance number of the object
+ */
+void handler_cov_object_changed(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    BACNET_OBJECT_ID object_id;
+    unsigned index = 0;
+
+    object_id.type = object_type;
+    object_id.instance = object_instance;
+    index = cov_object_find(&object_id);
+    if (index && (!COV_Objects[index - 1].dirty)) {
+        COV_Objects[index - 1].dirty = true;
+        cov_queue_add(&COV_Dirty_Queue, index - 1);
+    }
+}
+
+
 /*
 BACnetCOVSubscription ::= SEQUENCE {
 Recipient [0] BACnetRecipientProcess,
@@ -309,7 +727,7 @@ int handler_cov_encode_subscriptions(
     unsigned index = 0;
 
     if (apdu) {
-        for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
+        for (index = 0; index < COV_Subscriptions_Used; index++) {
             if (COV_Subscriptions[index].flag.valid) {
                 len =
                     cov_encode_subscription(&apdu[apdu_len],
@@ -332,23 +750,26 @@ int handler_cov_encode_subscriptions(
 void handler_cov_init(
     void)
 {
-    unsigned index = 0;
-
-    for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-        COV_Subscriptions[index].flag.valid = false;
-        COV_Subscriptions[index].dest_index = -1;
-        COV_Subscriptions[index].subscriberProcessIdentifier = 0;
-        COV_Subscriptions[index].monitoredObjectIdentifier.type =
-            OBJECT_ANALOG_INPUT;
-        COV_Subscriptions[index].monitoredObjectIdentifier.instance = 0;
-        COV_Subscriptions[index].flag.issueConfirmedNotifications = false;
-        COV_Subscriptions[index].invokeID = 0;
-        COV_Subscriptions[index].lifetime = 0;
-        COV_Subscriptions[index].flag.send_requested = false;
-    }
-    for (index = 0; index < MAX_COV_ADDRESSES; index++) {
-        COV_Addresses[index].valid = false;
-    }
+    free(COV_Subscriptions);
+    COV_Subscriptions = NULL;
+    COV_Subscriptions_Size = 0;
+    COV_Subscriptions_Used = 0;
+    COV_Subscriptions_Free = 0;
+    free(COV_Objects);
+    COV_Objects = NULL;
+    COV_Objects_Size = 0;
+    COV_Objects_Used = 0;
+    COV_Objects_Free = 0;
+    free(COV_Object_Hash);
+    COV_Object_Hash = NULL;
+    free(COV_Addresses);
+    COV_Addresses = NULL;
+    COV_Addresses_Size = 0;
+    COV_Dirty_Queue.head = COV_Dirty_Queue.tail = 0;
+    COV_Send_Queue.head = COV_Send_Queue.tail = 0;
+    COV_Confirm_Queue.head = COV_Confirm_Queue.tail = 0;
+    COV_Batch_Timer = 0;
+    memset(&COV_Batch_Counters, 0, sizeof(COV_Batch_Counters));
 }
 
 static bool cov_list_subscribe(
@@ -357,86 +778,95 @@ static bool cov_list_subscribe(
     BACNET_ERROR_CLASS * error_class,
     BACNET_ERROR_CODE * error_code)
 {
-    bool existing_entry = false;
-    int index;
-    int first_invalid_index = -1;
     bool found = true;
     bool address_match = false;
+    unsigned object_index = 0;
+    unsigned next = 0;
+    unsigned index = 0;
+    int dest_index = 0;
     BACNET_ADDRESS *dest = NULL;
+    BACNET_COV_SUBSCRIPTION *pSub = NULL;
 
     /* unable to subscribe - resources? */
     /* unable to cancel subscription - other? */
 
     /* existing? - match Object ID and Process ID and address */
-    for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
-        if (COV_Subscriptions[index].flag.valid) {
-            dest = cov_address_get(COV_Subscriptions[index].dest_index);
-            if (dest) {
-                address_match = bacnet_address_same(src, dest);
-            } else {
-                /* skip address matching - we don't have an address */
-                address_match = true;
-            }
-            if ((COV_Subscriptions[index].monitoredObjectIdentifier.type ==
-                    cov_data->monitoredObjectIdentifier.type) &&
-                (COV_Subscriptions[index].monitoredObjectIdentifier.instance ==
-                    cov_data->monitoredObjectIdentifier.instance) &&
-                (COV_Subscriptions[index].subscriberProcessIdentifier ==
-                    cov_data->subscriberProcessIdentifier) && address_match) {
-                existing_entry = true;
-                if (cov_data->cancellationRequest) {
-                    COV_Subscriptions[index].flag.valid = false;
-                    COV_Subscriptions[index].dest_index = -1;
-                    cov_address_remove_unused();
-                } else {
-                    COV_Subscriptions[index].dest_index = cov_address_add(src);
-                    COV_Subscriptions[index].flag.issueConfirmedNotifications =
-                        cov_data->issueConfirmedNotifications;
-                    COV_Subscriptions[index].lifetime = cov_data->lifetime;
-                    COV_Subscriptions[index].flag.send_requested = true;
-                }
-                if (COV_Subscriptions[index].invokeID) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
-                }
-                break;
-            }
+    object_index = cov_object_find(&cov_data->monitoredObjectIdentifier);
+    if (object_index) {
+        next = COV_Objects[object_index - 1].subscriptions;
+    }
+    while (next) {
+        pSub = &COV_Subscriptions[next - 1];
+        dest = cov_address_get(pSub->dest_index);
+        if (dest) {
+            address_match = bacnet_address_same(src, dest);
         } else {
-            if (first_invalid_index < 0) {
-                first_invalid_index = index;
-            }
+            /* skip address matching - we don't have an address */
+            address_match = true;
+        }
+        if ((pSub->subscriberProcessIdentifier ==
+                cov_data->subscriberProcessIdentifier) && address_match) {
+            break;
         }
+        next = pSub->next;
     }
-    if (!existing_entry && (first_invalid_index >= 0) &&
-        (!cov_data->cancellationRequest)) {
-        index = first_invalid_index;
+    if (next) {
+        index = next - 1;
+        if (cov_data->cancellationRequest) {
+            cov_subscription_remove(index);
+        } else {
+            cov_invoke_id_release(index);
+            pSub->flag.issueConfirmedNotifications =
+                cov_data->issueConfirmedNotifications;
+            pSub->lifetime = cov_data->lifetime;
+            cov_send_queue_add(index);
+        }
+    } else if (cov_data->cancellationRequest) {
+        /* cancellationRequest - valid object not subscribed */
+        /* From BACnet Standard 135-2010-13.14.2
+           ...Cancellations that are issued for which no matching COV
+           context can be found shall succeed as if a context had
+           existed, returning 'Result(+)'. */
         found = true;
-        COV_Subscriptions[index].flag.valid = true;
-        COV_Subscriptions[index].dest_index = cov_address_add(src);
-        COV_Subscriptions[index].monitoredObjectIdentifier.type =
-            cov_data->monitoredObjectIdentifier.type;
-        COV_Subscriptions[index].monitoredObjectIdentifier.instance =
-            cov_data->monitoredObjectIdentifier.instance;
-        COV_Subscriptions[index].subscriberProcessIdentifier =
-            cov_data->subscriberProcessIdentifier;
-        COV_Subscriptions[index].flag.issueConfirmedNotifications =
-            cov_data->issueConfirmedNotifications;
-        COV_Subscriptions[index].invokeID = 0;
-        COV_Subscriptions[index].lifetime = cov_data->lifetime;
-        COV_Subscriptions[index].flag.send_requested = true;
-    } else if (!existing_entry) {
-        if (first_invalid_index < 0) {
+    } else {
+        found = false;
+        object_index = cov_object_add(&cov_data->monitoredObjectIdentifier);
+        if (object_index) {
+            next = cov_subscription_alloc();
+            if (next) {
+                dest_index = cov_address_add(src);
+                if (dest_index < 0) {
+                    cov_subscription_free_unused(next - 1);
+                    next = 0;
+                }
+            }
+            if (next) {
+                found = true;
+                index = next - 1;
+                pSub = &COV_Subscriptions[index];
+                pSub->flag.valid = true;
+                pSub->dest_index = (uint16_t) dest_index;
+                pSub->monitoredObjectIdentifier.type =
+                    cov_data->monitoredObjectIdentifier.type;
+                pSub->monitoredObjectIdentifier.instance =
+                    cov_data->monitoredObjectIdentifier.instance;
+                pSub->subscriberProcessIdentifier =
+                    cov_data->subscriberProcessIdentifier;
+                pSub->flag.issueConfirmedNotifications =
+                    cov_data->issueConfirmedNotifications;
+                pSub->invokeID = 0;
+                pSub->lifetime = cov_data->lifetime;
+                pSub->next = COV_Objects[object_index - 1].subscriptions;
+                COV_Objects[object_index - 1].subscriptions = next;
+                cov_send_queue_add(index);
+            } else {
+                cov_object_remove_unused(object_index - 1);
+            }
+        }
+        if (!found) {
             /* Out of resources */
             *error_class = ERROR_CLASS_RESOURCES;
             *error_code = ERROR_CODE_NO_SPACE_TO_ADD_LIST_ELEMENT;
-            found = false;
-        } else {
-            /* cancellationRequest - valid object not subscribed */
-            /* From BACnet Standard 135-2010-13.14.2
-               ...Cancellations that are issued for which no matching COV
-               context can be found shall succeed as if a context had
-               existed, returning 'Result(+)'. */
-            found = true;
         }
     }
 
@@ -529,7 +959,7 @@ static void cov_lifetime_expiration_handler(
     uint32_t elapsed_seconds,
     uint32_t lifetime_seconds)
 {
-    if (index < MAX_COV_SUBCRIPTIONS) {
+    if (index < COV_Subscriptions_Used) {
         /* handle lifetime expiration */
         if (lifetime_seconds >= elapsed_seconds) {
             COV_Subscriptions[index].lifetime -= elapsed_seconds;
@@ -553,37 +983,18 @@ static void cov_lifetime_expiration_handler(
                 COV_Subscriptions[index].lifetime);
             fprintf(stderr, "\n");
 #endif
-            COV_Subscriptions[index].flag.valid = false;
-            COV_Subscriptions[index].dest_index = -1;
-            cov_address_remove_unused();
-            if (COV_Subscriptions[index].flag.issueConfirmedNotifications) {
-                if (COV_Subscriptions[index].invokeID) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
-                }
-            }
+            cov_subscription_remove(index);
         }
     }
 }
 
-/** Handler to check the list of subscribed objects for any that have changed
- *  and so need to have notifications sent.
+/** Handler to expire the COV subscriptions that have timed out.
  * @ingroup DSCOV
  * This handler will be invoked by the main program every second or so.
- * This example only handles Binary Inputs, but can be easily extended to
- * support other types.
- * For each subscribed object,
+ * For each subscription with a definite lifetime,
  *  - See if the subscription has timed out
  *    - Remove it if it has timed out.
- *  - See if the subscribed object instance has changed
- *    (eg, check with Binary_Input_Change_Of_Value() )
- *  - If changed,
- *    - Clear the COV (eg, Binary_Input_Change_Of_Value_Clear() )
- *    - Send the notice with cov_send_request()
- *      - Will be confirmed or unconfirmed, as per the subscription.
- *
- * @note worst case tasking: MS/TP with the ability to send only
- *        one notification per task cycle.
+ * The changed objects are handled by handler_cov_task().
  *
  * @param elapsed_seconds [in] How many seconds have elapsed since last called.
  */
@@ -595,7 +1006,7 @@ void handler_cov_timer_seconds(
 
     if (elapsed_seconds) {
         /* handle the subscription timeouts */
-        for (index = 0; index < MAX_COV_SUBCRIPTIONS; index++) {
+        for (index = 0; index < COV_Subscriptions_Used; index++) {
             if (COV_Subscriptions[index].flag.valid) {
                 lifetime_seconds = COV_Subscriptions[index].lifetime;
                 if (lifetime_seconds) {
@@ -608,140 +1019,448 @@ void handler_cov_timer_seconds(
     }
 }
 
-bool handler_cov_fsm(
-    void)
+/* marks the subscriptions of a changed object to be sent */
+static void cov_dirty_object_handler(
+    unsigned index)
 {
-    static int index = 0;
+    BACNET_COV_OBJECT *pObject = &COV_Objects[index];
     BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
     uint32_t object_instance = 0;
-    bool status = false;
-    bool send = false;
-    BACNET_PROPERTY_VALUE value_list[2];
-    /* states for transmitting */
-    static enum {
-        COV_STATE_IDLE = 0,
-        COV_STATE_MARK,
-        COV_STATE_CLEAR,
-        COV_STATE_FREE,
-        COV_STATE_SEND
-    } cov_task_state = COV_STATE_IDLE;
-
-    switch (cov_task_state) {
-        case COV_STATE_IDLE:
-            index = 0;
-            cov_task_state = COV_STATE_MARK;
-            break;
-        case COV_STATE_MARK:
-            /* mark any subscriptions where the value has changed */
-            if (COV_Subscriptions[index].flag.valid) {
-                object_type = (BACNET_OBJECT_TYPE)
-                    COV_Subscriptions[index].monitoredObjectIdentifier.type;
-                object_instance =
-                    COV_Subscriptions[index].
-                    monitoredObjectIdentifier.instance;
-                status = Device_COV(object_type, object_instance);
-                if (status) {
-                    COV_Subscriptions[index].flag.send_requested = true;
+    unsigned next = 0;
+
+    pObject->dirty = false;
+    if (!pObject->valid) {
+        return;
+    }
+    if (!pObject->subscriptions) {
+        cov_object_remove_unused(index);
+        return;
+    }
+    object_type = (BACNET_OBJECT_TYPE) pObject->object_id.type;
+    object_instance = pObject->object_id.instance;
+    if (Device_COV(object_type, object_instance)) {
 #if PRINT_ENABLED
-                    fprintf(stderr, "COVtask: Marking...\n");
+        fprintf(stderr, "COVtask: Marking...\n");
 #endif
+        next = pObject->subscriptions;
+        while (next) {
+            cov_send_queue_add(next - 1);
+            next = COV_Subscriptions[next - 1].next;
+        }
+        Device_COV_Clear(object_type, object_instance);
+    }
+}
+
+/* can the notification of the subscription go in a
+   COVNotificationMultiple? */
+static bool cov_multiple_enabled(
+    BACNET_COV_SUBSCRIPTION * pSub)
+{
+    uint8_t multiple = COV_MULTIPLE_UNKNOWN;
+
+    if ((!COV_Batching) || (pSub->dest_index >= COV_Addresses_Size)) {
+        return false;
+    }
+    multiple = COV_Addresses[pSub->dest_index].multiple;
+    if (pSub->flag.issueConfirmedNotifications) {
+        /* an unconfirmed notification is only sent when the subscriber
+           is known to support it, and the confirmed one finds out */
+        return (multiple != COV_MULTIPLE_UNSUPPORTED);
+    }
+
+    return (multiple == COV_MULTIPLE_SUPPORTED);
+}
+
+/* sends the notification of the subscription together with the other
+   notifications that are queued for the same subscriber.
+   Returns the number of notifications sent, which is zero if there is
+   no other notification to send with it, or if the send failed. */
+static unsigned cov_send_multiple(
+    unsigned index)
+{
+    static BACNET_COV_NOTIFICATION notification[COV_BATCH_MAX_NOTIFICATIONS];
+    static BACNET_PROPERTY_VALUE value_list[COV_BATCH_MAX_NOTIFICATIONS][2];
+    static uint8_t buffer[MAX_APDU];
+    unsigned member[COV_BATCH_MAX_NOTIFICATIONS];
+    BACNET_COV_SUBSCRIPTION *pSub = &COV_Subscriptions[index];
+    BACNET_COV_SUBSCRIPTION *pMember = NULL;
+    BACNET_COV_MULTIPLE_DATA cov_data;
+    BACNET_NPDU_DATA npdu_data;
+    BACNET_ADDRESS my_address;
+    BACNET_ADDRESS *dest = NULL;
+    unsigned count = 0;
+    unsigned next = index + 1;
+    unsigned i = 0;
+    int apdu_len = 0;
+    int len = 0;
+    int pdu_len = 0;
+    int bytes_sent = 0;
+    uint8_t invoke_id = 0;
+
+    if (!dcc_communication_enabled()) {
+        return 0;
+    }
+    dest = cov_address_get(pSub->dest_index);
+    if (!dest) {
+        return 0;
+    }
+    /* the service header, encoded with the largest values */
+    apdu_len = 4 + 5 + 5 + 5 + 2;
+    cov_data.timeRemaining = pSub->lifetime;
+    while (next && (count < COV_BATCH_MAX_NOTIFICATIONS)) {
+        pMember = &COV_Subscriptions[next - 1];
+        if ((count == 0) || ((pMember->flag.valid) &&
+                (pMember->flag.send_requested) &&
+                (pMember->dest_index == pSub->dest_index) &&
+                (pMember->subscriberProcessIdentifier ==
+                    pSub->subscriberProcessIdentifier) &&
+                (pMember->flag.issueConfirmedNotifications ==
+                    pSub->flag.issueConfirmedNotifications) &&
+                (pMember->invokeID == 0))) {
+            notification[count].monitoredObjectIdentifier =
+                pMember->monitoredObjectIdentifier;
+            notification[count].listOfValues = &value_list[count][0];
+            notification[count].next = NULL;
+            value_list[count][0].next = &value_list[count][1];
+            value_list[count][1].next = NULL;
+            if (Device_Encode_Value_List((BACNET_OBJECT_TYPE)
+                    pMember->monitoredObjectIdentifier.type,
+                    pMember->monitoredObjectIdentifier.instance,
+                    &value_list[count][0])) {
+                len = cov_notification_encode(&buffer[0],
+                    &notification[count]);
+                if ((apdu_len + len) > COV_BATCH_MAX_APDU) {
+                    break;
                 }
-            }
-            index++;
-            if (index >= MAX_COV_SUBCRIPTIONS) {
-                index = 0;
-                cov_task_state = COV_STATE_CLEAR;
-            }
-            break;
-        case COV_STATE_CLEAR:
-            /* clear the COV flag after checking all subscriptions */
-            if ((COV_Subscriptions[index].flag.valid) &&
-                (COV_Subscriptions[index].flag.send_requested)) {
-                object_type = (BACNET_OBJECT_TYPE)
-                    COV_Subscriptions[index].monitoredObjectIdentifier.type;
-                object_instance =
-                    COV_Subscriptions[index].
-                    monitoredObjectIdentifier.instance;
-                Device_COV_Clear(object_type, object_instance);
-            }
-            index++;
-            if (index >= MAX_COV_SUBCRIPTIONS) {
-                index = 0;
-                cov_task_state = COV_STATE_FREE;
-            }
-            break;
-        case COV_STATE_FREE:
-            /* confirmed notification house keeping */
-            if ((COV_Subscriptions[index].flag.valid) &&
-                (COV_Subscriptions[index].flag.issueConfirmedNotifications) &&
-                (COV_Subscriptions[index].invokeID)) {
-                if (tsm_invoke_id_free(COV_Subscriptions[index].invokeID)) {
-                    COV_Subscriptions[index].invokeID = 0;
-                } else
-                    if (tsm_invoke_id_failed(COV_Subscriptions
-                        [index].invokeID)) {
-                    tsm_free_invoke_id(COV_Subscriptions[index].invokeID);
-                    COV_Subscriptions[index].invokeID = 0;
+                apdu_len += len;
+                if (count) {
+                    notification[count - 1].next = &notification[count];
                 }
-            }
-            index++;
-            if (index >= MAX_COV_SUBCRIPTIONS) {
-                index = 0;
-                cov_task_state = COV_STATE_SEND;
-            }
-            break;
-        case COV_STATE_SEND:
-            /* send any COVs that are requested */
-            if ((COV_Subscriptions[index].flag.valid) &&
-                (COV_Subscriptions[index].flag.send_requested)) {
-                send = true;
-                if (COV_Subscriptions[index].flag.issueConfirmedNotifications) {
-                    if (COV_Subscriptions[index].invokeID != 0) {
-                        /* already sending */
-                        send = false;
-                    }
-                    if (!tsm_transaction_available()) {
-                        /* no transactions available - can't send now */
-                        send = false;
-                    }
+                member[count] = next - 1;
+                count++;
+                /* the subscriber gets the smallest time remaining */
+                if ((pMember->lifetime) && ((cov_data.timeRemaining == 0) ||
+                        (pMember->lifetime < cov_data.timeRemaining))) {
+                    cov_data.timeRemaining = pMember->lifetime;
                 }
-                if (send) {
-                    object_type = (BACNET_OBJECT_TYPE)
-                        COV_Subscriptions[index].
-                        monitoredObjectIdentifier.type;
-                    object_instance =
-                        COV_Subscriptions[index].
-                        monitoredObjectIdentifier.instance;
+            } else if (count == 0) {
+                return 0;
+            }
+        }
+        /* the subscription was taken off the send queue */
+        next = (next == (index + 1)) ? COV_Send_Queue.head :
+            pMember->next_send;
+    }
+    if (count < 2) {
+        return 0;
+    }
 #if PRINT_ENABLED
-                    fprintf(stderr, "COVtask: Sending...\n");
+    fprintf(stderr, "COVtask: Sending %u notifications...\n", count);
 #endif
-                    /* configure the linked list for the two properties */
-                    value_list[0].next = &value_list[1];
-                    value_list[1].next = NULL;
-                    status = Device_Encode_Value_List(object_type,
-                        object_instance, &value_list[0]);
-                    if (status) {
-                        status =
-                            cov_send_request(&COV_Subscriptions[index],
-                            &value_list[0]);
-                    }
-                    if (status) {
-                        COV_Subscriptions[index].flag.send_requested = false;
-                    }
-                }
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    pdu_len =
+        npdu_encode_pdu(&Handler_Transmit_Buffer[0], dest, &my_address,
+        &npdu_data);
+    cov_data.subscriberProcessIdentifier = pSub->subscriberProcessIdentifier;
+    cov_data.initiatingDeviceIdentifier = Device_Object_Instance_Number();
+    cov_data.listOfCOVNotifications = &notification[0];
+    if (pSub->flag.issueConfirmedNotifications) {
+        npdu_data.data_expecting_reply = true;
+        invoke_id = tsm_next_free_invokeID();
+        if (!invoke_id) {
+            return 0;
+        }
+        len =
+            ccov_notify_multiple_encode_apdu(&Handler_Transmit_Buffer
+            [pdu_len], sizeof(Handler_Transmit_Buffer) - pdu_len, invoke_id,
+            &cov_data);
+    } else {
+        len =
+            ucov_notify_multiple_encode_apdu(&Handler_Transmit_Buffer
+            [pdu_len], sizeof(Handler_Transmit_Buffer) - pdu_len, &cov_data);
+    }
+    if (len <= 0) {
+        if (invoke_id) {
+            tsm_free_invoke_id(invoke_id);
+        }
+        return 0;
+    }
+    pdu_len += len;
+    if (invoke_id) {
+        tsm_set_confirmed_unsegmented_transaction(invoke_id, dest, &npdu_data,
+            &Handler_Transmit_Buffer[0], (uint16_t) pdu_len);
+    }
+    bytes_sent =
+        datalink_send_pdu(dest, &npdu_data, &Handler_Transmit_Buffer[0],
+        pdu_len);
+    if (bytes_sent <= 0) {
+        if (invoke_id) {
+            tsm_free_invoke_id(invoke_id);
+        }
+        return 0;
+    }
+    for (i = 0; i < count; i++) {
+        pMember = &COV_Subscriptions[member[i]];
+        pMember->flag.send_requested = false;
+        if (invoke_id) {
+            /* the first subscription waits for the confirmation
+               on behalf of the others */
+            pMember->invokeID = invoke_id;
+            pMember->next_batch = ((i + 1) < count) ? (member[i + 1] + 1) : 0;
+            pMember->flag.batched = (i != 0);
+            pMember->flag.batch_acked = false;
+        }
+    }
+    if (invoke_id) {
+        cov_confirm_queue_add(index);
+    }
+    COV_Batch_Counters.notifications += count;
+    COV_Batch_Counters.packets++;
+    COV_Batch_Counters.multiple_packets++;
+    COV_Batch_Counters.packets_saved += count - 1;
+
+    return count;
+}
+
+/* sends the notification of a subscription.
+   Returns false if it has to wait, so that it is tried again later. */
+static bool cov_send_handler(
+    unsigned index)
+{
+    BACNET_COV_SUBSCRIPTION *pSub = &COV_Subscriptions[index];
+    BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
+    uint32_t object_instance = 0;
+    BACNET_PROPERTY_VALUE value_list[2];
+    bool status = false;
+
+    if ((!pSub->flag.valid) || (!pSub->flag.send_requested)) {
+        return true;
+    }
+    if (pSub->flag.issueConfirmedNotifications) {
+        if (pSub->invokeID != 0) {
+            /* already sending */
+            return false;
+        }
+        if (!tsm_transaction_available()) {
+            /* no transactions available - can't send now */
+            return false;
+        }
+    }
+    if (cov_multiple_enabled(pSub) && cov_send_multiple(index)) {
+        return true;
+    }
+    object_type = (BACNET_OBJECT_TYPE) pSub->monitoredObjectIdentifier.type;
+    object_instance = pSub->monitoredObjectIdentifier.instance;
+#if PRINT_ENABLED
+    fprintf(stderr, "COVtask: Sending...\n");
+#endif
+    /* configure the linked list for the two properties */
+    value_list[0].next = &value_list[1];
+    value_list[1].next = NULL;
+    status = Device_Encode_Value_List(object_type, object_instance,
+        &value_list[0]);
+    if (status) {
+        status = cov_send_request(pSub, &value_list[0]);
+    }
+    if (pSub->invokeID) {
+        /* confirmed notification house keeping */
+        cov_confirm_queue_add(index);
+    }
+    if (status) {
+        pSub->flag.send_requested = false;
+        COV_Batch_Counters.notifications++;
+        COV_Batch_Counters.packets++;
+    }
+
+    return status;
+}
+
+/* clears the invoke ID of the subscriptions sent in the
+   COVNotificationMultiple, and sends them again one by one if
+   the subscriber did not accept it */
+static void cov_batch_release(
+    unsigned index,
+    bool resend)
+{
+    BACNET_COV_SUBSCRIPTION *pSub = NULL;
+    unsigned next = index + 1;
+
+    while (next) {
+        pSub = &COV_Subscriptions[next - 1];
+        next = pSub->next_batch;
+        pSub->next_batch = 0;
+        pSub->invokeID = 0;
+        if (resend && pSub->flag.valid) {
+            cov_send_queue_add(pSub - COV_Subscriptions);
+        }
+        if (pSub->flag.batched) {
+            pSub->flag.batched = false;
+            cov_subscription_free_unused(pSub - COV_Subscriptions);
+        }
+    }
+}
+
+/* frees the invoke ID of a confirmed notification once it is done.
+   Returns false if it is still waiting. */
+static bool cov_confirm_handler(
+    unsigned index)
+{
+    BACNET_COV_SUBSCRIPTION *pSub = &COV_Subscriptions[index];
+    bool resend = false;
+
+    if (!pSub->invokeID) {
+        return true;
+    }
+    if (tsm_invoke_id_free(pSub->invokeID)) {
+        if (pSub->next_batch) {
+            if (pSub->dest_index < COV_Addresses_Size) {
+                /* the subscriber that rejects it does not support it */
+                COV_Addresses[pSub->dest_index].multiple =
+                    pSub->flag.batch_acked ? COV_MULTIPLE_SUPPORTED :
+                    COV_MULTIPLE_UNSUPPORTED;
             }
-            index++;
-            if (index >= MAX_COV_SUBCRIPTIONS) {
-                index = 0;
-                cov_task_state = COV_STATE_IDLE;
+            if (!pSub->flag.batch_acked) {
+                COV_Batch_Counters.fallbacks++;
+                resend = true;
             }
-            break;
-        default:
-            index = 0;
-            cov_task_state = COV_STATE_IDLE;
-            break;
+            cov_batch_release(index, resend);
+        } else {
+            pSub->invokeID = 0;
+        }
+    } else if (tsm_invoke_id_failed(pSub->invokeID)) {
+        tsm_free_invoke_id(pSub->invokeID);
+        if (pSub->next_batch) {
+            cov_batch_release(index, false);
+        } else {
+            pSub->invokeID = 0;
+        }
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+/** Handler for the Simple ACK of a ConfirmedCOVNotificationMultiple.
+ * @ingroup DSCOV
+ * Notes that the subscriber supports the COVNotificationMultiple
+ * services. Enabled by a call to apdu_set_confirmed_simple_ack_handler().
+ * @param src [in] BACNET_ADDRESS of the source of the message
+ * @param invoke_id [in] the invokeID of the acknowledged message
+ */
+void handler_ccov_notification_multiple_ack(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id)
+{
+    BACNET_COV_SUBSCRIPTION *pSub = NULL;
+    BACNET_ADDRESS *dest = NULL;
+    unsigned next = COV_Confirm_Queue.head;
+
+    while (next) {
+        pSub = &COV_Subscriptions[next - 1];
+        if ((pSub->invokeID == invoke_id) && (pSub->next_batch)) {
+            dest = cov_address_get(pSub->dest_index);
+            if (dest && bacnet_address_same(src, dest)) {
+                pSub->flag.batch_acked = true;
+                break;
+            }
+        }
+        next = pSub->next_confirm;
+    }
+}
+
+/** Enables the batching of the COV notifications.
+ * @ingroup DSCOV
+ * The notifications for the same subscriber are sent together in one
+ * ConfirmedCOVNotificationMultiple or UnconfirmedCOVNotificationMultiple
+ * when the subscriber supports them, else one by one.
+ * @param enable [in] true to batch the notifications
+ * @param window_ms [in] how long to collect the notifications before
+ *  they are sent, which needs handler_cov_timer_milliseconds().
+ */
+void handler_cov_batching_set(
+    bool enable,
+    uint16_t window_ms)
+{
+    COV_Batching = enable;
+    COV_Batch_Window = window_ms;
+    COV_Batch_Timer = 0;
+}
+
+/** Handler for the batching window of the COV notifications.
+ * @ingroup DSCOV
+ * @param elapsed_milliseconds [in] How many milliseconds have elapsed
+ *  since last called.
+ */
+void handler_cov_timer_milliseconds(
+    uint16_t elapsed_milliseconds)
+{
+    if (COV_Batch_Timer > elapsed_milliseconds) {
+        COV_Batch_Timer -= elapsed_milliseconds;
+    } else {
+        COV_Batch_Timer = 0;
+    }
+}
+
+/** Gets the counters of the COV notifications sent.
+ * @ingroup DSCOV
+ * @param counters [out] the notifications and the packets sent, and
+ *  the packets saved by the batching
+ */
+void handler_cov_batch_counters(
+    BACNET_COV_BATCH_COUNTERS * counters)
+{
+    if (counters) {
+        *counters = COV_Batch_Counters;
     }
-    return (cov_task_state == COV_STATE_IDLE);
+}
+
+/** Handler to send the COV notifications of the objects that changed.
+ * @ingroup DSCOV
+ * Does one step at a time:
+ *  - takes a changed object off the dirty queue, and if its COV flag is
+ *    set, clears it and queues its subscriptions to be sent,
+ *  - else sends one queued notification, confirmed or unconfirmed
+ *    as per the subscription, or a batch of them when batching is
+ *    enabled and the batching window is over,
+ *  - else checks one confirmed notification for completion.
+ *
+ * @note worst case tasking: MS/TP with the ability to send only
+ *        one notification per task cycle.
+ *
+ * @return true if there is nothing more to do.
+ */
+bool handler_cov_fsm(
+    void)
+{
+    unsigned index = 0;
+    BACNET_COV_SUBSCRIPTION *pSub = NULL;
+
+    index = cov_queue_remove(&COV_Dirty_Queue);
+    if (index) {
+        cov_dirty_object_handler(index - 1);
+    } else if ((COV_Batch_Timer == 0) &&
+        ((index = cov_queue_remove(&COV_Send_Queue)) != 0)) {
+        pSub = &COV_Subscriptions[index - 1];
+        pSub->flag.send_queued = false;
+        if (!cov_send_handler(index - 1)) {
+            pSub->flag.send_queued = true;
+            cov_queue_add(&COV_Send_Queue, index - 1);
+        }
+        cov_subscription_free_unused(index - 1);
+    } else if ((index = cov_queue_remove(&COV_Confirm_Queue)) != 0) {
+        pSub = &COV_Subscriptions[index - 1];
+        pSub->flag.confirm_queued = false;
+        if (!cov_confirm_handler(index - 1)) {
+            pSub->flag.confirm_queued = true;
+            cov_queue_add(&COV_Confirm_Queue, index - 1);
+        }
+        cov_subscription_free_unused(index - 1);
+    }
+
+    return ((COV_Dirty_Queue.head == 0) && (COV_Send_Queue.head == 0) &&
+        (COV_Confirm_Queue.head == 0));
 }
 
 void handler_cov_task(
@@ -904,3 +1623,363 @@ void handler_cov_subscribe(
 
     return;
 }
+
+#ifdef TEST
+#include <assert.h>
+#include "ctest.h"
+
+/* The device, the TSM and the datalink, as seen by the COV handler.
+   Each confirmed notification waits on its invoke ID until the test
+   answers it, and the service of each packet sent is kept. */
+#define TEST_TSM_FREE 0
+#define TEST_TSM_WAITING 1
+uint8_t Handler_Transmit_Buffer[MAX_PDU];
+static uint8_t Test_TSM[256];
+static uint8_t Test_Invoke_ID;
+static unsigned Test_Packets;
+static uint8_t Test_Service;
+/* services of the confirmed requests, by invoke ID */
+static uint8_t Test_Invoke_Service[256];
+
+bool Device_COV(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+
+    return true;
+}
+
+void Device_COV_Clear(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    (void) object_type;
+    (void) object_instance;
+}
+
+bool Device_Encode_Value_List(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_VALUE * value_list)
+{
+    (void) object_type;
+    value_list->propertyIdentifier = PROP_PRESENT_VALUE;
+    value_list->propertyArrayIndex = BACNET_ARRAY_ALL;
+    value_list->value.context_specific = false;
+    value_list->value.tag = BACNET_APPLICATION_TAG_REAL;
+    value_list->value.type.Real = (float) object_instance;
+    value_list->value.next = NULL;
+    value_list->priority = BACNET_NO_PRIORITY;
+    value_list = value_list->next;
+    value_list->propertyIdentifier = PROP_STATUS_FLAGS;
+    value_list->propertyArrayIndex = BACNET_ARRAY_ALL;
+    value_list->value.context_specific = false;
+    value_list->value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
+    bitstring_init(&value_list->value.type.Bit_String);
+    bitstring_set_bit(&value_list->value.type.Bit_String,
+        STATUS_FLAG_IN_ALARM, false);
+    bitstring_set_bit(&value_list->value.type.Bit_String,
+        STATUS_FLAG_FAULT, false);
+    bitstring_set_bit(&value_list->value.type.Bit_String,
+        STATUS_FLAG_OVERRIDDEN, false);
+    bitstring_set_bit(&value_list->value.type.Bit_String,
+        STATUS_FLAG_OUT_OF_SERVICE, false);
+    value_list->value.next = NULL;
+    value_list->priority = BACNET_NO_PRIORITY;
+
+    return true;
+}
+
+uint32_t Device_Object_Instance_Number(
+    void)
+{
+    return 1234;
+}
+
+bool Device_Valid_Object_Id(
+    int object_type,
+    uint32_t object_instance)
+{
+    (void) object_instance;
+
+    return object_type == OBJECT_ANALOG_INPUT;
+}
+
+bool Device_Value_List_Supported(
+    BACNET_OBJECT_TYPE object_type)
+{
+    return object_type == OBJECT_ANALOG_INPUT;
+}
+
+bool dcc_communication_enabled(
+    void)
+{
+    return true;
+}
+
+void datalink_get_my_address(
+    BACNET_ADDRESS * my_address)
+{
+    memset(my_address, 0, sizeof(*my_address));
+    my_address->mac_len = 1;
+    my_address->mac[0] = 1;
+}
+
+int datalink_send_pdu(
+    BACNET_ADDRESS * dest,
+    BACNET_NPDU_DATA * npdu_data,
+    uint8_t * pdu,
+    unsigned pdu_len)
+{
+    BACNET_ADDRESS npdu_dest, npdu_src;
+    BACNET_NPDU_DATA npdu;
+    uint8_t *apdu;
+    int len;
+
+    (void) dest;
+    (void) npdu_data;
+    len = npdu_decode(pdu, &npdu_dest, &npdu_src, &npdu);
+    apdu = &pdu[len];
+    if ((apdu[0] & 0xF0) == PDU_TYPE_CONFIRMED_SERVICE_REQUEST) {
+        Test_Service = apdu[3];
+        Test_Invoke_Service[apdu[2]] = apdu[3];
+    } else if ((apdu[0] & 0xF0) == PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST) {
+        Test_Service = apdu[1];
+    } else {
+        Test_Service = 0xFF;
+    }
+    Test_Packets++;
+
+    return (int) pdu_len;
+}
+
+bool tsm_transaction_available(
+    void)
+{
+    return true;
+}
+
+uint8_t tsm_next_free_invokeID(
+    void)
+{
+    do {
+        Test_Invoke_ID++;
+    } while ((Test_Invoke_ID == 0) ||
+        (Test_TSM[Test_Invoke_ID] != TEST_TSM_FREE));
+    Test_TSM[Test_Invoke_ID] = TEST_TSM_WAITING;
+
+    return Test_Invoke_ID;
+}
+
+void tsm_set_confirmed_unsegmented_transaction(
+    uint8_t invokeID,
+    BACNET_ADDRESS * dest,
+    BACNET_NPDU_DATA * ndpu_data,
+    uint8_t * apdu,
+    uint16_t apdu_len)
+{
+    (void) invokeID;
+    (void) dest;
+    (void) ndpu_data;
+    (void) apdu;
+    (void) apdu_len;
+}
+
+bool tsm_invoke_id_free(
+    uint8_t invokeID)
+{
+    return Test_TSM[invokeID] == TEST_TSM_FREE;
+}
+
+bool tsm_invoke_id_failed(
+    uint8_t invokeID)
+{
+    (void) invokeID;
+
+    return false;
+}
+
+void tsm_free_invoke_id(
+    uint8_t invokeID)
+{
+    Test_TSM[invokeID] = TEST_TSM_FREE;
+}
+
+static void testSubscriber(
+    BACNET_ADDRESS * src)
+{
+    memset(src, 0, sizeof(*src));
+    src->mac_len = 1;
+    src->mac[0] = 5;
+}
+
+/* Subscribes to the analog inputs from 0 to count - 1 */
+static void testSubscribe(
+    unsigned count,
+    bool confirmed)
+{
+    BACNET_CONFIRMED_SERVICE_DATA service_data;
+    BACNET_SUBSCRIBE_COV_DATA cov_data;
+    BACNET_ADDRESS src;
+    uint8_t apdu[MAX_APDU];
+    unsigned i;
+    int len;
+
+    testSubscriber(&src);
+    memset(&service_data, 0, sizeof(service_data));
+    for (i = 0; i < count; i++) {
+        memset(&cov_data, 0, sizeof(cov_data));
+        cov_data.subscriberProcessIdentifier = 1;
+        cov_data.monitoredObjectIdentifier.type = OBJECT_ANALOG_INPUT;
+        cov_data.monitoredObjectIdentifier.instance = i;
+        cov_data.issueConfirmedNotifications = confirmed;
+        cov_data.lifetime = 300;
+        len = cov_subscribe_encode_apdu(&apdu[0], sizeof(apdu), 1, &cov_data);
+        service_data.invoke_id = 1;
+        /* as apdu_handler() does, after the confirmed request header */
+        handler_cov_subscribe(&apdu[4], (uint16_t) (len - 4), &src,
+            &service_data);
+    }
+}
+
+/* Runs the COV handler, 10 milliseconds at a time, until it has
+   nothing more to do.  The subscriber acknowledges each confirmed
+   notification, and each COVNotificationMultiple if it supports them.
+   Returns the number of packets sent. */
+static unsigned testRun(
+    bool multiple)
+{
+    BACNET_ADDRESS src;
+    unsigned packets = Test_Packets;
+    unsigned id;
+
+    testSubscriber(&src);
+    while (!handler_cov_fsm()) {
+        for (id = 1; id < 256; id++) {
+            if (Test_TSM[id] != TEST_TSM_WAITING) {
+                continue;
+            }
+            if (multiple && (Test_Invoke_Service[id] ==
+                    SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE)) {
+                handler_ccov_notification_multiple_ack(&src, (uint8_t) id);
+            }
+            tsm_free_invoke_id((uint8_t) id);
+        }
+        handler_cov_timer_milliseconds(10);
+    }
+
+    return Test_Packets - packets;
+}
+
+static void testChanged(
+    unsigned count)
+{
+    unsigned i;
+
+    for (i = 0; i < count; i++) {
+        handler_cov_object_changed(OBJECT_ANALOG_INPUT, i);
+    }
+}
+
+static void testCOVBatching(
+    Test * pTest)
+{
+    BACNET_COV_BATCH_COUNTERS counters;
+    unsigned packets;
+
+    handler_cov_init();
+    handler_cov_batching_set(false, 0);
+    testSubscribe(8, true);
+    /* a Simple Ack, and the first notification, of each subscription */
+    ct_test(pTest, Test_Packets == 8);
+    ct_test(pTest, testRun(true) == 8);
+    /* without batching, a packet for each notification */
+    testChanged(8);
+    ct_test(pTest, testRun(true) == 8);
+    ct_test(pTest, Test_Service == SERVICE_CONFIRMED_COV_NOTIFICATION);
+    handler_cov_batch_counters(&counters);
+    ct_test(pTest, counters.notifications == 16);
+    ct_test(pTest, counters.packets == 16);
+    ct_test(pTest, counters.packets_saved == 0);
+    /* with batching, nothing is sent during the window... */
+    handler_cov_batching_set(true, 100);
+    testChanged(8);
+    packets = Test_Packets;
+    ct_test(pTest, !handler_cov_fsm());
+    ct_test(pTest, !handler_cov_fsm());
+    ct_test(pTest, Test_Packets == packets);
+    handler_cov_timer_milliseconds(50);
+    ct_test(pTest, !handler_cov_fsm());
+    ct_test(pTest, Test_Packets == packets);
+    /* ...and then one packet for the eight notifications */
+    handler_cov_timer_milliseconds(50);
+    ct_test(pTest, testRun(true) == 1);
+    ct_test(pTest,
+        Test_Service == SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE);
+    handler_cov_batch_counters(&counters);
+    ct_test(pTest, counters.notifications == 24);
+    ct_test(pTest, counters.packets == 17);
+    ct_test(pTest, counters.multiple_packets == 1);
+    ct_test(pTest, counters.packets_saved == 7);
+    ct_test(pTest, counters.fallbacks == 0);
+    /* the unconfirmed notifications too, once the subscriber is known
+       to support them */
+    testSubscribe(8, false);
+    ct_test(pTest, testRun(true) == 1);
+    ct_test(pTest,
+        Test_Service == SERVICE_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE);
+    handler_cov_batch_counters(&counters);
+    ct_test(pTest, counters.packets_saved == 14);
+    handler_cov_init();
+}
+
+static void testCOVBatchingFallback(
+    Test * pTest)
+{
+    BACNET_COV_BATCH_COUNTERS counters;
+
+    handler_cov_init();
+    handler_cov_batching_set(true, 0);
+    testSubscribe(8, true);
+    /* a subscriber without COVNotificationMultiple gets the
+       notifications one by one */
+    ct_test(pTest, testRun(false) == (1 + 8));
+    ct_test(pTest, Test_Service == SERVICE_CONFIRMED_COV_NOTIFICATION);
+    handler_cov_batch_counters(&counters);
+    ct_test(pTest, counters.fallbacks == 1);
+    ct_test(pTest, counters.notifications == 16);
+    ct_test(pTest, counters.packets == 9);
+    /* from then on */
+    testChanged(8);
+    ct_test(pTest, testRun(false) == 8);
+    handler_cov_batch_counters(&counters);
+    ct_test(pTest, counters.fallbacks == 1);
+    ct_test(pTest, counters.multiple_packets == 1);
+    handler_cov_init();
+}
+
+#ifdef TEST_COV_HANDLER
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("BACnet COV Handler", NULL);
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testCOVBatching);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testCOVBatchingFallback);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+    ct_destroy(pTest);
+
+    return 0;
+}
+#endif /* TEST_COV_HANDLER */
+#endif /* TEST */
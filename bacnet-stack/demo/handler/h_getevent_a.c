@@ -61,7 +61,7 @@
  */
 void get_event_ack_handler(
     uint8_t *service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS *src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA *service_data)
 {
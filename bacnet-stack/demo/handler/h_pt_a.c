@@ -185,7 +185,7 @@ static void ProcessPTA(
 
 void handler_conf_private_trans_ack(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
@@ -38,6 +38,7 @@
 #include "abort.h"
 #include "reject.h"
 #include "rp.h"
+#include "tsm.h"
 /* device object has custom handler for all objects */
 #include "device.h"
 #include "handlers.h"
@@ -53,7 +54,8 @@
  * - an Abort if
  *   - the message is segmented
  *   - if decoding fails
- *   - if the response would be too large
+ *   - if the response would be too large, and the client does not
+ *     accept a segmented response
  * - the result from Device_Read_Property(), if it succeeds
  * - an Error if Device_Read_Property() fails
  *   or there isn't enough room in the APDU to fit the data.
@@ -75,6 +77,8 @@ void handler_read_property(
     int pdu_len = 0;
     int apdu_len = -1;
     int npdu_len = -1;
+    uint8_t *apdu = NULL;
+    int apdu_max = 0;
     BACNET_NPDU_DATA npdu_data;
     bool error = true;  /* assume that there is an error */
     int bytes_sent = 0;
@@ -116,30 +120,53 @@ void handler_read_property(
         rpdata.object_instance = Device_Object_Instance_Number();
     }
 
+    apdu = &Handler_Transmit_Buffer[npdu_len];
+    apdu_max = sizeof(Handler_Transmit_Buffer) - npdu_len;
+#if BACNET_SEGMENTATION_ENABLED
+    if (service_data->segmented_response_accepted) {
+        /* encode all of it - the TSM segments it if it is too big */
+        apdu = &Handler_Segment_Buffer[0];
+        apdu_max = sizeof(Handler_Segment_Buffer);
+    }
+#endif
     apdu_len =
-        rp_ack_encode_apdu_init(&Handler_Transmit_Buffer[npdu_len],
-        service_data->invoke_id, &rpdata);
+        rp_ack_encode_apdu_init(&apdu[0], service_data->invoke_id, &rpdata);
     /* configure our storage */
-    rpdata.application_data = &Handler_Transmit_Buffer[npdu_len + apdu_len];
-    rpdata.application_data_len =
-        sizeof(Handler_Transmit_Buffer) - (npdu_len + apdu_len);
+    rpdata.application_data = &apdu[apdu_len];
+    rpdata.application_data_len = apdu_max - apdu_len;
     len = Device_Read_Property(&rpdata);
     if (len >= 0) {
         apdu_len += len;
-        len =
-            rp_ack_encode_apdu_object_property_end(&Handler_Transmit_Buffer
-            [npdu_len + apdu_len]);
+        len = rp_ack_encode_apdu_object_property_end(&apdu[apdu_len]);
         apdu_len += len;
         if (apdu_len > service_data->max_resp) {
+#if BACNET_SEGMENTATION_ENABLED
+            if (tsm_set_segmented_complex_ack_transaction(src, &npdu_data,
+                    service_data, &apdu[0], apdu_len)) {
+#if PRINT_ENABLED
+                fprintf(stderr, "RP: Sending Segmented Ack!\n");
+#endif
+                return;
+            }
+#endif
             /* too big for the sender - send an abort
              * Setting of error code needed here as read property processing may
              * have overriden the default set at start */
             rpdata.error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
+#if BACNET_SEGMENTATION_ENABLED
+            if (service_data->segmented_response_accepted) {
+                /* more segments than the client accepts */
+                rpdata.error_code = ERROR_CODE_ABORT_BUFFER_OVERFLOW;
+            }
+#endif
             len = BACNET_STATUS_ABORT;
 #if PRINT_ENABLED
             fprintf(stderr, "RP: Message too large.\n");
 #endif
         } else {
+            if (apdu != &Handler_Transmit_Buffer[npdu_len]) {
+                memmove(&Handler_Transmit_Buffer[npdu_len], apdu, apdu_len);
+            }
 #if PRINT_ENABLED
             fprintf(stderr, "RP: Sending Ack!\n");
 #endif
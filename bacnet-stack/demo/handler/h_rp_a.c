@@ -37,6 +37,8 @@
 #include "datalink.h"
 #include "bactext.h"
 #include "rp.h"
+#include "propcache.h"
+#include "rpmplan.h"
 /* some demo stuff needed */
 #include "handlers.h"
 #include "txbuf.h"
@@ -116,21 +118,29 @@ void rp_ack_print_data(
  */
 void handler_read_property_ack(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
     int len = 0;
     BACNET_READ_PROPERTY_DATA data;
+    uint32_t device_id = 0;
 
-    (void) src;
-    (void) service_data;        /* we could use these... */
     len = rp_ack_decode_service_request(service_request, service_len, &data);
 #if 0
     fprintf(stderr, "Received Read-Property Ack!\n");
 #endif
-    if (len > 0)
+    if (len > 0) {
+        if (address_get_device_id(src, &device_id)) {
+            property_cache_rp_ack(device_id, service_data->invoke_id, &data);
+            rpm_plan_learn_rp(device_id, &data);
+        } else {
+            property_cache_pending_clear(service_data->invoke_id);
+        }
         rp_ack_print_data(&data);
+    } else {
+        property_cache_pending_clear(service_data->invoke_id);
+    }
 }
 
 /** Decode the received RP data into a linked list of the results, with the
@@ -40,6 +40,7 @@
 #include "reject.h"
 #include "bacerror.h"
 #include "rpm.h"
+#include "tsm.h"
 #include "handlers.h"
 /* device object has custom handler for all objects */
 #include "device.h"
@@ -105,13 +106,15 @@ static unsigned RPM_Object_Property_Count(
    or 0 if there is no room to fit the encoding.  */
 static int RPM_Encode_Property(
     uint8_t * apdu,
-    uint16_t offset,
-    uint16_t max_apdu,
+    size_t offset,
+    size_t max_apdu,
     BACNET_RPM_DATA * rpmdata)
 {
     int len = 0;
     size_t copy_len = 0;
     int apdu_len = 0;
+    uint8_t *value = &Temp_Buf[0];
+    size_t value_max = sizeof(Temp_Buf);
     BACNET_READ_PROPERTY_DATA rpdata;
 
     len =
@@ -124,14 +127,20 @@ static int RPM_Encode_Property(
     }
     apdu_len += len;
     len = 0;
+    if (max_apdu >= (offset + apdu_len + 2 + sizeof(Temp_Buf))) {
+        /* a value that may need several segments is read in place,
+           behind room for its opening tag */
+        value = &apdu[offset + apdu_len + 1];
+        value_max = max_apdu - (offset + apdu_len + 2);
+    }
     rpdata.error_class = ERROR_CLASS_OBJECT;
     rpdata.error_code = ERROR_CODE_UNKNOWN_OBJECT;
     rpdata.object_type = rpmdata->object_type;
     rpdata.object_instance = rpmdata->object_instance;
     rpdata.object_property = rpmdata->object_property;
     rpdata.array_index = rpmdata->array_index;
-    rpdata.application_data = &Temp_Buf[0];
-    rpdata.application_data_len = sizeof(Temp_Buf);
+    rpdata.application_data = value;
+    rpdata.application_data_len = (int) value_max;
     len = Device_Read_Property(&rpdata);
     if (len < 0) {
         if ((len == BACNET_STATUS_ABORT) || (len == BACNET_STATUS_REJECT)) {
@@ -154,7 +163,7 @@ static int RPM_Encode_Property(
         /* enough room to fit the property value and tags */
         len =
             rpm_ack_encode_apdu_object_property_value(&apdu[offset + apdu_len],
-            &Temp_Buf[0], len);
+            value, len);
     } else {
         /* not enough room - abort! */
         rpmdata->error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
@@ -173,7 +182,8 @@ static int RPM_Encode_Property(
  * - an Abort if
  *   - the message is segmented
  *   - if decoding fails
- *   - if the response would be too large
+ *   - if the response would be too large, and the client does not
+ *     accept a segmented response
  * - the result from each included read request, if it succeeds
  * - an Error if processing fails for all, or individual errors if only some fail,
  *   or there isn't enough room in the APDU to fit the data.
@@ -200,6 +210,8 @@ void handler_read_property_multiple(
     BACNET_RPM_DATA rpmdata;
     int apdu_len = 0;
     int npdu_len = 0;
+    uint8_t *apdu = NULL;
+    size_t apdu_max = 0;
     int error = 0;
 
     /* jps_debug - see if we are utilizing all the buffer */
@@ -218,11 +230,18 @@ void handler_read_property_multiple(
 #endif
         goto RPM_FAILURE;
     }
+    apdu = &Handler_Transmit_Buffer[npdu_len];
+    apdu_max = MAX_APDU;
+#if BACNET_SEGMENTATION_ENABLED
+    if (service_data->segmented_response_accepted) {
+        /* encode all of it - the TSM segments it if it is too big */
+        apdu = &Handler_Segment_Buffer[0];
+        apdu_max = sizeof(Handler_Segment_Buffer);
+    }
+#endif
     /* decode apdu request & encode apdu reply
        encode complex ack, invoke id, service choice */
-    apdu_len =
-        rpm_ack_encode_apdu_init(&Handler_Transmit_Buffer[npdu_len],
-        service_data->invoke_id);
+    apdu_len = rpm_ack_encode_apdu_init(&apdu[0], service_data->invoke_id);
     for (;;) {
         /* Start by looking for an object ID */
         len =
@@ -248,9 +267,7 @@ void handler_read_property_multiple(
 
         /* Stick this object id into the reply - if it will fit */
         len = rpm_ack_encode_apdu_object_begin(&Temp_Buf[0], &rpmdata);
-        copy_len =
-            memcopy(&Handler_Transmit_Buffer[npdu_len], &Temp_Buf[0], apdu_len,
-            len, MAX_APDU);
+        copy_len = memcopy(&apdu[0], &Temp_Buf[0], apdu_len, len, apdu_max);
         if (copy_len == 0) {
 #if PRINT_ENABLED
             fprintf(stderr, "RPM: Response too big!\r\n");
@@ -292,8 +309,8 @@ void handler_read_property_multiple(
                         rpm_ack_encode_apdu_object_property(&Temp_Buf[0],
                         rpmdata.object_property, rpmdata.array_index);
                     copy_len =
-                        memcopy(&Handler_Transmit_Buffer[npdu_len],
-                        &Temp_Buf[0], apdu_len, len, MAX_APDU);
+                        memcopy(&apdu[0], &Temp_Buf[0], apdu_len, len,
+                        apdu_max);
                     if (copy_len == 0) {
 #if PRINT_ENABLED
                         fprintf(stderr,
@@ -310,8 +327,8 @@ void handler_read_property_multiple(
                         ERROR_CLASS_PROPERTY,
                         ERROR_CODE_PROPERTY_IS_NOT_AN_ARRAY);
                     copy_len =
-                        memcopy(&Handler_Transmit_Buffer[npdu_len],
-                        &Temp_Buf[0], apdu_len, len, MAX_APDU);
+                        memcopy(&apdu[0], &Temp_Buf[0], apdu_len, len,
+                        apdu_max);
                     if (copy_len == 0) {
 #if PRINT_ENABLED
                         fprintf(stderr, "RPM: Too full to encode error!\r\n");
@@ -342,9 +359,8 @@ void handler_read_property_multiple(
                                 RPM_Object_Property(&property_list,
                                 special_object_property, index);
                             len =
-                                RPM_Encode_Property(&Handler_Transmit_Buffer
-                                [npdu_len], (uint16_t) apdu_len, MAX_APDU,
-                                &rpmdata);
+                                RPM_Encode_Property(&apdu[0], apdu_len,
+                                apdu_max, &rpmdata);
                             if (len > 0) {
                                 apdu_len += len;
                             } else {
@@ -361,8 +377,8 @@ void handler_read_property_multiple(
             } else {
                 /* handle an individual property */
                 len =
-                    RPM_Encode_Property(&Handler_Transmit_Buffer[npdu_len],
-                    (uint16_t) apdu_len, MAX_APDU, &rpmdata);
+                    RPM_Encode_Property(&apdu[0], apdu_len, apdu_max,
+                    &rpmdata);
                 if (len > 0) {
                     apdu_len += len;
                 } else {
@@ -379,8 +395,7 @@ void handler_read_property_multiple(
                 decode_len++;
                 len = rpm_ack_encode_apdu_object_end(&Temp_Buf[0]);
                 copy_len =
-                    memcopy(&Handler_Transmit_Buffer[npdu_len], &Temp_Buf[0],
-                    apdu_len, len, MAX_APDU);
+                    memcopy(&apdu[0], &Temp_Buf[0], apdu_len, len, apdu_max);
                 if (copy_len == 0) {
 #if PRINT_ENABLED
                     fprintf(stderr, "RPM: Too full to encode object end!\r\n");
@@ -402,14 +417,32 @@ void handler_read_property_multiple(
     }
 
     if (apdu_len > service_data->max_resp) {
+#if BACNET_SEGMENTATION_ENABLED
+        if (tsm_set_segmented_complex_ack_transaction(src, &npdu_data,
+                service_data, &apdu[0], apdu_len)) {
+#if PRINT_ENABLED
+            fprintf(stderr, "RPM: Sending Segmented Ack!\n");
+#endif
+            return;
+        }
+#endif
         /* too big for the sender - send an abort */
         rpmdata.error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
+#if BACNET_SEGMENTATION_ENABLED
+        if (service_data->segmented_response_accepted) {
+            /* more segments than the client accepts */
+            rpmdata.error_code = ERROR_CODE_ABORT_BUFFER_OVERFLOW;
+        }
+#endif
         error = BACNET_STATUS_ABORT;
 #if PRINT_ENABLED
         fprintf(stderr, "RPM: Message too large.  Sending Abort!\n");
 #endif
         goto RPM_FAILURE;
     }
+    if (apdu != &Handler_Transmit_Buffer[npdu_len]) {
+        memmove(&Handler_Transmit_Buffer[npdu_len], apdu, apdu_len);
+    }
 
   RPM_FAILURE:
     if (error) {
@@ -25,6 +25,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "config.h"
 #include "txbuf.h"
@@ -38,25 +39,220 @@
 #include "datalink.h"
 #include "bactext.h"
 #include "rpm.h"
+#include "propcache.h"
+#include "rpmplan.h"
 /* some demo stuff needed */
 #include "handlers.h"
 #include "txbuf.h"
 
 /** @file h_rpm_a.c  Handles Read Property Multiple Acknowledgments. */
 
-/** Decode the received RPM data and make a linked list of the results.
+/* size of the blocks the arena mallocs when no buffer is given */
+#ifndef RPM_ACK_ARENA_BLOCK_SIZE
+#define RPM_ACK_ARENA_BLOCK_SIZE (16*1024)
+#endif
+
+/* allocations are rounded up so that every node is aligned */
+typedef union rpm_ack_arena_align {
+    void *pointer;
+    double real;
+    uint64_t integer;
+} RPM_ACK_ARENA_ALIGN;
+
+#define RPM_ACK_ARENA_ROUND(n) \
+    ((((n) + sizeof(RPM_ACK_ARENA_ALIGN) - 1) / \
+    sizeof(RPM_ACK_ARENA_ALIGN)) * sizeof(RPM_ACK_ARENA_ALIGN))
+
+/* header of a malloc'd block - the nodes follow it */
+typedef union rpm_ack_arena_block {
+    struct {
+        union rpm_ack_arena_block *next;
+        size_t size;
+    } header;
+    RPM_ACK_ARENA_ALIGN align;
+} RPM_ACK_ARENA_BLOCK;
+
+/* node allocators used by the decoder */
+typedef void *(
+    *rpm_ack_alloc_function) (
+    void *context,
+    size_t size);
+typedef void (
+    *rpm_ack_release_function) (
+    void *context,
+    void *node);
+
+static void *rpm_ack_calloc(
+    void *context,
+    size_t size)
+{
+    (void) context;
+
+    return calloc(1, size);
+}
+
+static void rpm_ack_free(
+    void *context,
+    void *node)
+{
+    (void) context;
+    free(node);
+}
+
+static void rpm_ack_arena_free_blocks(
+    BACNET_RPM_ACK_ARENA * arena)
+{
+    RPM_ACK_ARENA_BLOCK *block = NULL;
+
+    while (arena->blocks) {
+        block = (RPM_ACK_ARENA_BLOCK *) arena->blocks;
+        arena->blocks = block->header.next;
+        free(block);
+    }
+    arena->buffer = NULL;
+    arena->size = 0;
+}
+
+static bool rpm_ack_arena_add_block(
+    BACNET_RPM_ACK_ARENA * arena,
+    size_t size)
+{
+    RPM_ACK_ARENA_BLOCK *block = NULL;
+
+    if (size < RPM_ACK_ARENA_BLOCK_SIZE) {
+        size = RPM_ACK_ARENA_BLOCK_SIZE;
+    }
+    block = malloc(sizeof(RPM_ACK_ARENA_BLOCK) + size);
+    if (!block) {
+        return false;
+    }
+    block->header.next = (RPM_ACK_ARENA_BLOCK *) arena->blocks;
+    block->header.size = size;
+    arena->blocks = block;
+    arena->buffer = (uint8_t *) (block + 1);
+    arena->size = size;
+    arena->used = 0;
+    arena->last = 0;
+
+    return true;
+}
+
+static void *rpm_ack_arena_alloc(
+    void *context,
+    size_t size)
+{
+    BACNET_RPM_ACK_ARENA *arena = (BACNET_RPM_ACK_ARENA *) context;
+    void *node = NULL;
+
+    size = RPM_ACK_ARENA_ROUND(size);
+    if ((arena->used + size) > arena->size) {
+        if (arena->fixed || !rpm_ack_arena_add_block(arena, size)) {
+            arena->full = true;
+            return NULL;
+        }
+    }
+    node = &arena->buffer[arena->used];
+    memset(node, 0, size);
+    arena->last = arena->used;
+    arena->used += size;
+    arena->total += size;
+
+    return node;
+}
+
+/* only the last node can be given back, which is the only one
+   the decoder gives back */
+static void rpm_ack_arena_release(
+    void *context,
+    void *node)
+{
+    BACNET_RPM_ACK_ARENA *arena = (BACNET_RPM_ACK_ARENA *) context;
+
+    if (arena->buffer && (node == &arena->buffer[arena->last])) {
+        arena->used = arena->last;
+    }
+}
+
+/** Initialize an arena for decoding RPM Acks.
  * @ingroup DSRPM
  *
- * @param apdu [in] The received apdu data.
- * @param apdu_len [in] Total length of the apdu.
- * @param read_access_data [out] Pointer to the head of the linked list
- * 			where the RPM data is to be stored.
- * @return The number of bytes decoded, or -1 on error
+ * @param arena [in] The arena to initialize.
+ * @param buffer [in] Memory to decode into, or NULL to have the arena
+ *                    malloc blocks as they are needed.
+ * @param size [in] Size of the buffer in bytes.
  */
-int rpm_ack_decode_service_request(
+void rpm_ack_arena_init(
+    BACNET_RPM_ACK_ARENA * arena,
+    uint8_t * buffer,
+    size_t size)
+{
+    if (arena) {
+        memset(arena, 0, sizeof(BACNET_RPM_ACK_ARENA));
+        if (buffer && size) {
+            arena->buffer = buffer;
+            arena->size = size;
+            arena->fixed = true;
+        }
+    }
+}
+
+/** Empty the arena so that it can decode the next RPM Ack.
+ * The decoded data is no longer valid.  When the last Ack did not fit
+ * in one block, the blocks are replaced by one that is large enough,
+ * so the arena does not malloc again for Acks of that size.
+ * @ingroup DSRPM
+ *
+ * @param arena [in] The arena to empty.
+ */
+void rpm_ack_arena_reset(
+    BACNET_RPM_ACK_ARENA * arena)
+{
+    RPM_ACK_ARENA_BLOCK *block = NULL;
+    size_t total = 0;
+
+    if (!arena) {
+        return;
+    }
+    block = (RPM_ACK_ARENA_BLOCK *) arena->blocks;
+    if (block && block->header.next) {
+        total = arena->total;
+        rpm_ack_arena_free_blocks(arena);
+        (void) rpm_ack_arena_add_block(arena, total);
+    }
+    arena->used = 0;
+    arena->last = 0;
+    arena->total = 0;
+    arena->full = false;
+}
+
+/** Free the blocks malloc'd by the arena, and all the data decoded
+ * into it, in one call.  The arena can be used again after this.
+ * @ingroup DSRPM
+ *
+ * @param arena [in] The arena to free.
+ */
+void rpm_ack_arena_free(
+    BACNET_RPM_ACK_ARENA * arena)
+{
+    if (arena) {
+        if (arena->fixed) {
+            rpm_ack_arena_reset(arena);
+        } else {
+            rpm_ack_arena_free_blocks(arena);
+            rpm_ack_arena_init(arena, NULL, 0);
+        }
+    }
+}
+
+/* Decode the RPM data into a linked list, getting each node
+   from the alloc function, in the order they are decoded. */
+static int rpm_ack_decode_nodes(
     uint8_t * apdu,
     int apdu_len,
-    BACNET_READ_ACCESS_DATA * read_access_data)
+    BACNET_READ_ACCESS_DATA * read_access_data,
+    rpm_ack_alloc_function alloc,
+    rpm_ack_release_function release,
+    void *context)
 {
     int decoded_len = 0;        /* return value */
     uint32_t error_value = 0;   /* decoded error value */
@@ -79,13 +275,13 @@ int rpm_ack_decode_service_request(
             &rpm_object->object_instance);
         if (len <= 0) {
             old_rpm_object->next = NULL;
-            free(rpm_object);
+            release(context, rpm_object);
             break;
         }
         decoded_len += len;
         apdu_len -= len;
         apdu += len;
-        rpm_property = calloc(1, sizeof(BACNET_PROPERTY_REFERENCE));
+        rpm_property = alloc(context, sizeof(BACNET_PROPERTY_REFERENCE));
         rpm_object->listOfProperties = rpm_property;
         old_rpm_property = rpm_property;
         while (rpm_property && apdu_len) {
@@ -99,7 +295,7 @@ int rpm_ack_decode_service_request(
                     /* was this the only property in the list? */
                     rpm_object->listOfProperties = NULL;
                 }
-                free(rpm_property);
+                release(context, rpm_property);
                 break;
             }
             decoded_len += len;
@@ -112,7 +308,8 @@ int rpm_ack_decode_service_request(
                 apdu++;
                 /* note: if this is an array, there will be
                    more than one element to decode */
-                value = calloc(1, sizeof(BACNET_APPLICATION_DATA_VALUE));
+                value =
+                    alloc(context, sizeof(BACNET_APPLICATION_DATA_VALUE));
                 rpm_property->value = value;
                 old_value = value;
                 while (value && (apdu_len > 0)) {
@@ -142,7 +339,8 @@ int rpm_ack_decode_service_request(
                     } else {
                         old_value = value;
                         value =
-                            calloc(1, sizeof(BACNET_APPLICATION_DATA_VALUE));
+                            alloc(context,
+                            sizeof(BACNET_APPLICATION_DATA_VALUE));
                         old_value->next = value;
                     }
                 }
@@ -181,7 +379,7 @@ int rpm_ack_decode_service_request(
                 }
             }
             old_rpm_property = rpm_property;
-            rpm_property = calloc(1, sizeof(BACNET_PROPERTY_REFERENCE));
+            rpm_property = alloc(context, sizeof(BACNET_PROPERTY_REFERENCE));
             old_rpm_property->next = rpm_property;
         }
         len = rpm_decode_object_end(apdu, apdu_len);
@@ -192,7 +390,7 @@ int rpm_ack_decode_service_request(
         }
         if (apdu_len) {
             old_rpm_object = rpm_object;
-            rpm_object = calloc(1, sizeof(BACNET_READ_ACCESS_DATA));
+            rpm_object = alloc(context, sizeof(BACNET_READ_ACCESS_DATA));
             old_rpm_object->next = rpm_object;
         }
     }
@@ -200,6 +398,64 @@ int rpm_ack_decode_service_request(
     return decoded_len;
 }
 
+/** Decode the received RPM data and make a linked list of the results.
+ * @ingroup DSRPM
+ *
+ * @param apdu [in] The received apdu data.
+ * @param apdu_len [in] Total length of the apdu.
+ * @param read_access_data [out] Pointer to the head of the linked list
+ * 			where the RPM data is to be stored.
+ * @return The number of bytes decoded, or -1 on error
+ */
+int rpm_ack_decode_service_request(
+    uint8_t * apdu,
+    int apdu_len,
+    BACNET_READ_ACCESS_DATA * read_access_data)
+{
+    return rpm_ack_decode_nodes(apdu, apdu_len, read_access_data,
+        rpm_ack_calloc, rpm_ack_free, NULL);
+}
+
+/** Decode the received RPM data into an arena.
+ * The objects, properties, and values are the same linked list as from
+ * rpm_ack_decode_service_request, but are laid out one after the other
+ * in the order they are decoded, and are all freed with
+ * rpm_ack_arena_reset or rpm_ack_arena_free.
+ * @ingroup DSRPM
+ *
+ * @param apdu [in] The received apdu data.
+ * @param apdu_len [in] Total length of the apdu.
+ * @param arena [in] The arena that holds the decoded data.
+ * @param read_access_data [out] Set to the head of the linked list,
+ *                          or NULL when the arena is full.
+ * @return The number of bytes decoded, or -1 on error or when the
+ *         arena ran out of memory
+ */
+int rpm_ack_decode_service_request_arena(
+    uint8_t * apdu,
+    int apdu_len,
+    BACNET_RPM_ACK_ARENA * arena,
+    BACNET_READ_ACCESS_DATA ** read_access_data)
+{
+    BACNET_READ_ACCESS_DATA *rpm_data = NULL;
+    int len = BACNET_STATUS_ERROR;
+
+    assert(arena != NULL);
+    assert(read_access_data != NULL);
+    rpm_data = rpm_ack_arena_alloc(arena, sizeof(BACNET_READ_ACCESS_DATA));
+    if (rpm_data) {
+        len =
+            rpm_ack_decode_nodes(apdu, apdu_len, rpm_data,
+            rpm_ack_arena_alloc, rpm_ack_arena_release, arena);
+        if (arena->full) {
+            len = BACNET_STATUS_ERROR;
+        }
+    }
+    *read_access_data = rpm_data;
+
+    return len;
+}
+
 /* for debugging... */
 void rpm_ack_print_data(
     BACNET_READ_ACCESS_DATA * rpm_data)
@@ -286,7 +542,7 @@ void rpm_ack_print_data(
 /** Handler for a ReadPropertyMultiple ACK.
  * @ingroup DSRPM
  * For each read property, print out the ACK'd data for debugging,
- * and free the request data items from linked property list.
+ * and free the decoded data in one call by resetting the arena.
  *
  * @param service_request [in] The contents of the service request.
  * @param service_len [in] The length of the service_request.
@@ -296,69 +552,310 @@ void rpm_ack_print_data(
  */
 void handler_read_property_multiple_ack(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
+    /* keeps its memory from one Ack to the next */
+    static BACNET_RPM_ACK_ARENA arena;
     int len = 0;
-    BACNET_READ_ACCESS_DATA *rpm_data;
-    BACNET_READ_ACCESS_DATA *old_rpm_data;
-    BACNET_PROPERTY_REFERENCE *rpm_property;
-    BACNET_PROPERTY_REFERENCE *old_rpm_property;
-    BACNET_APPLICATION_DATA_VALUE *value;
-    BACNET_APPLICATION_DATA_VALUE *old_value;
-
-    (void) src;
-    (void) service_data;        /* we could use these... */
+    BACNET_READ_ACCESS_DATA *rpm_data = NULL;
+    uint32_t device_id = 0;
 
-    rpm_data = calloc(1, sizeof(BACNET_READ_ACCESS_DATA));
-    if (rpm_data) {
-        len =
-            rpm_ack_decode_service_request(service_request, service_len,
-            rpm_data);
-    }
+    len =
+        rpm_ack_decode_service_request_arena(service_request, service_len,
+        &arena, &rpm_data);
 #if 1
     fprintf(stderr, "Received Read-Property-Multiple Ack!\n");
 #endif
     if (len > 0) {
+        if (address_get_device_id(src, &device_id)) {
+            property_cache_rpm_ack(device_id, service_data->invoke_id,
+                rpm_data);
+            rpm_plan_learn_rpm(device_id, rpm_data);
+        } else {
+            property_cache_pending_clear(service_data->invoke_id);
+        }
         while (rpm_data) {
             rpm_ack_print_data(rpm_data);
-            rpm_property = rpm_data->listOfProperties;
-            while (rpm_property) {
-                value = rpm_property->value;
-                while (value) {
-                    old_value = value;
-                    value = value->next;
-                    free(old_value);
-                }
-                old_rpm_property = rpm_property;
-                rpm_property = rpm_property->next;
-                free(old_rpm_property);
-            }
-            old_rpm_data = rpm_data;
             rpm_data = rpm_data->next;
-            free(old_rpm_data);
         }
     } else {
+        property_cache_pending_clear(service_data->invoke_id);
 #if 1
         fprintf(stderr, "RPM Ack Malformed! Freeing memory...\n");
 #endif
-        while (rpm_data) {
-            rpm_property = rpm_data->listOfProperties;
-            while (rpm_property) {
-                value = rpm_property->value;
-                while (value) {
-                    old_value = value;
-                    value = value->next;
-                    free(old_value);
-                }
-                old_rpm_property = rpm_property;
-                rpm_property = rpm_property->next;
-                free(old_rpm_property);
+    }
+    rpm_ack_arena_reset(&arena);
+}
+
+#ifdef TEST
+#include "ctest.h"
+
+/* encodes an RPM Ack service request with one property of each object,
+   holding an array of REAL values, and returns its length */
+static int testRpmAckEncode(
+    uint8_t * apdu,
+    unsigned objects,
+    unsigned values)
+{
+    uint8_t value_apdu[MAX_APDU] = { 0 };
+    BACNET_APPLICATION_DATA_VALUE value;
+    BACNET_RPM_DATA rpmdata;
+    int value_len = 0;
+    int apdu_len = 0;
+    unsigned i;
+
+    for (i = 0; i < values; i++) {
+        bacapp_parse_application_data(BACNET_APPLICATION_TAG_REAL, "1.5",
+            &value);
+        value.type.Real = (float) i;
+        value_len +=
+            bacapp_encode_application_data(&value_apdu[value_len], &value);
+    }
+    for (i = 0; i < objects; i++) {
+        rpmdata.object_type = OBJECT_ANALOG_INPUT;
+        rpmdata.object_instance = i;
+        apdu_len += rpm_ack_encode_apdu_object_begin(&apdu[apdu_len],
+            &rpmdata);
+        apdu_len += rpm_ack_encode_apdu_object_property(&apdu[apdu_len],
+            PROP_PRIORITY_ARRAY, BACNET_ARRAY_ALL);
+        apdu_len += rpm_ack_encode_apdu_object_property_value(&apdu[apdu_len],
+            &value_apdu[0], value_len);
+        apdu_len += rpm_ack_encode_apdu_object_end(&apdu[apdu_len]);
+    }
+
+    return apdu_len;
+}
+
+/* counts the objects and values, and checks the values are in order */
+static bool testRpmAckData(
+    BACNET_READ_ACCESS_DATA * rpm_data,
+    unsigned objects,
+    unsigned values)
+{
+    BACNET_APPLICATION_DATA_VALUE *value;
+    unsigned object_count = 0;
+    unsigned value_count;
+
+    while (rpm_data) {
+        if ((rpm_data->object_instance != object_count) ||
+            !rpm_data->listOfProperties ||
+            rpm_data->listOfProperties->next) {
+            return false;
+        }
+        value_count = 0;
+        value = rpm_data->listOfProperties->value;
+        while (value) {
+            if (value->type.Real != (float) value_count) {
+                return false;
             }
-            old_rpm_data = rpm_data;
-            rpm_data = rpm_data->next;
-            free(old_rpm_data);
+            value_count++;
+            value = value->next;
         }
+        if (value_count != values) {
+            return false;
+        }
+        object_count++;
+        rpm_data = rpm_data->next;
     }
+
+    return (object_count == objects);
+}
+
+/* true if the node was laid out within the memory */
+static bool testRpmAckWithin(
+    void *node,
+    uint8_t * buffer,
+    size_t size)
+{
+    return ((uint8_t *) node >= buffer) && ((uint8_t *) node < &buffer[size]);
+}
+
+void testRpmAckArenaBlocks(
+    Test * pTest)
+{
+    static uint8_t apdu[MAX_APDU * 4];
+    BACNET_RPM_ACK_ARENA arena;
+    BACNET_READ_ACCESS_DATA *rpm_data = NULL;
+    uint8_t *buffer = NULL;
+    unsigned values;
+    int apdu_len = 0;
+    int len = 0;
+
+    rpm_ack_arena_init(&arena, NULL, 0);
+    ct_test(pTest, arena.blocks == NULL);
+    ct_test(pTest, !arena.fixed);
+    /* a small Ack fits in the first block */
+    apdu_len = testRpmAckEncode(apdu, 2, 3);
+    len = rpm_ack_decode_service_request_arena(apdu, apdu_len, &arena,
+        &rpm_data);
+    ct_test(pTest, len == apdu_len);
+    ct_test(pTest, testRpmAckData(rpm_data, 2, 3));
+    ct_test(pTest, arena.blocks != NULL);
+    ct_test(pTest, arena.size == RPM_ACK_ARENA_BLOCK_SIZE);
+    /* the nodes are one after the other, in the order decoded */
+    ct_test(pTest, testRpmAckWithin(rpm_data, arena.buffer, arena.size));
+    ct_test(pTest, (uint8_t *) rpm_data->listOfProperties >
+        (uint8_t *) rpm_data);
+    ct_test(pTest, (uint8_t *) rpm_data->next >
+        (uint8_t *) rpm_data->listOfProperties->value);
+    /* reuse of the same block, with no malloc */
+    buffer = arena.buffer;
+    rpm_ack_arena_reset(&arena);
+    ct_test(pTest, arena.used == 0);
+    ct_test(pTest, arena.buffer == buffer);
+    len = rpm_ack_decode_service_request_arena(apdu, apdu_len, &arena,
+        &rpm_data);
+    ct_test(pTest, len == apdu_len);
+    ct_test(pTest, testRpmAckData(rpm_data, 2, 3));
+    ct_test(pTest, (uint8_t *) rpm_data == buffer);
+    rpm_ack_arena_reset(&arena);
+
+    /* an Ack larger than a block grows the arena by another block */
+    values = (RPM_ACK_ARENA_BLOCK_SIZE /
+        sizeof(BACNET_APPLICATION_DATA_VALUE)) + 2;
+    apdu_len = testRpmAckEncode(apdu, 1, values);
+    ct_test(pTest, apdu_len < sizeof(apdu));
+    len = rpm_ack_decode_service_request_arena(apdu, apdu_len, &arena,
+        &rpm_data);
+    ct_test(pTest, len == apdu_len);
+    ct_test(pTest, testRpmAckData(rpm_data, 1, values));
+    ct_test(pTest, !arena.full);
+    ct_test(pTest, ((RPM_ACK_ARENA_BLOCK *) arena.blocks)->header.next);
+    /* the reset replaces the blocks with one large enough for it */
+    rpm_ack_arena_reset(&arena);
+    ct_test(pTest, ((RPM_ACK_ARENA_BLOCK *) arena.blocks)->header.next ==
+        NULL);
+    ct_test(pTest, arena.size > RPM_ACK_ARENA_BLOCK_SIZE);
+    buffer = arena.buffer;
+    len = rpm_ack_decode_service_request_arena(apdu, apdu_len, &arena,
+        &rpm_data);
+    ct_test(pTest, len == apdu_len);
+    ct_test(pTest, testRpmAckData(rpm_data, 1, values));
+    ct_test(pTest, arena.buffer == buffer);
+    ct_test(pTest, ((RPM_ACK_ARENA_BLOCK *) arena.blocks)->header.next ==
+        NULL);
+    /* everything is freed in one call, and the arena can be used again */
+    rpm_ack_arena_free(&arena);
+    ct_test(pTest, arena.blocks == NULL);
+    ct_test(pTest, arena.buffer == NULL);
+    apdu_len = testRpmAckEncode(apdu, 2, 3);
+    len = rpm_ack_decode_service_request_arena(apdu, apdu_len, &arena,
+        &rpm_data);
+    ct_test(pTest, len == apdu_len);
+    ct_test(pTest, testRpmAckData(rpm_data, 2, 3));
+    rpm_ack_arena_free(&arena);
+}
+
+void testRpmAckArenaFixed(
+    Test * pTest)
+{
+    /* room for a few values */
+    static RPM_ACK_ARENA_ALIGN buffer[(4 *
+            sizeof(BACNET_APPLICATION_DATA_VALUE)) /
+        sizeof(RPM_ACK_ARENA_ALIGN)];
+    uint8_t apdu[MAX_APDU];
+    BACNET_RPM_ACK_ARENA arena;
+    BACNET_READ_ACCESS_DATA *rpm_data = NULL;
+    uint8_t *memory = (uint8_t *) buffer;
+    unsigned objects;
+    int apdu_len = 0;
+    int len = 0;
+
+    rpm_ack_arena_init(&arena, memory, sizeof(buffer));
+    ct_test(pTest, arena.fixed);
+    /* each object has a value, so there are more values than it holds */
+    objects = sizeof(buffer);
+    objects = (objects / sizeof(BACNET_APPLICATION_DATA_VALUE)) + 1;
+    apdu_len = testRpmAckEncode(apdu, objects, 1);
+    len = rpm_ack_decode_service_request_arena(apdu, apdu_len, &arena,
+        &rpm_data);
+    ct_test(pTest, len == BACNET_STATUS_ERROR);
+    ct_test(pTest, arena.full);
+    ct_test(pTest, arena.blocks == NULL);
+    ct_test(pTest, arena.buffer == memory);
+    ct_test(pTest, arena.used <= sizeof(buffer));
+    /* after a reset, an Ack that fits is decoded into the same buffer */
+    rpm_ack_arena_reset(&arena);
+    ct_test(pTest, !arena.full);
+    ct_test(pTest, arena.used == 0);
+    apdu_len = testRpmAckEncode(apdu, 1, 1);
+    len = rpm_ack_decode_service_request_arena(apdu, apdu_len, &arena,
+        &rpm_data);
+    ct_test(pTest, len == apdu_len);
+    ct_test(pTest, !arena.full);
+    ct_test(pTest, testRpmAckData(rpm_data, 1, 1));
+    ct_test(pTest, (uint8_t *) rpm_data == memory);
+    ct_test(pTest, testRpmAckWithin(rpm_data->listOfProperties->value,
+            memory, sizeof(buffer)));
+    /* freeing a fixed arena keeps the caller's buffer */
+    rpm_ack_arena_free(&arena);
+    ct_test(pTest, arena.fixed);
+    ct_test(pTest, arena.buffer == memory);
+    ct_test(pTest, arena.used == 0);
+}
+
+void testRpmAckList(
+    Test * pTest)
+{
+    uint8_t apdu[MAX_APDU];
+    BACNET_READ_ACCESS_DATA *rpm_data = NULL;
+    BACNET_READ_ACCESS_DATA *old_rpm_data = NULL;
+    BACNET_PROPERTY_REFERENCE *rpm_property;
+    BACNET_PROPERTY_REFERENCE *old_rpm_property;
+    BACNET_APPLICATION_DATA_VALUE *value;
+    BACNET_APPLICATION_DATA_VALUE *old_value;
+    int apdu_len = 0;
+    int len = 0;
+
+    /* the linked list from calloc is the same as from the arena */
+    apdu_len = testRpmAckEncode(apdu, 3, 4);
+    rpm_data = calloc(1, sizeof(BACNET_READ_ACCESS_DATA));
+    len = rpm_ack_decode_service_request(apdu, apdu_len, rpm_data);
+    ct_test(pTest, len == apdu_len);
+    ct_test(pTest, testRpmAckData(rpm_data, 3, 4));
+    while (rpm_data) {
+        rpm_property = rpm_data->listOfProperties;
+        while (rpm_property) {
+            value = rpm_property->value;
+            while (value) {
+                old_value = value;
+                value = value->next;
+                free(old_value);
+            }
+            old_rpm_property = rpm_property;
+            rpm_property = rpm_property->next;
+            free(old_rpm_property);
+        }
+        old_rpm_data = rpm_data;
+        rpm_data = rpm_data->next;
+        free(old_rpm_data);
+    }
+}
+
+#ifdef TEST_RPM_ACK
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("BACnet ReadPropertyMultiple Ack", NULL);
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testRpmAckList);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testRpmAckArenaBlocks);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testRpmAckArenaFixed);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+    ct_destroy(pTest);
+
+    return 0;
 }
+#endif /* TEST_RPM_ACK */
+#endif /* TEST */
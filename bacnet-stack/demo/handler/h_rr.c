@@ -36,6 +36,7 @@
 #include "npdu.h"
 #include "abort.h"
 #include "readrange.h"
+#include "tsm.h"
 #include "device.h"
 #include "handlers.h"
 
@@ -100,6 +101,8 @@ void handler_read_range(
     bool error = false;
     int bytes_sent = 0;
     BACNET_ADDRESS my_address;
+    uint8_t *apdu = NULL;
+    uint8_t *payload = NULL;
 
     data.error_class = ERROR_CLASS_OBJECT;
     data.error_code = ERROR_CODE_UNKNOWN_OBJECT;
@@ -137,21 +140,51 @@ void handler_read_range(
         goto RR_ABORT;
     }
 
+    apdu = &Handler_Transmit_Buffer[pdu_len];
+    payload = &Temp_Buf[0];
+#if BACNET_SEGMENTATION_ENABLED
+    if (service_data->segmented_response_accepted) {
+        /* encode as many items as fit into the segments the client takes
+           straight into the segment buffer, behind room for the header */
+        apdu = &Handler_Segment_Buffer[0];
+        payload = &Handler_Segment_Buffer[RR_ACK_HEADER_MAX];
+        data.MaxApdu =
+            (int) tsm_segmented_complex_ack_max_len(service_data) -
+            (RR_ACK_HEADER_MAX + RR_ACK_TRAILER_MAX) + data.Overhead;
+    }
+#endif
     /* assume that there is an error */
     error = true;
-    len = Encode_RR_payload(&Temp_Buf[0], &data);
+    len = Encode_RR_payload(payload, &data);
     if (len >= 0) {
         /* encode the APDU portion of the packet */
-        data.application_data = &Temp_Buf[0];
+        data.application_data = payload;
         data.application_data_len = len;
         /* FIXME: probably need a length limitation sent with encode */
-        len =
-            rr_ack_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
-            service_data->invoke_id, &data);
+        len = rr_ack_encode_apdu(&apdu[0], service_data->invoke_id, &data);
+        error = false;
+#if BACNET_SEGMENTATION_ENABLED
+        if (len > service_data->max_resp) {
+            if (tsm_set_segmented_complex_ack_transaction(src, &npdu_data,
+                    service_data, &apdu[0], len)) {
+#if PRINT_ENABLED
+                fprintf(stderr, "RR: Sending Segmented Ack!\n");
+#endif
+                return;
+            }
+            /* more segments than the client accepts */
+            len =
+                abort_encode_apdu(&Handler_Transmit_Buffer[pdu_len],
+                service_data->invoke_id, ABORT_REASON_BUFFER_OVERFLOW, true);
+            goto RR_ABORT;
+        }
+        if (apdu != &Handler_Transmit_Buffer[pdu_len]) {
+            memmove(&Handler_Transmit_Buffer[pdu_len], apdu, len);
+        }
+#endif
 #if PRINT_ENABLED
         fprintf(stderr, "RR: Sending Ack!\n");
 #endif
-        error = false;
     }
     if (error) {
         if (len == -2) {
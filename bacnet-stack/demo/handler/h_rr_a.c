@@ -101,7 +101,7 @@ static void PrintReadRangeData(
 
 void handler_read_range_ack(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
@@ -0,0 +1,2057 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "config.h"
+#include "bacdef.h"
+#include "bacdcode.h"
+#include "address.h"
+#include "tsm.h"
+#include "apdu.h"
+#include "iam.h"
+#include "rp.h"
+#include "rpm.h"
+#include "handlers.h"
+#include "client.h"
+#include "hashindex.h"
+#include "propcache.h"
+#include "rpmplan.h"
+#include "pollsched.h"
+
+/** @file pollsched.c  Poll the properties of many devices at once. */
+
+/* Each device has a list of points, which are read with as few
+   ReadPropertyMultiple requests as will fit the device's max APDU, as
+   planned by the RPM planner (see rpmplan.c), or with a ReadProperty
+   for each point if the device has no ReadPropertyMultiple.  The
+   points of a request whose ack did not fit, or that was rejected as
+   an unrecognized service, are read again in the requests that the
+   planner plans from then on.
+   Requests are sent to as many devices at once as the TSM allows,
+   limited per device and per network, and the devices are bound
+   with Who-Is requests that are also sent in parallel.  A scan of
+   a device starts when its interval has passed since the last scan
+   started, and ends when every point of the device has been read.
+   A point can also be read once, for the function that asked for it,
+   in the requests that are sent before the next points of a scan. */
+typedef uint16_t POLL_INDEX;
+
+#define POLL_MAX_REQUESTS \
+    ((MAX_TSM_TRANSACTIONS) ? (MAX_TSM_TRANSACTIONS) : 1)
+
+typedef struct {
+    uint32_t object_instance;
+    BACNET_PROPERTY_ID object_property;
+    uint32_t array_index;
+    uint16_t object_type;
+    /* next point of the same device, plus one, or zero at the end */
+    POLL_INDEX next;
+} POLL_POINT;
+
+typedef struct {
+    uint32_t device_id;
+    uint32_t interval;
+    /* when the next scan is due, and when this one started */
+    uint32_t scan_due;
+    uint32_t scan_start;
+    /* first and last point, plus one, and the next one to request */
+    POLL_INDEX head;
+    POLL_INDEX tail;
+    POLL_INDEX cursor;
+    /* first point, plus one, and the number of points, to read again */
+    POLL_INDEX retry;
+    uint16_t retry_count;
+    /* first and last read waiting to be sent, plus one */
+    POLL_INDEX read_head;
+    POLL_INDEX read_tail;
+    uint16_t outstanding;
+    bool bound;
+    bool binding;
+    bool scanning;
+    bool bind_started;
+    uint32_t bind_sent;
+    uint32_t bind_start;
+    unsigned max_apdu;
+    int segmentation;
+    /* index of its network in the network table */
+    uint8_t network;
+    POLL_DEVICE_STATS stats;
+} POLL_DEVICE;
+
+typedef struct {
+    uint16_t net;
+    uint16_t outstanding;
+} POLL_NETWORK;
+
+/* a point that is read once, whose next links the reads that wait
+   on the same device, or those of one request, or the free reads */
+typedef struct {
+    POLL_POINT point;
+    /* the function given the result, or NULL once it is cancelled */
+    poll_value_function function;
+    unsigned number;
+    uint32_t queued;
+} POLL_READ;
+
+typedef struct {
+    uint8_t invoke_id;
+    POLL_INDEX device;
+    /* first point of the request, and the number of points */
+    POLL_INDEX first;
+    uint16_t count;
+    /* the points are reads, rather than the points of a scan */
+    bool read;
+    uint32_t sent;
+    /* as planned, to plan smaller acks if its ack did not fit */
+    RPM_PLAN_REQUEST plan;
+} POLL_REQUEST;
+
+static POLL_DEVICE Poll_Devices[MAX_POLL_DEVICES];
+static POLL_INDEX Poll_Device_Hash[HASH_INDEX_SIZE(MAX_POLL_DEVICES)];
+static unsigned Poll_Device_Count;
+/* the device that is first to be served by the next task */
+static unsigned Poll_Device_Next;
+static POLL_POINT Poll_Points[MAX_POLL_POINTS];
+static unsigned Poll_Point_Count;
+static POLL_NETWORK Poll_Networks[MAX_POLL_NETWORKS];
+static unsigned Poll_Network_Count;
+static POLL_READ Poll_Reads[MAX_POLL_READS];
+/* first free read, plus one */
+static POLL_INDEX Poll_Read_Free;
+static POLL_REQUEST Poll_Requests[POLL_MAX_REQUESTS];
+/* request slot, plus one, of each invoke ID */
+static POLL_INDEX Poll_Invoke[256];
+static unsigned Poll_Request_Count;
+static unsigned Poll_Bind_Count;
+static unsigned Poll_Device_Limit = POLL_DEVICE_REQUESTS;
+static unsigned Poll_Network_Limit = POLL_NETWORK_REQUESTS;
+static unsigned Poll_Bind_Limit = POLL_BIND_REQUESTS;
+/* milliseconds counted by the task */
+static uint32_t Poll_Clock;
+static poll_value_function Poll_Value_Function;
+/* the handlers that were set before poll_init(), which are given the
+   replies to the requests that are not ours */
+static confirmed_ack_function Poll_RPM_Ack_Next;
+static confirmed_ack_function Poll_RP_Ack_Next;
+static error_function Poll_RPM_Error_Next;
+static error_function Poll_RP_Error_Next;
+static abort_function Poll_Abort_Next;
+static reject_function Poll_Reject_Next;
+/* the points of the request being planned, and its plan */
+static RPM_PLAN_POINT Poll_Plan_Points[POLL_REQUEST_POINTS];
+static RPM_PLAN_REQUEST Poll_Plan[POLL_REQUEST_POINTS];
+/* the request being built, and the PDU it is encoded into */
+static BACNET_READ_ACCESS_DATA Poll_Objects[POLL_REQUEST_POINTS];
+static BACNET_PROPERTY_REFERENCE Poll_Properties[POLL_REQUEST_POINTS];
+static uint8_t Poll_PDU[MAX_PDU];
+/* keeps its memory from one Ack to the next */
+static BACNET_RPM_ACK_ARENA Poll_Arena;
+/* the values of a ReadProperty Ack */
+static BACNET_APPLICATION_DATA_VALUE Poll_Values[POLL_RP_VALUES];
+
+static uint32_t poll_device_home(
+    uint32_t index)
+{
+    return hash_index_mix(Poll_Devices[index].device_id);
+}
+
+static HASH_INDEX Poll_Device_Index = {
+    Poll_Device_Hash, sizeof(POLL_INDEX), HASH_INDEX_SIZE(MAX_POLL_DEVICES),
+    poll_device_home
+};
+
+/* Find a polled device.  Returns the index, or -1 if not found. */
+static int poll_device_find(
+    uint32_t device_id)
+{
+    unsigned slot;
+    uint32_t value;
+
+    slot = hash_index_start(&Poll_Device_Index, hash_index_mix(device_id));
+    while ((value = hash_index_get(&Poll_Device_Index, slot)) != 0) {
+        if (Poll_Devices[value - 1].device_id == device_id) {
+            return (int) (value - 1);
+        }
+        slot = hash_index_next(&Poll_Device_Index, slot);
+    }
+
+    return -1;
+}
+
+/* Find the network, adding it to the table if there is room.
+   The networks that do not fit share the last entry. */
+static uint8_t poll_network(
+    uint16_t net)
+{
+    unsigned index;
+
+    for (index = 0; index < Poll_Network_Count; index++) {
+        if (Poll_Networks[index].net == net) {
+            return (uint8_t) index;
+        }
+    }
+    if (Poll_Network_Count < MAX_POLL_NETWORKS) {
+        index = Poll_Network_Count++;
+        Poll_Networks[index].net = net;
+        Poll_Networks[index].outstanding = 0;
+    } else {
+        index = MAX_POLL_NETWORKS - 1;
+    }
+
+    return (uint8_t) index;
+}
+
+/* A point of a request, which is a read or a point of a scan */
+static POLL_POINT *poll_request_point(
+    POLL_REQUEST * request,
+    unsigned point)
+{
+    if (request->read) {
+        return &Poll_Reads[point].point;
+    }
+
+    return &Poll_Points[point];
+}
+
+static void poll_read_value(
+    uint32_t device_id,
+    unsigned read,
+    BACNET_PROPERTY_REFERENCE * reference)
+{
+    POLL_READ *pRead = &Poll_Reads[read];
+
+    if (pRead->function) {
+        pRead->function(device_id, pRead->number, reference);
+    }
+}
+
+static void poll_point_value(
+    POLL_REQUEST * request,
+    unsigned point,
+    BACNET_PROPERTY_REFERENCE * reference)
+{
+    uint32_t device_id = Poll_Devices[request->device].device_id;
+
+    if (request->read) {
+        poll_read_value(device_id, point, reference);
+    } else if (Poll_Value_Function) {
+        Poll_Value_Function(device_id, point, reference);
+    }
+}
+
+static void poll_error_reference(
+    POLL_POINT * pPoint,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code,
+    BACNET_PROPERTY_REFERENCE * reference)
+{
+    reference->propertyIdentifier = pPoint->object_property;
+    reference->propertyArrayIndex = pPoint->array_index;
+    reference->value = NULL;
+    reference->error.error_class = error_class;
+    reference->error.error_code = error_code;
+    reference->next = NULL;
+}
+
+/* Report an error in place of the value of each point of a request */
+static void poll_request_error(
+    POLL_REQUEST * request,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code)
+{
+    BACNET_PROPERTY_REFERENCE reference;
+    POLL_POINT *pPoint;
+    unsigned point = request->first;
+    unsigned count;
+
+    for (count = 0; count < request->count; count++) {
+        pPoint = poll_request_point(request, point);
+        poll_error_reference(pPoint, error_class, error_code, &reference);
+        poll_point_value(request, point, &reference);
+        if (pPoint->next == 0) {
+            break;
+        }
+        point = pPoint->next - 1;
+    }
+}
+
+/* Put a read back on the free list */
+static void poll_read_free(
+    unsigned read)
+{
+    Poll_Reads[read].function = NULL;
+    Poll_Reads[read].point.next = Poll_Read_Free;
+    Poll_Read_Free = (POLL_INDEX) (read + 1);
+}
+
+/* Give up the reads of a device that are cancelled, or that have
+   waited too long to be sent, with a timeout error */
+static void poll_read_expire(
+    POLL_DEVICE * device)
+{
+    BACNET_PROPERTY_REFERENCE reference;
+    POLL_READ *pRead;
+    unsigned read, prev = 0, next;
+
+    next = device->read_head;
+    while (next) {
+        read = next - 1;
+        pRead = &Poll_Reads[read];
+        next = pRead->point.next;
+        if (pRead->function &&
+            ((Poll_Clock - pRead->queued) < POLL_READ_TIMEOUT)) {
+            prev = read + 1;
+            continue;
+        }
+        if (prev) {
+            Poll_Reads[prev - 1].point.next = (POLL_INDEX) next;
+        } else {
+            device->read_head = (POLL_INDEX) next;
+        }
+        if (device->read_tail == (read + 1)) {
+            device->read_tail = (POLL_INDEX) prev;
+        }
+        poll_error_reference(&pRead->point, ERROR_CLASS_COMMUNICATION,
+            ERROR_CODE_TIMEOUT, &reference);
+        poll_read_value(device->device_id, read, &reference);
+        poll_read_free(read);
+    }
+}
+
+/* A scan ends when every point has been requested and answered */
+static void poll_scan_check(
+    POLL_DEVICE * device)
+{
+    if (device->scanning && (device->cursor == 0) && (device->retry == 0) &&
+        (device->outstanding == 0)) {
+        device->scanning = false;
+        device->stats.scans++;
+        device->stats.scan_time = Poll_Clock - device->scan_start;
+        device->scan_due = device->scan_start + device->interval;
+    }
+}
+
+/* Free the request slot of a reply or a timeout */
+static void poll_request_release(
+    POLL_REQUEST * request)
+{
+    POLL_DEVICE *device = &Poll_Devices[request->device];
+    unsigned slot = (unsigned) (request - Poll_Requests);
+    unsigned last, read, count, next = request->first + 1;
+
+    if (request->read) {
+        for (count = 0; (count < request->count) && next; count++) {
+            read = next - 1;
+            next = Poll_Reads[read].point.next;
+            poll_read_free(read);
+        }
+    }
+    Poll_Invoke[request->invoke_id] = 0;
+    if (device->outstanding) {
+        device->outstanding--;
+    }
+    if (Poll_Networks[device->network].outstanding) {
+        Poll_Networks[device->network].outstanding--;
+    }
+    /* keep the slots in use packed at the start */
+    last = Poll_Request_Count - 1;
+    if (slot != last) {
+        Poll_Requests[slot] = Poll_Requests[last];
+        Poll_Invoke[Poll_Requests[slot].invoke_id] = (POLL_INDEX) (slot + 1);
+    }
+    Poll_Request_Count--;
+    poll_scan_check(device);
+}
+
+/* Find the request that is waiting on a reply from this address */
+static POLL_REQUEST *poll_request_find(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id)
+{
+    POLL_REQUEST *request;
+    BACNET_ADDRESS dest;
+    unsigned max_apdu = 0;
+
+    if (Poll_Invoke[invoke_id] == 0) {
+        return NULL;
+    }
+    request = &Poll_Requests[Poll_Invoke[invoke_id] - 1];
+    if (src && address_get_by_device(Poll_Devices[request->device].device_id,
+            &max_apdu, &dest) && !address_match(&dest, src)) {
+        return NULL;
+    }
+
+    return request;
+}
+
+/* Plan the next points of the device, or the points that are read
+   again, into one request that fits the max APDU of the device, and
+   whose ack fits what the device can send back, and send it.
+   Returns false if the request could not be sent. */
+static bool poll_request_send(
+    unsigned index)
+{
+    POLL_DEVICE *device = &Poll_Devices[index];
+    POLL_REQUEST *request;
+    POLL_POINT *pPoint;
+    RPM_PLAN_POINT *pPlanPoint;
+    BACNET_READ_ACCESS_DATA *rpm_data;
+    unsigned ack_segments = 1;
+    unsigned first, point, limit, points = 0;
+    unsigned max_apdu = 0;
+    BACNET_ADDRESS dest;
+    uint8_t invoke_id;
+    bool read = false;
+    int count;
+
+    if (device->retry) {
+        first = device->retry - 1;
+        limit = device->retry_count;
+    } else if (device->read_head) {
+        first = device->read_head - 1;
+        limit = POLL_REQUEST_POINTS;
+        read = true;
+    } else {
+        first = device->cursor - 1;
+        limit = POLL_REQUEST_POINTS;
+    }
+    if (limit > POLL_REQUEST_POINTS) {
+        limit = POLL_REQUEST_POINTS;
+    }
+    point = first;
+    for (;;) {
+        pPoint = read ? &Poll_Reads[point].point : &Poll_Points[point];
+        pPlanPoint = &Poll_Plan_Points[points++];
+        pPlanPoint->object_type = (BACNET_OBJECT_TYPE) pPoint->object_type;
+        pPlanPoint->object_instance = pPoint->object_instance;
+        pPlanPoint->object_property = pPoint->object_property;
+        pPlanPoint->array_index = pPoint->array_index;
+        if ((pPoint->next == 0) || (points >= limit)) {
+            break;
+        }
+        point = pPoint->next - 1;
+    }
+#if BACNET_SEGMENTATION_ENABLED
+    if ((device->segmentation == SEGMENTATION_BOTH) ||
+        (device->segmentation == SEGMENTATION_TRANSMIT)) {
+        ack_segments = POLL_ACK_SEGMENTS;
+    }
+#endif
+    /* only the first request of the plan is sent */
+    count =
+        rpm_plan_build_segmented(device->device_id, device->max_apdu,
+        ack_segments, Poll_Plan_Points, points, Poll_Plan,
+        POLL_REQUEST_POINTS);
+    if (count <= 0) {
+        return false;
+    }
+    if (Poll_Plan[0].rpm) {
+        rpm_data =
+            rpm_plan_read_access_data(Poll_Plan_Points, &Poll_Plan[0],
+            Poll_Objects, Poll_Properties);
+        invoke_id =
+            Send_Read_Property_Multiple_Request(&Poll_PDU[0],
+            sizeof(Poll_PDU), device->device_id, rpm_data);
+    } else {
+        pPlanPoint = &Poll_Plan_Points[0];
+        invoke_id =
+            Send_Read_Property_Request(device->device_id,
+            pPlanPoint->object_type, pPlanPoint->object_instance,
+            pPlanPoint->object_property, pPlanPoint->array_index);
+    }
+    if (invoke_id == 0) {
+        if (!address_get_by_device(device->device_id, &max_apdu, &dest)) {
+            /* the binding has gone from the address cache */
+            device->bound = false;
+        }
+        return false;
+    }
+    request = &Poll_Requests[Poll_Request_Count++];
+    request->invoke_id = invoke_id;
+    request->device = (POLL_INDEX) index;
+    request->first = (POLL_INDEX) first;
+    request->count = (uint16_t) Poll_Plan[0].count;
+    request->read = read;
+    request->sent = Poll_Clock;
+    request->plan = Poll_Plan[0];
+    Poll_Invoke[invoke_id] = (POLL_INDEX) Poll_Request_Count;
+    /* the point after the last one of the request */
+    point = first;
+    for (points = 1; points < request->count; points++) {
+        point = poll_request_point(request, point)->next - 1;
+    }
+    if (read) {
+        /* the reads of the request leave the queue of the device */
+        pPoint = &Poll_Reads[point].point;
+        device->read_head = pPoint->next;
+        if (device->read_head == 0) {
+            device->read_tail = 0;
+        }
+        pPoint->next = 0;
+    } else if (device->retry) {
+        device->retry_count -= request->count;
+        device->retry = 0;
+        if (device->retry_count) {
+            device->retry = Poll_Points[point].next;
+        }
+    } else {
+        device->cursor = Poll_Points[point].next;
+    }
+    device->outstanding++;
+    device->stats.requests++;
+    Poll_Networks[device->network].outstanding++;
+
+    return true;
+}
+
+/* Read the points of a request again, before the next points of its
+   device.  Returns false if the device has points of another request
+   to read again, in which case these are not.  Reads are always read
+   again. */
+static bool poll_request_retry(
+    POLL_REQUEST * request)
+{
+    POLL_DEVICE *device = &Poll_Devices[request->device];
+    unsigned last = request->first, count;
+
+    if (request->read) {
+        /* the reads go back to the front of the queue */
+        for (count = 1; count < request->count; count++) {
+            last = Poll_Reads[last].point.next - 1;
+        }
+        Poll_Reads[last].point.next = device->read_head;
+        if (device->read_head == 0) {
+            device->read_tail = (POLL_INDEX) (last + 1);
+        }
+        device->read_head = (POLL_INDEX) (request->first + 1);
+        /* ...so they are not freed with the request */
+        request->count = 0;
+        return true;
+    }
+    if (device->retry) {
+        return false;
+    }
+    device->retry = (POLL_INDEX) (request->first + 1);
+    device->retry_count = request->count;
+
+    return true;
+}
+
+/* Count a reply, and its round trip time */
+static void poll_request_reply(
+    POLL_REQUEST * request)
+{
+    POLL_DEVICE *device = &Poll_Devices[request->device];
+    uint32_t rtt;
+
+    rtt = Poll_Clock - request->sent;
+    if ((device->stats.replies == 0) || (rtt < device->stats.rtt_min)) {
+        device->stats.rtt_min = rtt;
+    }
+    if (rtt > device->stats.rtt_max) {
+        device->stats.rtt_max = rtt;
+    }
+    device->stats.rtt_total += rtt;
+    device->stats.replies++;
+}
+
+/* Bind the device with the address cache, sending a Who-Is
+   if it is not already bound.  Returns true once it is bound. */
+static bool poll_device_bind(
+    POLL_DEVICE * device)
+{
+    BACNET_ADDRESS dest;
+    unsigned max_apdu = 0;
+    bool bound = false;
+
+    if (device->binding) {
+        bound = address_get_by_device(device->device_id, &max_apdu, &dest);
+        if (bound || ((Poll_Clock - device->bind_sent) >= POLL_BIND_TIMEOUT)) {
+            device->binding = false;
+            Poll_Bind_Count--;
+        }
+    }
+    if (!bound && !device->binding && (Poll_Bind_Count < Poll_Bind_Limit)) {
+        bound =
+            address_bind_request(device->device_id, &max_apdu, &dest);
+        if (!bound) {
+            Send_WhoIs(device->device_id, device->device_id);
+            device->binding = true;
+            device->bind_sent = Poll_Clock;
+            if (!device->bind_started) {
+                device->bind_started = true;
+                device->bind_start = Poll_Clock;
+            }
+            Poll_Bind_Count++;
+        }
+    }
+    if (bound) {
+        device->bound = true;
+        device->max_apdu = max_apdu;
+        device->network = poll_network(dest.net);
+        if (device->bind_started) {
+            device->bind_started = false;
+            device->stats.bind_time = Poll_Clock - device->bind_start;
+        }
+    }
+
+    return bound;
+}
+
+/** Initialize the poll scheduler, and set the handlers that it needs
+ *  for I-Am, the ReadPropertyMultiple and ReadProperty Ack and Error,
+ *  and for Abort and Reject.  The Ack, Error, Abort and Reject handlers
+ *  that were set before are given the replies to the requests that the
+ *  scheduler did not send, so set them first.
+ *
+ * @param pFunction [in] Called with each value that is read.
+ */
+void poll_init(
+    poll_value_function pFunction)
+{
+    unsigned index;
+
+    Poll_Value_Function = pFunction;
+    Poll_Device_Count = 0;
+    Poll_Device_Next = 0;
+    Poll_Point_Count = 0;
+    Poll_Network_Count = 0;
+    Poll_Request_Count = 0;
+    Poll_Bind_Count = 0;
+    hash_index_clear(&Poll_Device_Index);
+    memset(Poll_Invoke, 0, sizeof(Poll_Invoke));
+    Poll_Read_Free = 0;
+    for (index = MAX_POLL_READS; index > 0; index--) {
+        poll_read_free(index - 1);
+    }
+    /* not our own handlers, if this is called again */
+    if (apdu_abort_handler() != handler_poll_abort) {
+        Poll_RPM_Ack_Next =
+            apdu_confirmed_ack_handler(SERVICE_CONFIRMED_READ_PROP_MULTIPLE);
+        Poll_RP_Ack_Next =
+            apdu_confirmed_ack_handler(SERVICE_CONFIRMED_READ_PROPERTY);
+        Poll_RPM_Error_Next =
+            apdu_error_handler(SERVICE_CONFIRMED_READ_PROP_MULTIPLE);
+        Poll_RP_Error_Next = apdu_error_handler(SERVICE_CONFIRMED_READ_PROPERTY);
+        Poll_Abort_Next = apdu_abort_handler();
+        Poll_Reject_Next = apdu_reject_handler();
+    }
+    apdu_set_unconfirmed_handler(SERVICE_UNCONFIRMED_I_AM, handler_poll_i_am);
+    apdu_set_confirmed_ack_handler(SERVICE_CONFIRMED_READ_PROP_MULTIPLE,
+        handler_poll_rpm_ack);
+    apdu_set_error_handler(SERVICE_CONFIRMED_READ_PROP_MULTIPLE,
+        handler_poll_error);
+    apdu_set_confirmed_ack_handler(SERVICE_CONFIRMED_READ_PROPERTY,
+        handler_poll_rp_ack);
+    apdu_set_error_handler(SERVICE_CONFIRMED_READ_PROPERTY,
+        handler_poll_rp_error);
+    apdu_set_abort_handler(handler_poll_abort);
+    apdu_set_reject_handler(handler_poll_reject);
+}
+
+/** Set the limits of requests outstanding at once.
+ *
+ * @param device_requests [in] Requests to any one device.
+ * @param network_requests [in] Requests to the devices on any one network.
+ * @param bind_requests [in] Who-Is requests waiting on an I-Am.
+ */
+void poll_limits_set(
+    unsigned device_requests,
+    unsigned network_requests,
+    unsigned bind_requests)
+{
+    Poll_Device_Limit = device_requests;
+    Poll_Network_Limit = network_requests;
+    Poll_Bind_Limit = bind_requests;
+}
+
+/** Add a device to poll, or change how often it is polled.
+ *
+ * @param device_id [in] Device instance to poll.
+ * @param interval [in] Milliseconds from the start of one scan of its
+ *                      points to the start of the next.
+ * @return true if the device is polled.
+ */
+bool poll_device_add(
+    uint32_t device_id,
+    uint32_t interval)
+{
+    POLL_DEVICE *device;
+    int index;
+
+    index = poll_device_find(device_id);
+    if (index >= 0) {
+        Poll_Devices[index].interval = interval;
+        return true;
+    }
+    if (Poll_Device_Count >= MAX_POLL_DEVICES) {
+        return false;
+    }
+    device = &Poll_Devices[Poll_Device_Count];
+    memset(device, 0, sizeof(*device));
+    device->device_id = device_id;
+    device->interval = interval;
+    device->scan_due = Poll_Clock;
+    device->segmentation = SEGMENTATION_NONE;
+    hash_index_insert(&Poll_Device_Index, Poll_Device_Count);
+    Poll_Device_Count++;
+
+    return true;
+}
+
+/** Add a point to be read from a polled device.
+ *
+ * @return the point number that is given with its values,
+ *         or -1 if the device is not polled or there is no room.
+ */
+int poll_point_add(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index)
+{
+    POLL_DEVICE *device;
+    POLL_POINT *pPoint;
+    int index;
+
+    index = poll_device_find(device_id);
+    if ((index < 0) || (Poll_Point_Count >= MAX_POLL_POINTS)) {
+        return -1;
+    }
+    device = &Poll_Devices[index];
+    pPoint = &Poll_Points[Poll_Point_Count];
+    pPoint->object_type = (uint16_t) object_type;
+    pPoint->object_instance = object_instance;
+    pPoint->object_property = object_property;
+    pPoint->array_index = array_index;
+    pPoint->next = 0;
+    Poll_Point_Count++;
+    if (device->tail) {
+        Poll_Points[device->tail - 1].next = (POLL_INDEX) Poll_Point_Count;
+    } else {
+        device->head = (POLL_INDEX) Poll_Point_Count;
+    }
+    device->tail = (POLL_INDEX) Poll_Point_Count;
+
+    return (int) (Poll_Point_Count - 1);
+}
+
+/** Read a point of a device once, in the next request that can be sent
+ *  to it, adding the device to those that are polled if it is not.
+ *  A read that is not sent within POLL_READ_TIMEOUT is given up with a
+ *  timeout error.
+ *
+ * @param pFunction [in] Called with the value, or the error in place of
+ *                       the value, and the number.
+ * @param number [in] Given to the function as the point.
+ * @return true if the read is queued, or false if there is no room.
+ */
+bool poll_read(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index,
+    poll_value_function pFunction,
+    unsigned number)
+{
+    POLL_DEVICE *device;
+    POLL_READ *pRead;
+    unsigned read;
+    int index;
+
+    index = poll_device_find(device_id);
+    if ((index < 0) && poll_device_add(device_id, 0)) {
+        index = poll_device_find(device_id);
+    }
+    if ((index < 0) || (Poll_Read_Free == 0) || !pFunction) {
+        return false;
+    }
+    device = &Poll_Devices[index];
+    read = Poll_Read_Free - 1;
+    pRead = &Poll_Reads[read];
+    Poll_Read_Free = pRead->point.next;
+    pRead->point.object_type = (uint16_t) object_type;
+    pRead->point.object_instance = object_instance;
+    pRead->point.object_property = object_property;
+    pRead->point.array_index = array_index;
+    pRead->point.next = 0;
+    pRead->function = pFunction;
+    pRead->number = number;
+    pRead->queued = Poll_Clock;
+    if (device->read_tail) {
+        Poll_Reads[device->read_tail - 1].point.next = (POLL_INDEX) (read + 1);
+    } else {
+        device->read_head = (POLL_INDEX) (read + 1);
+    }
+    device->read_tail = (POLL_INDEX) (read + 1);
+
+    return true;
+}
+
+/** Cancel the reads for a function and number, whose results are
+ *  no longer given to the function.
+ */
+void poll_read_cancel(
+    poll_value_function pFunction,
+    unsigned number)
+{
+    unsigned read;
+
+    for (read = 0; read < MAX_POLL_READS; read++) {
+        if ((Poll_Reads[read].function == pFunction) &&
+            (Poll_Reads[read].number == number)) {
+            Poll_Reads[read].function = NULL;
+        }
+    }
+}
+
+/** Bind a device, as for the requests to it that are sent by others,
+ *  adding it to those that are polled if it is not.
+ *
+ * @return true once the device is bound.
+ */
+bool poll_device_bound(
+    uint32_t device_id)
+{
+    POLL_DEVICE *device;
+    BACNET_ADDRESS dest;
+    unsigned max_apdu = 0;
+    int index;
+
+    index = poll_device_find(device_id);
+    if (index < 0) {
+        /* it is bound by the tasks that follow */
+        poll_device_add(device_id, 0);
+        return false;
+    }
+    device = &Poll_Devices[index];
+    if (device->bound &&
+        !address_get_by_device(device_id, &max_apdu, &dest)) {
+        /* the binding has gone from the address cache */
+        device->bound = false;
+    }
+
+    return device->bound;
+}
+
+/** Bind the devices, start the scans that are due, and send as many
+ *  requests as the limits allow.  Call it often, as the replies only
+ *  make room for more requests when it runs.
+ *
+ * @param elapsed_milliseconds [in] Time since the last call.
+ */
+void poll_task(
+    uint16_t elapsed_milliseconds)
+{
+    POLL_REQUEST *request;
+    POLL_DEVICE *device;
+    unsigned count, index, slot;
+
+    Poll_Clock += elapsed_milliseconds;
+    /* requests that the TSM has given up on */
+    slot = Poll_Request_Count;
+    while (slot > 0) {
+        slot--;
+        request = &Poll_Requests[slot];
+        if (tsm_invoke_id_failed(request->invoke_id)) {
+            Poll_Devices[request->device].stats.timeouts++;
+            poll_request_error(request, ERROR_CLASS_COMMUNICATION,
+                ERROR_CODE_TIMEOUT);
+            tsm_free_invoke_id(request->invoke_id);
+            poll_request_release(request);
+        } else if (tsm_invoke_id_free(request->invoke_id)) {
+            /* the reply went to another handler */
+            Poll_Devices[request->device].stats.errors++;
+            if (request->read) {
+                poll_request_error(request, ERROR_CLASS_COMMUNICATION,
+                    ERROR_CODE_OTHER);
+            }
+            poll_request_release(request);
+        }
+    }
+    if (Poll_Device_Count == 0) {
+        return;
+    }
+    /* start with a different device each time, so that each device
+       has its turn when the TSM or the networks are busy */
+    index = Poll_Device_Next;
+    for (count = 0; count < Poll_Device_Count; count++) {
+        device = &Poll_Devices[index];
+        if (device->read_head) {
+            poll_read_expire(device);
+        }
+        if ((device->bound || poll_device_bind(device)) &&
+            (device->head || device->read_head)) {
+            if (device->head && !device->scanning &&
+                ((int32_t) (Poll_Clock - device->scan_due) >= 0)) {
+                device->scanning = true;
+                device->cursor = device->head;
+                device->scan_start = Poll_Clock;
+            }
+            while (((device->scanning && (device->cursor || device->retry))
+                    || device->read_head) &&
+                (device->outstanding < Poll_Device_Limit) &&
+                (Poll_Networks[device->network].outstanding <
+                    Poll_Network_Limit) &&
+                (Poll_Request_Count < POLL_MAX_REQUESTS) &&
+                tsm_transaction_available()) {
+                if (!poll_request_send(index)) {
+                    break;
+                }
+            }
+        }
+        index++;
+        if (index >= Poll_Device_Count) {
+            index = 0;
+        }
+    }
+    Poll_Device_Next++;
+    if (Poll_Device_Next >= Poll_Device_Count) {
+        Poll_Device_Next = 0;
+    }
+}
+
+/** Returns the number of requests waiting on a reply */
+unsigned poll_outstanding(
+    void)
+{
+    return Poll_Request_Count;
+}
+
+/** Get the counters of a polled device.
+ *
+ * @return true if the device is polled.
+ */
+bool poll_device_stats(
+    uint32_t device_id,
+    POLL_DEVICE_STATS * stats)
+{
+    int index;
+
+    index = poll_device_find(device_id);
+    if ((index < 0) || !stats) {
+        return false;
+    }
+    *stats = Poll_Devices[index].stats;
+
+    return true;
+}
+
+/** Handler for I-Am, which binds the devices that are waiting on it
+ *  like handler_i_am_bind(), and notes whether a polled device can
+ *  send a segmented ack.
+ * @ingroup DMDDB
+ */
+void handler_poll_i_am(
+    uint8_t * service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS * src)
+{
+    int len = 0;
+    uint32_t device_id = 0;
+    unsigned max_apdu = 0;
+    int segmentation = 0;
+    uint16_t vendor_id = 0;
+    int index;
+
+    (void) service_len;
+    len =
+        iam_decode_service_request(service_request, &device_id, &max_apdu,
+        &segmentation, &vendor_id);
+    if (len > 0) {
+        /* only add address if requested to bind */
+        address_add_binding(device_id, max_apdu, src);
+        index = poll_device_find(device_id);
+        if (index >= 0) {
+            Poll_Devices[index].segmentation = segmentation;
+        }
+    }
+}
+
+/** Handler for the ReadPropertyMultiple Ack of a poll request, which
+ *  gives each value to the poll value function and the property cache,
+ *  and the sizes of the values to the RPM planner.
+ * @ingroup DSRPM
+ */
+void handler_poll_rpm_ack(
+    uint8_t * service_request,
+    uint32_t service_len,
+    BACNET_ADDRESS * src,
+    BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
+{
+    POLL_REQUEST *request;
+    POLL_DEVICE *device;
+    POLL_POINT *pPoint;
+    BACNET_READ_ACCESS_DATA *rpm_data = NULL, *rpm_object;
+    BACNET_PROPERTY_REFERENCE *rpm_property;
+    unsigned point, count = 0;
+    int len;
+
+    request = poll_request_find(src, service_data->invoke_id);
+    if (!request) {
+        if (Poll_RPM_Ack_Next) {
+            Poll_RPM_Ack_Next(service_request, service_len, src,
+                service_data);
+        }
+        return;
+    }
+    device = &Poll_Devices[request->device];
+    poll_request_reply(request);
+    len =
+        rpm_ack_decode_service_request_arena(service_request, service_len,
+        &Poll_Arena, &rpm_data);
+    if (len <= 0) {
+        device->stats.errors++;
+        poll_request_error(request, ERROR_CLASS_COMMUNICATION,
+            ERROR_CODE_INVALID_TAG);
+        rpm_ack_arena_reset(&Poll_Arena);
+        poll_request_release(request);
+        return;
+    }
+    property_cache_rpm_ack(device->device_id, service_data->invoke_id,
+        rpm_data);
+    rpm_plan_learn_rpm(device->device_id, rpm_data);
+    /* the results are in the same order as the request */
+    point = request->first;
+    rpm_object = rpm_data;
+    while (rpm_object && (count < request->count)) {
+        rpm_property = rpm_object->listOfProperties;
+        while (rpm_property && (count < request->count)) {
+            pPoint = poll_request_point(request, point);
+            if ((pPoint->object_type != rpm_object->object_type) ||
+                (pPoint->object_instance != rpm_object->object_instance) ||
+                (pPoint->object_property != rpm_property->propertyIdentifier)
+                || (pPoint->array_index != rpm_property->propertyArrayIndex)) {
+                break;
+            }
+            poll_point_value(request, point, rpm_property);
+            count++;
+            point = pPoint->next - 1;
+            rpm_property = rpm_property->next;
+        }
+        if (rpm_property) {
+            break;
+        }
+        rpm_object = rpm_object->next;
+    }
+    if (count < request->count) {
+        device->stats.errors++;
+    }
+    rpm_ack_arena_reset(&Poll_Arena);
+    poll_request_release(request);
+}
+
+/** Handler for the ReadProperty Ack of a poll request to a device that
+ *  has no ReadPropertyMultiple, which gives the value to the poll value
+ *  function and the property cache, and its size to the RPM planner.
+ * @ingroup DSRP
+ */
+void handler_poll_rp_ack(
+    uint8_t * service_request,
+    uint32_t service_len,
+    BACNET_ADDRESS * src,
+    BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
+{
+    POLL_REQUEST *request;
+    POLL_DEVICE *device;
+    POLL_POINT *pPoint;
+    BACNET_READ_PROPERTY_DATA rp_data;
+    BACNET_PROPERTY_REFERENCE reference;
+    uint8_t *apdu;
+    int apdu_len, len;
+    unsigned values = 0;
+
+    request = poll_request_find(src, service_data->invoke_id);
+    if (!request) {
+        if (Poll_RP_Ack_Next) {
+            Poll_RP_Ack_Next(service_request, service_len, src, service_data);
+        }
+        return;
+    }
+    device = &Poll_Devices[request->device];
+    poll_request_reply(request);
+    len =
+        rp_ack_decode_service_request(service_request, (int) service_len,
+        &rp_data);
+    if (len > 0) {
+        property_cache_rp_ack(device->device_id, service_data->invoke_id,
+            &rp_data);
+        rpm_plan_learn_rp(device->device_id, &rp_data);
+        /* the values of a list, as many as there is room for */
+        apdu = rp_data.application_data;
+        apdu_len = rp_data.application_data_len;
+        while ((apdu_len > 0) && (values < POLL_RP_VALUES)) {
+            len =
+                bacapp_decode_application_data(apdu, (unsigned) apdu_len,
+                &Poll_Values[values]);
+            if (len <= 0) {
+                break;
+            }
+            Poll_Values[values].next = NULL;
+            if (values) {
+                Poll_Values[values - 1].next = &Poll_Values[values];
+            }
+            values++;
+            apdu += len;
+            apdu_len -= len;
+        }
+    }
+    pPoint = poll_request_point(request, request->first);
+    if ((len <= 0) || (values == 0) || (request->count != 1) ||
+        (pPoint->object_type != (uint16_t) rp_data.object_type) ||
+        (pPoint->object_instance != rp_data.object_instance) ||
+        (pPoint->object_property != rp_data.object_property) ||
+        (pPoint->array_index != rp_data.array_index)) {
+        device->stats.errors++;
+        poll_request_error(request, ERROR_CLASS_COMMUNICATION,
+            ERROR_CODE_INVALID_TAG);
+    } else {
+        reference.propertyIdentifier = rp_data.object_property;
+        reference.propertyArrayIndex = rp_data.array_index;
+        reference.value = &Poll_Values[0];
+        reference.next = NULL;
+        poll_point_value(request, request->first, &reference);
+    }
+    poll_request_release(request);
+}
+
+static void poll_error(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code,
+    error_function next)
+{
+    POLL_REQUEST *request;
+
+    request = poll_request_find(src, invoke_id);
+    if (request) {
+        Poll_Devices[request->device].stats.errors++;
+        poll_request_error(request, error_class, error_code);
+        poll_request_release(request);
+    } else if (next) {
+        next(src, invoke_id, error_class, error_code);
+    }
+}
+
+/** Handler for the ReadPropertyMultiple Error of a poll request
+ * @ingroup DSRPM
+ */
+void handler_poll_error(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code)
+{
+    poll_error(src, invoke_id, error_class, error_code, Poll_RPM_Error_Next);
+}
+
+/** Handler for the ReadProperty Error of a poll request
+ * @ingroup DSRP
+ */
+void handler_poll_rp_error(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code)
+{
+    poll_error(src, invoke_id, error_class, error_code, Poll_RP_Error_Next);
+}
+
+/** Handler for an Abort of a poll request.  A device that cannot send
+ *  a segmented ack has its next requests packed to fit one APDU, and
+ *  the points of a request whose ack did not fit are read again in
+ *  smaller requests.
+ */
+void handler_poll_abort(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    uint8_t abort_reason,
+    bool server)
+{
+    POLL_REQUEST *request;
+    POLL_DEVICE *device;
+    BACNET_ERROR_CODE error_code = ERROR_CODE_ABORT_OTHER;
+
+    request = poll_request_find(src, invoke_id);
+    if (request) {
+        device = &Poll_Devices[request->device];
+        device->stats.errors++;
+        if (abort_reason == ABORT_REASON_SEGMENTATION_NOT_SUPPORTED) {
+            device->segmentation = SEGMENTATION_NONE;
+            error_code = ERROR_CODE_ABORT_SEGMENTATION_NOT_SUPPORTED;
+        } else if (abort_reason == ABORT_REASON_BUFFER_OVERFLOW) {
+            error_code = ERROR_CODE_ABORT_BUFFER_OVERFLOW;
+        }
+        if ((request->plan.count > 1) &&
+            ((abort_reason == ABORT_REASON_SEGMENTATION_NOT_SUPPORTED) ||
+                (abort_reason == ABORT_REASON_BUFFER_OVERFLOW))) {
+            /* the ack did not fit - plan smaller ones, and read again */
+            rpm_plan_overflow(device->device_id, &request->plan);
+            if (poll_request_retry(request)) {
+                poll_request_release(request);
+                return;
+            }
+        }
+        poll_request_error(request, ERROR_CLASS_COMMUNICATION, error_code);
+        poll_request_release(request);
+    } else if (Poll_Abort_Next) {
+        Poll_Abort_Next(src, invoke_id, abort_reason, server);
+    }
+}
+
+/** Handler for a Reject of a poll request.  A device that does not
+ *  recognize ReadPropertyMultiple has its points read again, and from
+ *  then on, with ReadProperty.
+ */
+void handler_poll_reject(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    uint8_t reject_reason)
+{
+    POLL_REQUEST *request;
+    POLL_DEVICE *device;
+    BACNET_ERROR_CODE error_code = ERROR_CODE_REJECT_OTHER;
+
+    request = poll_request_find(src, invoke_id);
+    if (request) {
+        device = &Poll_Devices[request->device];
+        device->stats.errors++;
+        if (reject_reason == REJECT_REASON_UNRECOGNIZED_SERVICE) {
+            error_code = ERROR_CODE_REJECT_UNRECOGNIZED_SERVICE;
+            if (request->plan.rpm) {
+                rpm_plan_rpm_supported_set(device->device_id, false);
+                if (poll_request_retry(request)) {
+                    poll_request_release(request);
+                    return;
+                }
+            }
+        }
+        poll_request_error(request, ERROR_CLASS_SERVICES, error_code);
+        poll_request_release(request);
+    } else if (Poll_Reject_Next) {
+        Poll_Reject_Next(src, invoke_id, reject_reason);
+    }
+}
+
+#ifdef TEST
+#include <assert.h>
+#include "ctest.h"
+
+/* The TSM and the network, as seen by the poll scheduler.  The points
+   of each request are kept, by invoke ID, to answer it with. */
+#define TEST_TSM_FREE 0
+#define TEST_TSM_WAITING 1
+#define TEST_TSM_FAILED 2
+static uint8_t Test_TSM[256];
+static uint8_t Test_Invoke_ID;
+static unsigned Test_Who_Is;
+static uint32_t Test_Device[256];
+static bool Test_Is_RP[256];
+static unsigned Test_Count[256];
+static RPM_PLAN_POINT Test_Points[256][POLL_REQUEST_POINTS];
+/* the values, and the errors in place of values, of each point */
+static unsigned Test_Values[MAX_POLL_POINTS];
+static unsigned Test_Errors[MAX_POLL_POINTS];
+/* the handlers as they are set, and the replies given to those that
+   were set before the poll scheduler's */
+static confirmed_ack_function
+    Test_Ack_Function[MAX_BACNET_CONFIRMED_SERVICE];
+static error_function Test_Error_Function[MAX_BACNET_CONFIRMED_SERVICE];
+static abort_function Test_Abort_Function;
+static reject_function Test_Reject_Function;
+static unsigned Test_Other_Replies;
+/* the values, and the last error, of each number that was read once */
+static unsigned Test_Read_Values[8];
+static BACNET_ERROR_CODE Test_Read_Error[8];
+
+static uint8_t testInvokeID(
+    void)
+{
+    do {
+        Test_Invoke_ID++;
+    } while ((Test_Invoke_ID == 0) ||
+        (Test_TSM[Test_Invoke_ID] != TEST_TSM_FREE));
+    Test_TSM[Test_Invoke_ID] = TEST_TSM_WAITING;
+
+    return Test_Invoke_ID;
+}
+
+bool tsm_transaction_available(
+    void)
+{
+    return true;
+}
+
+bool tsm_invoke_id_free(
+    uint8_t invokeID)
+{
+    return Test_TSM[invokeID] == TEST_TSM_FREE;
+}
+
+bool tsm_invoke_id_failed(
+    uint8_t invokeID)
+{
+    return Test_TSM[invokeID] == TEST_TSM_FAILED;
+}
+
+void tsm_free_invoke_id(
+    uint8_t invokeID)
+{
+    Test_TSM[invokeID] = TEST_TSM_FREE;
+}
+
+void apdu_set_unconfirmed_handler(
+    BACNET_UNCONFIRMED_SERVICE service_choice,
+    unconfirmed_function pFunction)
+{
+    (void) service_choice;
+    (void) pFunction;
+}
+
+void apdu_set_confirmed_ack_handler(
+    BACNET_CONFIRMED_SERVICE service_choice,
+    confirmed_ack_function pFunction)
+{
+    Test_Ack_Function[service_choice] = pFunction;
+}
+
+confirmed_ack_function apdu_confirmed_ack_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    return Test_Ack_Function[service_choice];
+}
+
+void apdu_set_error_handler(
+    BACNET_CONFIRMED_SERVICE service_choice,
+    error_function pFunction)
+{
+    Test_Error_Function[service_choice] = pFunction;
+}
+
+error_function apdu_error_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    return Test_Error_Function[service_choice];
+}
+
+void apdu_set_abort_handler(
+    abort_function pFunction)
+{
+    Test_Abort_Function = pFunction;
+}
+
+abort_function apdu_abort_handler(
+    void)
+{
+    return Test_Abort_Function;
+}
+
+void apdu_set_reject_handler(
+    reject_function pFunction)
+{
+    Test_Reject_Function = pFunction;
+}
+
+reject_function apdu_reject_handler(
+    void)
+{
+    return Test_Reject_Function;
+}
+
+void Send_WhoIs(
+    int32_t low_limit,
+    int32_t high_limit)
+{
+    (void) low_limit;
+    (void) high_limit;
+    Test_Who_Is++;
+}
+
+uint8_t Send_Read_Property_Multiple_Request(
+    uint8_t * pdu,
+    size_t max_pdu,
+    uint32_t device_id,
+    BACNET_READ_ACCESS_DATA * read_access_data)
+{
+    BACNET_PROPERTY_REFERENCE *rpm_property;
+    RPM_PLAN_POINT *pPoint;
+    uint8_t invoke_id;
+
+    (void) pdu;
+    (void) max_pdu;
+    invoke_id = testInvokeID();
+    Test_Device[invoke_id] = device_id;
+    Test_Is_RP[invoke_id] = false;
+    Test_Count[invoke_id] = 0;
+    for (; read_access_data; read_access_data = read_access_data->next) {
+        for (rpm_property = read_access_data->listOfProperties; rpm_property;
+            rpm_property = rpm_property->next) {
+            pPoint = &Test_Points[invoke_id][Test_Count[invoke_id]++];
+            pPoint->object_type = read_access_data->object_type;
+            pPoint->object_instance = read_access_data->object_instance;
+            pPoint->object_property = rpm_property->propertyIdentifier;
+            pPoint->array_index = rpm_property->propertyArrayIndex;
+        }
+    }
+
+    return invoke_id;
+}
+
+uint8_t Send_Read_Property_Request(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index)
+{
+    RPM_PLAN_POINT *pPoint;
+    uint8_t invoke_id;
+
+    invoke_id = testInvokeID();
+    Test_Device[invoke_id] = device_id;
+    Test_Is_RP[invoke_id] = true;
+    Test_Count[invoke_id] = 1;
+    pPoint = &Test_Points[invoke_id][0];
+    pPoint->object_type = object_type;
+    pPoint->object_instance = object_instance;
+    pPoint->object_property = object_property;
+    pPoint->array_index = array_index;
+
+    return invoke_id;
+}
+
+void property_cache_rp_ack(
+    uint32_t device_id,
+    uint8_t invoke_id,
+    BACNET_READ_PROPERTY_DATA * rp_data)
+{
+    (void) device_id;
+    (void) invoke_id;
+    (void) rp_data;
+}
+
+void property_cache_rpm_ack(
+    uint32_t device_id,
+    uint8_t invoke_id,
+    BACNET_READ_ACCESS_DATA * rpm_data)
+{
+    (void) device_id;
+    (void) invoke_id;
+    (void) rpm_data;
+}
+
+void property_cache_pending_clear(
+    uint8_t invoke_id)
+{
+    (void) invoke_id;
+}
+
+static void testValue(
+    uint32_t device_id,
+    unsigned point,
+    BACNET_PROPERTY_REFERENCE * reference)
+{
+    (void) device_id;
+    if (reference->value) {
+        Test_Values[point]++;
+    } else {
+        Test_Errors[point]++;
+    }
+}
+
+static void testPollInit(
+    void)
+{
+    memset(Test_TSM, 0, sizeof(Test_TSM));
+    memset(Test_Values, 0, sizeof(Test_Values));
+    memset(Test_Errors, 0, sizeof(Test_Errors));
+    Test_Who_Is = 0;
+    address_init();
+    rpm_plan_init();
+    poll_init(testValue);
+}
+
+static void testDeviceAddress(
+    uint32_t device_id,
+    uint16_t net,
+    BACNET_ADDRESS * src)
+{
+    memset(src, 0, sizeof(*src));
+    src->mac_len = 1;
+    src->mac[0] = (uint8_t) device_id;
+    src->net = net;
+    if (net) {
+        src->len = 1;
+        src->adr[0] = (uint8_t) device_id;
+    }
+}
+
+/* A bound device with analog inputs 0 to points - 1 to poll */
+static void testDeviceAdd(
+    uint32_t device_id,
+    uint16_t net,
+    unsigned max_apdu,
+    unsigned points)
+{
+    BACNET_ADDRESS src;
+    unsigned i;
+
+    if (max_apdu) {
+        testDeviceAddress(device_id, net, &src);
+        address_add(device_id, max_apdu, &src);
+    }
+    poll_device_add(device_id, 1000);
+    for (i = 0; i < points; i++) {
+        poll_point_add(device_id, OBJECT_ANALOG_INPUT, i, PROP_PRESENT_VALUE,
+            BACNET_ARRAY_ALL);
+    }
+}
+
+/* Answers a ReadPropertyMultiple as it was sent, with a Present_Value
+   of the instance and a quarter */
+static void testRpmAck(
+    uint8_t invoke_id)
+{
+    static uint8_t apdu[MAX_APDU * POLL_ACK_SEGMENTS];
+    BACNET_CONFIRMED_SERVICE_ACK_DATA service_data;
+    BACNET_ADDRESS src;
+    BACNET_RPM_DATA rpmdata;
+    RPM_PLAN_POINT *pPoint, *pLast = NULL;
+    unsigned max_apdu = 0;
+    uint8_t value[16];
+    unsigned i;
+    int len, value_len;
+
+    len = rpm_ack_encode_apdu_init(&apdu[0], invoke_id);
+    for (i = 0; i < Test_Count[invoke_id]; i++) {
+        pPoint = &Test_Points[invoke_id][i];
+        if (!pLast || (pLast->object_instance != pPoint->object_instance)) {
+            if (pLast) {
+                len += rpm_ack_encode_apdu_object_end(&apdu[len]);
+            }
+            rpmdata.object_type = pPoint->object_type;
+            rpmdata.object_instance = pPoint->object_instance;
+            len += rpm_ack_encode_apdu_object_begin(&apdu[len], &rpmdata);
+        }
+        pLast = pPoint;
+        len +=
+            rpm_ack_encode_apdu_object_property(&apdu[len],
+            pPoint->object_property, pPoint->array_index);
+        value_len =
+            encode_application_real(&value[0],
+            (float) pPoint->object_instance + 0.25f);
+        len +=
+            rpm_ack_encode_apdu_object_property_value(&apdu[len], &value[0],
+            value_len);
+    }
+    len += rpm_ack_encode_apdu_object_end(&apdu[len]);
+    memset(&service_data, 0, sizeof(service_data));
+    service_data.invoke_id = invoke_id;
+    address_get_by_device(Test_Device[invoke_id], &max_apdu, &src);
+    /* as apdu_handler() does, after the handler */
+    handler_poll_rpm_ack(&apdu[3], len - 3, &src, &service_data);
+    tsm_free_invoke_id(invoke_id);
+}
+
+static void testRpAck(
+    uint8_t invoke_id)
+{
+    static uint8_t apdu[MAX_APDU];
+    BACNET_CONFIRMED_SERVICE_ACK_DATA service_data;
+    BACNET_READ_PROPERTY_DATA rp_data;
+    BACNET_ADDRESS src;
+    RPM_PLAN_POINT *pPoint;
+    unsigned max_apdu = 0;
+    uint8_t value[16];
+    int len;
+
+    pPoint = &Test_Points[invoke_id][0];
+    rp_data.object_type = pPoint->object_type;
+    rp_data.object_instance = pPoint->object_instance;
+    rp_data.object_property = pPoint->object_property;
+    rp_data.array_index = pPoint->array_index;
+    rp_data.application_data = &value[0];
+    rp_data.application_data_len =
+        encode_application_real(&value[0],
+        (float) pPoint->object_instance + 0.25f);
+    len = rp_ack_encode_apdu(&apdu[0], invoke_id, &rp_data);
+    memset(&service_data, 0, sizeof(service_data));
+    service_data.invoke_id = invoke_id;
+    address_get_by_device(Test_Device[invoke_id], &max_apdu, &src);
+    handler_poll_rp_ack(&apdu[3], len - 3, &src, &service_data);
+    tsm_free_invoke_id(invoke_id);
+}
+
+/* Answers the requests, and runs the task, until none are left */
+static void testAnswerAll(
+    void)
+{
+    unsigned id;
+
+    do {
+        for (id = 1; id < 256; id++) {
+            if (Test_TSM[id] != TEST_TSM_WAITING) {
+                continue;
+            }
+            if (Test_Is_RP[id]) {
+                testRpAck((uint8_t) id);
+            } else {
+                testRpmAck((uint8_t) id);
+            }
+        }
+        poll_task(10);
+    } while (poll_outstanding());
+}
+
+/* Returns the number of requests waiting on the device */
+static unsigned testWaiting(
+    uint32_t device_id)
+{
+    unsigned id, count = 0;
+
+    for (id = 1; id < 256; id++) {
+        if ((Test_TSM[id] == TEST_TSM_WAITING) &&
+            (Test_Device[id] == device_id)) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static void testPollLimits(
+    Test * pTest)
+{
+    POLL_DEVICE_STATS stats;
+    uint32_t device_id;
+    unsigned i;
+
+    testPollInit();
+    poll_limits_set(1, 2, POLL_BIND_REQUESTS);
+    /* three devices on network 1, and one on network 2 */
+    for (device_id = 1; device_id <= 4; device_id++) {
+        testDeviceAdd(device_id, (device_id < 4) ? 1 : 2, 128, 40);
+    }
+    poll_task(0);
+    ct_test(pTest, poll_outstanding() == 3);
+    ct_test(pTest, (testWaiting(1) + testWaiting(2) + testWaiting(3)) == 2);
+    ct_test(pTest, testWaiting(4) == 1);
+    poll_task(0);
+    ct_test(pTest, poll_outstanding() == 3);
+    /* more for each device, but no more than 5 on network 1 */
+    poll_limits_set(2, 5, POLL_BIND_REQUESTS);
+    poll_task(0);
+    ct_test(pTest, poll_outstanding() == 7);
+    for (device_id = 1; device_id <= 4; device_id++) {
+        ct_test(pTest, testWaiting(device_id) <= 2);
+    }
+    ct_test(pTest, (testWaiting(1) + testWaiting(2) + testWaiting(3)) == 5);
+    ct_test(pTest, testWaiting(4) == 2);
+    /* every point is read once in a scan */
+    testAnswerAll();
+    for (i = 0; i < 160; i++) {
+        ct_test(pTest, Test_Values[i] == 1);
+        ct_test(pTest, Test_Errors[i] == 0);
+    }
+    for (device_id = 1; device_id <= 4; device_id++) {
+        ct_test(pTest, poll_device_stats(device_id, &stats));
+        ct_test(pTest, stats.scans == 1);
+        ct_test(pTest, stats.requests > 1);
+        ct_test(pTest, stats.replies == stats.requests);
+        ct_test(pTest, stats.errors == 0);
+    }
+}
+
+static void testPollBind(
+    Test * pTest)
+{
+    POLL_DEVICE_STATS stats;
+    BACNET_ADDRESS src;
+    uint8_t apdu[MAX_APDU];
+    uint32_t device_id;
+    uint8_t invoke_id;
+    int len;
+
+    testPollInit();
+    poll_limits_set(1, 1, 2);
+    for (device_id = 11; device_id <= 14; device_id++) {
+        testDeviceAdd(device_id, 0, 0, 1);
+    }
+    /* two devices are bound at once */
+    poll_task(0);
+    ct_test(pTest, Test_Who_Is == 2);
+    ct_test(pTest, poll_outstanding() == 0);
+    poll_task(20);
+    ct_test(pTest, Test_Who_Is == 2);
+    /* an I-Am makes room for another */
+    testDeviceAddress(11, 0, &src);
+    len = iam_encode_apdu(&apdu[0], 11, 480, SEGMENTATION_NONE, 0);
+    handler_poll_i_am(&apdu[2], (uint16_t) (len - 2), &src);
+    /* in the turn of each device, after the binding is seen */
+    poll_task(0);
+    poll_task(0);
+    ct_test(pTest, Test_Who_Is == 3);
+    ct_test(pTest, poll_outstanding() == 1);
+    ct_test(pTest, testWaiting(11) == 1);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, poll_device_stats(11, &stats));
+    ct_test(pTest, stats.bind_time == 20);
+    /* a Who-Is that is not answered is sent again */
+    poll_task(POLL_BIND_TIMEOUT);
+    ct_test(pTest, Test_Who_Is == 5);
+    testRpmAck(invoke_id);
+    ct_test(pTest, Test_Values[0] == 1);
+    ct_test(pTest, poll_outstanding() == 0);
+}
+
+static void testPollTimes(
+    Test * pTest)
+{
+    POLL_DEVICE_STATS stats;
+    uint8_t invoke_id;
+
+    testPollInit();
+    poll_limits_set(1, 1, 1);
+    testDeviceAdd(21, 0, 480, 1);
+    poll_task(0);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_WAITING);
+    poll_task(30);
+    testRpmAck(invoke_id);
+    /* the next scan is due when the interval has passed */
+    poll_task(960);
+    ct_test(pTest, poll_outstanding() == 0);
+    poll_task(10);
+    ct_test(pTest, poll_outstanding() == 1);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_WAITING);
+    poll_task(50);
+    testRpmAck(invoke_id);
+    ct_test(pTest, poll_device_stats(21, &stats));
+    ct_test(pTest, stats.scans == 2);
+    ct_test(pTest, stats.scan_time == 50);
+    ct_test(pTest, stats.replies == 2);
+    ct_test(pTest, stats.rtt_min == 30);
+    ct_test(pTest, stats.rtt_max == 50);
+    ct_test(pTest, stats.rtt_total == 80);
+    ct_test(pTest, Test_Values[0] == 2);
+    /* a request that the TSM gave up on gives an error */
+    poll_task(950);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_WAITING);
+    Test_TSM[invoke_id] = TEST_TSM_FAILED;
+    poll_task(0);
+    ct_test(pTest, poll_device_stats(21, &stats));
+    ct_test(pTest, stats.timeouts == 1);
+    ct_test(pTest, stats.scans == 3);
+    ct_test(pTest, Test_Errors[0] == 1);
+    ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_FREE);
+}
+
+static void testPollOverflow(
+    Test * pTest)
+{
+    POLL_DEVICE_STATS stats;
+    BACNET_ADDRESS src;
+    unsigned max_apdu = 0, count, limit, i;
+    uint8_t invoke_id;
+
+    testPollInit();
+    poll_limits_set(1, 1, 1);
+    testDeviceAdd(31, 0, 480, 60);
+    address_get_by_device(31, &max_apdu, &src);
+    poll_task(0);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_WAITING);
+    count = Test_Count[invoke_id];
+    ct_test(pTest, count > 1);
+    limit = Poll_Requests[0].plan.ack_size;
+    limit -= limit / 4;
+    /* the ack did not fit, so its points are read again, in smaller
+       requests, without an error */
+    handler_poll_abort(&src, invoke_id, ABORT_REASON_BUFFER_OVERFLOW, true);
+    tsm_free_invoke_id(invoke_id);
+    poll_task(0);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_WAITING);
+    ct_test(pTest, Test_Count[invoke_id] < count);
+    ct_test(pTest, Test_Points[invoke_id][0].object_instance == 0);
+    ct_test(pTest, Poll_Requests[0].plan.ack_size <= limit);
+    testAnswerAll();
+    for (i = 0; i < 60; i++) {
+        ct_test(pTest, Test_Values[i] == 1);
+        ct_test(pTest, Test_Errors[i] == 0);
+    }
+    ct_test(pTest, poll_device_stats(31, &stats));
+    ct_test(pTest, stats.scans == 1);
+    ct_test(pTest, stats.errors == 1);
+    /* a device without ReadPropertyMultiple is read with ReadProperty */
+    poll_task(1000);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_WAITING);
+    ct_test(pTest, !Test_Is_RP[invoke_id]);
+    handler_poll_reject(&src, invoke_id, REJECT_REASON_UNRECOGNIZED_SERVICE);
+    tsm_free_invoke_id(invoke_id);
+    poll_task(0);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_WAITING);
+    ct_test(pTest, Test_Is_RP[invoke_id]);
+    ct_test(pTest, Test_Points[invoke_id][0].object_instance == 0);
+    testAnswerAll();
+    for (i = 0; i < 60; i++) {
+        ct_test(pTest, Test_Values[i] == 2);
+        ct_test(pTest, Test_Errors[i] == 0);
+    }
+    ct_test(pTest, poll_device_stats(31, &stats));
+    ct_test(pTest, stats.scans == 2);
+    ct_test(pTest, stats.errors == 2);
+}
+
+static void testReadValue(
+    uint32_t device_id,
+    unsigned number,
+    BACNET_PROPERTY_REFERENCE * reference)
+{
+    (void) device_id;
+    if (reference->value) {
+        Test_Read_Values[number]++;
+    } else {
+        Test_Read_Error[number] = reference->error.error_code;
+    }
+}
+
+static void testPollRead(
+    Test * pTest)
+{
+    BACNET_ADDRESS src;
+    unsigned max_apdu = 0, i;
+    uint8_t invoke_id;
+
+    testPollInit();
+    memset(Test_Read_Values, 0, sizeof(Test_Read_Values));
+    memset(Test_Read_Error, 0, sizeof(Test_Read_Error));
+    testDeviceAdd(61, 0, 480, 2);
+    /* the reads go before the points of the scan, in one request */
+    for (i = 0; i < 3; i++) {
+        ct_test(pTest, poll_read(61, OBJECT_ANALOG_VALUE, i,
+                PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, testReadValue, i));
+    }
+    poll_task(0);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_Count[invoke_id] == 3);
+    ct_test(pTest, Test_Points[invoke_id][0].object_type ==
+        OBJECT_ANALOG_VALUE);
+    testAnswerAll();
+    for (i = 0; i < 3; i++) {
+        ct_test(pTest, Test_Read_Values[i] == 1);
+    }
+    ct_test(pTest, Test_Values[0] == 1);
+    ct_test(pTest, Test_Values[1] == 1);
+    /* reads whose ack did not fit are read again, and a cancelled read
+       is not given to the function */
+    for (i = 0; i < 3; i++) {
+        poll_read(61, OBJECT_ANALOG_VALUE, i, PROP_PRESENT_VALUE,
+            BACNET_ARRAY_ALL, testReadValue, i);
+    }
+    poll_task(0);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_Count[invoke_id] == 3);
+    address_get_by_device(61, &max_apdu, &src);
+    handler_poll_abort(&src, invoke_id, ABORT_REASON_BUFFER_OVERFLOW, true);
+    tsm_free_invoke_id(invoke_id);
+    poll_read_cancel(testReadValue, 1);
+    poll_task(0);
+    ct_test(pTest, Test_TSM[Test_Invoke_ID] == TEST_TSM_WAITING);
+    ct_test(pTest, Test_Points[Test_Invoke_ID][0].object_instance == 0);
+    testAnswerAll();
+    ct_test(pTest, Test_Read_Values[0] == 2);
+    ct_test(pTest, Test_Read_Values[1] == 1);
+    ct_test(pTest, Test_Read_Values[2] == 2);
+    ct_test(pTest, Test_Read_Error[1] == 0);
+    /* a read of a device that is never bound is given up */
+    ct_test(pTest, !poll_device_bound(62));
+    ct_test(pTest, poll_read(62, OBJECT_ANALOG_VALUE, 4, PROP_PRESENT_VALUE,
+            BACNET_ARRAY_ALL, testReadValue, 4));
+    poll_task(0);
+    ct_test(pTest, Test_Who_Is == 1);
+    poll_task(POLL_READ_TIMEOUT - 1);
+    ct_test(pTest, Test_Read_Error[4] == 0);
+    poll_task(1);
+    ct_test(pTest, Test_Read_Error[4] == ERROR_CODE_TIMEOUT);
+    ct_test(pTest, Test_Read_Values[4] == 0);
+    ct_test(pTest, poll_device_bound(61));
+    ct_test(pTest, !poll_device_bound(62));
+}
+
+static void testOtherAck(
+    uint8_t * service_request,
+    uint32_t service_len,
+    BACNET_ADDRESS * src,
+    BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
+{
+    (void) service_request;
+    (void) service_len;
+    (void) src;
+    (void) service_data;
+    Test_Other_Replies++;
+}
+
+static void testOtherError(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code)
+{
+    (void) src;
+    (void) invoke_id;
+    (void) error_class;
+    (void) error_code;
+    Test_Other_Replies++;
+}
+
+static void testOtherAbort(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    uint8_t abort_reason,
+    bool server)
+{
+    (void) src;
+    (void) invoke_id;
+    (void) abort_reason;
+    (void) server;
+    Test_Other_Replies++;
+}
+
+static void testOtherReject(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    uint8_t reject_reason)
+{
+    (void) src;
+    (void) invoke_id;
+    (void) reject_reason;
+    Test_Other_Replies++;
+}
+
+static void testPollOther(
+    Test * pTest)
+{
+    BACNET_CONFIRMED_SERVICE_ACK_DATA service_data;
+    BACNET_ADDRESS src;
+    unsigned max_apdu = 0;
+    uint8_t apdu[4] = { 0 };
+    uint8_t invoke_id;
+
+    /* the handlers of another client, set before the scheduler's */
+    apdu_set_confirmed_ack_handler(SERVICE_CONFIRMED_READ_PROP_MULTIPLE,
+        testOtherAck);
+    apdu_set_confirmed_ack_handler(SERVICE_CONFIRMED_READ_PROPERTY,
+        testOtherAck);
+    apdu_set_error_handler(SERVICE_CONFIRMED_READ_PROP_MULTIPLE,
+        testOtherError);
+    apdu_set_error_handler(SERVICE_CONFIRMED_READ_PROPERTY, testOtherError);
+    apdu_set_abort_handler(testOtherAbort);
+    apdu_set_reject_handler(testOtherReject);
+    testPollInit();
+    /* ...which keeps them when it is initialized again */
+    testPollInit();
+    ct_test(pTest, apdu_abort_handler() == handler_poll_abort);
+    Test_Other_Replies = 0;
+    testDeviceAdd(41, 0, 480, 1);
+    poll_task(0);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_WAITING);
+    address_get_by_device(41, &max_apdu, &src);
+    /* the replies to a request that it did not send go to them */
+    memset(&service_data, 0, sizeof(service_data));
+    service_data.invoke_id = (uint8_t) (invoke_id + 1);
+    handler_poll_rpm_ack(&apdu[0], sizeof(apdu), &src, &service_data);
+    handler_poll_rp_ack(&apdu[0], sizeof(apdu), &src, &service_data);
+    handler_poll_error(&src, service_data.invoke_id, ERROR_CLASS_OBJECT,
+        ERROR_CODE_UNKNOWN_OBJECT);
+    handler_poll_rp_error(&src, service_data.invoke_id, ERROR_CLASS_OBJECT,
+        ERROR_CODE_UNKNOWN_OBJECT);
+    handler_poll_abort(&src, service_data.invoke_id, ABORT_REASON_OTHER,
+        true);
+    handler_poll_reject(&src, service_data.invoke_id, REJECT_REASON_OTHER);
+    ct_test(pTest, Test_Other_Replies == 6);
+    ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_WAITING);
+    /* and those to its own request do not */
+    testAnswerAll();
+    ct_test(pTest, Test_Other_Replies == 6);
+    ct_test(pTest, Test_Values[0] == 1);
+    /* as apdu_init() would, for the tests that follow */
+    memset(Test_Ack_Function, 0, sizeof(Test_Ack_Function));
+    memset(Test_Error_Function, 0, sizeof(Test_Error_Function));
+    Test_Abort_Function = NULL;
+    Test_Reject_Function = NULL;
+}
+
+void testPollScheduler(
+    Test * pTest)
+{
+    testPollLimits(pTest);
+    testPollBind(pTest);
+    testPollTimes(pTest);
+    testPollOverflow(pTest);
+    testPollRead(pTest);
+    testPollOther(pTest);
+}
+
+#ifdef TEST_POLL_SCHEDULER
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("BACnet Poll Scheduler", NULL);
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testPollLimits);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testPollBind);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testPollTimes);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testPollOverflow);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testPollRead);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testPollOther);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+    ct_destroy(pTest);
+
+    return 0;
+}
+#endif /* TEST_POLL_SCHEDULER */
+#endif /* TEST */
@@ -44,6 +44,13 @@
 
 /** @file s_iam.c  Send an I-Am message. */
 
+/* the segmentation we advertise in our I-Am */
+#if BACNET_SEGMENTATION_ENABLED
+#define IAM_SEGMENTATION SEGMENTATION_BOTH
+#else
+#define IAM_SEGMENTATION SEGMENTATION_NONE
+#endif
+
 /** Send a I-Am request to a remote network for a specific device.
  * @param target_address [in] BACnet address of target router
  * @param device_id [in] Device Instance 0 - 4194303
@@ -113,7 +120,7 @@ int iam_encode_pdu(
     /* encode the APDU portion of the packet */
     len =
         iam_encode_apdu(&buffer[pdu_len], Device_Object_Instance_Number(),
-        MAX_APDU, SEGMENTATION_NONE, Device_Vendor_Identifier());
+        MAX_APDU, IAM_SEGMENTATION, Device_Vendor_Identifier());
     pdu_len += len;
 
     return pdu_len;
@@ -186,7 +193,7 @@ int iam_unicast_encode_pdu(
     /* encode the APDU portion of the packet */
     apdu_len =
         iam_encode_apdu(&buffer[npdu_len], Device_Object_Instance_Number(),
-        MAX_APDU, SEGMENTATION_NONE, Device_Vendor_Identifier());
+        MAX_APDU, IAM_SEGMENTATION, Device_Vendor_Identifier());
     pdu_len = npdu_len + apdu_len;
 
     return pdu_len;
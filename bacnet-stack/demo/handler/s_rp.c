@@ -38,6 +38,7 @@
 #include "datalink.h"
 #include "dcc.h"
 #include "rp.h"
+#include "propcache.h"
 /* some demo stuff needed */
 #include "handlers.h"
 #include "txbuf.h"
@@ -165,3 +166,52 @@ uint8_t Send_Read_Property_Request(
 
     return invoke_id;
 }
+
+/** Sends a Read Property request, unless the same property of the same
+ *  device is already being read, in which case the caller shares that
+ *  request and its invoke id.  The value from the ack is stored in the
+ *  property cache, so the caller reads it with property_cache_read()
+ *  once tsm_invoke_id_free() reports the invoke id as done.
+ * @ingroup DSRP
+ *
+ * @param device_id [in] ID of the destination device
+ * @param object_type [in]  Type of the object whose property is to be read.
+ * @param object_instance [in] Instance # of the object to be read.
+ * @param object_property [in] Property to be read, but not ALL, REQUIRED, or OPTIONAL.
+ * @param array_index [in] Optional: if the Property is an array,
+ *   - 0 for the array size
+ *   - 1 to n for individual array members
+ *   - BACNET_ARRAY_ALL (~0) for the full array to be read.
+ * @return invoke id of the request in flight, or 0 if device is not bound or no tsm available
+ */
+uint8_t Send_Read_Property_Request_Shared(
+    uint32_t device_id, /* destination device */
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index)
+{
+    uint8_t invoke_id = 0;
+
+    invoke_id =
+        property_cache_pending(device_id, object_type, object_instance,
+        object_property, array_index);
+    if (invoke_id && (tsm_invoke_id_free(invoke_id) ||
+            tsm_invoke_id_failed(invoke_id))) {
+        /* the read ended without an ack: an Error, Reject or Abort
+           frees the invoke id, and a timeout fails it */
+        property_cache_pending_clear(invoke_id);
+        invoke_id = 0;
+    }
+    if (invoke_id == 0) {
+        invoke_id =
+            Send_Read_Property_Request(device_id, object_type,
+            object_instance, object_property, array_index);
+    }
+    if (invoke_id) {
+        property_cache_pending_set(device_id, object_type, object_instance,
+            object_property, array_index, invoke_id);
+    }
+
+    return invoke_id;
+}
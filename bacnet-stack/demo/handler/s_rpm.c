@@ -38,6 +38,7 @@
 #include "datalink.h"
 #include "dcc.h"
 #include "rpm.h"
+#include "rpmplan.h"
 /* some demo stuff needed */
 #include "handlers.h"
 #include "sbuf.h"
@@ -121,3 +122,45 @@ uint8_t Send_Read_Property_Multiple_Request(
 
     return invoke_id;
 }
+
+/** Sends one request of a plan from rpm_plan_build(), which is a
+ *  Read Property Multiple request of its points, or a Read Property
+ *  request of its one point for a device that does not support RPM.
+ * @ingroup DSRPM
+ *
+ * @param pdu [out] Buffer to build the outgoing message into
+ * @param max_pdu [in] Length of the pdu buffer.
+ * @param device_id [in] ID of the destination device
+ * @param points [in] The points of the plan.
+ * @param request [in] The request from the plan to send.
+ * @return invoke id of outgoing message, or 0 if device is not bound or no tsm available
+ */
+uint8_t Send_Read_Property_Multiple_Plan(
+    uint8_t * pdu,
+    size_t max_pdu,
+    uint32_t device_id, /* destination device */
+    RPM_PLAN_POINT * points,
+    RPM_PLAN_REQUEST * request)
+{
+    static BACNET_READ_ACCESS_DATA objects[RPM_PLAN_REQUEST_POINTS];
+    static BACNET_PROPERTY_REFERENCE properties[RPM_PLAN_REQUEST_POINTS];
+    BACNET_READ_ACCESS_DATA *read_access_data;
+    RPM_PLAN_POINT *pPoint;
+
+    if (!points || !request || (request->count == 0) ||
+        (request->count > RPM_PLAN_REQUEST_POINTS)) {
+        return 0;
+    }
+    if (!request->rpm) {
+        pPoint = &points[request->first];
+        return Send_Read_Property_Request(device_id, pPoint->object_type,
+            pPoint->object_instance, pPoint->object_property,
+            pPoint->array_index);
+    }
+    read_access_data =
+        rpm_plan_read_access_data(points, request, &objects[0],
+        &properties[0]);
+
+    return Send_Read_Property_Multiple_Request(pdu, max_pdu, device_id,
+        read_access_data);
+}
@@ -30,3 +30,6 @@
 /** @file txbuf.c  Declare the global Transmit Buffer for handler functions. */
 
 uint8_t Handler_Transmit_Buffer[MAX_PDU] = { 0 };
+#if BACNET_SEGMENTATION_ENABLED
+uint8_t Handler_Segment_Buffer[MAX_SEGMENTED_APDU];
+#endif
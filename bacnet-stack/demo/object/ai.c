@@ -221,6 +221,8 @@ static void Analog_Input_COV_Detect(unsigned int index,
         if (cov_delta >= cov_increment) {
             AI_Descr[index].Changed = true;
             AI_Descr[index].Prior_Value = value;
+            handler_cov_object_changed(OBJECT_ANALOG_INPUT,
+                Analog_Input_Index_To_Instance(index));
         }
     }
 }
@@ -234,6 +236,13 @@ void Analog_Input_Present_Value_Set(
     index = Analog_Input_Instance_To_Index(object_instance);
     if (index < MAX_ANALOG_INPUTS) {
         Analog_Input_COV_Detect(index, value);
+#if defined(INTRINSIC_REPORTING)
+        if (AI_Descr[index].Limit_Enable &&
+            (AI_Descr[index].Present_Value != value)) {
+            Device_local_reporting_changed(OBJECT_ANALOG_INPUT,
+                object_instance);
+        }
+#endif
         AI_Descr[index].Present_Value = value;
     }
 }
@@ -293,6 +302,9 @@ bool Analog_Input_Encode_Value_List(
     BACNET_PROPERTY_VALUE * value_list)
 {
     bool status = false;
+#if defined(INTRINSIC_REPORTING)
+    unsigned index = 0;
+#endif
 
     if (value_list) {
         value_list->propertyIdentifier = PROP_PRESENT_VALUE;
@@ -311,8 +323,15 @@ bool Analog_Input_Encode_Value_List(
         value_list->value.context_specific = false;
         value_list->value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
         bitstring_init(&value_list->value.type.Bit_String);
+#if defined(INTRINSIC_REPORTING)
+        index = Analog_Input_Instance_To_Index(object_instance);
+        bitstring_set_bit(&value_list->value.type.Bit_String,
+            STATUS_FLAG_IN_ALARM, (index < MAX_ANALOG_INPUTS) &&
+            (AI_Descr[index].Event_State != EVENT_STATE_NORMAL));
+#else
         bitstring_set_bit(&value_list->value.type.Bit_String,
             STATUS_FLAG_IN_ALARM, false);
+#endif
         bitstring_set_bit(&value_list->value.type.Bit_String,
             STATUS_FLAG_FAULT, false);
         bitstring_set_bit(&value_list->value.type.Bit_String,
@@ -392,6 +411,11 @@ void Analog_Input_Out_Of_Service_Set(
     		review by all interested parties. Say 6 months -> September 2016 */
         if (AI_Descr[index].Out_Of_Service != value) {
             AI_Descr[index].Changed = true;
+            handler_cov_object_changed(OBJECT_ANALOG_INPUT, object_instance);
+#if defined(INTRINSIC_REPORTING)
+            Device_local_reporting_changed(OBJECT_ANALOG_INPUT,
+                object_instance);
+#endif
         }
         AI_Descr[index].Out_Of_Service = value;
     }
@@ -749,6 +773,9 @@ bool Analog_Input_Write_Property(
             if (status) {
                 CurrentAI->Time_Delay = value.type.Unsigned_Int;
                 CurrentAI->Remaining_Time_Delay = CurrentAI->Time_Delay;
+                CurrentAI->Time_Delay_Counted = 0;
+                Device_local_reporting_changed(OBJECT_ANALOG_INPUT,
+                    wp_data->object_instance);
             }
             break;
 
@@ -769,6 +796,8 @@ bool Analog_Input_Write_Property(
 
             if (status) {
                 CurrentAI->High_Limit = value.type.Real;
+                Device_local_reporting_changed(OBJECT_ANALOG_INPUT,
+                    wp_data->object_instance);
             }
             break;
 
@@ -779,6 +808,8 @@ bool Analog_Input_Write_Property(
 
             if (status) {
                 CurrentAI->Low_Limit = value.type.Real;
+                Device_local_reporting_changed(OBJECT_ANALOG_INPUT,
+                    wp_data->object_instance);
             }
             break;
 
@@ -789,6 +820,8 @@ bool Analog_Input_Write_Property(
 
             if (status) {
                 CurrentAI->Deadband = value.type.Real;
+                Device_local_reporting_changed(OBJECT_ANALOG_INPUT,
+                    wp_data->object_instance);
             }
             break;
 
@@ -800,6 +833,8 @@ bool Analog_Input_Write_Property(
             if (status) {
                 if (value.type.Bit_String.bits_used == 2) {
                     CurrentAI->Limit_Enable = value.type.Bit_String.value[0];
+                    Device_local_reporting_changed(OBJECT_ANALOG_INPUT,
+                        wp_data->object_instance);
                 } else {
                     wp_data->error_class = ERROR_CLASS_PROPERTY;
                     wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
@@ -816,6 +851,8 @@ bool Analog_Input_Write_Property(
             if (status) {
                 if (value.type.Bit_String.bits_used == 3) {
                     CurrentAI->Event_Enable = value.type.Bit_String.value[0];
+                    Device_local_reporting_changed(OBJECT_ANALOG_INPUT,
+                        wp_data->object_instance);
                 } else {
                     wp_data->error_class = ERROR_CLASS_PROPERTY;
                     wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
@@ -933,10 +970,11 @@ void Analog_Input_Intrinsic_Reporting(
                         EVENT_HIGH_LIMIT_ENABLE) &&
                     ((CurrentAI->Event_Enable & EVENT_ENABLE_TO_OFFNORMAL) ==
                         EVENT_ENABLE_TO_OFFNORMAL)) {
-                    if (!CurrentAI->Remaining_Time_Delay)
+                    if (Device_local_reporting_time_delay(OBJECT_ANALOG_INPUT,
+                            object_instance, CurrentAI->Time_Delay,
+                            &CurrentAI->Remaining_Time_Delay,
+                            &CurrentAI->Time_Delay_Counted))
                         CurrentAI->Event_State = EVENT_STATE_HIGH_LIMIT;
-                    else
-                        CurrentAI->Remaining_Time_Delay--;
                     break;
                 }
 
@@ -950,14 +988,16 @@ void Analog_Input_Intrinsic_Reporting(
                         EVENT_LOW_LIMIT_ENABLE) &&
                     ((CurrentAI->Event_Enable & EVENT_ENABLE_TO_OFFNORMAL) ==
                         EVENT_ENABLE_TO_OFFNORMAL)) {
-                    if (!CurrentAI->Remaining_Time_Delay)
+                    if (Device_local_reporting_time_delay(OBJECT_ANALOG_INPUT,
+                            object_instance, CurrentAI->Time_Delay,
+                            &CurrentAI->Remaining_Time_Delay,
+                            &CurrentAI->Time_Delay_Counted))
                         CurrentAI->Event_State = EVENT_STATE_LOW_LIMIT;
-                    else
-                        CurrentAI->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAI->Remaining_Time_Delay = CurrentAI->Time_Delay;
+                CurrentAI->Time_Delay_Counted = 0;
                 break;
 
             case EVENT_STATE_HIGH_LIMIT:
@@ -972,14 +1012,16 @@ void Analog_Input_Intrinsic_Reporting(
                         EVENT_HIGH_LIMIT_ENABLE) &&
                     ((CurrentAI->Event_Enable & EVENT_ENABLE_TO_NORMAL) ==
                         EVENT_ENABLE_TO_NORMAL)) {
-                    if (!CurrentAI->Remaining_Time_Delay)
+                    if (Device_local_reporting_time_delay(OBJECT_ANALOG_INPUT,
+                            object_instance, CurrentAI->Time_Delay,
+                            &CurrentAI->Remaining_Time_Delay,
+                            &CurrentAI->Time_Delay_Counted))
                         CurrentAI->Event_State = EVENT_STATE_NORMAL;
-                    else
-                        CurrentAI->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAI->Remaining_Time_Delay = CurrentAI->Time_Delay;
+                CurrentAI->Time_Delay_Counted = 0;
                 break;
 
             case EVENT_STATE_LOW_LIMIT:
@@ -995,14 +1037,16 @@ void Analog_Input_Intrinsic_Reporting(
                         EVENT_LOW_LIMIT_ENABLE) &&
                     ((CurrentAI->Event_Enable & EVENT_ENABLE_TO_NORMAL) ==
                         EVENT_ENABLE_TO_NORMAL)) {
-                    if (!CurrentAI->Remaining_Time_Delay)
+                    if (Device_local_reporting_time_delay(OBJECT_ANALOG_INPUT,
+                            object_instance, CurrentAI->Time_Delay,
+                            &CurrentAI->Remaining_Time_Delay,
+                            &CurrentAI->Time_Delay_Counted))
                         CurrentAI->Event_State = EVENT_STATE_NORMAL;
-                    else
-                        CurrentAI->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAI->Remaining_Time_Delay = CurrentAI->Time_Delay;
+                CurrentAI->Time_Delay_Counted = 0;
                 break;
 
             default:
@@ -1342,6 +1386,8 @@ int Analog_Input_Alarm_Ack(
     }
     CurrentAI->Ack_notify_data.bSendAckNotify = true;
     CurrentAI->Ack_notify_data.EventState = alarmack_data->eventStateAcked;
+    Device_local_reporting_changed(OBJECT_ANALOG_INPUT,
+        alarmack_data->eventObjectIdentifier.instance);
 
     return 1;
 }
@@ -1392,6 +1438,14 @@ int Analog_Input_Alarm_Summary(
 #include <string.h>
 #include "ctest.h"
 
+void handler_cov_object_changed(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    object_type = object_type;
+    object_instance = object_instance;
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
@@ -197,6 +197,8 @@ static void Analog_Value_COV_Detect(unsigned int index,
         if (cov_delta >= cov_increment) {
             AV_Descr[index].Changed = true;
             AV_Descr[index].Prior_Value = value;
+            handler_cov_object_changed(OBJECT_ANALOG_VALUE,
+                Analog_Value_Index_To_Instance(index));
         }
     }
 }
@@ -222,6 +224,13 @@ bool Analog_Value_Present_Value_Set(
     index = Analog_Value_Instance_To_Index(object_instance);
     if (index < MAX_ANALOG_VALUES) {
         Analog_Value_COV_Detect(index, value);
+#if defined(INTRINSIC_REPORTING)
+        if (AV_Descr[index].Limit_Enable &&
+            (AV_Descr[index].Present_Value != value)) {
+            Device_local_reporting_changed(OBJECT_ANALOG_VALUE,
+                object_instance);
+        }
+#endif
         AV_Descr[index].Present_Value = value;
         status = true;
     }
@@ -308,6 +317,9 @@ bool Analog_Value_Encode_Value_List(
     BACNET_PROPERTY_VALUE * value_list)
 {
     bool status = false;
+#if defined(INTRINSIC_REPORTING)
+    unsigned index = 0;
+#endif
 
     if (value_list) {
         value_list->propertyIdentifier = PROP_PRESENT_VALUE;
@@ -326,8 +338,15 @@ bool Analog_Value_Encode_Value_List(
         value_list->value.context_specific = false;
         value_list->value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
         bitstring_init(&value_list->value.type.Bit_String);
+#if defined(INTRINSIC_REPORTING)
+        index = Analog_Value_Instance_To_Index(object_instance);
+        bitstring_set_bit(&value_list->value.type.Bit_String,
+        STATUS_FLAG_IN_ALARM, (index < MAX_ANALOG_VALUES) &&
+        (AV_Descr[index].Event_State != EVENT_STATE_NORMAL));
+#else
         bitstring_set_bit(&value_list->value.type.Bit_String,
         STATUS_FLAG_IN_ALARM, false);
+#endif
         bitstring_set_bit(&value_list->value.type.Bit_String,
         STATUS_FLAG_FAULT, false);
         bitstring_set_bit(&value_list->value.type.Bit_String,
@@ -399,6 +418,11 @@ void Analog_Value_Out_Of_Service_Set(
     if (index < MAX_ANALOG_VALUES) {
         if (AV_Descr[index].Out_Of_Service != value) {
             AV_Descr[index].Changed = true;
+            handler_cov_object_changed(OBJECT_ANALOG_VALUE, object_instance);
+#if defined(INTRINSIC_REPORTING)
+            Device_local_reporting_changed(OBJECT_ANALOG_VALUE,
+                object_instance);
+#endif
         }
         AV_Descr[index].Out_Of_Service = value;
     }
@@ -707,7 +731,8 @@ bool Analog_Value_Write_Property(
                 WPValidateArgType(&value, BACNET_APPLICATION_TAG_BOOLEAN,
                 &wp_data->error_class, &wp_data->error_code);
             if (status) {
-                CurrentAV->Out_Of_Service = value.type.Boolean;
+                Analog_Value_Out_Of_Service_Set(wp_data->object_instance,
+                    value.type.Boolean);
             }
             break;
 
@@ -746,6 +771,9 @@ bool Analog_Value_Write_Property(
             if (status) {
                 CurrentAV->Time_Delay = value.type.Unsigned_Int;
                 CurrentAV->Remaining_Time_Delay = CurrentAV->Time_Delay;
+                CurrentAV->Time_Delay_Counted = 0;
+                Device_local_reporting_changed(OBJECT_ANALOG_VALUE,
+                    wp_data->object_instance);
             }
             break;
 
@@ -766,6 +794,8 @@ bool Analog_Value_Write_Property(
 
             if (status) {
                 CurrentAV->High_Limit = value.type.Real;
+                Device_local_reporting_changed(OBJECT_ANALOG_VALUE,
+                    wp_data->object_instance);
             }
             break;
 
@@ -776,6 +806,8 @@ bool Analog_Value_Write_Property(
 
             if (status) {
                 CurrentAV->Low_Limit = value.type.Real;
+                Device_local_reporting_changed(OBJECT_ANALOG_VALUE,
+                    wp_data->object_instance);
             }
             break;
 
@@ -786,6 +818,8 @@ bool Analog_Value_Write_Property(
 
             if (status) {
                 CurrentAV->Deadband = value.type.Real;
+                Device_local_reporting_changed(OBJECT_ANALOG_VALUE,
+                    wp_data->object_instance);
             }
             break;
 
@@ -797,6 +831,8 @@ bool Analog_Value_Write_Property(
             if (status) {
                 if (value.type.Bit_String.bits_used == 2) {
                     CurrentAV->Limit_Enable = value.type.Bit_String.value[0];
+                    Device_local_reporting_changed(OBJECT_ANALOG_VALUE,
+                        wp_data->object_instance);
                 } else {
                     wp_data->error_class = ERROR_CLASS_PROPERTY;
                     wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
@@ -813,6 +849,8 @@ bool Analog_Value_Write_Property(
             if (status) {
                 if (value.type.Bit_String.bits_used == 3) {
                     CurrentAV->Event_Enable = value.type.Bit_String.value[0];
+                    Device_local_reporting_changed(OBJECT_ANALOG_VALUE,
+                        wp_data->object_instance);
                 } else {
                     wp_data->error_class = ERROR_CLASS_PROPERTY;
                     wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
@@ -928,10 +966,11 @@ void Analog_Value_Intrinsic_Reporting(
                         EVENT_HIGH_LIMIT_ENABLE) &&
                     ((CurrentAV->Event_Enable & EVENT_ENABLE_TO_OFFNORMAL) ==
                         EVENT_ENABLE_TO_OFFNORMAL)) {
-                    if (!CurrentAV->Remaining_Time_Delay)
+                    if (Device_local_reporting_time_delay(OBJECT_ANALOG_VALUE,
+                            object_instance, CurrentAV->Time_Delay,
+                            &CurrentAV->Remaining_Time_Delay,
+                            &CurrentAV->Time_Delay_Counted))
                         CurrentAV->Event_State = EVENT_STATE_HIGH_LIMIT;
-                    else
-                        CurrentAV->Remaining_Time_Delay--;
                     break;
                 }
 
@@ -945,14 +984,16 @@ void Analog_Value_Intrinsic_Reporting(
                         EVENT_LOW_LIMIT_ENABLE) &&
                     ((CurrentAV->Event_Enable & EVENT_ENABLE_TO_OFFNORMAL) ==
                         EVENT_ENABLE_TO_OFFNORMAL)) {
-                    if (!CurrentAV->Remaining_Time_Delay)
+                    if (Device_local_reporting_time_delay(OBJECT_ANALOG_VALUE,
+                            object_instance, CurrentAV->Time_Delay,
+                            &CurrentAV->Remaining_Time_Delay,
+                            &CurrentAV->Time_Delay_Counted))
                         CurrentAV->Event_State = EVENT_STATE_LOW_LIMIT;
-                    else
-                        CurrentAV->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAV->Remaining_Time_Delay = CurrentAV->Time_Delay;
+                CurrentAV->Time_Delay_Counted = 0;
                 break;
 
             case EVENT_STATE_HIGH_LIMIT:
@@ -967,14 +1008,16 @@ void Analog_Value_Intrinsic_Reporting(
                         EVENT_HIGH_LIMIT_ENABLE) &&
                     ((CurrentAV->Event_Enable & EVENT_ENABLE_TO_NORMAL) ==
                         EVENT_ENABLE_TO_NORMAL)) {
-                    if (!CurrentAV->Remaining_Time_Delay)
+                    if (Device_local_reporting_time_delay(OBJECT_ANALOG_VALUE,
+                            object_instance, CurrentAV->Time_Delay,
+                            &CurrentAV->Remaining_Time_Delay,
+                            &CurrentAV->Time_Delay_Counted))
                         CurrentAV->Event_State = EVENT_STATE_NORMAL;
-                    else
-                        CurrentAV->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAV->Remaining_Time_Delay = CurrentAV->Time_Delay;
+                CurrentAV->Time_Delay_Counted = 0;
                 break;
 
             case EVENT_STATE_LOW_LIMIT:
@@ -990,14 +1033,16 @@ void Analog_Value_Intrinsic_Reporting(
                         EVENT_LOW_LIMIT_ENABLE) &&
                     ((CurrentAV->Event_Enable & EVENT_ENABLE_TO_NORMAL) ==
                         EVENT_ENABLE_TO_NORMAL)) {
-                    if (!CurrentAV->Remaining_Time_Delay)
+                    if (Device_local_reporting_time_delay(OBJECT_ANALOG_VALUE,
+                            object_instance, CurrentAV->Time_Delay,
+                            &CurrentAV->Remaining_Time_Delay,
+                            &CurrentAV->Time_Delay_Counted))
                         CurrentAV->Event_State = EVENT_STATE_NORMAL;
-                    else
-                        CurrentAV->Remaining_Time_Delay--;
                     break;
                 }
                 /* value of the object is still in the same event state */
                 CurrentAV->Remaining_Time_Delay = CurrentAV->Time_Delay;
+                CurrentAV->Time_Delay_Counted = 0;
                 break;
 
             default:
@@ -1338,6 +1383,8 @@ int Analog_Value_Alarm_Ack(
     /* Need to send AckNotification. */
     CurrentAV->Ack_notify_data.bSendAckNotify = true;
     CurrentAV->Ack_notify_data.EventState = alarmack_data->eventStateAcked;
+    Device_local_reporting_changed(OBJECT_ANALOG_VALUE,
+        alarmack_data->eventObjectIdentifier.instance);
 
     /* Return OK */
     return 1;
@@ -1389,6 +1436,14 @@ int Analog_Value_Alarm_Summary(
 #include <string.h>
 #include "ctest.h"
 
+void handler_cov_object_changed(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    object_type = object_type;
+    object_instance = object_instance;
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
@@ -64,6 +64,8 @@ extern "C" {
         BACNET_DATE_TIME Event_Time_Stamps[MAX_BACNET_EVENT_TRANSITION];
         /* time to generate event notification */
         uint32_t Remaining_Time_Delay;
+        /* tick that Remaining_Time_Delay was counted to, or zero */
+        uint32_t Time_Delay_Counted;
         /* AckNotification informations */
         ACK_NOTIFICATION Ack_notify_data;
 #endif
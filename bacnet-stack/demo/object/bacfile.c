@@ -478,6 +478,17 @@ bool bacfile_read_stream_data(
 
 bool bacfile_write_stream_data(
     BACNET_ATOMIC_WRITE_FILE_DATA * data)
+{
+    BACNET_OCTET_STRING_VIEW file_data;
+
+    octetstring_view_from(&file_data, &data->fileData[0]);
+
+    return bacfile_write_stream_data_view(data, &file_data);
+}
+
+bool bacfile_write_stream_data_view(
+    BACNET_ATOMIC_WRITE_FILE_DATA * data,
+    const BACNET_OCTET_STRING_VIEW * file_data)
 {
     char *pFilename = NULL;
     bool found = false;
@@ -503,8 +514,8 @@ bool bacfile_write_stream_data(
                 (void) fseek(pFile, data->type.stream.fileStartPosition,
                     SEEK_SET);
             }
-            if (fwrite(octetstring_value(&data->fileData[0]),
-                    octetstring_length(&data->fileData[0]), 1, pFile) != 1) {
+            if (fwrite(file_data[0].value, file_data[0].length, 1,
+                    pFile) != 1) {
                 /* do something if it fails? */
             }
             fclose(pFile);
@@ -516,6 +527,24 @@ bool bacfile_write_stream_data(
 
 bool bacfile_write_record_data(
     BACNET_ATOMIC_WRITE_FILE_DATA * data)
+{
+    BACNET_OCTET_STRING_VIEW file_data[BACNET_WRITE_FILE_RECORD_COUNT];
+    uint32_t i = 0;
+
+    if (data->type.record.returnedRecordCount >
+        BACNET_WRITE_FILE_RECORD_COUNT) {
+        return false;
+    }
+    for (i = 0; i < data->type.record.returnedRecordCount; i++) {
+        octetstring_view_from(&file_data[i], &data->fileData[i]);
+    }
+
+    return bacfile_write_record_data_view(data, file_data);
+}
+
+bool bacfile_write_record_data_view(
+    BACNET_ATOMIC_WRITE_FILE_DATA * data,
+    const BACNET_OCTET_STRING_VIEW * file_data)
 {
     char *pFilename = NULL;
     bool found = false;
@@ -550,8 +579,7 @@ bool bacfile_write_record_data(
                 }
             }
             for (i = 0; i < data->type.record.returnedRecordCount; i++) {
-                if (fwrite(octetstring_value(&data->fileData[i]),
-                        octetstring_length(&data->fileData[i]), 1,
+                if (fwrite(file_data[i].value, file_data[i].length, 1,
                         pFile) != 1) {
                     /* do something if it fails? */
                 }
@@ -566,6 +594,18 @@ bool bacfile_write_record_data(
 bool bacfile_read_ack_stream_data(
     uint32_t instance,
     BACNET_ATOMIC_READ_FILE_DATA * data)
+{
+    BACNET_OCTET_STRING_VIEW file_data;
+
+    octetstring_view_from(&file_data, &data->fileData[0]);
+
+    return bacfile_read_ack_stream_data_view(instance, data, &file_data);
+}
+
+bool bacfile_read_ack_stream_data_view(
+    uint32_t instance,
+    BACNET_ATOMIC_READ_FILE_DATA * data,
+    const BACNET_OCTET_STRING_VIEW * file_data)
 {
     bool found = false;
     FILE *pFile = NULL;
@@ -574,11 +614,15 @@ bool bacfile_read_ack_stream_data(
     pFilename = bacfile_name(instance);
     if (pFilename) {
         found = true;
-        pFile = fopen(pFilename, "rb");
+        /* open for update, or create it */
+        pFile = fopen(pFilename, "rb+");
+        if (!pFile) {
+            pFile = fopen(pFilename, "wb");
+        }
         if (pFile) {
             (void) fseek(pFile, data->type.stream.fileStartPosition, SEEK_SET);
-            if (fwrite(octetstring_value(&data->fileData[0]),
-                    octetstring_length(&data->fileData[0]), 1, pFile) != 1) {
+            if (fwrite(file_data[0].value, file_data[0].length, 1,
+                    pFile) != 1) {
 #if PRINT_ENABLED
                 fprintf(stderr, "Failed to write to %s (%lu)!\n", pFilename,
                     (unsigned long) instance);
@@ -594,6 +638,24 @@ bool bacfile_read_ack_stream_data(
 bool bacfile_read_ack_record_data(
     uint32_t instance,
     BACNET_ATOMIC_READ_FILE_DATA * data)
+{
+    BACNET_OCTET_STRING_VIEW file_data[BACNET_READ_FILE_RECORD_COUNT];
+    uint32_t i = 0;
+
+    if (data->type.record.RecordCount > BACNET_READ_FILE_RECORD_COUNT) {
+        return false;
+    }
+    for (i = 0; i < data->type.record.RecordCount; i++) {
+        octetstring_view_from(&file_data[i], &data->fileData[i]);
+    }
+
+    return bacfile_read_ack_record_data_view(instance, data, file_data);
+}
+
+bool bacfile_read_ack_record_data_view(
+    uint32_t instance,
+    BACNET_ATOMIC_READ_FILE_DATA * data,
+    const BACNET_OCTET_STRING_VIEW * file_data)
 {
     bool found = false;
     FILE *pFile = NULL;
@@ -605,7 +667,11 @@ bool bacfile_read_ack_record_data(
     pFilename = bacfile_name(instance);
     if (pFilename) {
         found = true;
-        pFile = fopen(pFilename, "rb");
+        /* open for update, or create it */
+        pFile = fopen(pFilename, "rb+");
+        if (!pFile) {
+            pFile = fopen(pFilename, "wb");
+        }
         if (pFile) {
             if (data->type.record.fileStartRecord > 0) {
                 for (i = 0; i < (uint32_t)data->type.record.fileStartRecord; i++) {
@@ -616,8 +682,7 @@ bool bacfile_read_ack_record_data(
                 }
             }
             for (i = 0; i < data->type.record.RecordCount; i++) {
-                if (fwrite(octetstring_value(&data->fileData[i]),
-                        octetstring_length(&data->fileData[i]), 1,
+                if (fwrite(file_data[i].value, file_data[i].length, 1,
                         pFile) != 1) {
 #if PRINT_ENABLED
                     fprintf(stderr, "Failed to write to %s (%lu)!\n",
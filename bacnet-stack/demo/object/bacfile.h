@@ -88,6 +88,21 @@ extern "C" {
         BACNET_ATOMIC_READ_FILE_DATA * data);
     bool bacfile_write_record_data(
         BACNET_ATOMIC_WRITE_FILE_DATA * data);
+    /* as above, with the file data as views of the received APDU */
+    bool bacfile_read_ack_stream_data_view(
+        uint32_t instance,
+        BACNET_ATOMIC_READ_FILE_DATA * data,
+        const BACNET_OCTET_STRING_VIEW * file_data);
+    bool bacfile_write_stream_data_view(
+        BACNET_ATOMIC_WRITE_FILE_DATA * data,
+        const BACNET_OCTET_STRING_VIEW * file_data);
+    bool bacfile_read_ack_record_data_view(
+        uint32_t instance,
+        BACNET_ATOMIC_READ_FILE_DATA * data,
+        const BACNET_OCTET_STRING_VIEW * file_data);
+    bool bacfile_write_record_data_view(
+        BACNET_ATOMIC_WRITE_FILE_DATA * data,
+        const BACNET_OCTET_STRING_VIEW * file_data);
 
     void bacfile_init(
         void);
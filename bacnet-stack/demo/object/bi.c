@@ -288,6 +288,7 @@ bool Binary_Input_Present_Value_Set(
         }
         if (Present_Value[index] != value) {
             Change_Of_Value[index] = true;
+            handler_cov_object_changed(OBJECT_BINARY_INPUT, object_instance);
         }
         Present_Value[index] = value;
         status = true;
@@ -306,6 +307,7 @@ void Binary_Input_Out_Of_Service_Set(
     if (index < MAX_BINARY_INPUTS) {
         if (Out_Of_Service[index] != value) {
             Change_Of_Value[index] = true;
+            handler_cov_object_changed(OBJECT_BINARY_INPUT, object_instance);
         }
         Out_Of_Service[index] = value;
     }
@@ -527,6 +529,14 @@ bool Binary_Input_Write_Property(
 #include <string.h>
 #include "ctest.h"
 
+void handler_cov_object_changed(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    object_type = object_type;
+    object_instance = object_instance;
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
@@ -35,6 +35,7 @@
 #include "config.h"     /* the custom stuff */
 #include "rp.h"
 #include "wp.h"
+#include "device.h"
 #include "csv.h"
 #include "handlers.h"
 
@@ -266,6 +267,7 @@ bool CharacterString_Value_Name_Set(
     unsigned index = 0; /* offset from instance lookup */
     size_t i = 0;       /* loop counter */
     bool status = false;        /* return value */
+    bool changed = false;
 
     index = CharacterString_Value_Instance_To_Index(object_instance);
     if (index < MAX_CHARACTERSTRING_VALUES) {
@@ -273,6 +275,9 @@ bool CharacterString_Value_Name_Set(
         /* FIXME: check to see if there is a matching name */
         if (new_name) {
             for (i = 0; i < sizeof(Object_Name[index]); i++) {
+                if (Object_Name[index][i] != new_name[i]) {
+                    changed = true;
+                }
                 Object_Name[index][i] = new_name[i];
                 if (new_name[i] == 0) {
                     break;
@@ -280,9 +285,16 @@ bool CharacterString_Value_Name_Set(
             }
         } else {
             for (i = 0; i < sizeof(Object_Name[index]); i++) {
+                if (Object_Name[index][i] != 0) {
+                    changed = true;
+                }
                 Object_Name[index][i] = 0;
             }
         }
+        if (changed) {
+            Device_Object_Name_Changed(OBJECT_CHARACTERSTRING_VALUE,
+                object_instance);
+        }
     }
 
     return status;
@@ -447,6 +459,12 @@ bool CharacterString_Value_Write_Property(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Changed(
+    int object_type,
+    uint32_t object_instance)
+{
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
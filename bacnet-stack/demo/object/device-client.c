@@ -571,7 +571,29 @@ bool Device_Object_List_Identifier(
  * @return True on success or else False if not found.
  */
 bool Device_Valid_Object_Name(
-    BACNET_CHARACTER_STRING * object_name1,
+    BACNET_CHARACTER_STRING * object_name,
+    int *object_type,
+    uint32_t * object_instance)
+{
+    BACNET_CHARACTER_STRING_VIEW object_name_view;
+
+    characterstring_view_from(&object_name_view, object_name);
+
+    return Device_Valid_Object_Name_View(&object_name_view, object_type,
+        object_instance);
+}
+
+/** Determine if we have an object with the given object_name,
+ * where the name is a view such as one decoded from the received APDU.
+ * If the object_type and object_instance pointers are not null,
+ * and the lookup succeeds, they will be given the resulting values.
+ * @param object_name1 [in] The desired Object Name to look for.
+ * @param object_type [out] The BACNET_OBJECT_TYPE of the matching Object.
+ * @param object_instance [out] The object instance number of the matching Object.
+ * @return True on success or else False if not found.
+ */
+bool Device_Valid_Object_Name_View(
+    const BACNET_CHARACTER_STRING_VIEW * object_name1,
     int *object_type,
     uint32_t * object_instance)
 {
@@ -590,7 +612,8 @@ bool Device_Valid_Object_Name(
             pObject = Device_Objects_Find_Functions(type);
             if ((pObject != NULL) && (pObject->Object_Name != NULL) &&
                 (pObject->Object_Name(instance, &object_name2) &&
-                    characterstring_same(object_name1, &object_name2))) {
+                    characterstring_view_same(object_name1,
+                        &object_name2))) {
                 found = true;
                 if (object_type) {
                     *object_type = type;
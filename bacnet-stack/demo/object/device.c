@@ -44,6 +44,7 @@
 #include "handlers.h"
 #include "datalink.h"
 #include "address.h"
+#include "hashindex.h"
 /* os specfic includes */
 #include "timer.h"
 /* include the device object */
@@ -113,6 +114,8 @@ static object_functions_t My_Object_Table[] = {
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
         NULL /* Intrinsic Reporting */ },
+#if !defined(TEST_DEVICE)
+    /* the unit test has its own objects, so links without these */
     {OBJECT_ANALOG_INPUT,
             Analog_Input_Init,
             Analog_Input_Count,
@@ -449,6 +452,7 @@ static object_functions_t My_Object_Table[] = {
             NULL /* COV */ ,
             NULL /* COV Clear */ ,
         NULL /* Intrinsic Reporting */ },
+#endif
     {MAX_BACNET_OBJECT_TYPE,
             NULL /* Init */ ,
             NULL /* Count */ ,
@@ -466,6 +470,57 @@ static object_functions_t My_Object_Table[] = {
         NULL /* Intrinsic Reporting */ }
 };
 
+/* The entry of each object type in the Object_Table, plus one,
+   or zero for an object type that is not supported */
+static uint16_t Object_Type_Index[MAX_BACNET_OBJECT_TYPE];
+
+/* The Object_List directory holds the object identifier of each object
+   in the order of the Object_List, so that any element is found at once,
+   and a hash index of the identifiers (see hashindex.c).  The objects
+   are still kept by their own modules; the directory is rebuilt from
+   them when the number of objects or the Database_Revision changes, as
+   it must when an object is created, deleted or renumbered.  A device
+   with more than MAX_DEVICE_OBJECTS objects walks the modules instead. */
+#if (MAX_DEVICE_OBJECTS < 65535)
+typedef uint16_t DEVICE_OBJECT_INDEX;
+#else
+typedef uint32_t DEVICE_OBJECT_INDEX;
+#endif
+#define DEVICE_OBJECT_HASH_SIZE HASH_INDEX_SIZE(MAX_DEVICE_OBJECTS)
+static uint32_t Device_Object_Directory[MAX_DEVICE_OBJECTS];
+static DEVICE_OBJECT_INDEX Device_Object_Hash[DEVICE_OBJECT_HASH_SIZE];
+static unsigned Device_Object_Directory_Count;
+static uint32_t Device_Object_Directory_Revision;
+static bool Device_Object_Directory_Valid;
+/* The object names are indexed the same way, by a hash of the character
+   set and octets of each name, kept for each entry of the directory.
+   The index is rebuilt along with the directory, and a name that is
+   written is moved in place by Device_Object_Name_Changed.  An object
+   whose name could not be read is not in the index. */
+static uint32_t Device_Object_Name_Key[MAX_DEVICE_OBJECTS];
+static DEVICE_OBJECT_INDEX Device_Object_Name_Hash[DEVICE_OBJECT_HASH_SIZE];
+static bool Device_Object_Name_Index_Valid;
+
+/* Index the Object_Table by object type */
+static void Device_Objects_Type_Index_Init(
+    void)
+{
+    struct object_functions *pObject = NULL;
+    unsigned index = 0;
+
+    memset(Object_Type_Index, 0, sizeof(Object_Type_Index));
+    pObject = Object_Table;
+    while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
+        /* the first entry of a type is the one that is used */
+        if (Object_Type_Index[pObject->Object_Type] == 0) {
+            Object_Type_Index[pObject->Object_Type] = (uint16_t) (index + 1);
+        }
+        pObject++;
+        index++;
+    }
+    Device_Object_Directory_Valid = false;
+}
+
 /** Glue function to let the Device object, when called by a handler,
  * lookup which Object type needs to be invoked.
  * @ingroup ObjHelpers
@@ -476,15 +531,9 @@ static object_functions_t My_Object_Table[] = {
 static struct object_functions *Device_Objects_Find_Functions(
     BACNET_OBJECT_TYPE Object_Type)
 {
-    struct object_functions *pObject = NULL;
-
-    pObject = Object_Table;
-    while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
-        /* handle each object type */
-        if (pObject->Object_Type == Object_Type) {
-            return (pObject);
-        }
-        pObject++;
+    if (((unsigned) Object_Type < MAX_BACNET_OBJECT_TYPE) &&
+        (Object_Type_Index[Object_Type] != 0)) {
+        return &Object_Table[Object_Type_Index[Object_Type] - 1];
     }
 
     return (NULL);
@@ -646,6 +695,10 @@ static const int Device_Properties_Optional[] = {
     PROP_DAYLIGHT_SAVINGS_STATUS,
     PROP_LOCATION,
     PROP_ACTIVE_COV_SUBSCRIPTIONS,
+#if BACNET_SEGMENTATION_ENABLED
+    PROP_MAX_SEGMENTS_ACCEPTED,
+    PROP_APDU_SEGMENT_TIMEOUT,
+#endif
 #if defined(BACNET_TIME_MASTER)
     PROP_TIME_SYNCHRONIZATION_RECIPIENTS,
     PROP_TIME_SYNCHRONIZATION_INTERVAL,
@@ -799,7 +852,8 @@ bool Device_Set_Object_Name(
     if (!characterstring_same(&My_Object_Name, object_name)) {
         /* Make the change and update the database revision */
         status = characterstring_copy(&My_Object_Name, object_name);
-        Device_Inc_Database_Revision();
+        Device_Object_Name_Changed(OBJECT_DEVICE,
+            Device_Object_Instance_Number());
     }
 
     return status;
@@ -1008,7 +1062,11 @@ uint8_t Device_Protocol_Revision(
 BACNET_SEGMENTATION Device_Segmentation_Supported(
     void)
 {
+#if BACNET_SEGMENTATION_ENABLED
+    return SEGMENTATION_BOTH;
+#else
     return SEGMENTATION_NONE;
+#endif
 }
 
 uint32_t Device_Database_Revision(
@@ -1057,17 +1115,165 @@ unsigned Device_Object_List_Count(
     return count;
 }
 
-/** Lookup the Object at the given array index in the Device's Object List.
- * Even though we don't keep a single linear array of objects in the Device,
- * this method acts as though we do and works through a virtual, concatenated
- * array of all of our object type arrays.
- *
- * @param array_index [in] The desired array index (1 to N)
- * @param object_type [out] The object's type, if found.
- * @param instance [out] The object's instance number, if found.
- * @return True if found, else false.
- */
-bool Device_Object_List_Identifier(
+static uint32_t Device_Object_Hash_Home(
+    uint32_t index)
+{
+    return hash_index_mix(Device_Object_Directory[index]);
+}
+
+static HASH_INDEX Device_Object_Index = {
+    Device_Object_Hash, sizeof(DEVICE_OBJECT_INDEX), DEVICE_OBJECT_HASH_SIZE,
+    Device_Object_Hash_Home
+};
+
+static uint32_t Device_Object_Name_Hash_Home(
+    uint32_t index)
+{
+    return Device_Object_Name_Key[index];
+}
+
+static HASH_INDEX Device_Object_Name_Index = {
+    Device_Object_Name_Hash, sizeof(DEVICE_OBJECT_INDEX),
+    DEVICE_OBJECT_HASH_SIZE, Device_Object_Name_Hash_Home
+};
+
+/* Bring the Object_List directory up to date with the object modules.
+   Returns false if the objects do not fit, or cannot be listed. */
+static bool Device_Object_Directory_Update(
+    void)
+{
+    struct object_functions *pObject = NULL;
+    unsigned count, type_count, object_index, i, slot;
+    unsigned n = 0;
+    uint32_t object_id, value;
+
+    count = Device_Object_List_Count();
+    if (Device_Object_Directory_Valid &&
+        (count == Device_Object_Directory_Count) &&
+        (Database_Revision == Device_Object_Directory_Revision)) {
+        return true;
+    }
+    Device_Object_Directory_Valid = false;
+    Device_Object_Name_Index_Valid = false;
+#ifdef BAC_ROUTING
+    /* the Device object in the list is the routed device that is
+       addressed, so the modules are walked instead */
+    return false;
+#endif
+    if (count > MAX_DEVICE_OBJECTS) {
+        return false;
+    }
+    hash_index_clear(&Device_Object_Index);
+    pObject = Object_Table;
+    while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
+        type_count = 0;
+        if (pObject->Object_Count) {
+            type_count = pObject->Object_Count();
+        }
+        if (type_count && !pObject->Object_Index_To_Instance) {
+            return false;
+        }
+        /* the same order as the Object_List has always had */
+        object_index = 0;
+        if (pObject->Object_Iterator) {
+            object_index = pObject->Object_Iterator(~(unsigned) 0);
+        }
+        for (i = 0; i < type_count; i++) {
+            if (n >= count) {
+                return false;
+            }
+            object_id =
+                BACNET_ID_VALUE(pObject->Object_Index_To_Instance
+                (object_index), (uint32_t) pObject->Object_Type);
+            Device_Object_Directory[n] = object_id;
+            slot =
+                hash_index_start(&Device_Object_Index,
+                hash_index_mix(object_id));
+            while ((value =
+                    hash_index_get(&Device_Object_Index, slot)) != 0) {
+                if (Device_Object_Directory[value - 1] == object_id) {
+                    /* a duplicate is found at its first index */
+                    break;
+                }
+                slot = hash_index_next(&Device_Object_Index, slot);
+            }
+            if (value == 0) {
+                hash_index_set(&Device_Object_Index, slot, n);
+            }
+            n++;
+            if (pObject->Object_Iterator) {
+                object_index = pObject->Object_Iterator(object_index);
+            } else {
+                object_index++;
+            }
+        }
+        pObject++;
+    }
+    if (n != count) {
+        return false;
+    }
+    Device_Object_Directory_Count = n;
+    Device_Object_Directory_Revision = Database_Revision;
+    Device_Object_Directory_Valid = true;
+
+    return true;
+}
+
+/* FNV-1a hash of the character set and the octets of a name */
+static uint32_t Device_Object_Name_Key_Value(
+    const BACNET_CHARACTER_STRING_VIEW * object_name)
+{
+    uint32_t key = 2166136261UL;
+    uint32_t i;
+
+    key = (key ^ object_name->encoding) * 16777619UL;
+    for (i = 0; i < object_name->length; i++) {
+        key = (key ^ (uint8_t) object_name->value[i]) * 16777619UL;
+    }
+
+    return key;
+}
+
+/* Bring the name index up to date with the Object_List directory.
+   Returns false if there is no directory to index. */
+static bool Device_Object_Name_Index_Update(
+    void)
+{
+    struct object_functions *pObject = NULL;
+    BACNET_CHARACTER_STRING object_name;
+    BACNET_CHARACTER_STRING_VIEW object_name_view;
+    uint32_t object_id;
+    unsigned i;
+
+    if (!Device_Object_Directory_Update()) {
+        return false;
+    }
+    if (Device_Object_Name_Index_Valid) {
+        return true;
+    }
+    hash_index_clear(&Device_Object_Name_Index);
+    for (i = 0; i < Device_Object_Directory_Count; i++) {
+        object_id = Device_Object_Directory[i];
+        pObject = Device_Objects_Find_Functions((BACNET_OBJECT_TYPE)
+            BACNET_TYPE(object_id));
+        if ((pObject == NULL) || (pObject->Object_Name == NULL) ||
+            !pObject->Object_Name(BACNET_INSTANCE(object_id),
+                &object_name)) {
+            continue;
+        }
+        characterstring_view_from(&object_name_view, &object_name);
+        Device_Object_Name_Key[i] =
+            Device_Object_Name_Key_Value(&object_name_view);
+        hash_index_insert(&Device_Object_Name_Index, i);
+    }
+    Device_Object_Name_Index_Valid = true;
+
+    return true;
+}
+
+/* Lookup the Object at the given array index by walking the modules,
+   for a device whose objects do not fit the directory. */
+static bool Device_Object_List_Walk(
     uint32_t array_index,
     int *object_type,
     uint32_t * instance)
@@ -1118,6 +1324,82 @@ bool Device_Object_List_Identifier(
     return status;
 }
 
+/** Lookup the Object at the given array index in the Device's Object List.
+ * Even though we don't keep a single linear array of objects in the Device,
+ * this method acts as though we do and works through a virtual, concatenated
+ * array of all of our object type arrays.
+ *
+ * @param array_index [in] The desired array index (1 to N)
+ * @param object_type [out] The object's type, if found.
+ * @param instance [out] The object's instance number, if found.
+ * @return True if found, else false.
+ */
+bool Device_Object_List_Identifier(
+    uint32_t array_index,
+    int *object_type,
+    uint32_t * instance)
+{
+    uint32_t object_id;
+
+    /* array index zero is length - so invalid */
+    if (array_index == 0) {
+        return false;
+    }
+    if (!Device_Object_Directory_Update()) {
+        return Device_Object_List_Walk(array_index, object_type, instance);
+    }
+    if (array_index > Device_Object_Directory_Count) {
+        return false;
+    }
+    object_id = Device_Object_Directory[array_index - 1];
+    *object_type = (int) BACNET_TYPE(object_id);
+    *instance = BACNET_INSTANCE(object_id);
+
+    return true;
+}
+
+/** Find the position of an Object in the Device's Object List.
+ *
+ * @param object_type [in] The object's type.
+ * @param instance [in] The object's instance number.
+ * @return The array index (1 to N) of the object, or 0 if not found.
+ */
+uint32_t Device_Object_List_Index(
+    int object_type,
+    uint32_t instance)
+{
+    uint32_t object_id, count, i;
+    int type = 0;
+    uint32_t object_instance = 0;
+    uint32_t value;
+    unsigned slot;
+
+    if (((unsigned) object_type >= MAX_BACNET_OBJECT_TYPE) ||
+        (instance > BACNET_MAX_INSTANCE)) {
+        return 0;
+    }
+    if (!Device_Object_Directory_Update()) {
+        count = Device_Object_List_Count();
+        for (i = 1; i <= count; i++) {
+            if (Device_Object_List_Walk(i, &type, &object_instance) &&
+                (type == object_type) && (object_instance == instance)) {
+                return i;
+            }
+        }
+        return 0;
+    }
+    object_id = BACNET_ID_VALUE(instance, (uint32_t) object_type);
+    slot = hash_index_start(&Device_Object_Index, hash_index_mix(object_id));
+    while ((value = hash_index_get(&Device_Object_Index, slot)) != 0) {
+        if (Device_Object_Directory[value - 1] == object_id) {
+            return value;
+        }
+        slot = hash_index_next(&Device_Object_Index, slot);
+    }
+
+    return 0;
+}
+
 /** Determine if we have an object with the given object_name.
  * If the object_type and object_instance pointers are not null,
  * and the lookup succeeds, they will be given the resulting values.
@@ -1127,7 +1409,29 @@ bool Device_Object_List_Identifier(
  * @return True on success or else False if not found.
  */
 bool Device_Valid_Object_Name(
-    BACNET_CHARACTER_STRING * object_name1,
+    BACNET_CHARACTER_STRING * object_name,
+    int *object_type,
+    uint32_t * object_instance)
+{
+    BACNET_CHARACTER_STRING_VIEW object_name_view;
+
+    characterstring_view_from(&object_name_view, object_name);
+
+    return Device_Valid_Object_Name_View(&object_name_view, object_type,
+        object_instance);
+}
+
+/** Determine if we have an object with the given object_name,
+ * where the name is a view such as one decoded from the received APDU.
+ * If the object_type and object_instance pointers are not null,
+ * and the lookup succeeds, they will be given the resulting values.
+ * @param object_name1 [in] The desired Object Name to look for.
+ * @param object_type [out] The BACNET_OBJECT_TYPE of the matching Object.
+ * @param object_instance [out] The object instance number of the matching Object.
+ * @return True on success or else False if not found.
+ */
+bool Device_Valid_Object_Name_View(
+    const BACNET_CHARACTER_STRING_VIEW * object_name1,
     int *object_type,
     uint32_t * object_instance)
 {
@@ -1135,10 +1439,48 @@ bool Device_Valid_Object_Name(
     int type = 0;
     uint32_t instance;
     uint32_t max_objects = 0, i = 0;
+    uint32_t object_id, key, first, value;
+    unsigned slot;
     bool check_id = false;
     BACNET_CHARACTER_STRING object_name2;
     struct object_functions *pObject = NULL;
 
+    if (Device_Object_Name_Index_Update()) {
+        key = Device_Object_Name_Key_Value(object_name1);
+        slot = hash_index_start(&Device_Object_Name_Index, key);
+        /* of objects with the same name, the first in the Object_List
+           is found, as it always has been */
+        first = MAX_DEVICE_OBJECTS;
+        while ((value =
+                hash_index_get(&Device_Object_Name_Index, slot)) != 0) {
+            i = value - 1;
+            if ((i < first) && (Device_Object_Name_Key[i] == key)) {
+                object_id = Device_Object_Directory[i];
+                pObject = Device_Objects_Find_Functions((BACNET_OBJECT_TYPE)
+                    BACNET_TYPE(object_id));
+                if ((pObject != NULL) && (pObject->Object_Name != NULL) &&
+                    (pObject->Object_Name(BACNET_INSTANCE(object_id),
+                            &object_name2) &&
+                        characterstring_view_same(object_name1,
+                            &object_name2))) {
+                    first = i;
+                }
+            }
+            slot = hash_index_next(&Device_Object_Name_Index, slot);
+        }
+        if (first < MAX_DEVICE_OBJECTS) {
+            found = true;
+            object_id = Device_Object_Directory[first];
+            if (object_type) {
+                *object_type = (int) BACNET_TYPE(object_id);
+            }
+            if (object_instance) {
+                *object_instance = BACNET_INSTANCE(object_id);
+            }
+        }
+
+        return found;
+    }
     max_objects = Device_Object_List_Count();
     for (i = 1; i <= max_objects; i++) {
         check_id = Device_Object_List_Identifier(i, &type, &instance);
@@ -1146,7 +1488,8 @@ bool Device_Valid_Object_Name(
             pObject = Device_Objects_Find_Functions(type);
             if ((pObject != NULL) && (pObject->Object_Name != NULL) &&
                 (pObject->Object_Name(instance, &object_name2) &&
-                    characterstring_same(object_name1, &object_name2))) {
+                    characterstring_view_same(object_name1,
+                        &object_name2))) {
                 found = true;
                 if (object_type) {
                     *object_type = type;
@@ -1162,6 +1505,48 @@ bool Device_Valid_Object_Name(
     return found;
 }
 
+/** Keep the index of object names up to date with a name that was
+ * written, and increment the Database_Revision, as a new name must.
+ * The object modules call this instead of Device_Inc_Database_Revision
+ * when an Object_Name is changed.
+ * @param object_type [in] The BACNET_OBJECT_TYPE of the renamed Object.
+ * @param object_instance [in] The object instance number of the Object.
+ */
+void Device_Object_Name_Changed(
+    int object_type,
+    uint32_t object_instance)
+{
+    struct object_functions *pObject = NULL;
+    BACNET_CHARACTER_STRING object_name;
+    BACNET_CHARACTER_STRING_VIEW object_name_view;
+    uint32_t index;
+
+    /* an index that is not up to date is rebuilt when it is needed */
+    if (!Device_Object_Name_Index_Valid || !Device_Object_Directory_Update()
+        || !Device_Object_Name_Index_Valid) {
+        Database_Revision++;
+        return;
+    }
+    index = Device_Object_List_Index(object_type, object_instance);
+    if (index) {
+        index--;
+        /* a name that was not indexed is not found */
+        hash_index_remove(&Device_Object_Name_Index, index);
+        pObject = Device_Objects_Find_Functions((BACNET_OBJECT_TYPE)
+            object_type);
+        if ((pObject != NULL) && (pObject->Object_Name != NULL) &&
+            pObject->Object_Name(object_instance, &object_name)) {
+            characterstring_view_from(&object_name_view, &object_name);
+            Device_Object_Name_Key[index] =
+                Device_Object_Name_Key_Value(&object_name_view);
+            hash_index_insert(&Device_Object_Name_Index, index);
+        }
+    }
+    Database_Revision++;
+    /* the directory and the index stay valid for the new revision */
+    Device_Object_Directory_Revision = Database_Revision;
+}
+
 /** Determine if we have an object of this type and instance number.
  * @param object_type [in] The desired BACNET_OBJECT_TYPE
  * @param object_instance [in] The object instance number to be looked up.
@@ -1376,7 +1761,7 @@ int Device_Read_Property_Local(
     uint8_t *apdu = NULL;
     struct object_functions *pObject = NULL;
     bool found = false;
-    uint16_t apdu_max = 0;
+    int apdu_max = 0;
 
     if ((rpdata == NULL) || (rpdata->application_data == NULL) ||
         (rpdata->application_data_len == 0)) {
@@ -1553,6 +1938,17 @@ int Device_Read_Property_Local(
         case PROP_APDU_TIMEOUT:
             apdu_len = encode_application_unsigned(&apdu[0], apdu_timeout());
             break;
+#if BACNET_SEGMENTATION_ENABLED
+        case PROP_MAX_SEGMENTS_ACCEPTED:
+            apdu_len =
+                encode_application_unsigned(&apdu[0], MAX_SEGMENTS_ACCEPTED);
+            break;
+        case PROP_APDU_SEGMENT_TIMEOUT:
+            apdu_len =
+                encode_application_unsigned(&apdu[0],
+                apdu_segment_timeout());
+            break;
+#endif
         case PROP_NUMBER_OF_APDU_RETRIES:
             apdu_len = encode_application_unsigned(&apdu[0], apdu_retries());
             break;
@@ -2073,30 +2469,349 @@ void Device_COV_Clear(
 }
 
 #if defined(INTRINSIC_REPORTING)
-void Device_local_reporting(
+/* The intrinsic reporting of the objects is driven by their changes:
+   - objects report a change of a property that their event algorithm
+     uses with Device_local_reporting_changed(), which makes the object
+     due at the next tick of Device_local_reporting(),
+   - an object that counts down its Time_Delay is due again when the
+     delay ends, see Device_local_reporting_time_delay(),
+   - the due objects have a timer in a packed table, with a heap of
+     the timers ordered by their due tick, and a hash index of the
+     object identifiers (see hashindex.c), so that an object has only
+     one timer.
+   So each tick only evaluates the objects that are due.  Every object
+   is evaluated when the objects of the device change, and when more
+   than MAX_REPORTING_PENDING objects are due at once. */
+#if (MAX_REPORTING_PENDING < 65535)
+typedef uint16_t DEVICE_REPORTING_INDEX;
+#else
+typedef uint32_t DEVICE_REPORTING_INDEX;
+#endif
+typedef struct device_reporting_timer {
+    uint32_t object_id;
+    /* tick of Device_local_reporting() when the object is due */
+    uint32_t due;
+    /* tick of the change, or the end of the Time_Delay, that made
+       the object due, for the latency */
+    uint32_t since;
+    /* position of the timer in the heap */
+    DEVICE_REPORTING_INDEX heap;
+} DEVICE_REPORTING_TIMER;
+
+#define DEVICE_REPORTING_HASH_SIZE HASH_INDEX_SIZE(MAX_REPORTING_PENDING)
+static DEVICE_REPORTING_TIMER Reporting_Timer[MAX_REPORTING_PENDING];
+static DEVICE_REPORTING_INDEX Reporting_Heap[MAX_REPORTING_PENDING];
+static DEVICE_REPORTING_INDEX Reporting_Hash[DEVICE_REPORTING_HASH_SIZE];
+static unsigned Reporting_Timer_Count;
+/* ticks of Device_local_reporting(), from one so that zero is "none" */
+static uint32_t Reporting_Clock = 1;
+static bool Reporting_Sweep = true;
+static unsigned Reporting_Object_Count;
+static uint32_t Reporting_Revision;
+static DEVICE_REPORTING_STATS Reporting_Stats;
+
+static uint32_t Device_Reporting_Hash_Home(
+    uint32_t index)
+{
+    return hash_index_mix(Reporting_Timer[index].object_id);
+}
+
+static HASH_INDEX Reporting_Index = {
+    Reporting_Hash, sizeof(DEVICE_REPORTING_INDEX),
+    DEVICE_REPORTING_HASH_SIZE, Device_Reporting_Hash_Home
+};
+
+/* Find the hash slot of an object, or the empty slot where it goes */
+static unsigned Device_Reporting_Hash_Slot(
+    uint32_t object_id)
+{
+    unsigned slot;
+    uint32_t value;
+
+    slot = hash_index_start(&Reporting_Index, hash_index_mix(object_id));
+    while ((value = hash_index_get(&Reporting_Index, slot)) != 0) {
+        if (Reporting_Timer[value - 1].object_id == object_id) {
+            break;
+        }
+        slot = hash_index_next(&Reporting_Index, slot);
+    }
+
+    return slot;
+}
+
+static void Device_Reporting_Heap_Up(
+    unsigned position)
+{
+    DEVICE_REPORTING_INDEX index;
+    unsigned parent;
+
+    index = Reporting_Heap[position];
+    while (position > 0) {
+        parent = (position - 1) / 2;
+        if (Reporting_Timer[Reporting_Heap[parent]].due <=
+            Reporting_Timer[index].due) {
+            break;
+        }
+        Reporting_Heap[position] = Reporting_Heap[parent];
+        Reporting_Timer[Reporting_Heap[position]].heap =
+            (DEVICE_REPORTING_INDEX) position;
+        position = parent;
+    }
+    Reporting_Heap[position] = index;
+    Reporting_Timer[index].heap = (DEVICE_REPORTING_INDEX) position;
+}
+
+static void Device_Reporting_Heap_Down(
+    unsigned position)
+{
+    DEVICE_REPORTING_INDEX index;
+    unsigned child;
+
+    index = Reporting_Heap[position];
+    for (;;) {
+        child = (position * 2) + 1;
+        if (child >= Reporting_Timer_Count) {
+            break;
+        }
+        if (((child + 1) < Reporting_Timer_Count) &&
+            (Reporting_Timer[Reporting_Heap[child + 1]].due <
+                Reporting_Timer[Reporting_Heap[child]].due)) {
+            child++;
+        }
+        if (Reporting_Timer[index].due <=
+            Reporting_Timer[Reporting_Heap[child]].due) {
+            break;
+        }
+        Reporting_Heap[position] = Reporting_Heap[child];
+        Reporting_Timer[Reporting_Heap[position]].heap =
+            (DEVICE_REPORTING_INDEX) position;
+        position = child;
+    }
+    Reporting_Heap[position] = index;
+    Reporting_Timer[index].heap = (DEVICE_REPORTING_INDEX) position;
+}
+
+/* Make an object due at the given tick, unless it is due sooner */
+static void Device_Reporting_Timer_Set(
+    uint32_t object_id,
+    uint32_t due,
+    uint32_t since)
+{
+    unsigned slot, index;
+
+    slot = Device_Reporting_Hash_Slot(object_id);
+    if (hash_index_get(&Reporting_Index, slot) != 0) {
+        index = hash_index_get(&Reporting_Index, slot) - 1;
+        if ((int32_t) (due - Reporting_Timer[index].due) < 0) {
+            Reporting_Timer[index].due = due;
+            Reporting_Timer[index].since = since;
+            Device_Reporting_Heap_Up(Reporting_Timer[index].heap);
+        }
+        return;
+    }
+    if (Reporting_Timer_Count >= MAX_REPORTING_PENDING) {
+        /* too many to keep - evaluate them all instead */
+        Reporting_Sweep = true;
+        return;
+    }
+    index = Reporting_Timer_Count;
+    Reporting_Timer_Count++;
+    Reporting_Timer[index].object_id = object_id;
+    Reporting_Timer[index].due = due;
+    Reporting_Timer[index].since = since;
+    hash_index_set(&Reporting_Index, slot, index);
+    Reporting_Heap[index] = (DEVICE_REPORTING_INDEX) index;
+    Device_Reporting_Heap_Up(index);
+    if (Reporting_Timer_Count > Reporting_Stats.pending_max) {
+        Reporting_Stats.pending_max = Reporting_Timer_Count;
+    }
+}
+
+/* Remove the timer that is due first.  The table stays packed by
+   moving its last timer into the free entry. */
+static void Device_Reporting_Timer_Pop(
+    DEVICE_REPORTING_TIMER * timer)
+{
+    unsigned index, last;
+
+    index = Reporting_Heap[0];
+    *timer = Reporting_Timer[index];
+    hash_index_remove(&Reporting_Index, index);
+    Reporting_Timer_Count--;
+    last = Reporting_Timer_Count;
+    if (last > 0) {
+        Reporting_Heap[0] = Reporting_Heap[last];
+        Device_Reporting_Heap_Down(0);
+    }
+    if (index != last) {
+        hash_index_move(&Reporting_Index, last, index);
+        Reporting_Timer[index] = Reporting_Timer[last];
+        Reporting_Heap[Reporting_Timer[index].heap] =
+            (DEVICE_REPORTING_INDEX) index;
+    }
+}
+
+/* Forget the timers, so that every object is evaluated at first */
+static void Device_Reporting_Init(
     void)
+{
+    Reporting_Timer_Count = 0;
+    hash_index_clear(&Reporting_Index);
+    Reporting_Sweep = true;
+}
+
+static void Device_Reporting_Evaluate(
+    int object_type,
+    uint32_t object_instance)
 {
     struct object_functions *pObject;
+
+    pObject = Device_Objects_Find_Functions(object_type);
+    if (pObject != NULL) {
+        if (pObject->Object_Valid_Instance &&
+            pObject->Object_Valid_Instance(object_instance)) {
+            if (pObject->Object_Intrinsic_Reporting) {
+                pObject->Object_Intrinsic_Reporting(object_instance);
+            }
+        }
+    }
+}
+
+static void Device_Reporting_Latency(
+    uint32_t since)
+{
+    uint32_t latency = 0;
+
+    if ((int32_t) (Reporting_Clock - since) > 0) {
+        latency = Reporting_Clock - since;
+    }
+    if (latency > Reporting_Stats.latency_max) {
+        Reporting_Stats.latency_max = latency;
+    }
+    Reporting_Stats.latency_total += latency;
+}
+
+/** Evaluate the intrinsic reporting of the objects that are due.
+ * Called once a second; each call is a tick of the Time_Delay.
+ */
+void Device_local_reporting(
+    void)
+{
+    DEVICE_REPORTING_TIMER timer;
     uint32_t objects_count;
     uint32_t object_instance;
     int object_type;
     uint32_t idx;
 
+    Reporting_Clock++;
+    Reporting_Stats.ticks++;
     objects_count = Device_Object_List_Count();
-
-    /* loop for all objects */
-    for (idx = 1; idx <= objects_count; idx++) {
-        Device_Object_List_Identifier(idx, &object_type, &object_instance);
-
-        pObject = Device_Objects_Find_Functions(object_type);
-        if (pObject != NULL) {
-            if (pObject->Object_Valid_Instance &&
-                pObject->Object_Valid_Instance(object_instance)) {
-                if (pObject->Object_Intrinsic_Reporting) {
-                    pObject->Object_Intrinsic_Reporting(object_instance);
-                }
+    if ((objects_count != Reporting_Object_Count) ||
+        (Database_Revision != Reporting_Revision)) {
+        /* objects were created, deleted or renamed */
+        Reporting_Sweep = true;
+    }
+    if (Reporting_Sweep) {
+        Reporting_Sweep = false;
+        Reporting_Object_Count = objects_count;
+        Reporting_Revision = Database_Revision;
+        Reporting_Stats.sweeps++;
+        /* the objects that are due are evaluated with the others */
+        while ((Reporting_Timer_Count > 0) &&
+            ((int32_t) (Reporting_Clock -
+                    Reporting_Timer[Reporting_Heap[0]].due) >= 0)) {
+            Device_Reporting_Timer_Pop(&timer);
+            Device_Reporting_Latency(timer.since);
+        }
+        for (idx = 1; idx <= objects_count; idx++) {
+            if (Device_Object_List_Identifier(idx, &object_type,
+                    &object_instance)) {
+                Device_Reporting_Evaluate(object_type, object_instance);
+                Reporting_Stats.evaluations++;
             }
         }
+        return;
+    }
+    while ((Reporting_Timer_Count > 0) &&
+        ((int32_t) (Reporting_Clock -
+                Reporting_Timer[Reporting_Heap[0]].due) >= 0)) {
+        Device_Reporting_Timer_Pop(&timer);
+        Device_Reporting_Latency(timer.since);
+        Device_Reporting_Evaluate((int) BACNET_TYPE(timer.object_id),
+            BACNET_INSTANCE(timer.object_id));
+        Reporting_Stats.evaluations++;
+    }
+}
+
+/** Handler for the objects to report that a property that their
+ * intrinsic reporting uses has changed, such as the Present_Value,
+ * the Status_Flags or a limit, or that an event was acknowledged,
+ * so that the object is evaluated at the next tick.
+ * @param object_type [in] the BACNET_OBJECT_TYPE of the object
+ * @param object_instance [in] the instance number of the object
+ */
+void Device_local_reporting_changed(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance)
+{
+    Device_Reporting_Timer_Set(BACNET_ID_VALUE(object_instance,
+            (uint32_t) object_type), Reporting_Clock + 1, Reporting_Clock);
+}
+
+/** Count down the Time_Delay of an event condition that is present,
+ * for the intrinsic reporting of an object.  The object is due again
+ * when the delay ends, so it is not evaluated every tick meanwhile.
+ * The object restarts the count by setting the remaining time delay
+ * to its Time_Delay and the count to zero, when the condition is gone.
+ * @param object_type [in] the BACNET_OBJECT_TYPE of the object
+ * @param object_instance [in] the instance number of the object
+ * @param time_delay [in] the Time_Delay of the object, in seconds
+ * @param remaining_time_delay [in,out] the seconds of the delay left
+ * @param counted [in,out] the tick that the delay was counted to
+ * @return true when the delay has ended, and the count is restarted;
+ *  the object is then evaluated again at the next tick, in its new state
+ */
+bool Device_local_reporting_time_delay(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    uint32_t time_delay,
+    uint32_t * remaining_time_delay,
+    uint32_t * counted)
+{
+    uint32_t elapsed;
+
+    if (*counted == 0) {
+        /* the condition was found now */
+        *counted = Reporting_Clock;
+    }
+    elapsed = Reporting_Clock - *counted;
+    *counted = Reporting_Clock;
+    if (elapsed >= *remaining_time_delay) {
+        *remaining_time_delay = time_delay;
+        *counted = 0;
+        /* the condition of the new event state may be present too */
+        Device_Reporting_Timer_Set(BACNET_ID_VALUE(object_instance,
+                (uint32_t) object_type), Reporting_Clock + 1,
+            Reporting_Clock + 1);
+        return true;
+    }
+    *remaining_time_delay -= elapsed;
+    Device_Reporting_Timer_Set(BACNET_ID_VALUE(object_instance,
+            (uint32_t) object_type), Reporting_Clock + *remaining_time_delay,
+        Reporting_Clock + *remaining_time_delay);
+
+    return false;
+}
+
+/** Get the counters of the intrinsic reporting of the objects,
+ * such as the latency from a change of an object to its evaluation.
+ * @param stats [out] the counters
+ */
+void Device_local_reporting_stats(
+    DEVICE_REPORTING_STATS * stats)
+{
+    if (stats) {
+        *stats = Reporting_Stats;
     }
 }
 #endif
@@ -2157,6 +2872,10 @@ void Device_Init(
     } else {
         Object_Table = &My_Object_Table[0];
     }
+    Device_Objects_Type_Index_Init();
+#if defined(INTRINSIC_REPORTING)
+    Device_Reporting_Init();
+#endif
     pObject = Object_Table;
     while (pObject->Object_Type < MAX_BACNET_OBJECT_TYPE) {
         if (pObject->Object_Init) {
@@ -2288,6 +3007,357 @@ int handler_cov_encode_subscriptions(
     return 0;
 }
 
+/* The objects of the unit test are analog values, numbered 1, 4, 7...
+   A second entry of the same type lists the first objects again.
+   Their intrinsic reporting records the order that they are evaluated
+   in, and their event state follows their alarm after a Time_Delay. */
+#define TEST_OBJECTS_MAX 24
+#define TEST_TIME_DELAY 3
+static unsigned Test_Count;
+static unsigned Test_Duplicate_Count;
+static char Test_Name[TEST_OBJECTS_MAX][32];
+static bool Test_Alarm[TEST_OBJECTS_MAX];
+static bool Test_Event_State[TEST_OBJECTS_MAX];
+static uint32_t Test_Remaining[TEST_OBJECTS_MAX];
+static uint32_t Test_Counted[TEST_OBJECTS_MAX];
+static unsigned Test_Transitions[TEST_OBJECTS_MAX];
+static uint32_t Test_Evaluated[TEST_OBJECTS_MAX * 2];
+static unsigned Test_Evaluated_Count;
+
+static void Test_Object_Init(
+    void)
+{
+    unsigned i;
+
+    for (i = 0; i < TEST_OBJECTS_MAX; i++) {
+        sprintf(Test_Name[i], "Test %u", i);
+        Test_Alarm[i] = false;
+        Test_Event_State[i] = false;
+        Test_Remaining[i] = TEST_TIME_DELAY;
+        Test_Counted[i] = 0;
+        Test_Transitions[i] = 0;
+    }
+    Test_Evaluated_Count = 0;
+}
+
+static unsigned Test_Object_Count(
+    void)
+{
+    return Test_Count;
+}
+
+static unsigned Test_Duplicate_Object_Count(
+    void)
+{
+    return Test_Duplicate_Count;
+}
+
+static uint32_t Test_Object_Index_To_Instance(
+    unsigned index)
+{
+    return (index * 3) + 1;
+}
+
+static bool Test_Object_Valid_Instance(
+    uint32_t object_instance)
+{
+    return ((object_instance % 3) == 1) &&
+        (((object_instance - 1) / 3) < Test_Count);
+}
+
+static bool Test_Duplicate_Valid_Instance(
+    uint32_t object_instance)
+{
+    object_instance = object_instance;
+
+    return false;
+}
+
+static bool Test_Object_Name(
+    uint32_t object_instance,
+    BACNET_CHARACTER_STRING * object_name)
+{
+    if (!Test_Object_Valid_Instance(object_instance)) {
+        return false;
+    }
+
+    return characterstring_init_ansi(object_name,
+        Test_Name[(object_instance - 1) / 3]);
+}
+
+static bool Test_Duplicate_Object_Name(
+    uint32_t object_instance,
+    BACNET_CHARACTER_STRING * object_name)
+{
+    object_instance = object_instance;
+
+    return characterstring_init_ansi(object_name, "Duplicate");
+}
+
+static void Test_Object_Intrinsic_Reporting(
+    uint32_t object_instance)
+{
+    unsigned index = (object_instance - 1) / 3;
+
+    if (Test_Evaluated_Count < (TEST_OBJECTS_MAX * 2)) {
+        Test_Evaluated[Test_Evaluated_Count] = object_instance;
+        Test_Evaluated_Count++;
+    }
+#if defined(INTRINSIC_REPORTING)
+    if (Test_Alarm[index] != Test_Event_State[index]) {
+        if (Device_local_reporting_time_delay(OBJECT_ANALOG_VALUE,
+                object_instance, TEST_TIME_DELAY, &Test_Remaining[index],
+                &Test_Counted[index])) {
+            Test_Event_State[index] = Test_Alarm[index];
+            Test_Transitions[index]++;
+        }
+    } else {
+        /* the condition is gone */
+        Test_Remaining[index] = TEST_TIME_DELAY;
+        Test_Counted[index] = 0;
+    }
+#else
+    index = index;
+#endif
+}
+
+static object_functions_t Test_Object_Table[] = {
+    {OBJECT_DEVICE, NULL, Device_Count, Device_Index_To_Instance,
+            Device_Valid_Object_Instance_Number, Device_Object_Name,
+            Device_Read_Property_Local, Device_Write_Property_Local,
+            Device_Property_Lists, NULL, NULL, NULL, NULL, NULL, NULL},
+    {OBJECT_ANALOG_VALUE, Test_Object_Init, Test_Object_Count,
+            Test_Object_Index_To_Instance, Test_Object_Valid_Instance,
+            Test_Object_Name, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+        Test_Object_Intrinsic_Reporting},
+    {OBJECT_ANALOG_VALUE, NULL, Test_Duplicate_Object_Count,
+            Test_Object_Index_To_Instance, Test_Duplicate_Valid_Instance,
+            Test_Duplicate_Object_Name, NULL, NULL, NULL, NULL, NULL, NULL,
+        NULL, NULL, NULL},
+    {MAX_BACNET_OBJECT_TYPE, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+            NULL, NULL, NULL, NULL, NULL, NULL}
+};
+
+/* each element of the Object_List is found at its own index,
+   or at the index of the first of its duplicates */
+static void testObjectListIndex(
+    Test * pTest)
+{
+    unsigned count, i, index;
+    int object_type = 0;
+    uint32_t object_instance = 0;
+
+    count = Device_Object_List_Count();
+    ct_test(pTest, count == (1 + Test_Count + Test_Duplicate_Count));
+    ct_test(pTest, Device_Object_List_Identifier(1, &object_type,
+            &object_instance));
+    ct_test(pTest, object_type == OBJECT_DEVICE);
+    ct_test(pTest, object_instance == Device_Object_Instance_Number());
+    for (i = 0; i < Test_Count; i++) {
+        ct_test(pTest, Device_Object_List_Identifier(2 + i, &object_type,
+                &object_instance));
+        ct_test(pTest, object_type == OBJECT_ANALOG_VALUE);
+        ct_test(pTest, object_instance == ((i * 3) + 1));
+        index = Device_Object_List_Index(OBJECT_ANALOG_VALUE,
+            object_instance);
+        ct_test(pTest, index == (2 + i));
+    }
+    for (i = 0; i < Test_Duplicate_Count; i++) {
+        ct_test(pTest, Device_Object_List_Identifier(2 + Test_Count + i,
+                &object_type, &object_instance));
+        ct_test(pTest, object_type == OBJECT_ANALOG_VALUE);
+        ct_test(pTest, object_instance == ((i * 3) + 1));
+        index = Device_Object_List_Index(OBJECT_ANALOG_VALUE,
+            object_instance);
+        ct_test(pTest, index == (2 + i));
+    }
+    ct_test(pTest, !Device_Object_List_Identifier(0, &object_type,
+            &object_instance));
+    ct_test(pTest, !Device_Object_List_Identifier(count + 1, &object_type,
+            &object_instance));
+    ct_test(pTest, Device_Object_List_Index(OBJECT_ANALOG_VALUE, 2) == 0);
+    ct_test(pTest, Device_Object_List_Index(OBJECT_ANALOG_INPUT, 1) == 0);
+    ct_test(pTest, Device_Object_List_Index(MAX_BACNET_OBJECT_TYPE, 1) == 0);
+}
+
+/* the first entry of an object type in the table is the one used */
+static void testDeviceObjectTable(
+    Test * pTest)
+{
+    BACNET_CHARACTER_STRING object_name;
+    int object_type = 0;
+    uint32_t object_instance = 0;
+
+    Device_Init(Test_Object_Table);
+    Test_Count = 5;
+    Test_Duplicate_Count = 2;
+    ct_test(pTest, Device_Valid_Object_Id(OBJECT_ANALOG_VALUE, 4));
+    ct_test(pTest, !Device_Valid_Object_Id(OBJECT_ANALOG_VALUE, 5));
+    ct_test(pTest, !Device_Valid_Object_Id(OBJECT_ANALOG_INPUT, 4));
+    ct_test(pTest, Device_Object_Name_Copy(OBJECT_ANALOG_VALUE, 4,
+            &object_name));
+    ct_test(pTest, characterstring_ansi_same(&object_name, "Test 1"));
+    ct_test(pTest, !Device_Value_List_Supported(OBJECT_ANALOG_VALUE));
+    /* the directory, and the objects walked when they do not fit it */
+    testObjectListIndex(pTest);
+    Test_Count = TEST_OBJECTS_MAX;
+    if (Device_Object_List_Count() > MAX_DEVICE_OBJECTS) {
+        testObjectListIndex(pTest);
+    }
+    Test_Count = 5;
+    testObjectListIndex(pTest);
+    /* names */
+    characterstring_init_ansi(&object_name, "Test 3");
+    ct_test(pTest, Device_Valid_Object_Name(&object_name, &object_type,
+            &object_instance));
+    ct_test(pTest, object_type == OBJECT_ANALOG_VALUE);
+    ct_test(pTest, object_instance == 10);
+    characterstring_init_ansi(&object_name, "Duplicate");
+    ct_test(pTest, !Device_Valid_Object_Name(&object_name, NULL, NULL));
+    strcpy(Test_Name[3], "Renamed");
+    Device_Object_Name_Changed(OBJECT_ANALOG_VALUE, 10);
+    characterstring_init_ansi(&object_name, "Test 3");
+    ct_test(pTest, !Device_Valid_Object_Name(&object_name, NULL, NULL));
+    characterstring_init_ansi(&object_name, "Renamed");
+    ct_test(pTest, Device_Valid_Object_Name(&object_name, &object_type,
+            &object_instance));
+    ct_test(pTest, object_instance == 10);
+    /* of objects with the same name, the first is found */
+    strcpy(Test_Name[4], "Test 1");
+    Device_Object_Name_Changed(OBJECT_ANALOG_VALUE, 13);
+    characterstring_init_ansi(&object_name, "Test 1");
+    ct_test(pTest, Device_Valid_Object_Name(&object_name, &object_type,
+            &object_instance));
+    ct_test(pTest, object_instance == 4);
+    strcpy(Test_Name[1], "Moved");
+    Device_Object_Name_Changed(OBJECT_ANALOG_VALUE, 4);
+    ct_test(pTest, Device_Valid_Object_Name(&object_name, &object_type,
+            &object_instance));
+    ct_test(pTest, object_instance == 13);
+    Test_Duplicate_Count = 0;
+}
+
+#if defined(INTRINSIC_REPORTING)
+/* forget the objects that were evaluated, and tick once */
+static void testReportingTick(
+    void)
+{
+    Test_Evaluated_Count = 0;
+    Device_local_reporting();
+}
+
+static void testDeviceReporting(
+    Test * pTest)
+{
+    static const uint32_t delays[] = { 4, 2, 3, 1 };
+    DEVICE_REPORTING_STATS stats;
+    uint32_t evaluations, sweeps;
+    uint32_t remaining, counted;
+    unsigned i, ticks;
+
+    Device_Init(Test_Object_Table);
+    Test_Count = 8;
+    Test_Duplicate_Count = 0;
+    /* every object is evaluated at first */
+    Device_local_reporting();
+    ct_test(pTest, Test_Evaluated_Count == Test_Count);
+    testReportingTick();
+    ct_test(pTest, Test_Evaluated_Count == 0);
+
+    /* an object that changes again before it is evaluated has one timer,
+       and is due at the soonest of its times */
+    Device_local_reporting_changed(OBJECT_ANALOG_VALUE, 7);
+    Device_local_reporting_changed(OBJECT_ANALOG_VALUE, 7);
+    remaining = 4;
+    counted = 0;
+    Device_local_reporting_time_delay(OBJECT_ANALOG_VALUE, 7, 4, &remaining,
+        &counted);
+    Device_local_reporting_changed(OBJECT_ANALOG_VALUE, 7);
+    Device_local_reporting_stats(&stats);
+    ct_test(pTest, stats.pending_max == 1);
+    remaining = 4;
+    counted = 0;
+    Device_local_reporting_time_delay(OBJECT_ANALOG_VALUE, 10, 4, &remaining,
+        &counted);
+    Device_local_reporting_changed(OBJECT_ANALOG_VALUE, 10);
+    Device_local_reporting();
+    ct_test(pTest, Test_Evaluated_Count == 2);
+    ct_test(pTest, Test_Evaluated[0] != Test_Evaluated[1]);
+    testReportingTick();
+    for (i = 0; i < 5; i++) {
+        Device_local_reporting();
+    }
+    ct_test(pTest, Test_Evaluated_Count == 0);
+
+    /* the timers are evaluated in the order that they are due;
+       there are no more than the MAX_REPORTING_PENDING of device.mak */
+    for (i = 0; i < (sizeof(delays) / sizeof(delays[0])); i++) {
+        remaining = delays[i];
+        counted = 0;
+        ct_test(pTest, !Device_local_reporting_time_delay(OBJECT_ANALOG_VALUE,
+                Test_Object_Index_To_Instance(i), delays[i], &remaining,
+                &counted));
+    }
+    for (ticks = 1; ticks <= 4; ticks++) {
+        Device_local_reporting();
+        ct_test(pTest, Test_Evaluated_Count == ticks);
+        for (i = 0; i < (sizeof(delays) / sizeof(delays[0])); i++) {
+            if (delays[i] == ticks) {
+                ct_test(pTest, Test_Evaluated[ticks - 1] ==
+                    Test_Object_Index_To_Instance(i));
+            }
+        }
+    }
+    testReportingTick();
+    ct_test(pTest, Test_Evaluated_Count == 0);
+
+    /* more than MAX_REPORTING_PENDING objects are evaluated by a sweep */
+    Device_local_reporting_stats(&stats);
+    sweeps = stats.sweeps;
+    evaluations = stats.evaluations;
+    for (i = 0; i < Test_Count; i++) {
+        Device_local_reporting_changed(OBJECT_ANALOG_VALUE,
+            Test_Object_Index_To_Instance(i));
+    }
+    Device_local_reporting_stats(&stats);
+    ct_test(pTest, stats.pending_max == MAX_REPORTING_PENDING);
+    Device_local_reporting();
+    Device_local_reporting_stats(&stats);
+    ct_test(pTest, stats.sweeps == (sweeps + 1));
+    ct_test(pTest, stats.evaluations ==
+        (evaluations + Device_Object_List_Count()));
+    ct_test(pTest, Test_Evaluated_Count == Test_Count);
+    testReportingTick();
+    ct_test(pTest, Test_Evaluated_Count == 0);
+
+    /* the Time_Delay is counted anew after each transition */
+    for (i = 0; i < 2; i++) {
+        Test_Alarm[2] = !Test_Alarm[2];
+        Device_local_reporting_changed(OBJECT_ANALOG_VALUE, 7);
+        Device_local_reporting_stats(&stats);
+        evaluations = stats.evaluations;
+        for (ticks = 0; ticks < 10; ticks++) {
+            Device_local_reporting();
+            if (Test_Transitions[2] == (i + 1)) {
+                break;
+            }
+        }
+        ct_test(pTest, ticks == TEST_TIME_DELAY);
+        ct_test(pTest, Test_Event_State[2] == Test_Alarm[2]);
+        /* not evaluated while the delay is counted down */
+        Device_local_reporting_stats(&stats);
+        ct_test(pTest, stats.evaluations == (evaluations + 2));
+        /* and once more in the new state */
+        testReportingTick();
+        ct_test(pTest, Test_Evaluated_Count == 1);
+        ct_test(pTest, Test_Remaining[2] == TEST_TIME_DELAY);
+        testReportingTick();
+        ct_test(pTest, Test_Evaluated_Count == 0);
+    }
+    Test_Count = 0;
+}
+#endif
+
 void testDevice(
     Test * pTest)
 {
@@ -2332,6 +3402,12 @@ int main(
     /* individual tests */
     rc = ct_addTestFunction(pTest, testDevice);
     assert(rc);
+    rc = ct_addTestFunction(pTest, testDeviceObjectTable);
+    assert(rc);
+#if defined(INTRINSIC_REPORTING)
+    rc = ct_addTestFunction(pTest, testDeviceReporting);
+    assert(rc);
+#endif
 
     ct_setStream(pTest, stdout);
     ct_run(pTest);
@@ -2342,3 +3418,103 @@ int main(
 }
 #endif /* TEST_DEVICE */
 #endif /* TEST */
+
+#ifdef TEST_DEVICE_BENCH
+#include <time.h>
+
+/* Measure the Who-Has lookup of an object by its name, and the update
+   of the index when a name is written, as the number of objects grows.
+   Build with a MAX_DEVICE_OBJECTS of at least 100001 and the object
+   modules and library of the demo server - see device_bench.mak */
+static unsigned Bench_Count;
+
+static unsigned Bench_Object_Count(
+    void)
+{
+    return Bench_Count;
+}
+
+static uint32_t Bench_Index_To_Instance(
+    unsigned index)
+{
+    return index;
+}
+
+static bool Bench_Valid_Instance(
+    uint32_t object_instance)
+{
+    return (object_instance < Bench_Count);
+}
+
+static bool Bench_Object_Name(
+    uint32_t object_instance,
+    BACNET_CHARACTER_STRING * object_name)
+{
+    char text[32];
+
+    sprintf(text, "Zone %lu Temperature", (unsigned long) object_instance);
+
+    return characterstring_init_ansi(object_name, text);
+}
+
+static object_functions_t Bench_Object_Table[] = {
+    {OBJECT_DEVICE, NULL, Device_Count, Device_Index_To_Instance,
+            Device_Valid_Object_Instance_Number, Device_Object_Name,
+            Device_Read_Property_Local, Device_Write_Property_Local,
+            Device_Property_Lists, NULL, NULL, NULL, NULL, NULL, NULL},
+    {OBJECT_ANALOG_VALUE, NULL, Bench_Object_Count, Bench_Index_To_Instance,
+            Bench_Valid_Instance, Bench_Object_Name, NULL, NULL, NULL, NULL,
+            NULL, NULL, NULL, NULL, NULL},
+    {MAX_BACNET_OBJECT_TYPE, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL,
+            NULL, NULL, NULL, NULL, NULL, NULL}
+};
+
+int main(
+    void)
+{
+    static const unsigned sizes[] = { 100, 1000, 10000, 100000 };
+    const uint32_t lookups = 100000;
+    BACNET_CHARACTER_STRING object_name;
+    int object_type = 0;
+    uint32_t object_instance = 0;
+    uint32_t i, instance;
+    unsigned n;
+    unsigned long found;
+    clock_t start;
+    double lookup_ns, write_ns;
+
+    Device_Init(Bench_Object_Table);
+    printf("objects  Who-Has name ns/lookup  name write ns/write\n");
+    for (n = 0; n < (sizeof(sizes) / sizeof(sizes[0])); n++) {
+        Bench_Count = sizes[n];
+        if ((Bench_Count + 1) > MAX_DEVICE_OBJECTS) {
+            break;
+        }
+        Device_Inc_Database_Revision();
+        found = 0;
+        start = clock();
+        for (i = 0; i < lookups; i++) {
+            instance = (i * 7919) % Bench_Count;
+            Bench_Object_Name(instance, &object_name);
+            if (Device_Valid_Object_Name(&object_name, &object_type,
+                    &object_instance) && (object_instance == instance)) {
+                found++;
+            }
+        }
+        lookup_ns =
+            ((double) (clock() - start) * 1e9) / CLOCKS_PER_SEC / lookups;
+        /* the duplicate name check of each write is a lookup too */
+        start = clock();
+        for (i = 0; i < lookups; i++) {
+            Device_Object_Name_Changed(OBJECT_ANALOG_VALUE,
+                (i * 7919) % Bench_Count);
+        }
+        write_ns =
+            ((double) (clock() - start) * 1e9) / CLOCKS_PER_SEC / lookups;
+        printf("%7u  %23.1f  %19.1f  (%lu found)\n", Bench_Count, lookup_ns,
+            write_ns, found);
+    }
+
+    return 0;
+}
+#endif /* TEST_DEVICE_BENCH */
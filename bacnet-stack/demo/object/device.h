@@ -173,6 +173,40 @@ typedef struct object_functions {
 #define MAX_DEV_VER_LEN  16
 #define MAX_DEV_DESC_LEN 64
 
+/* objects that the Object_List directory can hold - the Object_List
+   of a device with more objects is found by walking the object types,
+   which makes reading the Object_List element by element quadratic.
+   A device with more objects, such as a gateway, defines a larger value
+   for the build; each object takes 16 octets of RAM for the directory
+   and its indexes (24 octets from 65535 objects). */
+#ifndef MAX_DEVICE_OBJECTS
+#define MAX_DEVICE_OBJECTS 1024
+#endif
+
+/* number of objects that can wait for their intrinsic reporting
+   to be evaluated at once; more than that makes every object be
+   evaluated at the next Device_local_reporting() */
+#ifndef MAX_REPORTING_PENDING
+#define MAX_REPORTING_PENDING 1024
+#endif
+
+/* Counters of the intrinsic reporting of the objects.  Times are in
+   seconds, the ticks of Device_local_reporting(). */
+typedef struct device_reporting_stats {
+    uint32_t ticks;
+    /* objects that were evaluated */
+    uint32_t evaluations;
+    /* evaluations of every object, when the objects changed or
+       there were more than MAX_REPORTING_PENDING waiting */
+    uint32_t sweeps;
+    /* objects waiting at once, at most */
+    uint32_t pending_max;
+    /* time from the change of an object, or the end of its
+       Time_Delay, to its evaluation */
+    uint32_t latency_max;
+    uint64_t latency_total;
+} DEVICE_REPORTING_STATS;
+
 /** Structure to define the Object Properties common to all Objects. */
 typedef struct commonBacObj_s {
 
@@ -281,6 +315,9 @@ extern "C" {
         uint32_t array_index,
         int *object_type,
         uint32_t * instance);
+    uint32_t Device_Object_List_Index(
+        int object_type,
+        uint32_t instance);
 
     unsigned Device_Count(
         void);
@@ -360,6 +397,13 @@ extern "C" {
         BACNET_CHARACTER_STRING * object_name,
         int *object_type,
         uint32_t * object_instance);
+    bool Device_Valid_Object_Name_View(
+        const BACNET_CHARACTER_STRING_VIEW * object_name,
+        int *object_type,
+        uint32_t * object_instance);
+    void Device_Object_Name_Changed(
+        int object_type,
+        uint32_t object_instance);
     bool Device_Valid_Object_Id(
         int object_type,
         uint32_t object_instance);
@@ -381,6 +425,17 @@ extern "C" {
 #if defined(INTRINSIC_REPORTING)
     void Device_local_reporting(
         void);
+    void Device_local_reporting_changed(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
+    bool Device_local_reporting_time_delay(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        uint32_t time_delay,
+        uint32_t * remaining_time_delay,
+        uint32_t * counted);
+    void Device_local_reporting_stats(
+        DEVICE_REPORTING_STATS * stats);
 #endif
 
 /* Prototypes for Routing functionality in the Device Object.
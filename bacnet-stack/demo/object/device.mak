@@ -10,6 +10,11 @@ DEFINES += -DBACAPP_ALL
 DEFINES += -DMAX_TSM_TRANSACTIONS=0
 DEFINES += -DTEST_DEVICE
 DEFINES += -DBACNET_PROPERTY_LISTS=1
+DEFINES += -DINTRINSIC_REPORTING
+# fewer than the objects of the test, so that they are swept too
+DEFINES += -DMAX_REPORTING_PENDING=4
+# fewer than the objects of the test, so that they are walked too
+DEFINES += -DMAX_DEVICE_OBJECTS=16
 
 CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -g
 
@@ -27,6 +32,7 @@ SRCS = device.c \
 	$(SRC_DIR)/lighting.c \
 	$(SRC_DIR)/apdu.c \
 	$(SRC_DIR)/address.c \
+	$(SRC_DIR)/hashindex.c \
 	$(SRC_DIR)/bacaddr.c \
 	$(SRC_DIR)/dcc.c \
 	$(SRC_DIR)/version.c \
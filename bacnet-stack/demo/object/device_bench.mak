@@ -0,0 +1,65 @@
+#Makefile to build benchmark
+CC      = gcc
+SRC_DIR = ../../src
+PORTS_DIR = ../../ports/linux
+BACNET_LIB_DIR = ../../lib
+INCLUDES = -I../../include -I$(PORTS_DIR) -I.
+# the same defines as the library that it links with
+DEFINES = -DPRINT_ENABLED=1 -DBACAPP_ALL -DBACFILE -DINTRINSIC_REPORTING
+DEFINES += -DBACNET_TIME_MASTER -DBACNET_PROPERTY_LISTS=1
+DEFINES += -DBACNET_SEGMENTATION_ENABLED=1 -DBACDL_BIP=1 -DWEAK_FUNC=
+DEFINES += -DTEST_DEVICE_BENCH -DMAX_DEVICE_OBJECTS=100001
+
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -O2
+
+SRCS = device.c \
+	ai.c \
+	ao.c \
+	av.c \
+	bi.c \
+	bo.c \
+	bv.c \
+	channel.c \
+	command.c \
+	csv.c \
+	iv.c \
+	lc.c \
+	lo.c \
+	lsp.c \
+	ms-input.c \
+	mso.c \
+	msv.c \
+	osv.c \
+	piv.c \
+	nc.c \
+	trendlog.c \
+	schedule.c \
+	access_credential.c \
+	access_door.c \
+	access_point.c \
+	access_rights.c \
+	access_user.c \
+	access_zone.c \
+	credential_data_input.c \
+	bacfile.c
+
+OBJS = ${SRCS:.c=.o}
+
+TARGET = device_bench
+
+all: ${TARGET}
+
+${TARGET}: ${OBJS}
+	${CC} -o $@ ${OBJS} -L$(BACNET_LIB_DIR) -lbacnet -lpthread -lm
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+
+clean:
+	rm -rf core ${TARGET} $(OBJS)
+
+include: .depend
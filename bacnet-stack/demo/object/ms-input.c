@@ -323,6 +323,7 @@ bool Multistate_Input_Name_Set(
     unsigned index = 0; /* offset from instance lookup */
     size_t i = 0;       /* loop counter */
     bool status = false;        /* return value */
+    bool changed = false;
 
     index = Multistate_Input_Instance_To_Index(object_instance);
     if (index < MAX_MULTISTATE_INPUTS) {
@@ -330,6 +331,9 @@ bool Multistate_Input_Name_Set(
         /* FIXME: check to see if there is a matching name */
         if (new_name) {
             for (i = 0; i < sizeof(Object_Name[index]); i++) {
+                if (Object_Name[index][i] != new_name[i]) {
+                    changed = true;
+                }
                 Object_Name[index][i] = new_name[i];
                 if (new_name[i] == 0) {
                     break;
@@ -337,9 +341,16 @@ bool Multistate_Input_Name_Set(
             }
         } else {
             for (i = 0; i < sizeof(Object_Name[index]); i++) {
+                if (Object_Name[index][i] != 0) {
+                    changed = true;
+                }
                 Object_Name[index][i] = 0;
             }
         }
+        if (changed) {
+            Device_Object_Name_Changed(OBJECT_MULTI_STATE_INPUT,
+                object_instance);
+        }
     }
 
     return status;
@@ -365,7 +376,10 @@ static bool Multistate_Input_Object_Name_Write(
                 status =
                     characterstring_ansi_copy(Object_Name[index],
                     sizeof(Object_Name[index]), char_string);
-                if (!status) {
+                if (status) {
+                    Device_Object_Name_Changed(OBJECT_MULTI_STATE_INPUT,
+                        object_instance);
+                } else {
                     *error_class = ERROR_CLASS_PROPERTY;
                     *error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
                 }
@@ -785,6 +799,12 @@ bool Multistate_Input_Write_Property(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Changed(
+    int object_type,
+    uint32_t object_instance)
+{
+}
+
 
 bool Device_Valid_Object_Name(
     BACNET_CHARACTER_STRING * object_name,
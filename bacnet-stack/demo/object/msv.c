@@ -35,6 +35,7 @@
 #include "config.h"     /* the custom stuff */
 #include "rp.h"
 #include "wp.h"
+#include "device.h"
 #include "msv.h"
 #include "handlers.h"
 
@@ -278,6 +279,7 @@ bool Multistate_Value_Name_Set(
     unsigned index = 0; /* offset from instance lookup */
     size_t i = 0;       /* loop counter */
     bool status = false;        /* return value */
+    bool changed = false;
 
     index = Multistate_Value_Instance_To_Index(object_instance);
     if (index < MAX_MULTISTATE_VALUES) {
@@ -285,6 +287,9 @@ bool Multistate_Value_Name_Set(
         /* FIXME: check to see if there is a matching name */
         if (new_name) {
             for (i = 0; i < sizeof(Object_Name[index]); i++) {
+                if (Object_Name[index][i] != new_name[i]) {
+                    changed = true;
+                }
                 Object_Name[index][i] = new_name[i];
                 if (new_name[i] == 0) {
                     break;
@@ -292,9 +297,16 @@ bool Multistate_Value_Name_Set(
             }
         } else {
             for (i = 0; i < sizeof(Object_Name[index]); i++) {
+                if (Object_Name[index][i] != 0) {
+                    changed = true;
+                }
                 Object_Name[index][i] = 0;
             }
         }
+        if (changed) {
+            Device_Object_Name_Changed(OBJECT_MULTI_STATE_VALUE,
+                object_instance);
+        }
     }
 
     return status;
@@ -559,6 +571,12 @@ bool Multistate_Value_Write_Property(
 #include <string.h>
 #include "ctest.h"
 
+void Device_Object_Name_Changed(
+    int object_type,
+    uint32_t object_instance)
+{
+}
+
 bool WPValidateArgType(
     BACNET_APPLICATION_DATA_VALUE * pValue,
     uint8_t ucExpectedTag,
@@ -25,6 +25,8 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdio.h>      /* for snprintf */
+#include <stdlib.h>     /* for calloc */
 #include <string.h>     /* for memmove */
 #include "bacdef.h"
 #include "bacdcode.h"
@@ -38,19 +40,213 @@
 #include "handlers.h"
 #include "datalink.h"
 #include "address.h"
+#include "tsm.h"
+#include "client.h"
+#include "pollsched.h"
 #include "bacdevobjpropref.h"
 #include "trendlog.h"
 #if defined(BACFILE)
 #include "bacfile.h"    /* object list dependency */
 #endif
 
+/* Keep the logs in memory mapped files where the OS has them */
+#if !defined(TL_STORE_MMAP) && (defined(__unix__) || defined(__APPLE__))
+#define TL_STORE_MMAP 1
+#endif
+#if TL_STORE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 /* number of demo objects */
 #ifndef MAX_TREND_LOGS
 #define MAX_TREND_LOGS 8
 #endif
+/* records written between each flush of a log file to the disk */
+#ifndef TL_STORE_SYNC_RECORDS
+#define TL_STORE_SYNC_RECORDS 128
+#endif
+#ifndef TL_STORE_PATH_MAX
+#define TL_STORE_PATH_MAX 256
+#endif
+/* records of a log file for each entry in its time index */
+#ifndef TL_TIME_INDEX_RECORDS
+#define TL_TIME_INDEX_RECORDS 128
+#endif
+/* seconds the sampling scheduler catches up one at a time when it is
+   called late; a longer step of the clock schedules every log again */
+#ifndef TL_SCHED_CATCH_UP
+#define TL_SCHED_CATCH_UP 3600
+#endif
+/* SubscribeCOV requests of remote sources waiting on a reply at once */
+#ifndef TL_COV_REQUESTS
+#define TL_COV_REQUESTS 16
+#endif
+/* seconds that the COV subscription of a log lasts, which is renewed
+   at half of it, and the wait to try again after one failed */
+#ifndef TL_COV_LIFETIME
+#define TL_COV_LIFETIME 600
+#endif
+#ifndef TL_COV_RETRY
+#define TL_COV_RETRY 30
+#endif
+/* subscriber process identifier of the first log, "TL" */
+#ifndef TL_COV_PROCESS_ID
+#define TL_COV_PROCESS_ID 0x544C0000UL
+#endif
+
+/*
+ * Log file format
+ *
+ * A header that does not change once the file is created, then
+ * Buffer_Size records at TL_STORE_RECORD_OFFSET.  The log is a ring of
+ * records that is only ever appended to.  Each record carries its
+ * sequence number and a hash of both, so that after a crash the log is
+ * found again by looking for where the sequence numbers stop following
+ * on from each other.  Records are flushed to the disk every
+ * TL_STORE_SYNC_RECORDS, so that only the last of these windows of
+ * records can be partly written; the earlier windows are searched in
+ * halves and only the last one a record at a time.  A purge or a new
+ * Buffer_Size replaces the file with an empty one.
+ */
+#define TL_STORE_VERSION 1
+#define TL_STORE_RECORD_OFFSET 64
+
+typedef struct tl_store_header {
+    uint8_t ucMagic[8];
+    uint32_t ulVersion;
+    uint32_t ulRecordSize;
+    uint32_t ulBufferSize;
+    uint32_t ulInstance;
+    uint32_t ulCheck;
+} TL_STORE_HEADER;
+
+typedef struct tl_store_rec {
+    uint32_t ulSequence;        /* Total_Record_Count with this record */
+    uint32_t ulCheck;   /* hash of the sequence number and the record */
+    TL_DATA_REC Rec;
+} TL_STORE_REC;
+
+typedef struct tl_store {
+    TL_STORE_REC *pRecords;
+    void *pMap; /* the file mapping, or NULL if the records are in RAM */
+    size_t MapSize;
+    int iFile;
+    /* time stamp of every TL_TIME_INDEX_RECORDS slot of a log file, so
+       that a search by time only reads one page of it, or NULL until
+       the first search */
+    time_t *pTimes;
+    /* sequence number of the newest record whose time stamp is before
+       that of the record before it, while that one is still in the
+       log, or 0.  A search by time walks the log while there is one. */
+    uint32_t ulDisorder;
+    /* true for a log file that was found again, until the first search
+       looks for such a record in it */
+    bool bOrderUnknown;
+} TL_STORE;
+
+static const uint8_t TL_Store_Magic[8] = {
+    'B', 'A', 'C', 'n', 'e', 't', 'T', 'L'
+};
+
+/*
+ * Sampling scheduler
+ *
+ * Each log that is due to take a reading waits on a timer wheel for
+ * the second its reading is due, so that a tick of the scheduler only
+ * looks at the logs that are due in it, however many logs there are.
+ * The wheel has TL_WHEEL_LEVELS levels of TL_WHEEL_SIZE slots of one,
+ * 64 and 4096 seconds; a log that is due later than that waits in the
+ * top level and is put back on the wheel when its slot comes round.
+ * The links hold the index plus one, so that zero is "none".
+ */
+#if (MAX_TREND_LOGS > 65000)
+#error MAX_TREND_LOGS is too large for the scheduler indexes
+#endif
+typedef uint16_t TL_INDEX;
+
+#define TL_WHEEL_BITS 6
+#define TL_WHEEL_SIZE (1 << TL_WHEEL_BITS)
+#define TL_WHEEL_MASK (TL_WHEEL_SIZE - 1)
+#define TL_WHEEL_LEVELS 3
+#define TL_WHEEL_SLOT(t, level) \
+    (((level) * TL_WHEEL_SIZE) + \
+    (((uint32_t) (t) >> ((level) * TL_WHEEL_BITS)) & TL_WHEEL_MASK))
+
+typedef struct tl_sched {
+    TL_INDEX next;
+    TL_INDEX prev;
+    /* wheel slot plus one, or zero when the log is not scheduled */
+    uint8_t ucSlot;
+    /* when the next reading is due */
+    time_t tDue;
+} TL_SCHED;
+
+/*
+ * Remote sources
+ *
+ * A log of a property of another device is read over the network by the
+ * poll scheduler (see pollsched.c).  The ticks read the logs that are
+ * due once, with the Status_Flags of their objects, and the scheduler
+ * sends the reads of each device together, in as few
+ * ReadPropertyMultiple requests as fit its max APDU, once the device is
+ * bound.  A reading that gets no reply, or that is not sent in time, is
+ * logged with the error that the scheduler gives in place of its value.
+ * A COV log subscribes to its object instead, and logs the value from
+ * each notification.
+ */
+/* the log of a subscription request that no log waits on */
+#define TL_LOG_NONE 0xFFFF
+
+typedef struct tl_remote {
+    /* results still to come for the reading */
+    uint8_t ucPoints;
+    /* when the COV subscription is to be renewed, or zero for now */
+    time_t tRenew;
+    /* a subscription was sent, which is cancelled when it is not wanted */
+    bool bSubscribed;
+    /* the reading, filled in as the results come in */
+    TL_DATA_REC Rec;
+} TL_REMOTE;
+
+/* a SubscribeCOV request waiting on its SimpleACK */
+typedef struct tl_subscribe {
+    uint8_t invoke_id;
+    TL_INDEX log;
+    uint32_t ulDevice;
+} TL_SUBSCRIBE;
 
-TL_DATA_REC Logs[MAX_TREND_LOGS][TL_MAX_ENTRIES];
 static TL_LOG_INFO LogInfo[MAX_TREND_LOGS];
+static TL_STORE LogStore[MAX_TREND_LOGS];
+/* directory of the log files, or empty to keep the logs in RAM */
+static char TL_Store_Directory[TL_STORE_PATH_MAX];
+static bool TL_Initialized;
+
+static TL_SCHED LogSched[MAX_TREND_LOGS];
+static TL_INDEX TL_Wheel[TL_WHEEL_LEVELS * TL_WHEEL_SIZE];
+static TL_INDEX TL_Batch[MAX_TREND_LOGS];
+static unsigned TL_Sched_Count;
+/* the second of the last tick, once the logs have been scheduled,
+   and of the last run of the ticks, which may be later */
+static time_t TL_Clock;
+static time_t TL_Now;
+static bool TL_Clock_Valid;
+static TREND_LOG_STATS TL_Stats;
+
+static TL_REMOTE LogRemote[MAX_TREND_LOGS];
+static TL_SUBSCRIBE TL_Subscribes[TL_COV_REQUESTS];
+static unsigned TL_Subscribe_Count;
+
+static void TL_Schedule(
+    int iLog);
+static bool TL_Is_Remote(
+    BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE * Source);
+static void TL_Remote_Cancel(
+    int iLog);
+static void TL_Remote_Reset(
+    void);
 
 /* These three arrays are used by the ReadPropertyMultiple handler */
 static const int Trend_Log_Properties_Required[] = {
@@ -160,6 +356,608 @@ unsigned Trend_Log_Instance_To_Index(
     return index;
 }
 
+/****************************************************************************
+ * Log storage                                                              *
+ ****************************************************************************/
+
+/* FNV-1a hash of some octets, continuing from the given key */
+static uint32_t TL_Store_Hash(
+    const void *pData,
+    size_t Size,
+    uint32_t ulKey)
+{
+    const uint8_t *pOctets = (const uint8_t *) pData;
+
+    while (Size--) {
+        ulKey = (ulKey ^ *pOctets++) * 16777619UL;
+    }
+
+    return ulKey;
+}
+
+static uint32_t TL_Store_Check(
+    const TL_STORE_REC * pSlot)
+{
+    uint32_t ulKey;
+
+    ulKey =
+        TL_Store_Hash(&pSlot->ulSequence, sizeof(pSlot->ulSequence),
+        2166136261UL);
+
+    return TL_Store_Hash(&pSlot->Rec, sizeof(pSlot->Rec), ulKey);
+}
+
+/* true if the slot holds a whole record with the given sequence number */
+static bool TL_Store_Match(
+    int iLog,
+    uint32_t ulSlot,
+    uint32_t ulSequence)
+{
+    TL_STORE_REC *pSlot = &LogStore[iLog].pRecords[ulSlot];
+
+    return (pSlot->ulSequence == ulSequence) &&
+        (pSlot->ulCheck == TL_Store_Check(pSlot));
+}
+
+/* Entries are numbered from 1 for the oldest, as in ReadRange */
+static TL_DATA_REC *TL_Record(
+    int iLog,
+    uint32_t ulEntry)
+{
+    TL_LOG_INFO *CurrentLog = &LogInfo[iLog];
+    uint32_t ulSlot;
+
+    ulSlot =
+        CurrentLog->iIndex + CurrentLog->ulBufferSize -
+        CurrentLog->ulRecordCount + ulEntry - 1;
+
+    return &LogStore[iLog].pRecords[ulSlot % CurrentLog->ulBufferSize].Rec;
+}
+
+/* Find the newest record and the number of records from the sequence
+ * numbers in the slots.  The windows of records before the one that was
+ * being written have all been flushed, so each starts with the sequence
+ * number of the first slot plus its slot number, and the windows after
+ * it do not.  The records after the head are older ones from the last
+ * time around the ring, which were also flushed.
+ */
+static void TL_Store_Recover(
+    int iLog)
+{
+    TL_LOG_INFO *CurrentLog = &LogInfo[iLog];
+    TL_STORE_REC *pRecords = LogStore[iLog].pRecords;
+    uint32_t ulSize = CurrentLog->ulBufferSize;
+    uint32_t ulFirstSeq = 0;    /* sequence number in slot 0 */
+    uint32_t ulLastSeq = 0;     /* sequence number of the newest record */
+    uint32_t ulOldSeq = 0;      /* sequence number the head slot would have */
+    uint32_t ulHead = 0;        /* slot after the newest record */
+    uint32_t ulTail = 0;        /* slot of the oldest record after the head */
+    uint32_t ulLow = 0;
+    uint32_t ulHigh = 0;
+    uint32_t ulMiddle = 0;
+
+    CurrentLog->iIndex = 0;
+    CurrentLog->ulRecordCount = 0;
+    CurrentLog->ulTotalRecordCount = 0;
+    if (TL_Store_Match(iLog, 0, pRecords[0].ulSequence)) {
+        ulFirstSeq = pRecords[0].ulSequence;
+        ulHigh = (ulSize - 1) / TL_STORE_SYNC_RECORDS;
+        while (ulLow < ulHigh) {
+            ulMiddle = ulLow + (ulHigh - ulLow + 1) / 2;
+            ulHead = ulMiddle * TL_STORE_SYNC_RECORDS;
+            if (TL_Store_Match(iLog, ulHead, ulFirstSeq + ulHead)) {
+                ulLow = ulMiddle;
+            } else {
+                ulHigh = ulMiddle - 1;
+            }
+        }
+        ulHead = ulLow * TL_STORE_SYNC_RECORDS;
+        while ((ulHead < ulSize) &&
+            TL_Store_Match(iLog, ulHead, ulFirstSeq + ulHead)) {
+            ulHead++;
+        }
+        ulLastSeq = ulFirstSeq + ulHead - 1;
+    } else if (TL_Store_Match(iLog, ulSize - 1,
+            pRecords[ulSize - 1].ulSequence)) {
+        /* the write of slot 0 was lost, after going around the ring */
+        ulLastSeq = pRecords[ulSize - 1].ulSequence;
+    } else {
+        /* empty */
+        return;
+    }
+    ulTail = ulSize;
+    if (ulHead < ulSize) {
+        /* the record in slot N after the head is ulOldSeq + N */
+        ulOldSeq = ulLastSeq + 1 - ulSize - ulHead;
+        ulTail = ((ulHead / TL_STORE_SYNC_RECORDS) + 1) * TL_STORE_SYNC_RECORDS;
+        if (ulTail > ulSize) {
+            ulTail = ulSize;
+        }
+        if ((ulTail == ulSize) ||
+            TL_Store_Match(iLog, ulTail, ulOldSeq + ulTail)) {
+            while ((ulTail > ulHead) &&
+                TL_Store_Match(iLog, ulTail - 1, ulOldSeq + ulTail - 1)) {
+                ulTail--;
+            }
+        } else {
+            ulTail = ulSize;
+        }
+    }
+    CurrentLog->iIndex = ulHead % ulSize;
+    CurrentLog->ulRecordCount = ulHead + (ulSize - ulTail);
+    CurrentLog->ulTotalRecordCount = ulLastSeq;
+    LogStore[iLog].bOrderUnknown = true;
+}
+
+static void TL_Store_Close(
+    int iLog)
+{
+    TL_STORE *pStore = &LogStore[iLog];
+
+#if TL_STORE_MMAP
+    if (pStore->pMap) {
+        munmap(pStore->pMap, pStore->MapSize);
+    }
+    if (pStore->iFile >= 0) {
+        close(pStore->iFile);
+    }
+#endif
+    if (!pStore->pMap) {
+        free(pStore->pRecords);
+    }
+    free(pStore->pTimes);
+    pStore->pTimes = NULL;
+    pStore->ulDisorder = 0;
+    pStore->bOrderUnknown = false;
+    pStore->pRecords = NULL;
+    pStore->pMap = NULL;
+    pStore->MapSize = 0;
+    pStore->iFile = -1;
+}
+
+#if TL_STORE_MMAP
+static void TL_Store_Header_Init(
+    TL_STORE_HEADER * pHeader,
+    uint32_t ulInstance,
+    uint32_t ulBufferSize)
+{
+    memset(pHeader, 0, sizeof(TL_STORE_HEADER));
+    memcpy(pHeader->ucMagic, TL_Store_Magic, sizeof(pHeader->ucMagic));
+    pHeader->ulVersion = TL_STORE_VERSION;
+    pHeader->ulRecordSize = sizeof(TL_STORE_REC);
+    pHeader->ulBufferSize = ulBufferSize;
+    pHeader->ulInstance = ulInstance;
+    pHeader->ulCheck =
+        TL_Store_Hash(pHeader, sizeof(TL_STORE_HEADER), 2166136261UL);
+}
+
+/* Replace the log file with an empty one, so that a crash leaves either
+ * the old file or the new one.  Its blocks are allocated here, as a
+ * sparse file would fault on a write to the map once the disk is full.
+ */
+static bool TL_Store_File_Create(
+    const char *pPath,
+    uint32_t ulInstance,
+    uint32_t ulBufferSize)
+{
+    char TempPath[TL_STORE_PATH_MAX + 40];
+    TL_STORE_HEADER Header;
+    off_t Size;
+    int iFile;
+    bool status = false;
+
+    snprintf(TempPath, sizeof(TempPath), "%s.tmp", pPath);
+    iFile = open(TempPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (iFile < 0) {
+        return false;
+    }
+    TL_Store_Header_Init(&Header, ulInstance, ulBufferSize);
+    Size =
+        (off_t) TL_STORE_RECORD_OFFSET +
+        (off_t) ulBufferSize * (off_t) sizeof(TL_STORE_REC);
+    if ((posix_fallocate(iFile, 0, Size) == 0) &&
+        (pwrite(iFile, &Header, sizeof(Header), 0) == sizeof(Header)) &&
+        (fsync(iFile) == 0)) {
+        status = true;
+    }
+    close(iFile);
+    if (status && (rename(TempPath, pPath) != 0)) {
+        status = false;
+    }
+    if (!status) {
+        unlink(TempPath);
+    }
+
+    return status;
+}
+
+/* Map a log file, and take its Buffer_Size from the header */
+static bool TL_Store_File_Map(
+    int iLog,
+    const char *pPath,
+    uint32_t ulInstance)
+{
+    TL_STORE *pStore = &LogStore[iLog];
+    TL_STORE_HEADER Header;
+    TL_STORE_HEADER *pHeader;
+    struct stat Stat;
+    void *pMap;
+    size_t MapSize;
+
+    pStore->iFile = open(pPath, O_RDWR);
+    if (pStore->iFile < 0) {
+        return false;
+    }
+    if ((fstat(pStore->iFile, &Stat) != 0) ||
+        (Stat.st_size < (off_t) (TL_STORE_RECORD_OFFSET +
+                sizeof(TL_STORE_REC)))) {
+        TL_Store_Close(iLog);
+        return false;
+    }
+    MapSize = (size_t) Stat.st_size;
+    pMap =
+        mmap(NULL, MapSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+        pStore->iFile, 0);
+    if (pMap == MAP_FAILED) {
+        TL_Store_Close(iLog);
+        return false;
+    }
+    pStore->pMap = pMap;
+    pStore->MapSize = MapSize;
+    pHeader = (TL_STORE_HEADER *) pMap;
+    TL_Store_Header_Init(&Header, ulInstance, pHeader->ulBufferSize);
+    if ((memcmp(&Header, pHeader, sizeof(Header)) != 0) ||
+        (Header.ulBufferSize == 0) ||
+        (Header.ulBufferSize > TL_MAX_BUFFER_SIZE) ||
+        (MapSize != TL_STORE_RECORD_OFFSET +
+            (size_t) Header.ulBufferSize * sizeof(TL_STORE_REC))) {
+        TL_Store_Close(iLog);
+        return false;
+    }
+    pStore->pRecords =
+        (TL_STORE_REC *) ((uint8_t *) pMap + TL_STORE_RECORD_OFFSET);
+    LogInfo[iLog].ulBufferSize = Header.ulBufferSize;
+
+    return true;
+}
+#endif
+
+/* Flush the window of records that the slot completes */
+static void TL_Store_Sync(
+    int iLog,
+    uint32_t ulSlot)
+{
+#if TL_STORE_MMAP
+    TL_STORE *pStore = &LogStore[iLog];
+    uint8_t *pBegin;
+    uint8_t *pEnd;
+    size_t Offset;
+    long PageSize;
+
+    if (!pStore->pMap) {
+        return;
+    }
+    ulSlot++;
+    if (((ulSlot % TL_STORE_SYNC_RECORDS) != 0) &&
+        (ulSlot != LogInfo[iLog].ulBufferSize)) {
+        return;
+    }
+    pBegin =
+        (uint8_t *) & pStore->pRecords[((ulSlot -
+                1) / TL_STORE_SYNC_RECORDS) * TL_STORE_SYNC_RECORDS];
+    pEnd = (uint8_t *) & pStore->pRecords[ulSlot];
+    PageSize = sysconf(_SC_PAGESIZE);
+    Offset = (size_t) (pBegin - (uint8_t *) pStore->pMap);
+    if (PageSize > 0) {
+        Offset -= Offset % (size_t) PageSize;
+    }
+    msync((uint8_t *) pStore->pMap + Offset,
+        (size_t) (pEnd - (uint8_t *) pStore->pMap) - Offset, MS_SYNC);
+#else
+    (void) iLog;
+    (void) ulSlot;
+#endif
+}
+
+/* Open the records of a log at its Buffer_Size, from its file if there
+ * is one and it is not to be erased, otherwise empty.  Logs are kept in
+ * RAM if there is no directory for them, or their file cannot be used.
+ */
+static bool TL_Store_Open(
+    int iLog,
+    bool bErase)
+{
+    TL_LOG_INFO *CurrentLog = &LogInfo[iLog];
+    TL_STORE *pStore = &LogStore[iLog];
+#if TL_STORE_MMAP
+    char Path[TL_STORE_PATH_MAX + 32];
+    uint32_t ulInstance = Trend_Log_Index_To_Instance(iLog);
+#endif
+
+    TL_Store_Close(iLog);
+#if TL_STORE_MMAP
+    if (TL_Store_Directory[0]) {
+        snprintf(Path, sizeof(Path), "%s/trendlog-%lu.dat",
+            TL_Store_Directory, (unsigned long) ulInstance);
+        if (!bErase && TL_Store_File_Map(iLog, Path, ulInstance)) {
+            TL_Store_Recover(iLog);
+            return true;
+        }
+        if (TL_Store_File_Create(Path, ulInstance, CurrentLog->ulBufferSize)
+            && TL_Store_File_Map(iLog, Path, ulInstance)) {
+            TL_Store_Recover(iLog);
+            return true;
+        }
+#if PRINT_ENABLED
+        fprintf(stderr, "Trend Log %lu: unable to use %s\n",
+            (unsigned long) ulInstance, Path);
+#endif
+    }
+#else
+    (void) bErase;
+#endif
+    CurrentLog->iIndex = 0;
+    CurrentLog->ulRecordCount = 0;
+    CurrentLog->ulTotalRecordCount = 0;
+    pStore->pRecords =
+        (TL_STORE_REC *) calloc(CurrentLog->ulBufferSize,
+        sizeof(TL_STORE_REC));
+
+    return (pStore->pRecords != NULL);
+}
+
+/* Append a record to a log, pushing out the oldest one if it is full */
+static void TL_Store_Append(
+    int iLog,
+    TL_DATA_REC * pRec)
+{
+    TL_LOG_INFO *CurrentLog = &LogInfo[iLog];
+    TL_STORE_REC *pSlot;
+
+    if (!LogStore[iLog].pRecords) {
+        return;
+    }
+    if ((CurrentLog->ulRecordCount > 0) &&
+        (pRec->tTimeStamp <
+            TL_Record(iLog, CurrentLog->ulRecordCount)->tTimeStamp)) {
+        /* the clock was set back */
+        LogStore[iLog].ulDisorder = CurrentLog->ulTotalRecordCount + 1;
+    }
+    CurrentLog->ulTotalRecordCount++;
+    pSlot = &LogStore[iLog].pRecords[CurrentLog->iIndex];
+    pSlot->ulSequence = CurrentLog->ulTotalRecordCount;
+    pSlot->Rec = *pRec;
+    pSlot->ulCheck = TL_Store_Check(pSlot);
+    if (LogStore[iLog].pTimes &&
+        ((CurrentLog->iIndex % TL_TIME_INDEX_RECORDS) == 0)) {
+        LogStore[iLog].pTimes[CurrentLog->iIndex / TL_TIME_INDEX_RECORDS] =
+            pRec->tTimeStamp;
+    }
+    TL_Store_Sync(iLog, CurrentLog->iIndex);
+
+    CurrentLog->iIndex++;
+    if ((uint32_t) CurrentLog->iIndex >= CurrentLog->ulBufferSize)
+        CurrentLog->iIndex = 0;
+
+    if (CurrentLog->ulRecordCount < CurrentLog->ulBufferSize)
+        CurrentLog->ulRecordCount++;
+}
+
+/* Empty a log, and give it a new Buffer_Size.  The sequence numbers
+ * carry on from where they were.
+ */
+static bool TL_Purge(
+    int iLog,
+    uint32_t ulBufferSize)
+{
+    TL_LOG_INFO *CurrentLog = &LogInfo[iLog];
+    uint32_t ulTotalRecordCount = CurrentLog->ulTotalRecordCount;
+    bool status;
+
+    CurrentLog->ulBufferSize = ulBufferSize;
+    status = TL_Store_Open(iLog, true);
+    CurrentLog->ulTotalRecordCount = ulTotalRecordCount;
+    if (status) {
+        TL_Insert_Status_Rec(iLog, LOG_STATUS_BUFFER_PURGED, true);
+    }
+
+    return status;
+}
+
+/* true if the time stamp comes before the time, or at it as well */
+static bool TL_Time_Before(
+    time_t tTimeStamp,
+    time_t tTime,
+    bool bAt)
+{
+    return (tTimeStamp < tTime) || (bAt && (tTimeStamp == tTime));
+}
+
+/* Find the newest record of a log that is older than the one before
+ * it, by walking the log
+ */
+static void TL_Store_Order(
+    int iLog)
+{
+    TL_LOG_INFO *CurrentLog = &LogInfo[iLog];
+    uint32_t ulEntry;
+
+    LogStore[iLog].ulDisorder = 0;
+    for (ulEntry = 2; ulEntry <= CurrentLog->ulRecordCount; ulEntry++) {
+        if (TL_Record(iLog, ulEntry)->tTimeStamp <
+            TL_Record(iLog, ulEntry - 1)->tTimeStamp) {
+            LogStore[iLog].ulDisorder =
+                CurrentLog->ulTotalRecordCount -
+                CurrentLog->ulRecordCount + ulEntry;
+        }
+    }
+    LogStore[iLog].bOrderUnknown = false;
+}
+
+/* Count the entries at the start of a log that come before the time, or
+ * at it as well.  The time stamps of a log only go up, unless the clock
+ * is set back, so this is a binary search, or a walk of the log while
+ * a record from before the clock was set back is in it.  For a log file
+ * the search is first made in its time index, so that only one page of
+ * the records is read.
+ */
+static uint32_t TL_Entries_Before(
+    int iLog,
+    time_t tTime,
+    bool bAt)
+{
+    TL_LOG_INFO *CurrentLog = &LogInfo[iLog];
+    TL_STORE *pStore = &LogStore[iLog];
+    uint32_t ulSize = CurrentLog->ulBufferSize;
+    uint32_t ulCount = CurrentLog->ulRecordCount;
+    uint32_t ulOldest;
+    uint32_t ulFirst;   /* first window that starts at or after the oldest */
+    uint32_t ulWindows;
+    uint32_t ulLow = 0;
+    uint32_t ulHigh = ulCount;
+    uint32_t ulMiddle;
+    uint32_t ulEntry;
+    uint32_t ulSlot;
+    uint32_t w;
+
+    if (ulCount == 0) {
+        return 0;
+    }
+    if (pStore->bOrderUnknown) {
+        TL_Store_Order(iLog);
+    }
+    if (pStore->ulDisorder &&
+        ((CurrentLog->ulTotalRecordCount - pStore->ulDisorder) + 1 >=
+            ulCount)) {
+        /* the record before it has aged out */
+        pStore->ulDisorder = 0;
+    }
+    if (pStore->ulDisorder) {
+        for (ulEntry = 1; ulEntry <= ulCount; ulEntry++) {
+            if (!TL_Time_Before(TL_Record(iLog, ulEntry)->tTimeStamp, tTime,
+                    bAt)) {
+                break;
+            }
+        }
+        return ulEntry - 1;
+    }
+    ulOldest = (CurrentLog->iIndex + ulSize - ulCount) % ulSize;
+    ulWindows = (ulSize + TL_TIME_INDEX_RECORDS - 1) / TL_TIME_INDEX_RECORDS;
+    if (pStore->pMap && !pStore->pTimes) {
+        pStore->pTimes = (time_t *) calloc(ulWindows, sizeof(time_t));
+        if (pStore->pTimes) {
+            for (w = 0; w < ulWindows; w++) {
+                pStore->pTimes[w] =
+                    pStore->pRecords[w *
+                    TL_TIME_INDEX_RECORDS].Rec.tTimeStamp;
+            }
+        }
+    }
+    if (pStore->pTimes) {
+        /* Windows in the order of their entries are the ones after the
+           oldest record, then the ones before it.  Find how many of them
+           start with an entry that comes before the time. */
+        ulFirst = ((ulOldest + TL_TIME_INDEX_RECORDS - 1) /
+            TL_TIME_INDEX_RECORDS) % ulWindows;
+        ulHigh = ulWindows;
+        while (ulLow < ulHigh) {
+            ulMiddle = ulLow + (ulHigh - ulLow) / 2;
+            w = (ulFirst + ulMiddle) % ulWindows;
+            ulEntry =
+                (w * TL_TIME_INDEX_RECORDS + ulSize - ulOldest) % ulSize;
+            if ((ulEntry < ulCount) &&
+                TL_Time_Before(pStore->pTimes[w], tTime, bAt)) {
+                ulLow = ulMiddle + 1;
+            } else {
+                ulHigh = ulMiddle;
+            }
+        }
+        /* The answer lies between the start of the last window that
+           comes before the time and the start of the next one. */
+        ulMiddle = ulLow;
+        ulLow = 0;
+        ulHigh = ulCount;
+        if (ulMiddle > 0) {
+            w = (ulFirst + ulMiddle - 1) % ulWindows;
+            ulLow =
+                ((w * TL_TIME_INDEX_RECORDS + ulSize - ulOldest) % ulSize) + 1;
+        }
+        if (ulMiddle < ulWindows) {
+            w = (ulFirst + ulMiddle) % ulWindows;
+            ulEntry =
+                (w * TL_TIME_INDEX_RECORDS + ulSize - ulOldest) % ulSize;
+            if (ulEntry < ulCount) {
+                ulHigh = ulEntry;
+            }
+        }
+    }
+    while (ulLow < ulHigh) {
+        ulMiddle = ulLow + (ulHigh - ulLow) / 2;
+        ulSlot = (ulOldest + ulMiddle) % ulSize;
+        if (TL_Time_Before(pStore->pRecords[ulSlot].Rec.tTimeStamp, tTime,
+                bAt)) {
+            ulLow = ulMiddle + 1;
+        } else {
+            ulHigh = ulMiddle;
+        }
+    }
+
+    return ulLow;
+}
+
+/* Keep the logs in files in the directory, or in RAM if it is NULL or
+ * empty.  Only takes effect if called before Trend_Log_Init().
+ */
+bool Trend_Log_Storage_Set(
+    const char *directory)
+{
+    if (!directory) {
+        directory = "";
+    }
+    if (strlen(directory) >= sizeof(TL_Store_Directory)) {
+        return false;
+    }
+    strcpy(TL_Store_Directory, directory);
+
+    return true;
+}
+
+uint32_t Trend_Log_Buffer_Size(
+    uint32_t object_instance)
+{
+    unsigned index = Trend_Log_Instance_To_Index(object_instance);
+
+    if (index < MAX_TREND_LOGS) {
+        return LogInfo[index].ulBufferSize;
+    }
+
+    return 0;
+}
+
+/* A new Buffer_Size empties the log */
+bool Trend_Log_Buffer_Size_Set(
+    uint32_t object_instance,
+    uint32_t buffer_size)
+{
+    unsigned index = Trend_Log_Instance_To_Index(object_instance);
+    uint32_t ulOldSize;
+
+    if ((index >= MAX_TREND_LOGS) || (buffer_size == 0) ||
+        (buffer_size > TL_MAX_BUFFER_SIZE)) {
+        return false;
+    }
+    ulOldSize = LogInfo[index].ulBufferSize;
+    if (buffer_size == ulOldSize) {
+        return true;
+    }
+    if (!TL_Purge(index, buffer_size)) {
+        TL_Purge(index, ulOldSize);
+        return false;
+    }
+
+    return true;
+}
+
 /*
  * Things to do when starting up the stack for Trend Logs.
  * Should be called whenever we reset the device or power it up
@@ -167,55 +965,18 @@ unsigned Trend_Log_Instance_To_Index(
 void Trend_Log_Init(
     void)
 {
-    static bool initialized = false;
     int iLog;
     int iEntry;
     struct tm TempTime;
     time_t tClock;
+    TL_DATA_REC TempRec;
 
-    if (!initialized) {
-        initialized = true;
+    if (!TL_Initialized) {
+        TL_Initialized = true;
 
         /* initialize all the values */
 
         for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
-            /*
-             * Do we need to do anything here?
-             * Trend logs are usually assumed to survive over resets
-             * and are frequently implemented using Battery Backed RAM
-             * If they are implemented using Flash or SD cards or some
-             * such mechanism there may be some RAM based setup needed
-             * for log management purposes.
-             * We probably need to look at inserting LOG_INTERRUPTED
-             * entries into any active logs if the power down or reset
-             * may have caused us to miss readings.
-             */
-
-            /* We will just fill the logs with some entries for testing
-             * purposes.
-             */
-            TempTime.tm_year = 109;
-            TempTime.tm_mon = iLog + 1; /* Different month for each log */
-            TempTime.tm_mday = 1;
-            TempTime.tm_hour = 0;
-            TempTime.tm_min = 0;
-            TempTime.tm_sec = 0;
-            tClock = mktime(&TempTime);
-
-            for (iEntry = 0; iEntry < TL_MAX_ENTRIES; iEntry++) {
-                Logs[iLog][iEntry].tTimeStamp = tClock;
-                Logs[iLog][iEntry].ucRecType = TL_TYPE_REAL;
-                Logs[iLog][iEntry].Datum.fReal =
-                    (float) (iEntry + (iLog * TL_MAX_ENTRIES));
-                /* Put status flags with every second log */
-                if ((iLog & 1) == 0)
-                    Logs[iLog][iEntry].ucStatus = 128;
-                else
-                    Logs[iLog][iEntry].ucStatus = 0;
-                tClock += 900;  /* advance 15 minutes */
-            }
-
-            LogInfo[iLog].tLastDataTime = tClock - 900;
             LogInfo[iLog].bAlignIntervals = true;
             LogInfo[iLog].bEnable = true;
             LogInfo[iLog].bStopWhenFull = false;
@@ -224,10 +985,9 @@ void Trend_Log_Init(
             LogInfo[iLog].Source.arrayIndex = 0;
             LogInfo[iLog].ucTimeFlags = 0;
             LogInfo[iLog].ulIntervalOffset = 0;
-            LogInfo[iLog].iIndex = 0;
             LogInfo[iLog].ulLogInterval = 900;
-            LogInfo[iLog].ulRecordCount = TL_MAX_ENTRIES;
-            LogInfo[iLog].ulTotalRecordCount = 10000;
+            LogInfo[iLog].ulBufferSize = TL_MAX_ENTRIES;
+            LogInfo[iLog].tLastDataTime = 0;
 
             LogInfo[iLog].Source.deviceIdentifier.instance =
                 Device_Object_Instance_Number();
@@ -245,13 +1005,84 @@ void Trend_Log_Init(
                 59, 99);
             LogInfo[iLog].tStopTime =
                 TL_BAC_Time_To_Local(&LogInfo[iLog].StopTime);
+
+            LogStore[iLog].iFile = -1;
+            if (!TL_Store_Open(iLog, false)) {
+                continue;
+            }
+            if (LogStore[iLog].pMap) {
+                /*
+                 * The log survived the reset in its file.  Carry on from
+                 * the last reading, and note that we may have missed some.
+                 */
+                if (LogInfo[iLog].ulRecordCount > 0) {
+                    LogInfo[iLog].tLastDataTime =
+                        TL_Record(iLog,
+                        LogInfo[iLog].ulRecordCount)->tTimeStamp;
+                    TL_Insert_Status_Rec(iLog, LOG_STATUS_LOG_INTERRUPTED,
+                        true);
+                }
+                continue;
+            }
+
+            /* We will just fill the logs in RAM with some entries for
+             * testing purposes.
+             */
+            TempTime.tm_year = 109;
+            TempTime.tm_mon = iLog + 1; /* Different month for each log */
+            TempTime.tm_mday = 1;
+            TempTime.tm_hour = 0;
+            TempTime.tm_min = 0;
+            TempTime.tm_sec = 0;
+            TempTime.tm_isdst = -1;
+            tClock = mktime(&TempTime);
+
+            LogInfo[iLog].ulTotalRecordCount = 10000 - TL_MAX_ENTRIES;
+            memset(&TempRec, 0, sizeof(TempRec));
+            for (iEntry = 0; iEntry < TL_MAX_ENTRIES; iEntry++) {
+                TempRec.tTimeStamp = tClock;
+                TempRec.ucRecType = TL_TYPE_REAL;
+                TempRec.Datum.fReal =
+                    (float) (iEntry + (iLog * TL_MAX_ENTRIES));
+                /* Put status flags with every second log */
+                if ((iLog & 1) == 0)
+                    TempRec.ucStatus = 128;
+                else
+                    TempRec.ucStatus = 0;
+                TL_Store_Append(iLog, &TempRec);
+                tClock += 900;  /* advance 15 minutes */
+            }
+
+            LogInfo[iLog].tLastDataTime = tClock - 900;
         }
+        /* the logs are scheduled by the next trend_log_timer() */
+        TL_Clock_Valid = false;
+        TL_Remote_Reset();
     }
 
     return;
 }
 
-
+/*
+ * Things to do when shutting down, or before starting up again.
+ */
+void Trend_Log_Cleanup(
+    void)
+{
+    int iLog;
+
+    if (TL_Initialized) {
+        for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+            TL_Store_Close(iLog);
+        }
+        TL_Initialized = false;
+        TL_Clock_Valid = false;
+        memset(LogSched, 0, sizeof(LogSched));
+        TL_Remote_Reset();
+    }
+}
+
+
 /*
  * Note: we use the instance number here and build the name based
  * on the assumption that there is a 1 to 1 correspondance. If there
@@ -322,7 +1153,9 @@ int Trend_Log_Read_Property(
             break;
 
         case PROP_BUFFER_SIZE:
-            apdu_len = encode_application_unsigned(&apdu[0], TL_MAX_ENTRIES);
+            apdu_len =
+                encode_application_unsigned(&apdu[0],
+                CurrentLog->ulBufferSize);
             break;
 
         case PROP_LOG_BUFFER:
@@ -488,7 +1321,7 @@ bool Trend_Log_Write_Property(
                 /* Section 12.25.5 can't enable a full log with stop when full set */
                 if ((CurrentLog->bEnable == false) &&
                     (CurrentLog->bStopWhenFull == true) &&
-                    (CurrentLog->ulRecordCount == TL_MAX_ENTRIES) &&
+                    (CurrentLog->ulRecordCount == CurrentLog->ulBufferSize) &&
                     (value.type.Boolean == true)) {
                     status = false;
                     wp_data->error_class = ERROR_CLASS_OBJECT;
@@ -502,6 +1335,7 @@ bool Trend_Log_Write_Property(
                     CurrentLog->bEnable = value.type.Boolean;
                     /* To do: what actions do we need to take on writing ? */
                     if (value.type.Boolean == false) {
+                        TL_Remote_Cancel(log_index);
                         if (bEffectiveEnable == true) {
                             /* Only insert record if we really were
                                enabled i.e. times and enable flags */
@@ -531,13 +1365,14 @@ bool Trend_Log_Write_Property(
                     CurrentLog->bStopWhenFull = value.type.Boolean;
 
                     if ((value.type.Boolean == true) &&
-                        (CurrentLog->ulRecordCount == TL_MAX_ENTRIES) &&
+                        (CurrentLog->ulRecordCount == CurrentLog->ulBufferSize) &&
                         (CurrentLog->bEnable == true)) {
 
                         /* When full log is switched from normal to stop when full
                          * disable the log and record the fact - see 135-2008 12.25.12
                          */
                         CurrentLog->bEnable = false;
+                        TL_Remote_Cancel(log_index);
                         TL_Insert_Status_Rec(log_index,
                             LOG_STATUS_LOG_DISABLED, true);
                     }
@@ -546,12 +1381,29 @@ bool Trend_Log_Write_Property(
             break;
 
         case PROP_BUFFER_SIZE:
-            /* Fixed size buffer so deny write. If buffer size was writable
-             * we would probably erase the current log, resize, re-initalise
-             * and carry on - however write is not allowed if enable is true.
+            /* A new size erases the current log, and is only allowed
+             * while the log is not enabled.
              */
-            wp_data->error_class = ERROR_CLASS_PROPERTY;
-            wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
+            status =
+                WPValidateArgType(&value, BACNET_APPLICATION_TAG_UNSIGNED_INT,
+                &wp_data->error_class, &wp_data->error_code);
+            if (status) {
+                if (CurrentLog->bEnable == true) {
+                    status = false;
+                    wp_data->error_class = ERROR_CLASS_PROPERTY;
+                    wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
+                } else if ((value.type.Unsigned_Int == 0) ||
+                    (value.type.Unsigned_Int > TL_MAX_BUFFER_SIZE)) {
+                    status = false;
+                    wp_data->error_class = ERROR_CLASS_PROPERTY;
+                    wp_data->error_code = ERROR_CODE_VALUE_OUT_OF_RANGE;
+                } else if (!Trend_Log_Buffer_Size_Set(wp_data->object_instance,
+                        value.type.Unsigned_Int)) {
+                    status = false;
+                    wp_data->error_class = ERROR_CLASS_RESOURCES;
+                    wp_data->error_code = ERROR_CODE_NO_SPACE_TO_WRITE_PROPERTY;
+                }
+            }
             break;
 
         case PROP_RECORD_COUNT:
@@ -561,10 +1413,7 @@ bool Trend_Log_Write_Property(
             if (status) {
                 if (value.type.Unsigned_Int == 0) {
                     /* Time to clear down the log */
-                    CurrentLog->ulRecordCount = 0;
-                    CurrentLog->iIndex = 0;
-                    TL_Insert_Status_Rec(log_index, LOG_STATUS_BUFFER_PURGED,
-                        true);
+                    TL_Purge(log_index, CurrentLog->ulBufferSize);
                 }
             }
             break;
@@ -577,7 +1426,12 @@ bool Trend_Log_Write_Property(
                 WPValidateArgType(&value, BACNET_APPLICATION_TAG_ENUMERATED,
                 &wp_data->error_class, &wp_data->error_code);
             if (status) {
-                if (value.type.Enumerated != LOGGING_TYPE_COV) {
+                if ((value.type.Enumerated != LOGGING_TYPE_COV) ||
+                    TL_Is_Remote(&CurrentLog->Source)) {
+                    if (CurrentLog->LoggingType != value.type.Enumerated) {
+                        /* forget the reading or subscription of the old */
+                        TL_Remote_Cancel(log_index);
+                    }
                     CurrentLog->LoggingType = value.type.Enumerated;
                     if (value.type.Enumerated == LOGGING_TYPE_POLLED) {
                         /* As per 12.25.27 pick a suitable default if interval is 0 */
@@ -589,8 +1443,13 @@ bool Trend_Log_Write_Property(
                         /* As per 12.25.27 0 the interval if triggered logging selected */
                         CurrentLog->ulLogInterval = 0;
                     }
+                    if (value.type.Enumerated == LOGGING_TYPE_COV) {
+                        /* Subscribe to the source from the next tick */
+                        CurrentLog->ulLogInterval = 0;
+                        LogRemote[log_index].tRenew = 0;
+                    }
                 } else {
-                    /* We don't currently support COV */
+                    /* We only support COV of objects in other devices */
                     status = false;
                     wp_data->error_class = ERROR_CLASS_PROPERTY;
                     wp_data->error_code =
@@ -712,8 +1571,8 @@ bool Trend_Log_Write_Property(
                 break;
                 }
 
-            // We only support references to objects in ourself for now
-            if((TempSource.deviceIdentifier.type == OBJECT_DEVICE) && (TempSource.deviceIdentifier.instance != Device_Object_Instance_Number()))
+            // A COV log can only subscribe to objects in other devices
+            if((CurrentLog->LoggingType == LOGGING_TYPE_COV) && !TL_Is_Remote(&TempSource))
                 	{
                     wp_data->error_class = ERROR_CLASS_PROPERTY;
                     wp_data->error_code = ERROR_CODE_OPTIONAL_FUNCTIONALITY_NOT_SUPPORTED;
@@ -724,10 +1583,9 @@ bool Trend_Log_Write_Property(
             if (memcmp(&TempSource, &CurrentLog->Source,
                     sizeof(BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE)) != 0) {
                 /* Clear buffer if property being logged is changed */
-                CurrentLog->ulRecordCount = 0;
-                CurrentLog->iIndex = 0;
-                TL_Insert_Status_Rec(log_index, LOG_STATUS_BUFFER_PURGED,
-                    true);
+                TL_Purge(log_index, CurrentLog->ulBufferSize);
+                /* and forget any reading or subscription of the old one */
+                TL_Remote_Cancel(log_index);
             }
             CurrentLog->Source = TempSource;
             status = true;
@@ -806,6 +1664,10 @@ bool Trend_Log_Write_Property(
             wp_data->error_code = ERROR_CODE_WRITE_ACCESS_DENIED;
             break;
     }
+    if (status) {
+        /* the next reading may be due at another time now */
+        TL_Schedule(log_index);
+    }
 
     return status;
 }
@@ -844,11 +1706,9 @@ void TL_Insert_Status_Rec(
     BACNET_LOG_STATUS eStatus,
     bool bState)
 {
-    TL_LOG_INFO *CurrentLog;
     TL_DATA_REC TempRec;
 
-    CurrentLog = &LogInfo[iLog];
-
+    memset(&TempRec, 0, sizeof(TempRec));
     TempRec.tTimeStamp = time(NULL);
     TempRec.ucRecType = TL_TYPE_STATUS;
     TempRec.ucStatus = 0;
@@ -871,14 +1731,7 @@ void TL_Insert_Status_Rec(
             break;
     }
 
-    Logs[iLog][CurrentLog->iIndex++] = TempRec;
-    if (CurrentLog->iIndex >= TL_MAX_ENTRIES)
-        CurrentLog->iIndex = 0;
-
-    CurrentLog->ulTotalRecordCount++;
-
-    if (CurrentLog->ulRecordCount < TL_MAX_ENTRIES)
-        CurrentLog->ulRecordCount++;
+    TL_Store_Append(iLog, &TempRec);
 }
 
 /*****************************************************************************
@@ -969,6 +1822,8 @@ time_t TL_BAC_Time_To_Local(
     LocalTime.tm_hour = SourceTime->time.hour;
     LocalTime.tm_min = SourceTime->time.min;
     LocalTime.tm_sec = SourceTime->time.sec;
+    /* let the library work out if daylight saving applies */
+    LocalTime.tm_isdst = -1;
 
     return (mktime(&LocalTime));
 }
@@ -1069,7 +1924,7 @@ int TL_encode_by_position(
     uint32_t uiRemaining = 0;   /* Amount of unused space in packet */
 
     /* See how much space we have */
-    uiRemaining = MAX_APDU - pRequest->Overhead;
+    uiRemaining = pRequest->MaxApdu - pRequest->Overhead;
     log_index = Trend_Log_Instance_To_Index(pRequest->object_instance);
     CurrentLog = &LogInfo[log_index];
     if (pRequest->RequestType == RR_READ_ALL) {
@@ -1179,7 +2034,7 @@ int TL_encode_by_sequence(
     bool bWrapLog = false;      /* Has log sequence range spanned the max for uint32_t? */
 
     /* See how much space we have */
-    uiRemaining = MAX_APDU - pRequest->Overhead;
+    uiRemaining = pRequest->MaxApdu - pRequest->Overhead;
     log_index = Trend_Log_Instance_To_Index(pRequest->object_instance);
     CurrentLog = &LogInfo[log_index];
     /* Figure out the sequence number for the first record, last is ulTotalRecordCount */
@@ -1288,6 +2143,7 @@ int TL_encode_by_sequence(
 
 /****************************************************************************
  * Handle encoding for the By Time option.                                  *
+ * The starting point is found with a binary search of the time stamps.    *
  * The fact that the buffer always has at least a single entry is used      *
  * implicetly in the following as we don't have to handle the case of an    *
  * empty buffer.                                                            *
@@ -1311,34 +2167,23 @@ int TL_encode_by_time(
     time_t tRefTime = 0;        /* The time from the request in local format */
 
     /* See how much space we have */
-    uiRemaining = MAX_APDU - pRequest->Overhead;
+    uiRemaining = pRequest->MaxApdu - pRequest->Overhead;
     log_index = Trend_Log_Instance_To_Index(pRequest->object_instance);
     CurrentLog = &LogInfo[log_index];
 
     tRefTime = TL_BAC_Time_To_Local(&pRequest->Range.RefTime);
-    /* Find correct position for oldest entry in log */
-    if (CurrentLog->ulRecordCount < TL_MAX_ENTRIES)
-        uiIndex = 0;
-    else
-        uiIndex = CurrentLog->iIndex;
 
+    /* Figure out the sequence number for the first record, last is ulTotalRecordCount */
+    uiFirstSeq =
+        CurrentLog->ulTotalRecordCount - (CurrentLog->ulRecordCount - 1);
     if (pRequest->Count < 0) {
-        /* Start at end of log and look for record which has
-         * timestamp greater than or equal to the reference.
+        /* Look for the last record which has a timestamp
+         * less than the reference.
          */
-        iCount = CurrentLog->ulRecordCount - 1;
-        /* Start out with the sequence number for the last record */
-        uiFirstSeq = CurrentLog->ulTotalRecordCount;
-        for (;;) {
-            if (Logs[pRequest->object_instance][(uiIndex +
-                        iCount) % TL_MAX_ENTRIES].tTimeStamp < tRefTime)
-                break;
-
-            uiFirstSeq--;
-            iCount--;
-            if (iCount < 0)
-                return (0);
-        }
+        iCount = TL_Entries_Before(log_index, tRefTime, false) - 1;
+        if (iCount < 0)
+            return (0);
+        uiFirstSeq += iCount;
 
         /* We have an and point for our request,
          * now work backwards to find where we should start from
@@ -1360,23 +2205,13 @@ int TL_encode_by_time(
             iCount -= iTemp;
         }
     } else {
-        /* Start at beginning of log and look for 1st record which has
-         * timestamp greater than the reference time.
+        /* Look for the 1st record which has a timestamp
+         * greater than the reference time.
          */
-        iCount = 0;
-        /* Figure out the sequence number for the first record, last is ulTotalRecordCount */
-        uiFirstSeq =
-            CurrentLog->ulTotalRecordCount - (CurrentLog->ulRecordCount - 1);
-        for (;;) {
-            if (Logs[pRequest->object_instance][(uiIndex +
-                        iCount) % TL_MAX_ENTRIES].tTimeStamp > tRefTime)
-                break;
-
-            uiFirstSeq++;
-            iCount++;
-            if ((uint32_t) iCount == CurrentLog->ulRecordCount)
-                return (0);
-        }
+        iCount = TL_Entries_Before(log_index, tRefTime, true);
+        if ((uint32_t) iCount == CurrentLog->ulRecordCount)
+            return (0);
+        uiFirstSeq += iCount;
     }
 
     /* We now have a starting point for the operation and a +ve count */
@@ -1433,14 +2268,7 @@ int TL_encode_entry(
     uint8_t ucCount = 0;
     BACNET_DATE_TIME TempTime;
 
-    /* Convert from BACnet 1 based to 0 based array index and then
-     * handle wrap around of the circular buffer */
-
-    if (LogInfo[iLog].ulRecordCount < TL_MAX_ENTRIES)
-        pSource = &Logs[iLog][(iEntry - 1) % TL_MAX_ENTRIES];
-    else
-        pSource =
-            &Logs[iLog][(LogInfo[iLog].iIndex + iEntry - 1) % TL_MAX_ENTRIES];
+    pSource = TL_Record(iLog, iEntry);
 
     iLen = 0;
     /* First stick the time stamp in with tag [0] */
@@ -1590,19 +2418,129 @@ static int local_read_property(
     return (len);
 }
 
+/* Store a bit string in a record, truncated at 32 bits to save space */
+static void TL_Bits_To_Record(
+    TL_DATA_REC * pRec,
+    BACNET_BIT_STRING * pBits)
+{
+    uint8_t ucCount;
+
+    pRec->ucRecType = TL_TYPE_BITS;
+    if (bitstring_bits_used(pBits) < 32) {
+        /* Store the bytes used and the bits free in the last byte */
+        pRec->Datum.Bits.ucLen = bitstring_bytes_used(pBits) << 4;
+        pRec->Datum.Bits.ucLen |= (8 - (bitstring_bits_used(pBits) % 8)) & 7;
+        /* Fetch the octets with the bits directly */
+        for (ucCount = 0; ucCount < bitstring_bytes_used(pBits); ucCount++)
+            pRec->Datum.Bits.ucStore[ucCount] =
+                bitstring_octet(pBits, ucCount);
+    } else {
+        /* We will only use the first 4 octets to save space */
+        pRec->Datum.Bits.ucLen = 4 << 4;
+        for (ucCount = 0; ucCount < 4; ucCount++)
+            pRec->Datum.Bits.ucStore[ucCount] =
+                bitstring_octet(pBits, ucCount);
+    }
+}
+
+/* Store a value in a record, or the error for a type we cannot log */
+static void TL_Value_To_Record(
+    TL_DATA_REC * pRec,
+    BACNET_APPLICATION_DATA_VALUE * pValue)
+{
+    switch (pValue->tag) {
+        case BACNET_APPLICATION_TAG_NULL:
+            pRec->ucRecType = TL_TYPE_NULL;
+            break;
+        case BACNET_APPLICATION_TAG_BOOLEAN:
+            pRec->ucRecType = TL_TYPE_BOOL;
+            pRec->Datum.ucBoolean = pValue->type.Boolean;
+            break;
+        case BACNET_APPLICATION_TAG_UNSIGNED_INT:
+            pRec->ucRecType = TL_TYPE_UNSIGN;
+            pRec->Datum.ulUValue = pValue->type.Unsigned_Int;
+            break;
+        case BACNET_APPLICATION_TAG_SIGNED_INT:
+            pRec->ucRecType = TL_TYPE_SIGN;
+            pRec->Datum.lSValue = pValue->type.Signed_Int;
+            break;
+        case BACNET_APPLICATION_TAG_REAL:
+            pRec->ucRecType = TL_TYPE_REAL;
+            pRec->Datum.fReal = pValue->type.Real;
+            break;
+        case BACNET_APPLICATION_TAG_BIT_STRING:
+            TL_Bits_To_Record(pRec, &pValue->type.Bit_String);
+            break;
+        case BACNET_APPLICATION_TAG_ENUMERATED:
+            pRec->ucRecType = TL_TYPE_ENUM;
+            pRec->Datum.ulEnum = pValue->type.Enumerated;
+            break;
+        default:
+            /* Fake an error response for any types we cannot handle */
+            pRec->Datum.Error.usClass = ERROR_CLASS_PROPERTY;
+            pRec->Datum.Error.usCode = ERROR_CODE_DATATYPE_NOT_SUPPORTED;
+            pRec->ucRecType = TL_TYPE_ERROR;
+            break;
+    }
+}
+
+/* The Present_Value and Status_Flags that an object gives for COV, as
+   values, so that the properties most logs are of are read without
+   being encoded and decoded again. */
+static BACNET_PROPERTY_VALUE TL_Value_List[2];
+/* for any other property, as read by Device_Read_Property() - a big
+   buffer in case someone selects the device object list for example */
+static uint8_t TL_Value_Buffer[MAX_APDU];
+
+static bool TL_Value_List_Read(
+    BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE * Source,
+    TL_DATA_REC * pRec)
+{
+    BACNET_PROPERTY_VALUE *pValue;
+    BACNET_PROPERTY_VALUE *pFound = NULL;
+    BACNET_PROPERTY_VALUE *pStatus = NULL;
+
+    if (((Source->propertyIdentifier != PROP_PRESENT_VALUE) &&
+            (Source->propertyIdentifier != PROP_STATUS_FLAGS)) ||
+        (Source->arrayIndex != BACNET_ARRAY_ALL)) {
+        return false;
+    }
+    TL_Value_List[0].next = &TL_Value_List[1];
+    TL_Value_List[1].next = NULL;
+    if (!Device_Encode_Value_List(Source->objectIdentifier.type,
+            Source->objectIdentifier.instance, &TL_Value_List[0])) {
+        return false;
+    }
+    for (pValue = &TL_Value_List[0]; pValue; pValue = pValue->next) {
+        if (pValue->propertyIdentifier == Source->propertyIdentifier) {
+            pFound = pValue;
+        }
+        if (pValue->propertyIdentifier == PROP_STATUS_FLAGS) {
+            pStatus = pValue;
+        }
+    }
+    if ((pFound == NULL) || (pStatus == NULL) ||
+        (pStatus->value.tag != BACNET_APPLICATION_TAG_BIT_STRING)) {
+        return false;
+    }
+    TL_Value_To_Record(pRec, &pFound->value);
+    pRec->ucStatus = 128 | bitstring_octet(&pStatus->value.type.Bit_String, 0);
+
+    return true;
+}
+
 /****************************************************************************
  * Attempt to fetch the logged property and store it in the Trend Log       *
  ****************************************************************************/
 
 static void TL_fetch_property(
-    int iLog)
+    int iLog,
+    time_t tNow)
 {
-    uint8_t ValueBuf[MAX_APDU]; /* This is a big buffer in case someone selects the device object list for example */
     uint8_t StatusBuf[3];       /* Should be tag, bits unused in last octet and 1 byte of data */
     BACNET_ERROR_CLASS error_class = ERROR_CLASS_SERVICES;
     BACNET_ERROR_CODE error_code = ERROR_CODE_OTHER;
     int iLen;
-    uint8_t ucCount;
     TL_LOG_INFO *CurrentLog;
     TL_DATA_REC TempRec;
     uint8_t tag_number = 0;
@@ -1613,12 +2551,18 @@ static void TL_fetch_property(
 
     /* Record the current time in the log entry and also in the info block
      * for the log so we can figure out when the next reading is due */
-    TempRec.tTimeStamp = time(NULL);
+    memset(&TempRec, 0, sizeof(TempRec));
+    TempRec.tTimeStamp = tNow;
     CurrentLog->tLastDataTime = TempRec.tTimeStamp;
     TempRec.ucStatus = 0;
 
+    if (TL_Value_List_Read(&CurrentLog->Source, &TempRec)) {
+        TL_Stats.fast_samples++;
+        TL_Store_Append(iLog, &TempRec);
+        return;
+    }
     iLen =
-        local_read_property(ValueBuf, StatusBuf, &LogInfo[iLog].Source,
+        local_read_property(TL_Value_Buffer, StatusBuf, &CurrentLog->Source,
         &error_class, &error_code);
     if (iLen < 0) {
         /* Insert error code into log */
@@ -1628,7 +2572,7 @@ static void TL_fetch_property(
     } else {
         /* Decode data returned and see if we can fit it into the log */
         iLen =
-            decode_tag_number_and_value(ValueBuf, &tag_number,
+            decode_tag_number_and_value(TL_Value_Buffer, &tag_number,
             &len_value_type);
         switch (tag_number) {
             case BACNET_APPLICATION_TAG_NULL:
@@ -1642,49 +2586,31 @@ static void TL_fetch_property(
 
             case BACNET_APPLICATION_TAG_UNSIGNED_INT:
                 TempRec.ucRecType = TL_TYPE_UNSIGN;
-                decode_unsigned(&ValueBuf[iLen], len_value_type,
+                decode_unsigned(&TL_Value_Buffer[iLen], len_value_type,
                     &TempRec.Datum.ulUValue);
                 break;
 
             case BACNET_APPLICATION_TAG_SIGNED_INT:
                 TempRec.ucRecType = TL_TYPE_SIGN;
-                decode_signed(&ValueBuf[iLen], len_value_type,
+                decode_signed(&TL_Value_Buffer[iLen], len_value_type,
                     &TempRec.Datum.lSValue);
                 break;
 
             case BACNET_APPLICATION_TAG_REAL:
                 TempRec.ucRecType = TL_TYPE_REAL;
-                decode_real_safe(&ValueBuf[iLen], len_value_type,
+                decode_real_safe(&TL_Value_Buffer[iLen], len_value_type,
                     &TempRec.Datum.fReal);
                 break;
 
             case BACNET_APPLICATION_TAG_BIT_STRING:
-                TempRec.ucRecType = TL_TYPE_BITS;
-                decode_bitstring(&ValueBuf[iLen], len_value_type, &TempBits);
-                /* We truncate any bitstrings at 32 bits to conserve space */
-                if (bitstring_bits_used(&TempBits) < 32) {
-                    /* Store the bytes used and the bits free in the last byte */
-                    TempRec.Datum.Bits.ucLen =
-                        bitstring_bytes_used(&TempBits) << 4;
-                    TempRec.Datum.Bits.ucLen |=
-                        (8 - (bitstring_bits_used(&TempBits) % 8)) & 7;
-                    /* Fetch the octets with the bits directly */
-                    for (ucCount = 0;
-                        ucCount < bitstring_bytes_used(&TempBits); ucCount++)
-                        TempRec.Datum.Bits.ucStore[ucCount] =
-                            bitstring_octet(&TempBits, ucCount);
-                } else {
-                    /* We will only use the first 4 octets to save space */
-                    TempRec.Datum.Bits.ucLen = 4 << 4;
-                    for (ucCount = 0; ucCount < 4; ucCount++)
-                        TempRec.Datum.Bits.ucStore[ucCount] =
-                            bitstring_octet(&TempBits, ucCount);
-                }
+                decode_bitstring(&TL_Value_Buffer[iLen], len_value_type,
+                    &TempBits);
+                TL_Bits_To_Record(&TempRec, &TempBits);
                 break;
 
             case BACNET_APPLICATION_TAG_ENUMERATED:
                 TempRec.ucRecType = TL_TYPE_ENUM;
-                decode_enumerated(&ValueBuf[iLen], len_value_type,
+                decode_enumerated(&TL_Value_Buffer[iLen], len_value_type,
                     &TempRec.Datum.ulEnum);
                 break;
 
@@ -1703,82 +2629,2292 @@ static void TL_fetch_property(
         TempRec.ucStatus = 128 | bitstring_octet(&TempBits, 0);
     }
 
-    Logs[iLog][CurrentLog->iIndex++] = TempRec;
-    if (CurrentLog->iIndex >= TL_MAX_ENTRIES)
-        CurrentLog->iIndex = 0;
+    TL_Store_Append(iLog, &TempRec);
+}
 
-    CurrentLog->ulTotalRecordCount++;
+/* true if the source is an object in another device */
+static bool TL_Is_Remote(
+    BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE * Source)
+{
+    return (Source->deviceIdentifier.type == OBJECT_DEVICE) &&
+        (Source->deviceIdentifier.instance != Device_Object_Instance_Number());
+}
 
-    if (CurrentLog->ulRecordCount < TL_MAX_ENTRIES)
-        CurrentLog->ulRecordCount++;
+/* The points of a remote reading: the property, and the Status_Flags
+   of its object unless that is the property */
+static uint8_t TL_Remote_Points(
+    BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE * Source)
+{
+    if ((Source->propertyIdentifier == PROP_STATUS_FLAGS) &&
+        (Source->arrayIndex == BACNET_ARRAY_ALL)) {
+        return 1;
+    }
+
+    return 2;
 }
 
-/****************************************************************************
- * Check each log to see if any data needs to be recorded.                  *
- ****************************************************************************/
+static void TL_Error_Append(
+    int iLog,
+    time_t tTime,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code)
+{
+    TL_DATA_REC TempRec;
 
-void trend_log_timer(
-    uint16_t uSeconds)
+    memset(&TempRec, 0, sizeof(TempRec));
+    TempRec.tTimeStamp = tTime;
+    TempRec.ucRecType = TL_TYPE_ERROR;
+    TempRec.Datum.Error.usClass = error_class;
+    TempRec.Datum.Error.usCode = error_code;
+    TL_Store_Append(iLog, &TempRec);
+}
+
+/* Puts a result of a remote reading in the record, and logs the record
+   once it has all of them.  The point is the log times two, plus one
+   for the Status_Flags of its object. */
+static void TL_Remote_Value(
+    uint32_t device_id,
+    unsigned point,
+    BACNET_PROPERTY_REFERENCE * reference)
 {
-    TL_LOG_INFO *CurrentLog = NULL;
-    int iCount = 0;
-    time_t tNow = 0;
+    BACNET_APPLICATION_DATA_VALUE *pValue = reference->value;
+    TL_REMOTE *pRemote;
+    int iLog = (int) (point / 2);
 
-    /* unused parameter */
-    uSeconds = uSeconds;
-    /* use OS to get the current time */
-    tNow = time(NULL);
-    for (iCount = 0; iCount < MAX_TREND_LOGS; iCount++) {
-        CurrentLog = &LogInfo[iCount];
-        if (TL_Is_Enabled(iCount)) {
-            if (CurrentLog->LoggingType == LOGGING_TYPE_POLLED) {
-                /* For polled logs we first need to see if they are clock
-                 * aligned or not.
-                 */
-                if (CurrentLog->bAlignIntervals == true) {
-                    /* Aligned logging so use the combination of the interval
-                     * and the offset to decide when to log. Also log a reading if
-                     * more than interval time has elapsed since last reading to ensure
-                     * we don't miss a reading if we aren't called at the precise second
-                     * when the match occurrs.
-                     */
-/*                if(((tNow % CurrentLog->ulLogInterval) >= (CurrentLog->ulIntervalOffset % CurrentLog->ulLogInterval)) && */
-/*                   ((tNow - CurrentLog->tLastDataTime) >= CurrentLog->ulLogInterval)) { */
-                    if ((tNow % CurrentLog->ulLogInterval) ==
-                        (CurrentLog->ulIntervalOffset %
-                            CurrentLog->ulLogInterval)) {
-                        /* Record value if time synchronised trigger condition is met
-                         * and at least one period has elapsed.
-                         */
-                        TL_fetch_property(iCount);
-                    } else if ((tNow - CurrentLog->tLastDataTime) >
-                        CurrentLog->ulLogInterval) {
-                        /* Also record value if we have waited more than a period
-                         * since the last reading. This ensures we take a reading as
-                         * soon as possible after a power down if we have been off for
-                         * more than a single period.
-                         */
-                        TL_fetch_property(iCount);
-                    }
-                } else if (((tNow - CurrentLog->tLastDataTime) >=
-                        CurrentLog->ulLogInterval) ||
-                    (CurrentLog->bTrigger == true)) {
-                    /* If not aligned take a reading when we have either waited long
-                     * enough or a trigger is set.
-                     */
-                    TL_fetch_property(iCount);
-                }
+    (void) device_id;
+    if (iLog >= MAX_TREND_LOGS) {
+        return;
+    }
+    pRemote = &LogRemote[iLog];
+    if (pRemote->ucPoints == 0) {
+        return;
+    }
+    if (pValue && (pValue->tag == BACNET_APPLICATION_TAG_BIT_STRING) &&
+        ((point & 1) ||
+            (LogInfo[iLog].Source.propertyIdentifier == PROP_STATUS_FLAGS))) {
+        pRemote->Rec.ucStatus =
+            128 | bitstring_octet(&pValue->type.Bit_String, 0);
+    }
+    if ((point & 1) == 0) {
+        if (pValue) {
+            TL_Value_To_Record(&pRemote->Rec, pValue);
+        } else {
+            pRemote->Rec.ucRecType = TL_TYPE_ERROR;
+            pRemote->Rec.Datum.Error.usClass = reference->error.error_class;
+            pRemote->Rec.Datum.Error.usCode = reference->error.error_code;
+        }
+    }
+    pRemote->ucPoints--;
+    if (pRemote->ucPoints == 0) {
+        if (pRemote->Rec.ucRecType != TL_TYPE_ERROR) {
+            TL_Stats.replies++;
+        } else if (pRemote->Rec.Datum.Error.usCode == ERROR_CODE_TIMEOUT) {
+            TL_Stats.timeouts++;
+        } else {
+            TL_Stats.errors++;
+        }
+        TL_Store_Append(iLog, &pRemote->Rec);
+    }
+}
 
-                CurrentLog->bTrigger = false;   /* Clear this every time */
-            } else if (CurrentLog->LoggingType == LOGGING_TYPE_TRIGGERED) {
-                /* Triggered logs take a reading when the trigger is set and
-                 * then reset the trigger to wait for the next event
-                 */
-                if (CurrentLog->bTrigger == true) {
-                    TL_fetch_property(iCount);
-                    CurrentLog->bTrigger = false;
-                }
+/* Reads a remote log, with the Status_Flags of its object, in the
+   requests that the poll scheduler sends to its device */
+static void TL_Remote_Read(
+    int iLog,
+    time_t tNow)
+{
+    BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE *Source = &LogInfo[iLog].Source;
+    TL_REMOTE *pRemote = &LogRemote[iLog];
+    uint32_t device_id = Source->deviceIdentifier.instance;
+
+    /* keep to the interval, whether or not this reading is taken */
+    LogInfo[iLog].tLastDataTime = tNow;
+    if (pRemote->ucPoints) {
+        /* the last reading is still to come */
+        TL_Stats.missed++;
+        return;
+    }
+    TL_Stats.requests++;
+    if (!poll_read(device_id, Source->objectIdentifier.type,
+            Source->objectIdentifier.instance, Source->propertyIdentifier,
+            Source->arrayIndex, TL_Remote_Value, (unsigned) iLog * 2)) {
+        TL_Stats.errors++;
+        TL_Error_Append(iLog, tNow, ERROR_CLASS_RESOURCES,
+            ERROR_CODE_NO_SPACE_FOR_OBJECT);
+        return;
+    }
+    memset(&pRemote->Rec, 0, sizeof(pRemote->Rec));
+    pRemote->Rec.tTimeStamp = tNow;
+    pRemote->ucPoints = 1;
+    /* without the Status_Flags if there is no room for them */
+    if ((TL_Remote_Points(Source) > 1) &&
+        poll_read(device_id, Source->objectIdentifier.type,
+            Source->objectIdentifier.instance, PROP_STATUS_FLAGS,
+            BACNET_ARRAY_ALL, TL_Remote_Value, ((unsigned) iLog * 2) + 1)) {
+        pRemote->ucPoints = 2;
+    }
+}
+
+/* Sends the SubscribeCOV request of a log, or its cancellation, with the
+   process identifier of the log.  Returns false if it was not sent. */
+static bool TL_Subscribe_Send(
+    int iLog,
+    bool bCancel)
+{
+    BACNET_SUBSCRIBE_COV_DATA cov_data;
+    TL_SUBSCRIBE *pRequest;
+    uint32_t device_id = LogInfo[iLog].Source.deviceIdentifier.instance;
+    uint8_t invoke_id;
+
+    if ((TL_Subscribe_Count >= TL_COV_REQUESTS) ||
+        !tsm_transaction_available()) {
+        return false;
+    }
+    memset(&cov_data, 0, sizeof(cov_data));
+    cov_data.subscriberProcessIdentifier = TL_COV_PROCESS_ID + iLog;
+    cov_data.monitoredObjectIdentifier = LogInfo[iLog].Source.objectIdentifier;
+    cov_data.cancellationRequest = bCancel;
+    if (!bCancel) {
+        cov_data.issueConfirmedNotifications = false;
+        cov_data.lifetime = TL_COV_LIFETIME;
+    }
+    invoke_id = Send_COV_Subscribe(device_id, &cov_data);
+    if (invoke_id == 0) {
+        return false;
+    }
+    pRequest = &TL_Subscribes[TL_Subscribe_Count++];
+    pRequest->invoke_id = invoke_id;
+    /* no log waits on the reply to a cancellation */
+    pRequest->log = bCancel ? TL_LOG_NONE : (TL_INDEX) iLog;
+    pRequest->ulDevice = device_id;
+    TL_Stats.requests++;
+
+    return true;
+}
+
+/* Forgets the reading that a log is waiting on, and cancels its
+   subscription, so that the device stops notifying us.  Called before
+   the source or the logging type of the log is changed, and when the
+   log is disabled. */
+static void TL_Remote_Cancel(
+    int iLog)
+{
+    unsigned i;
+
+    poll_read_cancel(TL_Remote_Value, (unsigned) iLog * 2);
+    poll_read_cancel(TL_Remote_Value, ((unsigned) iLog * 2) + 1);
+    for (i = 0; i < TL_Subscribe_Count; i++) {
+        if (TL_Subscribes[i].log == iLog) {
+            TL_Subscribes[i].log = TL_LOG_NONE;
+        }
+    }
+    LogRemote[iLog].ucPoints = 0;
+    LogRemote[iLog].tRenew = 0;
+    if (LogRemote[iLog].bSubscribed) {
+        LogRemote[iLog].bSubscribed = false;
+        /* if it cannot be sent, it lapses at the end of its lifetime */
+        TL_Subscribe_Send(iLog, true);
+    }
+}
+
+static void TL_Remote_Reset(
+    void)
+{
+    unsigned i;
+    int iLog;
+
+    /* the TSM no longer waits on the replies to our requests */
+    for (i = 0; i < TL_Subscribe_Count; i++) {
+        tsm_free_invoke_id(TL_Subscribes[i].invoke_id);
+    }
+    TL_Subscribe_Count = 0;
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        if (LogRemote[iLog].ucPoints) {
+            poll_read_cancel(TL_Remote_Value, (unsigned) iLog * 2);
+            poll_read_cancel(TL_Remote_Value, ((unsigned) iLog * 2) + 1);
+        }
+    }
+    memset(LogRemote, 0, sizeof(LogRemote));
+}
+
+/* Subscribes a COV log to its object, or renews the subscription, once
+   the poll scheduler has bound its device */
+static void TL_Remote_Subscribe(
+    int iLog,
+    time_t tNow)
+{
+    TL_REMOTE *pRemote = &LogRemote[iLog];
+
+    /* try again with the next tick until it can be sent */
+    pRemote->tRenew = tNow + 1;
+    if (!poll_device_bound(LogInfo[iLog].Source.deviceIdentifier.instance)
+        || !TL_Subscribe_Send(iLog, false)) {
+        return;
+    }
+    pRemote->tRenew = tNow + (TL_COV_LIFETIME / 2);
+    pRemote->bSubscribed = true;
+}
+
+static void TL_Subscribe_Release(
+    TL_SUBSCRIBE * pRequest)
+{
+    unsigned slot = (unsigned) (pRequest - TL_Subscribes);
+
+    /* keep the slots in use packed at the start */
+    TL_Subscribe_Count--;
+    if (slot != TL_Subscribe_Count) {
+        TL_Subscribes[slot] = TL_Subscribes[TL_Subscribe_Count];
+    }
+}
+
+/* Find the subscription request that is waiting on a reply from this
+   address */
+static TL_SUBSCRIBE *TL_Subscribe_Find(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id)
+{
+    BACNET_ADDRESS dest;
+    unsigned max_apdu = 0;
+    unsigned i;
+
+    for (i = 0; i < TL_Subscribe_Count; i++) {
+        if (TL_Subscribes[i].invoke_id != invoke_id) {
+            continue;
+        }
+        if (src && address_get_by_device(TL_Subscribes[i].ulDevice,
+                &max_apdu, &dest) && !address_match(&dest, src)) {
+            return NULL;
+        }
+        return &TL_Subscribes[i];
+    }
+
+    return NULL;
+}
+
+/* Logs the error of a subscription, which is tried again later, and
+   frees its request */
+static void TL_Subscribe_Error(
+    TL_SUBSCRIBE * pRequest,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code)
+{
+    int iLog = pRequest->log;
+
+    if (pRequest->log != TL_LOG_NONE) {
+        TL_Error_Append(iLog, time(NULL), error_class, error_code);
+        LogRemote[iLog].bSubscribed = false;
+        LogRemote[iLog].tRenew = TL_Now + TL_COV_RETRY;
+        TL_Schedule(iLog);
+    }
+    TL_Subscribe_Release(pRequest);
+}
+
+/* Deals with the subscription requests that got no reply, or a
+   SimpleACK */
+static void TL_Subscribe_Task(
+    void)
+{
+    TL_SUBSCRIBE *pRequest;
+    unsigned slot;
+
+    slot = TL_Subscribe_Count;
+    while (slot > 0) {
+        slot--;
+        pRequest = &TL_Subscribes[slot];
+        if (tsm_invoke_id_failed(pRequest->invoke_id)) {
+            TL_Stats.timeouts++;
+            tsm_free_invoke_id(pRequest->invoke_id);
+            TL_Subscribe_Error(pRequest, ERROR_CLASS_COMMUNICATION,
+                ERROR_CODE_TIMEOUT);
+        } else if (tsm_invoke_id_free(pRequest->invoke_id)) {
+            TL_Stats.replies++;
+            TL_Subscribe_Release(pRequest);
+        }
+    }
+}
+
+/* Puts a log on the wheel for its due time, or for tFirst, the first
+   tick that is still to come, if it is due before then. */
+static void TL_Sched_Insert(
+    int iLog,
+    time_t tFirst)
+{
+    TL_SCHED *pSched = &LogSched[iLog];
+    time_t tDue = pSched->tDue;
+    time_t tDelta;
+    unsigned slot;
+
+    if (tDue < tFirst) {
+        tDue = tFirst;
+    }
+    tDelta = tDue - TL_Clock;
+    if (tDelta < TL_WHEEL_SIZE) {
+        slot = TL_WHEEL_SLOT(tDue, 0);
+    } else if (tDelta < (1L << (2 * TL_WHEEL_BITS))) {
+        slot = TL_WHEEL_SLOT(tDue, 1);
+    } else {
+        if (tDelta >= (1L << (3 * TL_WHEEL_BITS))) {
+            /* wait in the last slot of the top level */
+            tDue = TL_Clock + (1L << (3 * TL_WHEEL_BITS)) - 1;
+        }
+        slot = TL_WHEEL_SLOT(tDue, 2);
+    }
+    pSched->prev = 0;
+    pSched->next = TL_Wheel[slot];
+    if (pSched->next) {
+        LogSched[pSched->next - 1].prev = iLog + 1;
+    }
+    TL_Wheel[slot] = iLog + 1;
+    pSched->ucSlot = (uint8_t) (slot + 1);
+    TL_Sched_Count++;
+}
+
+static void TL_Sched_Remove(
+    int iLog)
+{
+    TL_SCHED *pSched = &LogSched[iLog];
+
+    if (pSched->ucSlot == 0) {
+        return;
+    }
+    if (pSched->prev) {
+        LogSched[pSched->prev - 1].next = pSched->next;
+    } else {
+        TL_Wheel[pSched->ucSlot - 1] = pSched->next;
+    }
+    if (pSched->next) {
+        LogSched[pSched->next - 1].prev = pSched->prev;
+    }
+    pSched->next = 0;
+    pSched->prev = 0;
+    pSched->ucSlot = 0;
+    TL_Sched_Count--;
+}
+
+/* moves the logs of a slot down to the lower levels */
+static void TL_Sched_Cascade(
+    unsigned slot)
+{
+    TL_INDEX next = TL_Wheel[slot];
+    TL_INDEX index;
+
+    TL_Wheel[slot] = 0;
+    while (next) {
+        index = next - 1;
+        next = LogSched[index].next;
+        LogSched[index].ucSlot = 0;
+        TL_Sched_Count--;
+        /* the slot of this tick is still to be run */
+        TL_Sched_Insert(index, TL_Clock);
+    }
+}
+
+/* Works out when the next reading of a log is due, no earlier than
+   tBase, from the same rules as TL_Is_Enabled(); or returns zero if
+   the log is not going to take one unless it is written to. */
+static time_t TL_Next_Due(
+    int iLog,
+    time_t tBase)
+{
+    TL_LOG_INFO *CurrentLog = &LogInfo[iLog];
+    time_t tInterval = CurrentLog->ulLogInterval;
+    time_t tDue;
+
+    if (CurrentLog->bEnable == false) {
+        return 0;
+    }
+    if ((CurrentLog->ucTimeFlags == 0) &&
+        (CurrentLog->tStopTime < CurrentLog->tStartTime)) {
+        return 0;
+    }
+    if (((CurrentLog->ucTimeFlags & TL_T_START_WILD) == 0) &&
+        (tBase < CurrentLog->tStartTime)) {
+        tBase = CurrentLog->tStartTime;
+    }
+    if (CurrentLog->bTrigger == true) {
+        tDue = tBase;
+    } else if (CurrentLog->LoggingType == LOGGING_TYPE_COV) {
+        if (!TL_Is_Remote(&CurrentLog->Source)) {
+            return 0;
+        }
+        /* when the subscription is to be renewed */
+        tDue = LogRemote[iLog].tRenew;
+        if (tDue < tBase) {
+            tDue = tBase;
+        }
+    } else if ((CurrentLog->LoggingType != LOGGING_TYPE_POLLED) ||
+        (tInterval == 0)) {
+        return 0;
+    } else if (CurrentLog->bAlignIntervals == true) {
+        if ((tBase - CurrentLog->tLastDataTime) > tInterval) {
+            /* Take a reading as soon as possible if we have been off for
+             * more than a single period, then carry on at the interval.
+             */
+            tDue = tBase;
+        } else {
+            tDue =
+                tBase - (tBase % tInterval) +
+                (CurrentLog->ulIntervalOffset % CurrentLog->ulLogInterval);
+            if (tDue < tBase) {
+                tDue += tInterval;
             }
         }
+    } else {
+        tDue = CurrentLog->tLastDataTime + tInterval;
+        if (tDue < tBase) {
+            tDue = tBase;
+        }
+    }
+    if (((CurrentLog->ucTimeFlags & TL_T_STOP_WILD) == 0) &&
+        (tDue > CurrentLog->tStopTime)) {
+        return 0;
+    }
+
+    return tDue;
+}
+
+static void TL_Schedule(
+    int iLog)
+{
+    time_t tDue;
+
+    if (!TL_Clock_Valid) {
+        return;
     }
+    TL_Sched_Remove(iLog);
+    /* after the last run, as a log that fell behind is due after now */
+    tDue = TL_Next_Due(iLog, TL_Now + 1);
+    if (tDue) {
+        LogSched[iLog].tDue = tDue;
+        TL_Sched_Insert(iLog, TL_Clock + 1);
+    }
+}
+
+/* Schedules every log again from tNow, keeping the due time of the
+   readings that are late so that their lag is counted. */
+static void TL_Sched_Reset(
+    time_t tNow)
+{
+    int iLog;
+    time_t tLate;
+    time_t tDue;
+
+    memset(TL_Wheel, 0, sizeof(TL_Wheel));
+    TL_Sched_Count = 0;
+    TL_Clock = tNow - 1;
+    TL_Now = tNow - 1;
+    TL_Clock_Valid = true;
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        tLate = LogSched[iLog].ucSlot ? LogSched[iLog].tDue : 0;
+        LogSched[iLog].next = 0;
+        LogSched[iLog].prev = 0;
+        LogSched[iLog].ucSlot = 0;
+        tDue = TL_Next_Due(iLog, tNow);
+        if (tDue) {
+            if (tLate && (tLate < tDue)) {
+                tDue = tLate;
+            }
+            LogSched[iLog].tDue = tDue;
+            TL_Sched_Insert(iLog, tNow);
+        }
+    }
+}
+
+/* Takes the reading of a log that is due, and counts how late it is, or
+   queues it if the source is in another device.  A COV log renews its
+   subscription. */
+static void TL_Sample(
+    int iLog,
+    time_t tNow)
+{
+    TL_LOG_INFO *CurrentLog = &LogInfo[iLog];
+    bool bRemote = TL_Is_Remote(&CurrentLog->Source);
+    time_t tLag;
+
+    if (bRemote && (CurrentLog->LoggingType == LOGGING_TYPE_COV) &&
+        (tNow >= LogRemote[iLog].tRenew) && TL_Is_Enabled(iLog)) {
+        TL_Remote_Subscribe(iLog, tNow);
+    }
+    if (TL_Is_Enabled(iLog) &&
+        ((CurrentLog->LoggingType == LOGGING_TYPE_POLLED) ||
+            (CurrentLog->bTrigger == true))) {
+        tLag = tNow - LogSched[iLog].tDue;
+        if (tLag < 0) {
+            tLag = 0;
+        }
+        if ((CurrentLog->LoggingType == LOGGING_TYPE_POLLED) &&
+            (CurrentLog->ulLogInterval != 0)) {
+            TL_Stats.missed += (uint32_t) (tLag / CurrentLog->ulLogInterval);
+        }
+        if ((uint32_t) tLag > TL_Stats.lag_max) {
+            TL_Stats.lag_max = (uint32_t) tLag;
+        }
+        TL_Stats.lag_total += (uint32_t) tLag;
+        if (bRemote) {
+            TL_Remote_Read(iLog, tNow);
+        } else {
+            TL_fetch_property(iLog, tNow);
+        }
+        TL_Stats.samples++;
+    }
+    /* Clear this every time */
+    CurrentLog->bTrigger = false;
+}
+
+/* advances the wheel by one second, and samples all the logs due in it */
+static void TL_Sched_Tick(
+    time_t tNow)
+{
+    unsigned slot;
+    unsigned count = 0;
+    unsigned i;
+    TL_INDEX index;
+
+    TL_Clock++;
+    TL_Stats.ticks++;
+    if (((uint32_t) TL_Clock & TL_WHEEL_MASK) == 0) {
+        TL_Sched_Cascade(TL_WHEEL_SLOT(TL_Clock, 1));
+        if ((((uint32_t) TL_Clock >> TL_WHEEL_BITS) & TL_WHEEL_MASK) == 0) {
+            TL_Sched_Cascade(TL_WHEEL_SLOT(TL_Clock, 2));
+        }
+    }
+    slot = TL_WHEEL_SLOT(TL_Clock, 0);
+    /* take the whole slot first, as the logs go back on the wheel as
+       they are sampled */
+    while (TL_Wheel[slot]) {
+        index = TL_Wheel[slot] - 1;
+        TL_Sched_Remove(index);
+        TL_Batch[count++] = index;
+    }
+    if (count == 0) {
+        return;
+    }
+    TL_Stats.batches++;
+    if (count > TL_Stats.batch_max) {
+        TL_Stats.batch_max = count;
+    }
+    for (i = 0; i < count; i++) {
+        TL_Sample(TL_Batch[i], tNow);
+        TL_Schedule(TL_Batch[i]);
+    }
+}
+
+/* Runs the ticks up to tNow.  A tick that comes late still runs, so
+   that a late reading is taken once, and its lag counted. */
+static void TL_Sched_Run(
+    time_t tNow)
+{
+    if (!TL_Clock_Valid || (tNow < TL_Clock) ||
+        ((tNow - TL_Clock) > TL_SCHED_CATCH_UP)) {
+        /* the first run, or the clock was set */
+        TL_Sched_Reset(tNow);
+    }
+    TL_Now = tNow;
+    while (TL_Clock < tNow) {
+        if (TL_Sched_Count == 0) {
+            /* nothing is scheduled - no need to turn the wheel */
+            TL_Clock = tNow;
+            break;
+        }
+        TL_Sched_Tick(tNow);
+    }
+    TL_Subscribe_Task();
+}
+
+/****************************************************************************
+ * Take the readings of the logs that are due, and queue the reads of the   *
+ * remote ones with the poll scheduler.                                     *
+ ****************************************************************************/
+
+void trend_log_timer(
+    uint16_t uSeconds)
+{
+    /* unused parameter */
+    uSeconds = uSeconds;
+    /* use OS to get the current time */
+    TL_Sched_Run(time(NULL));
+}
+
+void Trend_Log_Stats(
+    TREND_LOG_STATS * stats)
+{
+    if (stats) {
+        *stats = TL_Stats;
+    }
+}
+
+/** Handler for the SubscribeCOV Error of a remote source, which is
+ *  logged, and the subscription tried again later.
+ */
+void handler_trend_log_error(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    BACNET_ERROR_CLASS error_class,
+    BACNET_ERROR_CODE error_code)
+{
+    TL_SUBSCRIBE *pRequest;
+
+    pRequest = TL_Subscribe_Find(src, invoke_id);
+    if (pRequest) {
+        TL_Stats.errors++;
+        TL_Subscribe_Error(pRequest, error_class, error_code);
+    }
+}
+
+/** Handler for an Abort of the subscription of a remote source.  Set it
+ *  before poll_init(), which gives it the Aborts of other requests.
+ */
+void handler_trend_log_abort(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    uint8_t abort_reason,
+    bool server)
+{
+    TL_SUBSCRIBE *pRequest;
+
+    (void) abort_reason;
+    (void) server;
+    pRequest = TL_Subscribe_Find(src, invoke_id);
+    if (pRequest) {
+        TL_Stats.errors++;
+        TL_Subscribe_Error(pRequest, ERROR_CLASS_COMMUNICATION,
+            ERROR_CODE_ABORT_OTHER);
+    }
+}
+
+/** Handler for a Reject of the subscription of a remote source.  Set it
+ *  before poll_init(), which gives it the Rejects of other requests.
+ */
+void handler_trend_log_reject(
+    BACNET_ADDRESS * src,
+    uint8_t invoke_id,
+    uint8_t reject_reason)
+{
+    TL_SUBSCRIBE *pRequest;
+    BACNET_ERROR_CODE error_code = ERROR_CODE_REJECT_OTHER;
+
+    pRequest = TL_Subscribe_Find(src, invoke_id);
+    if (pRequest) {
+        if (reject_reason == REJECT_REASON_UNRECOGNIZED_SERVICE) {
+            error_code = ERROR_CODE_REJECT_UNRECOGNIZED_SERVICE;
+        }
+        TL_Stats.errors++;
+        TL_Subscribe_Error(pRequest, ERROR_CLASS_SERVICES, error_code);
+    }
+}
+
+/** Logs the value of a COV notification for the subscription of a COV
+ *  log, as set with handler_ucov_notification_set(), or with
+ *  handler_ccov_notification_set() for confirmed notifications.
+ *
+ * @param cov_data [in] The notification that was received.
+ */
+void Trend_Log_COV_Notification(
+    BACNET_COV_DATA * cov_data)
+{
+    BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE *Source;
+    BACNET_PROPERTY_VALUE *pValue;
+    TL_DATA_REC TempRec;
+    bool bFound = false;
+    uint32_t ulLog;
+
+    if (!cov_data ||
+        (cov_data->subscriberProcessIdentifier < TL_COV_PROCESS_ID)) {
+        return;
+    }
+    ulLog = cov_data->subscriberProcessIdentifier - TL_COV_PROCESS_ID;
+    if (ulLog >= MAX_TREND_LOGS) {
+        return;
+    }
+    Source = &LogInfo[ulLog].Source;
+    if ((LogInfo[ulLog].LoggingType != LOGGING_TYPE_COV) ||
+        !TL_Is_Remote(Source) || !TL_Is_Enabled((int) ulLog) ||
+        (cov_data->initiatingDeviceIdentifier !=
+            Source->deviceIdentifier.instance) ||
+        (cov_data->monitoredObjectIdentifier.type !=
+            Source->objectIdentifier.type) ||
+        (cov_data->monitoredObjectIdentifier.instance !=
+            Source->objectIdentifier.instance)) {
+        /* not for a subscription that we still want */
+        return;
+    }
+    memset(&TempRec, 0, sizeof(TempRec));
+    TempRec.tTimeStamp = time(NULL);
+    for (pValue = cov_data->listOfValues; pValue; pValue = pValue->next) {
+        if ((pValue->propertyIdentifier == Source->propertyIdentifier) &&
+            ((Source->arrayIndex == BACNET_ARRAY_ALL) ||
+                (Source->arrayIndex == pValue->propertyArrayIndex))) {
+            TL_Value_To_Record(&TempRec, &pValue->value);
+            bFound = true;
+        }
+        if ((pValue->propertyIdentifier == PROP_STATUS_FLAGS) &&
+            (pValue->value.tag == BACNET_APPLICATION_TAG_BIT_STRING)) {
+            TempRec.ucStatus =
+                128 | bitstring_octet(&pValue->value.type.Bit_String, 0);
+        }
+    }
+    if (bFound) {
+        TL_Stats.notifications++;
+        LogInfo[ulLog].tLastDataTime = TempRec.tTimeStamp;
+        TL_Store_Append((int) ulLog, &TempRec);
+    }
+}
+
+#ifdef TEST
+#include <assert.h>
+#include <string.h>
+#include "rpm.h"
+#include "rpmplan.h"
+#include "ctest.h"
+
+uint32_t Device_Object_Instance_Number(
+    void)
+{
+    return 1234;
+}
+
+int Device_Read_Property(
+    BACNET_READ_PROPERTY_DATA * rpdata)
+{
+    rpdata->error_class = ERROR_CLASS_OBJECT;
+    rpdata->error_code = ERROR_CODE_UNKNOWN_OBJECT;
+
+    return BACNET_STATUS_ERROR;
+}
+
+/* Analog Inputs 0 to 99, with a Present_Value of the instance and a
+   half, out of service when the instance is odd, and in alarm when it
+   is 2 more than a multiple of 4 */
+bool Device_Encode_Value_List(
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_VALUE * value_list)
+{
+    if ((object_type != OBJECT_ANALOG_INPUT) || (object_instance >= 100)) {
+        return false;
+    }
+    value_list->propertyIdentifier = PROP_PRESENT_VALUE;
+    value_list->propertyArrayIndex = BACNET_ARRAY_ALL;
+    value_list->value.tag = BACNET_APPLICATION_TAG_REAL;
+    value_list->value.type.Real = (float) object_instance + 0.5f;
+    value_list = value_list->next;
+    value_list->propertyIdentifier = PROP_STATUS_FLAGS;
+    value_list->propertyArrayIndex = BACNET_ARRAY_ALL;
+    value_list->value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
+    bitstring_init(&value_list->value.type.Bit_String);
+    bitstring_set_bit(&value_list->value.type.Bit_String,
+        STATUS_FLAG_IN_ALARM, (object_instance & 3) == 2);
+    bitstring_set_bit(&value_list->value.type.Bit_String,
+        STATUS_FLAG_FAULT, false);
+    bitstring_set_bit(&value_list->value.type.Bit_String,
+        STATUS_FLAG_OVERRIDDEN, false);
+    bitstring_set_bit(&value_list->value.type.Bit_String,
+        STATUS_FLAG_OUT_OF_SERVICE, (object_instance & 1) != 0);
+    value_list->next = NULL;
+
+    return true;
+}
+
+bool WPValidateArgType(
+    BACNET_APPLICATION_DATA_VALUE * pValue,
+    uint8_t ucExpectedTag,
+    BACNET_ERROR_CLASS * pErrorClass,
+    BACNET_ERROR_CODE * pErrorCode)
+{
+    if (pValue->tag != ucExpectedTag) {
+        *pErrorClass = ERROR_CLASS_PROPERTY;
+        *pErrorCode = ERROR_CODE_INVALID_DATA_TYPE;
+        return false;
+    }
+
+    return true;
+}
+
+/* The TSM, the network and the property cache, as seen by the logs of
+   remote sources.  The points of the last few ReadPropertyMultiple
+   and ReadProperty requests are kept, by invoke ID, to answer them
+   with. */
+#define TEST_TSM_FREE 0
+#define TEST_TSM_WAITING 1
+#define TEST_TSM_FAILED 2
+#define TEST_RPM_KEPT 8
+static uint8_t Test_TSM[256];
+static uint8_t Test_Invoke_ID;
+static unsigned Test_Who_Is;
+static unsigned Test_Subscribes;
+static BACNET_SUBSCRIBE_COV_DATA Test_COV_Data;
+static uint32_t Test_RPM_Device[TEST_RPM_KEPT];
+static bool Test_RPM_Is_RP[TEST_RPM_KEPT];
+static unsigned Test_RPM_Count[TEST_RPM_KEPT];
+static RPM_PLAN_POINT Test_RPM_Points[TEST_RPM_KEPT][RPM_PLAN_REQUEST_POINTS];
+
+static uint8_t testInvokeID(
+    void)
+{
+    do {
+        Test_Invoke_ID++;
+    } while ((Test_Invoke_ID == 0) ||
+        (Test_TSM[Test_Invoke_ID] != TEST_TSM_FREE));
+    Test_TSM[Test_Invoke_ID] = TEST_TSM_WAITING;
+
+    return Test_Invoke_ID;
+}
+
+bool tsm_transaction_available(
+    void)
+{
+    return true;
+}
+
+bool tsm_invoke_id_free(
+    uint8_t invokeID)
+{
+    return Test_TSM[invokeID] == TEST_TSM_FREE;
+}
+
+bool tsm_invoke_id_failed(
+    uint8_t invokeID)
+{
+    return Test_TSM[invokeID] == TEST_TSM_FAILED;
+}
+
+void tsm_free_invoke_id(
+    uint8_t invokeID)
+{
+    Test_TSM[invokeID] = TEST_TSM_FREE;
+}
+
+void Send_WhoIs(
+    int32_t low_limit,
+    int32_t high_limit)
+{
+    (void) low_limit;
+    (void) high_limit;
+    Test_Who_Is++;
+}
+
+/* the poll scheduler sets its handlers, and those set before it */
+void apdu_set_unconfirmed_handler(
+    BACNET_UNCONFIRMED_SERVICE service_choice,
+    unconfirmed_function pFunction)
+{
+    (void) service_choice;
+    (void) pFunction;
+}
+
+void apdu_set_confirmed_ack_handler(
+    BACNET_CONFIRMED_SERVICE service_choice,
+    confirmed_ack_function pFunction)
+{
+    (void) service_choice;
+    (void) pFunction;
+}
+
+confirmed_ack_function apdu_confirmed_ack_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    (void) service_choice;
+
+    return NULL;
+}
+
+void apdu_set_error_handler(
+    BACNET_CONFIRMED_SERVICE service_choice,
+    error_function pFunction)
+{
+    (void) service_choice;
+    (void) pFunction;
+}
+
+error_function apdu_error_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    (void) service_choice;
+
+    return NULL;
+}
+
+void apdu_set_abort_handler(
+    abort_function pFunction)
+{
+    (void) pFunction;
+}
+
+abort_function apdu_abort_handler(
+    void)
+{
+    return NULL;
+}
+
+void apdu_set_reject_handler(
+    reject_function pFunction)
+{
+    (void) pFunction;
+}
+
+reject_function apdu_reject_handler(
+    void)
+{
+    return NULL;
+}
+
+uint8_t Send_COV_Subscribe(
+    uint32_t device_id,
+    BACNET_SUBSCRIBE_COV_DATA * cov_data)
+{
+    (void) device_id;
+    Test_COV_Data = *cov_data;
+    Test_Subscribes++;
+
+    return testInvokeID();
+}
+
+uint8_t Send_Read_Property_Multiple_Request(
+    uint8_t * pdu,
+    size_t max_pdu,
+    uint32_t device_id,
+    BACNET_READ_ACCESS_DATA * read_access_data)
+{
+    BACNET_PROPERTY_REFERENCE *rpm_property;
+    RPM_PLAN_POINT *pPoint;
+    uint8_t invoke_id;
+    unsigned slot;
+
+    (void) pdu;
+    (void) max_pdu;
+    invoke_id = testInvokeID();
+    slot = invoke_id % TEST_RPM_KEPT;
+    Test_RPM_Device[slot] = device_id;
+    Test_RPM_Is_RP[slot] = false;
+    Test_RPM_Count[slot] = 0;
+    for (; read_access_data; read_access_data = read_access_data->next) {
+        for (rpm_property = read_access_data->listOfProperties; rpm_property;
+            rpm_property = rpm_property->next) {
+            pPoint = &Test_RPM_Points[slot][Test_RPM_Count[slot]++];
+            pPoint->object_type = read_access_data->object_type;
+            pPoint->object_instance = read_access_data->object_instance;
+            pPoint->object_property = rpm_property->propertyIdentifier;
+            pPoint->array_index = rpm_property->propertyArrayIndex;
+        }
+    }
+
+    return invoke_id;
+}
+
+uint8_t Send_Read_Property_Request(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index)
+{
+    RPM_PLAN_POINT *pPoint;
+    uint8_t invoke_id;
+    unsigned slot;
+
+    invoke_id = testInvokeID();
+    slot = invoke_id % TEST_RPM_KEPT;
+    Test_RPM_Device[slot] = device_id;
+    Test_RPM_Is_RP[slot] = true;
+    Test_RPM_Count[slot] = 1;
+    pPoint = &Test_RPM_Points[slot][0];
+    pPoint->object_type = object_type;
+    pPoint->object_instance = object_instance;
+    pPoint->object_property = object_property;
+    pPoint->array_index = array_index;
+
+    return invoke_id;
+}
+
+void property_cache_rp_ack(
+    uint32_t device_id,
+    uint8_t invoke_id,
+    BACNET_READ_PROPERTY_DATA * rp_data)
+{
+    (void) device_id;
+    (void) invoke_id;
+    (void) rp_data;
+}
+
+void property_cache_rpm_ack(
+    uint32_t device_id,
+    uint8_t invoke_id,
+    BACNET_READ_ACCESS_DATA * rpm_data)
+{
+    (void) device_id;
+    (void) invoke_id;
+    (void) rpm_data;
+}
+
+void property_cache_pending_clear(
+    uint8_t invoke_id)
+{
+    (void) invoke_id;
+}
+
+static uint32_t testEntriesBefore(
+    int iLog,
+    time_t tTime,
+    bool bAt)
+{
+    uint32_t ulEntry;
+
+    for (ulEntry = 1; ulEntry <= LogInfo[iLog].ulRecordCount; ulEntry++) {
+        if (!TL_Time_Before(TL_Record(iLog, ulEntry)->tTimeStamp, tTime,
+                bAt)) {
+            break;
+        }
+    }
+
+    return ulEntry - 1;
+}
+
+#ifdef TEST_TREND_LOG_BENCH
+#include <time.h>
+
+/* Measure ReadRange by time and by sequence as a log grows, against
+   walking the log from its oldest record as the by time search used
+   to.  The logs are in files where there are files - see
+   trendlog_bench.mak */
+static double Bench_Elapsed(
+    struct timespec *pStart)
+{
+    struct timespec Now;
+
+    clock_gettime(CLOCK_MONOTONIC, &Now);
+
+    return ((double) (Now.tv_sec - pStart->tv_sec) * 1e9) +
+        (double) (Now.tv_nsec - pStart->tv_nsec);
+}
+
+int main(
+    void)
+{
+    static const uint32_t sizes[] = { 1000, 10000, 100000, 1000000 };
+    char Directory[] = "/tmp/trendlogXXXXXX";
+    char Path[TL_STORE_PATH_MAX + 32];
+    BACNET_READ_RANGE_DATA Request;
+    uint8_t apdu[MAX_APDU];
+    TL_DATA_REC TempRec;
+    struct timespec Start;
+    time_t tFirst;
+    uint32_t ulSize;
+    uint32_t i, n, lookups, walks;
+    unsigned long items;
+    double search_ns, walk_ns, time_ns, seq_ns;
+
+#if TL_STORE_MMAP
+    if (mkdtemp(Directory)) {
+        Trend_Log_Storage_Set(Directory);
+    }
+#endif
+    Trend_Log_Init();
+    printf("records  file  search ns  walk ns  by time us/request"
+        "  by sequence us/request\n");
+    memset(&TempRec, 0, sizeof(TempRec));
+    TempRec.ucRecType = TL_TYPE_REAL;
+    memset(&Request, 0, sizeof(Request));
+    Request.object_type = OBJECT_TRENDLOG;
+    Request.object_instance = 0;
+    Request.object_property = PROP_LOG_BUFFER;
+    Request.array_index = BACNET_ARRAY_ALL;
+    Request.MaxApdu = sizeof(apdu);
+    for (n = 0; n < (sizeof(sizes) / sizeof(sizes[0])); n++) {
+        ulSize = sizes[n];
+        LogInfo[0].bEnable = false;
+        if (!Trend_Log_Buffer_Size_Set(0, ulSize)) {
+            break;
+        }
+        /* go a third of the way around the ring again, a minute apart */
+        tFirst = 1500000000;
+        for (i = 0; i < ulSize + ulSize / 3; i++) {
+            TempRec.tTimeStamp = tFirst + (time_t) i *60;
+            TempRec.Datum.fReal = (float) i;
+            TL_Store_Append(0, &TempRec);
+        }
+        tFirst = TL_Record(0, 1)->tTimeStamp;
+        /* a historian fills in a gap of 20 records at a time */
+        lookups = 10000;
+        items = 0;
+        Request.RequestType = RR_BY_TIME;
+        clock_gettime(CLOCK_MONOTONIC, &Start);
+        for (i = 0; i < lookups; i++) {
+            TL_Local_Time_To_BAC(&Request.Range.RefTime,
+                tFirst + (time_t) ((i * 7919UL) % ulSize) * 60);
+            Request.Count = ((i & 1) ? 20 : -20);
+            rr_trend_log_encode(apdu, &Request);
+            items += Request.ItemCount;
+        }
+        time_ns = Bench_Elapsed(&Start) / lookups;
+        clock_gettime(CLOCK_MONOTONIC, &Start);
+        for (i = 0; i < lookups; i++) {
+            items +=
+                TL_Entries_Before(0,
+                tFirst + (time_t) ((i * 7919UL) % ulSize) * 60, true);
+        }
+        search_ns = Bench_Elapsed(&Start) / lookups;
+        walks = (ulSize >= 100000) ? 100 : 1000;
+        clock_gettime(CLOCK_MONOTONIC, &Start);
+        for (i = 0; i < walks; i++) {
+            items +=
+                testEntriesBefore(0,
+                tFirst + (time_t) ((i * 7919UL) % ulSize) * 60, true);
+        }
+        walk_ns = Bench_Elapsed(&Start) / walks;
+        Request.RequestType = RR_BY_SEQUENCE;
+        clock_gettime(CLOCK_MONOTONIC, &Start);
+        for (i = 0; i < lookups; i++) {
+            Request.Range.RefSeqNum =
+                LogInfo[0].ulTotalRecordCount - ulSize + 1 +
+                ((i * 7919UL) % ulSize);
+            Request.Count = ((i & 1) ? 20 : -20);
+            rr_trend_log_encode(apdu, &Request);
+            items += Request.ItemCount;
+        }
+        seq_ns = Bench_Elapsed(&Start) / lookups;
+        printf("%7lu  %4s  %9.0f  %7.0f  %18.2f  %22.2f  (%lu items)\n",
+            (unsigned long) ulSize, LogStore[0].pMap ? "yes" : "no",
+            search_ns, walk_ns, time_ns / 1000.0, seq_ns / 1000.0, items);
+    }
+    Trend_Log_Cleanup();
+#if TL_STORE_MMAP
+    for (i = 0; i < MAX_TREND_LOGS; i++) {
+        snprintf(Path, sizeof(Path), "%s/trendlog-%lu.dat", Directory,
+            (unsigned long) i);
+        unlink(Path);
+    }
+    rmdir(Directory);
+#else
+    (void) Path;
+#endif
+
+    return 0;
+}
+#endif /* TEST_TREND_LOG_BENCH */
+
+#ifdef TEST_TREND_LOG
+static void testAppend(
+    int iLog,
+    unsigned count)
+{
+    TL_DATA_REC TempRec;
+
+    memset(&TempRec, 0, sizeof(TempRec));
+    TempRec.ucRecType = TL_TYPE_UNSIGN;
+    while (count--) {
+        TempRec.tTimeStamp = 1000 + LogInfo[iLog].ulTotalRecordCount;
+        TempRec.Datum.ulUValue = LogInfo[iLog].ulTotalRecordCount + 1;
+        TL_Store_Append(iLog, &TempRec);
+    }
+}
+
+/* every record holds its own sequence number */
+static bool testRecords(
+    int iLog)
+{
+    TL_LOG_INFO *CurrentLog = &LogInfo[iLog];
+    uint32_t ulFirstSeq;
+    uint32_t ulEntry;
+    TL_DATA_REC *pRec;
+
+    ulFirstSeq =
+        CurrentLog->ulTotalRecordCount - CurrentLog->ulRecordCount + 1;
+    for (ulEntry = 1; ulEntry <= CurrentLog->ulRecordCount; ulEntry++) {
+        pRec = TL_Record(iLog, ulEntry);
+        if ((pRec->ucRecType == TL_TYPE_UNSIGN) &&
+            (pRec->Datum.ulUValue != ulFirstSeq + ulEntry - 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void testTrendLogRecover(
+    Test * pTest)
+{
+    TL_LOG_INFO *CurrentLog = &LogInfo[0];
+    TL_STORE_REC *pRecords;
+    uint32_t ulTotal;
+
+    Trend_Log_Storage_Set(NULL);
+    Trend_Log_Init();
+    ct_test(pTest, Trend_Log_Buffer_Size(0) == TL_MAX_ENTRIES);
+    ct_test(pTest, CurrentLog->ulRecordCount == TL_MAX_ENTRIES);
+    ct_test(pTest, CurrentLog->ulTotalRecordCount == 10000);
+    ct_test(pTest, Trend_Log_Buffer_Size_Set(0, 0) == false);
+    ct_test(pTest, Trend_Log_Buffer_Size_Set(0, 300));
+    ct_test(pTest, Trend_Log_Buffer_Size(0) == 300);
+    ct_test(pTest, CurrentLog->ulRecordCount == 1);
+    ct_test(pTest, CurrentLog->ulTotalRecordCount == 10001);
+    pRecords = LogStore[0].pRecords;
+
+    /* not yet around the ring */
+    testAppend(0, 199);
+    TL_Store_Recover(0);
+    ct_test(pTest, CurrentLog->ulRecordCount == 200);
+    ct_test(pTest, CurrentLog->iIndex == 200);
+    ct_test(pTest, CurrentLog->ulTotalRecordCount == 10200);
+    ct_test(pTest, testRecords(0));
+
+    /* around the ring */
+    testAppend(0, 450);
+    ulTotal = CurrentLog->ulTotalRecordCount;
+    TL_Store_Recover(0);
+    ct_test(pTest, CurrentLog->ulRecordCount == 300);
+    ct_test(pTest, CurrentLog->iIndex == 50);
+    ct_test(pTest, CurrentLog->ulTotalRecordCount == ulTotal);
+    ct_test(pTest, testRecords(0));
+
+    /* the newest record was torn */
+    pRecords[49].Rec.Datum.ulUValue++;
+    TL_Store_Recover(0);
+    ct_test(pTest, CurrentLog->ulRecordCount == 299);
+    ct_test(pTest, CurrentLog->iIndex == 49);
+    ct_test(pTest, CurrentLog->ulTotalRecordCount == ulTotal - 1);
+    ct_test(pTest, testRecords(0));
+
+    /* a record in the last window was lost, and the two after it
+       were written */
+    testAppend(0, 1);
+    ulTotal = CurrentLog->ulTotalRecordCount;
+    pRecords[47].ulCheck++;
+    TL_Store_Recover(0);
+    ct_test(pTest, CurrentLog->ulRecordCount == 297);
+    ct_test(pTest, CurrentLog->iIndex == 47);
+    ct_test(pTest, CurrentLog->ulTotalRecordCount == ulTotal - 3);
+    ct_test(pTest, testRecords(0));
+
+    /* the record in slot 0 was lost */
+    testAppend(0, 254);
+    ct_test(pTest, CurrentLog->iIndex == 1);
+    ulTotal = CurrentLog->ulTotalRecordCount;
+    memset(&pRecords[0], 0, sizeof(pRecords[0]));
+    TL_Store_Recover(0);
+    ct_test(pTest, CurrentLog->ulRecordCount == 299);
+    ct_test(pTest, CurrentLog->iIndex == 0);
+    ct_test(pTest, CurrentLog->ulTotalRecordCount == ulTotal - 1);
+    ct_test(pTest, testRecords(0));
+
+    /* empty */
+    memset(pRecords, 0, 300 * sizeof(TL_STORE_REC));
+    TL_Store_Recover(0);
+    ct_test(pTest, CurrentLog->ulRecordCount == 0);
+    ct_test(pTest, CurrentLog->iIndex == 0);
+
+    Trend_Log_Cleanup();
+}
+
+static void testTrendLogFile(
+    Test * pTest)
+{
+    char Directory[] = "/tmp/trendlogXXXXXX";
+    char Path[TL_STORE_PATH_MAX + 32];
+    TL_LOG_INFO *CurrentLog = &LogInfo[1];
+    BACNET_READ_RANGE_DATA Request;
+    struct stat Stat;
+    uint8_t apdu[MAX_APDU];
+    uint32_t ulTotal;
+    int iLog;
+    int len;
+
+#if TL_STORE_MMAP
+    ct_test(pTest, mkdtemp(Directory) != NULL);
+    ct_test(pTest, Trend_Log_Storage_Set(Directory));
+    Trend_Log_Init();
+    ct_test(pTest, LogStore[1].pMap != NULL);
+    ct_test(pTest, CurrentLog->ulRecordCount == 0);
+    ct_test(pTest, Trend_Log_Buffer_Size_Set(1, 5000));
+    /* with its blocks allocated, not sparse */
+    ct_test(pTest, fstat(LogStore[1].iFile, &Stat) == 0);
+    ct_test(pTest, ((off_t) Stat.st_blocks * 512) >= Stat.st_size);
+    testAppend(1, 12344);
+    ulTotal = CurrentLog->ulTotalRecordCount;
+    ct_test(pTest, ulTotal == 12345);
+    Trend_Log_Cleanup();
+
+    /* the log is there after a restart, with the restart noted */
+    Trend_Log_Init();
+    ct_test(pTest, Trend_Log_Buffer_Size(1) == 5000);
+    ct_test(pTest, CurrentLog->ulRecordCount == 5000);
+    ct_test(pTest, CurrentLog->ulTotalRecordCount == ulTotal + 1);
+    ct_test(pTest, TL_Record(1, 5000)->ucRecType == TL_TYPE_STATUS);
+    ct_test(pTest, TL_Record(1, 4999)->Datum.ulUValue == ulTotal);
+    ct_test(pTest, testRecords(1));
+    ct_test(pTest, LogInfo[2].ulRecordCount == 0);
+
+    memset(&Request, 0, sizeof(Request));
+    Request.object_type = OBJECT_TRENDLOG;
+    Request.object_instance = 1;
+    Request.object_property = PROP_LOG_BUFFER;
+    Request.array_index = BACNET_ARRAY_ALL;
+    Request.RequestType = RR_BY_SEQUENCE;
+    Request.Range.RefSeqNum = ulTotal - 10;
+    Request.Count = 5;
+    Request.MaxApdu = sizeof(apdu);
+    len = rr_trend_log_encode(apdu, &Request);
+    ct_test(pTest, len > 0);
+    ct_test(pTest, Request.ItemCount == 5);
+    ct_test(pTest, Request.FirstSequence == ulTotal - 10);
+
+    /* the records that are not flushed are lost in a crash, but those
+       that are flushed are all kept */
+    LogStore[1].pRecords[(ulTotal + 1 - 3) % 5000].ulCheck++;
+    Trend_Log_Cleanup();
+    Trend_Log_Init();
+    ct_test(pTest, CurrentLog->ulRecordCount == 4998);
+    ct_test(pTest, CurrentLog->ulTotalRecordCount == ulTotal - 1);
+    ct_test(pTest, testRecords(1));
+    Trend_Log_Cleanup();
+
+    /* a file that is not a log is replaced by an empty log */
+    snprintf(Path, sizeof(Path), "%s/trendlog-1.dat", Directory);
+    ct_test(pTest, truncate(Path, 100) == 0);
+    Trend_Log_Init();
+    ct_test(pTest, LogStore[1].pMap != NULL);
+    ct_test(pTest, Trend_Log_Buffer_Size(1) == TL_MAX_ENTRIES);
+    ct_test(pTest, CurrentLog->ulRecordCount == 0);
+    Trend_Log_Cleanup();
+
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        snprintf(Path, sizeof(Path), "%s/trendlog-%d.dat", Directory, iLog);
+        unlink(Path);
+    }
+    rmdir(Directory);
+    Trend_Log_Storage_Set(NULL);
+#else
+    (void) pTest;
+#endif
+}
+
+/* a search at each time from tFirst to tLast finds what a walk does */
+static bool testSearchTimes(
+    int iLog,
+    time_t tFirst,
+    time_t tLast)
+{
+    time_t tTime;
+
+    for (tTime = tFirst - 5; tTime <= tLast + 5; tTime++) {
+        if ((TL_Entries_Before(iLog, tTime, false) != testEntriesBefore(iLog,
+                    tTime, false)) ||
+            (TL_Entries_Before(iLog, tTime, true) != testEntriesBefore(iLog,
+                    tTime, true))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool testSearch(
+    int iLog)
+{
+    return testSearchTimes(iLog, TL_Record(iLog, 1)->tTimeStamp,
+        TL_Record(iLog, LogInfo[iLog].ulRecordCount)->tTimeStamp);
+}
+
+/* time stamps that go up by 10 seconds every 4 records */
+static void testAppendTimes(
+    int iLog,
+    unsigned count)
+{
+    TL_DATA_REC TempRec;
+
+    memset(&TempRec, 0, sizeof(TempRec));
+    TempRec.ucRecType = TL_TYPE_UNSIGN;
+    while (count--) {
+        TempRec.tTimeStamp =
+            1000000 + (LogInfo[iLog].ulTotalRecordCount / 4) * 10;
+        TempRec.Datum.ulUValue = LogInfo[iLog].ulTotalRecordCount + 1;
+        TL_Store_Append(iLog, &TempRec);
+    }
+}
+
+static void testTrendLogByTime(
+    Test * pTest)
+{
+    char Directory[] = "/tmp/trendlogXXXXXX";
+    char Path[TL_STORE_PATH_MAX + 32];
+    BACNET_READ_RANGE_DATA Request;
+    uint8_t apdu[MAX_APDU];
+    int iLog;
+    int len;
+
+    Trend_Log_Storage_Set(NULL);
+#if TL_STORE_MMAP
+    ct_test(pTest, mkdtemp(Directory) != NULL);
+    ct_test(pTest, Trend_Log_Storage_Set(Directory));
+#endif
+    Trend_Log_Init();
+    /* log 3 is in a file where there are files, log 4 is in RAM */
+    for (iLog = 3; iLog <= 4; iLog++) {
+        if (iLog == 4) {
+            Trend_Log_Storage_Set(NULL);
+        }
+        ct_test(pTest, Trend_Log_Buffer_Size_Set(iLog, 999));
+        testAppendTimes(iLog, 299);
+        ct_test(pTest, testSearch(iLog));
+        testAppendTimes(iLog, 2000);
+        ct_test(pTest, testSearch(iLog));
+        testAppendTimes(iLog, 77);
+        ct_test(pTest, testSearch(iLog));
+    }
+#if TL_STORE_MMAP
+    ct_test(pTest, LogStore[3].pTimes != NULL);
+#endif
+    ct_test(pTest, LogStore[4].pTimes == NULL);
+
+    /* 10 records after the time, starting with the first one after it */
+    memset(&Request, 0, sizeof(Request));
+    Request.object_type = OBJECT_TRENDLOG;
+    Request.object_instance = 3;
+    Request.object_property = PROP_LOG_BUFFER;
+    Request.array_index = BACNET_ARRAY_ALL;
+    Request.RequestType = RR_BY_TIME;
+    TL_Local_Time_To_BAC(&Request.Range.RefTime,
+        TL_Record(3, 500)->tTimeStamp);
+    Request.Count = 10;
+    Request.MaxApdu = sizeof(apdu);
+    len = rr_trend_log_encode(apdu, &Request);
+    ct_test(pTest, len > 0);
+    ct_test(pTest, Request.ItemCount == 10);
+    ct_test(pTest,
+        Request.FirstSequence ==
+        LogInfo[3].ulTotalRecordCount - LogInfo[3].ulRecordCount + 1 +
+        testEntriesBefore(3, TL_Record(3, 500)->tTimeStamp, true));
+    /* 10 records before the time, ending with the last one before it */
+    Request.Count = -10;
+    len = rr_trend_log_encode(apdu, &Request);
+    ct_test(pTest, len > 0);
+    ct_test(pTest, Request.ItemCount == 10);
+    ct_test(pTest,
+        Request.FirstSequence ==
+        LogInfo[3].ulTotalRecordCount - LogInfo[3].ulRecordCount - 9 +
+        testEntriesBefore(3, TL_Record(3, 500)->tTimeStamp, false));
+    Trend_Log_Cleanup();
+
+#if TL_STORE_MMAP
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        snprintf(Path, sizeof(Path), "%s/trendlog-%d.dat", Directory, iLog);
+        unlink(Path);
+    }
+    rmdir(Directory);
+    Trend_Log_Storage_Set(NULL);
+#else
+    (void) Path;
+#endif
+}
+
+/* A log with a record from after the clock was set back is searched by
+   walking it, until the record before that one ages out, and also when
+   the log file is found again */
+static void testTrendLogSetBack(
+    Test * pTest)
+{
+    char Directory[] = "/tmp/trendlogXXXXXX";
+    char Path[TL_STORE_PATH_MAX + 32];
+    TL_DATA_REC TempRec;
+    uint32_t ulSequence;
+    time_t tFirst = 1000000 - 5;
+    time_t tLast = 1000000 + 5000;
+    int iLog;
+
+    Trend_Log_Storage_Set(NULL);
+#if TL_STORE_MMAP
+    ct_test(pTest, mkdtemp(Directory) != NULL);
+    ct_test(pTest, Trend_Log_Storage_Set(Directory));
+#endif
+    Trend_Log_Init();
+    memset(&TempRec, 0, sizeof(TempRec));
+    TempRec.ucRecType = TL_TYPE_UNSIGN;
+    TempRec.tTimeStamp = 1000000;
+    for (iLog = 3; iLog <= 4; iLog++) {
+        if (iLog == 4) {
+            Trend_Log_Storage_Set(NULL);
+        }
+        /* the status record of the purge is newer than the records
+           that follow it, until it ages out */
+        ct_test(pTest, Trend_Log_Buffer_Size_Set(iLog, 999));
+        testAppendTimes(iLog, 999);
+        ct_test(pTest, LogStore[iLog].ulDisorder != 0);
+        ct_test(pTest, testSearch(iLog));
+        ct_test(pTest, LogStore[iLog].ulDisorder == 0);
+        TL_Store_Append(iLog, &TempRec);
+        ulSequence = LogInfo[iLog].ulTotalRecordCount;
+        ct_test(pTest, LogStore[iLog].ulDisorder == ulSequence);
+        testAppendTimes(iLog, 100);
+        ct_test(pTest, testSearchTimes(iLog, tFirst, tLast));
+        /* the record before it is the oldest, and then ages out */
+        testAppendTimes(iLog, 999 - 102);
+        ct_test(pTest, testSearchTimes(iLog, tFirst, tLast));
+        ct_test(pTest, LogStore[iLog].ulDisorder == ulSequence);
+        testAppendTimes(iLog, 1);
+        ct_test(pTest, testSearchTimes(iLog, tFirst, tLast));
+        ct_test(pTest, LogStore[iLog].ulDisorder == 0);
+    }
+    /* a purge empties the log */
+    TL_Store_Append(4, &TempRec);
+    ct_test(pTest, LogStore[4].ulDisorder != 0);
+    ct_test(pTest, TL_Purge(4, 999));
+    ct_test(pTest, LogStore[4].ulDisorder == 0);
+#if TL_STORE_MMAP
+    TL_Store_Append(3, &TempRec);
+    ulSequence = LogInfo[3].ulTotalRecordCount;
+    testAppendTimes(3, 10);
+    Trend_Log_Cleanup();
+    Trend_Log_Storage_Set(Directory);
+    Trend_Log_Init();
+    ct_test(pTest, LogStore[3].bOrderUnknown);
+    ct_test(pTest, testSearchTimes(3, tFirst, tLast));
+    ct_test(pTest, !LogStore[3].bOrderUnknown);
+    ct_test(pTest, LogStore[3].ulDisorder == ulSequence);
+#endif
+    Trend_Log_Cleanup();
+
+#if TL_STORE_MMAP
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        snprintf(Path, sizeof(Path), "%s/trendlog-%d.dat", Directory, iLog);
+        unlink(Path);
+    }
+    rmdir(Directory);
+    Trend_Log_Storage_Set(NULL);
+#else
+    (void) Path;
+#endif
+}
+
+/* a polled log of an Analog Input, enabled at any time */
+static void testSchedulePolled(
+    int iLog,
+    uint32_t instance,
+    uint32_t interval,
+    bool align,
+    uint32_t offset)
+{
+    LogInfo[iLog].bEnable = true;
+    LogInfo[iLog].ucTimeFlags = TL_T_START_WILD | TL_T_STOP_WILD;
+    LogInfo[iLog].LoggingType = LOGGING_TYPE_POLLED;
+    LogInfo[iLog].ulLogInterval = interval;
+    LogInfo[iLog].bAlignIntervals = align;
+    LogInfo[iLog].ulIntervalOffset = offset;
+    LogInfo[iLog].Source.objectIdentifier.type = OBJECT_ANALOG_INPUT;
+    LogInfo[iLog].Source.objectIdentifier.instance = instance;
+    LogInfo[iLog].Source.propertyIdentifier = PROP_PRESENT_VALUE;
+    LogInfo[iLog].Source.arrayIndex = BACNET_ARRAY_ALL;
+    TL_Schedule(iLog);
+}
+
+/* the newest record of a log */
+static TL_DATA_REC *testNewest(
+    int iLog)
+{
+    return TL_Record(iLog, LogInfo[iLog].ulRecordCount);
+}
+
+static void testTrendLogSchedule(
+    Test * pTest)
+{
+    /* a whole number of minutes */
+    const time_t tBase = 1500000000;
+    uint32_t ulTotal[MAX_TREND_LOGS];
+    TREND_LOG_STATS Stats;
+    time_t tNow;
+    int iLog;
+
+    Trend_Log_Storage_Set(NULL);
+    Trend_Log_Init();
+    memset(&TL_Stats, 0, sizeof(TL_Stats));
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        LogInfo[iLog].bEnable = false;
+    }
+    testSchedulePolled(0, 0, 60, true, 0);
+    testSchedulePolled(1, 1, 60, true, 10);
+    testSchedulePolled(2, 2, 7, false, 0);
+    /* not an object with a value list, so read and found missing */
+    testSchedulePolled(4, 200, 60, true, 0);
+    LogInfo[3] = LogInfo[2];
+    LogInfo[3].LoggingType = LOGGING_TYPE_TRIGGERED;
+    LogInfo[3].ulLogInterval = 0;
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        ulTotal[iLog] = LogInfo[iLog].ulTotalRecordCount;
+    }
+
+    /* The logs have been off for years, so the first run takes a
+       reading of all of them at once */
+    tNow = tBase + 5;
+    TL_Sched_Run(tNow);
+    Trend_Log_Stats(&Stats);
+    ct_test(pTest, Stats.batches == 1);
+    ct_test(pTest, Stats.batch_max == 4);
+    ct_test(pTest, Stats.samples == 4);
+    ct_test(pTest, Stats.fast_samples == 3);
+    ct_test(pTest, Stats.missed == 0);
+    ct_test(pTest, LogInfo[3].ulTotalRecordCount == ulTotal[3]);
+    ct_test(pTest, testNewest(0)->tTimeStamp == tNow);
+    ct_test(pTest, testNewest(0)->ucRecType == TL_TYPE_REAL);
+    ct_test(pTest, testNewest(0)->Datum.fReal == 0.5f);
+    ct_test(pTest, testNewest(0)->ucStatus == 128);
+    ct_test(pTest, testNewest(1)->Datum.fReal == 1.5f);
+    ct_test(pTest,
+        testNewest(1)->ucStatus == (128 | (1 << STATUS_FLAG_OUT_OF_SERVICE)));
+    ct_test(pTest, testNewest(2)->Datum.fReal == 2.5f);
+    ct_test(pTest,
+        testNewest(2)->ucStatus == (128 | (1 << STATUS_FLAG_IN_ALARM)));
+    ct_test(pTest, testNewest(4)->ucRecType == TL_TYPE_ERROR);
+    ct_test(pTest,
+        testNewest(4)->Datum.Error.usCode == ERROR_CODE_UNKNOWN_OBJECT);
+
+    /* then each one at its interval, aligned to the clock or not */
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        ulTotal[iLog] = LogInfo[iLog].ulTotalRecordCount;
+    }
+    while (tNow < tBase + 130) {
+        tNow++;
+        TL_Sched_Run(tNow);
+        if (tNow == tBase + 70) {
+            ct_test(pTest, testNewest(1)->tTimeStamp == tNow);
+        }
+    }
+    ct_test(pTest, LogInfo[0].ulTotalRecordCount == ulTotal[0] + 2);
+    ct_test(pTest, testNewest(0)->tTimeStamp == tBase + 120);
+    ct_test(pTest, LogInfo[1].ulTotalRecordCount == ulTotal[1] + 3);
+    ct_test(pTest, testNewest(1)->tTimeStamp == tBase + 130);
+    ct_test(pTest, LogInfo[2].ulTotalRecordCount == ulTotal[2] + 17);
+    ct_test(pTest, testNewest(2)->tTimeStamp == tBase + 5 + (17 * 7));
+    Trend_Log_Stats(&Stats);
+    ct_test(pTest, Stats.ticks == 126);
+    ct_test(pTest, Stats.missed == 0);
+    ct_test(pTest, Stats.lag_max == 0);
+
+    /* a trigger takes a reading at the next tick */
+    ulTotal[3] = LogInfo[3].ulTotalRecordCount;
+    LogInfo[3].bTrigger = true;
+    TL_Schedule(3);
+    tNow++;
+    TL_Sched_Run(tNow);
+    ct_test(pTest, LogInfo[3].ulTotalRecordCount == ulTotal[3] + 1);
+    ct_test(pTest, testNewest(3)->tTimeStamp == tNow);
+    ct_test(pTest, LogInfo[3].bTrigger == false);
+    tNow++;
+    TL_Sched_Run(tNow);
+    ct_test(pTest, LogInfo[3].ulTotalRecordCount == ulTotal[3] + 1);
+
+    /* A late run takes one reading of each log that is due, and counts
+       the intervals that were missed */
+    ulTotal[0] = LogInfo[0].ulTotalRecordCount;
+    tNow = tBase + 330;
+    TL_Sched_Run(tNow);
+    Trend_Log_Stats(&Stats);
+    ct_test(pTest, LogInfo[0].ulTotalRecordCount == ulTotal[0] + 1);
+    ct_test(pTest, testNewest(0)->tTimeStamp == tNow);
+    /* logs 0, 1 and 4 were due at tBase + 180, 190 and 180, and log 2
+       at tBase + 138 */
+    ct_test(pTest, Stats.lag_max == 192);
+    ct_test(pTest, Stats.missed == 2 + 2 + 2 + (192 / 7));
+    TL_Sched_Run(tBase + 359);
+    ct_test(pTest, LogInfo[0].ulTotalRecordCount == ulTotal[0] + 1);
+    TL_Sched_Run(tBase + 360);
+    ct_test(pTest, LogInfo[0].ulTotalRecordCount == ulTotal[0] + 2);
+
+    /* A step of the clock schedules the logs again, without running
+       a tick for every second of it */
+    ulTotal[0] = LogInfo[0].ulTotalRecordCount;
+    tNow = tBase + 360 + 86400;
+    TL_Sched_Run(tNow);
+    ct_test(pTest, LogInfo[0].ulTotalRecordCount == ulTotal[0] + 1);
+    Trend_Log_Stats(&Stats);
+    ct_test(pTest, Stats.ticks < 500);
+    ct_test(pTest, Stats.lag_max >= 86400 - 60);
+
+    /* A disabled log is off the wheel, and a long interval waits in
+       the top level until it comes down */
+    for (iLog = 0; iLog < 5; iLog++) {
+        LogInfo[iLog].bEnable = false;
+        TL_Schedule(iLog);
+    }
+    ct_test(pTest, TL_Sched_Count == 0);
+    LogInfo[5].tLastDataTime = tNow;
+    testSchedulePolled(5, 5, 300000, false, 0);
+    ct_test(pTest, TL_Sched_Count == 1);
+    ulTotal[5] = LogInfo[5].ulTotalRecordCount;
+    while (tNow < LogInfo[5].tLastDataTime + 300000 - 1) {
+        tNow++;
+        TL_Sched_Run(tNow);
+    }
+    ct_test(pTest, LogInfo[5].ulTotalRecordCount == ulTotal[5]);
+    tNow++;
+    TL_Sched_Run(tNow);
+    ct_test(pTest, LogInfo[5].ulTotalRecordCount == ulTotal[5] + 1);
+    ct_test(pTest, testNewest(5)->tTimeStamp == tNow);
+    Trend_Log_Cleanup();
+}
+
+/* a polled log of an Analog Input in another device */
+static void testScheduleRemote(
+    int iLog,
+    uint32_t device_id,
+    uint32_t instance,
+    BACNET_PROPERTY_ID property)
+{
+    testSchedulePolled(iLog, instance, 60, true, 0);
+    LogInfo[iLog].Source.deviceIdentifier.type = OBJECT_DEVICE;
+    LogInfo[iLog].Source.deviceIdentifier.instance = device_id;
+    LogInfo[iLog].Source.propertyIdentifier = property;
+    TL_Schedule(iLog);
+}
+
+static void testDeviceAddress(
+    uint32_t device_id,
+    BACNET_ADDRESS * src)
+{
+    memset(src, 0, sizeof(*src));
+    src->mac_len = 1;
+    src->mac[0] = (uint8_t) device_id;
+}
+
+/* Answers a ReadPropertyMultiple as it was sent: a Present_Value of
+   the instance and a quarter, in fault when the instance is odd, and
+   no Analog Input 13 */
+static void testRpmAck(
+    uint8_t invoke_id)
+{
+    static uint8_t apdu[MAX_APDU];
+    BACNET_CONFIRMED_SERVICE_ACK_DATA service_data;
+    BACNET_ADDRESS src;
+    BACNET_RPM_DATA rpmdata;
+    BACNET_BIT_STRING bits;
+    RPM_PLAN_POINT *pPoint, *pLast = NULL;
+    unsigned slot = invoke_id % TEST_RPM_KEPT;
+    uint8_t value[16];
+    unsigned i;
+    int len, value_len;
+
+    len = rpm_ack_encode_apdu_init(&apdu[0], invoke_id);
+    for (i = 0; i < Test_RPM_Count[slot]; i++) {
+        pPoint = &Test_RPM_Points[slot][i];
+        if (!pLast || (pLast->object_instance != pPoint->object_instance)) {
+            if (pLast) {
+                len += rpm_ack_encode_apdu_object_end(&apdu[len]);
+            }
+            rpmdata.object_type = pPoint->object_type;
+            rpmdata.object_instance = pPoint->object_instance;
+            len += rpm_ack_encode_apdu_object_begin(&apdu[len], &rpmdata);
+        }
+        pLast = pPoint;
+        len +=
+            rpm_ack_encode_apdu_object_property(&apdu[len],
+            pPoint->object_property, pPoint->array_index);
+        if (pPoint->object_instance == 13) {
+            len +=
+                rpm_ack_encode_apdu_object_property_error(&apdu[len],
+                ERROR_CLASS_OBJECT, ERROR_CODE_UNKNOWN_OBJECT);
+            continue;
+        }
+        if (pPoint->object_property == PROP_STATUS_FLAGS) {
+            bitstring_init(&bits);
+            bitstring_set_bit(&bits, STATUS_FLAG_IN_ALARM, false);
+            bitstring_set_bit(&bits, STATUS_FLAG_FAULT,
+                (pPoint->object_instance & 1) != 0);
+            bitstring_set_bit(&bits, STATUS_FLAG_OVERRIDDEN, false);
+            bitstring_set_bit(&bits, STATUS_FLAG_OUT_OF_SERVICE, false);
+            value_len = encode_application_bitstring(&value[0], &bits);
+        } else {
+            value_len =
+                encode_application_real(&value[0],
+                (float) pPoint->object_instance + 0.25f);
+        }
+        len +=
+            rpm_ack_encode_apdu_object_property_value(&apdu[len], &value[0],
+            value_len);
+    }
+    len += rpm_ack_encode_apdu_object_end(&apdu[len]);
+    memset(&service_data, 0, sizeof(service_data));
+    service_data.invoke_id = invoke_id;
+    testDeviceAddress(Test_RPM_Device[slot], &src);
+    /* as apdu_handler() does, after the handler */
+    handler_poll_rpm_ack(&apdu[3], len - 3, &src, &service_data);
+    tsm_free_invoke_id(invoke_id);
+}
+
+/* Answers a ReadProperty as testRpmAck() does */
+static void testRpAck(
+    uint8_t invoke_id)
+{
+    static uint8_t apdu[MAX_APDU];
+    BACNET_CONFIRMED_SERVICE_ACK_DATA service_data;
+    BACNET_READ_PROPERTY_DATA rp_data;
+    BACNET_ADDRESS src;
+    RPM_PLAN_POINT *pPoint;
+    unsigned slot = invoke_id % TEST_RPM_KEPT;
+    uint8_t value[16];
+    int len;
+
+    pPoint = &Test_RPM_Points[slot][0];
+    rp_data.object_type = pPoint->object_type;
+    rp_data.object_instance = pPoint->object_instance;
+    rp_data.object_property = pPoint->object_property;
+    rp_data.array_index = pPoint->array_index;
+    rp_data.application_data = &value[0];
+    rp_data.application_data_len =
+        encode_application_real(&value[0],
+        (float) pPoint->object_instance + 0.25f);
+    len = rp_ack_encode_apdu(&apdu[0], invoke_id, &rp_data);
+    memset(&service_data, 0, sizeof(service_data));
+    service_data.invoke_id = invoke_id;
+    testDeviceAddress(Test_RPM_Device[slot], &src);
+    handler_poll_rp_ack(&apdu[3], len - 3, &src, &service_data);
+    tsm_free_invoke_id(invoke_id);
+}
+
+/* Writes a property of a log that has a value of one tag */
+static bool testWriteLog(
+    int iLog,
+    BACNET_PROPERTY_ID property,
+    BACNET_APPLICATION_DATA_VALUE * value)
+{
+    BACNET_WRITE_PROPERTY_DATA wp_data;
+
+    memset(&wp_data, 0, sizeof(wp_data));
+    wp_data.object_type = OBJECT_TRENDLOG;
+    wp_data.object_instance = Trend_Log_Index_To_Instance(iLog);
+    wp_data.object_property = property;
+    wp_data.array_index = BACNET_ARRAY_ALL;
+    wp_data.application_data_len =
+        bacapp_encode_application_data(&wp_data.application_data[0], value);
+
+    return Trend_Log_Write_Property(&wp_data);
+}
+
+/* A run of the logs, and then of the poll scheduler that sends their
+   reads, as the server runs them */
+static void testRun(
+    time_t tNow)
+{
+    TL_Sched_Run(tNow);
+    poll_task(1000);
+}
+
+static void testTrendLogRemote(
+    Test * pTest)
+{
+    const time_t tBase = 1500000000;
+    uint32_t ulTotal[MAX_TREND_LOGS];
+    BACNET_PROPERTY_VALUE Values[2];
+    BACNET_COV_DATA cov_data;
+    BACNET_ADDRESS src;
+    TREND_LOG_STATS Stats;
+    uint32_t errors;
+    uint8_t invoke_id;
+    time_t tNow, tRenew, tExpire;
+    int iLog;
+
+    Trend_Log_Storage_Set(NULL);
+    Trend_Log_Init();
+    memset(&TL_Stats, 0, sizeof(TL_Stats));
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        LogInfo[iLog].bEnable = false;
+    }
+    address_init();
+    rpm_plan_init();
+    poll_init(NULL);
+    Test_Who_Is = 0;
+    testDeviceAddress(100, &src);
+    address_add(100, MAX_APDU, &src);
+    /* device 100 is bound and device 200 is not */
+    testScheduleRemote(0, 100, 10, PROP_PRESENT_VALUE);
+    testScheduleRemote(1, 100, 11, PROP_PRESENT_VALUE);
+    testScheduleRemote(2, 100, 13, PROP_PRESENT_VALUE);
+    testScheduleRemote(3, 100, 10, PROP_STATUS_FLAGS);
+    testScheduleRemote(4, 200, 1, PROP_PRESENT_VALUE);
+    testSchedulePolled(5, 5, 60, true, 0);
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        ulTotal[iLog] = LogInfo[iLog].ulTotalRecordCount;
+    }
+
+    /* The readings of device 100 go in one request, with the
+       Status_Flags of the objects, and the local log is read at once */
+    tNow = tBase + 5;
+    testRun(tNow);
+    Trend_Log_Stats(&Stats);
+    ct_test(pTest, Stats.samples == 6);
+    ct_test(pTest, Stats.requests == 5);
+    ct_test(pTest, Test_RPM_Device[Test_Invoke_ID % TEST_RPM_KEPT] == 100);
+    ct_test(pTest, Test_RPM_Count[Test_Invoke_ID % TEST_RPM_KEPT] == 7);
+    ct_test(pTest, Test_Who_Is == 1);
+    ct_test(pTest, LogInfo[0].ulTotalRecordCount == ulTotal[0]);
+    ct_test(pTest, LogInfo[5].ulTotalRecordCount == ulTotal[5] + 1);
+    ct_test(pTest, poll_outstanding() == 1);
+    testRpmAck(Test_Invoke_ID);
+    ct_test(pTest, poll_outstanding() == 0);
+    ct_test(pTest, testNewest(0)->tTimeStamp == tNow);
+    ct_test(pTest, testNewest(0)->ucRecType == TL_TYPE_REAL);
+    ct_test(pTest, testNewest(0)->Datum.fReal == 10.25f);
+    ct_test(pTest, testNewest(0)->ucStatus == 128);
+    ct_test(pTest, testNewest(1)->Datum.fReal == 11.25f);
+    ct_test(pTest,
+        testNewest(1)->ucStatus == (128 | (1 << STATUS_FLAG_FAULT)));
+    ct_test(pTest, testNewest(2)->ucRecType == TL_TYPE_ERROR);
+    ct_test(pTest,
+        testNewest(2)->Datum.Error.usCode == ERROR_CODE_UNKNOWN_OBJECT);
+    ct_test(pTest, testNewest(3)->ucRecType == TL_TYPE_BITS);
+    ct_test(pTest, testNewest(3)->ucStatus == 128);
+    ct_test(pTest, LogInfo[4].ulTotalRecordCount == ulTotal[4]);
+
+    /* The next readings get no reply, and device 200 is never bound,
+       so all of them are logged as timeouts */
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        ulTotal[iLog] = LogInfo[iLog].ulTotalRecordCount;
+    }
+    while (tNow < tBase + 60) {
+        tNow++;
+        testRun(tNow);
+    }
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_RPM_Count[invoke_id % TEST_RPM_KEPT] == 7);
+    Test_TSM[invoke_id] = TEST_TSM_FAILED;
+    tNow++;
+    testRun(tNow);
+    ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_FREE);
+    ct_test(pTest, poll_outstanding() == 0);
+    for (iLog = 0; iLog < 4; iLog++) {
+        ct_test(pTest, LogInfo[iLog].ulTotalRecordCount == ulTotal[iLog] + 1);
+        ct_test(pTest, testNewest(iLog)->tTimeStamp == tBase + 60);
+        ct_test(pTest, testNewest(iLog)->ucRecType == TL_TYPE_ERROR);
+        ct_test(pTest,
+            testNewest(iLog)->Datum.Error.usCode == ERROR_CODE_TIMEOUT);
+    }
+    /* the read of device 200 is given up in the run that follows the
+       first by POLL_READ_TIMEOUT */
+    tExpire = tBase + 4 + (POLL_READ_TIMEOUT / 1000);
+    while (tNow < tExpire - 1) {
+        tNow++;
+        testRun(tNow);
+    }
+    ct_test(pTest, LogInfo[4].ulTotalRecordCount == ulTotal[4]);
+    tNow++;
+    testRun(tNow);
+    ct_test(pTest, LogInfo[4].ulTotalRecordCount == ulTotal[4] + 1);
+    ct_test(pTest, testNewest(4)->tTimeStamp == tBase + 5);
+    ct_test(pTest, testNewest(4)->Datum.Error.usCode == ERROR_CODE_TIMEOUT);
+    /* a Who-Is for it every POLL_BIND_TIMEOUT, and the reading due at
+       tBase + 60 was missed while the first waited */
+    ct_test(pTest, Test_Who_Is ==
+        1 + ((POLL_READ_TIMEOUT - 1000) / POLL_BIND_TIMEOUT));
+    Trend_Log_Stats(&Stats);
+    ct_test(pTest, Stats.timeouts == 5);
+    ct_test(pTest, Stats.missed == 1);
+
+    /* A reading whose source is changed is not logged from its reply */
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        LogInfo[iLog].bEnable = false;
+        TL_Schedule(iLog);
+    }
+    testScheduleRemote(0, 100, 10, PROP_PRESENT_VALUE);
+    testScheduleRemote(1, 100, 12, PROP_PRESENT_VALUE);
+    ulTotal[0] = LogInfo[0].ulTotalRecordCount;
+    ulTotal[1] = LogInfo[1].ulTotalRecordCount;
+    while (tNow < tBase + 120) {
+        tNow++;
+        testRun(tNow);
+    }
+    ct_test(pTest, poll_outstanding() == 1);
+    ct_test(pTest, Test_RPM_Count[Test_Invoke_ID % TEST_RPM_KEPT] == 4);
+    TL_Remote_Cancel(0);
+    testRpmAck(Test_Invoke_ID);
+    ct_test(pTest, LogInfo[0].ulTotalRecordCount == ulTotal[0]);
+    ct_test(pTest, LogInfo[1].ulTotalRecordCount == ulTotal[1] + 1);
+    ct_test(pTest, testNewest(1)->Datum.fReal == 12.25f);
+    ct_test(pTest, LogRemote[0].ucPoints == 0);
+
+    /* A COV log subscribes to its object, and logs the notifications */
+    LogInfo[0].bEnable = false;
+    LogInfo[1].bEnable = false;
+    TL_Schedule(0);
+    TL_Schedule(1);
+    testScheduleRemote(6, 100, 20, PROP_PRESENT_VALUE);
+    LogInfo[6].LoggingType = LOGGING_TYPE_COV;
+    LogInfo[6].ulLogInterval = 0;
+    TL_Schedule(6);
+    ulTotal[6] = LogInfo[6].ulTotalRecordCount;
+    tNow++;
+    testRun(tNow);
+    ct_test(pTest, Test_Subscribes == 1);
+    ct_test(pTest,
+        Test_COV_Data.subscriberProcessIdentifier == TL_COV_PROCESS_ID + 6);
+    ct_test(pTest, Test_COV_Data.monitoredObjectIdentifier.instance == 20);
+    ct_test(pTest, Test_COV_Data.lifetime == TL_COV_LIFETIME);
+    ct_test(pTest, LogRemote[6].tRenew == tNow + (TL_COV_LIFETIME / 2));
+    /* the SimpleACK */
+    tsm_free_invoke_id(Test_Invoke_ID);
+    tNow++;
+    testRun(tNow);
+    ct_test(pTest, TL_Subscribe_Count == 0);
+    ct_test(pTest, LogInfo[6].ulTotalRecordCount == ulTotal[6]);
+    Values[0].propertyIdentifier = PROP_PRESENT_VALUE;
+    Values[0].propertyArrayIndex = BACNET_ARRAY_ALL;
+    Values[0].value.tag = BACNET_APPLICATION_TAG_REAL;
+    Values[0].value.type.Real = 20.5f;
+    Values[0].next = &Values[1];
+    Values[1].propertyIdentifier = PROP_STATUS_FLAGS;
+    Values[1].propertyArrayIndex = BACNET_ARRAY_ALL;
+    Values[1].value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
+    bitstring_init(&Values[1].value.type.Bit_String);
+    bitstring_set_bit(&Values[1].value.type.Bit_String, STATUS_FLAG_IN_ALARM,
+        true);
+    Values[1].next = NULL;
+    memset(&cov_data, 0, sizeof(cov_data));
+    cov_data.subscriberProcessIdentifier = TL_COV_PROCESS_ID + 6;
+    cov_data.initiatingDeviceIdentifier = 100;
+    cov_data.monitoredObjectIdentifier.type = OBJECT_ANALOG_INPUT;
+    cov_data.monitoredObjectIdentifier.instance = 20;
+    cov_data.listOfValues = &Values[0];
+    Trend_Log_COV_Notification(&cov_data);
+    ct_test(pTest, LogInfo[6].ulTotalRecordCount == ulTotal[6] + 1);
+    ct_test(pTest, testNewest(6)->ucRecType == TL_TYPE_REAL);
+    ct_test(pTest, testNewest(6)->Datum.fReal == 20.5f);
+    ct_test(pTest,
+        testNewest(6)->ucStatus == (128 | (1 << STATUS_FLAG_IN_ALARM)));
+    /* not for one of our subscriptions */
+    cov_data.subscriberProcessIdentifier = TL_COV_PROCESS_ID + 5;
+    Trend_Log_COV_Notification(&cov_data);
+    cov_data.subscriberProcessIdentifier = TL_COV_PROCESS_ID + 6;
+    cov_data.monitoredObjectIdentifier.instance = 21;
+    Trend_Log_COV_Notification(&cov_data);
+    ct_test(pTest, LogInfo[6].ulTotalRecordCount == ulTotal[6] + 1);
+
+    /* the subscription is renewed at half its lifetime, and an error
+       is logged and tried again later */
+    tRenew = LogRemote[6].tRenew;
+    while (tNow < tRenew) {
+        tNow++;
+        testRun(tNow);
+    }
+    ct_test(pTest, Test_Subscribes == 2);
+    Trend_Log_Stats(&Stats);
+    errors = Stats.errors;
+    handler_trend_log_error(&src, Test_Invoke_ID, ERROR_CLASS_OBJECT,
+        ERROR_CODE_UNKNOWN_OBJECT);
+    tsm_free_invoke_id(Test_Invoke_ID);
+    ct_test(pTest, TL_Subscribe_Count == 0);
+    ct_test(pTest, LogInfo[6].ulTotalRecordCount == ulTotal[6] + 2);
+    ct_test(pTest, testNewest(6)->ucRecType == TL_TYPE_ERROR);
+    ct_test(pTest, LogRemote[6].tRenew == tNow + TL_COV_RETRY);
+    Trend_Log_Stats(&Stats);
+    ct_test(pTest, Stats.notifications == 1);
+    ct_test(pTest, Stats.errors == errors + 1);
+    Trend_Log_Cleanup();
+}
+
+/* Answers the requests that the poll scheduler is waiting on, one at
+   a time, until there are none */
+static void testAnswerAll(
+    Test * pTest,
+    bool bRP)
+{
+    uint8_t invoke_id;
+
+    while (poll_outstanding()) {
+        invoke_id = Test_Invoke_ID;
+        ct_test(pTest, Test_TSM[invoke_id] == TEST_TSM_WAITING);
+        ct_test(pTest, Test_RPM_Is_RP[invoke_id % TEST_RPM_KEPT] == bRP);
+        if (bRP) {
+            testRpAck(invoke_id);
+        } else {
+            testRpmAck(invoke_id);
+        }
+        poll_task(0);
+    }
+}
+
+/* A device that rejects ReadPropertyMultiple is read with ReadProperty,
+   the readings of an ack that did not fit are read again in smaller
+   requests, both by the poll scheduler, and a COV log cancels the
+   subscription that it no longer wants */
+static void testTrendLogFallback(
+    Test * pTest)
+{
+    const time_t tBase = 1500000000;
+    BACNET_APPLICATION_DATA_VALUE value;
+    BACNET_ADDRESS src;
+    uint32_t ulTotal[MAX_TREND_LOGS];
+    uint8_t invoke_id;
+    unsigned subscribes;
+    time_t tNow;
+    int iLog;
+
+    Trend_Log_Storage_Set(NULL);
+    Trend_Log_Init();
+    memset(&TL_Stats, 0, sizeof(TL_Stats));
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        LogInfo[iLog].bEnable = false;
+    }
+    address_init();
+    rpm_plan_init();
+    poll_init(NULL);
+    testDeviceAddress(30, &src);
+    address_add(30, MAX_APDU, &src);
+    testDeviceAddress(40, &src);
+    address_add(40, MAX_APDU, &src);
+    testScheduleRemote(0, 30, 10, PROP_PRESENT_VALUE);
+    testScheduleRemote(1, 30, 11, PROP_PRESENT_VALUE);
+    for (iLog = 0; iLog < MAX_TREND_LOGS; iLog++) {
+        ulTotal[iLog] = LogInfo[iLog].ulTotalRecordCount;
+    }
+    tNow = tBase + 5;
+    testRun(tNow);
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, !Test_RPM_Is_RP[invoke_id % TEST_RPM_KEPT]);
+    ct_test(pTest, Test_RPM_Count[invoke_id % TEST_RPM_KEPT] == 4);
+    /* from another device */
+    handler_poll_reject(&src, invoke_id, REJECT_REASON_UNRECOGNIZED_SERVICE);
+    ct_test(pTest, poll_outstanding() == 1);
+    testDeviceAddress(30, &src);
+    handler_poll_reject(&src, invoke_id, REJECT_REASON_UNRECOGNIZED_SERVICE);
+    tsm_free_invoke_id(invoke_id);
+    ct_test(pTest, poll_outstanding() == 0);
+    ct_test(pTest, !rpm_plan_rpm_supported(30));
+    ct_test(pTest, LogInfo[0].ulTotalRecordCount == ulTotal[0]);
+    /* each point in a ReadProperty of its own */
+    poll_task(0);
+    testAnswerAll(pTest, true);
+    ct_test(pTest, LogInfo[0].ulTotalRecordCount == ulTotal[0] + 1);
+    ct_test(pTest, testNewest(0)->tTimeStamp == tBase + 5);
+    ct_test(pTest, testNewest(0)->ucRecType == TL_TYPE_REAL);
+    ct_test(pTest, testNewest(0)->Datum.fReal == 10.25f);
+    ct_test(pTest, LogInfo[1].ulTotalRecordCount == ulTotal[1] + 1);
+    ct_test(pTest, testNewest(1)->Datum.fReal == 11.25f);
+
+    /* an ack that overflowed: its readings are read again, in requests
+       that are planned smaller */
+    LogInfo[0].bEnable = false;
+    LogInfo[1].bEnable = false;
+    TL_Schedule(0);
+    TL_Schedule(1);
+    for (iLog = 2; iLog < 6; iLog++) {
+        testScheduleRemote(iLog, 40, 20 + iLog, PROP_PRESENT_VALUE);
+        ulTotal[iLog] = LogInfo[iLog].ulTotalRecordCount;
+    }
+    while (poll_outstanding() == 0) {
+        tNow++;
+        testRun(tNow);
+    }
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_RPM_Count[invoke_id % TEST_RPM_KEPT] == 8);
+    testDeviceAddress(40, &src);
+    handler_poll_abort(&src, invoke_id, ABORT_REASON_BUFFER_OVERFLOW, true);
+    tsm_free_invoke_id(invoke_id);
+    ct_test(pTest, poll_outstanding() == 0);
+    ct_test(pTest, LogInfo[2].ulTotalRecordCount == ulTotal[2]);
+    poll_task(0);
+    ct_test(pTest, Test_RPM_Count[Test_Invoke_ID % TEST_RPM_KEPT] < 8);
+    testAnswerAll(pTest, false);
+    for (iLog = 2; iLog < 6; iLog++) {
+        ct_test(pTest, LogInfo[iLog].ulTotalRecordCount == ulTotal[iLog] + 1);
+        ct_test(pTest, testNewest(iLog)->ucRecType == TL_TYPE_REAL);
+        ct_test(pTest,
+            testNewest(iLog)->Datum.fReal == (float) (20 + iLog) + 0.25f);
+    }
+    for (iLog = 3; iLog < 6; iLog++) {
+        LogInfo[iLog].bEnable = false;
+        TL_Schedule(iLog);
+    }
+    /* a request of one point that overflowed is logged as an error */
+    LogInfo[2].Source.propertyIdentifier = PROP_STATUS_FLAGS;
+    while (poll_outstanding() == 0) {
+        tNow++;
+        testRun(tNow);
+    }
+    invoke_id = Test_Invoke_ID;
+    ct_test(pTest, Test_RPM_Count[invoke_id % TEST_RPM_KEPT] == 1);
+    handler_poll_abort(&src, invoke_id, ABORT_REASON_BUFFER_OVERFLOW, true);
+    tsm_free_invoke_id(invoke_id);
+    ct_test(pTest, poll_outstanding() == 0);
+    ct_test(pTest, LogInfo[2].ulTotalRecordCount == ulTotal[2] + 2);
+    ct_test(pTest, testNewest(2)->ucRecType == TL_TYPE_ERROR);
+    ct_test(pTest,
+        testNewest(2)->Datum.Error.usCode == ERROR_CODE_ABORT_BUFFER_OVERFLOW);
+    LogInfo[2].bEnable = false;
+    TL_Schedule(2);
+
+    /* a COV log cancels its subscription when it is disabled, and when
+       its logging type is changed */
+    testScheduleRemote(6, 40, 30, PROP_PRESENT_VALUE);
+    LogInfo[6].LoggingType = LOGGING_TYPE_COV;
+    LogInfo[6].ulLogInterval = 0;
+    TL_Schedule(6);
+    subscribes = Test_Subscribes;
+    tNow++;
+    testRun(tNow);
+    ct_test(pTest, Test_Subscribes == subscribes + 1);
+    ct_test(pTest, !Test_COV_Data.cancellationRequest);
+    tsm_free_invoke_id(Test_Invoke_ID);
+    value.tag = BACNET_APPLICATION_TAG_BOOLEAN;
+    value.type.Boolean = false;
+    ct_test(pTest, testWriteLog(6, PROP_ENABLE, &value));
+    ct_test(pTest, Test_Subscribes == subscribes + 2);
+    ct_test(pTest, Test_COV_Data.cancellationRequest);
+    ct_test(pTest,
+        Test_COV_Data.subscriberProcessIdentifier == TL_COV_PROCESS_ID + 6);
+    ct_test(pTest, Test_COV_Data.monitoredObjectIdentifier.instance == 30);
+    tsm_free_invoke_id(Test_Invoke_ID);
+    tNow++;
+    testRun(tNow);
+    ct_test(pTest, TL_Subscribe_Count == 0);
+    ct_test(pTest, Test_Subscribes == subscribes + 2);
+    value.type.Boolean = true;
+    ct_test(pTest, testWriteLog(6, PROP_ENABLE, &value));
+    tNow++;
+    testRun(tNow);
+    ct_test(pTest, Test_Subscribes == subscribes + 3);
+    ct_test(pTest, !Test_COV_Data.cancellationRequest);
+    tsm_free_invoke_id(Test_Invoke_ID);
+    value.tag = BACNET_APPLICATION_TAG_ENUMERATED;
+    value.type.Enumerated = LOGGING_TYPE_COV;
+    ct_test(pTest, testWriteLog(6, PROP_LOGGING_TYPE, &value));
+    ct_test(pTest, Test_Subscribes == subscribes + 3);
+    value.type.Enumerated = LOGGING_TYPE_POLLED;
+    ct_test(pTest, testWriteLog(6, PROP_LOGGING_TYPE, &value));
+    ct_test(pTest, Test_Subscribes == subscribes + 4);
+    ct_test(pTest, Test_COV_Data.cancellationRequest);
+    tsm_free_invoke_id(Test_Invoke_ID);
+    /* ...and only once */
+    value.tag = BACNET_APPLICATION_TAG_BOOLEAN;
+    value.type.Boolean = false;
+    ct_test(pTest, testWriteLog(6, PROP_ENABLE, &value));
+    ct_test(pTest, Test_Subscribes == subscribes + 4);
+    Trend_Log_Cleanup();
+}
+
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("BACnet Trend Log", NULL);
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testTrendLogRecover);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testTrendLogFile);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testTrendLogByTime);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testTrendLogSetBack);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testTrendLogSchedule);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testTrendLogRemote);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testTrendLogFallback);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+    ct_destroy(pTest);
+
+    return 0;
 }
+#endif /* TEST_TREND_LOG */
+#endif /* TEST */
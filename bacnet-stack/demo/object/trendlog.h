@@ -29,6 +29,7 @@
 #include <stdint.h>
 #include <time.h>       /* for time_t */
 #include "bacdef.h"
+#include "apdu.h"
 #include "cov.h"
 #include "rp.h"
 #include "wp.h"
@@ -80,7 +81,13 @@ extern "C" {
 #define TL_T_START_WILD 1       /* Start time is wild carded */
 #define TL_T_STOP_WILD  2       /* Stop Time is wild carded */
 
-#define TL_MAX_ENTRIES 1000     /* Entries per datalog */
+/* Buffer_Size of a new log, and the largest that can be set */
+#ifndef TL_MAX_ENTRIES
+#define TL_MAX_ENTRIES 1000
+#endif
+#ifndef TL_MAX_BUFFER_SIZE
+#define TL_MAX_BUFFER_SIZE 1000000
+#endif
 
 /* Structure containing config and status info for a Trend Log */
 
@@ -94,6 +101,7 @@ extern "C" {
         BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE Source; /* Where the data comes from */
         uint32_t ulLogInterval; /* Time between entries in seconds */
         bool bStopWhenFull;     /* Log halts when full if true */
+        uint32_t ulBufferSize;  /* Count of items the buffer can hold */
         uint32_t ulRecordCount; /* Count of items currently in the buffer */
         uint32_t ulTotalRecordCount;    /* Count of all items that have ever been inserted into the buffer */
         BACNET_LOGGING_TYPE LoggingType;        /* Polled/cov/triggered */
@@ -104,6 +112,31 @@ extern "C" {
         time_t tLastDataTime;
     } TL_LOG_INFO;
 
+/* Counters of the sampling of the logs.  Times are in seconds, the
+   ticks of the scheduler run by trend_log_timer(). */
+    typedef struct trend_log_stats {
+        uint32_t ticks;
+        /* ticks with at least one log due, and the most logs in one */
+        uint32_t batches;
+        uint32_t batch_max;
+        /* readings taken, and those from the value list of the object */
+        uint32_t samples;
+        uint32_t fast_samples;
+        /* intervals of polled logs that passed without a reading */
+        uint32_t missed;
+        /* time from when a reading was due to when it was taken */
+        uint32_t lag_max;
+        uint64_t lag_total;
+        /* readings of remote sources and SubscribeCOV requests, those
+           that were answered, and those that failed or got no reply */
+        uint32_t requests;
+        uint32_t replies;
+        uint32_t errors;
+        uint32_t timeouts;
+        /* readings logged from COV notifications */
+        uint32_t notifications;
+    } TREND_LOG_STATS;
+
 /*
  * Data types associated with a BACnet Log Record. We use these for managing the
  * log buffer but they are also the tag numbers to use when encoding/decoding
@@ -150,6 +183,16 @@ extern "C" {
         BACNET_WRITE_PROPERTY_DATA * wp_data);
     void Trend_Log_Init(
         void);
+    void Trend_Log_Cleanup(
+        void);
+
+    bool Trend_Log_Storage_Set(
+        const char *directory);
+    uint32_t Trend_Log_Buffer_Size(
+        uint32_t object_instance);
+    bool Trend_Log_Buffer_Size_Set(
+        uint32_t object_instance,
+        uint32_t buffer_size);
 
     void TL_Insert_Status_Rec(
         int iLog,
@@ -193,6 +236,25 @@ extern "C" {
 
     void trend_log_timer(
         uint16_t uSeconds);
+    void Trend_Log_Stats(
+        TREND_LOG_STATS * stats);
+
+    void Trend_Log_COV_Notification(
+        BACNET_COV_DATA * cov_data);
+    void handler_trend_log_error(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id,
+        BACNET_ERROR_CLASS error_class,
+        BACNET_ERROR_CODE error_code);
+    void handler_trend_log_abort(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id,
+        uint8_t abort_reason,
+        bool server);
+    void handler_trend_log_reject(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id,
+        uint8_t reject_reason);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,59 @@
+#Makefile to build benchmark
+CC      = gcc
+SRC_DIR = ../../src
+TEST_DIR = ../../test
+HANDLER_DIR = ../handler
+INCLUDES = -I../../include -I$(TEST_DIR) -I. -I$(HANDLER_DIR)
+DEFINES = -DBIG_ENDIAN=0 -DBACDL_ALL
+# only the trend log is built with its tests, for their helpers
+trendlog.o: DEFINES += -DTEST -DTEST_TREND_LOG_BENCH
+# the RPM ack handler is built as it is for the library, with the
+# value printing that it uses
+$(HANDLER_DIR)/h_rpm_a.o $(SRC_DIR)/bacapp.o $(SRC_DIR)/bacstr.o: DEFINES += -DPRINT_ENABLED=1
+
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -O2
+
+SRCS = trendlog.c \
+	$(SRC_DIR)/bacdcode.c \
+	$(SRC_DIR)/bacint.c \
+	$(SRC_DIR)/bacstr.c \
+	$(SRC_DIR)/bacreal.c \
+	$(SRC_DIR)/bacapp.c \
+	$(SRC_DIR)/bacdevobjpropref.c \
+	$(SRC_DIR)/bactext.c \
+	$(SRC_DIR)/indtext.c \
+	$(SRC_DIR)/datetime.c \
+	$(SRC_DIR)/lighting.c \
+	$(SRC_DIR)/memcopy.c \
+	$(SRC_DIR)/bacerror.c \
+	$(SRC_DIR)/address.c \
+	$(SRC_DIR)/hashindex.c \
+	$(SRC_DIR)/bacaddr.c \
+	$(SRC_DIR)/rp.c \
+	$(SRC_DIR)/rpm.c \
+	$(SRC_DIR)/rpmplan.c \
+	$(HANDLER_DIR)/h_rpm_a.c \
+	$(HANDLER_DIR)/pollsched.c \
+	$(SRC_DIR)/iam.c \
+	$(TEST_DIR)/ctest.c
+
+TARGET = trendlog_bench
+
+all: ${TARGET}
+
+OBJS = ${SRCS:.c=.o}
+
+${TARGET}: ${OBJS}
+	${CC} -o $@ ${OBJS}
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+
+clean:
+	rm -rf core ${TARGET} $(OBJS)
+
+include: .depend
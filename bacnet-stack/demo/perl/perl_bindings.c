@@ -244,7 +244,7 @@ void rpm_ack_extract_data(
 
 static void AtomicReadFileAckHandler(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
@@ -295,7 +295,7 @@ static void AtomicReadFileAckHandler(
  */
 static void My_Read_Property_Ack_Handler(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
@@ -325,7 +325,7 @@ static void My_Read_Property_Ack_Handler(
  */
 static void My_Read_Property_Multiple_Ack_Handler(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
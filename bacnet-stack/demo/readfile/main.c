@@ -110,19 +110,23 @@ void MyRejectHandler(
 
 static void AtomicReadFileAckHandler(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
     int len = 0;
     int result = 0;
     BACNET_ATOMIC_READ_FILE_DATA data;
+    /* the file data points into the service_request */
+    BACNET_OCTET_STRING_VIEW file_data[BACNET_READ_FILE_RECORD_COUNT];
     FILE *pFile = NULL; /* stream pointer */
     size_t octets_written = 0;
 
     if (address_match(&Target_Address, src) &&
         (service_data->invoke_id == Request_Invoke_ID)) {
-        len = arf_ack_decode_service_request(service_request, service_len, &data);
+        len =
+            arf_ack_decode_service_request_view(service_request, service_len,
+            &data, file_data);
         if ((len > 0) && (data.access == FILE_STREAM_ACCESS)) {
             if (data.type.stream.fileStartPosition == 0) {
                 pFile = fopen(Local_File_Name, "wb");
@@ -135,11 +139,9 @@ static void AtomicReadFileAckHandler(
                 if (result == 0) {
                     /* unit to write in bytes -
                        in our case, an octet is one byte */
-                    octets_written = fwrite(
-                        octetstring_value(&data.fileData[0]), 1,
-                        octetstring_length(&data.fileData[0]), pFile);
-                    if (octets_written !=
-                        octetstring_length(&data.fileData[0])) {
+                    octets_written = fwrite(file_data[0].value, 1,
+                        file_data[0].length, pFile);
+                    if (octets_written != file_data[0].length) {
                         fprintf(stderr,
                             "Unable to write data to file \"%s\".\n",
                             Local_File_Name);
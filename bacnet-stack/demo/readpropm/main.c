@@ -124,65 +124,29 @@ void MyRejectHandler(
  */
 void My_Read_Property_Multiple_Ack_Handler(
     uint8_t * service_request,
-    uint16_t service_len,
+    uint32_t service_len,
     BACNET_ADDRESS * src,
     BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
 {
+    BACNET_RPM_ACK_ARENA arena;
     int len = 0;
-    BACNET_READ_ACCESS_DATA *rpm_data;
-    BACNET_READ_ACCESS_DATA *old_rpm_data;
-    BACNET_PROPERTY_REFERENCE *rpm_property;
-    BACNET_PROPERTY_REFERENCE *old_rpm_property;
-    BACNET_APPLICATION_DATA_VALUE *value;
-    BACNET_APPLICATION_DATA_VALUE *old_value;
+    BACNET_READ_ACCESS_DATA *rpm_data = NULL;
 
     if (address_match(&Target_Address, src) &&
         (service_data->invoke_id == Request_Invoke_ID)) {
-        rpm_data = calloc(1, sizeof(BACNET_READ_ACCESS_DATA));
-        if (rpm_data) {
-            len =
-                rpm_ack_decode_service_request(service_request, service_len,
-                rpm_data);
-        }
+        rpm_ack_arena_init(&arena, NULL, 0);
+        len =
+            rpm_ack_decode_service_request_arena(service_request, service_len,
+            &arena, &rpm_data);
         if (len > 0) {
             while (rpm_data) {
                 rpm_ack_print_data(rpm_data);
-                rpm_property = rpm_data->listOfProperties;
-                while (rpm_property) {
-                    value = rpm_property->value;
-                    while (value) {
-                        old_value = value;
-                        value = value->next;
-                        free(old_value);
-                    }
-                    old_rpm_property = rpm_property;
-                    rpm_property = rpm_property->next;
-                    free(old_rpm_property);
-                }
-                old_rpm_data = rpm_data;
                 rpm_data = rpm_data->next;
-                free(old_rpm_data);
             }
         } else {
             fprintf(stderr, "RPM Ack Malformed! Freeing memory...\n");
-            while (rpm_data) {
-                rpm_property = rpm_data->listOfProperties;
-                while (rpm_property) {
-                    value = rpm_property->value;
-                    while (value) {
-                        old_value = value;
-                        value = value->next;
-                        free(old_value);
-                    }
-                    old_rpm_property = rpm_property;
-                    rpm_property = rpm_property->next;
-                    free(old_rpm_property);
-                }
-                old_rpm_data = rpm_data;
-                rpm_data = rpm_data->next;
-                free(old_rpm_data);
-            }
         }
+        rpm_ack_arena_free(&arena);
     }
 }
 
@@ -71,7 +71,8 @@ void *dl_ip_thread(
         return NULL;
     }
 
-    msgboxid = create_msgbox();
+    /* only the router thread sends to a port */
+    msgboxid = create_msgbox_spsc();
     if (msgboxid == INVALID_MSGBOX_ID) {
         PRINT(ERROR, "Error: Failed to create message box");
         port->state = INIT_FAILED;
@@ -119,8 +120,12 @@ void *dl_ip_thread(
                     break;
             }
         } else {
-            status = dl_ip_recv(&ip_data, &msg_data, &address, 5);
-            if (status > 0) {
+            status = dl_ip_recv(&ip_data, &msg_data, &address, 0);
+            if (status <= 0) {
+                /* sleep until the router sends a message or a packet
+                   arrives */
+                wait_for_msgbox(port->port_id, ip_data.socket, -1);
+            } else {
                 memmove(&msg_data->src.len, &address.mac_len, 1);
                 memmove(&msg_data->src.adr[0], &address.mac[0], MAX_MAC_LEN);
                 msg_storage.origin = port->port_id;
@@ -339,10 +344,9 @@ int dl_ip_recv(
                     buff_len -= 4;
                     if (buff_len < data->max_buff) {
                         /* allocate data message stucture */
-                        (*msg_data) = (MSG_DATA *) malloc(sizeof(MSG_DATA));
+                        (*msg_data) = alloc_data();
                         (*msg_data)->pdu_len = buff_len;
-                        (*msg_data)->pdu =
-                            (uint8_t *) malloc((*msg_data)->pdu_len);
+                        (*msg_data)->pdu = alloc_pdu((*msg_data)->pdu_len);
                         /* fill up data message structure */
                         memmove(&(*msg_data)->pdu[0], &data->buff[4],
                             (*msg_data)->pdu_len);
@@ -376,10 +380,9 @@ int dl_ip_recv(
                     buff_len -= 10;
                     if (buff_len < data->max_buff) {
                         /* allocate data message stucture */
-                        (*msg_data) = (MSG_DATA *) malloc(sizeof(MSG_DATA));
+                        (*msg_data) = alloc_data();
                         (*msg_data)->pdu_len = buff_len;
-                        (*msg_data)->pdu =
-                            (uint8_t *) malloc((*msg_data)->pdu_len);
+                        (*msg_data)->pdu = alloc_pdu((*msg_data)->pdu_len);
                         /* fill up data message structure */
                         memmove(&(*msg_data)->pdu[0], &data->buff[4 + 6],
                             (*msg_data)->pdu_len);
@@ -50,11 +50,23 @@
 #include "msgqueue.h"
 #include "portthread.h"
 #include "network_layer.h"
+#include "routing_table.h"
+#include "timer.h"
 #include "ipmodule.h"
 #include "mstpmodule.h"
+#include "mstp_engine.h"
 
 #define KEY_ESC 27
 
+/* how often the routing table is aged */
+#define ROUTER_TIMER_MS 1000
+
+/* SCHED_FIFO priority of the thread that runs all the MS/TP ports,
+   or 0 for the default policy */
+#ifndef ROUTER_MSTP_PRIORITY
+#define ROUTER_MSTP_PRIORITY 0
+#endif
+
 ROUTER_PORT *head = NULL;       /* pointer to list of router ports */
 
 int port_count;
@@ -86,6 +98,12 @@ uint16_t process_msg(
     MSG_DATA * data,
     uint8_t ** buff);
 
+void route_msg(
+    BACMSG * msg);
+
+void route_held_msgs(
+    );
+
 uint16_t get_next_free_dnet(
     );
 
@@ -101,11 +119,11 @@ int main(
 {
     printf("I am router\n");
 
-    ROUTER_PORT *port;
     BACMSG msg_storage, *bacmsg = NULL;
     MSG_DATA *msg_data = NULL;
     uint8_t *buff = NULL;
-    int16_t buff_len = 0;
+    int stdin_fd = STDIN_FILENO;
+    uint32_t last_time, now;
 
     atexit(cleanup);
 
@@ -123,104 +141,172 @@ int main(
     send_network_message(NETWORK_MESSAGE_I_AM_ROUTER_TO_NETWORK, msg_data,
         &buff, NULL);
 
+    kbhit();    /* turn off line buffering before waiting on stdin */
+    last_time = timeGetTime();
     while (true) {
-        if (kbhit()) {
-            char ch = getchar();
-            if (ch == KEY_ESC) {
-                PRINT(INFO, "Received shutdown. Exiting...\n");
-                break;
-            }
+        now = timeGetTime();
+        if ((now - last_time) >= ROUTER_TIMER_MS) {
+            /* age the routes, and forward messages for networks that
+               are no longer busy */
+            routing_table_timer(now - last_time);
+            last_time = now;
+            route_held_msgs();
         }
 
         bacmsg = recv_from_msgbox(head->main_id, &msg_storage);
-        if (bacmsg) {
-            switch (bacmsg->type) {
-                case DATA:
-                    {
-                        MSGBOX_ID msg_src = bacmsg->origin;
-
-                        /* allocate message structure */
-                        msg_data = malloc(sizeof(MSG_DATA));
-                        if (!msg_data) {
-                            PRINT(ERROR, "Error: Could not allocate memory\n");
-                            break;
-                        }
+        if (!bacmsg) {
+            /* sleep until a port sends a message or a key is pressed */
+            if (wait_for_msgbox(head->main_id, stdin_fd, ROUTER_TIMER_MS)) {
+                if (kbhit()) {
+                    char ch = getchar();
+                    if (ch == KEY_ESC) {
+                        PRINT(INFO, "Received shutdown. Exiting...\n");
+                        break;
+                    }
+                } else {
+                    /* end of input, stop watching it */
+                    stdin_fd = -1;
+                }
+            }
+            continue;
+        }
 
-                        print_msg(bacmsg);
+        switch (bacmsg->type) {
+            case DATA:
+                if (is_network_msg(bacmsg)) {
+                    route_msg(bacmsg);
+                    /* the routing table may have learned a route */
+                    route_held_msgs();
+                } else {
+                    route_msg(bacmsg);
+                }
+                break;
+            case SERVICE:
+            default:
+                break;
+        }
+    }
 
-                        if (is_network_msg(bacmsg)) {
-                            buff_len =
-                                process_network_message(bacmsg, msg_data,
-                                &buff);
-                            if (buff_len == 0) {
-                                free_data(bacmsg->data);
-                                break;
-                            }
-                        } else {
-                            buff_len = process_msg(bacmsg, msg_data, &buff);
-                        }
+    return 0;
 
-                        /* if buff_len */
-                        /* >0 - form new message and send */
-                        /* =-1 - try to find next router */
-                        /* other value - discard message */
-
-                        if (buff_len > 0) {
-                            /* form new message */
-                            msg_data->pdu = buff;
-                            msg_data->pdu_len = buff_len;
-                            msg_storage.origin = head->main_id;
-                            msg_storage.type = DATA;
-                            msg_storage.data = msg_data;
-
-                            print_msg(bacmsg);
-
-                            if (is_network_msg(bacmsg)) {
-                                msg_data->ref_count = 1;
-                                send_to_msgbox(msg_src, &msg_storage);
-                            } else if (msg_data->dest.net !=
-                                BACNET_BROADCAST_NETWORK) {
-                                msg_data->ref_count = 1;
-                                port =
-                                    find_dnet(msg_data->dest.net,
-                                    &msg_data->dest);
-                                send_to_msgbox(port->port_id, &msg_storage);
-                            } else {
-                                port = head;
-                                msg_data->ref_count = port_count - 1;
-                                while (port != NULL) {
-                                    if (port->port_id == msg_src ||
-                                        port->state == FINISHED) {
-                                        port = port->next;
-                                        continue;
-                                    }
-                                    send_to_msgbox(port->port_id,
-                                        &msg_storage);
-                                    port = port->next;
-                                }
-                            }
-                        } else if (buff_len == -1) {
-                            uint16_t net = msg_data->dest.net;  /* NET to find */
-                            PRINT(INFO, "Searching NET...\n");
-                            send_network_message
-                                (NETWORK_MESSAGE_WHO_IS_ROUTER_TO_NETWORK,
-                                msg_data, &buff, &net);
-                        } else {
-                            /* if invalid message send Reject-Message-To-Network */
-                            PRINT(ERROR, "Error: Invalid message\n");
-                            free_data(msg_data);
-                        }
-                    }
-                    break;
-                case SERVICE:
-                default:
-                    break;
+}
+
+void route_msg(
+    BACMSG * bacmsg)
+{
+    ROUTER_PORT *port;
+    BACMSG msg_storage;
+    MSGBOX_ID msg_src = bacmsg->origin;
+    MSG_DATA *rx_data = (MSG_DATA *) bacmsg->data;
+    MSG_DATA *msg_data;
+    uint8_t *buff = NULL;
+    int16_t buff_len = 0;
+    bool network_msg = is_network_msg(bacmsg);
+
+    /* allocate message structure */
+    msg_data = alloc_data();
+    if (!msg_data) {
+        PRINT(ERROR, "Error: Could not allocate memory\n");
+        check_data(rx_data);
+        return;
+    }
+
+    print_msg(bacmsg);
+
+    if (network_msg) {
+        buff_len = process_network_message(bacmsg, msg_data, &buff);
+        /* msg_data holds a copy, so return the received buffers to the pool */
+        msg_data->pdu = NULL;
+        free_data(rx_data);
+        if (buff_len == 0) {
+            free_data(msg_data);
+            return;
+        }
+    } else {
+        buff_len = process_msg(bacmsg, msg_data, &buff);
+        if (buff_len == -1) {
+            uint16_t net = msg_data->dest.net;
+            /* a busy network is known, and one already held is being
+               searched for */
+            bool searching = routing_table_held(net) ||
+                routing_table_find(net);
+
+            /* hold the message until the route is found or available */
+            msg_data->pdu = NULL;
+            if (!routing_table_hold(net, msg_src, rx_data)) {
+                PRINT(ERROR, "Error: Too many held messages\n");
+                free_data(rx_data);
+            }
+            if (searching) {
+                free_data(msg_data);
+                return;
             }
         }
     }
 
-    return 0;
+    /* if buff_len */
+    /* >0 - form new message and send */
+    /* =-1 - try to find next router */
+    /* other value - discard message */
+
+    if (buff_len > 0) {
+        /* form new message */
+        msg_data->pdu = buff;
+        msg_data->pdu_len = buff_len;
+        msg_storage.origin = head->main_id;
+        msg_storage.type = DATA;
+        msg_storage.data = msg_data;
+
+        print_msg(&msg_storage);
+
+        if (network_msg) {
+            msg_data->ref_count = 1;
+            if (!send_to_msgbox(msg_src, &msg_storage)) {
+                check_data(msg_data);
+            }
+        } else if (msg_data->dest.net != BACNET_BROADCAST_NETWORK) {
+            msg_data->ref_count = 1;
+            port = find_dnet(msg_data->dest.net, &msg_data->dest);
+            if (!send_to_msgbox(port->port_id, &msg_storage)) {
+                check_data(msg_data);
+            }
+        } else {
+            port = head;
+            msg_data->ref_count = port_count - 1;
+            while (port != NULL) {
+                if (port->port_id == msg_src || port->state == FINISHED) {
+                    port = port->next;
+                    continue;
+                }
+                if (!send_to_msgbox(port->port_id, &msg_storage)) {
+                    check_data(msg_data);
+                }
+                port = port->next;
+            }
+        }
+    } else if (buff_len == -1) {
+        uint16_t net = msg_data->dest.net;      /* NET to find */
+        PRINT(INFO, "Searching NET...\n");
+        send_network_message(NETWORK_MESSAGE_WHO_IS_ROUTER_TO_NETWORK,
+            msg_data, &buff, &net);
+    } else {
+        /* if invalid message send Reject-Message-To-Network */
+        PRINT(ERROR, "Error: Invalid message\n");
+        free_data(msg_data);
+    }
+}
 
+/* forward the held messages whose networks can now be reached */
+void route_held_msgs(
+    )
+{
+    BACMSG msg;
+
+    msg.type = DATA;
+    msg.subtype = (MSGSUBTYPE) 0;
+    while ((msg.data = routing_table_release(&msg.origin)) != NULL) {
+        route_msg(&msg);
+    }
 }
 
 void print_help(
@@ -711,6 +797,10 @@ bool init_router(
         port = port->next;
     }
 
+    /* the MS/TP ports add themselves to the engine */
+    if (!mstp_engine_init() || !mstp_engine_start(ROUTER_MSTP_PRIORITY)) {
+        return false;
+    }
     init_port_threads(head);
 
     /* wait for port initialization */
@@ -729,6 +819,18 @@ bool init_router(
         }
     }
 
+    /* directly connected networks */
+    routing_table_init();
+    port = head;
+    while (port != NULL) {
+        if (!routing_table_add_port(port)) {
+            PRINT(ERROR, "Error: Failed to add NET %u\n",
+                (unsigned) port->route_info.net);
+            return false;
+        }
+        port = port->next;
+    }
+
     return true;
 }
 
@@ -746,6 +848,7 @@ void cleanup(
     msg.subtype = SHUTDOWN;
 
     del_msgbox(head->main_id);  /* close routers message box */
+    routing_table_cleanup();    /* discard held messages */
 
     /* send shutdown message to all router ports */
     port = head;
@@ -758,15 +861,13 @@ void cleanup(
     port = head;
     while (port != NULL) {
         if (port->state == FINISHED) {
-            cleanup_dnets(port->route_info.dnets);
             port = port->next;
             free(head->iface);
             free(head);
             head = port;
         }
     }
-
-    pthread_mutex_destroy(&msg_lock);
+    mstp_engine_cleanup();
 }
 
 void print_msg(
@@ -829,7 +930,7 @@ uint16_t process_msg(
 
         buff_len = npdu_len + data->pdu_len - apdu_offset;
 
-        *buff = (uint8_t *) malloc(buff_len);
+        *buff = alloc_pdu(buff_len);
         memmove(*buff, npdu, npdu_len); /* copy newly formed NPDU */
         memmove(*buff + npdu_len, &data->pdu[apdu_offset], apdu_len);   /* copy APDU */
 
@@ -30,35 +30,248 @@
 #include <errno.h>
 #include <string.h>
 #include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
 #include <pthread.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include "msgqueue.h"
 
-pthread_mutex_t msg_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Bounded lock-free ring (D. Vyukov's MPMC queue): every cell has a
+   sequence number that tells producers and consumers whose turn it is,
+   so neither side takes a lock.  A box with one producer skips the
+   compare-and-swap on the enqueue position. */
+typedef struct _msg_cell {
+    uint32_t sequence;
+    BACMSG msg;
+} MSG_CELL;
+
+typedef struct _msg_ring {
+    uint32_t enqueue_pos;
+    uint8_t pad1[60];   /* keep producers and consumers on their own lines */
+    uint32_t dequeue_pos;
+    uint8_t pad2[60];
+    uint32_t mask;
+    bool single_producer;
+    MSG_CELL *cells;
+} MSG_RING;
+
+typedef struct _msgbox {
+    bool valid;
+    MSG_RING ring;
+    MSG_CELL cells[MSGBOX_SIZE];
+    /* eventfd that is written when a message arrives while the
+       receiver sleeps */
+    int event_fd;
+    int sleeping;
+} MSGBOX;
+
+static MSGBOX Msgbox[MSGBOX_MAX];
+
+/* the pools are rings of free buffers; a buffer travels as msg.data */
+static MSG_RING Data_Pool;
+static MSG_CELL Data_Pool_Cells[MSG_POOL_COUNT];
+static MSG_DATA Data_Pool_Buffers[MSG_POOL_COUNT];
+static MSG_RING PDU_Pool;
+static MSG_CELL PDU_Pool_Cells[MSG_POOL_COUNT];
+static uint8_t PDU_Pool_Buffers[MSG_POOL_COUNT][MSG_POOL_PDU_SIZE];
+static pthread_once_t Pool_Once = PTHREAD_ONCE_INIT;
+
+/* how many times a sender yields to a full box before giving up */
+#ifndef MSGBOX_SEND_RETRIES
+#define MSGBOX_SEND_RETRIES 1000
+#endif
+
+static void ring_init(
+    MSG_RING * ring,
+    MSG_CELL * cells,
+    uint32_t size,
+    bool single_producer)
+{
+    uint32_t i;
+
+    for (i = 0; i < size; i++) {
+        __atomic_store_n(&cells[i].sequence, i, __ATOMIC_RELAXED);
+    }
+    ring->cells = cells;
+    ring->mask = size - 1;
+    ring->single_producer = single_producer;
+    __atomic_store_n(&ring->enqueue_pos, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->dequeue_pos, 0, __ATOMIC_RELEASE);
+}
+
+static bool ring_put(
+    MSG_RING * ring,
+    BACMSG * msg)
+{
+    MSG_CELL *cell;
+    uint32_t pos;
+    uint32_t seq;
+    int32_t dif;
+
+    pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        cell = &ring->cells[pos & ring->mask];
+        seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        dif = (int32_t) (seq - pos);
+        if (dif == 0) {
+            if (ring->single_producer) {
+                __atomic_store_n(&ring->enqueue_pos, pos + 1,
+                    __ATOMIC_RELAXED);
+                break;
+            }
+            if (__atomic_compare_exchange_n(&ring->enqueue_pos, &pos,
+                    pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (dif < 0) {
+            /* full */
+            return false;
+        } else {
+            pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    cell->msg = *msg;
+    __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static bool ring_get(
+    MSG_RING * ring,
+    BACMSG * msg)
+{
+    MSG_CELL *cell;
+    uint32_t pos;
+    uint32_t seq;
+    int32_t dif;
+
+    pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+    for (;;) {
+        cell = &ring->cells[pos & ring->mask];
+        seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+        dif = (int32_t) (seq - (pos + 1));
+        if (dif == 0) {
+            if (__atomic_compare_exchange_n(&ring->dequeue_pos, &pos,
+                    pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (dif < 0) {
+            /* empty */
+            return false;
+        } else {
+            pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+        }
+    }
+    *msg = cell->msg;
+    __atomic_store_n(&cell->sequence, pos + ring->mask + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+static bool ring_empty(
+    MSG_RING * ring)
+{
+    uint32_t pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+    MSG_CELL *cell = &ring->cells[pos & ring->mask];
+
+    return (__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) != pos + 1);
+}
+
+static void pool_init(
+    void)
+{
+    BACMSG msg = { 0 };
+    unsigned i;
+
+    ring_init(&Data_Pool, Data_Pool_Cells, MSG_POOL_COUNT, false);
+    ring_init(&PDU_Pool, PDU_Pool_Cells, MSG_POOL_COUNT, false);
+    for (i = 0; i < MSG_POOL_COUNT; i++) {
+        msg.data = &Data_Pool_Buffers[i];
+        ring_put(&Data_Pool, &msg);
+        msg.data = &PDU_Pool_Buffers[i][0];
+        ring_put(&PDU_Pool, &msg);
+    }
+}
+
+static MSGBOX_ID msgbox_create(
+    bool single_producer)
+{
+    MSGBOX_ID i;
+    int fd;
+
+    pthread_once(&Pool_Once, pool_init);
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0) {
+        return INVALID_MSGBOX_ID;
+    }
+    for (i = 0; i < MSGBOX_MAX; i++) {
+        bool expected = false;
+
+        /* claim a free box - port threads create theirs at the same time */
+        if (__atomic_compare_exchange_n(&Msgbox[i].valid, &expected, true,
+                false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            ring_init(&Msgbox[i].ring, Msgbox[i].cells, MSGBOX_SIZE,
+                single_producer);
+            Msgbox[i].sleeping = 0;
+            Msgbox[i].event_fd = fd;
+            return i;
+        }
+    }
+    close(fd);
+
+    return INVALID_MSGBOX_ID;
+}
 
 MSGBOX_ID create_msgbox(
     )
 {
-    MSGBOX_ID msgboxid;
+    return msgbox_create(false);
+}
 
-    msgboxid = msgget(IPC_PRIVATE, 0666 | IPC_CREAT);
-    if (msgboxid == INVALID_MSGBOX_ID) {
-        return INVALID_MSGBOX_ID;
+MSGBOX_ID create_msgbox_spsc(
+    )
+{
+    return msgbox_create(true);
+}
+
+static MSGBOX *msgbox_get(
+    MSGBOX_ID id)
+{
+    if ((id < 0) || (id >= MSGBOX_MAX) ||
+        !__atomic_load_n(&Msgbox[id].valid, __ATOMIC_ACQUIRE)) {
+        return NULL;
     }
 
-    return msgboxid;
+    return &Msgbox[id];
 }
 
 bool send_to_msgbox(
     MSGBOX_ID dest,
     BACMSG * msg)
 {
+    MSGBOX *box = msgbox_get(dest);
+    uint64_t one = 1;
+    unsigned retries = 0;
 
-    int err;
-
-    err = msgsnd(dest, msg, sizeof(BACMSG)-sizeof(MSGTYPE), 0);
-    if (err) {
+    if (!box) {
         return false;
     }
+    /* like a blocking msgsnd, give the receiver a chance to catch up */
+    while (!ring_put(&box->ring, msg)) {
+        if (++retries > MSGBOX_SEND_RETRIES) {
+            return false;
+        }
+        sched_yield();
+    }
+    /* only pay for the syscall when the receiver is asleep */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_exchange_n(&box->sleeping, 0, __ATOMIC_SEQ_CST)) {
+        if (write(box->event_fd, &one, sizeof(one)) < 0) {
+            /* the counter is already non-zero, so the receiver wakes */
+        }
+    }
+
     return true;
 }
 
@@ -66,49 +279,458 @@ BACMSG *recv_from_msgbox(
     MSGBOX_ID src,
     BACMSG * msg)
 {
+    MSGBOX *box = msgbox_get(src);
 
-    int recv_bytes;
-
-    recv_bytes = msgrcv(src, msg, sizeof(BACMSG)-sizeof(MSGTYPE), 0, IPC_NOWAIT);
-    if (recv_bytes > 0) {
+    if (box && ring_get(&box->ring, msg)) {
         return msg;
-    } else {
-        return NULL;
     }
+
+    return NULL;
+}
+
+bool wait_for_msgbox(
+    MSGBOX_ID src,
+    int fd,
+    int timeout)
+{
+    MSGBOX *box = msgbox_get(src);
+    struct pollfd fds[2];
+    uint64_t count;
+    nfds_t nfds = 0;
+
+    if (box) {
+        __atomic_store_n(&box->sleeping, 1, __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (!ring_empty(&box->ring)) {
+            /* a message arrived after the last receive */
+            __atomic_store_n(&box->sleeping, 0, __ATOMIC_SEQ_CST);
+            return false;
+        }
+        fds[nfds].fd = box->event_fd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+    }
+    if (fd >= 0) {
+        fds[nfds].fd = fd;
+        fds[nfds].events = POLLIN;
+        nfds++;
+    }
+    if (poll(fds, nfds, timeout) < 0) {
+        nfds = 0;
+    }
+    if (box) {
+        __atomic_store_n(&box->sleeping, 0, __ATOMIC_SEQ_CST);
+        if (read(box->event_fd, &count, sizeof(count)) < 0) {
+            /* nothing to clear */
+        }
+    }
+
+    return (fd >= 0) && (nfds > 0) && (fds[nfds - 1].revents & POLLIN);
 }
 
 void del_msgbox(
     MSGBOX_ID msgboxid)
 {
+    MSGBOX *box = msgbox_get(msgboxid);
 
-    if (msgboxid == INVALID_MSGBOX_ID)
-        return;
-    else
-        msgctl(msgboxid, IPC_RMID, NULL);
+    if (box) {
+        /* retire the box before its eventfd, so that a sender that
+           still sees it valid never writes to a closed descriptor */
+        __atomic_store_n(&box->valid, false, __ATOMIC_RELEASE);
+        close(box->event_fd);
+        box->event_fd = -1;
+    }
+}
+
+MSG_DATA *alloc_data(
+    )
+{
+    BACMSG msg;
+    MSG_DATA *data = NULL;
+
+    pthread_once(&Pool_Once, pool_init);
+    if (ring_get(&Data_Pool, &msg)) {
+        data = (MSG_DATA *) msg.data;
+    } else {
+        data = (MSG_DATA *) malloc(sizeof(MSG_DATA));
+    }
+    if (data) {
+        memset(data, 0, sizeof(MSG_DATA));
+    }
+
+    return data;
+}
+
+uint8_t *alloc_pdu(
+    uint16_t pdu_len)
+{
+    BACMSG msg;
+
+    pthread_once(&Pool_Once, pool_init);
+    if ((pdu_len <= MSG_POOL_PDU_SIZE) && ring_get(&PDU_Pool, &msg)) {
+        return (uint8_t *) msg.data;
+    }
+
+    return (uint8_t *) malloc(pdu_len);
+}
+
+static bool is_pool_data(
+    MSG_DATA * data)
+{
+    return (data >= &Data_Pool_Buffers[0]) &&
+        (data < &Data_Pool_Buffers[MSG_POOL_COUNT]);
+}
+
+static bool is_pool_pdu(
+    uint8_t * pdu)
+{
+    return (pdu >= &PDU_Pool_Buffers[0][0]) &&
+        (pdu < &PDU_Pool_Buffers[0][0] + sizeof(PDU_Pool_Buffers));
 }
 
 void free_data(
     MSG_DATA * data)
 {
+    BACMSG msg = { 0 };
 
+    if (!data) {
+        return;
+    }
     if (data->pdu) {
-        free(data->pdu);
+        if (is_pool_pdu(data->pdu)) {
+            msg.data = data->pdu;
+            ring_put(&PDU_Pool, &msg);
+        } else {
+            free(data->pdu);
+        }
         data->pdu = NULL;
     }
-    if (data) {
+    if (is_pool_data(data)) {
+        msg.data = data;
+        ring_put(&Data_Pool, &msg);
+    } else {
         free(data);
-        data = NULL;
     }
 }
 
 void check_data(
     MSG_DATA * data)
 {
+    /* decrement messages reference count, the last one frees it */
+    if (__atomic_sub_fetch(&data->ref_count, 1, __ATOMIC_ACQ_REL) == 0) {
+        free_data(data);
+    }
+}
+
+#ifdef TEST
+#ifdef TEST_MSGQUEUE_BENCH
+#include <time.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+
+/* Push traffic through the router fabric the way the demo does: an IP
+   port thread sends to the router thread, which re-encodes the NPDU with
+   the source network and sends it to an IP or an MS/TP port thread.
+   The legacy fabric - SysV queues polled with IPC_NOWAIT, malloc, and a
+   reference count under a mutex - carries the same traffic. Its port
+   threads sleep in the datalink for up to 5ms between polls, like
+   dl_ip_recv and dlmstp_receive used to, and its router thread spins. */
+
+#ifndef BENCH_MESSAGES
+#define BENCH_MESSAGES 200000
+#endif
+#define BENCH_SNET 1
+#define BENCH_IP_DNET 2
+#define BENCH_MSTP_DNET 3
+
+typedef struct bench_fabric {
+    const char *name;
+    void (
+        *send) (
+        MSGBOX_ID dest,
+        BACMSG * msg);
+    void (
+        *recv) (
+        MSGBOX_ID src,
+        BACMSG * msg,
+        bool port);
+    MSG_DATA *(
+        *data) (
+        void);
+    uint8_t *(
+        *pdu) (
+        uint16_t pdu_len);
+    void (
+        *release) (
+        MSG_DATA * data);
+    MSGBOX_ID router_id;
+    MSGBOX_ID ip_id;
+    MSGBOX_ID mstp_id;
+} BENCH_FABRIC;
+
+typedef struct bench_run {
+    BENCH_FABRIC *fabric;
+    uint16_t dnet;
+    MSGBOX_ID sink_id;
+    unsigned long sink_octets;
+} BENCH_RUN;
+
+static void ring_send(
+    MSGBOX_ID dest,
+    BACMSG * msg)
+{
+    while (!send_to_msgbox(dest, msg)) {
+        /* box is full - wait for the receiver */
+    }
+}
+
+static void ring_recv(
+    MSGBOX_ID src,
+    BACMSG * msg,
+    bool port)
+{
+    (void) port;
+    while (!recv_from_msgbox(src, msg)) {
+        wait_for_msgbox(src, -1, -1);
+    }
+}
+
+static MSG_DATA *ring_data(
+    void)
+{
+    return alloc_data();
+}
+
+typedef struct legacy_msg {
+    long mtype;
+    BACMSG msg;
+} LEGACY_MSG;
+
+static pthread_mutex_t Legacy_Lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void legacy_send(
+    MSGBOX_ID dest,
+    BACMSG * msg)
+{
+    LEGACY_MSG legacy;
+
+    legacy.mtype = 1;
+    legacy.msg = *msg;
+    while (msgsnd(dest, &legacy, sizeof(BACMSG), 0) != 0) {
+        /* interrupted */
+    }
+}
+
+static void legacy_recv(
+    MSGBOX_ID src,
+    BACMSG * msg,
+    bool port)
+{
+    LEGACY_MSG legacy;
+
+    while (msgrcv(src, &legacy, sizeof(BACMSG), 0, IPC_NOWAIT) <= 0) {
+        if (port) {
+            /* the old port threads waited on their datalink */
+            poll(NULL, 0, 5);
+        }
+    }
+    *msg = legacy.msg;
+}
 
-    /* lock and decrement messages reference count */
-    pthread_mutex_lock(&msg_lock);
+static MSG_DATA *legacy_data(
+    void)
+{
+    return (MSG_DATA *) calloc(1, sizeof(MSG_DATA));
+}
+
+static uint8_t *legacy_pdu(
+    uint16_t pdu_len)
+{
+    return (uint8_t *) malloc(pdu_len);
+}
+
+static void legacy_release(
+    MSG_DATA * data)
+{
+    pthread_mutex_lock(&Legacy_Lock);
     if (--data->ref_count == 0) {
-        free_data(data);
+        free(data->pdu);
+        free(data);
     }
-    pthread_mutex_unlock(&msg_lock);
+    pthread_mutex_unlock(&Legacy_Lock);
+}
+
+static void *bench_source(
+    void *arg)
+{
+    BENCH_RUN *run = (BENCH_RUN *) arg;
+    BENCH_FABRIC *fabric = run->fabric;
+    BACNET_ADDRESS dest = { 0 };
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t npdu[MAX_NPDU];
+    BACMSG msg = { 0 };
+    MSG_DATA *data;
+    int npdu_len;
+    unsigned long i;
+
+    dest.net = run->dnet;
+    dest.len = 1;
+    dest.adr[0] = 5;
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+    npdu_len = npdu_encode_pdu(npdu, &dest, NULL, &npdu_data);
+    for (i = 0; i < BENCH_MESSAGES; i++) {
+        data = fabric->data();
+        data->pdu_len = npdu_len + 20;
+        data->pdu = fabric->pdu(data->pdu_len);
+        memcpy(data->pdu, npdu, npdu_len);
+        /* a ReadProperty request sized APDU */
+        memset(&data->pdu[npdu_len], (int) i, 20);
+        data->src.len = 6;
+        data->src.adr[0] = 192;
+        data->ref_count = 1;
+        msg.type = DATA;
+        msg.origin = fabric->ip_id;
+        msg.data = data;
+        fabric->send(fabric->router_id, &msg);
+    }
+
+    return NULL;
+}
+
+static void *bench_sink(
+    void *arg)
+{
+    BENCH_RUN *run = (BENCH_RUN *) arg;
+    BENCH_FABRIC *fabric = run->fabric;
+    uint8_t frame[MAX_PDU];
+    MSG_DATA *data;
+    BACMSG msg;
+    unsigned long i;
+
+    for (i = 0; i < BENCH_MESSAGES; i++) {
+        fabric->recv(run->sink_id, &msg, true);
+        data = (MSG_DATA *) msg.data;
+        /* the port copies the PDU into its datalink frame */
+        memcpy(frame, data->pdu, data->pdu_len);
+        run->sink_octets += data->pdu_len + frame[0];
+        fabric->release(data);
+    }
+
+    return NULL;
+}
+
+/* what process_msg does for a message to a directly connected network */
+static void bench_router(
+    BENCH_RUN * run)
+{
+    BENCH_FABRIC *fabric = run->fabric;
+    BACNET_ADDRESS dest, src;
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t npdu[MAX_NPDU];
+    MSG_DATA *rx_data, *data;
+    BACMSG msg;
+    int apdu_offset, npdu_len;
+    unsigned long i;
+
+    for (i = 0; i < BENCH_MESSAGES; i++) {
+        fabric->recv(fabric->router_id, &msg, false);
+        rx_data = (MSG_DATA *) msg.data;
+        apdu_offset = npdu_decode(rx_data->pdu, &dest, NULL, &npdu_data);
+        src = rx_data->src;
+        src.net = BENCH_SNET;
+        npdu_len = npdu_encode_pdu(npdu, NULL, &src, &npdu_data);
+        data = fabric->data();
+        data->dest = dest;
+        data->src = src;
+        data->pdu_len = npdu_len + rx_data->pdu_len - apdu_offset;
+        data->pdu = fabric->pdu(data->pdu_len);
+        memcpy(data->pdu, npdu, npdu_len);
+        memcpy(&data->pdu[npdu_len], &rx_data->pdu[apdu_offset],
+            rx_data->pdu_len - apdu_offset);
+        data->ref_count = 1;
+        fabric->release(rx_data);
+        msg.origin = fabric->router_id;
+        msg.data = data;
+        fabric->send((dest.net == BENCH_MSTP_DNET) ? fabric->mstp_id :
+            fabric->ip_id, &msg);
+    }
+}
+
+static double bench_seconds(
+    struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) (now.tv_sec - start->tv_sec) +
+        (double) (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void bench_route(
+    BENCH_FABRIC * fabric,
+    const char *path,
+    uint16_t dnet)
+{
+    BENCH_RUN run = { 0 };
+    pthread_t source, sink;
+    struct timespec start;
+    clock_t cpu;
+    double wall;
+
+    run.fabric = fabric;
+    run.dnet = dnet;
+    run.sink_id = (dnet == BENCH_MSTP_DNET) ? fabric->mstp_id : fabric->ip_id;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    cpu = clock();
+    pthread_create(&sink, NULL, bench_sink, &run);
+    pthread_create(&source, NULL, bench_source, &run);
+    bench_router(&run);
+    pthread_join(source, NULL);
+    pthread_join(sink, NULL);
+    wall = bench_seconds(&start);
+    printf("%-8s %-12s %10.0f msgs/s %8.2f us cpu/msg\n", fabric->name,
+        path, BENCH_MESSAGES / wall,
+        1e6 * (double) (clock() - cpu) / CLOCKS_PER_SEC / BENCH_MESSAGES);
+}
+
+int main(
+    void)
+{
+    BENCH_FABRIC rings = {
+        "rings", ring_send, ring_recv, ring_data, alloc_pdu, check_data
+    };
+    BENCH_FABRIC legacy = {
+        "sysv", legacy_send, legacy_recv, legacy_data, legacy_pdu,
+        legacy_release
+    };
+
+    rings.router_id = create_msgbox();
+    rings.ip_id = create_msgbox_spsc();
+    rings.mstp_id = create_msgbox_spsc();
+    legacy.router_id = msgget(IPC_PRIVATE, 0666 | IPC_CREAT);
+    legacy.ip_id = msgget(IPC_PRIVATE, 0666 | IPC_CREAT);
+    legacy.mstp_id = msgget(IPC_PRIVATE, 0666 | IPC_CREAT);
+    if ((rings.router_id == INVALID_MSGBOX_ID) ||
+        (rings.ip_id == INVALID_MSGBOX_ID) ||
+        (rings.mstp_id == INVALID_MSGBOX_ID)) {
+        printf("msgqueue bench: cannot create message boxes\n");
+        return 1;
+    }
+
+    printf("router fabric, %d messages per path\n", BENCH_MESSAGES);
+    bench_route(&rings, "IP-to-IP", BENCH_IP_DNET);
+    bench_route(&rings, "IP-to-MS/TP", BENCH_MSTP_DNET);
+    if ((legacy.router_id < 0) || (legacy.ip_id < 0) || (legacy.mstp_id < 0)) {
+        printf("sysv     message queues are not available\n");
+    } else {
+        bench_route(&legacy, "IP-to-IP", BENCH_IP_DNET);
+        bench_route(&legacy, "IP-to-MS/TP", BENCH_MSTP_DNET);
+    }
+    msgctl(legacy.router_id, IPC_RMID, NULL);
+    msgctl(legacy.ip_id, IPC_RMID, NULL);
+    msgctl(legacy.mstp_id, IPC_RMID, NULL);
+
+    return 0;
 }
+#endif /* TEST_MSGQUEUE_BENCH */
+#endif /* TEST */
@@ -32,15 +32,31 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <sys/types.h>
-#include <sys/ipc.h>
-#include <sys/msg.h>
 #include "bacdef.h"
 #include "npdu.h"
 
-extern pthread_mutex_t msg_lock;
-
 #define INVALID_MSGBOX_ID -1
 
+/* number of message boxes: one for the router and one per port */
+#ifndef MSGBOX_MAX
+#define MSGBOX_MAX 16
+#endif
+
+/* messages each box can hold - must be a power of 2 */
+#ifndef MSGBOX_SIZE
+#define MSGBOX_SIZE 256
+#endif
+
+/* pooled MSG_DATA structures and PDU buffers - must be a power of 2 */
+#ifndef MSG_POOL_COUNT
+#define MSG_POOL_COUNT 256
+#endif
+
+/* PDU buffers larger than this are allocated with malloc */
+#ifndef MSG_POOL_PDU_SIZE
+#define MSG_POOL_PDU_SIZE MAX_PDU
+#endif
+
 typedef int MSGBOX_ID;
 
 typedef enum {
@@ -71,22 +87,42 @@ typedef struct _msg_data {
     uint8_t ref_count;
 } MSG_DATA;
 
+/* message box that any thread may send to */
 MSGBOX_ID create_msgbox(
     );
 
-/* returns sent byte count */
+/* message box that only one thread sends to */
+MSGBOX_ID create_msgbox_spsc(
+    );
+
+/* returns true if the message was queued */
 bool send_to_msgbox(
     MSGBOX_ID dest,
     BACMSG * msg);
 
-/* returns received message */
+/* returns received message, or NULL if the box is empty */
 BACMSG *recv_from_msgbox(
     MSGBOX_ID src,
     BACMSG * msg);
 
+/* sleeps until a message arrives, fd is readable, or timeout ms pass;
+   returns true if fd is readable */
+bool wait_for_msgbox(
+    MSGBOX_ID src,
+    int fd,
+    int timeout);
+
 void del_msgbox(
     MSGBOX_ID msgboxid);
 
+/* get message data structure from the pool, with no PDU */
+MSG_DATA *alloc_data(
+    );
+
+/* get PDU buffer from the pool */
+uint8_t *alloc_pdu(
+    uint16_t pdu_len);
+
 /* free message data structure */
 void free_data(
     MSG_DATA * data);
@@ -32,6 +32,7 @@
 #include "mstpmodule.h"
 #include "bacint.h"
 #include "dlmstp_linux.h"
+#include "mstp_engine.h"
 #include <termios.h>
 
 #define MSTP_THREAD_PRINT_ENABLED
@@ -93,11 +94,18 @@ void *dl_mstp_thread(
     dlmstp_set_max_info_frames(&mstp_port,
         port->params.mstp_params.max_frames);
     dlmstp_set_max_master(&mstp_port, port->params.mstp_params.max_master);
-    if (!dlmstp_init(&mstp_port, port->iface))
+    /* the state machines run in the shared MS/TP engine thread */
+    if (!mstp_engine_add_port(&mstp_port, port->iface)) {
         printf("MSTP %s init failed. Stop.\n", port->iface);
+        port->state = INIT_FAILED;
+        return NULL;
+    }
 
-    port->port_id = create_msgbox();
+    /* only the router thread sends to a port */
+    port->port_id = create_msgbox_spsc();
     if (port->port_id == INVALID_MSGBOX_ID) {
+        mstp_engine_remove_port(&mstp_port);
+        dlmstp_cleanup(&mstp_port);
         port->state = INIT_FAILED;
         return NULL;
     }
@@ -144,16 +152,21 @@ void *dl_mstp_thread(
                     break;
             }
         } else {
-            pdu_len = dlmstp_receive(&mstp_port, NULL, NULL, 0, 5);
-
-            if (pdu_len > 0) {
-                msg_data = (MSG_DATA *) malloc(sizeof(MSG_DATA));
+            pdu_len = dlmstp_receive(&mstp_port, NULL, NULL, 0, 0);
+
+            if (pdu_len == 0) {
+                /* sleep until the router sends a message or a frame
+                   arrives */
+                wait_for_msgbox(port->port_id, dlmstp_receive_fd(&mstp_port),
+                    -1);
+            } else {
+                msg_data = alloc_data();
                 memmove(&(msg_data->src),
                     (const void *) &(shared_port_data.Receive_Packet.address),
                     sizeof(shared_port_data.Receive_Packet.address));
                 msg_data->src.adr[0] = msg_data->src.mac[0];
                 msg_data->src.len = 1;
-                msg_data->pdu = (uint8_t *) malloc(pdu_len);
+                msg_data->pdu = alloc_pdu(pdu_len);
                 memmove(msg_data->pdu,
                     (const void *) &(shared_port_data.Receive_Packet.pdu),
                     pdu_len);
@@ -171,6 +184,7 @@ void *dl_mstp_thread(
         }
     }
 
+    mstp_engine_remove_port(&mstp_port);
     dlmstp_cleanup(&mstp_port);
     port->state = FINISHED;
 
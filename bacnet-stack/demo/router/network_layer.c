@@ -30,6 +30,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "network_layer.h"
+#include "routing_table.h"
 #include "bacint.h"
 
 uint16_t process_network_message(
@@ -96,7 +97,7 @@ uint16_t process_network_message(
                 int i;
                 for (i = 0; i < net_count; i++) {
                     decode_unsigned16(&data->pdu[apdu_offset + 2 * i], &net);   /* decode received NET values */
-                    add_dnet(&srcport->route_info, net, data->src);     /* and update routing table */
+                    routing_table_learn(net, srcport, &data->src);      /* and update routing table */
                 }
                 break;
             }
@@ -111,6 +112,16 @@ uint16_t process_network_message(
                         break;
                     case 1:
                         PRINT(ERROR, "Error: Network unreachable\n");
+                        if (apdu_len >= 3) {
+                            ROUTE *route;
+
+                            /* forget the router that could not reach it */
+                            decode_unsigned16(&data->pdu[apdu_offset + 1],
+                                &net);
+                            route = routing_table_find(net);
+                            if (route && route->learned)
+                                routing_table_remove(net);
+                        }
                         break;
                     case 2:
                         PRINT(ERROR, "Error: Network is busy\n");
@@ -128,14 +139,12 @@ uint16_t process_network_message(
             PRINT(INFO, "Recieved Initialize-Routing-Table message\n");
             if (data->pdu[apdu_offset] > 0) {
                 int net_count = data->pdu[apdu_offset];
-                while (net_count--) {
-                    int i = 1;
+                int i = 1;
+                while (net_count-- && (i + 4 <= apdu_len)) {
                     decode_unsigned16(&data->pdu[apdu_offset + i], &net);       /* decode received NET values */
-                    add_dnet(&srcport->route_info, net, data->src);     /* and update routing table */
-                    if (data->pdu[apdu_offset + i + 3] > 0)     /* find next NET value */
-                        i = data->pdu[apdu_offset + i + 3] + 4;
-                    else
-                        i = i + 4;
+                    routing_table_learn(net, srcport, &data->src);      /* and update routing table */
+                    /* skip NET, port ID, port info length and port info */
+                    i = i + 4 + data->pdu[apdu_offset + i + 3];
                 }
                 buff_len =
                     create_network_message(NETWORK_MESSAGE_INIT_RT_TABLE_ACK,
@@ -150,22 +159,37 @@ uint16_t process_network_message(
             PRINT(INFO, "Recieved Initialize-Routing-Table-Ack message\n");
             if (data->pdu[apdu_offset] > 0) {
                 int net_count = data->pdu[apdu_offset];
-                while (net_count--) {
-                    int i = 1;
+                int i = 1;
+                while (net_count-- && (i + 4 <= apdu_len)) {
                     decode_unsigned16(&data->pdu[apdu_offset + i], &net);       /* decode received NET values */
-                    add_dnet(&srcport->route_info, net, data->src);     /* and update routing table */
-                    if (data->pdu[apdu_offset + i + 3] > 0)     /* find next NET value */
-                        i = data->pdu[apdu_offset + i + 3] + 4;
-                    else
-                        i = i + 4;
+                    routing_table_learn(net, srcport, &data->src);      /* and update routing table */
+                    /* skip NET, port ID, port info length and port info */
+                    i = i + 4 + data->pdu[apdu_offset + i + 3];
                 }
             }
             break;
 
-        case NETWORK_MESSAGE_INVALID:
-        case NETWORK_MESSAGE_I_COULD_BE_ROUTER_TO_NETWORK:
         case NETWORK_MESSAGE_ROUTER_BUSY_TO_NETWORK:
         case NETWORK_MESSAGE_ROUTER_AVAILABLE_TO_NETWORK:
+            {
+                bool busy = (npdu_data.network_message_type ==
+                    NETWORK_MESSAGE_ROUTER_BUSY_TO_NETWORK);
+                int i;
+
+                PRINT(INFO, "Recieved Router-%s-To-Network message\n",
+                    busy ? "Busy" : "Available");
+                if (apdu_len < 2) {
+                    /* no list means every network behind the router */
+                    routing_table_busy(0, srcport, &data->src, busy);
+                }
+                for (i = 0; i + 2 <= apdu_len; i += 2) {
+                    decode_unsigned16(&data->pdu[apdu_offset + i], &net);
+                    routing_table_busy(net, srcport, &data->src, busy);
+                }
+                break;
+            }
+        case NETWORK_MESSAGE_INVALID:
+        case NETWORK_MESSAGE_I_COULD_BE_ROUTER_TO_NETWORK:
         case NETWORK_MESSAGE_ESTABLISH_CONNECTION_TO_NETWORK:
         case NETWORK_MESSAGE_DISCONNECT_CONNECTION_TO_NETWORK:
             /* hell if I know what to do with these messages */
@@ -211,7 +235,7 @@ uint16_t create_network_message(
         data_expecting_reply = true;
     init_npdu(&npdu_data, network_message_type, data_expecting_reply);
 
-    *buff = (uint8_t *) malloc(128);    /* resolve different length */
+    *buff = alloc_pdu(MSG_POOL_PDU_SIZE);       /* resolve different length */
 
     /* manual destination setup for Init-RT-Table-Ack message */
     data->dest.net = BACNET_BROADCAST_NETWORK;
@@ -233,29 +257,19 @@ uint16_t create_network_message(
                 uint16_t val16 = (valptr[0]) + (valptr[1] << 8);
                 buff_len += encode_unsigned16(*buff + buff_len, val16);
             } else {
-                ROUTER_PORT *port = head;
-                DNET *dnet;
-                while (port != NULL) {
-                    if (port->route_info.net != data->src.net) {
-                        buff_len +=
-                            encode_unsigned16(*buff + buff_len,
-                            port->route_info.net);
-                        dnet = port->route_info.dnets;
-                        while (dnet != NULL) {
-                            buff_len +=
-                                encode_unsigned16(*buff + buff_len, dnet->net);
-                            dnet = dnet->next;
-                        }
-                        port = port->next;
-                    } else {
-                        dnet = port->route_info.dnets;
-                        while (dnet != NULL) {
-                            buff_len +=
-                                encode_unsigned16(*buff + buff_len, dnet->net);
-                            dnet = dnet->next;
-                        }
-                        port = port->next;
-                    }
+                ROUTE *route;
+                unsigned i;
+
+                /* every network reached through the other ports */
+                for (i = 0; i < ROUTING_TABLE_SIZE; i++) {
+                    route = routing_table_get_by_index(i);
+                    if (!route || route->busy ||
+                        (route->port->route_info.net == data->src.net))
+                        continue;
+                    if (buff_len + 2 > MSG_POOL_PDU_SIZE)
+                        break;
+                    buff_len +=
+                        encode_unsigned16(*buff + buff_len, route->net);
                 }
             }
             break;
@@ -329,7 +343,7 @@ void send_network_message(
     int16_t buff_len;
 
     if (!data) {
-        data = (MSG_DATA *) malloc(sizeof(MSG_DATA));
+        data = alloc_data();
         data->dest.net = BACNET_BROADCAST_NETWORK;
         data->dest.len = 0;
     }
@@ -349,7 +363,9 @@ void send_network_message(
             port = port->next;
             continue;
         }
-        send_to_msgbox(port->port_id, &msg);
+        if (!send_to_msgbox(port->port_id, &msg)) {
+            check_data(data);
+        }
         port = port->next;
     }
 }
@@ -30,20 +30,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include "portthread.h"
+#include "routing_table.h"
 
 ROUTER_PORT *find_snet(
     MSGBOX_ID id)
 {
 
-    ROUTER_PORT *port = head;
-
-    while (port != NULL) {
-        if (port->port_id == id)
-            return port;
-        port = port->next;
-    }
-
-    return NULL;
+    return routing_table_port(id);
 }
 
 ROUTER_PORT *find_dnet(
@@ -51,82 +44,21 @@ ROUTER_PORT *find_dnet(
     BACNET_ADDRESS * addr)
 {
 
-    ROUTER_PORT *port = head;
-    DNET *dnet;
+    ROUTE *route;
 
     /* for broadcast messages no search is needed */
     if (net == BACNET_BROADCAST_NETWORK)
-        return port;
-
-    while (port != NULL) {
-
-        /* check if DNET is directly connected to the router */
-        if (net == port->route_info.net)
-            return port;
-
-        /* else search router ports DNET list */
-        else if (port->route_info.dnets) {
-            dnet = port->route_info.dnets;
-            while (dnet != NULL) {
-                if (net == dnet->net) {
-                    if (addr) {
-                        memmove(&addr->len, &dnet->mac_len, 1);
-                        memmove(&addr->adr[0], &dnet->mac[0], MAX_MAC_LEN);
-                    }
-                    return port;
-                }
-                dnet = dnet->next;
-            }
-        }
-        port = port->next;
-    }
-
-    return NULL;
-}
+        return head;
 
-void add_dnet(
-    RT_ENTRY * route_info,
-    uint16_t net,
-    BACNET_ADDRESS addr)
-{
-
-    DNET *dnet = route_info->dnets;
-    DNET *tmp;
-
-    if (dnet == NULL) {
-        route_info->dnets = (DNET *) malloc(sizeof(DNET));
-        memmove(&route_info->dnets->mac_len, &addr.len, 1);
-        memmove(&route_info->dnets->mac[0], &addr.adr[0], MAX_MAC_LEN);
-        route_info->dnets->net = net;
-        route_info->dnets->state = true;
-        route_info->dnets->next = NULL;
-    } else {
-
-        while (dnet != NULL) {
-            if (dnet->net == net)       /* make sure NETs are not repeated */
-                return;
-            tmp = dnet;
-            dnet = dnet->next;
-        }
+    route = routing_table_find(net);
+    if (!route || route->busy)
+        return NULL;
 
-        dnet = (DNET *) malloc(sizeof(DNET));
-        memmove(&dnet->mac_len, &addr.len, 1);
-        memmove(&dnet->mac[0], &addr.adr[0], MAX_MAC_LEN);
-        dnet->net = net;
-        dnet->state = true;
-        dnet->next = NULL;
-        tmp->next = dnet;
+    /* networks behind another router are sent to that router */
+    if (addr && route->mac_len) {
+        addr->len = route->mac_len;
+        memmove(&addr->adr[0], &route->mac[0], route->mac_len);
     }
-}
-
-void cleanup_dnets(
-    DNET * dnets)
-{
 
-    DNET *dnet = dnets;
-    while (dnet != NULL) {
-        dnet = dnet->next;
-        free(dnets);
-        dnets = dnet;
-    }
+    return route->port;
 }
@@ -85,21 +85,12 @@ typedef union _port_params {
     } mstp_params;
 } PORT_PARAMS;
 
-/* list node for reacheble networks */
-typedef struct _dnet {
-    uint8_t mac[MAX_MAC_LEN];
-    uint8_t mac_len;
-    uint16_t net;
-    bool state; /* enabled or disabled */
-    struct _dnet *next;
-} DNET;
-
-/* information for routing table */
+/* address and network number of the router port,
+   the networks behind other routers are in routing_table.h */
 typedef struct _routing_table_entry {
     uint8_t mac[MAX_MAC_LEN];
     uint8_t mac_len;
     uint16_t net;
-    DNET *dnets;
 } RT_ENTRY;
 
 typedef struct _port {
@@ -121,18 +112,10 @@ extern int port_count;
 ROUTER_PORT *find_snet(
     MSGBOX_ID id);
 
-/* get sending router port */
+/* get sending router port, and the next router address in addr
+   if the network is not directly connected */
 ROUTER_PORT *find_dnet(
     uint16_t net,
     BACNET_ADDRESS * addr);
 
-/* add reacheble network for specified router port */
-void add_dnet(
-    RT_ENTRY * route_info,
-    uint16_t net,
-    BACNET_ADDRESS addr);
-
-void cleanup_dnets(
-    DNET * dnets);
-
 #endif /* end of PORTTHREAD_H */
@@ -0,0 +1,676 @@
+/**
+* @file
+* @author agent
+* @date 2026
+* @brief Routing table - DNET to router port lookup, learned routes,
+* and packets held while a route is being searched for
+*
+* @section LICENSE
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "routing_table.h"
+
+/* open addressing with linear probing; a zero net is an empty slot,
+   since zero is never a valid DNET */
+static ROUTE Routes[ROUTING_TABLE_SIZE];
+static unsigned Route_Count;
+
+/* ports by message box, so a received message finds its port at once */
+static ROUTER_PORT *Ports[MSGBOX_MAX];
+
+typedef struct _held_packet {
+    uint16_t net;
+    MSGBOX_ID origin;
+    MSG_DATA *data;
+    uint32_t sequence;  /* so packets are released in the order held */
+    uint16_t milliseconds;      /* time left before it is discarded */
+} HELD_PACKET;
+
+static HELD_PACKET Held[ROUTING_TABLE_HOLD_MAX];
+static uint32_t Held_Sequence;
+static uint32_t Timer_Milliseconds;
+
+static unsigned route_hash(
+    uint16_t net)
+{
+    uint16_t hash = (uint16_t) (net * 40503U);
+
+    hash ^= (hash >> 8);
+
+    return hash & (ROUTING_TABLE_SIZE - 1);
+}
+
+static bool route_valid_net(
+    uint16_t net)
+{
+    return (net != 0) && (net != BACNET_BROADCAST_NETWORK);
+}
+
+/* returns the slot holding the net, or the empty slot where it goes */
+static unsigned route_slot(
+    uint16_t net)
+{
+    unsigned slot = route_hash(net);
+
+    while (Routes[slot].net && (Routes[slot].net != net)) {
+        slot = (slot + 1) & (ROUTING_TABLE_SIZE - 1);
+    }
+
+    return slot;
+}
+
+static ROUTE *route_add(
+    uint16_t net)
+{
+    unsigned slot;
+
+    if (!route_valid_net(net)) {
+        return NULL;
+    }
+    slot = route_slot(net);
+    if (Routes[slot].net == 0) {
+        /* keep an empty slot so that probing always ends */
+        if (Route_Count >= (ROUTING_TABLE_SIZE - 1)) {
+            return NULL;
+        }
+        memset(&Routes[slot], 0, sizeof(ROUTE));
+        Routes[slot].net = net;
+        Route_Count++;
+    }
+
+    return &Routes[slot];
+}
+
+/** Empties the table and the held packets. */
+void routing_table_init(
+    void)
+{
+    routing_table_cleanup();
+    memset(Routes, 0, sizeof(Routes));
+    memset(Ports, 0, sizeof(Ports));
+    Route_Count = 0;
+    Held_Sequence = 0;
+    Timer_Milliseconds = 0;
+}
+
+/** Frees the held packets. */
+void routing_table_cleanup(
+    void)
+{
+    unsigned i;
+
+    for (i = 0; i < ROUTING_TABLE_HOLD_MAX; i++) {
+        if (Held[i].data) {
+            free_data(Held[i].data);
+            Held[i].data = NULL;
+        }
+    }
+}
+
+/** Adds the directly connected network of a port, and maps its
+ *  message box to the port.
+ * @param port [in] a running port, with its port_id and network number
+ * @return true if added
+ */
+bool routing_table_add_port(
+    ROUTER_PORT * port)
+{
+    ROUTE *route;
+
+    if (!port || (port->port_id < 0) || (port->port_id >= MSGBOX_MAX)) {
+        return false;
+    }
+    route = route_add(port->route_info.net);
+    if (!route) {
+        return false;
+    }
+    memset(route, 0, sizeof(ROUTE));
+    route->net = port->route_info.net;
+    route->port = port;
+    Ports[port->port_id] = port;
+
+    return true;
+}
+
+/** Gets the port that owns a message box.
+ * @param id [in] the port_id of the port
+ * @return the port, or NULL if none was added with that id
+ */
+ROUTER_PORT *routing_table_port(
+    MSGBOX_ID id)
+{
+    if ((id < 0) || (id >= MSGBOX_MAX)) {
+        return NULL;
+    }
+
+    return Ports[id];
+}
+
+/** Adds or refreshes a route to a network behind another router.
+ *  A directly connected network is never replaced.
+ * @param net [in] the DNET the router can reach
+ * @param port [in] the port the router is on
+ * @param router [in] the MAC of the router in len and adr
+ * @return true if the route is in the table
+ */
+bool routing_table_learn(
+    uint16_t net,
+    ROUTER_PORT * port,
+    BACNET_ADDRESS * router)
+{
+    ROUTE *route;
+
+    if (!port || !router) {
+        return false;
+    }
+    route = route_add(net);
+    if (!route) {
+        return false;
+    }
+    if (route->port && !route->learned) {
+        /* directly connected */
+        return true;
+    }
+    route->port = port;
+    route->mac_len = router->len;
+    if (route->mac_len > MAX_MAC_LEN) {
+        route->mac_len = MAX_MAC_LEN;
+    }
+    memcpy(route->mac, router->adr, route->mac_len);
+    route->learned = true;
+    route->age_seconds = 0;
+
+    return true;
+}
+
+/** Removes a route, moving later entries of its probe run back so that
+ *  lookups still find them.
+ * @param net [in] the DNET to remove
+ */
+void routing_table_remove(
+    uint16_t net)
+{
+    unsigned slot, next, home;
+
+    if (!route_valid_net(net)) {
+        return;
+    }
+    slot = route_slot(net);
+    if (Routes[slot].net == 0) {
+        return;
+    }
+    next = slot;
+    for (;;) {
+        next = (next + 1) & (ROUTING_TABLE_SIZE - 1);
+        if (Routes[next].net == 0) {
+            break;
+        }
+        home = route_hash(Routes[next].net);
+        /* move it if its home slot is not between the hole and it */
+        if (((next > slot) && ((home <= slot) || (home > next))) ||
+            ((next < slot) && ((home <= slot) && (home > next)))) {
+            Routes[slot] = Routes[next];
+            slot = next;
+        }
+    }
+    memset(&Routes[slot], 0, sizeof(ROUTE));
+    Route_Count--;
+}
+
+/** Finds the route to a network.
+ * @param net [in] the DNET
+ * @return the route, or NULL if the network is unknown
+ */
+ROUTE *routing_table_find(
+    uint16_t net)
+{
+    unsigned slot;
+
+    if (!route_valid_net(net)) {
+        return NULL;
+    }
+    slot = route_slot(net);
+    if (Routes[slot].net == 0) {
+        return NULL;
+    }
+
+    return &Routes[slot];
+}
+
+/** Gets the route in a slot of the table.
+ * @param index [in] 0 to ROUTING_TABLE_SIZE-1
+ * @return the route, or NULL if the slot is empty
+ */
+ROUTE *routing_table_get_by_index(
+    unsigned index)
+{
+    if ((index < ROUTING_TABLE_SIZE) && Routes[index].net) {
+        return &Routes[index];
+    }
+
+    return NULL;
+}
+
+static void route_busy(
+    ROUTE * route,
+    bool busy)
+{
+    route->busy = busy;
+    route->busy_seconds = 0;
+}
+
+/** Marks networks busy or available, from Router-Busy-To-Network
+ *  or Router-Available-To-Network.
+ * @param net [in] the DNET, or zero for every network behind the router
+ * @param port [in] the port the router is on
+ * @param router [in] the MAC of the router in len and adr
+ * @param busy [in] true for busy, false for available
+ */
+void routing_table_busy(
+    uint16_t net,
+    ROUTER_PORT * port,
+    BACNET_ADDRESS * router,
+    bool busy)
+{
+    ROUTE *route;
+    unsigned i;
+
+    if (net) {
+        route = routing_table_find(net);
+        if (route && route->learned) {
+            route_busy(route, busy);
+        }
+        return;
+    }
+    for (i = 0; i < ROUTING_TABLE_SIZE; i++) {
+        route = &Routes[i];
+        if (route->net && route->learned && (route->port == port) &&
+            (route->mac_len == router->len) &&
+            (memcmp(route->mac, router->adr, route->mac_len) == 0)) {
+            route_busy(route, busy);
+        }
+    }
+}
+
+/** Holds a packet until its network is found or becomes available.
+ * @param net [in] the DNET of the packet
+ * @param origin [in] the port_id the packet came from
+ * @param data [in] the packet, which belongs to the table if held
+ * @return true if held, false if there is no room
+ */
+bool routing_table_hold(
+    uint16_t net,
+    MSGBOX_ID origin,
+    MSG_DATA * data)
+{
+    unsigned i;
+
+    for (i = 0; i < ROUTING_TABLE_HOLD_MAX; i++) {
+        if (!Held[i].data) {
+            Held[i].net = net;
+            Held[i].origin = origin;
+            Held[i].data = data;
+            Held[i].sequence = Held_Sequence++;
+            Held[i].milliseconds = ROUTING_TABLE_HOLD_TIME;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/** Tells if a search for the network is already in progress.
+ * @param net [in] the DNET
+ * @return true if packets are held for it
+ */
+bool routing_table_held(
+    uint16_t net)
+{
+    unsigned i;
+
+    for (i = 0; i < ROUTING_TABLE_HOLD_MAX; i++) {
+        if (Held[i].data && (Held[i].net == net)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/** Gets the oldest held packet whose network can now be reached.
+ *  Call it until it returns NULL after the table learns a route or a
+ *  network becomes available.
+ * @param origin [out] the port_id the packet came from
+ * @return the packet, which belongs to the caller, or NULL
+ */
+MSG_DATA *routing_table_release(
+    MSGBOX_ID * origin)
+{
+    HELD_PACKET *oldest = NULL;
+    MSG_DATA *data;
+    ROUTE *route;
+    unsigned i;
+
+    for (i = 0; i < ROUTING_TABLE_HOLD_MAX; i++) {
+        if (!Held[i].data) {
+            continue;
+        }
+        if (oldest &&
+            ((int32_t) (Held[i].sequence - oldest->sequence) > 0)) {
+            continue;
+        }
+        route = routing_table_find(Held[i].net);
+        if (route && !route->busy) {
+            oldest = &Held[i];
+        }
+    }
+    if (!oldest) {
+        return NULL;
+    }
+    data = oldest->data;
+    if (origin) {
+        *origin = oldest->origin;
+    }
+    oldest->data = NULL;
+
+    return data;
+}
+
+/** Ages the learned routes, clears busy networks that were never made
+ *  available again, and discards packets held too long.
+ * @param milliseconds [in] time since the last call
+ */
+void routing_table_timer(
+    uint32_t milliseconds)
+{
+    uint32_t seconds;
+    ROUTE *route;
+    unsigned i;
+
+    for (i = 0; i < ROUTING_TABLE_HOLD_MAX; i++) {
+        if (!Held[i].data) {
+            continue;
+        }
+        if (Held[i].milliseconds > milliseconds) {
+            Held[i].milliseconds -= milliseconds;
+        } else {
+            PRINT(INFO, "Discarded message held for NET %u\n",
+                (unsigned) Held[i].net);
+            free_data(Held[i].data);
+            Held[i].data = NULL;
+        }
+    }
+    Timer_Milliseconds += milliseconds;
+    seconds = Timer_Milliseconds / 1000;
+    if (seconds == 0) {
+        return;
+    }
+    Timer_Milliseconds -= seconds * 1000;
+    i = 0;
+    while (i < ROUTING_TABLE_SIZE) {
+        route = &Routes[i];
+        if (!route->net || !route->learned) {
+            i++;
+            continue;
+        }
+        if (route->busy) {
+            route->busy_seconds += seconds;
+            if (route->busy_seconds >= ROUTING_TABLE_BUSY_LIMIT) {
+                route_busy(route, false);
+            }
+        }
+        route->age_seconds += seconds;
+        if (route->age_seconds >= ROUTING_TABLE_AGE_LIMIT) {
+            PRINT(INFO, "Route to NET %u aged out\n", (unsigned) route->net);
+            /* removal may move another route into this slot */
+            routing_table_remove(route->net);
+            continue;
+        }
+        i++;
+    }
+}
+
+#ifdef TEST
+#include <assert.h>
+#include "ctest.h"
+
+static unsigned Freed_Count;
+
+void free_data(
+    MSG_DATA * data)
+{
+    (void) data;
+    Freed_Count++;
+}
+
+/* finds nets, from start up, whose home slot is the given slot */
+static unsigned testNets(
+    unsigned home,
+    uint16_t start,
+    uint16_t * nets,
+    unsigned count)
+{
+    unsigned found = 0;
+    uint16_t net;
+
+    for (net = start; (net < BACNET_BROADCAST_NETWORK) && (found < count);
+        net++) {
+        if (route_hash(net) == home) {
+            nets[found++] = net;
+        }
+    }
+
+    return found;
+}
+
+static unsigned testRouteCount(
+    void)
+{
+    unsigned i, count = 0;
+
+    for (i = 0; i < ROUTING_TABLE_SIZE; i++) {
+        if (routing_table_get_by_index(i)) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+static ROUTER_PORT Test_Port;
+static BACNET_ADDRESS Test_Router;
+
+static void testSetup(
+    void)
+{
+    routing_table_init();
+    memset(&Test_Port, 0, sizeof(Test_Port));
+    Test_Port.port_id = 1;
+    Test_Port.route_info.net = 1;
+    memset(&Test_Router, 0, sizeof(Test_Router));
+    Test_Router.len = 1;
+    Test_Router.adr[0] = 0x7F;
+    Freed_Count = 0;
+}
+
+void testRoutingTableInsert(
+    Test * pTest)
+{
+    ROUTE *route;
+
+    testSetup();
+    ct_test(pTest, routing_table_add_port(&Test_Port));
+    ct_test(pTest, routing_table_port(1) == &Test_Port);
+    ct_test(pTest, routing_table_port(0) == NULL);
+    route = routing_table_find(1);
+    ct_test(pTest, route != NULL);
+    ct_test(pTest, route->port == &Test_Port);
+    ct_test(pTest, !route->learned);
+
+    ct_test(pTest, routing_table_learn(100, &Test_Port, &Test_Router));
+    route = routing_table_find(100);
+    ct_test(pTest, route != NULL);
+    ct_test(pTest, route->learned);
+    ct_test(pTest, route->mac_len == 1);
+    ct_test(pTest, route->mac[0] == 0x7F);
+    /* learning again refreshes, and does not add */
+    ct_test(pTest, routing_table_learn(100, &Test_Port, &Test_Router));
+    ct_test(pTest, testRouteCount() == 2);
+    /* a directly connected network is never replaced */
+    ct_test(pTest, routing_table_learn(1, &Test_Port, &Test_Router));
+    route = routing_table_find(1);
+    ct_test(pTest, !route->learned);
+    ct_test(pTest, route->mac_len == 0);
+    /* zero and the broadcast network are never routes */
+    ct_test(pTest, !routing_table_learn(0, &Test_Port, &Test_Router));
+    ct_test(pTest, !routing_table_learn(BACNET_BROADCAST_NETWORK,
+            &Test_Port, &Test_Router));
+    ct_test(pTest, routing_table_find(0) == NULL);
+    ct_test(pTest, routing_table_find(200) == NULL);
+    ct_test(pTest, testRouteCount() == 2);
+}
+
+/* removes the first of a probe run, and checks the rest are found */
+static void testRemoveRun(
+    Test * pTest,
+    unsigned home,
+    uint16_t start)
+{
+    uint16_t nets[4];
+    unsigned i;
+
+    testSetup();
+    /* three nets share the home slot, the fourth has the next slot
+       as its home, and is pushed along after them */
+    ct_test(pTest, testNets(home, start, nets, 3) == 3);
+    ct_test(pTest, testNets((home + 1) & (ROUTING_TABLE_SIZE - 1), start,
+            &nets[3], 1) == 1);
+    for (i = 0; i < 4; i++) {
+        ct_test(pTest, routing_table_learn(nets[i], &Test_Port,
+                &Test_Router));
+    }
+    ct_test(pTest, routing_table_get_by_index(home)->net == nets[0]);
+    routing_table_remove(nets[0]);
+    ct_test(pTest, routing_table_find(nets[0]) == NULL);
+    ct_test(pTest, testRouteCount() == 3);
+    for (i = 1; i < 4; i++) {
+        ct_test(pTest, routing_table_find(nets[i]) != NULL);
+    }
+    /* each later route moved back one slot to close the hole */
+    ct_test(pTest, routing_table_get_by_index(home)->net == nets[1]);
+    ct_test(pTest, routing_table_get_by_index((home + 2) &
+            (ROUTING_TABLE_SIZE - 1))->net == nets[3]);
+    ct_test(pTest, routing_table_get_by_index((home + 3) &
+            (ROUTING_TABLE_SIZE - 1)) == NULL);
+    /* removing from the middle of the run */
+    routing_table_remove(nets[2]);
+    ct_test(pTest, routing_table_find(nets[1]) != NULL);
+    ct_test(pTest, routing_table_find(nets[2]) == NULL);
+    ct_test(pTest, routing_table_find(nets[3]) != NULL);
+    ct_test(pTest, testRouteCount() == 2);
+    /* removing an unknown net changes nothing */
+    routing_table_remove(nets[2]);
+    ct_test(pTest, testRouteCount() == 2);
+}
+
+void testRoutingTableRemove(
+    Test * pTest)
+{
+    testRemoveRun(pTest, route_hash(1), 2);
+    /* the run wraps from the last slot to the first */
+    testRemoveRun(pTest, ROUTING_TABLE_SIZE - 1, 1);
+}
+
+void testRoutingTableAge(
+    Test * pTest)
+{
+    uint16_t nets[3];
+    MSG_DATA data;
+
+    testSetup();
+    ct_test(pTest, routing_table_add_port(&Test_Port));
+    /* colliding routes, so aging out one moves the next into its slot */
+    ct_test(pTest, testNets(route_hash(1), 2, nets, 3) == 3);
+    ct_test(pTest, routing_table_learn(nets[0], &Test_Port, &Test_Router));
+    ct_test(pTest, routing_table_learn(nets[1], &Test_Port, &Test_Router));
+    ct_test(pTest, routing_table_learn(nets[2], &Test_Port, &Test_Router));
+    routing_table_timer((ROUTING_TABLE_AGE_LIMIT - 1) * 1000UL);
+    ct_test(pTest, testRouteCount() == 4);
+    /* an I-Am-Router-To-Network refreshes a route */
+    ct_test(pTest, routing_table_learn(nets[2], &Test_Port, &Test_Router));
+    routing_table_timer(999);
+    ct_test(pTest, testRouteCount() == 4);
+    routing_table_timer(1);
+    ct_test(pTest, routing_table_find(nets[0]) == NULL);
+    ct_test(pTest, routing_table_find(nets[1]) == NULL);
+    ct_test(pTest, routing_table_find(nets[2]) != NULL);
+    ct_test(pTest, routing_table_find(1) != NULL);
+    ct_test(pTest, testRouteCount() == 2);
+    /* a direct route never ages */
+    routing_table_timer(ROUTING_TABLE_AGE_LIMIT * 1000UL);
+    ct_test(pTest, routing_table_find(nets[2]) == NULL);
+    ct_test(pTest, routing_table_find(1) != NULL);
+    ct_test(pTest, testRouteCount() == 1);
+
+    /* held packets are released once routed, or discarded in time */
+    ct_test(pTest, routing_table_hold(nets[0], 1, &data));
+    ct_test(pTest, routing_table_held(nets[0]));
+    ct_test(pTest, routing_table_release(NULL) == NULL);
+    routing_table_timer(ROUTING_TABLE_HOLD_TIME - 1);
+    ct_test(pTest, Freed_Count == 0);
+    routing_table_timer(1);
+    ct_test(pTest, Freed_Count == 1);
+    ct_test(pTest, !routing_table_held(nets[0]));
+    ct_test(pTest, routing_table_hold(nets[0], 1, &data));
+    ct_test(pTest, routing_table_learn(nets[0], &Test_Port, &Test_Router));
+    ct_test(pTest, routing_table_release(NULL) == &data);
+    ct_test(pTest, !routing_table_held(nets[0]));
+}
+
+#ifdef TEST_ROUTING_TABLE
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("BACnet Router Routing Table", NULL);
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testRoutingTableInsert);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testRoutingTableRemove);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testRoutingTableAge);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+    ct_destroy(pTest);
+
+    return 0;
+}
+#endif /* TEST_ROUTING_TABLE */
+#endif /* TEST */
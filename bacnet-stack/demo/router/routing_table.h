@@ -0,0 +1,126 @@
+/**
+* @file
+* @author agent
+* @date 2026
+* @brief Routing table - DNET to router port lookup, learned routes,
+* and packets held while a route is being searched for
+*
+* @section LICENSE
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*
+*/
+#ifndef ROUTING_TABLE_H
+#define ROUTING_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bacdef.h"
+#include "msgqueue.h"
+#include "portthread.h"
+
+/* number of networks the router knows - must be a power of 2,
+   and should be about twice the expected number of networks */
+#ifndef ROUTING_TABLE_SIZE
+#define ROUTING_TABLE_SIZE 1024
+#endif
+
+/* seconds a learned route lasts without an I-Am-Router-To-Network */
+#ifndef ROUTING_TABLE_AGE_LIMIT
+#define ROUTING_TABLE_AGE_LIMIT 900
+#endif
+
+/* seconds a network stays busy without a Router-Available-To-Network */
+#ifndef ROUTING_TABLE_BUSY_LIMIT
+#define ROUTING_TABLE_BUSY_LIMIT 30
+#endif
+
+/* packets held for networks being searched for, or that are busy */
+#ifndef ROUTING_TABLE_HOLD_MAX
+#define ROUTING_TABLE_HOLD_MAX 64
+#endif
+
+/* milliseconds a packet is held before it is discarded */
+#ifndef ROUTING_TABLE_HOLD_TIME
+#define ROUTING_TABLE_HOLD_TIME 3000
+#endif
+
+typedef struct _route {
+    uint16_t net;
+    ROUTER_PORT *port;  /* router port the network is reached through */
+    /* next router on the port, or zero length if directly connected */
+    uint8_t mac[MAX_MAC_LEN];
+    uint8_t mac_len;
+    bool learned;
+    bool busy;
+    uint16_t busy_seconds;
+    uint32_t age_seconds;
+} ROUTE;
+
+void routing_table_init(
+    void);
+void routing_table_cleanup(
+    void);
+
+/* adds the directly connected network of a running port */
+bool routing_table_add_port(
+    ROUTER_PORT * port);
+/* gets the port that owns a message box */
+ROUTER_PORT *routing_table_port(
+    MSGBOX_ID id);
+
+/* adds or refreshes a route learned from another router */
+bool routing_table_learn(
+    uint16_t net,
+    ROUTER_PORT * port,
+    BACNET_ADDRESS * router);
+void routing_table_remove(
+    uint16_t net);
+ROUTE *routing_table_find(
+    uint16_t net);
+/* gets the route in a slot, for walking the whole table */
+ROUTE *routing_table_get_by_index(
+    unsigned index);
+
+/* Router-Busy-To-Network and Router-Available-To-Network for one network,
+   or for every network behind a router when net is zero */
+void routing_table_busy(
+    uint16_t net,
+    ROUTER_PORT * port,
+    BACNET_ADDRESS * router,
+    bool busy);
+
+/* holds a packet for a network with no usable route */
+bool routing_table_hold(
+    uint16_t net,
+    MSGBOX_ID origin,
+    MSG_DATA * data);
+/* true if packets are already held for the network */
+bool routing_table_held(
+    uint16_t net);
+/* gets a held packet whose network can now be reached */
+MSG_DATA *routing_table_release(
+    MSGBOX_ID * origin);
+
+/* ages routes and held packets */
+void routing_table_timer(
+    uint32_t milliseconds);
+
+#endif /* end of ROUTING_TABLE_H */
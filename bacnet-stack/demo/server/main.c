@@ -54,6 +54,8 @@
 /* include the device object */
 #include "device.h"
 #include "trendlog.h"
+#include "propcache.h"
+#include "pollsched.h"
 #if defined(INTRINSIC_REPORTING)
 #include "nc.h"
 #endif /* defined(INTRINSIC_REPORTING) */
@@ -64,6 +66,19 @@
 #include "ucix.h"
 #endif /* defined(BAC_UCI) */
 
+/* On Linux, wait on the datalink and the timers with epoll
+   instead of waking up every millisecond to poll them */
+#if !defined(BACNET_EVENT_LOOP) && defined(__linux__)
+#define BACNET_EVENT_LOOP 1
+#endif
+#if BACNET_EVENT_LOOP
+#include "event_loop.h"
+/* period of the TSM and COV batching timer */
+#ifndef SERVER_FAST_TIMER_MS
+#define SERVER_FAST_TIMER_MS 50
+#endif
+#endif
+
 
 /** @file server/main.c  Example server application using the BACnet Stack. */
 
@@ -75,6 +90,140 @@
 /** Buffer used for receiving */
 static uint8_t Rx_Buf[MAX_MPDU] = { 0 };
 
+#if BACNET_EVENT_LOOP
+/** Handles a packet when the datalink is readable, or when polled.
+ */
+static void Datalink_Event_Handler(
+    int fd,
+    void *context)
+{
+    BACNET_ADDRESS src = {
+        0
+    };  /* address where message came from */
+    uint16_t pdu_len = 0;
+
+    (void) fd;
+    (void) context;
+    /* the packet is already there, so no need to wait, and the
+       datalink may have received several of them at once */
+    do {
+        pdu_len = datalink_receive(&src, &Rx_Buf[0], MAX_MPDU, 0);
+        if (pdu_len) {
+            npdu_handler(&src, &Rx_Buf[0], pdu_len);
+        }
+    } while (datalink_receive_pending());
+}
+
+/** Polls a datalink that has no file descriptor to wait on.
+ */
+static void Datalink_Poll_Handler(
+    uint32_t elapsed_milliseconds,
+    void *context)
+{
+    (void) elapsed_milliseconds;
+    Datalink_Event_Handler(-1, context);
+}
+
+/** Runs the TSM, the COV batching window and the poll scheduler.
+ */
+static void Fast_Timer_Handler(
+    uint32_t elapsed_milliseconds,
+    void *context)
+{
+    (void) context;
+    if (elapsed_milliseconds > UINT16_MAX) {
+        elapsed_milliseconds = UINT16_MAX;
+    }
+    tsm_timer_milliseconds((uint16_t) elapsed_milliseconds);
+    handler_cov_timer_milliseconds((uint16_t) elapsed_milliseconds);
+    poll_task((uint16_t) elapsed_milliseconds);
+}
+
+/** Runs the tasks that count seconds.
+ */
+static void Seconds_Timer_Handler(
+    uint32_t elapsed_milliseconds,
+    void *context)
+{
+    uint32_t elapsed_seconds = elapsed_milliseconds / 1000;
+#if defined(BACNET_TIME_MASTER)
+    BACNET_DATE_TIME bdatetime;
+#endif
+
+    (void) context;
+    dcc_timer_seconds(elapsed_seconds);
+#if defined(BACDL_BIP) && BBMD_ENABLED
+    bvlc_maintenance_timer(elapsed_seconds);
+#endif
+    dlenv_maintenance_timer(elapsed_seconds);
+    Load_Control_State_Machine_Handler();
+    handler_cov_timer_seconds(elapsed_seconds);
+    trend_log_timer(elapsed_seconds);
+    property_cache_timer((uint16_t) elapsed_seconds);
+#if defined(INTRINSIC_REPORTING)
+    Device_local_reporting();
+#endif
+#if defined(BACNET_TIME_MASTER)
+    Device_getCurrentDateTime(&bdatetime);
+    handler_timesync_task(&bdatetime);
+#endif
+}
+
+/** Scans the address cache for entries that have expired.
+ */
+static void Address_Timer_Handler(
+    uint32_t elapsed_milliseconds,
+    void *context)
+{
+    uint32_t elapsed_seconds = elapsed_milliseconds / 1000;
+
+    (void) context;
+    if (elapsed_seconds > UINT16_MAX) {
+        elapsed_seconds = UINT16_MAX;
+    }
+    address_cache_timer((uint16_t) elapsed_seconds);
+}
+
+#if defined(INTRINSIC_REPORTING)
+/** Tries to find the addresses of the notification recipients.
+ */
+static void Recipient_Timer_Handler(
+    uint32_t elapsed_milliseconds,
+    void *context)
+{
+    (void) elapsed_milliseconds;
+    (void) context;
+    Notification_Class_find_recipient();
+}
+#endif
+
+/** Sets up the event loop for the datalink and the timers.
+ */
+static void Event_Loop_Init(
+    void)
+{
+    int fd = -1;
+
+    if (!event_loop_init()) {
+        exit(1);
+    }
+    fd = event_loop_datalink_fd();
+    if (fd >= 0) {
+        event_loop_add_fd(fd, Datalink_Event_Handler, NULL);
+    } else {
+        event_loop_add_timer(1, Datalink_Poll_Handler, NULL);
+    }
+    event_loop_add_timer(SERVER_FAST_TIMER_MS, Fast_Timer_Handler, NULL);
+    event_loop_add_timer(1000, Seconds_Timer_Handler, NULL);
+    event_loop_add_timer(60UL * 1000UL, Address_Timer_Handler, NULL);
+#if defined(INTRINSIC_REPORTING)
+    event_loop_add_timer(NC_RESCAN_RECIPIENTS_SECS * 1000UL,
+        Recipient_Timer_Handler, NULL);
+#endif
+    atexit(event_loop_cleanup);
+}
+#endif
+
 /** Initialize the handlers we will utilize.
  * @see Device_Init, apdu_set_unconfirmed_handler, apdu_set_confirmed_handler
  */
@@ -130,8 +279,21 @@ static void Init_Service_Handlers(
         handler_timesync);
     apdu_set_confirmed_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV,
         handler_cov_subscribe);
+    /* learn which COV subscribers accept COVNotificationMultiple */
+    apdu_set_confirmed_simple_ack_handler
+        (SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE,
+        handler_ccov_notification_multiple_ack);
     apdu_set_unconfirmed_handler(SERVICE_UNCONFIRMED_COV_NOTIFICATION,
         handler_ucov_notification);
+    /* subscribe to the trend log sources in other devices... */
+    apdu_set_error_handler(SERVICE_CONFIRMED_SUBSCRIBE_COV,
+        handler_trend_log_error);
+    apdu_set_abort_handler(handler_trend_log_abort);
+    apdu_set_reject_handler(handler_trend_log_reject);
+    handler_ucov_notification_set(Trend_Log_COV_Notification);
+    /* ...and read them with the poll scheduler, which binds the devices,
+       and passes on the Aborts and Rejects that are not its own */
+    poll_init(NULL);
     /* handle communication so we can shutup when asked */
     apdu_set_confirmed_handler(SERVICE_CONFIRMED_DEVICE_COMMUNICATION_CONTROL,
         handler_device_communication_control);
@@ -188,6 +350,9 @@ int main(
     int argc,
     char *argv[])
 {
+#if BACNET_EVENT_LOOP
+    bool cov_idle = true;
+#else
     BACNET_ADDRESS src = {
         0
     };  /* address where message came from */
@@ -202,12 +367,14 @@ int main(
 #if defined(BACNET_TIME_MASTER)
     BACNET_DATE_TIME bdatetime;
 #endif
+#endif
 #if defined(BAC_UCI)
     int uciId = 0;
     struct uci_context *ctx;
 #endif
     int argi = 0;
     const char *filename = NULL;
+    char *pEnv = NULL;
 
     filename = filename_remove_path(argv[0]);
     for (argi = 1; argi < argc; argi++) {
@@ -253,9 +420,27 @@ int main(
     /* load any static address bindings to show up
        in our device bindings list */
     address_init();
+    /* keep the trend logs in files, if there is a place for them */
+    Trend_Log_Storage_Set(getenv("BACNET_TRENDLOG_DIR"));
     Init_Service_Handlers();
+    /* send the COV notifications of a subscriber together */
+    pEnv = getenv("BACNET_COV_BATCH_WINDOW");
+    if (pEnv) {
+        handler_cov_batching_set(true, (uint16_t) strtol(pEnv, NULL, 0));
+    }
     dlenv_init();
     atexit(datalink_cleanup);
+#if BACNET_EVENT_LOOP
+    Event_Loop_Init();
+    /* broadcast an I-Am on startup */
+    Send_I_Am(&Handler_Transmit_Buffer[0]);
+    /* loop forever */
+    for (;;) {
+        /* sleep until a packet or a timer, unless COV work is pending */
+        event_loop_run_once(cov_idle ? -1 : 1);
+        cov_idle = handler_cov_fsm();
+    }
+#else
     /* configure the timeout values */
     last_seconds = time(NULL);
     /* broadcast an I-Am on startup */
@@ -283,9 +468,15 @@ int main(
             dlenv_maintenance_timer(elapsed_seconds);
             Load_Control_State_Machine_Handler();
             elapsed_milliseconds = elapsed_seconds * 1000;
+            if (elapsed_milliseconds > UINT16_MAX) {
+                elapsed_milliseconds = UINT16_MAX;
+            }
             handler_cov_timer_seconds(elapsed_seconds);
-            tsm_timer_milliseconds(elapsed_milliseconds);
+            tsm_timer_milliseconds((uint16_t) elapsed_milliseconds);
+            handler_cov_timer_milliseconds((uint16_t) elapsed_milliseconds);
             trend_log_timer(elapsed_seconds);
+            poll_task((uint16_t) elapsed_milliseconds);
+            property_cache_timer((uint16_t) elapsed_seconds);
 #if defined(INTRINSIC_REPORTING)
             Device_local_reporting();
 #endif
@@ -313,6 +504,7 @@ int main(
 
         /* blink LEDs, Turn on or off outputs, etc */
     }
+#endif
 
     return 0;
 }
@@ -94,10 +94,12 @@ extern "C" {
         uint8_t invoke_id);
 
 /* generic confirmed ack function handler */
+/* note: a segmented ack is reassembled before it is handed over,
+   so the service data may be longer than one APDU */
     typedef void (
         *confirmed_ack_function) (
         uint8_t * service_request,
-        uint16_t service_len,
+        uint32_t service_len,
         BACNET_ADDRESS * src,
         BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data);
 
@@ -127,6 +129,9 @@ extern "C" {
     void apdu_set_confirmed_ack_handler(
         BACNET_CONFIRMED_SERVICE service_choice,
         confirmed_ack_function pFunction);
+/* the handlers that are set, to be called by those set in their place */
+    confirmed_ack_function apdu_confirmed_ack_handler(
+        BACNET_CONFIRMED_SERVICE service_choice);
 
     void apdu_set_confirmed_simple_ack_handler(
         BACNET_CONFIRMED_SERVICE service_choice,
@@ -167,6 +172,13 @@ extern "C" {
     void apdu_set_reject_handler(
         reject_function pFunction);
 
+    error_function apdu_error_handler(
+        BACNET_CONFIRMED_SERVICE service_choice);
+    abort_function apdu_abort_handler(
+        void);
+    reject_function apdu_reject_handler(
+        void);
+
     uint16_t apdu_decode_confirmed_service_request(
         uint8_t * apdu, /* APDU data */
         uint16_t apdu_len,
@@ -179,6 +191,10 @@ extern "C" {
         void);
     void apdu_timeout_set(
         uint16_t value);
+    uint16_t apdu_segment_timeout(
+        void);
+    void apdu_segment_timeout_set(
+        uint16_t value);
     uint8_t apdu_retries(
         void);
     void apdu_retries_set(
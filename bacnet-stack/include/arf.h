@@ -88,6 +88,12 @@ extern "C" {
         uint8_t * apdu,
         unsigned apdu_len,
         BACNET_ATOMIC_READ_FILE_DATA * data);
+/* the fileData is decoded as views that point into the apdu */
+    int arf_ack_decode_service_request_view(
+        uint8_t * apdu,
+        unsigned apdu_len,
+        BACNET_ATOMIC_READ_FILE_DATA * data,
+        BACNET_OCTET_STRING_VIEW file_data[BACNET_READ_FILE_RECORD_COUNT]);
 
     int arf_ack_decode_apdu(
         uint8_t * apdu,
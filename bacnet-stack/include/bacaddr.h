@@ -39,6 +39,8 @@ extern "C" {
     bool bacnet_address_same(
         BACNET_ADDRESS * dest,
         BACNET_ADDRESS * src);
+    uint32_t bacnet_address_hash(
+        BACNET_ADDRESS * src);
 
 #ifdef __cplusplus
 }
@@ -131,6 +131,68 @@ typedef struct BACnet_Object_Property_Value {
     BACNET_APPLICATION_DATA_VALUE *value;
 } BACNET_OBJECT_PROPERTY_VALUE;
 
+/* A compact BACNET_APPLICATION_DATA_VALUE, for decoding many values.
+   The character and octet strings are not stored in the value:
+   after bacapp_compact_decode_application_data they point into the
+   APDU, which must not change or be freed while the value is used;
+   after bacapp_compact_copy they are allocated, and must be released
+   with bacapp_compact_free. */
+struct BACnet_Application_Compact_Value;
+typedef struct BACnet_Application_Compact_Value {
+    bool context_specific;      /* true if context specific data */
+    uint8_t context_tag;        /* only used for context specific data */
+    uint8_t tag;        /* application tag data type */
+    bool allocated;     /* true if the string was allocated by a copy */
+    union {
+        /* NULL - not needed as it is encoded in the tag alone */
+#if defined (BACAPP_BOOLEAN)
+        bool Boolean;
+#endif
+#if defined (BACAPP_UNSIGNED)
+        uint32_t Unsigned_Int;
+#endif
+#if defined (BACAPP_SIGNED)
+        int32_t Signed_Int;
+#endif
+#if defined (BACAPP_REAL)
+        float Real;
+#endif
+#if defined (BACAPP_DOUBLE)
+        double Double;
+#endif
+#if defined (BACAPP_OCTET_STRING)
+        BACNET_OCTET_STRING_VIEW Octet_String;
+#endif
+#if defined (BACAPP_CHARACTER_STRING)
+        BACNET_CHARACTER_STRING_VIEW Character_String;
+#endif
+#if defined (BACAPP_BIT_STRING)
+        BACNET_BIT_STRING Bit_String;
+#endif
+#if defined (BACAPP_ENUMERATED)
+        uint32_t Enumerated;
+#endif
+#if defined (BACAPP_DATE)
+        BACNET_DATE Date;
+#endif
+#if defined (BACAPP_TIME)
+        BACNET_TIME Time;
+#endif
+#if defined (BACAPP_OBJECT_ID)
+        BACNET_OBJECT_ID Object_Id;
+#endif
+#if defined (BACAPP_LIGHTING_COMMAND)
+        BACNET_LIGHTING_COMMAND Lighting_Command;
+#endif
+#if defined (BACAPP_DEVICE_OBJECT_PROP_REF)
+        BACNET_DEVICE_OBJECT_PROPERTY_REFERENCE
+            Device_Object_Property_Reference;
+#endif
+    } type;
+    /* simple linked list if needed */
+    struct BACnet_Application_Compact_Value *next;
+} BACNET_APPLICATION_COMPACT_VALUE;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -181,6 +243,27 @@ extern "C" {
         BACNET_APPLICATION_DATA_VALUE * dest_value,
         BACNET_APPLICATION_DATA_VALUE * src_value);
 
+    int bacapp_compact_decode_application_data(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        BACNET_APPLICATION_COMPACT_VALUE * value);
+    int bacapp_compact_encode_application_data(
+        uint8_t * apdu,
+        BACNET_APPLICATION_COMPACT_VALUE * value);
+    /* copies the strings, which are then released with bacapp_compact_free */
+    bool bacapp_compact_copy(
+        BACNET_APPLICATION_COMPACT_VALUE * dest_value,
+        BACNET_APPLICATION_COMPACT_VALUE * src_value);
+    void bacapp_compact_free(
+        BACNET_APPLICATION_COMPACT_VALUE * value);
+    /* the compact value points to the strings of the source value */
+    void bacapp_compact_from_value(
+        BACNET_APPLICATION_COMPACT_VALUE * dest_value,
+        BACNET_APPLICATION_DATA_VALUE * src_value);
+    bool bacapp_compact_to_value(
+        BACNET_APPLICATION_DATA_VALUE * dest_value,
+        BACNET_APPLICATION_COMPACT_VALUE * src_value);
+
     /* returns the length of data between an opening tag and a closing tag.
        Expects that the first octet contain the opening tag.
        Include a value property identifier for context specific data
@@ -213,6 +296,12 @@ extern "C" {
         char *str,
         size_t str_len,
         BACNET_OBJECT_PROPERTY_VALUE * object_value);
+    int bacapp_compact_snprintf_value(
+        char *str,
+        size_t str_len,
+        BACNET_OBJECT_TYPE object_type,
+        BACNET_PROPERTY_ID property,
+        BACNET_APPLICATION_COMPACT_VALUE * value);
 #endif
 
 #ifdef BACAPP_PRINT_ENABLED
@@ -238,6 +327,8 @@ extern "C" {
 
     void testBACnetApplicationDataLength(
         Test * pTest);
+    void testBACnetApplicationCompactValue(
+        Test * pTest);
     void testBACnetApplicationData(
         Test * pTest);
 #endif
@@ -219,6 +219,16 @@ extern "C" {
         uint8_t * apdu,
         uint8_t tag_number,
         BACNET_OCTET_STRING * octet_string);
+/* the view points into the apdu - see bacstr.h.
+   The caller checks that len_value fits in the apdu. */
+    int decode_octet_string_view(
+        uint8_t * apdu,
+        uint32_t len_value,
+        BACNET_OCTET_STRING_VIEW * view);
+    int decode_context_octet_string_view(
+        uint8_t * apdu,
+        uint8_t tag_number,
+        BACNET_OCTET_STRING_VIEW * view);
 
 
 /* from clause 20.2.9 Encoding of a Character String Value */
@@ -248,6 +258,16 @@ extern "C" {
         uint8_t * apdu,
         uint8_t tag_number,
         BACNET_CHARACTER_STRING * char_string);
+/* the view points into the apdu - see bacstr.h.
+   The caller checks that len_value fits in the apdu. */
+    int decode_character_string_view(
+        uint8_t * apdu,
+        uint32_t len_value,
+        BACNET_CHARACTER_STRING_VIEW * view);
+    int decode_context_character_string_view(
+        uint8_t * apdu,
+        uint8_t tag_number,
+        BACNET_CHARACTER_STRING_VIEW * view);
 
 
 /* from clause 20.2.4 Encoding of an Unsigned Integer Value */
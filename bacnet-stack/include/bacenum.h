@@ -1279,7 +1279,10 @@ typedef enum {
     /* lifeSafetyOperation (27) see Alarm and Event Services */
     /* subscribeCOVProperty (28) see Alarm and Event Services */
     /* getEventInformation (29) see Alarm and Event Services */
-    MAX_BACNET_CONFIRMED_SERVICE = 30
+    /* Services added after 2012 */
+    SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE = 30,
+    SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE = 31,
+    MAX_BACNET_CONFIRMED_SERVICE = 32
 } BACNET_CONFIRMED_SERVICE;
 
 typedef enum {
@@ -1295,12 +1298,13 @@ typedef enum {
     SERVICE_UNCONFIRMED_UTC_TIME_SYNCHRONIZATION = 9,
     /* addendum 2010-aa */
     SERVICE_UNCONFIRMED_WRITE_GROUP = 10,
+    SERVICE_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE = 11,
     /* Other services to be added as they are defined. */
     /* All choice values in this production are reserved */
     /* for definition by ASHRAE. */
     /* Proprietary extensions are made by using the */
     /* UnconfirmedPrivateTransfer service. See Clause 23. */
-    MAX_BACNET_UNCONFIRMED_SERVICE = 11
+    MAX_BACNET_UNCONFIRMED_SERVICE = 12
 } BACNET_UNCONFIRMED_SERVICE;
 
 /* Bit String Enumerations */
@@ -1330,6 +1334,9 @@ typedef enum {
     SERVICE_SUPPORTED_WRITE_PROPERTY = 15,
     SERVICE_SUPPORTED_WRITE_PROP_MULTIPLE = 16,
     SERVICE_SUPPORTED_WRITE_GROUP = 40,
+    SERVICE_SUPPORTED_SUBSCRIBE_COV_PROPERTY_MULTIPLE = 41,
+    SERVICE_SUPPORTED_CONFIRMED_COV_NOTIFICATION_MULTIPLE = 42,
+    SERVICE_SUPPORTED_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE = 43,
     /* Remote Device Management Services */
     SERVICE_SUPPORTED_DEVICE_COMMUNICATION_CONTROL = 17,
     SERVICE_SUPPORTED_PRIVATE_TRANSFER = 18,
@@ -52,6 +52,22 @@ typedef struct BACnet_Octet_String {
     uint8_t value[MAX_OCTET_STRING_BYTES];
 } BACNET_OCTET_STRING;
 
+/* A view borrows the string from a buffer it does not own, usually the
+   received APDU that it was decoded from.  It is only valid until that
+   buffer is changed or reused, so copy it into a BACNET_CHARACTER_STRING
+   or BACNET_OCTET_STRING to keep it any longer.  A view is not limited
+   to the capacity of the string types. */
+typedef struct BACnet_Character_String_View {
+    const char *value;
+    uint32_t length;
+    uint8_t encoding;
+} BACNET_CHARACTER_STRING_VIEW;
+
+typedef struct BACnet_Octet_String_View {
+    const uint8_t *value;
+    uint32_t length;
+} BACNET_OCTET_STRING_VIEW;
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -151,6 +167,27 @@ extern "C" {
         const char *str,
         size_t length);
 
+/* views of a string owned by someone else - see above */
+    void characterstring_view_init(
+        BACNET_CHARACTER_STRING_VIEW * view,
+        uint8_t encoding,
+        const char *value,
+        size_t length);
+    void characterstring_view_from(
+        BACNET_CHARACTER_STRING_VIEW * view,
+        BACNET_CHARACTER_STRING * char_string);
+/* returns false if the view exceeds the capacity of the string */
+    bool characterstring_view_copy(
+        BACNET_CHARACTER_STRING * dest,
+        const BACNET_CHARACTER_STRING_VIEW * src);
+/* returns true if the same length, encoding, value */
+    bool characterstring_view_same(
+        const BACNET_CHARACTER_STRING_VIEW * view,
+        BACNET_CHARACTER_STRING * char_string);
+    bool characterstring_view_same_view(
+        const BACNET_CHARACTER_STRING_VIEW * view1,
+        const BACNET_CHARACTER_STRING_VIEW * view2);
+
     /* returns false if the string exceeds capacity
        initialize by using length=0 */
     bool octetstring_init(
@@ -195,10 +232,25 @@ extern "C" {
         BACNET_OCTET_STRING * octet_string1,
         BACNET_OCTET_STRING * octet_string2);
 
+/* views of a string owned by someone else - see above */
+    void octetstring_view_init(
+        BACNET_OCTET_STRING_VIEW * view,
+        const uint8_t * value,
+        size_t length);
+    void octetstring_view_from(
+        BACNET_OCTET_STRING_VIEW * view,
+        BACNET_OCTET_STRING * octet_string);
+/* returns false if the view exceeds the capacity of the string */
+    bool octetstring_view_copy(
+        BACNET_OCTET_STRING * dest,
+        const BACNET_OCTET_STRING_VIEW * src);
+
 #ifdef TEST
 #include "ctest.h"
     void testBACnetStrings(
         Test * pTest);
+    void testStringViews(
+        Test * pTest);
 #endif
 
 #ifdef __cplusplus
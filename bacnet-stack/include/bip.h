@@ -80,6 +80,22 @@ extern "C" {
         uint8_t * pdu,  /* PDU data */
         uint16_t max_pdu,       /* amount of space available in the PDU  */
         unsigned timeout);      /* milliseconds to wait for a packet */
+    /* number of packets already received that bip_receive returns
+       without waiting */
+    unsigned bip_receive_pending(
+        void);
+
+    /* whole datagrams, BVLC included, with addresses in network order */
+    int bip_receive_mpdu(
+        uint8_t * mtu,
+        uint16_t max_mtu,
+        struct sockaddr_in *sin,
+        unsigned timeout);
+    int bip_send_mpdu_multiple(
+        struct sockaddr_in *dest,
+        unsigned dest_count,
+        uint8_t * mtu,
+        uint16_t mtu_len);
 
     /* use network byte order for setting */
     void bip_set_port(
@@ -143,6 +143,53 @@ extern "C" {
     bool bvlc_add_bdt_entry_local(
         BBMD_TABLE_ENTRY* entry);
 
+#if defined(BBMD_ENABLED) && BBMD_ENABLED
+    /* BBMD statistics.  The counters wrap around. */
+    typedef struct {
+        unsigned bdt_entries;
+        unsigned fdt_entries;
+        /* Register-Foreign-Device from a new foreign device */
+        uint32_t fd_registrations;
+        /* Register-Foreign-Device from a registered foreign device */
+        uint32_t fd_renewals;
+        /* Register-Foreign-Device refused because the FDT is full */
+        uint32_t fd_register_naks;
+        /* Delete-Foreign-Device-Table-Entry that removed an entry */
+        uint32_t fd_deletions;
+        /* entries purged when their time to live ran out */
+        uint32_t fd_expirations;
+        uint32_t read_bdt_requests;
+        uint32_t read_fdt_requests;
+        /* Forwarded-NPDU messages sent to BDT and FDT entries */
+        uint32_t forwarded_npdus;
+        uint32_t forwarded_bytes;
+    } BVLC_BBMD_STATS;
+
+    /* Forwarded-NPDU messages sent to one BDT or FDT entry */
+    typedef struct {
+        struct in_addr dest_address;        /* in network format */
+        uint16_t dest_port; /* in network format */
+        /* FDT entries only */
+        uint16_t time_to_live;
+        uint16_t seconds_remaining;
+        uint32_t forwarded_npdus;
+        uint32_t forwarded_bytes;
+    } BVLC_PEER_STATS;
+
+    void bvlc_bbmd_stats(
+        BVLC_BBMD_STATS * stats);
+    /* Get the counts of an entry, by index into the BDT or FDT. Returns
+     * false if the index is not an entry. */
+    bool bvlc_bdt_peer_stats(
+        unsigned index,
+        BVLC_PEER_STATS * stats);
+    bool bvlc_fdt_peer_stats(
+        unsigned index,
+        BVLC_PEER_STATS * stats);
+    void bvlc_bbmd_stats_clear(
+        void);
+#endif
+
 
     /* NAT handling
      * If the communication between BBMDs goes through a NAT enabled internet
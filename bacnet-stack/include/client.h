@@ -40,6 +40,7 @@
 #include "lso.h"
 #include "alarm_ack.h"
 #include "ptransfer.h"
+#include "rpmplan.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -140,11 +141,23 @@ extern "C" {
         uint32_t object_instance,
         BACNET_PROPERTY_ID object_property,
         uint32_t array_index);
+    uint8_t Send_Read_Property_Request_Shared(
+        uint32_t device_id,     /* destination device */
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        BACNET_PROPERTY_ID object_property,
+        uint32_t array_index);
     uint8_t Send_Read_Property_Multiple_Request(
         uint8_t * pdu,
         size_t max_pdu,
         uint32_t device_id,     /* destination device */
         BACNET_READ_ACCESS_DATA * read_access_data);
+    uint8_t Send_Read_Property_Multiple_Plan(
+        uint8_t * pdu,
+        size_t max_pdu,
+        uint32_t device_id,     /* destination device */
+        RPM_PLAN_POINT * points,
+        RPM_PLAN_REQUEST * request);
 
 /* returns the invoke ID for confirmed request, or 0 if failed */
     uint8_t Send_Write_Property_Request(
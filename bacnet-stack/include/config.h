@@ -45,6 +45,16 @@
 #if !defined(BBMD_ENABLED)
 #define BBMD_ENABLED 1
 #endif
+/* Define BBMD_TABLE_DYNAMIC to 1 to allocate the broadcast distribution
+   and foreign device tables on demand, starting with BBMD_TABLE_INITIAL
+   entries and doubling as needed up to MAX_BBMD_ENTRIES and MAX_FD_ENTRIES
+   (e.g. a BBMD serving thousands of foreign devices). */
+#if !defined(BBMD_TABLE_DYNAMIC)
+#define BBMD_TABLE_DYNAMIC 0
+#endif
+#if !defined(BBMD_TABLE_INITIAL)
+#define BBMD_TABLE_INITIAL 16
+#endif
 #endif
 
 /* optional configuration for BACnet/IPv6 datalink layer */
@@ -116,14 +126,63 @@
 #if !defined(MAX_TSM_TRANSACTIONS)
 #define MAX_TSM_TRANSACTIONS 255
 #endif
+/* Segmentation lets a confirmed request or complex ack span several */
+/* APDUs (clause 5.2), e.g. a whole Object_List in one ReadProperty. */
+/* The TSM reassembles and windows the segments using heap buffers, */
+/* so it is off by default for the small embedded targets. */
+#if !defined(BACNET_SEGMENTATION_ENABLED)
+#define BACNET_SEGMENTATION_ENABLED 0
+#endif
+#if BACNET_SEGMENTATION_ENABLED
+/* number of segments we accept in one segmented message */
+#if !defined(MAX_SEGMENTS_ACCEPTED)
+#define MAX_SEGMENTS_ACCEPTED 255
+#endif
+/* window size we propose when sending segments: 1..127 */
+#if !defined(BACNET_SEGMENT_WINDOW_SIZE)
+#define BACNET_SEGMENT_WINDOW_SIZE 16
+#endif
+/* the largest segmented APDU we will reassemble or transmit */
+#if !defined(MAX_SEGMENTED_APDU)
+#define MAX_SEGMENTED_APDU ((unsigned long)MAX_SEGMENTS_ACCEPTED*MAX_APDU)
+#endif
+#if !MAX_TSM_TRANSACTIONS
+#error "segmentation requires the TSM: MAX_TSM_TRANSACTIONS > 0"
+#endif
+#endif
 /* The address cache is used for binding to BACnet devices */
 /* The number of entries corresponds to the number of */
 /* devices that might respond to an I-Am on the network. */
 /* If your device is a simple server and does not need to bind, */
 /* then you don't need to use this. */
+/* Define ADDRESS_CACHE_DYNAMIC to 1 to allocate the cache on demand, */
+/* starting with ADDRESS_CACHE_INITIAL entries and doubling as needed */
+/* up to MAX_ADDRESS_CACHE entries (e.g. a workstation binding to */
+/* thousands of devices). */
+#if !defined(ADDRESS_CACHE_DYNAMIC)
+#define ADDRESS_CACHE_DYNAMIC 0
+#endif
 #if !defined(MAX_ADDRESS_CACHE)
 #define MAX_ADDRESS_CACHE 255
 #endif
+#if !defined(ADDRESS_CACHE_INITIAL)
+#define ADDRESS_CACHE_INITIAL 64
+#endif
+
+/* The property cache holds values read from other devices, so that */
+/* a client can answer repeated reads of the same property locally. */
+/* Each entry holds up to MAX_PROPERTY_CACHE_DATA encoded octets, */
+/* and is fresh for PROPERTY_CACHE_TTL seconds after an RP or RPM ack, */
+/* or for the time remaining of the COV subscription that updated it. */
+#if !defined(MAX_PROPERTY_CACHE)
+#define MAX_PROPERTY_CACHE 256
+#endif
+#if !defined(MAX_PROPERTY_CACHE_DATA)
+#define MAX_PROPERTY_CACHE_DATA 64
+#endif
+#if !defined(PROPERTY_CACHE_TTL)
+#define PROPERTY_CACHE_TTL 60
+#endif
 
 /* some modules have debugging enabled using PRINT_ENABLED */
 #if !defined(PRINT_ENABLED)
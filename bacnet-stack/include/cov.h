@@ -37,6 +37,27 @@ typedef struct BACnet_COV_Data {
     BACNET_PROPERTY_VALUE *listOfValues;
 } BACNET_COV_DATA;
 
+/* called with each COV notification that is received */
+typedef void (
+    *cov_notification_function) (
+    BACNET_COV_DATA * cov_data);
+
+/* one object in a COVNotificationMultiple */
+typedef struct BACnet_COV_Notification {
+    BACNET_OBJECT_ID monitoredObjectIdentifier;
+    /* simple linked list of values */
+    BACNET_PROPERTY_VALUE *listOfValues;
+    struct BACnet_COV_Notification *next;
+} BACNET_COV_NOTIFICATION;
+
+typedef struct BACnet_COV_Multiple_Data {
+    uint32_t subscriberProcessIdentifier;
+    uint32_t initiatingDeviceIdentifier;
+    uint32_t timeRemaining;     /* seconds */
+    /* simple linked list of notifications */
+    BACNET_COV_NOTIFICATION *listOfCOVNotifications;
+} BACNET_COV_MULTIPLE_DATA;
+
 struct BACnet_Subscribe_COV_Data;
 typedef struct BACnet_Subscribe_COV_Data {
     uint32_t subscriberProcessIdentifier;
@@ -116,10 +137,44 @@ extern "C" {
         BACNET_PROPERTY_VALUE *value_list,
         size_t count);
 
+    int cov_notification_encode(
+        uint8_t * apdu,
+        BACNET_COV_NOTIFICATION * notification);
+
+    int ucov_notify_multiple_encode_apdu(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        BACNET_COV_MULTIPLE_DATA * data);
+
+    int ucov_notify_multiple_decode_apdu(
+        uint8_t * apdu,
+        unsigned apdu_len,
+        BACNET_COV_MULTIPLE_DATA * data);
+
+    int ccov_notify_multiple_encode_apdu(
+        uint8_t * apdu,
+        unsigned max_apdu_len,
+        uint8_t invoke_id,
+        BACNET_COV_MULTIPLE_DATA * data);
+
+    int ccov_notify_multiple_decode_apdu(
+        uint8_t * apdu,
+        unsigned apdu_len,
+        uint8_t * invoke_id,
+        BACNET_COV_MULTIPLE_DATA * data);
+
+    /* common for both confirmed and unconfirmed */
+    int cov_notify_multiple_decode_service_request(
+        uint8_t * apdu,
+        unsigned apdu_len,
+        BACNET_COV_MULTIPLE_DATA * data);
+
 #ifdef TEST
 #include "ctest.h"
     void testCOVNotify(
         Test * pTest);
+    void testCOVNotifyMultiple(
+        Test * pTest);
     void testCOVSubscribeProperty(
         Test * pTest);
     void testCOVSubscribe(
@@ -26,6 +26,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -38,6 +39,24 @@ extern "C" {
         uint8_t dataValue,
         uint16_t crcValue);
 
+/* CRC of a whole block of octets - define CRC_USE_SLICE_BY_8 to
+   calculate the Data CRC eight octets at a time, using 4K of tables */
+    uint8_t CRC_Calc_Header_Block(
+        const uint8_t * buffer,
+        size_t length,
+        uint8_t crcValue);
+    uint16_t CRC_Calc_Data_Block(
+        const uint8_t * buffer,
+        size_t length,
+        uint16_t crcValue);
+/* header is the Frame Type through the Header CRC (6 octets) */
+    bool CRC_Header_Valid(
+        const uint8_t * header);
+/* buffer is the data followed by the two octets of Data CRC */
+    bool CRC_Data_Valid(
+        const uint8_t * buffer,
+        size_t length);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
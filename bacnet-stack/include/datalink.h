@@ -33,6 +33,7 @@
 #define datalink_init ethernet_init
 #define datalink_send_pdu ethernet_send_pdu
 #define datalink_receive ethernet_receive
+#define datalink_receive_pending() (0)
 #define datalink_cleanup ethernet_cleanup
 #define datalink_get_broadcast_address ethernet_get_broadcast_address
 #define datalink_get_my_address ethernet_get_my_address
@@ -43,6 +44,7 @@
 #define datalink_init arcnet_init
 #define datalink_send_pdu arcnet_send_pdu
 #define datalink_receive arcnet_receive
+#define datalink_receive_pending() (0)
 #define datalink_cleanup arcnet_cleanup
 #define datalink_get_broadcast_address arcnet_get_broadcast_address
 #define datalink_get_my_address arcnet_get_my_address
@@ -53,6 +55,7 @@
 #define datalink_init dlmstp_init
 #define datalink_send_pdu dlmstp_send_pdu
 #define datalink_receive dlmstp_receive
+#define datalink_receive_pending() (0)
 #define datalink_cleanup dlmstp_cleanup
 #define datalink_get_broadcast_address dlmstp_get_broadcast_address
 #define datalink_get_my_address dlmstp_get_my_address
@@ -69,6 +72,7 @@
 #define datalink_send_pdu bip_send_pdu
 #define datalink_receive bip_receive
 #endif
+#define datalink_receive_pending bip_receive_pending
 #define datalink_cleanup bip_cleanup
 #define datalink_get_broadcast_address bip_get_broadcast_address
 #ifdef BAC_ROUTING
@@ -85,6 +89,7 @@ extern void routed_get_my_address(
 #define datalink_init bip6_init
 #define datalink_send_pdu bip6_send_pdu
 #define datalink_receive bip6_receive
+#define datalink_receive_pending() (0)
 #define datalink_cleanup bip6_cleanup
 #define datalink_get_broadcast_address bip6_get_broadcast_address
 #define datalink_get_my_address bip6_get_my_address
@@ -110,6 +115,8 @@ extern "C" {
         uint8_t * pdu,
         uint16_t max_pdu,
         unsigned timeout);
+    extern unsigned datalink_receive_pending(
+        void);
     extern void datalink_cleanup(
         void);
     extern void datalink_get_broadcast_address(
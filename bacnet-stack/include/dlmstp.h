@@ -68,6 +68,10 @@ extern "C" {
         uint16_t max_pdu,       /* amount of space available in the PDU  */
         unsigned timeout);      /* milliseconds to wait for a packet */
 
+    /* Linux: readable while a packet is waiting for dlmstp_receive */
+    int dlmstp_receive_fd(
+        void);
+
     /* This parameter represents the value of the Max_Info_Frames property of */
     /* the node's Device object. The value of Max_Info_Frames specifies the */
     /* maximum number of information frames the node may send before it must */
@@ -40,6 +40,8 @@ extern "C" {
 
     bool ethernet_valid(
         void);
+    int ethernet_socket(
+        void);
     void ethernet_cleanup(
         void);
     bool ethernet_init(
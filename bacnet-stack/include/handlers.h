@@ -27,6 +27,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include "bacdef.h"
 #include "apdu.h"
@@ -41,7 +42,38 @@
 #include "getevent.h"
 #include "get_alarm_sum.h"
 #include "alarm_ack.h"
-
+#include "cov.h"
+
+/* counters of the COV notifications sent */
+typedef struct BACnet_COV_Batch_Counters {
+    /* notifications of a changed object */
+    uint32_t notifications;
+    /* COVNotification and COVNotificationMultiple requests */
+    uint32_t packets;
+    uint32_t multiple_packets;
+    /* notifications that did not need a request of their own */
+    uint32_t packets_saved;
+    /* COVNotificationMultiple requests that the subscriber refused */
+    uint32_t fallbacks;
+} BACNET_COV_BATCH_COUNTERS;
+
+/* memory that a decoded RPM Ack is laid out in, and freed from in one call */
+typedef struct BACnet_RPM_Ack_Arena {
+    /* the block being decoded into */
+    uint8_t *buffer;
+    size_t size;
+    size_t used;
+    /* offset of the last node given out */
+    size_t last;
+    /* bytes given out since the last reset */
+    size_t total;
+    /* true if the buffer is from the caller, and cannot grow */
+    bool fixed;
+    /* true if a node did not fit since the last reset */
+    bool full;
+    /* blocks malloc'd by the arena, newest first */
+    void *blocks;
+} BACNET_RPM_ACK_ARENA;
 
 #ifdef __cplusplus
 extern "C" {
@@ -131,7 +163,7 @@ extern "C" {
 
     void handler_read_property_ack(
         uint8_t * service_request,
-        uint16_t service_len,
+        uint32_t service_len,
         BACNET_ADDRESS * src,
         BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data);
 
@@ -168,7 +200,7 @@ extern "C" {
 
     void handler_atomic_read_file_ack(
         uint8_t * service_request,
-        uint16_t service_len,
+        uint32_t service_len,
         BACNET_ADDRESS * src,
         BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data);
 
@@ -233,7 +265,7 @@ extern "C" {
 
     void handler_read_property_multiple_ack(
         uint8_t * service_request,
-        uint16_t service_len,
+        uint32_t service_len,
         BACNET_ADDRESS * src,
         BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data);
 
@@ -242,6 +274,20 @@ extern "C" {
         uint8_t * apdu,
         int apdu_len,
         BACNET_READ_ACCESS_DATA * read_access_data);
+    /* Decode the received RPM data into an arena, which frees it in one call */
+    int rpm_ack_decode_service_request_arena(
+        uint8_t * apdu,
+        int apdu_len,
+        BACNET_RPM_ACK_ARENA * arena,
+        BACNET_READ_ACCESS_DATA ** read_access_data);
+    void rpm_ack_arena_init(
+        BACNET_RPM_ACK_ARENA * arena,
+        uint8_t * buffer,
+        size_t size);
+    void rpm_ack_arena_reset(
+        BACNET_RPM_ACK_ARENA * arena);
+    void rpm_ack_arena_free(
+        BACNET_RPM_ACK_ARENA * arena);
     /* print the RP Ack data to stdout */
     void rp_ack_print_data(
         BACNET_READ_PROPERTY_DATA * data);
@@ -267,16 +313,33 @@ extern "C" {
     int handler_cov_encode_subscriptions(
         uint8_t * apdu,
         int max_apdu);
+    void handler_cov_object_changed(
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance);
+    void handler_cov_batching_set(
+        bool enable,
+        uint16_t window_ms);
+    void handler_cov_timer_milliseconds(
+        uint16_t elapsed_milliseconds);
+    void handler_cov_batch_counters(
+        BACNET_COV_BATCH_COUNTERS * counters);
+    void handler_ccov_notification_multiple_ack(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id);
 
     void handler_ucov_notification(
         uint8_t * service_request,
         uint16_t service_len,
         BACNET_ADDRESS * src);
+    void handler_ucov_notification_set(
+        cov_notification_function pFunction);
     void handler_ccov_notification(
         uint8_t * service_request,
         uint16_t service_len,
         BACNET_ADDRESS * src,
         BACNET_CONFIRMED_SERVICE_DATA * service_data);
+    void handler_ccov_notification_set(
+        cov_notification_function pFunction);
 
     void handler_lso(
         uint8_t * service_request,
@@ -302,7 +365,7 @@ extern "C" {
 
     void handler_conf_private_trans_ack(
         uint8_t * service_request,
-        uint16_t service_len,
+        uint32_t service_len,
         BACNET_ADDRESS * src,
         BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data);
 
@@ -322,7 +385,7 @@ extern "C" {
 
     void handler_read_range_ack(
         uint8_t * service_request,
-        uint16_t service_len,
+        uint32_t service_len,
         BACNET_ADDRESS * src,
         BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data);
 
@@ -348,13 +411,13 @@ extern "C" {
 
     void get_alarm_summary_ack_handler(
         uint8_t * service_request,
-        uint16_t service_len,
+        uint32_t service_len,
         BACNET_ADDRESS * src,
         BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data);
 
     void get_event_ack_handler(
         uint8_t *service_request,
-        uint16_t service_len,
+        uint32_t service_len,
         BACNET_ADDRESS *src,
         BACNET_CONFIRMED_SERVICE_ACK_DATA *service_data);
 
@@ -0,0 +1,108 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#ifndef HASHINDEX_H
+#define HASHINDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @file hashindex.h  Open addressing hash index of a table of entries */
+
+/* number of slots for a table of n entries, so that it is never
+   more than half full */
+#define HASH_INDEX_SIZE(n) (((n) * 2) + 1)
+
+/** An index of the entries of a table, kept by the hash of their keys.
+ * Each slot holds the index of an entry plus one, so that zero marks
+ * an empty slot, and entries of the same hash are in the slots that
+ * follow their home slot.  The slots are an array of uint16_t or of
+ * uint32_t that is kept by the user of the index, who also finds the
+ * entries with the same key, since only it knows how keys compare.
+ * @{ */
+typedef struct hash_index {
+    /** the array of slots */
+    void *slots;
+    /** size of a slot in octets: 2 or 4 */
+    unsigned width;
+    /** number of slots */
+    unsigned size;
+    /** hash of the key of the entry at an index */
+    uint32_t(*home) (uint32_t index);
+} HASH_INDEX;
+/** @} */
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    uint32_t hash_index_mix(
+        uint32_t key);
+
+    void hash_index_init(
+        HASH_INDEX * h,
+        void *slots,
+        unsigned width,
+        unsigned size,
+        uint32_t(*home) (uint32_t index));
+    void hash_index_clear(
+        HASH_INDEX * h);
+
+    unsigned hash_index_start(
+        HASH_INDEX const *h,
+        uint32_t hash);
+    unsigned hash_index_next(
+        HASH_INDEX const *h,
+        unsigned slot);
+    uint32_t hash_index_get(
+        HASH_INDEX const *h,
+        unsigned slot);
+    void hash_index_set(
+        HASH_INDEX * h,
+        unsigned slot,
+        uint32_t index);
+
+    unsigned hash_index_slot(
+        HASH_INDEX const *h,
+        uint32_t index);
+    void hash_index_insert(
+        HASH_INDEX * h,
+        uint32_t index);
+    void hash_index_remove(
+        HASH_INDEX * h,
+        uint32_t index);
+    void hash_index_move(
+        HASH_INDEX * h,
+        uint32_t from,
+        uint32_t to);
+
+#ifdef TEST
+#include "ctest.h"
+    void testHashIndex(
+        Test * pTest);
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
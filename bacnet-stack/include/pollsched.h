@@ -0,0 +1,196 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#ifndef POLLSCHED_H
+#define POLLSCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bacdef.h"
+#include "bacenum.h"
+#include "bacapp.h"
+#include "apdu.h"
+
+/* number of devices and points that can be polled */
+#ifndef MAX_POLL_DEVICES
+#define MAX_POLL_DEVICES 256
+#endif
+#ifndef MAX_POLL_POINTS
+#define MAX_POLL_POINTS 4096
+#endif
+/* number of BACnet networks with their own limit of requests */
+#ifndef MAX_POLL_NETWORKS
+#define MAX_POLL_NETWORKS 32
+#endif
+/* default limits of requests outstanding at once */
+#ifndef POLL_DEVICE_REQUESTS
+#define POLL_DEVICE_REQUESTS 1
+#endif
+#ifndef POLL_NETWORK_REQUESTS
+#define POLL_NETWORK_REQUESTS 8
+#endif
+#ifndef POLL_BIND_REQUESTS
+#define POLL_BIND_REQUESTS 16
+#endif
+/* milliseconds to wait for an I-Am before another Who-Is */
+#ifndef POLL_BIND_TIMEOUT
+#define POLL_BIND_TIMEOUT 3000
+#endif
+/* points read by one ReadPropertyMultiple request, at most */
+#ifndef POLL_REQUEST_POINTS
+#define POLL_REQUEST_POINTS 64
+#endif
+/* segments of an ack that a request is packed to fill, from a
+   device that can send segmented messages */
+#ifndef POLL_ACK_SEGMENTS
+#define POLL_ACK_SEGMENTS 4
+#endif
+/* points read once that wait to be sent, or on a reply, at most */
+#ifndef MAX_POLL_READS
+#define MAX_POLL_READS 256
+#endif
+/* milliseconds that a read waits to be sent before it is given up */
+#ifndef POLL_READ_TIMEOUT
+#define POLL_READ_TIMEOUT 60000UL
+#endif
+/* values of a list read with ReadProperty that are given with the
+   point, at most */
+#ifndef POLL_RP_VALUES
+#define POLL_RP_VALUES 32
+#endif
+
+/* Counters for one polled device.  Times are in milliseconds. */
+typedef struct {
+    /* scans that read every point of the device */
+    uint32_t scans;
+    /* time from the first request of the last scan to its last reply */
+    uint32_t scan_time;
+    /* time from the first Who-Is to the binding */
+    uint32_t bind_time;
+    uint32_t requests;
+    uint32_t replies;
+    /* Error, Reject or Abort replies */
+    uint32_t errors;
+    uint32_t timeouts;
+    /* round trip time of a request and its reply */
+    uint32_t rtt_min;
+    uint32_t rtt_max;
+    uint64_t rtt_total;
+} POLL_DEVICE_STATS;
+
+/* called with the value, or the error in place of a value, of each
+   point that was read, or of each read with its number in place of the
+   point.  The reference is only valid for the call. */
+typedef void (
+    *poll_value_function) (
+    uint32_t device_id,
+    unsigned point,
+    BACNET_PROPERTY_REFERENCE * reference);
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    void poll_init(
+        poll_value_function pFunction);
+    void poll_limits_set(
+        unsigned device_requests,
+        unsigned network_requests,
+        unsigned bind_requests);
+
+    bool poll_device_add(
+        uint32_t device_id,
+        uint32_t interval);
+    int poll_point_add(
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        BACNET_PROPERTY_ID object_property,
+        uint32_t array_index);
+    bool poll_read(
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        BACNET_PROPERTY_ID object_property,
+        uint32_t array_index,
+        poll_value_function pFunction,
+        unsigned number);
+    void poll_read_cancel(
+        poll_value_function pFunction,
+        unsigned number);
+    bool poll_device_bound(
+        uint32_t device_id);
+
+    void poll_task(
+        uint16_t elapsed_milliseconds);
+    unsigned poll_outstanding(
+        void);
+
+    bool poll_device_stats(
+        uint32_t device_id,
+        POLL_DEVICE_STATS * stats);
+
+    void handler_poll_i_am(
+        uint8_t * service_request,
+        uint16_t service_len,
+        BACNET_ADDRESS * src);
+    void handler_poll_rpm_ack(
+        uint8_t * service_request,
+        uint32_t service_len,
+        BACNET_ADDRESS * src,
+        BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data);
+    void handler_poll_rp_ack(
+        uint8_t * service_request,
+        uint32_t service_len,
+        BACNET_ADDRESS * src,
+        BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data);
+    void handler_poll_error(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id,
+        BACNET_ERROR_CLASS error_class,
+        BACNET_ERROR_CODE error_code);
+    void handler_poll_rp_error(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id,
+        BACNET_ERROR_CLASS error_class,
+        BACNET_ERROR_CODE error_code);
+    void handler_poll_abort(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id,
+        uint8_t abort_reason,
+        bool server);
+    void handler_poll_reject(
+        BACNET_ADDRESS * src,
+        uint8_t invoke_id,
+        uint8_t reject_reason);
+
+#ifdef TEST
+#include "ctest.h"
+    void testPollScheduler(
+        Test * pTest);
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -0,0 +1,145 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#ifndef PROPCACHE_H
+#define PROPCACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "bacdef.h"
+#include "bacenum.h"
+#include "rp.h"
+#include "rpm.h"
+#include "cov.h"
+
+/* Counters of the property cache, and a snapshot of its entries */
+typedef struct {
+    /* reads answered with a fresh value */
+    uint32_t hits;
+    /* reads of a property that is not in the cache */
+    uint32_t misses;
+    /* reads of a property whose value is past its time to live */
+    uint32_t stale_reads;
+    /* requests that joined a read of the same property in flight */
+    uint32_t collapsed;
+    /* values stored from RP and RPM acks, and from COV notifications */
+    uint32_t ack_updates;
+    uint32_t cov_updates;
+    /* values too large for an entry, and entries reused when full */
+    uint32_t oversize;
+    uint32_t evictions;
+    /* hits as a percentage of all reads */
+    unsigned hit_ratio;
+    /* entries in use, with a fresh value, past their time to live,
+       and waiting on a request in flight */
+    unsigned entries;
+    unsigned fresh;
+    unsigned stale;
+    unsigned pending;
+    /* seconds since the oldest fresh value was updated, and the mean */
+    uint32_t age_max;
+    uint32_t age_mean;
+} PROPERTY_CACHE_STATS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    void property_cache_init(
+        void);
+
+    bool property_cache_store(
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        BACNET_PROPERTY_ID object_property,
+        uint32_t array_index,
+        uint8_t * application_data,
+        int application_data_len,
+        uint32_t ttl);
+
+    int property_cache_read(
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        BACNET_PROPERTY_ID object_property,
+        uint32_t array_index,
+        uint8_t * application_data,
+        size_t application_data_size,
+        uint32_t * age);
+
+    void property_cache_invalidate(
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        BACNET_PROPERTY_ID object_property,
+        uint32_t array_index);
+    void property_cache_invalidate_device(
+        uint32_t device_id);
+
+    uint8_t property_cache_pending(
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        BACNET_PROPERTY_ID object_property,
+        uint32_t array_index);
+    bool property_cache_pending_set(
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        uint32_t object_instance,
+        BACNET_PROPERTY_ID object_property,
+        uint32_t array_index,
+        uint8_t invoke_id);
+    void property_cache_pending_clear(
+        uint8_t invoke_id);
+
+    void property_cache_rp_ack(
+        uint32_t device_id,
+        uint8_t invoke_id,
+        BACNET_READ_PROPERTY_DATA * rp_data);
+    void property_cache_rpm_ack(
+        uint32_t device_id,
+        uint8_t invoke_id,
+        BACNET_READ_ACCESS_DATA * rpm_data);
+    void property_cache_cov(
+        BACNET_COV_DATA * cov_data);
+
+    void property_cache_timer(
+        uint16_t uSeconds);
+
+    void property_cache_stats(
+        PROPERTY_CACHE_STATS * stats);
+    void property_cache_stats_reset(
+        void);
+
+#ifdef TEST
+#include "ctest.h"
+    void testPropertyCache(
+        Test * pTest);
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
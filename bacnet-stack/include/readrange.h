@@ -42,6 +42,7 @@ extern "C" {
         BACNET_BIT_STRING ResultFlags;  /**<  FIRST_ITEM, LAST_ITEM, MORE_ITEMS. */
         int RequestType;/**< Index, sequence or time based request. */
         int Overhead;    /**< How much space the baggage takes in the response. */
+        int MaxApdu;     /**< Size of the response APDU, larger if segmented. */
         uint32_t ItemCount;
         uint32_t FirstSequence;
         union { /**< Pick the appropriate data type. */
@@ -99,6 +100,13 @@ extern "C" {
 #define RR_1ST_SEQ_OVERHEAD 5
 #define RR_INDEX_OVERHEAD   3   /* or 5 if paranoid */
 
+/* The absolute worst case for the part of the response ahead of the
+ * items - 1. to 5. with 5 byte property and array index, a 5 byte Item
+ * Count and the opening tag - and for the part behind them, the closing
+ * tag and firstSequenceNumber. */
+#define RR_ACK_HEADER_MAX   27
+#define RR_ACK_TRAILER_MAX  6
+
 /** Define pointer to function type for handling ReadRange request.
    This function will take the following parameters:
   - 1. A pointer to a buffer of at least MAX_APDU bytes to build the response in.
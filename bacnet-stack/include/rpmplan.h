@@ -0,0 +1,151 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#ifndef RPMPLAN_H
+#define RPMPLAN_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "bacdef.h"
+#include "bacenum.h"
+#include "rp.h"
+#include "rpm.h"
+
+/* devices whose ReadPropertyMultiple support and limits are kept */
+#ifndef MAX_RPM_PLAN_DEVICES
+#define MAX_RPM_PLAN_DEVICES 256
+#endif
+/* encoded sizes of values learned from acks, per device and property */
+#ifndef RPM_PLAN_SIZES
+#define RPM_PLAN_SIZES 1024
+#endif
+/* entries of a set, any of which can hold the size of a property */
+#ifndef RPM_PLAN_WAYS
+#define RPM_PLAN_WAYS 4
+#endif
+#define RPM_PLAN_SETS \
+    (((RPM_PLAN_SIZES) + (RPM_PLAN_WAYS) - 1) / (RPM_PLAN_WAYS))
+/* points read by one ReadPropertyMultiple request, at most */
+#ifndef RPM_PLAN_REQUEST_POINTS
+#define RPM_PLAN_REQUEST_POINTS 64
+#endif
+/* encoded octets expected for a value that has not been seen yet,
+   and for a value of a property that holds a character string */
+#ifndef RPM_PLAN_VALUE_SIZE
+#define RPM_PLAN_VALUE_SIZE 8
+#endif
+#ifndef RPM_PLAN_STRING_SIZE
+#define RPM_PLAN_STRING_SIZE 32
+#endif
+/* room for the NPDU in front of a request, which must also fit
+   within the max APDU of the device - see s_rpm.c */
+#ifndef RPM_PLAN_NPDU_SIZE
+#define RPM_PLAN_NPDU_SIZE 24
+#endif
+
+/* One property to be read */
+typedef struct {
+    BACNET_OBJECT_TYPE object_type;
+    uint32_t object_instance;
+    BACNET_PROPERTY_ID object_property;
+    uint32_t array_index;
+} RPM_PLAN_POINT;
+
+/* One request of a plan, which reads a run of the points */
+typedef struct {
+    /* first point, and the number of points */
+    unsigned first;
+    unsigned count;
+    /* false if it is a ReadProperty of the one point */
+    bool rpm;
+    /* predicted APDU sizes of the request and of its ack */
+    uint16_t request_size;
+    uint16_t ack_size;
+} RPM_PLAN_REQUEST;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    void rpm_plan_init(
+        void);
+
+    int rpm_plan_build(
+        uint32_t device_id,
+        RPM_PLAN_POINT * points,
+        unsigned point_count,
+        RPM_PLAN_REQUEST * requests,
+        unsigned max_requests);
+    int rpm_plan_build_max_apdu(
+        uint32_t device_id,
+        unsigned max_apdu,
+        RPM_PLAN_POINT * points,
+        unsigned point_count,
+        RPM_PLAN_REQUEST * requests,
+        unsigned max_requests);
+    int rpm_plan_build_segmented(
+        uint32_t device_id,
+        unsigned max_apdu,
+        unsigned ack_segments,
+        RPM_PLAN_POINT * points,
+        unsigned point_count,
+        RPM_PLAN_REQUEST * requests,
+        unsigned max_requests);
+
+    BACNET_READ_ACCESS_DATA *rpm_plan_read_access_data(
+        RPM_PLAN_POINT * points,
+        RPM_PLAN_REQUEST * request,
+        BACNET_READ_ACCESS_DATA * objects,
+        BACNET_PROPERTY_REFERENCE * properties);
+
+    unsigned rpm_plan_value_size(
+        uint32_t device_id,
+        BACNET_OBJECT_TYPE object_type,
+        BACNET_PROPERTY_ID object_property,
+        uint32_t array_index);
+    void rpm_plan_learn_rp(
+        uint32_t device_id,
+        BACNET_READ_PROPERTY_DATA * rp_data);
+    void rpm_plan_learn_rpm(
+        uint32_t device_id,
+        BACNET_READ_ACCESS_DATA * read_access_data);
+    void rpm_plan_overflow(
+        uint32_t device_id,
+        RPM_PLAN_REQUEST * request);
+
+    bool rpm_plan_rpm_supported(
+        uint32_t device_id);
+    bool rpm_plan_rpm_supported_set(
+        uint32_t device_id,
+        bool supported);
+
+#ifdef TEST
+#include "ctest.h"
+    void testRpmPlan(
+        Test * pTest);
+#endif
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
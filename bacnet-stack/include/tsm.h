@@ -29,18 +29,21 @@
 #include <stddef.h>
 #include "bacdef.h"
 #include "npdu.h"
+#include "apdu.h"
 
 /* note: TSM functionality is optional - only needed if we are
    doing client requests */
 #if (!MAX_TSM_TRANSACTIONS)
 #define tsm_free_invoke_id(x) (void)x;
+#define tsm_free_peer_invoke_id(s,x) (void)s; (void)x;
 #else
 typedef enum {
     TSM_STATE_IDLE,
     TSM_STATE_AWAIT_CONFIRMATION,
     TSM_STATE_AWAIT_RESPONSE,
     TSM_STATE_SEGMENTED_REQUEST,
-    TSM_STATE_SEGMENTED_CONFIRMATION
+    TSM_STATE_SEGMENTED_CONFIRMATION,
+    TSM_STATE_SEGMENTED_RESPONSE
 } BACNET_TSM_STATE;
 
 /* 5.4.1 Variables And Parameters */
@@ -49,25 +52,38 @@ typedef enum {
 typedef struct BACnet_TSM_Data {
     /* used to count APDU retries */
     uint8_t RetryCount;
+#if BACNET_SEGMENTATION_ENABLED
     /* used to count segment retries */
-    /*uint8_t SegmentRetryCount;  */
+    uint8_t SegmentRetryCount;
     /* used to control APDU retries and the acceptance of server replies */
-    /*bool SentAllSegments;  */
+    bool SentAllSegments;
     /* stores the sequence number of the last segment received in order */
-    /*uint8_t LastSequenceNumber; */
+    uint8_t LastSequenceNumber;
     /* stores the sequence number of the first segment of */
     /* a sequence of segments that fill a window */
-    /*uint8_t InitialSequenceNumber; */
+    uint8_t InitialSequenceNumber;
     /* stores the current window size */
-    /*uint8_t ActualWindowSize; */
+    uint8_t ActualWindowSize;
     /* stores the window size proposed by the segment sender */
-    /*uint8_t ProposedWindowSize;  */
-    /*  used to perform timeout on PDU segments */
-    /*uint8_t SegmentTimer; */
-    /* used to perform timeout on Confirmed Requests */
-    /* in milliseconds */
-    uint16_t RequestTimer;
-    /* unique id */
+    uint8_t ProposedWindowSize;
+    /* true when we are the responding BACnet-user of this transaction */
+    bool server;
+    /* service choice and max-segs/max-APDU octet of the segmented PDU */
+    uint8_t service_choice;
+    uint8_t max_segs_max_apdu;
+    /* the service data being segmented, or being reassembled */
+    uint8_t *segment_data;
+    uint32_t segment_data_len;
+    uint32_t segment_data_size;
+    /* number of service data octets carried in each segment sent */
+    uint16_t segment_size;
+    /* index of the segment numbered InitialSequenceNumber when sending,
+       or the count of segments received in order when receiving */
+    uint32_t segment_index;
+#endif
+    /* note: the RequestTimer and SegmentTimer are kept on the
+       timer wheel of the TSM */
+    /* unique id - or unique for the peer */
     uint8_t InvokeID;
     /* state that the TSM is in */
     BACNET_TSM_STATE state;
@@ -84,6 +100,12 @@ typedef void (
     *tsm_timeout_function) (
     uint8_t invoke_id);
 
+/* timeout of any client transaction, with the peer address */
+typedef void (
+    *tsm_peer_timeout_function) (
+    BACNET_ADDRESS * dest,
+    uint8_t invoke_id);
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -91,10 +113,12 @@ extern "C" {
 
     void tsm_set_timeout_handler(
         tsm_timeout_function pFunction);
+    void tsm_set_peer_timeout_handler(
+        tsm_peer_timeout_function pFunction);
 
     bool tsm_transaction_available(
         void);
-    uint8_t tsm_transaction_idle_count(
+    uint16_t tsm_transaction_idle_count(
         void);
     void tsm_timer_milliseconds(
         uint16_t milliseconds);
@@ -126,6 +150,77 @@ extern "C" {
     bool tsm_invoke_id_failed(
         uint8_t invokeID);
 
+/* invoke IDs that are only unique for the peer, so that a client can
+   have more than 255 requests in flight to many devices.  The set
+   transaction functions take the peer address, so they work with both
+   kinds of invoke ID. */
+    uint8_t tsm_next_free_peer_invokeID(
+        BACNET_ADDRESS * dest);
+/* frees the transaction when the reply comes back - the invoke ID
+   can be either kind */
+    void tsm_free_peer_invoke_id(
+        BACNET_ADDRESS * src,
+        uint8_t invokeID);
+    bool tsm_peer_invoke_id_free(
+        BACNET_ADDRESS * dest,
+        uint8_t invokeID);
+    bool tsm_peer_invoke_id_failed(
+        BACNET_ADDRESS * dest,
+        uint8_t invokeID);
+
+#if BACNET_SEGMENTATION_ENABLED
+/* client: send service data that does not fit in one APDU to a peer
+   that accepts max_apdu octets in each segment */
+    bool tsm_set_confirmed_segmented_transaction(
+        uint8_t invokeID,
+        BACNET_ADDRESS * dest,
+        BACNET_NPDU_DATA * ndpu_data,
+        uint8_t service_choice,
+        uint16_t max_apdu,
+        uint8_t * service_data,
+        uint32_t service_data_len);
+/* server: send an encoded Complex-ACK that is larger than the
+   client max-APDU as segments.  Returns false if the client does
+   not accept that many segments or there is no room in the TSM. */
+    bool tsm_set_segmented_complex_ack_transaction(
+        BACNET_ADDRESS * dest,
+        BACNET_NPDU_DATA * ndpu_data,
+        BACNET_CONFIRMED_SERVICE_DATA * service_data,
+        uint8_t * apdu,
+        uint32_t apdu_len);
+/* server: the largest Complex-ACK, header included, that the client
+   accepts, so that a response can be trimmed to fit */
+    uint32_t tsm_segmented_complex_ack_max_len(
+        BACNET_CONFIRMED_SERVICE_DATA * service_data);
+/* reassembly of received segments - return true when the message is
+   complete, and hand over the reassembled service data, which the
+   caller must free() */
+    bool tsm_segmented_request_received(
+        BACNET_ADDRESS * src,
+        BACNET_CONFIRMED_SERVICE_DATA * service_data,
+        uint8_t service_choice,
+        uint8_t * service_request,
+        uint16_t service_request_len,
+        uint8_t ** data,
+        uint32_t * data_len);
+    bool tsm_segmented_complex_ack_received(
+        BACNET_ADDRESS * src,
+        BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data,
+        uint8_t service_choice,
+        uint8_t * service_request,
+        uint16_t service_request_len,
+        uint8_t ** data,
+        uint32_t * data_len);
+    void tsm_segment_ack_received(
+        BACNET_ADDRESS * src,
+        uint8_t * apdu,
+        uint16_t apdu_len);
+/* a client aborted the transaction we are serving */
+    void tsm_free_server_transaction(
+        BACNET_ADDRESS * src,
+        uint8_t invokeID);
+#endif
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -31,5 +31,9 @@
 #include "datalink.h"
 
 extern uint8_t Handler_Transmit_Buffer[MAX_PDU];
+#if BACNET_SEGMENTATION_ENABLED
+/* room for a Complex-ACK that will be sent as segments */
+extern uint8_t Handler_Segment_Buffer[MAX_SEGMENTED_APDU];
+#endif
 
 #endif
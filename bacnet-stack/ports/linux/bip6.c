@@ -65,6 +65,17 @@ static int BIP6_Socket = -1;
 static BACNET_IP6_ADDRESS BIP6_Addr;
 static BACNET_IP6_ADDRESS BIP6_Broadcast_Addr;
 
+/**
+ * Getter for the BACnet/IPv6 socket handle.
+ *
+ * @return The handle to the BACnet/IPv6 socket, or -1 if not open.
+ */
+int bip6_socket(
+    void)
+{
+    return BIP6_Socket;
+}
+
 /**
  * Set the interface name. On Linux, ifname is the /dev/ name of the interface.
  *
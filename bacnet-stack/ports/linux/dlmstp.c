@@ -30,6 +30,8 @@
 #include <string.h>
 #include <stdio.h>
 #include <sys/time.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include "bacdef.h"
 #include "bacaddr.h"
 #include "mstp.h"
@@ -56,6 +58,8 @@ static RT_MUTEX Receive_Packet_Mutex;
 */
 static pthread_cond_t Receive_Packet_Flag;
 static pthread_mutex_t Receive_Packet_Mutex;
+/* pipe that is readable while a packet is ready, for poll or epoll */
+static int Receive_Packet_Pipe[2] = { -1, -1 };
 /* mechanism to wait for a frame in state machine */
 /*
 static RT_COND Received_Frame_Flag;
@@ -142,6 +146,19 @@ void dlmstp_cleanup(
     pthread_mutex_destroy(&Received_Frame_Mutex);
     pthread_mutex_destroy(&Receive_Packet_Mutex);
     pthread_mutex_destroy(&Master_Done_Mutex);
+    if (Receive_Packet_Pipe[0] >= 0) {
+        close(Receive_Packet_Pipe[0]);
+        close(Receive_Packet_Pipe[1]);
+        Receive_Packet_Pipe[0] = -1;
+        Receive_Packet_Pipe[1] = -1;
+    }
+}
+
+/* file descriptor that becomes readable when dlmstp_receive has a packet */
+int dlmstp_receive_fd(
+    void)
+{
+    return Receive_Packet_Pipe[0];
 }
 
 /* returns number of bytes sent on success, zero on failure */
@@ -184,6 +201,7 @@ uint16_t dlmstp_receive(
 {       /* milliseconds to wait for a packet */
     uint16_t pdu_len = 0;
     struct timespec abstime;
+    uint8_t drain[8];
 
     (void) max_pdu;
     /* see if there is a packet available, and a place
@@ -206,6 +224,11 @@ uint16_t dlmstp_receive(
             pdu_len = Receive_Packet.pdu_len;
         }
         Receive_Packet.ready = false;
+        if (Receive_Packet_Pipe[0] >= 0) {
+            while (read(Receive_Packet_Pipe[0], drain, sizeof(drain)) > 0) {
+                /* empty the pipe */
+            }
+        }
     }
     pthread_mutex_unlock(&Receive_Packet_Mutex);
 
@@ -311,6 +334,11 @@ uint16_t MSTP_Put_Receive(
         Receive_Packet.pdu_len = mstp_port->DataLength;
         Receive_Packet.ready = true;
         pthread_cond_signal(&Receive_Packet_Flag);
+        if (Receive_Packet_Pipe[1] >= 0) {
+            if (write(Receive_Packet_Pipe[1], "", 1) < 0) {
+                debug_printf("MS/TP: receive pipe full!\n");
+            }
+        }
     }
     pthread_mutex_unlock(&Receive_Packet_Mutex);
 
@@ -693,6 +721,15 @@ bool dlmstp_init(
             "MS/TP Interface: %s\n cannot allocate PThread Mutex.\n", ifname);
         exit(1);
     }
+    if (Receive_Packet_Pipe[0] < 0) {
+        if (pipe(Receive_Packet_Pipe) == 0) {
+            fcntl(Receive_Packet_Pipe[0], F_SETFL, O_NONBLOCK);
+            fcntl(Receive_Packet_Pipe[1], F_SETFL, O_NONBLOCK);
+        } else {
+            Receive_Packet_Pipe[0] = -1;
+            Receive_Packet_Pipe[1] = -1;
+        }
+    }
     /* initialize hardware */
     if (ifname) {
         RS485_Set_Interface(ifname);
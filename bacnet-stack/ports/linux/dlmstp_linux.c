@@ -51,7 +51,8 @@
 uint32_t Timer_Silence(
     void *poPort)
 {
-    struct timeval now, tmp_diff;
+    struct timespec now;
+    int64_t nanoseconds;
     SHARED_MSTP_DATA *poSharedData;
     struct mstp_port_struct_t *mstp_port =
         (struct mstp_port_struct_t *) poPort;
@@ -63,13 +64,16 @@ uint32_t Timer_Silence(
         return -1;
     }
 
-    int32_t res;
-
-    gettimeofday(&now, NULL);
-    timersub(&poSharedData->start, &now, &tmp_diff);
-    res = ((tmp_diff.tv_sec) * 1000 + (tmp_diff.tv_usec) / 1000);
+    /* monotonic, so that setting the clock does not break the silence */
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    nanoseconds =
+        ((int64_t) (now.tv_sec - poSharedData->start.tv_sec) * 1000000000LL) +
+        (now.tv_nsec - poSharedData->start.tv_nsec);
+    if (nanoseconds < 0) {
+        return 0;
+    }
 
-    return (res >= 0 ? res : -res);
+    return (uint32_t) (nanoseconds / 1000000LL);
 }
 
 void Timer_Silence_Reset(
@@ -86,7 +90,7 @@ void Timer_Silence_Reset(
         return;
     }
 
-    gettimeofday(&poSharedData->start, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &poSharedData->start);
 }
 
 void get_abstime(
@@ -128,6 +132,30 @@ void dlmstp_cleanup(
     pthread_mutex_destroy(&poSharedData->Received_Frame_Mutex);
     pthread_mutex_destroy(&poSharedData->Receive_Packet_Mutex);
     pthread_mutex_destroy(&poSharedData->Master_Done_Mutex);
+    if (poSharedData->Receive_Packet_Pipe[0] >= 0) {
+        close(poSharedData->Receive_Packet_Pipe[0]);
+        close(poSharedData->Receive_Packet_Pipe[1]);
+        poSharedData->Receive_Packet_Pipe[0] = -1;
+        poSharedData->Receive_Packet_Pipe[1] = -1;
+    }
+}
+
+/* file descriptor that becomes readable when dlmstp_receive has a packet */
+int dlmstp_receive_fd(
+    void *poPort)
+{
+    SHARED_MSTP_DATA *poSharedData;
+    struct mstp_port_struct_t *mstp_port =
+        (struct mstp_port_struct_t *) poPort;
+    if (!mstp_port) {
+        return -1;
+    }
+    poSharedData = (SHARED_MSTP_DATA *) mstp_port->UserData;
+    if (!poSharedData) {
+        return -1;
+    }
+
+    return poSharedData->Receive_Packet_Pipe[0];
 }
 
 /* returns number of bytes sent on success, zero on failure */
@@ -177,7 +205,7 @@ uint16_t dlmstp_receive(
 {       /* milliseconds to wait for a packet */
     uint16_t pdu_len = 0;
     struct timespec abstime;
-    int rv = 0;
+    uint8_t drain[8];
     SHARED_MSTP_DATA *poSharedData;
     struct mstp_port_struct_t *mstp_port =
         (struct mstp_port_struct_t *) poPort;
@@ -191,26 +219,34 @@ uint16_t dlmstp_receive(
     (void) max_pdu;
     /* see if there is a packet available, and a place
        to put the reply (if necessary) and process it */
-    get_abstime(&abstime, timeout);
-    rv = pthread_cond_timedwait(&poSharedData->Receive_Packet_Flag,
-        &poSharedData->Receive_Packet_Mutex, &abstime);
-    if (rv == 0) {
-        if (poSharedData->Receive_Packet.ready) {
-            if (poSharedData->Receive_Packet.pdu_len) {
-                poSharedData->MSTP_Packets++;
-                if (src) {
-                    memmove(src, &poSharedData->Receive_Packet.address,
-                        sizeof(poSharedData->Receive_Packet.address));
-                }
-                if (pdu) {
-                    memmove(pdu, &poSharedData->Receive_Packet.pdu,
-                        sizeof(poSharedData->Receive_Packet.pdu));
-                }
-                pdu_len = poSharedData->Receive_Packet.pdu_len;
+    pthread_mutex_lock(&poSharedData->Receive_Packet_Mutex);
+    if (!poSharedData->Receive_Packet.ready && timeout) {
+        get_abstime(&abstime, timeout);
+        pthread_cond_timedwait(&poSharedData->Receive_Packet_Flag,
+            &poSharedData->Receive_Packet_Mutex, &abstime);
+    }
+    if (poSharedData->Receive_Packet.ready) {
+        if (poSharedData->Receive_Packet.pdu_len) {
+            poSharedData->MSTP_Packets++;
+            if (src) {
+                memmove(src, &poSharedData->Receive_Packet.address,
+                    sizeof(poSharedData->Receive_Packet.address));
+            }
+            if (pdu) {
+                memmove(pdu, &poSharedData->Receive_Packet.pdu,
+                    sizeof(poSharedData->Receive_Packet.pdu));
+            }
+            pdu_len = poSharedData->Receive_Packet.pdu_len;
+        }
+        poSharedData->Receive_Packet.ready = false;
+        if (poSharedData->Receive_Packet_Pipe[0] >= 0) {
+            while (read(poSharedData->Receive_Packet_Pipe[0], drain,
+                    sizeof(drain)) > 0) {
+                /* empty the pipe */
             }
-            poSharedData->Receive_Packet.ready = false;
         }
     }
+    pthread_mutex_unlock(&poSharedData->Receive_Packet_Mutex);
 
     return pdu_len;
 }
@@ -347,6 +383,7 @@ uint16_t MSTP_Put_Receive(
         return 0;
     }
 
+    pthread_mutex_lock(&poSharedData->Receive_Packet_Mutex);
     if (!poSharedData->Receive_Packet.ready) {
         /* bounds check - maybe this should send an abort? */
         pdu_len = mstp_port->DataLength;
@@ -359,7 +396,13 @@ uint16_t MSTP_Put_Receive(
         poSharedData->Receive_Packet.pdu_len = mstp_port->DataLength;
         poSharedData->Receive_Packet.ready = true;
         pthread_cond_signal(&poSharedData->Receive_Packet_Flag);
+        if (poSharedData->Receive_Packet_Pipe[1] >= 0) {
+            if (write(poSharedData->Receive_Packet_Pipe[1], "", 1) < 0) {
+                /* pipe is full, so it is already readable */
+            }
+        }
     }
+    pthread_mutex_unlock(&poSharedData->Receive_Packet_Mutex);
 
     return pdu_len;
 }
@@ -868,11 +911,12 @@ void dlmstp_get_broadcast_address(
     return;
 }
 
-bool dlmstp_init(
+/* opens the port and initializes the MS/TP state machines,
+   but does not start a thread to run them */
+bool dlmstp_open(
     void *poPort,
     char *ifname)
 {
-    unsigned long hThread = 0;
     int rv = 0;
     SHARED_MSTP_DATA *poSharedData;
     struct mstp_port_struct_t *mstp_port =
@@ -888,6 +932,7 @@ bool dlmstp_init(
     }
 
     poSharedData->RS485_Port_Name = ifname;
+    poSharedData->Send_Frame = NULL;
     /* initialize PDU queue */
     Ringbuf_Init(&poSharedData->PDU_Queue,
         (uint8_t *) & poSharedData->PDU_Buffer, sizeof(struct mstp_pdu_packet),
@@ -908,6 +953,13 @@ bool dlmstp_init(
             "MS/TP Interface: %s\n cannot allocate PThread Mutex.\n", ifname);
         exit(1);
     }
+    if (pipe(poSharedData->Receive_Packet_Pipe) == 0) {
+        fcntl(poSharedData->Receive_Packet_Pipe[0], F_SETFL, O_NONBLOCK);
+        fcntl(poSharedData->Receive_Packet_Pipe[1], F_SETFL, O_NONBLOCK);
+    } else {
+        poSharedData->Receive_Packet_Pipe[0] = -1;
+        poSharedData->Receive_Packet_Pipe[1] = -1;
+    }
 
     struct termios newtio;
     printf("RS485: Initializing %s", poSharedData->RS485_Port_Name);
@@ -961,7 +1013,7 @@ bool dlmstp_init(
     mstp_port->InputBufferSize = sizeof(poSharedData->RxBuffer);
     mstp_port->OutputBuffer = &poSharedData->TxBuffer[0];
     mstp_port->OutputBufferSize = sizeof(poSharedData->TxBuffer);
-    gettimeofday(&poSharedData->start, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &poSharedData->start);
     mstp_port->SilenceTimer = Timer_Silence;
     mstp_port->SilenceTimerReset = Timer_Silence_Reset;
     MSTP_Init(mstp_port);
@@ -972,7 +1024,20 @@ bool dlmstp_init(
         mstp_port->Nmax_info_frames);
 #endif
 
-    rv = pthread_create(&hThread, NULL, dlmstp_master_fsm_task, mstp_port);
+    return true;
+}
+
+bool dlmstp_init(
+    void *poPort,
+    char *ifname)
+{
+    pthread_t hThread;
+    int rv = 0;
+
+    if (!dlmstp_open(poPort, ifname)) {
+        return false;
+    }
+    rv = pthread_create(&hThread, NULL, dlmstp_master_fsm_task, poPort);
     if (rv != 0) {
         fprintf(stderr, "Failed to start Master Node FSM task\n");
     }
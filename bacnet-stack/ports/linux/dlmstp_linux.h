@@ -34,6 +34,7 @@
 #include "bacdef.h"
 #include "npdu.h"
 #include <termios.h>
+#include <time.h>
 #include "fifo.h"
 #include "ringbuf.h"
 /* defines specific to MS/TP */
@@ -75,6 +76,8 @@ typedef struct shared_mstp_data {
      */
     pthread_cond_t Receive_Packet_Flag;
     pthread_mutex_t Receive_Packet_Mutex;
+    /* pipe that is readable while a packet is ready, for poll or epoll */
+    int Receive_Packet_Pipe[2];
     /* mechanism to wait for a frame in state machine */
     /*
        RT_COND Received_Frame_Flag;
@@ -116,7 +119,15 @@ typedef struct shared_mstp_data {
     FIFO_BUFFER Rx_FIFO;
     /* buffer size needs to be a power of 2 */
     uint8_t Rx_Buffer[4096];
-    struct timeval start;
+    /* CLOCK_MONOTONIC time of the last silence timer reset */
+    struct timespec start;
+    /* when set, RS485_Send_Frame hands the frame to this function instead
+       of writing it and waiting for it to leave the UART */
+    void (
+        *Send_Frame) (
+        void *poPort,
+        uint8_t * buffer,
+        uint16_t nbytes);
 
     RING_BUFFER PDU_Queue;
 
@@ -131,6 +142,10 @@ extern "C" {
     bool dlmstp_init(
         void *poShared,
         char *ifname);
+    /* like dlmstp_init, but the caller runs the state machines */
+    bool dlmstp_open(
+        void *poShared,
+        char *ifname);
     void dlmstp_reset(
         void *poShared);
     void dlmstp_cleanup(
@@ -151,6 +166,10 @@ extern "C" {
         uint16_t max_pdu,       /* amount of space available in the PDU  */
         unsigned timeout);      /* milliseconds to wait for a packet */
 
+    /* file descriptor that becomes readable when dlmstp_receive has a packet */
+    int dlmstp_receive_fd(
+        void *poShared);
+
     /* This parameter represents the value of the Max_Info_Frames property of */
     /* the node's Device object. The value of Max_Info_Frames specifies the */
     /* maximum number of information frames the node may send before it must */
@@ -60,6 +60,12 @@ bool ethernet_valid(
     return (eth802_sockfd >= 0);
 }
 
+int ethernet_socket(
+    void)
+{
+    return eth802_sockfd;
+}
+
 void ethernet_cleanup(
     void)
 {
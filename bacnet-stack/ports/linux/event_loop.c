@@ -0,0 +1,383 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "event_loop.h"
+#if defined(BACDL_ALL)
+#include "bip.h"
+#include "bvlc.h"
+#include "ethernet.h"
+#include "dlmstp.h"
+#endif
+#include "datalink.h"
+
+/** @file linux/event_loop.c  Waits on the datalinks and timers with epoll. */
+
+/* one file descriptor or timer that is watched */
+struct event_source {
+    bool valid;
+    bool timer;
+    int fd;
+    uint32_t interval;
+    event_loop_fd_handler fd_handler;
+    event_loop_timer_handler timer_handler;
+    void *context;
+};
+
+static struct event_source Event_Sources[EVENT_LOOP_MAX_SOURCES];
+static int Epoll_FD = -1;
+static volatile bool Event_Loop_Running;
+
+/* the epoll data holds the fd and the index, so that an event for a
+   source that was removed while dispatching is not given to a new one */
+static uint64_t event_loop_key(
+    int fd,
+    unsigned index)
+{
+    return ((uint64_t) (uint32_t) fd << 32) | index;
+}
+
+static int event_loop_source_add(
+    int fd,
+    bool timer)
+{
+    struct epoll_event event;
+    unsigned i = 0;
+
+    if ((Epoll_FD < 0) || (fd < 0)) {
+        return -1;
+    }
+    for (i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        if (!Event_Sources[i].valid) {
+            break;
+        }
+    }
+    if (i >= EVENT_LOOP_MAX_SOURCES) {
+        return -1;
+    }
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = event_loop_key(fd, i);
+    if (epoll_ctl(Epoll_FD, EPOLL_CTL_ADD, fd, &event) < 0) {
+        return -1;
+    }
+    memset(&Event_Sources[i], 0, sizeof(Event_Sources[i]));
+    Event_Sources[i].valid = true;
+    Event_Sources[i].timer = timer;
+    Event_Sources[i].fd = fd;
+
+    return (int) i;
+}
+
+static struct event_source *event_loop_source_find(
+    int fd,
+    bool timer)
+{
+    unsigned i = 0;
+
+    for (i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        if (Event_Sources[i].valid && (Event_Sources[i].fd == fd) &&
+            (Event_Sources[i].timer == timer)) {
+            return &Event_Sources[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void event_loop_source_remove(
+    struct event_source *source)
+{
+    epoll_ctl(Epoll_FD, EPOLL_CTL_DEL, source->fd, NULL);
+    if (source->timer) {
+        close(source->fd);
+    }
+    source->valid = false;
+}
+
+/** Creates the event loop.
+ * @return true if the epoll instance was created.
+ */
+bool event_loop_init(
+    void)
+{
+    if (Epoll_FD >= 0) {
+        event_loop_cleanup();
+    }
+    memset(Event_Sources, 0, sizeof(Event_Sources));
+    Epoll_FD = epoll_create1(EPOLL_CLOEXEC);
+    if (Epoll_FD < 0) {
+        fprintf(stderr, "event loop: epoll_create1: %s\n", strerror(errno));
+        return false;
+    }
+
+    return true;
+}
+
+/** Removes all sources, closes the timers and the epoll instance.
+ *  The file descriptors added with event_loop_add_fd stay open.
+ */
+void event_loop_cleanup(
+    void)
+{
+    unsigned i = 0;
+
+    if (Epoll_FD < 0) {
+        return;
+    }
+    for (i = 0; i < EVENT_LOOP_MAX_SOURCES; i++) {
+        if (Event_Sources[i].valid) {
+            event_loop_source_remove(&Event_Sources[i]);
+        }
+    }
+    close(Epoll_FD);
+    Epoll_FD = -1;
+}
+
+/** Calls a handler each time a file descriptor has data to read.
+ *  The handler must read the data, else it is called again.
+ * @param fd [in] socket, pipe or device to watch
+ * @param pFunction [in] handler called with the fd and the context
+ * @param context [in] passed to the handler
+ * @return true if the file descriptor was added
+ */
+bool event_loop_add_fd(
+    int fd,
+    event_loop_fd_handler pFunction,
+    void *context)
+{
+    int index = 0;
+
+    if (!pFunction) {
+        return false;
+    }
+    index = event_loop_source_add(fd, false);
+    if (index < 0) {
+        return false;
+    }
+    Event_Sources[index].fd_handler = pFunction;
+    Event_Sources[index].context = context;
+
+    return true;
+}
+
+/** Stops watching a file descriptor, but does not close it.
+ * @param fd [in] the file descriptor given to event_loop_add_fd
+ * @return true if it was found and removed
+ */
+bool event_loop_remove_fd(
+    int fd)
+{
+    struct event_source *source = event_loop_source_find(fd, false);
+
+    if (source) {
+        event_loop_source_remove(source);
+        return true;
+    }
+
+    return false;
+}
+
+/** Calls a handler periodically from a timerfd.
+ *  Expirations missed while the loop was busy are added together, so
+ *  the handler gets the real elapsed time.
+ * @param interval_milliseconds [in] period of the timer
+ * @param pFunction [in] handler called with the elapsed time
+ * @param context [in] passed to the handler
+ * @return the timer handle, or -1 on failure
+ */
+int event_loop_add_timer(
+    uint32_t interval_milliseconds,
+    event_loop_timer_handler pFunction,
+    void *context)
+{
+    struct itimerspec spec;
+    int fd = -1;
+    int index = 0;
+
+    if (!pFunction || (interval_milliseconds == 0) || (Epoll_FD < 0)) {
+        return -1;
+    }
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "event loop: timerfd_create: %s\n", strerror(errno));
+        return -1;
+    }
+    spec.it_interval.tv_sec = interval_milliseconds / 1000;
+    spec.it_interval.tv_nsec = (interval_milliseconds % 1000) * 1000000L;
+    spec.it_value = spec.it_interval;
+    if (timerfd_settime(fd, 0, &spec, NULL) < 0) {
+        close(fd);
+        return -1;
+    }
+    index = event_loop_source_add(fd, true);
+    if (index < 0) {
+        close(fd);
+        return -1;
+    }
+    Event_Sources[index].interval = interval_milliseconds;
+    Event_Sources[index].timer_handler = pFunction;
+    Event_Sources[index].context = context;
+
+    return fd;
+}
+
+/** Stops and closes a timer.
+ * @param timer [in] the handle from event_loop_add_timer
+ * @return true if it was found and removed
+ */
+bool event_loop_remove_timer(
+    int timer)
+{
+    struct event_source *source = event_loop_source_find(timer, true);
+
+    if (source) {
+        event_loop_source_remove(source);
+        return true;
+    }
+
+    return false;
+}
+
+static void event_loop_timer_dispatch(
+    struct event_source *source)
+{
+    uint64_t expirations = 0;
+    uint64_t elapsed = 0;
+
+    if (read(source->fd, &expirations, sizeof(expirations)) !=
+        sizeof(expirations)) {
+        return;
+    }
+    elapsed = expirations * source->interval;
+    if (elapsed > UINT32_MAX) {
+        elapsed = UINT32_MAX;
+    }
+    source->timer_handler((uint32_t) elapsed, source->context);
+}
+
+/** Waits for one batch of events and calls their handlers.
+ * @param timeout_milliseconds [in] how long to wait, or -1 for no limit
+ * @return number of handlers called, or -1 on error
+ */
+int event_loop_run_once(
+    int timeout_milliseconds)
+{
+    struct epoll_event events[EVENT_LOOP_MAX_SOURCES];
+    struct event_source *source = NULL;
+    unsigned index = 0;
+    int fd = 0;
+    int count = 0;
+    int dispatched = 0;
+    int i = 0;
+
+    if (Epoll_FD < 0) {
+        return -1;
+    }
+    count =
+        epoll_wait(Epoll_FD, events, EVENT_LOOP_MAX_SOURCES,
+        timeout_milliseconds);
+    if (count < 0) {
+        return (errno == EINTR) ? 0 : -1;
+    }
+    for (i = 0; i < count; i++) {
+        index = (unsigned) (events[i].data.u64 & 0xFFFFFFFF);
+        fd = (int) (events[i].data.u64 >> 32);
+        if (index >= EVENT_LOOP_MAX_SOURCES) {
+            continue;
+        }
+        source = &Event_Sources[index];
+        if (!source->valid || (source->fd != fd)) {
+            /* removed by an earlier handler */
+            continue;
+        }
+        if (source->timer) {
+            event_loop_timer_dispatch(source);
+        } else {
+            source->fd_handler(fd, source->context);
+        }
+        dispatched++;
+    }
+
+    return dispatched;
+}
+
+/** Dispatches events until event_loop_stop is called or an error occurs.
+ */
+void event_loop_run(
+    void)
+{
+    Event_Loop_Running = true;
+    while (Event_Loop_Running) {
+        if (event_loop_run_once(-1) < 0) {
+            break;
+        }
+    }
+}
+
+/** Makes event_loop_run return after the current events.
+ *  Safe to call from a handler or a signal handler.
+ */
+void event_loop_stop(
+    void)
+{
+    Event_Loop_Running = false;
+}
+
+/** Gets the file descriptor that becomes readable when the datalink
+ *  chosen at build time (or with datalink_set) has a packet.
+ *  For MS/TP it is the pipe written by the receive thread.
+ * @return the file descriptor, or -1 if the datalink cannot be watched
+ */
+int event_loop_datalink_fd(
+    void)
+{
+#if defined(BACDL_ALL)
+    if ((datalink_receive == bip_receive) ||
+        (datalink_receive == bvlc_receive)) {
+        return bip_socket();
+    } else if (datalink_receive == ethernet_receive) {
+        return ethernet_socket();
+    } else if (datalink_receive == dlmstp_receive) {
+        return dlmstp_receive_fd();
+    }
+    return -1;
+#elif defined(BACDL_BIP)
+    return bip_socket();
+#elif defined(BACDL_BIP6)
+    return bip6_socket();
+#elif defined(BACDL_ETHERNET)
+    return ethernet_socket();
+#elif defined(BACDL_MSTP)
+    return dlmstp_receive_fd();
+#else
+    return -1;
+#endif
+}
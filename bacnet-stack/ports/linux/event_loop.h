@@ -0,0 +1,83 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* number of file descriptors and timers that can be watched at once */
+#ifndef EVENT_LOOP_MAX_SOURCES
+#define EVENT_LOOP_MAX_SOURCES 16
+#endif
+
+/* called when the file descriptor is readable */
+typedef void (
+    *event_loop_fd_handler) (
+    int fd,
+    void *context);
+
+/* called when the timer expires, with the milliseconds since last called */
+typedef void (
+    *event_loop_timer_handler) (
+    uint32_t elapsed_milliseconds,
+    void *context);
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    bool event_loop_init(
+        void);
+    void event_loop_cleanup(
+        void);
+
+    bool event_loop_add_fd(
+        int fd,
+        event_loop_fd_handler pFunction,
+        void *context);
+    bool event_loop_remove_fd(
+        int fd);
+
+    int event_loop_add_timer(
+        uint32_t interval_milliseconds,
+        event_loop_timer_handler pFunction,
+        void *context);
+    bool event_loop_remove_timer(
+        int timer);
+
+    int event_loop_run_once(
+        int timeout_milliseconds);
+    void event_loop_run(
+        void);
+    void event_loop_stop(
+        void);
+
+    int event_loop_datalink_fd(
+        void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -0,0 +1,1131 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/timerfd.h>
+#include "mstp.h"
+#include "fifo.h"
+#include "dlmstp_linux.h"
+#include "rs485.h"
+#include "mstp_engine.h"
+
+/** @file linux/mstp_engine.c  Runs the MS/TP state machines of several
+ *  ports from one thread, woken by epoll on the ttys and by a timerfd
+ *  at the next silence timeout of each port.  Frames are written without
+ *  blocking, and the state machines of a port wait until its frames have
+ *  left the UART, so that one slow port does not hold up the others. */
+
+/* same defaults as src/mstp.c */
+#ifndef Tframe_abort
+#define Tframe_abort 95
+#endif
+#ifndef Treply_timeout
+#define Treply_timeout 295
+#endif
+#ifndef Tusage_timeout
+#define Tusage_timeout 95
+#endif
+
+/* octets read from the tty at once */
+#ifndef MSTP_ENGINE_READ_SIZE
+#define MSTP_ENGINE_READ_SIZE 2048
+#endif
+
+/* states that wait for the application, rather than for the silence
+   timer, are polled this often, in milliseconds */
+#ifndef MSTP_ENGINE_POLL_MS
+#define MSTP_ENGINE_POLL_MS 1
+#endif
+
+/* octets of frames waiting to be written to the tty - the state machines
+   can send a frame and then pass the token in one go */
+#ifndef MSTP_ENGINE_WRITE_SIZE
+#define MSTP_ENGINE_WRITE_SIZE 2048
+#endif
+
+struct mstp_engine_port {
+    bool valid;
+    /* the tty is in the epoll set */
+    bool reading;
+    /* ... and is watched for EPOLLOUT too */
+    bool writing;
+    /* from queueing a frame until its last octet has left the UART */
+    bool sending;
+    uint8_t tx_buffer[MSTP_ENGINE_WRITE_SIZE];
+    unsigned tx_head;
+    unsigned tx_count;
+    /* when the turnaround time ends, or the output may have drained */
+    struct timespec tx_deadline;
+    volatile struct mstp_port_struct_t *mstp_port;
+    SHARED_MSTP_DATA *shared;
+    int timer_fd;
+    /* when the timer was set to expire */
+    struct timespec deadline;
+    /* microseconds, for the statistics */
+    uint64_t token_time;
+    uint64_t reply_time;
+    MSTP_ENGINE_STATS stats;
+};
+
+static struct mstp_engine_port Engine_Ports[MSTP_ENGINE_MAX_PORTS];
+/* held by the engine thread while it runs the state machines */
+static pthread_mutex_t Engine_Mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t Engine_Thread;
+static volatile bool Engine_Running;
+static int Epoll_FD = -1;
+/* eventfd that wakes the engine thread to stop */
+static int Wakeup_FD = -1;
+
+/* the epoll data holds the fd and the port index, so that an event for
+   a port that was removed is not given to a new one */
+static uint64_t mstp_engine_key(
+    int fd,
+    unsigned index)
+{
+    return ((uint64_t) (uint32_t) fd << 32) | index;
+}
+
+static uint64_t mstp_engine_usec(
+    const struct timespec *t)
+{
+    return ((uint64_t) t->tv_sec * 1000000ULL) + (t->tv_nsec / 1000);
+}
+
+static void mstp_engine_timespec_add_usec(
+    struct timespec *t,
+    uint64_t usec)
+{
+    t->tv_sec += (time_t) (usec / 1000000ULL);
+    t->tv_nsec += (long) (usec % 1000000ULL) * 1000L;
+    if (t->tv_nsec >= 1000000000L) {
+        t->tv_sec++;
+        t->tv_nsec -= 1000000000L;
+    }
+}
+
+static void mstp_engine_timespec_add(
+    struct timespec *t,
+    uint32_t milliseconds)
+{
+    mstp_engine_timespec_add_usec(t, (uint64_t) milliseconds * 1000ULL);
+}
+
+/* microseconds to send some bits on the port, at least one */
+static uint64_t mstp_engine_bit_usec(
+    struct mstp_engine_port *port,
+    uint64_t bits)
+{
+    uint32_t baud = RS485_Get_Port_Baud_Rate(port->mstp_port);
+    uint64_t usec = 1;
+
+    if (baud) {
+        usec = ((bits * 1000000ULL) + baud - 1) / baud;
+    }
+
+    return usec ? usec : 1;
+}
+
+static void mstp_engine_sample(
+    uint32_t * count,
+    uint32_t * min,
+    uint32_t * max,
+    uint64_t * total,
+    uint64_t value)
+{
+    if (value > UINT32_MAX) {
+        value = UINT32_MAX;
+    }
+    if ((*count == 0) || (value < *min)) {
+        *min = (uint32_t) value;
+    }
+    if (value > *max) {
+        *max = (uint32_t) value;
+    }
+    *total += value;
+    (*count)++;
+}
+
+static bool mstp_engine_frame_pending(
+    volatile struct mstp_port_struct_t *mstp_port)
+{
+    return mstp_port->ReceivedValidFrame || mstp_port->ReceivedInvalidFrame;
+}
+
+/* milliseconds after the last silence timer reset that the state machines
+   need to run again, or zero if they are waiting for the application */
+static uint32_t mstp_engine_timeout(
+    volatile struct mstp_port_struct_t *mstp_port)
+{
+    uint32_t timeout = Tno_token;
+
+    if (mstp_port->This_Station <= DEFAULT_MAX_MASTER) {
+        switch (mstp_port->master_state) {
+            case MSTP_MASTER_STATE_IDLE:
+                timeout = Tno_token;
+                break;
+            case MSTP_MASTER_STATE_WAIT_FOR_REPLY:
+                timeout = Treply_timeout;
+                break;
+            case MSTP_MASTER_STATE_PASS_TOKEN:
+            case MSTP_MASTER_STATE_POLL_FOR_MASTER:
+                timeout = Tusage_timeout;
+                break;
+            case MSTP_MASTER_STATE_NO_TOKEN:
+                timeout = Tno_token + (Tslot * mstp_port->This_Station);
+                break;
+            default:
+                /* ANSWER_DATA_REQUEST waits for a reply to be queued */
+                timeout = 0;
+                break;
+        }
+    } else if (mstp_port->ReceivedValidFrame) {
+        /* the slave is waiting for a reply to be queued */
+        timeout = 0;
+    }
+    if (timeout && (mstp_port->receive_state != MSTP_RECEIVE_STATE_IDLE) &&
+        (Tframe_abort < timeout)) {
+        timeout = Tframe_abort;
+    }
+
+    return timeout;
+}
+
+static void mstp_engine_port_arm(
+    struct mstp_engine_port *port)
+{
+    struct itimerspec spec;
+    struct timespec now;
+    uint32_t timeout = mstp_engine_timeout(port->mstp_port);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (port->sending) {
+        /* the state machines wait for the frames to be sent */
+        port->deadline = port->tx_deadline;
+    } else if (timeout) {
+        /* the state machines compare whole milliseconds, some with > */
+        port->deadline = port->shared->start;
+        mstp_engine_timespec_add(&port->deadline, timeout + 1);
+    }
+    if ((!port->sending && !timeout) ||
+        (mstp_engine_usec(&port->deadline) <= mstp_engine_usec(&now))) {
+        port->deadline = now;
+        mstp_engine_timespec_add(&port->deadline, MSTP_ENGINE_POLL_MS);
+    }
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value = port->deadline;
+    timerfd_settime(port->timer_fd, TFD_TIMER_ABSTIME, &spec, NULL);
+}
+
+static void mstp_engine_timer(
+    struct mstp_engine_port *port,
+    const struct timespec *now)
+{
+    uint64_t expirations = 0;
+    uint64_t deadline = 0;
+    uint64_t late = 0;
+
+    if (read(port->timer_fd, &expirations, sizeof(expirations)) !=
+        sizeof(expirations)) {
+        return;
+    }
+    port->stats.wakeups++;
+    deadline = mstp_engine_usec(&port->deadline);
+    if (mstp_engine_usec(now) > deadline) {
+        late = mstp_engine_usec(now) - deadline;
+        if (late > MSTP_ENGINE_LATE_USEC) {
+            port->stats.late_wakeups++;
+        }
+        if (late > port->stats.wakeup_late_max) {
+            port->stats.wakeup_late_max =
+                (late > UINT32_MAX) ? UINT32_MAX : (uint32_t) late;
+        }
+    }
+}
+
+static void mstp_engine_read(
+    struct mstp_engine_port *port)
+{
+    uint8_t buffer[MSTP_ENGINE_READ_SIZE];
+    FIFO_BUFFER *fifo = &port->shared->Rx_FIFO;
+    unsigned space = sizeof(port->shared->Rx_Buffer) - FIFO_Count(fifo);
+    ssize_t count = 0;
+
+    count = read(port->shared->RS485_Handle, buffer, sizeof(buffer));
+    if (count > 0) {
+        if ((unsigned) count > space) {
+            port->stats.receive_overruns += (unsigned) count - space;
+            count = space;
+        }
+        FIFO_Add(fifo, buffer, (unsigned) count);
+    } else if ((count == 0) || ((errno != EAGAIN) && (errno != EINTR))) {
+        /* hangup or error: stop watching, else epoll keeps waking us */
+        fprintf(stderr, "MS/TP engine: %s: %s\n",
+            port->shared->RS485_Port_Name,
+            (count == 0) ? "hangup" : strerror(errno));
+        epoll_ctl(Epoll_FD, EPOLL_CTL_DEL, port->shared->RS485_Handle, NULL);
+        port->reading = false;
+    }
+}
+
+/* feed the received octets to the receive state machine, one at a time,
+   until a frame is complete */
+static void mstp_engine_receive(
+    struct mstp_engine_port *port)
+{
+    volatile struct mstp_port_struct_t *mstp_port = port->mstp_port;
+    FIFO_BUFFER *fifo = &port->shared->Rx_FIFO;
+
+    if (mstp_engine_frame_pending(mstp_port)) {
+        return;
+    }
+    while (!FIFO_Empty(fifo)) {
+        mstp_port->DataRegister = FIFO_Get(fifo);
+        mstp_port->DataAvailable = true;
+        do {
+            MSTP_Receive_Frame_FSM(mstp_port);
+        } while (mstp_port->DataAvailable);
+        if (mstp_engine_frame_pending(mstp_port)) {
+            break;
+        }
+    }
+    if (!mstp_engine_frame_pending(mstp_port)) {
+        /* Tframe_abort */
+        MSTP_Receive_Frame_FSM(mstp_port);
+    }
+    if (mstp_port->ReceivedValidFrame) {
+        port->stats.valid_frames++;
+    } else if (mstp_port->ReceivedInvalidFrame) {
+        port->stats.invalid_frames++;
+    }
+}
+
+static void mstp_engine_master(
+    struct mstp_engine_port *port)
+{
+    volatile struct mstp_port_struct_t *mstp_port = port->mstp_port;
+    MSTP_MASTER_STATE state = mstp_port->master_state;
+    bool valid = mstp_port->ReceivedValidFrame;
+    bool invalid = mstp_port->ReceivedInvalidFrame;
+    bool for_us = valid &&
+        (mstp_port->DestinationAddress == mstp_port->This_Station);
+    struct timespec now;
+    uint64_t usec = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    usec = mstp_engine_usec(&now);
+    /* a token can arrive in PASS_TOKEN or NO_TOKEN, which go to IDLE
+       and then use it */
+    if (for_us && (state != MSTP_MASTER_STATE_WAIT_FOR_REPLY) &&
+        (mstp_port->FrameType == FRAME_TYPE_TOKEN)) {
+        port->stats.tokens++;
+        if (port->token_time) {
+            mstp_engine_sample(&port->stats.token_rotations,
+                &port->stats.token_rotation_min,
+                &port->stats.token_rotation_max,
+                &port->stats.token_rotation_total, usec - port->token_time);
+        }
+        port->token_time = usec;
+    } else if (for_us && (state == MSTP_MASTER_STATE_WAIT_FOR_REPLY)) {
+        mstp_engine_sample(&port->stats.replies,
+            &port->stats.reply_latency_min, &port->stats.reply_latency_max,
+            &port->stats.reply_latency_total, usec - port->reply_time);
+    }
+    if (mstp_port->This_Station <= DEFAULT_MAX_MASTER) {
+        while (MSTP_Master_Node_FSM(mstp_port)) {
+            /* do nothing while immediate transitioning */
+        }
+    } else if (mstp_port->This_Station < 255) {
+        MSTP_Slave_Node_FSM(mstp_port);
+    }
+    if ((state == MSTP_MASTER_STATE_WAIT_FOR_REPLY) && !valid && !invalid &&
+        (mstp_port->master_state != MSTP_MASTER_STATE_WAIT_FOR_REPLY)) {
+        port->stats.reply_timeouts++;
+    }
+    if ((mstp_port->master_state == MSTP_MASTER_STATE_WAIT_FOR_REPLY) &&
+        ((state != MSTP_MASTER_STATE_WAIT_FOR_REPLY) || valid || invalid)) {
+        /* a Data-Expecting-Reply frame was just sent */
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        port->reply_time = mstp_engine_usec(&now);
+    }
+}
+
+static struct mstp_engine_port *mstp_engine_port_find(
+    void *poPort)
+{
+    unsigned i = 0;
+
+    for (i = 0; i < MSTP_ENGINE_MAX_PORTS; i++) {
+        if (Engine_Ports[i].valid && (Engine_Ports[i].mstp_port == poPort)) {
+            return &Engine_Ports[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* RS485_Send_Frame of a port in the engine: the state machines run in
+   the engine thread, so this only queues the frame */
+static void mstp_engine_send_frame(
+    void *poPort,
+    uint8_t * buffer,
+    uint16_t nbytes)
+{
+    struct mstp_engine_port *port = mstp_engine_port_find(poPort);
+
+    if (!port) {
+        return;
+    }
+    if (nbytes > (sizeof(port->tx_buffer) - port->tx_head - port->tx_count)) {
+        port->stats.transmit_overruns++;
+        return;
+    }
+    memcpy(&port->tx_buffer[port->tx_head + port->tx_count], buffer, nbytes);
+    port->tx_count += nbytes;
+    if (!port->sending) {
+        /* give the other nodes Tturnaround to stop sending */
+        port->sending = true;
+        port->tx_deadline = port->shared->start;
+        mstp_engine_timespec_add_usec(&port->tx_deadline,
+            mstp_engine_bit_usec(port, Tturnaround));
+    }
+}
+
+static void mstp_engine_writing(
+    struct mstp_engine_port *port,
+    bool writing)
+{
+    struct epoll_event event;
+
+    if (!port->reading || (port->writing == writing)) {
+        return;
+    }
+    memset(&event, 0, sizeof(event));
+    event.events = writing ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.u64 =
+        mstp_engine_key(port->shared->RS485_Handle,
+        (unsigned) (port - Engine_Ports));
+    epoll_ctl(Epoll_FD, EPOLL_CTL_MOD, port->shared->RS485_Handle, &event);
+    port->writing = writing;
+}
+
+/* octets that the driver has not sent yet, including any in the UART
+   shift register, if the driver tells us */
+static unsigned mstp_engine_output_queued(
+    struct mstp_engine_port *port)
+{
+    int queued = 0;
+    int lsr = 0;
+
+    if (ioctl(port->shared->RS485_Handle, TIOCOUTQ, &queued) < 0) {
+        queued = 0;
+    }
+    if ((queued == 0) &&
+        (ioctl(port->shared->RS485_Handle, TIOCSERGETLSR, &lsr) == 0) &&
+        !(lsr & TIOCSER_TEMT)) {
+        queued = 1;
+    }
+
+    return (queued > 0) ? (unsigned) queued : 0;
+}
+
+/* writes the queued frames without blocking.  Returns true while the port
+   is still sending, and the state machines must wait for it. */
+static bool mstp_engine_transmit(
+    struct mstp_engine_port *port)
+{
+    struct timespec now;
+    unsigned queued = 0;
+    ssize_t written = 0;
+
+    if (!port->sending) {
+        return false;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (mstp_engine_usec(&now) < mstp_engine_usec(&port->tx_deadline)) {
+        /* still in the turnaround time, or draining */
+        return true;
+    }
+    if (port->tx_count) {
+        written =
+            write(port->shared->RS485_Handle,
+            &port->tx_buffer[port->tx_head], port->tx_count);
+        if (written > 0) {
+            port->tx_head += (unsigned) written;
+            port->tx_count -= (unsigned) written;
+        } else if ((written < 0) && (errno != EAGAIN) && (errno != EINTR)) {
+            fprintf(stderr, "MS/TP engine: %s: write: %s\n",
+                port->shared->RS485_Port_Name, strerror(errno));
+            port->stats.transmit_overruns++;
+            port->tx_count = 0;
+        }
+        if (port->tx_count) {
+            /* the tty buffer is full: wait for EPOLLOUT */
+            mstp_engine_writing(port, true);
+            port->tx_deadline = now;
+            mstp_engine_timespec_add_usec(&port->tx_deadline,
+                mstp_engine_bit_usec(port, 10ULL * port->tx_count));
+            return true;
+        }
+        port->tx_head = 0;
+        mstp_engine_writing(port, false);
+    }
+    /* rather than tcdrain, check the output queue when it should be empty */
+    queued = mstp_engine_output_queued(port);
+    if (queued) {
+        port->tx_deadline = now;
+        mstp_engine_timespec_add_usec(&port->tx_deadline,
+            mstp_engine_bit_usec(port, 10ULL * queued));
+        return true;
+    }
+    port->sending = false;
+    port->stats.frames_sent++;
+    /* per MSTP spec, sort of */
+    port->mstp_port->SilenceTimerReset((void *) port->mstp_port);
+
+    return false;
+}
+
+static void mstp_engine_port_run(
+    struct mstp_engine_port *port)
+{
+    for (;;) {
+        if (mstp_engine_transmit(port)) {
+            break;
+        }
+        mstp_engine_receive(port);
+        mstp_engine_master(port);
+        if (port->sending) {
+            /* start sending what was just queued */
+            continue;
+        }
+        if (mstp_engine_frame_pending(port->mstp_port) ||
+            FIFO_Empty(&port->shared->Rx_FIFO)) {
+            break;
+        }
+    }
+    mstp_engine_port_arm(port);
+}
+
+static void *mstp_engine_task(
+    void *pArg)
+{
+    struct epoll_event events[(MSTP_ENGINE_MAX_PORTS * 2) + 1];
+    struct mstp_engine_port *port = NULL;
+    struct timespec now;
+    uint64_t value = 0;
+    unsigned index = 0;
+    int fd = 0;
+    int count = 0;
+    int i = 0;
+
+    (void) pArg;
+    while (Engine_Running) {
+        count =
+            epoll_wait(Epoll_FD, events,
+            sizeof(events) / sizeof(events[0]), -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            fprintf(stderr, "MS/TP engine: epoll_wait: %s\n",
+                strerror(errno));
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        pthread_mutex_lock(&Engine_Mutex);
+        for (i = 0; i < count; i++) {
+            index = (unsigned) (events[i].data.u64 & 0xFFFFFFFF);
+            fd = (int) (events[i].data.u64 >> 32);
+            if (index >= MSTP_ENGINE_MAX_PORTS) {
+                if (read(Wakeup_FD, &value, sizeof(value)) < 0) {
+                    /* already drained */
+                }
+                continue;
+            }
+            port = &Engine_Ports[index];
+            if (!port->valid) {
+                /* removed since epoll_wait returned */
+                continue;
+            }
+            if (fd == port->timer_fd) {
+                mstp_engine_timer(port, &now);
+            } else if (port->reading && (fd == port->shared->RS485_Handle)) {
+                if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                    mstp_engine_read(port);
+                }
+                /* on EPOLLOUT, the port run writes the rest of a frame */
+            } else {
+                continue;
+            }
+            mstp_engine_port_run(port);
+        }
+        pthread_mutex_unlock(&Engine_Mutex);
+    }
+
+    return NULL;
+}
+
+/** Creates the engine.  Ports can be added before or after it starts.
+ * @return true if the epoll instance was created.
+ */
+bool mstp_engine_init(
+    void)
+{
+    struct epoll_event event;
+
+    if (Epoll_FD >= 0) {
+        mstp_engine_cleanup();
+    }
+    memset(Engine_Ports, 0, sizeof(Engine_Ports));
+    Epoll_FD = epoll_create1(EPOLL_CLOEXEC);
+    if (Epoll_FD < 0) {
+        fprintf(stderr, "MS/TP engine: epoll_create1: %s\n", strerror(errno));
+        return false;
+    }
+    Wakeup_FD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (Wakeup_FD < 0) {
+        fprintf(stderr, "MS/TP engine: eventfd: %s\n", strerror(errno));
+        close(Epoll_FD);
+        Epoll_FD = -1;
+        return false;
+    }
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = mstp_engine_key(Wakeup_FD, MSTP_ENGINE_MAX_PORTS);
+    epoll_ctl(Epoll_FD, EPOLL_CTL_ADD, Wakeup_FD, &event);
+
+    return true;
+}
+
+/** Stops the engine thread and removes all the ports.
+ *  The ports stay open; close them with dlmstp_cleanup.
+ */
+void mstp_engine_cleanup(
+    void)
+{
+    unsigned i = 0;
+
+    if (Epoll_FD < 0) {
+        return;
+    }
+    mstp_engine_stop();
+    for (i = 0; i < MSTP_ENGINE_MAX_PORTS; i++) {
+        if (Engine_Ports[i].valid) {
+            mstp_engine_remove_port((void *) Engine_Ports[i].mstp_port);
+        }
+    }
+    close(Wakeup_FD);
+    Wakeup_FD = -1;
+    close(Epoll_FD);
+    Epoll_FD = -1;
+}
+
+/** Starts the thread that runs the state machines of all the ports.
+ * @param priority [in] SCHED_FIFO priority, or 0 for the default policy.
+ *  If the process may not use SCHED_FIFO, the default policy is used.
+ * @return true if the thread was started
+ */
+bool mstp_engine_start(
+    int priority)
+{
+    pthread_attr_t attr;
+    struct sched_param param;
+    int rv = 0;
+
+    if ((Epoll_FD < 0) || Engine_Running) {
+        return false;
+    }
+    Engine_Running = true;
+    pthread_attr_init(&attr);
+    if (priority > 0) {
+        if (priority > sched_get_priority_max(SCHED_FIFO)) {
+            priority = sched_get_priority_max(SCHED_FIFO);
+        }
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = priority;
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+        pthread_attr_setschedparam(&attr, &param);
+        /* a page fault would delay the thread as much as a busy CPU */
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0) {
+            fprintf(stderr, "MS/TP engine: mlockall: %s\n", strerror(errno));
+        }
+    }
+    rv = pthread_create(&Engine_Thread, &attr, mstp_engine_task, NULL);
+    if ((rv == EPERM) && (priority > 0)) {
+        fprintf(stderr,
+            "MS/TP engine: SCHED_FIFO not permitted, "
+            "using the default policy\n");
+        rv = pthread_create(&Engine_Thread, NULL, mstp_engine_task, NULL);
+    }
+    pthread_attr_destroy(&attr);
+    if (rv != 0) {
+        fprintf(stderr, "MS/TP engine: pthread_create: %s\n", strerror(rv));
+        Engine_Running = false;
+        return false;
+    }
+
+    return true;
+}
+
+/** Stops the engine thread and waits for it to finish. */
+void mstp_engine_stop(
+    void)
+{
+    uint64_t value = 1;
+
+    if (!Engine_Running) {
+        return;
+    }
+    Engine_Running = false;
+    if (write(Wakeup_FD, &value, sizeof(value)) < 0) {
+        /* the counter is already set */
+    }
+    pthread_join(Engine_Thread, NULL);
+}
+
+/** Opens an MS/TP port and runs its state machines in the engine thread.
+ *  Set up the port as for dlmstp_init, which this replaces.
+ * @param poPort [in] the mstp_port_struct_t, with its SHARED_MSTP_DATA
+ * @param ifname [in] serial port name, such as /dev/ttyS0
+ * @return true if the port was added
+ */
+bool mstp_engine_add_port(
+    void *poPort,
+    char *ifname)
+{
+    struct mstp_port_struct_t *mstp_port =
+        (struct mstp_port_struct_t *) poPort;
+    struct mstp_engine_port *port = NULL;
+    SHARED_MSTP_DATA *poSharedData = NULL;
+    struct epoll_event event;
+    unsigned i = 0;
+    int flags = 0;
+
+    if (!mstp_port || (Epoll_FD < 0)) {
+        return false;
+    }
+    poSharedData = (SHARED_MSTP_DATA *) mstp_port->UserData;
+    if (!poSharedData) {
+        return false;
+    }
+    /* reserve a slot, since opening the port takes a while */
+    pthread_mutex_lock(&Engine_Mutex);
+    for (i = 0; i < MSTP_ENGINE_MAX_PORTS; i++) {
+        if (!Engine_Ports[i].mstp_port) {
+            port = &Engine_Ports[i];
+            memset(port, 0, sizeof(*port));
+            port->mstp_port = mstp_port;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&Engine_Mutex);
+    if (!port) {
+        return false;
+    }
+    port->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK |
+        TFD_CLOEXEC);
+    if ((port->timer_fd < 0) || !dlmstp_open(poPort, ifname)) {
+        if (port->timer_fd >= 0) {
+            close(port->timer_fd);
+        }
+        pthread_mutex_lock(&Engine_Mutex);
+        memset(port, 0, sizeof(*port));
+        pthread_mutex_unlock(&Engine_Mutex);
+        return false;
+    }
+    flags = fcntl(poSharedData->RS485_Handle, F_GETFL);
+    fcntl(poSharedData->RS485_Handle, F_SETFL, flags | O_NONBLOCK);
+    pthread_mutex_lock(&Engine_Mutex);
+    port->shared = poSharedData;
+    port->valid = true;
+    port->reading = true;
+    poSharedData->Send_Frame = mstp_engine_send_frame;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.u64 = mstp_engine_key(poSharedData->RS485_Handle, i);
+    epoll_ctl(Epoll_FD, EPOLL_CTL_ADD, poSharedData->RS485_Handle, &event);
+    event.data.u64 = mstp_engine_key(port->timer_fd, i);
+    epoll_ctl(Epoll_FD, EPOLL_CTL_ADD, port->timer_fd, &event);
+    mstp_engine_port_arm(port);
+    pthread_mutex_unlock(&Engine_Mutex);
+
+    return true;
+}
+
+/** Stops running the state machines of a port, but does not close it.
+ * @param poPort [in] the port given to mstp_engine_add_port
+ * @return true if it was found and removed
+ */
+bool mstp_engine_remove_port(
+    void *poPort)
+{
+    struct mstp_engine_port *port = NULL;
+    unsigned i = 0;
+
+    pthread_mutex_lock(&Engine_Mutex);
+    for (i = 0; i < MSTP_ENGINE_MAX_PORTS; i++) {
+        if (Engine_Ports[i].valid && (Engine_Ports[i].mstp_port == poPort)) {
+            port = &Engine_Ports[i];
+            break;
+        }
+    }
+    if (port) {
+        if (port->reading) {
+            epoll_ctl(Epoll_FD, EPOLL_CTL_DEL, port->shared->RS485_Handle,
+                NULL);
+        }
+        epoll_ctl(Epoll_FD, EPOLL_CTL_DEL, port->timer_fd, NULL);
+        close(port->timer_fd);
+        port->shared->Send_Frame = NULL;
+        memset(port, 0, sizeof(*port));
+    }
+    pthread_mutex_unlock(&Engine_Mutex);
+
+    return (port != NULL);
+}
+
+/** Copies the timing statistics of a port.
+ * @param poPort [in] the port given to mstp_engine_add_port
+ * @param stats [out] the statistics
+ * @return true if the port was found
+ */
+bool mstp_engine_stats(
+    void *poPort,
+    MSTP_ENGINE_STATS * stats)
+{
+    bool status = false;
+    unsigned i = 0;
+
+    pthread_mutex_lock(&Engine_Mutex);
+    for (i = 0; i < MSTP_ENGINE_MAX_PORTS; i++) {
+        if (Engine_Ports[i].valid && (Engine_Ports[i].mstp_port == poPort)) {
+            if (stats) {
+                *stats = Engine_Ports[i].stats;
+            }
+            status = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&Engine_Mutex);
+
+    return status;
+}
+
+/** Clears the timing statistics of a port.
+ * @param poPort [in] the port given to mstp_engine_add_port
+ */
+void mstp_engine_stats_reset(
+    void *poPort)
+{
+    unsigned i = 0;
+
+    pthread_mutex_lock(&Engine_Mutex);
+    for (i = 0; i < MSTP_ENGINE_MAX_PORTS; i++) {
+        if (Engine_Ports[i].valid && (Engine_Ports[i].mstp_port == poPort)) {
+            memset(&Engine_Ports[i].stats, 0, sizeof(Engine_Ports[i].stats));
+            Engine_Ports[i].token_time = 0;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&Engine_Mutex);
+}
+
+#ifdef TEST_MSTP_ENGINE
+#include <poll.h>
+#include <stdlib.h>
+#include "npdu.h"
+
+/* MS/TP networks in the test, each with two nodes joined by ptys */
+#define TEST_NETWORKS 2
+#define TEST_NODES 2
+
+struct test_network {
+    /* pty master of each node, the wire side */
+    int wire[TEST_NODES];
+    char name[TEST_NODES][64];
+    struct mstp_port_struct_t mstp_port[TEST_NODES];
+    SHARED_MSTP_DATA shared[TEST_NODES];
+    pthread_t wire_thread;
+    pthread_t traffic_thread;
+};
+
+static struct test_network Test_Networks[TEST_NETWORKS];
+static volatile bool Test_Running;
+static volatile bool Load_Running;
+
+/* copies what one node sends to the other, like an RS-485 pair */
+static void *test_wire_task(
+    void *pArg)
+{
+    struct test_network *network = (struct test_network *) pArg;
+    struct pollfd fds[TEST_NODES];
+    uint8_t buffer[512];
+    ssize_t count = 0;
+    unsigned i = 0;
+
+    while (Test_Running) {
+        for (i = 0; i < TEST_NODES; i++) {
+            fds[i].fd = network->wire[i];
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        if (poll(fds, TEST_NODES, 100) <= 0) {
+            continue;
+        }
+        for (i = 0; i < TEST_NODES; i++) {
+            if (fds[i].revents & POLLIN) {
+                count = read(network->wire[i], buffer, sizeof(buffer));
+                if ((count > 0) &&
+                    (write(network->wire[(i + 1) % TEST_NODES], buffer,
+                            (size_t) count) != count)) {
+                    fprintf(stderr, "wire: short write\n");
+                }
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/* node 0 sends confirmed requests to node 1, which answers each one.
+   A reply can be postponed to the next token, so wait long enough. */
+#define TEST_REPLY_WAIT_MS 1000
+
+static void *test_traffic_task(
+    void *pArg)
+{
+    struct test_network *network = (struct test_network *) pArg;
+    BACNET_ADDRESS dest;
+    BACNET_ADDRESS src;
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t pdu[MAX_MPDU];
+    uint8_t rx_pdu[MAX_MPDU];
+    uint8_t invoke_id = 0;
+    uint16_t rx_len = 0;
+    int len = 0;
+
+    while (Test_Running) {
+        dlmstp_fill_bacnet_address(&dest,
+            network->mstp_port[1].This_Station);
+        npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+        len = npdu_encode_pdu(pdu, &dest, NULL, &npdu_data);
+        pdu[len++] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+        pdu[len++] = 0x05;
+        pdu[len++] = invoke_id;
+        pdu[len++] = SERVICE_CONFIRMED_READ_PROPERTY;
+        dlmstp_send_pdu(&network->mstp_port[0], &dest, pdu, (unsigned) len);
+        rx_len =
+            dlmstp_receive(&network->mstp_port[1], &src, rx_pdu,
+            sizeof(rx_pdu), TEST_REPLY_WAIT_MS);
+        if (rx_len >= 4) {
+            /* answer the request that arrived, which may be an old one */
+            npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+            len = npdu_encode_pdu(pdu, &src, NULL, &npdu_data);
+            pdu[len++] = PDU_TYPE_SIMPLE_ACK;
+            pdu[len++] = rx_pdu[rx_len - 2];
+            pdu[len++] = rx_pdu[rx_len - 1];
+            dlmstp_send_pdu(&network->mstp_port[1], &src, pdu,
+                (unsigned) len);
+        }
+        (void) dlmstp_receive(&network->mstp_port[0], NULL, rx_pdu,
+            sizeof(rx_pdu), TEST_REPLY_WAIT_MS);
+        invoke_id++;
+    }
+
+    return NULL;
+}
+
+/* keeps a CPU busy with memory traffic */
+static void *test_load_task(
+    void *pArg)
+{
+    size_t size = 1024 * 1024;
+    uint8_t *buffer = (uint8_t *) malloc(size);
+    unsigned value = 0;
+
+    (void) pArg;
+    while (Load_Running && buffer) {
+        memset(buffer, (int) value++, size);
+    }
+    free(buffer);
+
+    return NULL;
+}
+
+static double test_ms(
+    uint64_t usec)
+{
+    return (double) usec / 1000.0;
+}
+
+static void test_phase(
+    const char *phase,
+    unsigned seconds)
+{
+    MSTP_ENGINE_STATS stats;
+    struct test_network *network = NULL;
+    unsigned n = 0;
+    unsigned i = 0;
+
+    for (n = 0; n < TEST_NETWORKS; n++) {
+        for (i = 0; i < TEST_NODES; i++) {
+            mstp_engine_stats_reset(&Test_Networks[n].mstp_port[i]);
+        }
+    }
+    sleep(seconds);
+    for (n = 0; n < TEST_NETWORKS; n++) {
+        network = &Test_Networks[n];
+        for (i = 0; i < TEST_NODES; i++) {
+            if (!mstp_engine_stats(&network->mstp_port[i], &stats)) {
+                continue;
+            }
+            printf("%-7s %-11s %3u %6u %6.2f %6.2f %7.2f %6u %6.2f %6.2f "
+                "%7.2f %4u %6u %7.2f\n", phase, network->name[i],
+                (unsigned) network->mstp_port[i].This_Station,
+                (unsigned) stats.tokens,
+                test_ms(stats.token_rotation_min),
+                stats.token_rotations ?
+                test_ms(stats.token_rotation_total / stats.token_rotations) :
+                0.0, test_ms(stats.token_rotation_max),
+                (unsigned) stats.replies, test_ms(stats.reply_latency_min),
+                stats.replies ? test_ms(stats.reply_latency_total /
+                    stats.replies) : 0.0, test_ms(stats.reply_latency_max),
+                (unsigned) stats.reply_timeouts,
+                (unsigned) stats.late_wakeups,
+                test_ms(stats.wakeup_late_max));
+        }
+    }
+}
+
+/* mstp_engine [seconds [load threads [SCHED_FIFO priority]]] */
+int main(
+    int argc,
+    char *argv[])
+{
+    struct test_network *network = NULL;
+    pthread_t *load_threads = NULL;
+    unsigned seconds = 5;
+    unsigned load = 0;
+    int priority = 0;
+    unsigned n = 0;
+    unsigned i = 0;
+
+    load = (unsigned) sysconf(_SC_NPROCESSORS_ONLN) * 4;
+    if (argc > 1) {
+        seconds = (unsigned) strtoul(argv[1], NULL, 0);
+    }
+    if (argc > 2) {
+        load = (unsigned) strtoul(argv[2], NULL, 0);
+    }
+    if (argc > 3) {
+        priority = (int) strtol(argv[3], NULL, 0);
+    }
+    if (!mstp_engine_init()) {
+        return 1;
+    }
+    for (n = 0; n < TEST_NETWORKS; n++) {
+        network = &Test_Networks[n];
+        for (i = 0; i < TEST_NODES; i++) {
+            network->wire[i] = posix_openpt(O_RDWR | O_NOCTTY);
+            if ((network->wire[i] < 0) || (grantpt(network->wire[i]) < 0) ||
+                (unlockpt(network->wire[i]) < 0)) {
+                perror("posix_openpt");
+                return 1;
+            }
+            snprintf(network->name[i], sizeof(network->name[i]), "%s",
+                ptsname(network->wire[i]));
+            network->shared[i].RS485_Handle = -1;
+            network->shared[i].RS485MOD = CS8;
+            network->mstp_port[i].UserData = &network->shared[i];
+            dlmstp_set_baud_rate(&network->mstp_port[i], 38400);
+            dlmstp_set_mac_address(&network->mstp_port[i], i);
+            dlmstp_set_max_master(&network->mstp_port[i], TEST_NODES - 1);
+            dlmstp_set_max_info_frames(&network->mstp_port[i], 1);
+            if (!mstp_engine_add_port(&network->mstp_port[i],
+                    network->name[i])) {
+                fprintf(stderr, "cannot add %s\n", network->name[i]);
+                return 1;
+            }
+        }
+    }
+    Test_Running = true;
+    for (n = 0; n < TEST_NETWORKS; n++) {
+        pthread_create(&Test_Networks[n].wire_thread, NULL, test_wire_task,
+            &Test_Networks[n]);
+        pthread_create(&Test_Networks[n].traffic_thread, NULL,
+            test_traffic_task, &Test_Networks[n]);
+    }
+    if (!mstp_engine_start(priority)) {
+        return 1;
+    }
+    printf("%u networks of %u nodes, %u load threads, priority %d\n",
+        TEST_NETWORKS, TEST_NODES, load, priority);
+    printf("                            token rotation ms       "
+        "   reply latency ms            late wakeups\n");
+    printf("phase   port        MAC tokens    min    avg     max "
+        "replies   min    avg     max  t/o  count  max ms\n");
+    fflush(stdout);
+    /* let the token ring form */
+    sleep(1);
+    test_phase("idle", seconds);
+    Load_Running = true;
+    load_threads = (pthread_t *) calloc(load ? load : 1, sizeof(pthread_t));
+    for (i = 0; i < load; i++) {
+        pthread_create(&load_threads[i], NULL, test_load_task, NULL);
+    }
+    test_phase("loaded", seconds);
+    Load_Running = false;
+    for (i = 0; i < load; i++) {
+        pthread_join(load_threads[i], NULL);
+    }
+    free(load_threads);
+    Test_Running = false;
+    for (n = 0; n < TEST_NETWORKS; n++) {
+        pthread_join(Test_Networks[n].traffic_thread, NULL);
+        pthread_join(Test_Networks[n].wire_thread, NULL);
+    }
+    mstp_engine_cleanup();
+    for (n = 0; n < TEST_NETWORKS; n++) {
+        for (i = 0; i < TEST_NODES; i++) {
+            dlmstp_cleanup(&Test_Networks[n].mstp_port[i]);
+            close(Test_Networks[n].wire[i]);
+        }
+    }
+
+    return 0;
+}
+#endif
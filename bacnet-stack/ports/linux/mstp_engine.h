@@ -0,0 +1,99 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#ifndef MSTP_ENGINE_H
+#define MSTP_ENGINE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* number of MS/TP ports that the engine thread can run */
+#ifndef MSTP_ENGINE_MAX_PORTS
+#define MSTP_ENGINE_MAX_PORTS 8
+#endif
+
+/* a timer wakeup later than this is counted as late, in microseconds */
+#ifndef MSTP_ENGINE_LATE_USEC
+#define MSTP_ENGINE_LATE_USEC 1000
+#endif
+
+/* Timing statistics for one port.  Times are in microseconds. */
+typedef struct {
+    /* Token frames received for this station */
+    uint32_t tokens;
+    /* time from one token to the next, i.e. one token rotation */
+    uint32_t token_rotations;
+    uint32_t token_rotation_min;
+    uint32_t token_rotation_max;
+    uint64_t token_rotation_total;
+    /* time from sending a Data-Expecting-Reply frame to its reply */
+    uint32_t replies;
+    uint32_t reply_latency_min;
+    uint32_t reply_latency_max;
+    uint64_t reply_latency_total;
+    /* Treply_timeout expired without a reply */
+    uint32_t reply_timeouts;
+    uint32_t valid_frames;
+    uint32_t invalid_frames;
+    /* octets dropped because the receive FIFO was full */
+    uint32_t receive_overruns;
+    /* frames written and drained, and frames dropped because the
+       transmit buffer was full or the write failed */
+    uint32_t frames_sent;
+    uint32_t transmit_overruns;
+    /* timer wakeups, and how late they were */
+    uint32_t wakeups;
+    uint32_t late_wakeups;
+    uint32_t wakeup_late_max;
+} MSTP_ENGINE_STATS;
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+    bool mstp_engine_init(
+        void);
+    void mstp_engine_cleanup(
+        void);
+
+    bool mstp_engine_start(
+        int priority);
+    void mstp_engine_stop(
+        void);
+
+    bool mstp_engine_add_port(
+        void *poPort,
+        char *ifname);
+    bool mstp_engine_remove_port(
+        void *poPort);
+
+    bool mstp_engine_stats(
+        void *poPort,
+        MSTP_ENGINE_STATS * stats);
+    void mstp_engine_stats_reset(
+        void *poPort);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif
@@ -0,0 +1,46 @@
+#Makefile to build test case
+#CC      = gcc
+TARGET = mstp_engine
+
+# Directories
+BACNET_SOURCE_DIR = ../../src
+BACNET_INCLUDE = ../../include
+
+# -g for debugging with gdb
+DEFINES = -DBIG_ENDIAN=0 -D_GNU_SOURCE -DTEST_MSTP_ENGINE -DBACDL_MSTP=1 -DCRC_USE_SLICE_BY_8
+INCLUDES = -I. -I../../ -I$(BACNET_INCLUDE)
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -O2 -g
+LIBRARIES=-lc,-lgcc,-lrt,-lm
+LFLAGS = -pthread -Wl,$(LIBRARIES)
+
+SRCS = mstp_engine.c \
+	dlmstp_linux.c \
+	rs485.c \
+	${BACNET_SOURCE_DIR}/mstp.c \
+	${BACNET_SOURCE_DIR}/mstptext.c \
+	${BACNET_SOURCE_DIR}/indtext.c \
+	${BACNET_SOURCE_DIR}/crc.c \
+	${BACNET_SOURCE_DIR}/fifo.c \
+	${BACNET_SOURCE_DIR}/ringbuf.c \
+	${BACNET_SOURCE_DIR}/npdu.c \
+	${BACNET_SOURCE_DIR}/bacaddr.c \
+	${BACNET_SOURCE_DIR}/bacint.c
+
+OBJS = ${SRCS:.c=.o}
+
+all: ${TARGET}
+
+${TARGET}: ${OBJS}
+	${CC} ${OBJS} ${LFLAGS} -o $@
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+
+clean:
+	rm -rf core ${TARGET} $(OBJS) *.bak *.1 *.ini
+
+include: .depend
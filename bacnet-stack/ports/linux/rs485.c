@@ -395,6 +395,7 @@ void RS485_Send_Frame(
     uint32_t baud;
     ssize_t written = 0;
     int greska;
+    struct timespec turnaround;
     SHARED_MSTP_DATA *poSharedData = NULL;
 
     if (mstp_port) {
@@ -425,11 +426,23 @@ void RS485_Send_Frame(
         if (mstp_port) {
             mstp_port->SilenceTimerReset((void *) mstp_port);
         }
+    } else if (poSharedData->Send_Frame) {
+        /* the caller writes it without blocking, and resets the silence
+           timer once it has been sent */
+        poSharedData->Send_Frame((void *) mstp_port, buffer, nbytes);
     } else {
         baud = RS485_Get_Port_Baud_Rate(mstp_port);
         /* sleeping for turnaround time is necessary to give other devices
-           time to change from sending to receiving state. */
-        usleep(turnaround_time / baud);
+           time to change from sending to receiving state.
+           Tturnaround is in bit times, so it is converted to nanoseconds. */
+        if (baud) {
+            turnaround.tv_sec = 0;
+            turnaround.tv_nsec = (long) ((Tturnaround * 1000000000ULL) / baud);
+            while (clock_nanosleep(CLOCK_MONOTONIC, 0, &turnaround,
+                    &turnaround) == EINTR) {
+                /* sleep the remainder */
+            }
+        }
         /*
            On  success,  the  number of bytes written are returned (zero indicates
            nothing was written).  On error, -1  is  returned,  and  errno  is  set
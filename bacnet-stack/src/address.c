@@ -39,6 +39,7 @@
 #include "config.h"
 #include "bacaddr.h"
 #include "address.h"
+#include "hashindex.h"
 #include "bacdef.h"
 #include "bacdcode.h"
 #include "readrange.h"
@@ -52,13 +53,41 @@
 static uint32_t Top_Protected_Entry;
 static uint32_t Own_Device_ID = 0xFFFFFFFF;
 
-static struct Address_Cache_Entry {
+struct Address_Cache_Entry {
     uint8_t Flags;
     uint32_t device_id;
     unsigned max_apdu;
     BACNET_ADDRESS address;
     uint32_t TimeToLive;
-} Address_Cache[MAX_ADDRESS_CACHE];
+};
+
+/* The cache entries are indexed twice: by device instance, and by     */
+/* BACnet address (network number and MAC), with hash indexes (see    */
+/* hashindex.c).  Entries that are freed go onto a stack, so adding a  */
+/* device never searches for a hole. */
+#if ADDRESS_CACHE_DYNAMIC
+typedef uint32_t ADDRESS_INDEX;
+static struct Address_Cache_Entry *Address_Cache;
+static ADDRESS_INDEX *Address_Free_List;
+static uint32_t Address_Cache_Size;
+#else
+#if (MAX_ADDRESS_CACHE < 65535)
+typedef uint16_t ADDRESS_INDEX;
+#else
+typedef uint32_t ADDRESS_INDEX;
+#endif
+static struct Address_Cache_Entry Address_Cache[MAX_ADDRESS_CACHE];
+static ADDRESS_INDEX Address_Device_Hash[HASH_INDEX_SIZE(MAX_ADDRESS_CACHE)];
+static ADDRESS_INDEX Address_MAC_Hash[HASH_INDEX_SIZE(MAX_ADDRESS_CACHE)];
+static ADDRESS_INDEX Address_Free_List[MAX_ADDRESS_CACHE];
+static const uint32_t Address_Cache_Size = MAX_ADDRESS_CACHE;
+#endif
+/* number of entries on the free stack */
+static uint32_t Address_Free_Count;
+/* entries at or above this index have not been used since init */
+static uint32_t Address_Cache_Used;
+/* number of bound entries, so that address_count() need not scan */
+static uint32_t Address_Bound_Count;
 
 /* State flags for cache entries */
 
@@ -68,6 +97,9 @@ static struct Address_Cache_Entry {
 #define BAC_ADDR_SHORT_TTL 8    /* Oppertunistaclly added address with short TTL */
 #define BAC_ADDR_RESERVED  128  /* Freed up but held for caller to fill */
 
+#define BAC_ADDR_BOUND(f) \
+    (((f) & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) == BAC_ADDR_IN_USE)
+
 #define BAC_ADDR_SECS_1HOUR 3600        /* 60x60 */
 #define BAC_ADDR_SECS_1DAY  86400       /* 60x60x24 */
 
@@ -75,6 +107,200 @@ static struct Address_Cache_Entry {
 #define BAC_ADDR_SHORT_TIME BAC_ADDR_SECS_1HOUR
 #define BAC_ADDR_FOREVER    0xFFFFFFFF  /* Permenant entry */
 
+static uint32_t address_device_home(
+    uint32_t index)
+{
+    return hash_index_mix(Address_Cache[index].device_id);
+}
+
+static uint32_t address_mac_home(
+    uint32_t index)
+{
+    return bacnet_address_hash(&Address_Cache[index].address);
+}
+
+#if ADDRESS_CACHE_DYNAMIC
+static HASH_INDEX Address_Device_Index = {
+    NULL, sizeof(ADDRESS_INDEX), 0, address_device_home
+};
+static HASH_INDEX Address_MAC_Index = {
+    NULL, sizeof(ADDRESS_INDEX), 0, address_mac_home
+};
+#else
+static HASH_INDEX Address_Device_Index = {
+    Address_Device_Hash, sizeof(ADDRESS_INDEX),
+    HASH_INDEX_SIZE(MAX_ADDRESS_CACHE), address_device_home
+};
+static HASH_INDEX Address_MAC_Index = {
+    Address_MAC_Hash, sizeof(ADDRESS_INDEX),
+    HASH_INDEX_SIZE(MAX_ADDRESS_CACHE), address_mac_home
+};
+#endif
+
+/* Add the entry to the indexes, according to its flags. */
+static void address_entry_link(
+    struct Address_Cache_Entry *pMatch)
+{
+    uint32_t index = (uint32_t) (pMatch - Address_Cache);
+
+    if ((pMatch->Flags & BAC_ADDR_IN_USE) != 0) {
+        hash_index_insert(&Address_Device_Index, index);
+    }
+    if (BAC_ADDR_BOUND(pMatch->Flags)) {
+        hash_index_insert(&Address_MAC_Index, index);
+        Address_Bound_Count++;
+    }
+}
+
+/* Remove the entry from the indexes.  Must be called before the */
+/* flags, device id or address of an indexed entry are changed. */
+static void address_entry_unlink(
+    struct Address_Cache_Entry *pMatch)
+{
+    uint32_t index = (uint32_t) (pMatch - Address_Cache);
+
+    if ((pMatch->Flags & BAC_ADDR_IN_USE) != 0) {
+        hash_index_remove(&Address_Device_Index, index);
+    }
+    if (BAC_ADDR_BOUND(pMatch->Flags)) {
+        hash_index_remove(&Address_MAC_Index, index);
+        Address_Bound_Count--;
+    }
+}
+
+static void address_entry_free(
+    struct Address_Cache_Entry *pMatch)
+{
+    address_entry_unlink(pMatch);
+    pMatch->Flags = 0;
+    Address_Free_List[Address_Free_Count++] =
+        (ADDRESS_INDEX) (pMatch - Address_Cache);
+}
+
+#if ADDRESS_CACHE_DYNAMIC
+/* Double the cache, up to MAX_ADDRESS_CACHE entries, and rebuild  */
+/* the indexes at the new size.  Returns false if it cannot grow.  */
+static bool address_cache_grow(
+    void)
+{
+    struct Address_Cache_Entry *pCache;
+    ADDRESS_INDEX *pFree, *pDevice_Hash, *pMAC_Hash;
+    uint32_t size, index;
+
+    if (Address_Cache_Size == 0) {
+        size = ADDRESS_CACHE_INITIAL;
+    } else {
+        size = Address_Cache_Size * 2;
+    }
+    if (size > MAX_ADDRESS_CACHE) {
+        size = MAX_ADDRESS_CACHE;
+    }
+    if (size <= Address_Cache_Size) {
+        return false;
+    }
+    pDevice_Hash = calloc(HASH_INDEX_SIZE(size), sizeof(ADDRESS_INDEX));
+    pMAC_Hash = calloc(HASH_INDEX_SIZE(size), sizeof(ADDRESS_INDEX));
+    pCache = realloc(Address_Cache, size * sizeof(*Address_Cache));
+    if (pCache) {
+        Address_Cache = pCache;
+    }
+    pFree = realloc(Address_Free_List, size * sizeof(ADDRESS_INDEX));
+    if (pFree) {
+        Address_Free_List = pFree;
+    }
+    if (!(pDevice_Hash && pMAC_Hash && pCache && pFree)) {
+        free(pDevice_Hash);
+        free(pMAC_Hash);
+        return false;
+    }
+    for (index = Address_Cache_Size; index < size; index++) {
+        Address_Cache[index].Flags = 0;
+    }
+    free(Address_Device_Index.slots);
+    free(Address_MAC_Index.slots);
+    hash_index_init(&Address_Device_Index, pDevice_Hash,
+        sizeof(ADDRESS_INDEX), HASH_INDEX_SIZE(size), address_device_home);
+    hash_index_init(&Address_MAC_Index, pMAC_Hash, sizeof(ADDRESS_INDEX),
+        HASH_INDEX_SIZE(size), address_mac_home);
+    Address_Cache_Size = size;
+    Address_Bound_Count = 0;
+    for (index = 0; index < Address_Cache_Used; index++) {
+        address_entry_link(&Address_Cache[index]);
+    }
+
+    return true;
+}
+#else
+static bool address_cache_grow(
+    void)
+{
+    return false;
+}
+#endif
+
+/* Take an entry from the free stack, or one that has never been  */
+/* used.  Returns NULL if the cache is full and cannot grow.       */
+static struct Address_Cache_Entry *address_entry_alloc(
+    void)
+{
+    if (Address_Free_Count > 0) {
+        Address_Free_Count--;
+        return &Address_Cache[Address_Free_List[Address_Free_Count]];
+    }
+    if ((Address_Cache_Used >= Address_Cache_Size) &&
+        (!address_cache_grow())) {
+        return NULL;
+    }
+
+    return &Address_Cache[Address_Cache_Used++];
+}
+
+static struct Address_Cache_Entry *address_find_device(
+    uint32_t device_id)
+{
+    struct Address_Cache_Entry *pMatch;
+    unsigned slot;
+    uint32_t value;
+
+    if (Address_Device_Index.size == 0) {
+        return NULL;
+    }
+    slot =
+        hash_index_start(&Address_Device_Index, hash_index_mix(device_id));
+    while ((value = hash_index_get(&Address_Device_Index, slot)) != 0) {
+        pMatch = &Address_Cache[value - 1];
+        if (pMatch->device_id == device_id) {
+            return pMatch;
+        }
+        slot = hash_index_next(&Address_Device_Index, slot);
+    }
+
+    return NULL;
+}
+
+static struct Address_Cache_Entry *address_find_mac(
+    BACNET_ADDRESS * src)
+{
+    struct Address_Cache_Entry *pMatch;
+    unsigned slot;
+    uint32_t value;
+
+    if (Address_MAC_Index.size == 0) {
+        return NULL;
+    }
+    slot =
+        hash_index_start(&Address_MAC_Index, bacnet_address_hash(src));
+    while ((value = hash_index_get(&Address_MAC_Index, slot)) != 0) {
+        pMatch = &Address_Cache[value - 1];
+        if (bacnet_address_same(&pMatch->address, src)) {
+            return pMatch;
+        }
+        slot = hash_index_next(&Address_MAC_Index, slot);
+    }
+
+    return NULL;
+}
+
 
 void address_protected_entry_index_set(uint32_t top_protected_entry_index)
 {
@@ -128,18 +354,13 @@ void address_remove_device(
     struct Address_Cache_Entry *pMatch;
     uint32_t index = 0;
 
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
-            pMatch->Flags = 0;
-            if (index < Top_Protected_Entry) {
-                Top_Protected_Entry--;
-            }
-            break;
+    pMatch = address_find_device(device_id);
+    if (pMatch) {
+        index = (uint32_t) (pMatch - Address_Cache);
+        address_entry_free(pMatch);
+        if (index < Top_Protected_Entry) {
+            Top_Protected_Entry--;
         }
-        pMatch++;
-        index++;
     }
 
     return;
@@ -162,7 +383,7 @@ static struct Address_Cache_Entry *address_remove_oldest(
     uint32_t ulTime;
 
     pCandidate = NULL;
-    if (Top_Protected_Entry > (MAX_ADDRESS_CACHE - 1)) {
+    if (Top_Protected_Entry >= Address_Cache_Used) {
        return pCandidate;
     }
     ulTime = BAC_ADDR_FOREVER - 1;      /* Longest possible non static time to live */
@@ -170,7 +391,7 @@ static struct Address_Cache_Entry *address_remove_oldest(
     /* First pass - try only in use and bound entries */
 
     pMatch = &Address_Cache[Top_Protected_Entry];
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+    while (pMatch < &Address_Cache[Address_Cache_Used]) {
         if ((pMatch->
                 Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ |
                     BAC_ADDR_STATIC)) == BAC_ADDR_IN_USE) {
@@ -183,6 +404,7 @@ static struct Address_Cache_Entry *address_remove_oldest(
     }
 
     if (pCandidate != NULL) {   /* Found something to free up */
+        address_entry_unlink(pCandidate);
         pCandidate->Flags = BAC_ADDR_RESERVED;
         pCandidate->TimeToLive = BAC_ADDR_SHORT_TIME;   /* only reserve it for a short while */
         return (pCandidate);
@@ -190,7 +412,7 @@ static struct Address_Cache_Entry *address_remove_oldest(
 
     /* Second pass - try in use and un bound as last resort */
     pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+    while (pMatch < &Address_Cache[Address_Cache_Used]) {
         if ((pMatch->
                 Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ |
                     BAC_ADDR_STATIC)) ==
@@ -204,6 +426,7 @@ static struct Address_Cache_Entry *address_remove_oldest(
     }
 
     if (pCandidate != NULL) {   /* Found something to free up */
+        address_entry_unlink(pCandidate);
         pCandidate->Flags = BAC_ADDR_RESERVED;
         pCandidate->TimeToLive = BAC_ADDR_SHORT_TIME;   /* only reserve it for a short while */
     }
@@ -363,13 +586,18 @@ void address_init(
 {
     struct Address_Cache_Entry *pMatch;
 
-   Top_Protected_Entry = 0;
+    Top_Protected_Entry = 0;
 
     pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+    while (pMatch < &Address_Cache[Address_Cache_Used]) {
         pMatch->Flags = 0;
         pMatch++;
     }
+    hash_index_clear(&Address_Device_Index);
+    hash_index_clear(&Address_MAC_Index);
+    Address_Cache_Used = 0;
+    Address_Free_Count = 0;
+    Address_Bound_Count = 0;
     address_file_init(Address_Cache_Filename);
 
     return;
@@ -389,15 +617,15 @@ void address_init_partial(
     struct Address_Cache_Entry *pMatch;
 
     pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+    while (pMatch < &Address_Cache[Address_Cache_Used]) {
         if ((pMatch->Flags & BAC_ADDR_IN_USE) != 0) {   /* It's in use so let's check further */
             if (((pMatch->Flags & BAC_ADDR_BIND_REQ) != 0) ||
                 (pMatch->TimeToLive == 0))
-                pMatch->Flags = 0;
+                address_entry_free(pMatch);
         }
 
         if ((pMatch->Flags & BAC_ADDR_RESERVED) != 0) { /* Reserved entries should be cleared */
-            pMatch->Flags = 0;
+            address_entry_free(pMatch);
         }
 
         pMatch++;
@@ -422,24 +650,19 @@ void address_set_device_TTL(
 {
     struct Address_Cache_Entry *pMatch;
 
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
-            if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {     /* If bound then we have either static or normaal */
-                if (StaticFlag) {
-                    pMatch->Flags |= BAC_ADDR_STATIC;
-                    pMatch->TimeToLive = BAC_ADDR_FOREVER;
-                } else {
-                    pMatch->Flags &= ~BAC_ADDR_STATIC;
-                    pMatch->TimeToLive = TimeOut;
-                }
+    pMatch = address_find_device(device_id);
+    if (pMatch) {
+        if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) { /* If bound then we have either static or normaal */
+            if (StaticFlag) {
+                pMatch->Flags |= BAC_ADDR_STATIC;
+                pMatch->TimeToLive = BAC_ADDR_FOREVER;
             } else {
-                pMatch->TimeToLive = TimeOut;   /* For unbound we can only set the time to live */
+                pMatch->Flags &= ~BAC_ADDR_STATIC;
+                pMatch->TimeToLive = TimeOut;
             }
-            break;      /* Exit now if found at all - bound or unbound */
+        } else {
+            pMatch->TimeToLive = TimeOut;       /* For unbound we can only set the time to live */
         }
-        pMatch++;
     }
 }
 
@@ -452,18 +675,13 @@ bool address_get_by_device(
     struct Address_Cache_Entry *pMatch;
     bool found = false; /* return value */
 
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
-            if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {     /* If bound then fetch data */
-                bacnet_address_copy(src, &pMatch->address);
-                *max_apdu = pMatch->max_apdu;
-                found = true;   /* Prove we found it */
-            }
-            break;      /* Exit now if found at all - bound or unbound */
+    pMatch = address_find_device(device_id);
+    if (pMatch) {
+        if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) { /* If bound then fetch data */
+            bacnet_address_copy(src, &pMatch->address);
+            *max_apdu = pMatch->max_apdu;
+            found = true;       /* Prove we found it */
         }
-        pMatch++;
     }
 
     return found;
@@ -478,18 +696,12 @@ bool address_get_device_id(
     struct Address_Cache_Entry *pMatch;
     bool found = false; /* return value */
 
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) == BAC_ADDR_IN_USE) {       /* If bound */
-            if (bacnet_address_same(&pMatch->address, src)) {
-                if (device_id) {
-                    *device_id = pMatch->device_id;
-                }
-                found = true;
-                break;
-            }
+    pMatch = address_find_mac(src);
+    if (pMatch) {
+        if (device_id) {
+            *device_id = pMatch->device_id;
         }
-        pMatch++;
+        found = true;
     }
 
     return found;
@@ -514,57 +726,42 @@ void address_add(
        bind request if it exists */
 
     /* existing device or bind request outstanding - update address */
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
-            bacnet_address_copy(&pMatch->address, src);
-            pMatch->max_apdu = max_apdu;
-
-            /* Pick the right time to live */
-
-            if ((pMatch->Flags & BAC_ADDR_BIND_REQ) != 0)       /* Bind requested so long time */
-                pMatch->TimeToLive = BAC_ADDR_LONG_TIME;
-            else if ((pMatch->Flags & BAC_ADDR_STATIC) != 0)    /* Static already so make sure it never expires */
-                pMatch->TimeToLive = BAC_ADDR_FOREVER;
-            else if ((pMatch->Flags & BAC_ADDR_SHORT_TTL) != 0) /* Opportunistic entry so leave on short fuse */
-                pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;
-            else
-                pMatch->TimeToLive = BAC_ADDR_LONG_TIME;        /* Renewing existing entry */
+    pMatch = address_find_device(device_id);
+    if (pMatch) {
+        address_entry_unlink(pMatch);
+        bacnet_address_copy(&pMatch->address, src);
+        pMatch->max_apdu = max_apdu;
+
+        /* Pick the right time to live */
+
+        if ((pMatch->Flags & BAC_ADDR_BIND_REQ) != 0)   /* Bind requested so long time */
+            pMatch->TimeToLive = BAC_ADDR_LONG_TIME;
+        else if ((pMatch->Flags & BAC_ADDR_STATIC) != 0)        /* Static already so make sure it never expires */
+            pMatch->TimeToLive = BAC_ADDR_FOREVER;
+        else if ((pMatch->Flags & BAC_ADDR_SHORT_TTL) != 0)     /* Opportunistic entry so leave on short fuse */
+            pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;
+        else
+            pMatch->TimeToLive = BAC_ADDR_LONG_TIME;    /* Renewing existing entry */
 
-            pMatch->Flags &= ~BAC_ADDR_BIND_REQ;        /* Clear bind request flag just in case */
-            found = true;
-            break;
-        }
-        pMatch++;
+        pMatch->Flags &= ~BAC_ADDR_BIND_REQ;    /* Clear bind request flag just in case */
+        address_entry_link(pMatch);
+        found = true;
     }
 
     /* new device - add to cache if there is room */
     if (!found) {
-        pMatch = Address_Cache;
-        while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-            if ((pMatch->Flags & BAC_ADDR_IN_USE) == 0) {
-                pMatch->Flags = BAC_ADDR_IN_USE;
-                pMatch->device_id = device_id;
-                pMatch->max_apdu = max_apdu;
-                bacnet_address_copy(&pMatch->address, src);
-                pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;       /* Opportunistic entry so leave on short fuse */
-                found = true;
-                break;
-            }
-            pMatch++;
+        pMatch = address_entry_alloc();
+        if (pMatch == NULL) {
+            /* See if we can squeeze it in */
+            pMatch = address_remove_oldest();
         }
-    }
-
-    /* See if we can squeeze it in */
-    if (!found) {
-        pMatch = address_remove_oldest();
         if (pMatch != NULL) {
             pMatch->Flags = BAC_ADDR_IN_USE;
             pMatch->device_id = device_id;
             pMatch->max_apdu = max_apdu;
             bacnet_address_copy(&pMatch->address, src);
             pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;   /* Opportunistic entry so leave on short fuse */
+            address_entry_link(pMatch);
         }
     }
     return;
@@ -582,53 +779,41 @@ bool address_device_bind_request(
     struct Address_Cache_Entry *pMatch;
 
     /* existing device - update address info if currently bound */
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
-            if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) {     /* Already bound */
-                found = true;
-                if (src) {
-                    bacnet_address_copy(src, &pMatch->address);
-                }
-                if (max_apdu) {
-                    *max_apdu = pMatch->max_apdu;
-                }
-                if (device_ttl) {
-                    *device_ttl = pMatch->TimeToLive;
-                }
-                if ((pMatch->Flags & BAC_ADDR_SHORT_TTL) != 0) {        /* Was picked up opportunistacilly */
-                    pMatch->Flags &= ~BAC_ADDR_SHORT_TTL;       /* Convert to normal entry  */
-                    pMatch->TimeToLive = BAC_ADDR_LONG_TIME;    /* And give it a decent time to live */
-                }
+    pMatch = address_find_device(device_id);
+    if (pMatch) {
+        if ((pMatch->Flags & BAC_ADDR_BIND_REQ) == 0) { /* Already bound */
+            found = true;
+            if (src) {
+                bacnet_address_copy(src, &pMatch->address);
+            }
+            if (max_apdu) {
+                *max_apdu = pMatch->max_apdu;
+            }
+            if (device_ttl) {
+                *device_ttl = pMatch->TimeToLive;
+            }
+            if ((pMatch->Flags & BAC_ADDR_SHORT_TTL) != 0) {    /* Was picked up opportunistacilly */
+                pMatch->Flags &= ~BAC_ADDR_SHORT_TTL;   /* Convert to normal entry  */
+                pMatch->TimeToLive = BAC_ADDR_LONG_TIME;        /* And give it a decent time to live */
             }
-            return (found);     /* True if bound, false if bind request outstanding */
         }
-        pMatch++;
+        return (found); /* True if bound, false if bind request outstanding */
     }
 
     /* Not there already so look for a free entry to put it in */
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_RESERVED)) == 0) {
-            /* In use and awaiting binding */
-            pMatch->Flags = (uint8_t) (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ);
-            pMatch->device_id = device_id;
-            /* No point in leaving bind requests in for long haul */
-            pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;
-            /* now would be a good time to do a Who-Is request */
-            return (false);
-        }
-        pMatch++;
+    pMatch = address_entry_alloc();
+    if (pMatch == NULL) {
+        /* No free entries, See if we can squeeze it in by dropping an existing one */
+        pMatch = address_remove_oldest();
     }
-
-    /* No free entries, See if we can squeeze it in by dropping an existing one */
-    pMatch = address_remove_oldest();
     if (pMatch != NULL) {
+        /* In use and awaiting binding */
         pMatch->Flags = (uint8_t) (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ);
         pMatch->device_id = device_id;
         /* No point in leaving bind requests in for long haul */
         pMatch->TimeToLive = BAC_ADDR_SHORT_TIME;
+        address_entry_link(pMatch);
+        /* now would be a good time to do a Who-Is request */
     }
     return (false);
 }
@@ -651,22 +836,19 @@ void address_add_binding(
     struct Address_Cache_Entry *pMatch;
 
     /* existing device or bind request - update address */
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        if (((pMatch->Flags & BAC_ADDR_IN_USE) != 0) &&
-            (pMatch->device_id == device_id)) {
-            bacnet_address_copy(&pMatch->address, src);
-            pMatch->max_apdu = max_apdu;
-            /* Clear bind request flag in case it was set */
-            pMatch->Flags &= ~BAC_ADDR_BIND_REQ;
-            /* Only update TTL if not static */
-            if ((pMatch->Flags & BAC_ADDR_STATIC) == 0) {
-                /* and set it on a long fuse */
-                pMatch->TimeToLive = BAC_ADDR_LONG_TIME;
-            }
-            break;
+    pMatch = address_find_device(device_id);
+    if (pMatch) {
+        address_entry_unlink(pMatch);
+        bacnet_address_copy(&pMatch->address, src);
+        pMatch->max_apdu = max_apdu;
+        /* Clear bind request flag in case it was set */
+        pMatch->Flags &= ~BAC_ADDR_BIND_REQ;
+        /* Only update TTL if not static */
+        if ((pMatch->Flags & BAC_ADDR_STATIC) == 0) {
+            /* and set it on a long fuse */
+            pMatch->TimeToLive = BAC_ADDR_LONG_TIME;
         }
-        pMatch++;
+        address_entry_link(pMatch);
     }
     return;
 }
@@ -681,7 +863,7 @@ bool address_device_get_by_index(
     struct Address_Cache_Entry *pMatch;
     bool found = false; /* return value */
 
-    if (index < MAX_ADDRESS_CACHE) {
+    if (index < Address_Cache_Used) {
         pMatch = &Address_Cache[index];
         if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) ==
             BAC_ADDR_IN_USE) {
@@ -716,20 +898,8 @@ bool address_get_by_index(
 unsigned address_count(
     void)
 {
-    struct Address_Cache_Entry *pMatch;
-    unsigned count = 0; /* return value */
-
-    pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
-        /* Only count bound entries */
-        if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) ==
-            BAC_ADDR_IN_USE)
-            count++;
-
-        pMatch++;
-    }
-
-    return count;
+    /* Only count bound entries */
+    return Address_Bound_Count;
 }
 
 /****************************************************************************
@@ -751,7 +921,7 @@ int address_list_encode(
     apdu_len = apdu_len;
     /* look for matching address */
     pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+    while (pMatch < &Address_Cache[Address_Cache_Used]) {
         if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) ==
             BAC_ADDR_IN_USE) {
             iLen +=
@@ -826,7 +996,7 @@ int rr_address_list_encode(
     bitstring_set_bit(&pRequest->ResultFlags, RESULT_FLAG_LAST_ITEM, false);
     bitstring_set_bit(&pRequest->ResultFlags, RESULT_FLAG_MORE_ITEMS, false);
     /* See how much space we have */
-    uiRemaining = (uint32_t) (MAX_APDU - pRequest->Overhead);
+    uiRemaining = (uint32_t) (pRequest->MaxApdu - pRequest->Overhead);
 
     pRequest->ItemCount = 0;    /* Start out with nothing */
     uiTotal = address_count();  /* What do we have to work with here ? */
@@ -884,11 +1054,10 @@ int rr_address_list_encode(
 
     /* Seek to start position */
     while (uiIndex != pRequest->Range.RefIndex) {
-        if ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) == BAC_ADDR_IN_USE) {       /* Only count bound entries */
-            pMatch++;
-            uiIndex++;
-        } else
+        pMatch++;
+        while (!BAC_ADDR_BOUND(pMatch->Flags))  /* Only count bound entries */
             pMatch++;
+        uiIndex++;
     }
 
     uiFirst = uiIndex;  /* Record where we started from */
@@ -934,8 +1103,10 @@ int rr_address_list_encode(
         pMatch++;
         pRequest->ItemCount++;  /* Chalk up another one for the response count */
 
-        while ((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_BIND_REQ)) != BAC_ADDR_IN_USE)      /* Find next bound entry */
-            pMatch++;
+        if (uiIndex <= uiTarget) {
+            while (!BAC_ADDR_BOUND(pMatch->Flags))      /* Find next bound entry */
+                pMatch++;
+        }
     }
 
     /* Set remaining result flags if necessary */
@@ -962,13 +1133,13 @@ void address_cache_timer(
     struct Address_Cache_Entry *pMatch;
 
     pMatch = Address_Cache;
-    while (pMatch <= &Address_Cache[MAX_ADDRESS_CACHE - 1]) {
+    while (pMatch < &Address_Cache[Address_Cache_Used]) {
         if (((pMatch->Flags & (BAC_ADDR_IN_USE | BAC_ADDR_RESERVED)) != 0)
             && ((pMatch->Flags & BAC_ADDR_STATIC) == 0)) {      /* Check all entries holding a slot except statics */
             if (pMatch->TimeToLive >= uSeconds)
                 pMatch->TimeToLive -= uSeconds;
             else
-                pMatch->Flags = 0;
+                address_entry_free(pMatch);
         }
 
         pMatch++;
@@ -1130,6 +1301,54 @@ void testAddress(
     }
 }
 
+void testAddressBinding(
+    Test * pTest)
+{
+    BACNET_ADDRESS src, old_src;
+    BACNET_ADDRESS test_address;
+    uint32_t test_device_id = 0;
+    unsigned test_max_apdu = 0;
+    uint32_t device_id = 260001;
+    unsigned i, count;
+
+    address_init();
+    count = address_count();
+    /* a bind request is found by device id, but is not bound */
+    ct_test(pTest, !address_bind_request(device_id, &test_max_apdu,
+            &test_address));
+    ct_test(pTest, !address_get_by_device(device_id, &test_max_apdu,
+            &test_address));
+    ct_test(pTest, address_count() == count);
+    /* the I-Am completes the binding */
+    set_address(1, &old_src);
+    address_add_binding(device_id, 1476, &old_src);
+    ct_test(pTest, address_count() == (count + 1));
+    ct_test(pTest, address_bind_request(device_id, &test_max_apdu,
+            &test_address));
+    ct_test(pTest, test_max_apdu == 1476);
+    ct_test(pTest, bacnet_address_same(&test_address, &old_src));
+    ct_test(pTest, address_get_device_id(&old_src, &test_device_id));
+    ct_test(pTest, test_device_id == device_id);
+    /* the device moves: the old MAC must no longer resolve */
+    set_address(2, &src);
+    address_add(device_id, 480, &src);
+    ct_test(pTest, address_count() == (count + 1));
+    ct_test(pTest, !address_get_device_id(&old_src, &test_device_id));
+    ct_test(pTest, address_get_device_id(&src, &test_device_id));
+    ct_test(pTest, test_device_id == device_id);
+    ct_test(pTest, address_get_by_device(device_id, &test_max_apdu,
+            &test_address));
+    ct_test(pTest, test_max_apdu == 480);
+    /* entries expire from both indexes */
+    for (i = 0; i <= (BAC_ADDR_LONG_TIME / BAC_ADDR_SHORT_TIME); i++) {
+        address_cache_timer(BAC_ADDR_SHORT_TIME);
+    }
+    ct_test(pTest, !address_get_by_device(device_id, &test_max_apdu,
+            &test_address));
+    ct_test(pTest, !address_get_device_id(&src, &test_device_id));
+    ct_test(pTest, address_count() == count);
+}
+
 #ifdef TEST_ADDRESS
 int main(
     void)
@@ -1143,6 +1362,8 @@ int main(
     assert(rc);
     rc = ct_addTestFunction(pTest, testAddressFile);
     assert(rc);
+    rc = ct_addTestFunction(pTest, testAddressBinding);
+    assert(rc);
 
 
     ct_setStream(pTest, stdout);
@@ -1153,4 +1374,67 @@ int main(
     return 0;
 }
 #endif /* TEST_ADDRESS */
+
+#ifdef TEST_ADDRESS_BENCH
+#include <time.h>
+
+/* Measure the lookup cost by device instance and by MAC address
+   as the cache grows.  Build with ADDRESS_CACHE_DYNAMIC and a
+   MAX_ADDRESS_CACHE of at least 100000 - see address_bench.mak */
+int main(
+    void)
+{
+    static const uint32_t sizes[] = { 100, 1000, 10000, 100000 };
+    const uint32_t lookups = 1000000;
+    BACNET_ADDRESS src, test_address;
+    uint32_t device_id = 0;
+    unsigned max_apdu = 0;
+    uint32_t i, n, size;
+    unsigned long found;
+    clock_t start;
+    double device_ns, mac_ns;
+
+    printf("entries  device-id ns/lookup  MAC ns/lookup\n");
+    for (n = 0; n < (sizeof(sizes) / sizeof(sizes[0])); n++) {
+        size = sizes[n];
+        if (size > MAX_ADDRESS_CACHE) {
+            break;
+        }
+        address_init();
+        for (i = 0; i < size; i++) {
+            src.mac_len = 6;
+            encode_unsigned32(&src.mac[0], i);
+            src.mac[4] = 0xBA;
+            src.mac[5] = 0xC0;
+            src.net = 0;
+            src.len = 0;
+            address_add(i * 7, 1476, &src);
+        }
+        found = 0;
+        start = clock();
+        for (i = 0; i < lookups; i++) {
+            if (address_get_by_device(((i * 7919) % size) * 7, &max_apdu,
+                    &test_address)) {
+                found++;
+            }
+        }
+        device_ns =
+            ((double) (clock() - start) * 1e9) / CLOCKS_PER_SEC / lookups;
+        start = clock();
+        for (i = 0; i < lookups; i++) {
+            src.mac_len = 6;
+            encode_unsigned32(&src.mac[0], (i * 7919) % size);
+            if (address_get_device_id(&src, &device_id)) {
+                found++;
+            }
+        }
+        mac_ns =
+            ((double) (clock() - start) * 1e9) / CLOCKS_PER_SEC / lookups;
+        printf("%7lu  %19.1f  %13.1f  (%lu found)\n", (unsigned long) size,
+            device_ns, mac_ns, found);
+    }
+
+    return 0;
+}
+#endif /* TEST_ADDRESS_BENCH */
 #endif /* TEST */
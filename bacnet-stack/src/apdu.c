@@ -42,6 +42,9 @@
 #include "tsm.h"
 #include "dcc.h"
 #include "iam.h"
+#if BACNET_SEGMENTATION_ENABLED
+#include <stdlib.h>
+#endif
 
 /** @file apdu.c  Handles APDU services */
 
@@ -54,6 +57,8 @@ extern int Routed_Device_Service_Approval(
 
 /* APDU Timeout in Milliseconds */
 static uint16_t Timeout_Milliseconds = 3000;
+/* APDU Segment Timeout in Milliseconds */
+static uint16_t Segment_Timeout_Milliseconds = 2000;
 /* Number of APDU Retries */
 static uint8_t Number_Of_Retries = 3;
 
@@ -89,7 +94,9 @@ static BACNET_SERVICES_SUPPORTED
     SERVICE_SUPPORTED_READ_RANGE,
     SERVICE_SUPPORTED_LIFE_SAFETY_OPERATION,
     SERVICE_SUPPORTED_SUBSCRIBE_COV_PROPERTY,
-    SERVICE_SUPPORTED_GET_EVENT_INFORMATION
+    SERVICE_SUPPORTED_GET_EVENT_INFORMATION,
+    SERVICE_SUPPORTED_SUBSCRIBE_COV_PROPERTY_MULTIPLE,
+    SERVICE_SUPPORTED_CONFIRMED_COV_NOTIFICATION_MULTIPLE
 };
 
 /* a simple table for crossing the services supported */
@@ -104,7 +111,9 @@ static BACNET_SERVICES_SUPPORTED
     SERVICE_SUPPORTED_TIME_SYNCHRONIZATION,
     SERVICE_SUPPORTED_WHO_HAS,
     SERVICE_SUPPORTED_WHO_IS,
-    SERVICE_SUPPORTED_UTC_TIME_SYNCHRONIZATION
+    SERVICE_SUPPORTED_UTC_TIME_SYNCHRONIZATION,
+    SERVICE_SUPPORTED_WRITE_GROUP,
+    SERVICE_SUPPORTED_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE
 };
 
 /* Confirmed Function Handlers */
@@ -295,6 +304,17 @@ void apdu_set_confirmed_ack_handler(
     }
 }
 
+/* the ack handler of a confirmed service, to be called by one set
+   in its place */
+confirmed_ack_function apdu_confirmed_ack_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    if (service_choice < MAX_BACNET_CONFIRMED_SERVICE)
+        return Confirmed_ACK_Function[service_choice];
+
+    return NULL;
+}
+
 static error_function Error_Function[MAX_BACNET_CONFIRMED_SERVICE];
 
 void apdu_set_error_handler(
@@ -305,6 +325,15 @@ void apdu_set_error_handler(
         Error_Function[service_choice] = pFunction;
 }
 
+error_function apdu_error_handler(
+    BACNET_CONFIRMED_SERVICE service_choice)
+{
+    if (service_choice < MAX_BACNET_CONFIRMED_SERVICE)
+        return Error_Function[service_choice];
+
+    return NULL;
+}
+
 static abort_function Abort_Function;
 
 void apdu_set_abort_handler(
@@ -313,6 +342,12 @@ void apdu_set_abort_handler(
     Abort_Function = pFunction;
 }
 
+abort_function apdu_abort_handler(
+    void)
+{
+    return Abort_Function;
+}
+
 static reject_function Reject_Function;
 
 void apdu_set_reject_handler(
@@ -321,6 +356,12 @@ void apdu_set_reject_handler(
     Reject_Function = pFunction;
 }
 
+reject_function apdu_reject_handler(
+    void)
+{
+    return Reject_Function;
+}
+
 uint16_t apdu_decode_confirmed_service_request(
     uint8_t * apdu,     /* APDU data */
     uint16_t apdu_len,
@@ -362,6 +403,18 @@ void apdu_timeout_set(
     Timeout_Milliseconds = milliseconds;
 }
 
+uint16_t apdu_segment_timeout(
+    void)
+{
+    return Segment_Timeout_Milliseconds;
+}
+
+void apdu_segment_timeout_set(
+    uint16_t milliseconds)
+{
+    Segment_Timeout_Milliseconds = milliseconds;
+}
+
 uint8_t apdu_retries(
     void)
 {
@@ -457,6 +510,10 @@ void apdu_handler(
     uint32_t error_class = 0;
     uint8_t reason = 0;
     bool server = false;
+#if BACNET_SEGMENTATION_ENABLED
+    uint8_t *segment_data = NULL;
+    uint32_t segment_data_len = 0;
+#endif
 
     if (apdu) {
         /* PDU Type */
@@ -471,6 +528,21 @@ void apdu_handler(
                        shall be processed and no messages shall be initiated. */
                     break;
                 }
+#if BACNET_SEGMENTATION_ENABLED
+                if (service_data.segmented_message) {
+                    if (!tsm_segmented_request_received(src, &service_data,
+                            service_choice, service_request,
+                            service_request_len, &segment_data,
+                            &segment_data_len)) {
+                        break;
+                    }
+                    /* hand over the whole request as if unsegmented */
+                    service_request = segment_data;
+                    service_request_len = (uint16_t) segment_data_len;
+                    service_data.segmented_message = false;
+                    service_data.more_follows = false;
+                }
+#endif
                 if ((service_choice < MAX_BACNET_CONFIRMED_SERVICE) &&
                     (Confirmed_Function[service_choice]))
                     Confirmed_Function[service_choice] (service_request,
@@ -478,6 +550,9 @@ void apdu_handler(
                 else if (Unrecognized_Service_Handler)
                     Unrecognized_Service_Handler(service_request,
                         service_request_len, src, &service_data);
+#if BACNET_SEGMENTATION_ENABLED
+                free(segment_data);
+#endif
                 break;
             case PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST:
                 service_choice = apdu[1];
@@ -506,6 +581,8 @@ void apdu_handler(
                     case SERVICE_CONFIRMED_EVENT_NOTIFICATION:
                     case SERVICE_CONFIRMED_SUBSCRIBE_COV:
                     case SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY:
+                    case SERVICE_CONFIRMED_SUBSCRIBE_COV_PROPERTY_MULTIPLE:
+                    case SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE:
                     case SERVICE_CONFIRMED_LIFE_SAFETY_OPERATION:
                         /* Object Access Services */
                     case SERVICE_CONFIRMED_ADD_LIST_ELEMENT:
@@ -526,7 +603,7 @@ void apdu_handler(
                                 Confirmed_ACK_Function[service_choice]) (src,
                                 invoke_id);
                         }
-                        tsm_free_invoke_id(invoke_id);
+                        tsm_free_peer_invoke_id(src, invoke_id);
                         break;
                     default:
                         break;
@@ -546,6 +623,18 @@ void apdu_handler(
                 service_choice = apdu[len++];
                 service_request = &apdu[len];
                 service_request_len = apdu_len - (uint16_t) len;
+#if BACNET_SEGMENTATION_ENABLED
+                segment_data_len = service_request_len;
+                if (service_ack_data.segmented_message) {
+                    if (!tsm_segmented_complex_ack_received(src,
+                            &service_ack_data, service_choice,
+                            service_request, service_request_len,
+                            &segment_data, &segment_data_len)) {
+                        break;
+                    }
+                    service_request = segment_data;
+                }
+#endif
                 switch (service_choice) {
                     case SERVICE_CONFIRMED_GET_ALARM_SUMMARY:
                     case SERVICE_CONFIRMED_GET_ENROLLMENT_SUMMARY:
@@ -567,19 +656,31 @@ void apdu_handler(
                     case SERVICE_CONFIRMED_AUTHENTICATE:
                         if (Confirmed_ACK_Function[service_choice] != NULL) {
                             (Confirmed_ACK_Function[service_choice])
+#if BACNET_SEGMENTATION_ENABLED
+                                (service_request, segment_data_len, src,
+                                &service_ack_data);
+#else
                                 (service_request, service_request_len, src,
                                 &service_ack_data);
+#endif
                         }
-                        tsm_free_invoke_id(invoke_id);
+                        tsm_free_peer_invoke_id(src, invoke_id);
                         break;
                     default:
                         break;
                 }
+#if BACNET_SEGMENTATION_ENABLED
+                free(segment_data);
+#endif
                 break;
             case PDU_TYPE_SEGMENT_ACK:
+#if BACNET_SEGMENTATION_ENABLED
+                tsm_segment_ack_received(src, apdu, apdu_len);
+#else
                 /* FIXME: what about a denial of service attack here?
                    we could check src to see if that matched the tsm */
-                tsm_free_invoke_id(invoke_id);
+                tsm_free_peer_invoke_id(src, invoke_id);
+#endif
                 break;
             case PDU_TYPE_ERROR:
                 invoke_id = apdu[1];
@@ -618,14 +719,14 @@ void apdu_handler(
                             (BACNET_ERROR_CLASS) error_class,
                             (BACNET_ERROR_CODE) error_code);
                 }
-                tsm_free_invoke_id(invoke_id);
+                tsm_free_peer_invoke_id(src, invoke_id);
                 break;
             case PDU_TYPE_REJECT:
                 invoke_id = apdu[1];
                 reason = apdu[2];
                 if (Reject_Function)
                     Reject_Function(src, invoke_id, reason);
-                tsm_free_invoke_id(invoke_id);
+                tsm_free_peer_invoke_id(src, invoke_id);
                 break;
             case PDU_TYPE_ABORT:
                 server = apdu[0] & 0x01;
@@ -633,7 +734,14 @@ void apdu_handler(
                 reason = apdu[2];
                 if (Abort_Function)
                     Abort_Function(src, invoke_id, reason, server);
-                tsm_free_invoke_id(invoke_id);
+#if BACNET_SEGMENTATION_ENABLED
+                if (!server) {
+                    /* the client aborted a transaction we are serving */
+                    tsm_free_server_transaction(src, invoke_id);
+                    break;
+                }
+#endif
+                tsm_free_peer_invoke_id(src, invoke_id);
                 break;
             default:
                 break;
@@ -248,11 +248,13 @@ int arf_ack_encode_apdu(
     return apdu_len;
 }
 
-/* decode the service request only */
-int arf_ack_decode_service_request(
+/* decodes the fileData into the data, or into views of the apdu
+   when file_data is not NULL */
+static int arf_ack_decode(
     uint8_t * apdu,
     unsigned apdu_len,
-    BACNET_ATOMIC_READ_FILE_DATA * data)
+    BACNET_ATOMIC_READ_FILE_DATA * data,
+    BACNET_OCTET_STRING_VIEW * file_data)
 {
     int len = 0;
     int tag_len = 0;
@@ -293,9 +295,18 @@ int arf_ack_decode_service_request(
             if (tag_number != BACNET_APPLICATION_TAG_OCTET_STRING) {
                 return -1;
             }
-            decoded_len =
-                decode_octet_string(&apdu[len], len_value_type,
-                &data->fileData[0]);
+            if ((len + len_value_type) > apdu_len) {
+                return -1;
+            }
+            if (file_data) {
+                decoded_len =
+                    decode_octet_string_view(&apdu[len], len_value_type,
+                    &file_data[0]);
+            } else {
+                decoded_len =
+                    decode_octet_string(&apdu[len], len_value_type,
+                    &data->fileData[0]);
+            }
             if ((uint32_t)decoded_len != len_value_type) {
                 return -1;
             }
@@ -331,6 +342,10 @@ int arf_ack_decode_service_request(
             len +=
                 decode_unsigned(&apdu[len], len_value_type,
                 &data->type.record.RecordCount);
+            if (data->type.record.RecordCount >
+                BACNET_READ_FILE_RECORD_COUNT) {
+                return -1;
+            }
             for (i = 0; i < data->type.record.RecordCount; i++) {
                 /* fileData */
                 tag_len =
@@ -340,9 +355,18 @@ int arf_ack_decode_service_request(
                 if (tag_number != BACNET_APPLICATION_TAG_OCTET_STRING) {
                     return -1;
                 }
-                decoded_len =
+                if ((len + len_value_type) > apdu_len) {
+                    return -1;
+                }
+                if (file_data) {
+                    decoded_len =
+                        decode_octet_string_view(&apdu[len], len_value_type,
+                        &file_data[i]);
+                } else {
+                    decoded_len =
                         decode_octet_string(&apdu[len], len_value_type,
                         &data->fileData[i]);
+                }
                 if ((uint32_t)decoded_len != len_value_type) {
                     return -1;
                 }
@@ -361,6 +385,26 @@ int arf_ack_decode_service_request(
     return len;
 }
 
+/* decode the service request only */
+int arf_ack_decode_service_request(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    BACNET_ATOMIC_READ_FILE_DATA * data)
+{
+    return arf_ack_decode(apdu, apdu_len, data, NULL);
+}
+
+/* decode the service request only, with the fileData as views that
+   point into the apdu rather than copies in the data */
+int arf_ack_decode_service_request_view(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    BACNET_ATOMIC_READ_FILE_DATA * data,
+    BACNET_OCTET_STRING_VIEW file_data[BACNET_READ_FILE_RECORD_COUNT])
+{
+    return arf_ack_decode(apdu, apdu_len, data, file_data);
+}
+
 int arf_ack_decode_apdu(
     uint8_t * apdu,
     unsigned apdu_len,
@@ -406,6 +450,7 @@ void testAtomicReadFileAckAccess(
     uint8_t invoke_id = 128;
     uint8_t test_invoke_id = 0;
     unsigned int i = 0;
+    BACNET_OCTET_STRING_VIEW file_data[BACNET_READ_FILE_RECORD_COUNT];
 
     len = arf_ack_encode_apdu(&apdu[0], invoke_id, data);
     ct_test(pTest, len != 0);
@@ -441,6 +486,29 @@ void testAtomicReadFileAckAccess(
                     octetstring_length(&test_data.fileData[i])) == 0);
         }
     }
+    /* the views point into the apdu, past the 3 octet header */
+    len =
+        arf_ack_decode_service_request_view(&apdu[3], apdu_len - 3,
+        &test_data, file_data);
+    ct_test(pTest, len == (apdu_len - 3));
+    for (i = 0; i < BACNET_READ_FILE_RECORD_COUNT; i++) {
+        if ((test_data.access == FILE_STREAM_ACCESS) ? (i > 0) :
+            (i >= test_data.type.record.RecordCount)) {
+            break;
+        }
+        ct_test(pTest, file_data[i].value > &apdu[3]);
+        ct_test(pTest, file_data[i].value < &apdu[apdu_len]);
+        ct_test(pTest,
+            file_data[i].length == octetstring_length(&data->fileData[i]));
+        ct_test(pTest, memcmp(file_data[i].value,
+                octetstring_value(&data->fileData[i]),
+                file_data[i].length) == 0);
+    }
+    /* the data must be in the apdu */
+    len =
+        arf_ack_decode_service_request_view(&apdu[3], apdu_len - 5,
+        &test_data, file_data);
+    ct_test(pTest, len == -1);
 }
 
 void testAtomicReadFileAck(
@@ -91,11 +91,13 @@ int awf_encode_apdu(
     return apdu_len;
 }
 
-/* decode the service request only */
-int awf_decode_service_request(
+/* decodes the fileData into the data, or into views of the apdu
+   when file_data is not NULL */
+static int awf_decode(
     uint8_t * apdu,
     unsigned apdu_len,
-    BACNET_ATOMIC_WRITE_FILE_DATA * data)
+    BACNET_ATOMIC_WRITE_FILE_DATA * data,
+    BACNET_OCTET_STRING_VIEW * file_data)
 {
     int len = 0;
     int tag_len = 0;
@@ -136,9 +138,18 @@ int awf_decode_service_request(
             len += tag_len;
             if (tag_number != BACNET_APPLICATION_TAG_OCTET_STRING)
                 return -1;
-            decoded_len =
-                decode_octet_string(&apdu[len], len_value_type,
-                &data->fileData[0]);
+            if ((len + len_value_type) > apdu_len) {
+                return -1;
+            }
+            if (file_data) {
+                decoded_len =
+                    decode_octet_string_view(&apdu[len], len_value_type,
+                    &file_data[0]);
+            } else {
+                decoded_len =
+                    decode_octet_string(&apdu[len], len_value_type,
+                    &data->fileData[0]);
+            }
             if ((uint32_t)decoded_len != len_value_type) {
                 return -1;
             }
@@ -171,6 +182,10 @@ int awf_decode_service_request(
                 decode_unsigned(&apdu[len], len_value_type, &unsigned_value);
             data->type.record.returnedRecordCount = unsigned_value;
             /* fileData */
+            if (data->type.record.returnedRecordCount >
+                BACNET_WRITE_FILE_RECORD_COUNT) {
+                return -1;
+            }
             for (i = 0; i < data->type.record.returnedRecordCount; i++) {
                 tag_len =
                     decode_tag_number_and_value(&apdu[len], &tag_number,
@@ -178,9 +193,18 @@ int awf_decode_service_request(
                 len += tag_len;
                 if (tag_number != BACNET_APPLICATION_TAG_OCTET_STRING)
                     return -1;
-                decoded_len =
-                    decode_octet_string(&apdu[len], len_value_type,
-                    &data->fileData[i]);
+                if ((len + len_value_type) > apdu_len) {
+                    return -1;
+                }
+                if (file_data) {
+                    decoded_len =
+                        decode_octet_string_view(&apdu[len], len_value_type,
+                        &file_data[i]);
+                } else {
+                    decoded_len =
+                        decode_octet_string(&apdu[len], len_value_type,
+                        &data->fileData[i]);
+                }
                 if ((uint32_t)decoded_len != len_value_type) {
                     return -1;
                 }
@@ -197,6 +221,26 @@ int awf_decode_service_request(
     return len;
 }
 
+/* decode the service request only */
+int awf_decode_service_request(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    BACNET_ATOMIC_WRITE_FILE_DATA * data)
+{
+    return awf_decode(apdu, apdu_len, data, NULL);
+}
+
+/* decode the service request only, with the fileData as views that
+   point into the apdu rather than copies in the data */
+int awf_decode_service_request_view(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    BACNET_ATOMIC_WRITE_FILE_DATA * data,
+    BACNET_OCTET_STRING_VIEW file_data[BACNET_WRITE_FILE_RECORD_COUNT])
+{
+    return awf_decode(apdu, apdu_len, data, file_data);
+}
+
 int awf_decode_apdu(
     uint8_t * apdu,
     unsigned apdu_len,
@@ -331,6 +375,7 @@ void testAtomicWriteFileAccess(
     int apdu_len = 0;
     uint8_t invoke_id = 128;
     uint8_t test_invoke_id = 0;
+    BACNET_OCTET_STRING_VIEW file_data[BACNET_WRITE_FILE_RECORD_COUNT];
 
     len = awf_encode_apdu(&apdu[0], invoke_id, data);
     ct_test(pTest, len != 0);
@@ -359,6 +404,23 @@ void testAtomicWriteFileAccess(
     ct_test(pTest, memcmp(octetstring_value(&test_data.fileData[0]),
             octetstring_value(&data->fileData[0]),
             octetstring_length(&test_data.fileData[0])) == 0);
+    /* the views point into the apdu, past the 4 octet header */
+    len =
+        awf_decode_service_request_view(&apdu[4], apdu_len - 4, &test_data,
+        file_data);
+    ct_test(pTest, len == (apdu_len - 4));
+    ct_test(pTest, file_data[0].value > &apdu[4]);
+    ct_test(pTest, file_data[0].value < &apdu[apdu_len]);
+    ct_test(pTest,
+        file_data[0].length == octetstring_length(&data->fileData[0]));
+    ct_test(pTest, memcmp(file_data[0].value,
+            octetstring_value(&data->fileData[0]),
+            file_data[0].length) == 0);
+    /* the data must be in the apdu */
+    len =
+        awf_decode_service_request_view(&apdu[4], apdu_len - 6, &test_data,
+        file_data);
+    ct_test(pTest, len == -1);
 }
 
 void testAtomicWriteFile(
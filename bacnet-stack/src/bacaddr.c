@@ -95,3 +95,37 @@ bool bacnet_address_same(
     }
     return true;
 }
+
+/** Hash of the parts of an address that bacnet_address_same() compares,
+ * so that addresses that are the same have the same hash.
+ * @param src - address to hash
+ * @return 32-bit FNV-1a hash of the address
+ */
+uint32_t bacnet_address_hash(
+    BACNET_ADDRESS * src)
+{
+    uint32_t hash = 2166136261UL;       /* FNV-1a */
+    uint8_t i = 0;
+    uint8_t max_len = 0;
+
+    hash = (hash ^ (src->net & 0xFF)) * 16777619UL;
+    hash = (hash ^ (src->net >> 8)) * 16777619UL;
+    max_len = src->len;
+    if (max_len > MAX_MAC_LEN)
+        max_len = MAX_MAC_LEN;
+    hash = (hash ^ max_len) * 16777619UL;
+    for (i = 0; i < max_len; i++) {
+        hash = (hash ^ src->adr[i]) * 16777619UL;
+    }
+    if (src->net == 0) {
+        max_len = src->mac_len;
+        if (max_len > MAX_MAC_LEN)
+            max_len = MAX_MAC_LEN;
+        hash = (hash ^ max_len) * 16777619UL;
+        for (i = 0; i < max_len; i++) {
+            hash = (hash ^ src->mac[i]) * 16777619UL;
+        }
+    }
+
+    return hash;
+}
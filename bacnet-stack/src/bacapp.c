@@ -54,9 +54,11 @@
 #define snprintf _snprintf
 #endif
 
-int bacapp_encode_application_data(
+/* Encode the value with its application tag.
+   Returns the number of octets encoded, or zero if it does not fit. */
+int bacapp_compact_encode_application_data(
     uint8_t * apdu,
-    BACNET_APPLICATION_DATA_VALUE * value)
+    BACNET_APPLICATION_COMPACT_VALUE * value)
 {
     int apdu_len = 0;   /* total length of the apdu, return value */
 
@@ -102,15 +104,36 @@ int bacapp_encode_application_data(
 #if defined (BACAPP_OCTET_STRING)
             case BACNET_APPLICATION_TAG_OCTET_STRING:
                 apdu_len =
-                    encode_application_octet_string(&apdu[0],
-                    &value->type.Octet_String);
+                    encode_tag(&apdu[0], BACNET_APPLICATION_TAG_OCTET_STRING,
+                    false, value->type.Octet_String.length);
+                if ((apdu_len + value->type.Octet_String.length) < MAX_APDU) {
+                    if (value->type.Octet_String.length) {
+                        memcpy(&apdu[apdu_len], value->type.Octet_String.value,
+                            value->type.Octet_String.length);
+                    }
+                    apdu_len += (int) value->type.Octet_String.length;
+                } else {
+                    apdu_len = 0;
+                }
                 break;
 #endif
 #if defined (BACAPP_CHARACTER_STRING)
             case BACNET_APPLICATION_TAG_CHARACTER_STRING:
                 apdu_len =
-                    encode_application_character_string(&apdu[0],
-                    &value->type.Character_String);
+                    encode_tag(&apdu[0],
+                    BACNET_APPLICATION_TAG_CHARACTER_STRING, false,
+                    value->type.Character_String.length + 1);
+                if ((apdu_len + value->type.Character_String.length + 1) <
+                    MAX_APDU) {
+                    apdu_len +=
+                        (int) encode_bacnet_character_string_safe(&apdu
+                        [apdu_len], MAX_APDU - apdu_len,
+                        value->type.Character_String.encoding,
+                        (char *) value->type.Character_String.value,
+                        value->type.Character_String.length);
+                } else {
+                    apdu_len = 0;
+                }
                 break;
 #endif
 #if defined (BACAPP_BIT_STRING)
@@ -170,6 +193,20 @@ int bacapp_encode_application_data(
     return apdu_len;
 }
 
+int bacapp_encode_application_data(
+    uint8_t * apdu,
+    BACNET_APPLICATION_DATA_VALUE * value)
+{
+    BACNET_APPLICATION_COMPACT_VALUE compact_value;
+
+    if (value == NULL) {
+        return 0;
+    }
+    bacapp_compact_from_value(&compact_value, value);
+
+    return bacapp_compact_encode_application_data(apdu, &compact_value);
+}
+
 /* decode the data and store it into value.
    Return the number of octets consumed. */
 int bacapp_decode_data(
@@ -335,6 +372,155 @@ int bacapp_decode_application_data(
     return len;
 }
 
+/* Decode an application tagged value, with its character or octet
+   string pointing into the apdu rather than copied.
+   Return the number of octets consumed, or BACNET_STATUS_ERROR. */
+int bacapp_compact_decode_application_data(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    BACNET_APPLICATION_COMPACT_VALUE * value)
+{
+    int len = 0;
+    int tag_len = 0;
+    uint8_t tag_number = 0;
+    uint32_t len_value_type = 0;
+
+    if (!apdu || !value || (max_apdu_len == 0) || IS_CONTEXT_SPECIFIC(*apdu)) {
+        return 0;
+    }
+    value->context_specific = false;
+    value->context_tag = 0;
+    value->allocated = false;
+    value->next = NULL;
+    tag_len =
+        decode_tag_number_and_value(&apdu[0], &tag_number, &len_value_type);
+    if ((tag_len == 0) || ((unsigned) tag_len > max_apdu_len)) {
+        return BACNET_STATUS_ERROR;
+    }
+    value->tag = tag_number;
+    /* the boolean value is in the tag, and has no content */
+    if ((tag_number != BACNET_APPLICATION_TAG_BOOLEAN) &&
+        (len_value_type > (max_apdu_len - tag_len))) {
+        return BACNET_STATUS_ERROR;
+    }
+    apdu += tag_len;
+    switch (tag_number) {
+#if defined (BACAPP_NULL)
+        case BACNET_APPLICATION_TAG_NULL:
+            /* nothing else to do */
+            break;
+#endif
+#if defined (BACAPP_BOOLEAN)
+        case BACNET_APPLICATION_TAG_BOOLEAN:
+            value->type.Boolean = decode_boolean(len_value_type);
+            break;
+#endif
+#if defined (BACAPP_UNSIGNED)
+        case BACNET_APPLICATION_TAG_UNSIGNED_INT:
+            len =
+                decode_unsigned(&apdu[0], len_value_type,
+                &value->type.Unsigned_Int);
+            break;
+#endif
+#if defined (BACAPP_SIGNED)
+        case BACNET_APPLICATION_TAG_SIGNED_INT:
+            len =
+                decode_signed(&apdu[0], len_value_type,
+                &value->type.Signed_Int);
+            break;
+#endif
+#if defined (BACAPP_REAL)
+        case BACNET_APPLICATION_TAG_REAL:
+            len =
+                decode_real_safe(&apdu[0], len_value_type,
+                &value->type.Real);
+            break;
+#endif
+#if defined (BACAPP_DOUBLE)
+        case BACNET_APPLICATION_TAG_DOUBLE:
+            len =
+                decode_double_safe(&apdu[0], len_value_type,
+                &value->type.Double);
+            break;
+#endif
+#if defined (BACAPP_OCTET_STRING)
+        case BACNET_APPLICATION_TAG_OCTET_STRING:
+            len =
+                decode_octet_string_view(&apdu[0], len_value_type,
+                &value->type.Octet_String);
+            break;
+#endif
+#if defined (BACAPP_CHARACTER_STRING)
+        case BACNET_APPLICATION_TAG_CHARACTER_STRING:
+            len =
+                decode_character_string_view(&apdu[0], len_value_type,
+                &value->type.Character_String);
+            break;
+#endif
+#if defined (BACAPP_BIT_STRING)
+        case BACNET_APPLICATION_TAG_BIT_STRING:
+            len =
+                decode_bitstring(&apdu[0], len_value_type,
+                &value->type.Bit_String);
+            break;
+#endif
+#if defined (BACAPP_ENUMERATED)
+        case BACNET_APPLICATION_TAG_ENUMERATED:
+            len =
+                decode_enumerated(&apdu[0], len_value_type,
+                &value->type.Enumerated);
+            break;
+#endif
+#if defined (BACAPP_DATE)
+        case BACNET_APPLICATION_TAG_DATE:
+            len =
+                decode_date_safe(&apdu[0], len_value_type, &value->type.Date);
+            break;
+#endif
+#if defined (BACAPP_TIME)
+        case BACNET_APPLICATION_TAG_TIME:
+            len =
+                decode_bacnet_time_safe(&apdu[0], len_value_type,
+                &value->type.Time);
+            break;
+#endif
+#if defined (BACAPP_OBJECT_ID)
+        case BACNET_APPLICATION_TAG_OBJECT_ID:
+            {
+                uint16_t object_type = 0;
+                uint32_t instance = 0;
+                len =
+                    decode_object_id_safe(&apdu[0], len_value_type,
+                    &object_type, &instance);
+                value->type.Object_Id.type = object_type;
+                value->type.Object_Id.instance = instance;
+            }
+            break;
+#endif
+#if defined (BACAPP_LIGHTING_COMMAND)
+        case BACNET_APPLICATION_TAG_LIGHTING_COMMAND:
+            len =
+                lighting_command_decode(&apdu[0], len_value_type,
+                &value->type.Lighting_Command);
+            break;
+#endif
+        default:
+            value->tag = MAX_BACNET_APPLICATION_TAG;
+            break;
+    }
+    if ((len == 0) && (tag_number != BACNET_APPLICATION_TAG_NULL) &&
+        (tag_number != BACNET_APPLICATION_TAG_BOOLEAN) &&
+        (tag_number != BACNET_APPLICATION_TAG_OCTET_STRING)) {
+        /* indicate that we were not able to decode the value */
+        value->tag = MAX_BACNET_APPLICATION_TAG;
+    }
+    if (value->tag == MAX_BACNET_APPLICATION_TAG) {
+        return BACNET_STATUS_ERROR;
+    }
+
+    return tag_len + len;
+}
+
 /*
 ** Usage: Similar to strtok. Call function the first time with new_apdu and new_adu_len set to apdu buffer
 ** to be processed. Subsequent calls should pass in NULL.
@@ -940,6 +1126,296 @@ bool bacapp_copy(
     return status;
 }
 
+/* Copy a compact value.  The strings are allocated, so that the copy
+   does not depend on the APDU it was decoded from. */
+bool bacapp_compact_copy(
+    BACNET_APPLICATION_COMPACT_VALUE * dest_value,
+    BACNET_APPLICATION_COMPACT_VALUE * src_value)
+{
+    bool status = true; /*return value */
+    uint8_t *data = NULL;
+    uint32_t length = 0;
+
+    if (dest_value && src_value) {
+        *dest_value = *src_value;
+        dest_value->allocated = false;
+        switch (src_value->tag) {
+#if defined (BACAPP_OCTET_STRING)
+            case BACNET_APPLICATION_TAG_OCTET_STRING:
+                length = src_value->type.Octet_String.length;
+                if (length) {
+                    data = malloc(length);
+                    if (data) {
+                        memcpy(data, src_value->type.Octet_String.value,
+                            length);
+                        dest_value->allocated = true;
+                    } else {
+                        dest_value->type.Octet_String.length = 0;
+                        status = false;
+                    }
+                }
+                dest_value->type.Octet_String.value = data;
+                break;
+#endif
+#if defined (BACAPP_CHARACTER_STRING)
+            case BACNET_APPLICATION_TAG_CHARACTER_STRING:
+                length = src_value->type.Character_String.length;
+                if (length) {
+                    data = malloc(length);
+                    if (data) {
+                        memcpy(data, src_value->type.Character_String.value,
+                            length);
+                        dest_value->allocated = true;
+                    } else {
+                        dest_value->type.Character_String.length = 0;
+                        status = false;
+                    }
+                }
+                dest_value->type.Character_String.value = (char *) data;
+                break;
+#endif
+            default:
+                if (src_value->tag >= MAX_BACNET_APPLICATION_TAG) {
+                    status = false;
+                }
+                break;
+        }
+    }
+
+    return status;
+}
+
+/* Release the strings of a value copied by bacapp_compact_copy */
+void bacapp_compact_free(
+    BACNET_APPLICATION_COMPACT_VALUE * value)
+{
+    if (value && value->allocated) {
+        switch (value->tag) {
+#if defined (BACAPP_OCTET_STRING)
+            case BACNET_APPLICATION_TAG_OCTET_STRING:
+                free((void *) value->type.Octet_String.value);
+                value->type.Octet_String.value = NULL;
+                value->type.Octet_String.length = 0;
+                break;
+#endif
+#if defined (BACAPP_CHARACTER_STRING)
+            case BACNET_APPLICATION_TAG_CHARACTER_STRING:
+                free((void *) value->type.Character_String.value);
+                value->type.Character_String.value = NULL;
+                value->type.Character_String.length = 0;
+                break;
+#endif
+            default:
+                break;
+        }
+        value->allocated = false;
+    }
+}
+
+/* Make a compact value from a value, pointing to its strings,
+   so it is only valid while the source value is */
+void bacapp_compact_from_value(
+    BACNET_APPLICATION_COMPACT_VALUE * dest_value,
+    BACNET_APPLICATION_DATA_VALUE * src_value)
+{
+    if (!dest_value || !src_value) {
+        return;
+    }
+    dest_value->context_specific = src_value->context_specific;
+    dest_value->context_tag = src_value->context_tag;
+    dest_value->tag = src_value->tag;
+    dest_value->allocated = false;
+    dest_value->next = NULL;
+    switch (src_value->tag) {
+#if defined (BACAPP_BOOLEAN)
+        case BACNET_APPLICATION_TAG_BOOLEAN:
+            dest_value->type.Boolean = src_value->type.Boolean;
+            break;
+#endif
+#if defined (BACAPP_UNSIGNED)
+        case BACNET_APPLICATION_TAG_UNSIGNED_INT:
+            dest_value->type.Unsigned_Int = src_value->type.Unsigned_Int;
+            break;
+#endif
+#if defined (BACAPP_SIGNED)
+        case BACNET_APPLICATION_TAG_SIGNED_INT:
+            dest_value->type.Signed_Int = src_value->type.Signed_Int;
+            break;
+#endif
+#if defined (BACAPP_REAL)
+        case BACNET_APPLICATION_TAG_REAL:
+            dest_value->type.Real = src_value->type.Real;
+            break;
+#endif
+#if defined (BACAPP_DOUBLE)
+        case BACNET_APPLICATION_TAG_DOUBLE:
+            dest_value->type.Double = src_value->type.Double;
+            break;
+#endif
+#if defined (BACAPP_OCTET_STRING)
+        case BACNET_APPLICATION_TAG_OCTET_STRING:
+            octetstring_view_from(&dest_value->type.Octet_String,
+                &src_value->type.Octet_String);
+            break;
+#endif
+#if defined (BACAPP_CHARACTER_STRING)
+        case BACNET_APPLICATION_TAG_CHARACTER_STRING:
+            characterstring_view_from(&dest_value->type.Character_String,
+                &src_value->type.Character_String);
+            break;
+#endif
+#if defined (BACAPP_BIT_STRING)
+        case BACNET_APPLICATION_TAG_BIT_STRING:
+            bitstring_copy(&dest_value->type.Bit_String,
+                &src_value->type.Bit_String);
+            break;
+#endif
+#if defined (BACAPP_ENUMERATED)
+        case BACNET_APPLICATION_TAG_ENUMERATED:
+            dest_value->type.Enumerated = src_value->type.Enumerated;
+            break;
+#endif
+#if defined (BACAPP_DATE)
+        case BACNET_APPLICATION_TAG_DATE:
+            datetime_copy_date(&dest_value->type.Date,
+                &src_value->type.Date);
+            break;
+#endif
+#if defined (BACAPP_TIME)
+        case BACNET_APPLICATION_TAG_TIME:
+            datetime_copy_time(&dest_value->type.Time,
+                &src_value->type.Time);
+            break;
+#endif
+#if defined (BACAPP_OBJECT_ID)
+        case BACNET_APPLICATION_TAG_OBJECT_ID:
+            dest_value->type.Object_Id = src_value->type.Object_Id;
+            break;
+#endif
+#if defined (BACAPP_LIGHTING_COMMAND)
+        case BACNET_APPLICATION_TAG_LIGHTING_COMMAND:
+            dest_value->type.Lighting_Command =
+                src_value->type.Lighting_Command;
+            break;
+#endif
+#if defined (BACAPP_DEVICE_OBJECT_PROP_REF)
+        case BACNET_APPLICATION_TAG_DEVICE_OBJECT_PROPERTY_REFERENCE:
+            dest_value->type.Device_Object_Property_Reference =
+                src_value->type.Device_Object_Property_Reference;
+            break;
+#endif
+        default:
+            break;
+    }
+}
+
+/* Copy a compact value into a value, including its strings.
+   Returns false if a string is too long for the value. */
+bool bacapp_compact_to_value(
+    BACNET_APPLICATION_DATA_VALUE * dest_value,
+    BACNET_APPLICATION_COMPACT_VALUE * src_value)
+{
+    bool status = true; /*return value */
+
+    if (!dest_value || !src_value) {
+        return false;
+    }
+    dest_value->context_specific = src_value->context_specific;
+    dest_value->context_tag = src_value->context_tag;
+    dest_value->tag = src_value->tag;
+    dest_value->next = NULL;
+    switch (src_value->tag) {
+#if defined (BACAPP_NULL)
+        case BACNET_APPLICATION_TAG_NULL:
+            break;
+#endif
+#if defined (BACAPP_BOOLEAN)
+        case BACNET_APPLICATION_TAG_BOOLEAN:
+            dest_value->type.Boolean = src_value->type.Boolean;
+            break;
+#endif
+#if defined (BACAPP_UNSIGNED)
+        case BACNET_APPLICATION_TAG_UNSIGNED_INT:
+            dest_value->type.Unsigned_Int = src_value->type.Unsigned_Int;
+            break;
+#endif
+#if defined (BACAPP_SIGNED)
+        case BACNET_APPLICATION_TAG_SIGNED_INT:
+            dest_value->type.Signed_Int = src_value->type.Signed_Int;
+            break;
+#endif
+#if defined (BACAPP_REAL)
+        case BACNET_APPLICATION_TAG_REAL:
+            dest_value->type.Real = src_value->type.Real;
+            break;
+#endif
+#if defined (BACAPP_DOUBLE)
+        case BACNET_APPLICATION_TAG_DOUBLE:
+            dest_value->type.Double = src_value->type.Double;
+            break;
+#endif
+#if defined (BACAPP_OCTET_STRING)
+        case BACNET_APPLICATION_TAG_OCTET_STRING:
+            status =
+                octetstring_view_copy(&dest_value->type.Octet_String,
+                &src_value->type.Octet_String);
+            break;
+#endif
+#if defined (BACAPP_CHARACTER_STRING)
+        case BACNET_APPLICATION_TAG_CHARACTER_STRING:
+            status =
+                characterstring_view_copy(&dest_value->type.Character_String,
+                &src_value->type.Character_String);
+            break;
+#endif
+#if defined (BACAPP_BIT_STRING)
+        case BACNET_APPLICATION_TAG_BIT_STRING:
+            bitstring_copy(&dest_value->type.Bit_String,
+                &src_value->type.Bit_String);
+            break;
+#endif
+#if defined (BACAPP_ENUMERATED)
+        case BACNET_APPLICATION_TAG_ENUMERATED:
+            dest_value->type.Enumerated = src_value->type.Enumerated;
+            break;
+#endif
+#if defined (BACAPP_DATE)
+        case BACNET_APPLICATION_TAG_DATE:
+            datetime_copy_date(&dest_value->type.Date,
+                &src_value->type.Date);
+            break;
+#endif
+#if defined (BACAPP_TIME)
+        case BACNET_APPLICATION_TAG_TIME:
+            datetime_copy_time(&dest_value->type.Time,
+                &src_value->type.Time);
+            break;
+#endif
+#if defined (BACAPP_OBJECT_ID)
+        case BACNET_APPLICATION_TAG_OBJECT_ID:
+            dest_value->type.Object_Id = src_value->type.Object_Id;
+            break;
+#endif
+#if defined (BACAPP_LIGHTING_COMMAND)
+        case BACNET_APPLICATION_TAG_LIGHTING_COMMAND:
+            dest_value->type.Lighting_Command =
+                src_value->type.Lighting_Command;
+            break;
+#endif
+#if defined (BACAPP_DEVICE_OBJECT_PROP_REF)
+        case BACNET_APPLICATION_TAG_DEVICE_OBJECT_PROPERTY_REFERENCE:
+            dest_value->type.Device_Object_Property_Reference =
+                src_value->type.Device_Object_Property_Reference;
+            break;
+#endif
+        default:
+            status = false;
+            break;
+    }
+
+    return status;
+}
+
 /* returns the length of data between an opening tag and a closing tag.
    Expects that the first octet contain the opening tag.
    Include a value property identifier for context specific data
@@ -1032,34 +1508,32 @@ static bool append_str(
     return retval;
 }
 
-/* Extract the value into a string
+/* Extract the compact value into a string
  *  Inputs:  str - the buffer to store the extracted value.
  *           str_len - the size of the buffer
- *           object_value - ptr to BACnet object value from which to extract str
+ *           object_type - type of the object that has the property
+ *           property - property of the value, for naming enumerations
+ *           value - ptr to BACnet value from which to extract str
  *  Return:  number of bytes (excluding terminating NULL byte) that were stored
  *           to the output string. If output was truncated due to string size,
  *           then the returned value is greater than str_len (a la snprintf() ).
  */
-int bacapp_snprintf_value(
+int bacapp_compact_snprintf_value(
     char *str,
     size_t str_len,
-    BACNET_OBJECT_PROPERTY_VALUE * object_value)
+    BACNET_OBJECT_TYPE object_type,
+    BACNET_PROPERTY_ID property,
+    BACNET_APPLICATION_COMPACT_VALUE * value)
 {
     size_t len = 0, i = 0;
-    char *char_str;
-    uint8_t *octet_str;
-    BACNET_APPLICATION_DATA_VALUE *value;
-    BACNET_PROPERTY_ID property = PROP_ALL;
-    BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
+    const char *char_str;
+    const uint8_t *octet_str;
     int ret_val = -1;
     char *p_str = str;
     size_t rem_str_len = str_len;
     char temp_str[32];
 
-    if (object_value && object_value->value) {
-        value = object_value->value;
-        property = object_value->object_property;
-        object_type = object_value->object_type;
+    if (value) {
         switch (value->tag) {
             case BACNET_APPLICATION_TAG_NULL:
                 ret_val = snprintf(str, str_len, "Null");
@@ -1089,8 +1563,8 @@ int bacapp_snprintf_value(
                 break;
 #endif
             case BACNET_APPLICATION_TAG_OCTET_STRING:
-                len = octetstring_length(&value->type.Octet_String);
-                octet_str = octetstring_value(&value->type.Octet_String);
+                len = value->type.Octet_String.length;
+                octet_str = value->type.Octet_String.value;
                 for (i = 0; i < len; i++) {
                     snprintf(temp_str, sizeof(temp_str), "%02X", *octet_str);
                     if (!append_str(&p_str, &rem_str_len, temp_str))
@@ -1103,9 +1577,8 @@ int bacapp_snprintf_value(
                 }
                 break;
             case BACNET_APPLICATION_TAG_CHARACTER_STRING:
-                len = characterstring_length(&value->type.Character_String);
-                char_str =
-                    characterstring_value(&value->type.Character_String);
+                len = value->type.Character_String.length;
+                char_str = value->type.Character_String.value;
                 if (!append_str(&p_str, &rem_str_len, "\""))
                     break;
                 for (i = 0; i < len; i++) {
@@ -1150,7 +1623,7 @@ int bacapp_snprintf_value(
             case BACNET_APPLICATION_TAG_ENUMERATED:
                 switch (property) {
                     case PROP_PROPERTY_LIST:
-                        char_str = (char *) bactext_property_name_default(
+                        char_str = bactext_property_name_default(
                             value->type.Enumerated, NULL);
                         if (char_str) {
                             ret_val = snprintf(str, str_len, "%s", char_str);
@@ -1383,6 +1856,31 @@ int bacapp_snprintf_value(
 
     return ret_val;
 }
+
+/* Extract the value into a string
+ *  Inputs:  str - the buffer to store the extracted value.
+ *           str_len - the size of the buffer
+ *           object_value - ptr to BACnet object value from which to extract str
+ *  Return:  number of bytes (excluding terminating NULL byte) that were stored
+ *           to the output string. If output was truncated due to string size,
+ *           then the returned value is greater than str_len (a la snprintf() ).
+ */
+int bacapp_snprintf_value(
+    char *str,
+    size_t str_len,
+    BACNET_OBJECT_PROPERTY_VALUE * object_value)
+{
+    BACNET_APPLICATION_COMPACT_VALUE value;
+
+    if (!object_value || !object_value->value) {
+        return -1;
+    }
+    /* the strings are printed from the object value, without a copy */
+    bacapp_compact_from_value(&value, object_value->value);
+
+    return bacapp_compact_snprintf_value(str, str_len,
+        object_value->object_type, object_value->object_property, &value);
+}
 #endif /* BACAPP_SNPRINTF_ENABLED */
 
 #ifdef BACAPP_PRINT_ENABLED
@@ -2214,6 +2712,102 @@ void testBACnetApplicationData(
 }
 
 
+void testBACnetApplicationCompactValue(
+    Test * pTest)
+{
+    static const struct {
+        BACNET_APPLICATION_TAG tag;
+        const char *text;
+    } samples[] = {
+        {BACNET_APPLICATION_TAG_NULL, NULL},
+        {BACNET_APPLICATION_TAG_BOOLEAN, "1"},
+        {BACNET_APPLICATION_TAG_UNSIGNED_INT, "0xFFFF"},
+        {BACNET_APPLICATION_TAG_SIGNED_INT, "-42"},
+        {BACNET_APPLICATION_TAG_REAL, "72.5"},
+        {BACNET_APPLICATION_TAG_DOUBLE, "-1.0e10"},
+        {BACNET_APPLICATION_TAG_OCTET_STRING, "\x12\x34\xAB\xCD\xEF"},
+        {BACNET_APPLICATION_TAG_OCTET_STRING, ""},
+        {BACNET_APPLICATION_TAG_CHARACTER_STRING, "Zone Temperature"},
+        {BACNET_APPLICATION_TAG_CHARACTER_STRING, ""},
+        {BACNET_APPLICATION_TAG_BIT_STRING, "1011"},
+        {BACNET_APPLICATION_TAG_ENUMERATED, "2"},
+        {BACNET_APPLICATION_TAG_DATE, "2016/9/30:5"},
+        {BACNET_APPLICATION_TAG_TIME, "23:59:59.12"},
+        {BACNET_APPLICATION_TAG_OBJECT_ID, "8:4194303"}
+    };
+    BACNET_APPLICATION_DATA_VALUE value, test_value;
+    BACNET_APPLICATION_COMPACT_VALUE compact_value, copy_value;
+    BACNET_OBJECT_PROPERTY_VALUE object_value;
+    uint8_t apdu[MAX_APDU] = { 0 };
+    uint8_t test_apdu[MAX_APDU] = { 0 };
+    char str[64] = "", test_str[64] = "";
+    int apdu_len = 0, test_len = 0, len = 0;
+    unsigned i = 0;
+    bool status = false;
+
+    ct_test(pTest, sizeof(compact_value) < 64);
+    for (i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        if (samples[i].tag == BACNET_APPLICATION_TAG_OCTET_STRING) {
+            value.tag = samples[i].tag;
+            status =
+                octetstring_init(&value.type.Octet_String,
+                (uint8_t *) samples[i].text, strlen(samples[i].text));
+        } else {
+            status =
+                bacapp_parse_application_data(samples[i].tag,
+                samples[i].text, &value);
+        }
+        ct_test(pTest, status);
+        apdu_len = bacapp_encode_application_data(&apdu[0], &value);
+        ct_test(pTest, apdu_len > 0);
+        /* decoded, the strings point into the APDU */
+        len =
+            bacapp_compact_decode_application_data(&apdu[0], apdu_len,
+            &compact_value);
+        ct_test(pTest, len == apdu_len);
+        ct_test(pTest, compact_value.tag == samples[i].tag);
+        ct_test(pTest, !compact_value.allocated);
+        status = bacapp_compact_to_value(&test_value, &compact_value);
+        ct_test(pTest, status);
+        ct_test(pTest, bacapp_same_value(&value, &test_value));
+        /* a truncated APDU is not decoded */
+        if (apdu_len > 1) {
+            len =
+                bacapp_compact_decode_application_data(&apdu[0],
+                apdu_len - 1, &copy_value);
+            ct_test(pTest, len == BACNET_STATUS_ERROR);
+        }
+        /* the copy does not depend on the APDU */
+        status = bacapp_compact_copy(&copy_value, &compact_value);
+        ct_test(pTest, status);
+        memset(apdu, 0, sizeof(apdu));
+        test_len =
+            bacapp_compact_encode_application_data(&test_apdu[0],
+            &copy_value);
+        apdu_len = bacapp_encode_application_data(&apdu[0], &value);
+        ct_test(pTest, test_len == apdu_len);
+        ct_test(pTest, memcmp(apdu, test_apdu, apdu_len) == 0);
+        /* printing either value gives the same text */
+        object_value.object_type = OBJECT_ANALOG_VALUE;
+        object_value.object_instance = 1;
+        object_value.object_property = PROP_PRESENT_VALUE;
+        object_value.array_index = BACNET_ARRAY_ALL;
+        object_value.value = &value;
+        len = bacapp_snprintf_value(str, sizeof(str), &object_value);
+        test_len =
+            bacapp_compact_snprintf_value(test_str, sizeof(test_str),
+            OBJECT_ANALOG_VALUE, PROP_PRESENT_VALUE, &copy_value);
+        ct_test(pTest, len == test_len);
+        ct_test(pTest, strcmp(str, test_str) == 0);
+        bacapp_compact_free(&copy_value);
+        ct_test(pTest, !copy_value.allocated);
+    }
+    /* context tagged data is not application data */
+    apdu[0] = 0x09;
+    len = bacapp_compact_decode_application_data(&apdu[0], 2, &compact_value);
+    ct_test(pTest, len == 0);
+}
+
 #ifdef TEST_BACNET_APPLICATION_DATA
 int main(
     void)
@@ -2229,6 +2823,8 @@ int main(
     assert(rc);
     rc = ct_addTestFunction(pTest, testBACnetApplicationData_Safe);
     assert(rc);
+    rc = ct_addTestFunction(pTest, testBACnetApplicationCompactValue);
+    assert(rc);
 
     ct_setStream(pTest, stdout);
     ct_run(pTest);
@@ -2238,4 +2834,185 @@ int main(
     return 0;
 }
 #endif /* TEST_BACNET_APPLICATION_DATA */
+
+#ifdef TEST_BACAPP_BENCH
+#include <time.h>
+
+#define BENCH_VALUES 200
+#define BENCH_ACKS 5000
+
+/* Decode an ACK of BENCH_VALUES property values into a list of
+   BACNET_APPLICATION_DATA_VALUE, one calloc per value as h_rpm_a.c
+   does, and into a list of BACNET_APPLICATION_COMPACT_VALUE, then
+   encode the values again and free the lists. */
+int main(
+    void)
+{
+    static uint8_t ack[BENCH_VALUES * 32];
+    static uint8_t apdu[BENCH_VALUES * 32];
+    BACNET_APPLICATION_DATA_VALUE value;
+    BACNET_APPLICATION_DATA_VALUE *list, *next, **tail;
+    BACNET_APPLICATION_COMPACT_VALUE *compact_list, *compact_next;
+    BACNET_APPLICATION_COMPACT_VALUE **compact_tail;
+    int ack_len = 0, len = 0, apdu_len = 0;
+    unsigned i, n;
+    unsigned long checksum = 0;
+    clock_t start;
+    double decode_ns, encode_ns, compact_decode_ns, compact_encode_ns;
+
+    for (i = 0; i < BENCH_VALUES; i++) {
+        switch (i % 5) {
+            case 0:
+                value.tag = BACNET_APPLICATION_TAG_REAL;
+                value.type.Real = 20.0f + (float) i;
+                break;
+            case 1:
+                value.tag = BACNET_APPLICATION_TAG_ENUMERATED;
+                value.type.Enumerated = i % 3;
+                break;
+            case 2:
+                value.tag = BACNET_APPLICATION_TAG_UNSIGNED_INT;
+                value.type.Unsigned_Int = i * 1000;
+                break;
+            case 3:
+                value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
+                bitstring_init(&value.type.Bit_String);
+                bitstring_set_bit(&value.type.Bit_String, 3, true);
+                break;
+            default:
+                value.tag = BACNET_APPLICATION_TAG_CHARACTER_STRING;
+                characterstring_init_ansi(&value.type.Character_String,
+                    "AHU-1 Zone Temperature");
+                break;
+        }
+        ack_len += bacapp_encode_application_data(&ack[ack_len], &value);
+    }
+
+    start = clock();
+    for (n = 0; n < BENCH_ACKS; n++) {
+        list = NULL;
+        tail = &list;
+        for (len = 0; len < ack_len;) {
+            next = calloc(1, sizeof(BACNET_APPLICATION_DATA_VALUE));
+            len +=
+                bacapp_decode_application_data(&ack[len], ack_len - len,
+                next);
+            *tail = next;
+            tail = &next->next;
+        }
+        apdu_len = 0;
+        for (next = list; next; next = next->next) {
+            apdu_len += bacapp_encode_application_data(&apdu[apdu_len], next);
+        }
+        checksum += apdu_len;
+        while (list) {
+            next = list->next;
+            free(list);
+            list = next;
+        }
+    }
+    decode_ns =
+        ((double) (clock() - start) * 1e9) / CLOCKS_PER_SEC / BENCH_ACKS /
+        BENCH_VALUES;
+    /* the encode alone, from one decoded list */
+    list = NULL;
+    tail = &list;
+    for (len = 0; len < ack_len;) {
+        next = calloc(1, sizeof(BACNET_APPLICATION_DATA_VALUE));
+        len += bacapp_decode_application_data(&ack[len], ack_len - len, next);
+        *tail = next;
+        tail = &next->next;
+    }
+    start = clock();
+    for (n = 0; n < BENCH_ACKS; n++) {
+        apdu_len = 0;
+        for (next = list; next; next = next->next) {
+            apdu_len += bacapp_encode_application_data(&apdu[apdu_len], next);
+        }
+        checksum += apdu_len;
+    }
+    encode_ns =
+        ((double) (clock() - start) * 1e9) / CLOCKS_PER_SEC / BENCH_ACKS /
+        BENCH_VALUES;
+    while (list) {
+        next = list->next;
+        free(list);
+        list = next;
+    }
+
+    start = clock();
+    for (n = 0; n < BENCH_ACKS; n++) {
+        compact_list = NULL;
+        compact_tail = &compact_list;
+        for (len = 0; len < ack_len;) {
+            compact_next = calloc(1, sizeof(BACNET_APPLICATION_COMPACT_VALUE));
+            len +=
+                bacapp_compact_decode_application_data(&ack[len],
+                ack_len - len, compact_next);
+            *compact_tail = compact_next;
+            compact_tail = &compact_next->next;
+        }
+        apdu_len = 0;
+        for (compact_next = compact_list; compact_next;
+            compact_next = compact_next->next) {
+            apdu_len +=
+                bacapp_compact_encode_application_data(&apdu[apdu_len],
+                compact_next);
+        }
+        checksum += apdu_len;
+        while (compact_list) {
+            compact_next = compact_list->next;
+            free(compact_list);
+            compact_list = compact_next;
+        }
+    }
+    compact_decode_ns =
+        ((double) (clock() - start) * 1e9) / CLOCKS_PER_SEC / BENCH_ACKS /
+        BENCH_VALUES;
+    compact_list = NULL;
+    compact_tail = &compact_list;
+    for (len = 0; len < ack_len;) {
+        compact_next = calloc(1, sizeof(BACNET_APPLICATION_COMPACT_VALUE));
+        len +=
+            bacapp_compact_decode_application_data(&ack[len], ack_len - len,
+            compact_next);
+        *compact_tail = compact_next;
+        compact_tail = &compact_next->next;
+    }
+    start = clock();
+    for (n = 0; n < BENCH_ACKS; n++) {
+        apdu_len = 0;
+        for (compact_next = compact_list; compact_next;
+            compact_next = compact_next->next) {
+            apdu_len +=
+                bacapp_compact_encode_application_data(&apdu[apdu_len],
+                compact_next);
+        }
+        checksum += apdu_len;
+    }
+    compact_encode_ns =
+        ((double) (clock() - start) * 1e9) / CLOCKS_PER_SEC / BENCH_ACKS /
+        BENCH_VALUES;
+    while (compact_list) {
+        compact_next = compact_list->next;
+        free(compact_list);
+        compact_list = compact_next;
+    }
+
+    printf("%u values, %d octets per ACK, %u ACKs (checksum %lu)\n",
+        BENCH_VALUES, ack_len, BENCH_ACKS, checksum);
+    printf("value type        bytes/value  bytes/ACK  "
+        "decode+encode ns/value  encode ns/value\n");
+    printf("DATA_VALUE      %13lu  %9lu  %22.1f  %15.1f\n",
+        (unsigned long) sizeof(BACNET_APPLICATION_DATA_VALUE),
+        (unsigned long) sizeof(BACNET_APPLICATION_DATA_VALUE) * BENCH_VALUES,
+        decode_ns, encode_ns);
+    printf("COMPACT_VALUE   %13lu  %9lu  %22.1f  %15.1f\n",
+        (unsigned long) sizeof(BACNET_APPLICATION_COMPACT_VALUE),
+        (unsigned long) sizeof(BACNET_APPLICATION_COMPACT_VALUE) *
+        BENCH_VALUES, compact_decode_ns, compact_encode_ns);
+
+    return 0;
+}
+#endif /* TEST_BACAPP_BENCH */
 #endif /* TEST */
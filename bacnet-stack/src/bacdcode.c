@@ -988,6 +988,38 @@ int decode_context_octet_string(
 
     return len;
 }
+
+/* decodes without copying - the view points into the apdu,
+   and is only valid as long as the apdu is */
+int decode_octet_string_view(
+    uint8_t * apdu,
+    uint32_t len_value,
+    BACNET_OCTET_STRING_VIEW * view)
+{
+    octetstring_view_init(view, &apdu[0], len_value);
+
+    return (int) len_value;
+}
+
+int decode_context_octet_string_view(
+    uint8_t * apdu,
+    uint8_t tag_number,
+    BACNET_OCTET_STRING_VIEW * view)
+{
+    int len = 0;        /* return value */
+    uint32_t len_value = 0;
+
+    if (decode_is_context_tag(&apdu[len], tag_number) &&
+        !decode_is_closing_tag(&apdu[len])) {
+        len +=
+            decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+        len += decode_octet_string_view(&apdu[len], len_value, view);
+    } else {
+        len = BACNET_STATUS_ERROR;
+    }
+
+    return len;
+}
 #endif
 
 /* from clause 20.2.9 Encoding of a Character String Value */
@@ -1117,6 +1149,52 @@ int decode_context_character_string(
     return len;
 }
 
+/* decodes without copying - the view points into the apdu,
+   and is only valid as long as the apdu is.
+   returns zero if there is no character set octet */
+int decode_character_string_view(
+    uint8_t * apdu,
+    uint32_t len_value,
+    BACNET_CHARACTER_STRING_VIEW * view)
+{
+    int len = 0;        /* return value */
+
+    if (len_value > 0) {
+        characterstring_view_init(view, apdu[0], (char *) &apdu[1],
+            len_value - 1);
+        len = (int) len_value;
+    }
+
+    return len;
+}
+
+int decode_context_character_string_view(
+    uint8_t * apdu,
+    uint8_t tag_number,
+    BACNET_CHARACTER_STRING_VIEW * view)
+{
+    int len = 0;        /* return value */
+    int decoded_len = 0;
+    uint32_t len_value = 0;
+
+    if (decode_is_context_tag(&apdu[len], tag_number) &&
+        !decode_is_closing_tag(&apdu[len])) {
+        len +=
+            decode_tag_number_and_value(&apdu[len], &tag_number, &len_value);
+        decoded_len = decode_character_string_view(&apdu[len], len_value,
+            view);
+        if (decoded_len > 0) {
+            len += decoded_len;
+        } else {
+            len = BACNET_STATUS_ERROR;
+        }
+    } else {
+        len = BACNET_STATUS_ERROR;
+    }
+
+    return len;
+}
+
 /* from clause 20.2.4 Encoding of an Unsigned Integer Value */
 /* and 20.2.1 General Rules for Encoding BACnet Tags */
 /* returns the number of apdu bytes consumed */
@@ -2396,6 +2474,61 @@ static void testBACDCodeCharacterString(
     return;
 }
 
+static void testBACDCodeStringViews(
+    Test * pTest)
+{
+    uint8_t apdu[MAX_APDU] = { 0 };
+    BACNET_CHARACTER_STRING char_string;
+    BACNET_CHARACTER_STRING_VIEW char_view;
+    BACNET_OCTET_STRING octet_string;
+    BACNET_OCTET_STRING_VIEW octet_view;
+    uint8_t test_value[4] = { 0xDE, 0xAD, 0xBE, 0xEF };
+    int apdu_len;
+    int len;
+    uint8_t tag_number = 0;
+    uint32_t len_value = 0;
+
+    /* the views point into the apdu */
+    characterstring_init_ansi(&char_string, "Joshua");
+    apdu_len = encode_application_character_string(&apdu[0], &char_string);
+    len = decode_tag_number_and_value(&apdu[0], &tag_number, &len_value);
+    /* after the tag and the character set */
+    ct_test(pTest, decode_character_string_view(&apdu[len], len_value,
+            &char_view) == (int) len_value);
+    ct_test(pTest, char_view.value == (char *) &apdu[len + 1]);
+    len += len_value;
+    ct_test(pTest, apdu_len == len);
+    ct_test(pTest, characterstring_view_same(&char_view, &char_string));
+    /* no character set octet */
+    len = decode_character_string_view(&apdu[0], 0, &char_view);
+    ct_test(pTest, len == 0);
+    apdu_len =
+        encode_context_character_string(&apdu[0], 3, &char_string);
+    len = decode_context_character_string_view(&apdu[0], 3, &char_view);
+    ct_test(pTest, apdu_len == len);
+    ct_test(pTest, characterstring_view_same(&char_view, &char_string));
+    len = decode_context_character_string_view(&apdu[0], 4, &char_view);
+    ct_test(pTest, len == BACNET_STATUS_ERROR);
+
+    octetstring_init(&octet_string, test_value, sizeof(test_value));
+    apdu_len = encode_application_octet_string(&apdu[0], &octet_string);
+    len = decode_tag_number_and_value(&apdu[0], &tag_number, &len_value);
+    ct_test(pTest, decode_octet_string_view(&apdu[len], len_value,
+            &octet_view) == (int) len_value);
+    ct_test(pTest, octet_view.value == &apdu[len]);
+    len += len_value;
+    ct_test(pTest, apdu_len == len);
+    ct_test(pTest, octet_view.length == sizeof(test_value));
+    ct_test(pTest, memcmp(octet_view.value, test_value,
+            sizeof(test_value)) == 0);
+    apdu_len = encode_context_octet_string(&apdu[0], 9, &octet_string);
+    len = decode_context_octet_string_view(&apdu[0], 9, &octet_view);
+    ct_test(pTest, apdu_len == len);
+    ct_test(pTest, octet_view.length == sizeof(test_value));
+    len = decode_context_octet_string_view(&apdu[0], 8, &octet_view);
+    ct_test(pTest, len == BACNET_STATUS_ERROR);
+}
+
 static void testBACDCodeObject(
     Test * pTest)
 {
@@ -3170,6 +3303,8 @@ void test_BACDCode(
     assert(rc);
     rc = ct_addTestFunction(pTest, testOctetStringContextDecodes);
     assert(rc);
+    rc = ct_addTestFunction(pTest, testBACDCodeStringViews);
+    assert(rc);
     rc = ct_addTestFunction(pTest, testBACDCodeDouble);
     assert(rc);
 }
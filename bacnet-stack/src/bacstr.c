@@ -34,7 +34,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
-#include <string.h>     /* for strlen */
+#include <string.h>     /* for strlen, memcmp */
 #include "config.h"
 #include "bacstr.h"
 #include "bits.h"
@@ -685,6 +685,84 @@ bool characterstring_valid(
     return valid;
 }
 
+void characterstring_view_init(
+    BACNET_CHARACTER_STRING_VIEW * view,
+    uint8_t encoding,
+    const char *value,
+    size_t length)
+{
+    if (view) {
+        view->encoding = encoding;
+        if (value) {
+            view->value = value;
+            view->length = (uint32_t) length;
+        } else {
+            view->value = NULL;
+            view->length = 0;
+        }
+    }
+}
+
+/* the view is only valid while the char_string is */
+void characterstring_view_from(
+    BACNET_CHARACTER_STRING_VIEW * view,
+    BACNET_CHARACTER_STRING * char_string)
+{
+    if (view && char_string) {
+        view->value = char_string->value;
+        view->length = (uint32_t) char_string->length;
+        view->encoding = char_string->encoding;
+    }
+}
+
+/* returns false if the view exceeds the capacity of the string */
+bool characterstring_view_copy(
+    BACNET_CHARACTER_STRING * dest,
+    const BACNET_CHARACTER_STRING_VIEW * src)
+{
+    if (dest && src) {
+        return characterstring_init(dest, src->encoding, src->value,
+            src->length);
+    }
+
+    return false;
+}
+
+bool characterstring_view_same(
+    const BACNET_CHARACTER_STRING_VIEW * view,
+    BACNET_CHARACTER_STRING * char_string)
+{
+    BACNET_CHARACTER_STRING_VIEW view2;
+
+    if (char_string) {
+        characterstring_view_from(&view2, char_string);
+        return characterstring_view_same_view(view, &view2);
+    }
+
+    return characterstring_view_same_view(view, NULL);
+}
+
+bool characterstring_view_same_view(
+    const BACNET_CHARACTER_STRING_VIEW * view1,
+    const BACNET_CHARACTER_STRING_VIEW * view2)
+{
+    bool same_status = false;
+
+    if (view1 && view2) {
+        if ((view1->length == view2->length) &&
+            (view1->encoding == view2->encoding)) {
+            same_status = (view1->length == 0) ||
+                (memcmp(view1->value, view2->value, view1->length) == 0);
+        }
+    } else if (view1) {
+        same_status = (view1->length == 0);
+    } else if (view2) {
+        same_status = (view2->length == 0);
+    }
+
+    return same_status;
+}
+
 #if BACNET_USE_OCTETSTRING
 /* returns false if the string exceeds capacity
    initialize by using value=NULL */
@@ -900,6 +978,49 @@ bool octetstring_value_same(
 
     return false;
 }
+
+void octetstring_view_init(
+    BACNET_OCTET_STRING_VIEW * view,
+    const uint8_t * value,
+    size_t length)
+{
+    if (view) {
+        if (value) {
+            view->value = value;
+            view->length = (uint32_t) length;
+        } else {
+            view->value = NULL;
+            view->length = 0;
+        }
+    }
+}
+
+/* the view is only valid while the octet_string is */
+void octetstring_view_from(
+    BACNET_OCTET_STRING_VIEW * view,
+    BACNET_OCTET_STRING * octet_string)
+{
+    if (view && octet_string) {
+        view->value = octet_string->value;
+        view->length = (uint32_t) octet_string->length;
+    }
+}
+
+/* returns false if the view exceeds the capacity of the string */
+bool octetstring_view_copy(
+    BACNET_OCTET_STRING * dest,
+    const BACNET_OCTET_STRING_VIEW * src)
+{
+    if (dest && src && (src->length <= MAX_OCTET_STRING_BYTES)) {
+        dest->length = src->length;
+        if (src->length) {
+            memcpy(dest->value, src->value, src->length);
+        }
+        return true;
+    }
+
+    return false;
+}
 #endif
 
 #ifdef TEST
@@ -1095,6 +1216,70 @@ void testOctetString(
     }
 }
 
+void testStringViews(
+    Test * pTest)
+{
+    BACNET_CHARACTER_STRING char_string;
+    BACNET_CHARACTER_STRING_VIEW char_view;
+    BACNET_CHARACTER_STRING_VIEW char_view2;
+    static char long_value[MAX_CHARACTER_STRING_BYTES + 10];
+    const char *name = "Patricia";
+    bool status = false;
+#if BACNET_USE_OCTETSTRING
+    BACNET_OCTET_STRING octet_string;
+    BACNET_OCTET_STRING_VIEW octet_view;
+    uint8_t octets[4] = { 1, 2, 3, 4 };
+#endif
+
+    /* a view borrows the value - it is not copied */
+    characterstring_view_init(&char_view, CHARACTER_ANSI_X34, name,
+        strlen(name));
+    ct_test(pTest, char_view.value == name);
+    ct_test(pTest, char_view.length == strlen(name));
+    characterstring_init_ansi(&char_string, name);
+    ct_test(pTest, characterstring_view_same(&char_view, &char_string));
+    characterstring_view_from(&char_view2, &char_string);
+    ct_test(pTest, char_view2.value == characterstring_value(&char_string));
+    ct_test(pTest, characterstring_view_same_view(&char_view, &char_view2));
+    /* encoding and length count */
+    char_view2.encoding = CHARACTER_ISO8859;
+    ct_test(pTest, !characterstring_view_same_view(&char_view, &char_view2));
+    char_view2.encoding = CHARACTER_ANSI_X34;
+    char_view2.length--;
+    ct_test(pTest, !characterstring_view_same_view(&char_view, &char_view2));
+    /* empty strings */
+    characterstring_view_init(&char_view2, CHARACTER_ANSI_X34, NULL, 10);
+    ct_test(pTest, char_view2.length == 0);
+    ct_test(pTest, characterstring_view_same_view(&char_view2, NULL));
+    ct_test(pTest, !characterstring_view_same(&char_view, NULL));
+    /* copy, limited by capacity */
+    characterstring_init_ansi(&char_string, "");
+    status = characterstring_view_copy(&char_string, &char_view);
+    ct_test(pTest, status);
+    ct_test(pTest, characterstring_ansi_same(&char_string, name));
+    memset(long_value, 'A', sizeof(long_value));
+    characterstring_view_init(&char_view, CHARACTER_ANSI_X34, long_value,
+        sizeof(long_value));
+    ct_test(pTest, char_view.length == sizeof(long_value));
+    status = characterstring_view_copy(&char_string, &char_view);
+    ct_test(pTest, !status);
+#if BACNET_USE_OCTETSTRING
+    octetstring_view_init(&octet_view, octets, sizeof(octets));
+    ct_test(pTest, octet_view.value == octets);
+    status = octetstring_view_copy(&octet_string, &octet_view);
+    ct_test(pTest, status);
+    ct_test(pTest, octetstring_length(&octet_string) == sizeof(octets));
+    ct_test(pTest, memcmp(octetstring_value(&octet_string), octets,
+            sizeof(octets)) == 0);
+    octetstring_view_from(&octet_view, &octet_string);
+    ct_test(pTest, octet_view.value == octetstring_value(&octet_string));
+    ct_test(pTest, octet_view.length == sizeof(octets));
+    octet_view.length = MAX_OCTET_STRING_BYTES + 1;
+    status = octetstring_view_copy(&octet_string, &octet_view);
+    ct_test(pTest, !status);
+#endif
+}
+
 #ifdef TEST_BACSTR
 int main(
     void)
@@ -1110,6 +1295,8 @@ int main(
     assert(rc);
     rc = ct_addTestFunction(pTest, testOctetString);
     assert(rc);
+    rc = ct_addTestFunction(pTest, testStringViews);
+    assert(rc);
     /* configure output */
     ct_setStream(pTest, stdout);
     ct_run(pTest);
@@ -32,6 +32,9 @@
  -------------------------------------------
 ####COPYRIGHTEND####*/
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     /* for recvmmsg and sendmmsg */
+#endif
 #include <stdint.h>     /* for standard integer types uint8_t etc. */
 #include <stdbool.h>    /* for the standard bool type. */
 #include "bacdcode.h"
@@ -53,6 +56,26 @@ static struct in_addr BIP_Address;
 /* Broadcast Address - stored in network byte order */
 static struct in_addr BIP_Broadcast_Address;
 
+/* Number of datagrams moved per recvmmsg or sendmmsg call.
+   Zero uses one recvfrom or sendto per datagram. */
+#ifndef BIP_MMSG_COUNT
+#if defined(__linux__)
+#define BIP_MMSG_COUNT 16
+#else
+#define BIP_MMSG_COUNT 0
+#endif
+#endif
+
+#if BIP_MMSG_COUNT
+/* datagrams received in one batch, handed out one at a time */
+static uint8_t BIP_Rx_Buffer[BIP_MMSG_COUNT][MAX_MPDU];
+static struct sockaddr_in BIP_Rx_Address[BIP_MMSG_COUNT];
+static struct iovec BIP_Rx_Iov[BIP_MMSG_COUNT];
+static struct mmsghdr BIP_Rx_Msg[BIP_MMSG_COUNT];
+static unsigned BIP_Rx_Count;
+static unsigned BIP_Rx_Index;
+#endif
+
 /** Setter for the BACnet/IP socket handle.
  *
  * @param sock_fd [in] Handle for the BACnet/IP socket.
@@ -61,6 +84,11 @@ void bip_set_socket(
     int sock_fd)
 {
     BIP_Socket = sock_fd;
+#if BIP_MMSG_COUNT
+    /* the queued datagrams came from the old socket */
+    BIP_Rx_Count = 0;
+    BIP_Rx_Index = 0;
+#endif
 }
 
 /** Getter for the BACnet/IP socket handle.
@@ -135,6 +163,172 @@ static int bip_decode_bip_address(
     return len;
 }
 
+/** Receives one datagram from the BACnet/IP socket.
+ * When the socket is readable, up to BIP_MMSG_COUNT datagrams are read
+ * with one recvmmsg, and the next calls return them without waiting.
+ *
+ * @param mtu [out] Buffer for the whole datagram, BVLC included.
+ * @param max_mtu [in] Size of the mtu[] buffer.
+ * @param sin [out] Source address of the datagram, in network order.
+ * @param timeout [in] The number of milliseconds to wait for a datagram.
+ * @return The number of octets received, zero on timeout, or
+ *  negative on error.
+ */
+int bip_receive_mpdu(
+    uint8_t * mtu,
+    uint16_t max_mtu,
+    struct sockaddr_in *sin,
+    unsigned timeout)
+{
+    fd_set read_fds;
+    int max = 0;
+    struct timeval select_timeout;
+#if BIP_MMSG_COUNT
+    unsigned i = 0;
+    int count = 0;
+    int mtu_len = 0;
+#else
+    socklen_t sin_len = sizeof(struct sockaddr_in);
+#endif
+
+    /* Make sure the socket is open */
+    if (BIP_Socket < 0)
+        return 0;
+#if BIP_MMSG_COUNT
+    if (BIP_Rx_Index < BIP_Rx_Count) {
+        /* already received, no need to wait */
+        i = BIP_Rx_Index++;
+        mtu_len = (int) BIP_Rx_Msg[i].msg_len;
+        if (mtu_len > max_mtu) {
+            mtu_len = max_mtu;
+        }
+        memcpy(mtu, &BIP_Rx_Buffer[i][0], mtu_len);
+        memcpy(sin, &BIP_Rx_Address[i], sizeof(struct sockaddr_in));
+        return mtu_len;
+    }
+    BIP_Rx_Count = 0;
+    BIP_Rx_Index = 0;
+#endif
+    /* we could just use a non-blocking socket, but that consumes all
+       the CPU time.  We can use a timeout; it is only supported as
+       a select. */
+    if (timeout >= 1000) {
+        select_timeout.tv_sec = timeout / 1000;
+        select_timeout.tv_usec =
+            1000 * (timeout - select_timeout.tv_sec * 1000);
+    } else {
+        select_timeout.tv_sec = 0;
+        select_timeout.tv_usec = 1000 * timeout;
+    }
+    FD_ZERO(&read_fds);
+    FD_SET(BIP_Socket, &read_fds);
+    max = BIP_Socket;
+    /* see if there is a packet for us */
+    if (select(max + 1, &read_fds, NULL, NULL, &select_timeout) <= 0) {
+        return 0;
+    }
+#if BIP_MMSG_COUNT
+    for (i = 0; i < BIP_MMSG_COUNT; i++) {
+        BIP_Rx_Iov[i].iov_base = &BIP_Rx_Buffer[i][0];
+        BIP_Rx_Iov[i].iov_len = sizeof(BIP_Rx_Buffer[i]);
+        memset(&BIP_Rx_Msg[i], 0, sizeof(BIP_Rx_Msg[i]));
+        BIP_Rx_Msg[i].msg_hdr.msg_name = &BIP_Rx_Address[i];
+        BIP_Rx_Msg[i].msg_hdr.msg_namelen = sizeof(BIP_Rx_Address[i]);
+        BIP_Rx_Msg[i].msg_hdr.msg_iov = &BIP_Rx_Iov[i];
+        BIP_Rx_Msg[i].msg_hdr.msg_iovlen = 1;
+    }
+    count =
+        recvmmsg(BIP_Socket, &BIP_Rx_Msg[0], BIP_MMSG_COUNT, MSG_DONTWAIT,
+        NULL);
+    if (count <= 0) {
+        return count;
+    }
+    BIP_Rx_Count = (unsigned) count;
+
+    return bip_receive_mpdu(mtu, max_mtu, sin, 0);
+#else
+    return recvfrom(BIP_Socket, (char *) &mtu[0], max_mtu, 0,
+        (struct sockaddr *) sin, &sin_len);
+#endif
+}
+
+/** Sends the same datagram to several BACnet/IP addresses, for example
+ * a Forwarded-NPDU to each BDT or FDT entry.  Up to BIP_MMSG_COUNT
+ * datagrams are given to the kernel with one sendmmsg.
+ *
+ * @param dest [in] Array of destination addresses, in network order.
+ * @param dest_count [in] Number of addresses in the dest[] array.
+ * @param mtu [in] The whole datagram, BVLC included.
+ * @param mtu_len [in] Number of bytes in the mtu[] buffer.
+ * @return The number of datagrams sent, or negative if the socket
+ *  is not open.
+ */
+int bip_send_mpdu_multiple(
+    struct sockaddr_in *dest,
+    unsigned dest_count,
+    uint8_t * mtu,
+    uint16_t mtu_len)
+{
+    struct sockaddr_in bip_dest[BIP_MMSG_COUNT ? BIP_MMSG_COUNT : 1];
+    unsigned next = 0;
+    int sent = 0;
+#if BIP_MMSG_COUNT
+    struct mmsghdr msg[BIP_MMSG_COUNT];
+    unsigned i = 0;
+    struct iovec iov;
+    unsigned batch = 0;
+    int rv = 0;
+#endif
+
+    /* assumes that the driver has already been initialized */
+    if (BIP_Socket < 0) {
+        return BIP_Socket;
+    }
+#if BIP_MMSG_COUNT
+    iov.iov_base = mtu;
+    iov.iov_len = mtu_len;
+    while (next < dest_count) {
+        batch = dest_count - next;
+        if (batch > BIP_MMSG_COUNT) {
+            batch = BIP_MMSG_COUNT;
+        }
+        for (i = 0; i < batch; i++) {
+            memset(&bip_dest[i], 0, sizeof(bip_dest[i]));
+            bip_dest[i].sin_family = AF_INET;
+            bip_dest[i].sin_addr.s_addr = dest[next + i].sin_addr.s_addr;
+            bip_dest[i].sin_port = dest[next + i].sin_port;
+            memset(&msg[i], 0, sizeof(msg[i]));
+            msg[i].msg_hdr.msg_name = &bip_dest[i];
+            msg[i].msg_hdr.msg_namelen = sizeof(bip_dest[i]);
+            msg[i].msg_hdr.msg_iov = &iov;
+            msg[i].msg_hdr.msg_iovlen = 1;
+        }
+        rv = sendmmsg(BIP_Socket, &msg[0], batch, 0);
+        if (rv > 0) {
+            sent += rv;
+            next += (unsigned) rv;
+        } else {
+            /* skip the address that failed, like a failed sendto */
+            next++;
+        }
+    }
+#else
+    for (next = 0; next < dest_count; next++) {
+        memset(&bip_dest[0], 0, sizeof(bip_dest[0]));
+        bip_dest[0].sin_family = AF_INET;
+        bip_dest[0].sin_addr.s_addr = dest[next].sin_addr.s_addr;
+        bip_dest[0].sin_port = dest[next].sin_port;
+        if (sendto(BIP_Socket, (char *) mtu, mtu_len, 0,
+                (struct sockaddr *) &bip_dest[0],
+                sizeof(struct sockaddr)) >= 0) {
+            sent++;
+        }
+    }
+#endif
+
+    return sent;
+}
+
 /** Function to send a packet out the BACnet/IP socket (Annex J).
  * @ingroup DLBIP
  *
@@ -224,39 +418,11 @@ uint16_t bip_receive(
 {
     int received_bytes = 0;
     uint16_t pdu_len = 0;       /* return value */
-    fd_set read_fds;
-    int max = 0;
-    struct timeval select_timeout;
     struct sockaddr_in sin = { 0 };
-    socklen_t sin_len = sizeof(sin);
     uint16_t i = 0;
     int function = 0;
 
-    /* Make sure the socket is open */
-    if (BIP_Socket < 0)
-        return 0;
-
-    /* we could just use a non-blocking socket, but that consumes all
-       the CPU time.  We can use a timeout; it is only supported as
-       a select. */
-    if (timeout >= 1000) {
-        select_timeout.tv_sec = timeout / 1000;
-        select_timeout.tv_usec =
-            1000 * (timeout - select_timeout.tv_sec * 1000);
-    } else {
-        select_timeout.tv_sec = 0;
-        select_timeout.tv_usec = 1000 * timeout;
-    }
-    FD_ZERO(&read_fds);
-    FD_SET(BIP_Socket, &read_fds);
-    max = BIP_Socket;
-    /* see if there is a packet for us */
-    if (select(max + 1, &read_fds, NULL, NULL, &select_timeout) > 0)
-        received_bytes =
-            recvfrom(BIP_Socket, (char *) &pdu[0], max_pdu, 0,
-            (struct sockaddr *) &sin, &sin_len);
-    else
-        return 0;
+    received_bytes = bip_receive_mpdu(&pdu[0], max_pdu, &sin, timeout);
 
     /* See if there is a problem */
     if (received_bytes < 0) {
@@ -358,6 +524,21 @@ uint16_t bip_receive(
     return pdu_len;
 }
 
+/** Gets the number of datagrams that were received in the last batch
+ * and not yet returned, so they can be read without waiting.
+ *
+ * @return The number of datagrams waiting.
+ */
+unsigned bip_receive_pending(
+    void)
+{
+#if BIP_MMSG_COUNT
+    return BIP_Rx_Count - BIP_Rx_Index;
+#else
+    return 0;
+#endif
+}
+
 void bip_get_my_address(
     BACNET_ADDRESS * my_address)
 {
@@ -34,11 +34,13 @@
 
 #include <stdint.h>     /* for standard integer types uint8_t etc. */
 #include <stdbool.h>    /* for the standard bool type. */
+#include <stdlib.h>
 #include <time.h>
 #include "bacenum.h"
 #include "bacdcode.h"
 #include "bacint.h"
 #include "bvlc.h"
+#include "hashindex.h"
 #ifndef DEBUG_ENABLED
 #define DEBUG_ENABLED 0
 #endif
@@ -77,7 +79,21 @@ BACNET_BVLC_FUNCTION BVLC_Function_Code = BVLC_RESULT;  /* A safe default */
 #ifndef MAX_BBMD_ENTRIES
 #define MAX_BBMD_ENTRIES 128
 #endif
-static BBMD_TABLE_ENTRY BBMD_Table[MAX_BBMD_ENTRIES];
+#ifndef MAX_FD_ENTRIES
+#define MAX_FD_ENTRIES 128
+#endif
+
+#if (MAX_BBMD_ENTRIES < 65535) && (MAX_FD_ENTRIES < 65535)
+typedef uint16_t BVLC_INDEX;
+#else
+typedef uint32_t BVLC_INDEX;
+#endif
+
+/* Forwarded-NPDU messages sent to a BDT or FDT entry */
+typedef struct {
+    uint32_t npdus;
+    uint32_t bytes;
+} BVLC_PEER_COUNTERS;
 
 /*Each device that registers as a foreign device shall be placed
 in an entry in the BBMD's Foreign Device Table (FDT). Each
@@ -89,22 +105,358 @@ entry if no re-registration occurs. This value will be initialized
 to the 2-octet Time-to-Live value supplied at the time of
 registration.*/
 typedef struct {
-    bool valid;
     /* BACnet/IP address */
     struct in_addr dest_address;
     /* BACnet/IP port number - not always 47808=BAC0h */
     uint16_t dest_port;
     /* seconds for valid entry lifetime */
     uint16_t time_to_live;
-    /* our counter */
-    time_t seconds_remaining;   /* includes 30 second grace period */
+    /* value of BVLC_Seconds when the entry is purged,
+       which includes the 30 second grace period */
+    uint32_t expires;
+    /* position of the entry in the expiry heap */
+    BVLC_INDEX heap;
+    BVLC_PEER_COUNTERS counters;
 } FD_TABLE_ENTRY;
 
-#ifndef MAX_FD_ENTRIES
-#define MAX_FD_ENTRIES 128
-#endif
+/* The BDT and FDT entries are packed at the start of their tables,
+   and each table is indexed by B/IP address and port with a hash index
+   (see hashindex.c).  The FDT entries are also in a binary heap ordered
+   by the time they expire, so that the maintenance timer only looks at
+   the entries that are due. */
+#if BBMD_TABLE_DYNAMIC
+static BBMD_TABLE_ENTRY *BBMD_Table;
+static BVLC_PEER_COUNTERS *BBMD_Counters;
+static unsigned BBMD_Table_Size;
+static FD_TABLE_ENTRY *FD_Table;
+static BVLC_INDEX *FD_Heap;
+static unsigned FD_Table_Size;
+#else
+static BBMD_TABLE_ENTRY BBMD_Table[MAX_BBMD_ENTRIES];
+static BVLC_PEER_COUNTERS BBMD_Counters[MAX_BBMD_ENTRIES];
+static BVLC_INDEX BBMD_Hash[HASH_INDEX_SIZE(MAX_BBMD_ENTRIES)];
+static const unsigned BBMD_Table_Size = MAX_BBMD_ENTRIES;
 static FD_TABLE_ENTRY FD_Table[MAX_FD_ENTRIES];
+static BVLC_INDEX FD_Hash[HASH_INDEX_SIZE(MAX_FD_ENTRIES)];
+static BVLC_INDEX FD_Heap[MAX_FD_ENTRIES];
+static const unsigned FD_Table_Size = MAX_FD_ENTRIES;
+#endif
+/* number of entries in use, at the start of each table */
+static unsigned BBMD_Count;
+static unsigned FD_Count;
+/* seconds counted by the maintenance timer, for the FDT expiry times */
+static uint32_t BVLC_Seconds;
+static BVLC_BBMD_STATS BBMD_Stats;
+
+static uint32_t bvlc_hash(
+    uint32_t address,
+    uint16_t port)
+{
+    /* the address and port are in network byte order */
+    return hash_index_mix(address ^ ((uint32_t) port << 16));
+}
+
+static uint32_t bvlc_bdt_home(
+    uint32_t index)
+{
+    return bvlc_hash(BBMD_Table[index].dest_address.s_addr,
+        BBMD_Table[index].dest_port);
+}
+
+static uint32_t bvlc_fdt_home(
+    uint32_t index)
+{
+    return bvlc_hash(FD_Table[index].dest_address.s_addr,
+        FD_Table[index].dest_port);
+}
+
+#if BBMD_TABLE_DYNAMIC
+static HASH_INDEX BBMD_Index = {
+    NULL, sizeof(BVLC_INDEX), 0, bvlc_bdt_home
+};
+static HASH_INDEX FD_Index = {
+    NULL, sizeof(BVLC_INDEX), 0, bvlc_fdt_home
+};
+#else
+static HASH_INDEX BBMD_Index = {
+    BBMD_Hash, sizeof(BVLC_INDEX), HASH_INDEX_SIZE(MAX_BBMD_ENTRIES),
+    bvlc_bdt_home
+};
+static HASH_INDEX FD_Index = {
+    FD_Hash, sizeof(BVLC_INDEX), HASH_INDEX_SIZE(MAX_FD_ENTRIES),
+    bvlc_fdt_home
+};
+#endif
+
+/* Find the BDT entry for a B/IP address and port.
+   Returns the index, or -1 if not found. */
+static int bvlc_bdt_find(
+    uint32_t address,
+    uint16_t port)
+{
+    unsigned slot, index;
+    uint32_t value;
+
+    if (BBMD_Table_Size == 0) {
+        return -1;
+    }
+    slot = hash_index_start(&BBMD_Index, bvlc_hash(address, port));
+    while ((value = hash_index_get(&BBMD_Index, slot)) != 0) {
+        index = value - 1;
+        if ((BBMD_Table[index].dest_address.s_addr == address) &&
+            (BBMD_Table[index].dest_port == port)) {
+            return (int) index;
+        }
+        slot = hash_index_next(&BBMD_Index, slot);
+    }
+
+    return -1;
+}
+
+/* Find the FDT entry for a B/IP address and port.
+   Returns the index, or -1 if not found. */
+static int bvlc_fdt_find(
+    uint32_t address,
+    uint16_t port)
+{
+    unsigned slot, index;
+    uint32_t value;
+
+    if (FD_Table_Size == 0) {
+        return -1;
+    }
+    slot = hash_index_start(&FD_Index, bvlc_hash(address, port));
+    while ((value = hash_index_get(&FD_Index, slot)) != 0) {
+        index = value - 1;
+        if ((FD_Table[index].dest_address.s_addr == address) &&
+            (FD_Table[index].dest_port == port)) {
+            return (int) index;
+        }
+        slot = hash_index_next(&FD_Index, slot);
+    }
+
+    return -1;
+}
+
+#if BBMD_TABLE_DYNAMIC
+/* Double the BDT, up to MAX_BBMD_ENTRIES entries, and rebuild the
+   index at the new size.  Returns false if it cannot grow. */
+static bool bvlc_bdt_grow(
+    void)
+{
+    BBMD_TABLE_ENTRY *pTable;
+    BVLC_PEER_COUNTERS *pCounters;
+    BVLC_INDEX *pHash;
+    unsigned size, index;
+
+    if (BBMD_Table_Size == 0) {
+        size = BBMD_TABLE_INITIAL;
+    } else {
+        size = BBMD_Table_Size * 2;
+    }
+    if (size > MAX_BBMD_ENTRIES) {
+        size = MAX_BBMD_ENTRIES;
+    }
+    if (size <= BBMD_Table_Size) {
+        return false;
+    }
+    pHash = calloc(HASH_INDEX_SIZE(size), sizeof(BVLC_INDEX));
+    pTable = realloc(BBMD_Table, size * sizeof(*BBMD_Table));
+    if (pTable) {
+        BBMD_Table = pTable;
+    }
+    pCounters = realloc(BBMD_Counters, size * sizeof(*BBMD_Counters));
+    if (pCounters) {
+        BBMD_Counters = pCounters;
+    }
+    if (!(pHash && pTable && pCounters)) {
+        free(pHash);
+        return false;
+    }
+    free(BBMD_Index.slots);
+    hash_index_init(&BBMD_Index, pHash, sizeof(BVLC_INDEX),
+        HASH_INDEX_SIZE(size), bvlc_bdt_home);
+    BBMD_Table_Size = size;
+    for (index = 0; index < BBMD_Count; index++) {
+        hash_index_insert(&BBMD_Index, index);
+    }
+
+    return true;
+}
+
+/* Double the FDT, up to MAX_FD_ENTRIES entries, and rebuild the
+   index at the new size.  The heap holds indexes, so it is kept. */
+static bool bvlc_fdt_grow(
+    void)
+{
+    FD_TABLE_ENTRY *pTable;
+    BVLC_INDEX *pHash, *pHeap;
+    unsigned size, index;
+
+    if (FD_Table_Size == 0) {
+        size = BBMD_TABLE_INITIAL;
+    } else {
+        size = FD_Table_Size * 2;
+    }
+    if (size > MAX_FD_ENTRIES) {
+        size = MAX_FD_ENTRIES;
+    }
+    if (size <= FD_Table_Size) {
+        return false;
+    }
+    pHash = calloc(HASH_INDEX_SIZE(size), sizeof(BVLC_INDEX));
+    pTable = realloc(FD_Table, size * sizeof(*FD_Table));
+    if (pTable) {
+        FD_Table = pTable;
+    }
+    pHeap = realloc(FD_Heap, size * sizeof(*FD_Heap));
+    if (pHeap) {
+        FD_Heap = pHeap;
+    }
+    if (!(pHash && pTable && pHeap)) {
+        free(pHash);
+        return false;
+    }
+    free(FD_Index.slots);
+    hash_index_init(&FD_Index, pHash, sizeof(BVLC_INDEX),
+        HASH_INDEX_SIZE(size), bvlc_fdt_home);
+    FD_Table_Size = size;
+    for (index = 0; index < FD_Count; index++) {
+        hash_index_insert(&FD_Index, index);
+    }
+
+    return true;
+}
+#else
+static bool bvlc_bdt_grow(
+    void)
+{
+    return false;
+}
+
+static bool bvlc_fdt_grow(
+    void)
+{
+    return false;
+}
+#endif
 
+/* Add an entry to the end of the BDT.
+   Returns false if the table is full. */
+static bool bvlc_bdt_add(
+    BBMD_TABLE_ENTRY * entry)
+{
+    unsigned index = BBMD_Count;
+
+    if ((index >= BBMD_Table_Size) && (!bvlc_bdt_grow())) {
+        return false;
+    }
+    BBMD_Table[index] = *entry;
+    BBMD_Table[index].valid = true;
+    BBMD_Counters[index].npdus = 0;
+    BBMD_Counters[index].bytes = 0;
+    hash_index_insert(&BBMD_Index, index);
+    BBMD_Count++;
+
+    return true;
+}
+
+static void bvlc_bdt_clear(
+    void)
+{
+    unsigned i = 0;
+
+    for (i = 0; i < BBMD_Count; i++) {
+        BBMD_Table[i].valid = false;
+        BBMD_Table[i].dest_address.s_addr = 0;
+        BBMD_Table[i].dest_port = 0;
+        BBMD_Table[i].broadcast_mask.s_addr = 0;
+    }
+    hash_index_clear(&BBMD_Index);
+    BBMD_Count = 0;
+}
+
+/* true if the FDT entry at a expires before the one at b */
+static bool bvlc_fdt_heap_before(
+    unsigned a,
+    unsigned b)
+{
+    return (int32_t) (FD_Table[a].expires - FD_Table[b].expires) < 0;
+}
+
+static void bvlc_fdt_heap_set(
+    unsigned position,
+    unsigned index)
+{
+    FD_Heap[position] = (BVLC_INDEX) index;
+    FD_Table[index].heap = (BVLC_INDEX) position;
+}
+
+static void bvlc_fdt_heap_up(
+    unsigned position)
+{
+    unsigned index = FD_Heap[position];
+    unsigned parent;
+
+    while (position > 0) {
+        parent = (position - 1) / 2;
+        if (!bvlc_fdt_heap_before(index, FD_Heap[parent])) {
+            break;
+        }
+        bvlc_fdt_heap_set(position, FD_Heap[parent]);
+        position = parent;
+    }
+    bvlc_fdt_heap_set(position, index);
+}
+
+static void bvlc_fdt_heap_down(
+    unsigned position,
+    unsigned count)
+{
+    unsigned index = FD_Heap[position];
+    unsigned child;
+
+    for (;;) {
+        child = (position * 2) + 1;
+        if (child >= count) {
+            break;
+        }
+        if (((child + 1) < count) &&
+            bvlc_fdt_heap_before(FD_Heap[child + 1], FD_Heap[child])) {
+            child++;
+        }
+        if (!bvlc_fdt_heap_before(FD_Heap[child], index)) {
+            break;
+        }
+        bvlc_fdt_heap_set(position, FD_Heap[child]);
+        position = child;
+    }
+    bvlc_fdt_heap_set(position, index);
+}
+
+/* Remove an entry from the FDT, moving the last entry into its place */
+static void bvlc_fdt_remove(
+    unsigned index)
+{
+    unsigned last = FD_Count - 1;
+    unsigned position = FD_Table[index].heap;
+    unsigned moved;
+
+    /* fill the hole in the heap with its last entry */
+    if (position != last) {
+        moved = FD_Heap[last];
+        bvlc_fdt_heap_set(position, moved);
+        bvlc_fdt_heap_up(position);
+        bvlc_fdt_heap_down(FD_Table[moved].heap, last);
+    }
+    hash_index_remove(&FD_Index, index);
+    if (index != last) {
+        hash_index_move(&FD_Index, last, index);
+        FD_Table[index] = FD_Table[last];
+        FD_Heap[FD_Table[index].heap] = (BVLC_INDEX) index;
+    }
+    FD_Count = last;
+}
 
 /** A timer function that is called about once a second.
  *
@@ -113,21 +465,16 @@ static FD_TABLE_ENTRY FD_Table[MAX_FD_ENTRIES];
 void bvlc_maintenance_timer(
     time_t seconds)
 {
-    unsigned i = 0;
+    unsigned index = 0;
 
-    for (i = 0; i < MAX_FD_ENTRIES; i++) {
-        if (FD_Table[i].valid) {
-            if (FD_Table[i].seconds_remaining) {
-                if (FD_Table[i].seconds_remaining < seconds) {
-                    FD_Table[i].seconds_remaining = 0;
-                } else {
-                    FD_Table[i].seconds_remaining -= seconds;
-                }
-                if (FD_Table[i].seconds_remaining == 0) {
-                    FD_Table[i].valid = false;
-                }
-            }
+    BVLC_Seconds += (uint32_t) seconds;
+    while (FD_Count > 0) {
+        index = FD_Heap[0];
+        if ((int32_t) (FD_Table[index].expires - BVLC_Seconds) > 0) {
+            break;
         }
+        bvlc_fdt_remove(index);
+        BBMD_Stats.fd_expirations++;
     }
 }
 
@@ -386,29 +733,21 @@ static int bvlc_encode_read_bdt_ack(
 {
     int pdu_len = 0;    /* return value */
     int len = 0;
-    unsigned count = 0;
     unsigned i;
 
-    for (i = 0; i < MAX_BBMD_ENTRIES; i++) {
-        if (BBMD_Table[i].valid) {
-            count++;
-        }
-    }
-    len = bvlc_encode_read_bdt_ack_init(&pdu[0], count);
+    len = bvlc_encode_read_bdt_ack_init(&pdu[0], BBMD_Count);
     pdu_len += len;
-    for (i = 0; i < MAX_BBMD_ENTRIES; i++) {
-        if (BBMD_Table[i].valid) {
-            /* too much to send */
-            if ((pdu_len + 10) > max_pdu) {
-                pdu_len = 0;
-                break;
-            }
-            len =
-                bvlc_encode_address_entry(&pdu[pdu_len],
-                &BBMD_Table[i].dest_address, BBMD_Table[i].dest_port,
-                &BBMD_Table[i].broadcast_mask);
-            pdu_len += len;
+    for (i = 0; i < BBMD_Count; i++) {
+        /* too much to send */
+        if ((pdu_len + 10) > max_pdu) {
+            pdu_len = 0;
+            break;
         }
+        len =
+            bvlc_encode_address_entry(&pdu[pdu_len],
+            &BBMD_Table[i].dest_address, BBMD_Table[i].dest_port,
+            &BBMD_Table[i].broadcast_mask);
+        pdu_len += len;
     }
 
     return pdu_len;
@@ -524,34 +863,27 @@ static int bvlc_encode_read_fdt_ack(
 {
     int pdu_len = 0;    /* return value */
     int len = 0;
-    unsigned count = 0;
     unsigned i;
     uint16_t seconds_remaining = 0;
 
-    for (i = 0; i < MAX_FD_ENTRIES; i++) {
-        if (FD_Table[i].valid) {
-            count++;
-        }
-    }
-    len = bvlc_encode_read_fdt_ack_init(&pdu[0], count);
+    len = bvlc_encode_read_fdt_ack_init(&pdu[0], FD_Count);
     pdu_len += len;
-    for (i = 0; i < MAX_FD_ENTRIES; i++) {
-        if (FD_Table[i].valid) {
-            /* too much to send */
-            if ((pdu_len + 10) > max_pdu) {
-                pdu_len = 0;
-                break;
-            }
-            len =
-                bvlc_encode_bip_address(&pdu[pdu_len],
-                &FD_Table[i].dest_address, FD_Table[i].dest_port);
-            pdu_len += len;
-            len = encode_unsigned16(&pdu[pdu_len], FD_Table[i].time_to_live);
-            pdu_len += len;
-            seconds_remaining = (uint16_t) FD_Table[i].seconds_remaining;
-            len = encode_unsigned16(&pdu[pdu_len], seconds_remaining);
-            pdu_len += len;
+    for (i = 0; i < FD_Count; i++) {
+        /* too much to send */
+        if ((pdu_len + 10) > max_pdu) {
+            pdu_len = 0;
+            break;
         }
+        len =
+            bvlc_encode_bip_address(&pdu[pdu_len],
+            &FD_Table[i].dest_address, FD_Table[i].dest_port);
+        pdu_len += len;
+        len = encode_unsigned16(&pdu[pdu_len], FD_Table[i].time_to_live);
+        pdu_len += len;
+        seconds_remaining =
+            (uint16_t) (FD_Table[i].expires - BVLC_Seconds);
+        len = encode_unsigned16(&pdu[pdu_len], seconds_remaining);
+        pdu_len += len;
     }
 
     return pdu_len;
@@ -677,33 +1009,27 @@ static bool bvlc_create_bdt(
     uint8_t * npdu,
     uint16_t npdu_length)
 {
-    bool status = false;
-    unsigned i = 0;
+    BBMD_TABLE_ENTRY entry = { 0 };
     uint16_t pdu_offset = 0;
 
-    for (i = 0; i < MAX_BBMD_ENTRIES; i++) {
-        if (npdu_length >= 10) {
-            BBMD_Table[i].valid = true;
-            memcpy(&BBMD_Table[i].dest_address.s_addr, &npdu[pdu_offset], 4);
-            pdu_offset += 4;
-            memcpy(&BBMD_Table[i].dest_port, &npdu[pdu_offset], 2);
-            pdu_offset += 2;
-            memcpy(&BBMD_Table[i].broadcast_mask.s_addr, &npdu[pdu_offset], 4);
-            pdu_offset += 4;
-            npdu_length -= (4 + 2 + 4);
-        } else {
-            BBMD_Table[i].valid = false;
-            BBMD_Table[i].dest_address.s_addr = 0;
-            BBMD_Table[i].dest_port = 0;
-            BBMD_Table[i].broadcast_mask.s_addr = 0;
+    bvlc_bdt_clear();
+    while (npdu_length >= 10) {
+        memcpy(&entry.dest_address.s_addr, &npdu[pdu_offset], 4);
+        pdu_offset += 4;
+        memcpy(&entry.dest_port, &npdu[pdu_offset], 2);
+        pdu_offset += 2;
+        memcpy(&entry.broadcast_mask.s_addr, &npdu[pdu_offset], 4);
+        pdu_offset += 4;
+        /* a BBMD listed twice keeps its first entry */
+        if ((bvlc_bdt_find(entry.dest_address.s_addr,
+                    entry.dest_port) < 0) && (!bvlc_bdt_add(&entry))) {
+            break;
         }
-    }
-    /* did they all fit? */
-    if (npdu_length < 10) {
-        status = true;
+        npdu_length -= (4 + 2 + 4);
     }
 
-    return status;
+    /* did they all fit? */
+    return (npdu_length < 10);
 }
 
 /** Register a Foreign Device in the Foreign Device Table
@@ -717,41 +1043,42 @@ static bool bvlc_register_foreign_device(
     struct sockaddr_in *sin,
     uint16_t time_to_live)
 {
-    unsigned i = 0;
-    bool status = false;
-
-    /* am I here already?  If so, update my time to live... */
-    for (i = 0; i < MAX_FD_ENTRIES; i++) {
-        if (FD_Table[i].valid) {
-            if ((FD_Table[i].dest_address.s_addr == sin->sin_addr.s_addr) &&
-                (FD_Table[i].dest_port == sin->sin_port)) {
-                status = true;
-                FD_Table[i].time_to_live = time_to_live;
-                /*  Upon receipt of a BVLL Register-Foreign-Device message,
-                   a BBMD shall start a timer with a value equal to the
-                   Time-to-Live parameter supplied plus a fixed grace
-                   period of 30 seconds. */
-                FD_Table[i].seconds_remaining = time_to_live + 30;
-                break;
-            }
-        }
+    int found = 0;
+    unsigned index = 0;
+
+    /*  Upon receipt of a BVLL Register-Foreign-Device message,
+       a BBMD shall start a timer with a value equal to the
+       Time-to-Live parameter supplied plus a fixed grace
+       period of 30 seconds. */
+    found = bvlc_fdt_find(sin->sin_addr.s_addr, sin->sin_port);
+    if (found >= 0) {
+        /* am I here already?  If so, update my time to live... */
+        index = (unsigned) found;
+        FD_Table[index].time_to_live = time_to_live;
+        FD_Table[index].expires = BVLC_Seconds + time_to_live + 30;
+        bvlc_fdt_heap_up(FD_Table[index].heap);
+        bvlc_fdt_heap_down(FD_Table[index].heap, FD_Count);
+        BBMD_Stats.fd_renewals++;
+        return true;
     }
-    if (!status) {
-        for (i = 0; i < MAX_FD_ENTRIES; i++) {
-            if (!FD_Table[i].valid) {
-                FD_Table[i].dest_address.s_addr = sin->sin_addr.s_addr;
-                FD_Table[i].dest_port = sin->sin_port;
-                FD_Table[i].time_to_live = time_to_live;
-                FD_Table[i].seconds_remaining = time_to_live + 30;
-                FD_Table[i].valid = true;
-                status = true;
-                break;
-            }
-        }
+    index = FD_Count;
+    if ((index >= FD_Table_Size) && (!bvlc_fdt_grow())) {
+        BBMD_Stats.fd_register_naks++;
+        return false;
     }
+    FD_Table[index].dest_address.s_addr = sin->sin_addr.s_addr;
+    FD_Table[index].dest_port = sin->sin_port;
+    FD_Table[index].time_to_live = time_to_live;
+    FD_Table[index].expires = BVLC_Seconds + time_to_live + 30;
+    FD_Table[index].counters.npdus = 0;
+    FD_Table[index].counters.bytes = 0;
+    hash_index_insert(&FD_Index, index);
+    FD_Count++;
+    bvlc_fdt_heap_set(index, index);
+    bvlc_fdt_heap_up(index);
+    BBMD_Stats.fd_registrations++;
 
-
-    return status;
+    return true;
 }
 
 /** Delete a Foreign Device from the Foreign Device Table
@@ -764,22 +1091,17 @@ static bool bvlc_delete_foreign_device(
     uint8_t * pdu)
 {
     struct sockaddr_in sin = { 0 };     /* the ip address */
-    bool status = false;        /* return value */
-    unsigned i = 0;
+    int index = 0;
 
     bvlc_decode_bip_address(pdu, &sin.sin_addr, &sin.sin_port);
-    for (i = 0; i < MAX_FD_ENTRIES; i++) {
-        if (FD_Table[i].valid) {
-            if ((FD_Table[i].dest_address.s_addr == sin.sin_addr.s_addr) &&
-                (FD_Table[i].dest_port == sin.sin_port)) {
-                FD_Table[i].valid = false;
-                FD_Table[i].seconds_remaining = 0;
-                status = true;
-                break;
-            }
-        }
+    index = bvlc_fdt_find(sin.sin_addr.s_addr, sin.sin_port);
+    if (index < 0) {
+        return false;
     }
-    return status;
+    bvlc_fdt_remove((unsigned) index);
+    BBMD_Stats.fd_deletions++;
+
+    return true;
 }
 #endif
 
@@ -836,6 +1158,10 @@ static void bvlc_bdt_forward_npdu(
     uint16_t mtu_len = 0;
     unsigned i = 0;     /* loop counter */
     struct sockaddr_in bip_dest = { 0 };
+    struct sockaddr_in dest_list[MAX_BBMD_ENTRIES];
+    BVLC_INDEX dest_index[MAX_BBMD_ENTRIES];
+    unsigned dest_count = 0;
+    int sent = 0;
 
     /* If we are forwarding an original broadcast message and the NAT
      * handling is enabled, change the source address to NAT routers
@@ -856,40 +1182,51 @@ static void bvlc_bdt_forward_npdu(
                              sin, npdu, max_npdu, npdu_length);
     }
 
-    /* loop through the BDT and send one to each entry, except us */
-    for (i = 0; i < MAX_BBMD_ENTRIES; i++) {
-        if (BBMD_Table[i].valid) {
-            /* The B/IP address to which the Forwarded-NPDU message is
-               sent is formed by inverting the broadcast distribution
-               mask in the BDT entry and logically ORing it with the
-               BBMD address of the same entry. */
-            bip_dest.sin_addr.s_addr =
-                ((~BBMD_Table[i].broadcast_mask.
-                    s_addr) | BBMD_Table[i].dest_address.s_addr);
-            bip_dest.sin_port = BBMD_Table[i].dest_port;
-            /* don't send to my broadcast address and same port */
-            if ((bip_dest.sin_addr.s_addr == bip_get_broadcast_addr())
-                && (bip_dest.sin_port == bip_get_port())) {
-                continue;
-            }
-            /* don't send to my ip address and same port */
-            if ((bip_dest.sin_addr.s_addr == bip_get_addr()) &&
-                (bip_dest.sin_port == bip_get_port())) {
-                continue;
-            }
-            /* NAT router port forwards BACnet packets from global IP to us.
-             * Packets sent to that global IP by us would end up back, creating
-             * a loop.
-             */
-            if (BVLC_NAT_Handling &&
-                (bip_dest.sin_addr.s_addr == BVLC_Global_Address.s_addr) &&
-                (bip_dest.sin_port == bip_get_port())) {
-                continue;
-            }
-            bvlc_send_mpdu(&bip_dest, mtu, mtu_len);
-            debug_printf("BVLC: BDT Sent Forwarded-NPDU to %s:%04X\n",
-                inet_ntoa(bip_dest.sin_addr), ntohs(bip_dest.sin_port));
+    /* loop through the BDT and send one to each entry, except us,
+       in one batch */
+    for (i = 0; i < BBMD_Count; i++) {
+        /* The B/IP address to which the Forwarded-NPDU message is
+           sent is formed by inverting the broadcast distribution
+           mask in the BDT entry and logically ORing it with the
+           BBMD address of the same entry. */
+        bip_dest.sin_addr.s_addr =
+            ((~BBMD_Table[i].broadcast_mask.
+                s_addr) | BBMD_Table[i].dest_address.s_addr);
+        bip_dest.sin_port = BBMD_Table[i].dest_port;
+        /* don't send to my broadcast address and same port */
+        if ((bip_dest.sin_addr.s_addr == bip_get_broadcast_addr())
+            && (bip_dest.sin_port == bip_get_port())) {
+            continue;
+        }
+        /* don't send to my ip address and same port */
+        if ((bip_dest.sin_addr.s_addr == bip_get_addr()) &&
+            (bip_dest.sin_port == bip_get_port())) {
+            continue;
         }
+        /* NAT router port forwards BACnet packets from global IP to us.
+         * Packets sent to that global IP by us would end up back, creating
+         * a loop.
+         */
+        if (BVLC_NAT_Handling &&
+            (bip_dest.sin_addr.s_addr == BVLC_Global_Address.s_addr) &&
+            (bip_dest.sin_port == bip_get_port())) {
+            continue;
+        }
+        dest_index[dest_count] = (BVLC_INDEX) i;
+        dest_list[dest_count++] = bip_dest;
+        debug_printf("BVLC: BDT Sent Forwarded-NPDU to %s:%04X\n",
+            inet_ntoa(bip_dest.sin_addr), ntohs(bip_dest.sin_port));
+    }
+    if (dest_count) {
+        sent =
+            bip_send_mpdu_multiple(&dest_list[0], dest_count, mtu, mtu_len);
+    }
+    /* the datagrams are sent in order, so count the first ones */
+    for (i = 0; (int) i < sent; i++) {
+        BBMD_Counters[dest_index[i]].npdus++;
+        BBMD_Counters[dest_index[i]].bytes += mtu_len;
+        BBMD_Stats.forwarded_npdus++;
+        BBMD_Stats.forwarded_bytes += mtu_len;
     }
 
     return;
@@ -941,6 +1278,10 @@ static void bvlc_fdt_forward_npdu(
     uint16_t mtu_len = 0;
     unsigned i = 0;     /* loop counter */
     struct sockaddr_in bip_dest = { 0 };
+    struct sockaddr_in dest_list[MAX_FD_ENTRIES];
+    BVLC_INDEX dest_index[MAX_FD_ENTRIES];
+    unsigned dest_count = 0;
+    int sent = 0;
 
     /* If we are forwarding an original broadcast message and the NAT
      * handling is enabled, change the source address to NAT routers
@@ -960,34 +1301,44 @@ static void bvlc_fdt_forward_npdu(
                              sin, npdu, max_npdu, npdu_length);
     }
 
-    /* loop through the FDT and send one to each entry */
-    for (i = 0; i < MAX_FD_ENTRIES; i++) {
-        if (FD_Table[i].valid && FD_Table[i].seconds_remaining) {
-            bip_dest.sin_addr.s_addr = FD_Table[i].dest_address.s_addr;
-            bip_dest.sin_port = FD_Table[i].dest_port;
-            /* don't send to my ip address and same port */
-            if ((bip_dest.sin_addr.s_addr == bip_get_addr()) &&
-                (bip_dest.sin_port == bip_get_port())) {
-                continue;
-            }
-            /* don't send to src ip address and same port */
-            if ((bip_dest.sin_addr.s_addr == sin->sin_addr.s_addr) &&
-                (bip_dest.sin_port == sin->sin_port)) {
-                continue;
-            }
-            /* NAT router port forwards BACnet packets from global IP to us.
-             * Packets sent to that global IP by us would end up back, creating
-             * a loop.
-             */
-            if (BVLC_NAT_Handling &&
-                (bip_dest.sin_addr.s_addr == BVLC_Global_Address.s_addr) &&
-                (bip_dest.sin_port == bip_get_port())) {
-                continue;
-            }
-            bvlc_send_mpdu(&bip_dest, mtu, mtu_len);
-            debug_printf("BVLC: FDT Sent Forwarded-NPDU to %s:%04X\n",
-                inet_ntoa(bip_dest.sin_addr), ntohs(bip_dest.sin_port));
+    /* loop through the FDT and send one to each entry, in one batch */
+    for (i = 0; i < FD_Count; i++) {
+        bip_dest.sin_addr.s_addr = FD_Table[i].dest_address.s_addr;
+        bip_dest.sin_port = FD_Table[i].dest_port;
+        /* don't send to my ip address and same port */
+        if ((bip_dest.sin_addr.s_addr == bip_get_addr()) &&
+            (bip_dest.sin_port == bip_get_port())) {
+            continue;
+        }
+        /* don't send to src ip address and same port */
+        if ((bip_dest.sin_addr.s_addr == sin->sin_addr.s_addr) &&
+            (bip_dest.sin_port == sin->sin_port)) {
+            continue;
+        }
+        /* NAT router port forwards BACnet packets from global IP to us.
+         * Packets sent to that global IP by us would end up back, creating
+         * a loop.
+         */
+        if (BVLC_NAT_Handling &&
+            (bip_dest.sin_addr.s_addr == BVLC_Global_Address.s_addr) &&
+            (bip_dest.sin_port == bip_get_port())) {
+            continue;
         }
+        dest_index[dest_count] = (BVLC_INDEX) i;
+        dest_list[dest_count++] = bip_dest;
+        debug_printf("BVLC: FDT Sent Forwarded-NPDU to %s:%04X\n",
+            inet_ntoa(bip_dest.sin_addr), ntohs(bip_dest.sin_port));
+    }
+    if (dest_count) {
+        sent =
+            bip_send_mpdu_multiple(&dest_list[0], dest_count, mtu, mtu_len);
+    }
+    /* the datagrams are sent in order, so count the first ones */
+    for (i = 0; (int) i < sent; i++) {
+        FD_Table[dest_index[i]].counters.npdus++;
+        FD_Table[dest_index[i]].counters.bytes += mtu_len;
+        BBMD_Stats.forwarded_npdus++;
+        BBMD_Stats.forwarded_bytes += mtu_len;
     }
 
     return;
@@ -1030,6 +1381,7 @@ static int bvlc_send_bdt(
     uint8_t mtu[MAX_MPDU] = { 0 };
     uint16_t mtu_len = 0;
 
+    BBMD_Stats.read_bdt_requests++;
     mtu_len = (uint16_t) bvlc_encode_read_bdt_ack(&mtu[0], sizeof(mtu));
     if (mtu_len) {
         bvlc_send_mpdu(dest, &mtu[0], mtu_len);
@@ -1050,6 +1402,7 @@ static int bvlc_send_fdt(
     uint8_t mtu[MAX_MPDU] = { 0 };
     uint16_t mtu_len = 0;
 
+    BBMD_Stats.read_fdt_requests++;
     mtu_len = (uint16_t) bvlc_encode_read_fdt_ack(&mtu[0], sizeof(mtu));
     if (mtu_len) {
         bvlc_send_mpdu(dest, &mtu[0], mtu_len);
@@ -1067,31 +1420,21 @@ static int bvlc_send_fdt(
 static bool bvlc_bdt_member_mask_is_unicast(
     struct sockaddr_in *sin)
 {
-    bool unicast = false;
-    unsigned i = 0;     /* loop counter */
-
-    for (i = 0; i < MAX_BBMD_ENTRIES; i++) {
-        if (BBMD_Table[i].valid) {
+    int index = 0;
 
-            /* Skip ourself*/
-            if ((BBMD_Table[i].dest_address.s_addr == bip_get_addr()) &&
-                (BBMD_Table[i].dest_port == bip_get_port())) {
-                continue;
-            }
-
-            /* find the source address in the table */
-            if ((BBMD_Table[i].dest_address.s_addr == sin->sin_addr.s_addr) &&
-                (BBMD_Table[i].dest_port == sin->sin_port)) {
-                /* unicast mask? */
-                if (BBMD_Table[i].broadcast_mask.s_addr == 0xFFFFFFFFL) {
-                    unicast = true;
-                    break;
-                }
-            }
-        }
+    /* Skip ourself*/
+    if ((sin->sin_addr.s_addr == bip_get_addr()) &&
+        (sin->sin_port == bip_get_port())) {
+        return false;
+    }
+    /* find the source address in the table */
+    index = bvlc_bdt_find(sin->sin_addr.s_addr, sin->sin_port);
+    if (index < 0) {
+        return false;
     }
 
-    return unicast;
+    /* unicast mask? */
+    return (BBMD_Table[index].broadcast_mask.s_addr == 0xFFFFFFFFL);
 }
 
 /** Receive a packet from the BACnet/IP socket (Annex J)
@@ -1110,46 +1453,17 @@ uint16_t bvlc_receive(
     unsigned timeout)
 {
     uint16_t npdu_len = 0;      /* return value */
-    fd_set read_fds;
-    int max = 0;
-    struct timeval select_timeout;
     struct sockaddr_in sin = { 0 };
     struct sockaddr_in original_sin = { 0 };
     struct sockaddr_in dest = { 0 };
-    socklen_t sin_len = sizeof(sin);
     int received_bytes = 0;
     uint16_t result_code = 0;
     uint16_t i = 0;
     bool status = false;
     uint16_t time_to_live = 0;
 
-    /* Make sure the socket is open */
-    if (bip_socket() < 0) {
-        return 0;
-    }
-
-    /* we could just use a non-blocking socket, but that consumes all
-       the CPU time.  We can use a timeout; it is only supported as
-       a select. */
-    if (timeout >= 1000) {
-        select_timeout.tv_sec = timeout / 1000;
-        select_timeout.tv_usec =
-            1000 * (timeout - select_timeout.tv_sec * 1000);
-    } else {
-        select_timeout.tv_sec = 0;
-        select_timeout.tv_usec = 1000 * timeout;
-    }
-    FD_ZERO(&read_fds);
-    FD_SET(bip_socket(), &read_fds);
-    max = bip_socket();
-    /* see if there is a packet for us */
-    if (select(max + 1, &read_fds, NULL, NULL, &select_timeout) > 0) {
-        received_bytes =
-            recvfrom(bip_socket(), (char *) &npdu[0], max_npdu, 0,
-            (struct sockaddr *) &sin, &sin_len);
-    } else {
-        return 0;
-    }
+    /* several datagrams may be read at once, and returned one by one */
+    received_bytes = bip_receive_mpdu(&npdu[0], max_npdu, &sin, timeout);
     /* See if there is a problem */
     if (received_bytes < 0) {
         return 0;
@@ -1667,20 +1981,12 @@ BACNET_BVLC_FUNCTION bvlc_get_function_code(
 int bvlc_get_bdt_local(
      const BBMD_TABLE_ENTRY** table)
 {
-    int count = 0;
-
     if(table == NULL)
         return -1;
 
     *table = BBMD_Table;
 
-    for (count = 0; count < MAX_BBMD_ENTRIES; ++count) {
-        if (!BBMD_Table[count].valid) {
-            break;
-        }
-    }
-
-    return count;
+    return (int) BBMD_Count;
 }
 
 /** Invalidate all entries in the broadcast distribution table (BDT).
@@ -1688,53 +1994,110 @@ int bvlc_get_bdt_local(
 void bvlc_clear_bdt_local(
     void)
 {
-    int i = 0;
-    for (i = 0; i < MAX_BBMD_ENTRIES; ++i) {
-        BBMD_Table[i].valid = false;
-        BBMD_Table[i].dest_address.s_addr = 0;
-        BBMD_Table[i].dest_port = 0;
-        BBMD_Table[i].broadcast_mask.s_addr = 0;
-    }
+    bvlc_bdt_clear();
 }
 
 /** Add new entry to broadcast distribution table.
  *
- * @return True if the new entry was added successfully.
+ * @return True if the new entry was added successfully, false if the
+ *  table is full or already has an entry for the address and port.
  */
 bool bvlc_add_bdt_entry_local(
     BBMD_TABLE_ENTRY* entry)
 {
-    bool found = false;
-    int i = 0;
-
     if(entry == NULL)
         return false;
 
-    /* Find first empty slot */
-    for (i = 0; i < MAX_BBMD_ENTRIES; ++i) {
-        if (!BBMD_Table[i].valid) {
-            found = true;
-            break;
-        }
+    /* Make sure that we are not adding a duplicate */
+    if (bvlc_bdt_find(entry->dest_address.s_addr, entry->dest_port) >= 0)
+        return false;
 
-        /* Make sure that we are not adding a duplicate */
-        if(BBMD_Table[i].dest_address.s_addr == entry->dest_address.s_addr &&
-           BBMD_Table[i].broadcast_mask.s_addr == entry->broadcast_mask.s_addr &&
-           BBMD_Table[i].dest_port == entry->dest_port) {
-            return false;
-        }
+    return bvlc_bdt_add(entry);
+}
+
+/** Get the BBMD statistics, which count the changes to the
+ *  foreign device table, the table reads, and the forwarded messages.
+ *
+ * @param stats [out] - the statistics and current table sizes
+ */
+void bvlc_bbmd_stats(
+    BVLC_BBMD_STATS * stats)
+{
+    if (stats) {
+        *stats = BBMD_Stats;
+        stats->bdt_entries = BBMD_Count;
+        stats->fdt_entries = FD_Count;
     }
+}
 
-    if(!found)
+/** Get the Forwarded-NPDU counts for a BDT entry.
+ *
+ * @param index [in] - 0 to the number of BDT entries less one
+ * @param stats [out] - the entry address and its counts
+ *
+ * @return true if the index is a BDT entry
+ */
+bool bvlc_bdt_peer_stats(
+    unsigned index,
+    BVLC_PEER_STATS * stats)
+{
+    if ((index >= BBMD_Count) || (stats == NULL)) {
         return false;
+    }
+    stats->dest_address = BBMD_Table[index].dest_address;
+    stats->dest_port = BBMD_Table[index].dest_port;
+    stats->time_to_live = 0;
+    stats->seconds_remaining = 0;
+    stats->forwarded_npdus = BBMD_Counters[index].npdus;
+    stats->forwarded_bytes = BBMD_Counters[index].bytes;
 
-    /* Copy new entry to the empty slot */
-    BBMD_Table[i] = *entry;
-    BBMD_Table[i].valid = true;
+    return true;
+}
+
+/** Get the Forwarded-NPDU counts and time to live for an FDT entry.
+ *  Removing an entry moves the last entry into its place.
+ *
+ * @param index [in] - 0 to the number of FDT entries less one
+ * @param stats [out] - the entry address and its counts
+ *
+ * @return true if the index is an FDT entry
+ */
+bool bvlc_fdt_peer_stats(
+    unsigned index,
+    BVLC_PEER_STATS * stats)
+{
+    if ((index >= FD_Count) || (stats == NULL)) {
+        return false;
+    }
+    stats->dest_address = FD_Table[index].dest_address;
+    stats->dest_port = FD_Table[index].dest_port;
+    stats->time_to_live = FD_Table[index].time_to_live;
+    stats->seconds_remaining =
+        (uint16_t) (FD_Table[index].expires - BVLC_Seconds);
+    stats->forwarded_npdus = FD_Table[index].counters.npdus;
+    stats->forwarded_bytes = FD_Table[index].counters.bytes;
 
     return true;
 }
 
+/** Reset the BBMD statistics and the counts of every entry.
+ */
+void bvlc_bbmd_stats_clear(
+    void)
+{
+    unsigned i = 0;
+
+    memset(&BBMD_Stats, 0, sizeof(BBMD_Stats));
+    for (i = 0; i < BBMD_Count; i++) {
+        BBMD_Counters[i].npdus = 0;
+        BBMD_Counters[i].bytes = 0;
+    }
+    for (i = 0; i < FD_Count; i++) {
+        FD_Table[i].counters.npdus = 0;
+        FD_Table[i].counters.bytes = 0;
+    }
+}
+
 /** Enable NAT handling and set the global IP address
  * @param [in] - Global IP address visible to peer BBMDs and foreign devices
  */
@@ -1809,6 +2172,106 @@ void testInternetAddress(
     ct_test(pTest, sin.sin_addr.s_addr == test_sin.sin_addr.s_addr);
 }
 
+#if defined(BBMD_ENABLED) && BBMD_ENABLED
+static void testBBMDTables(
+    Test * pTest)
+{
+    BBMD_TABLE_ENTRY entry = { 0 };
+    const BBMD_TABLE_ENTRY *table = NULL;
+    BVLC_BBMD_STATS stats = { 0 };
+    BVLC_PEER_STATS peer = { 0 };
+    struct sockaddr_in sin = { 0 };
+    uint8_t pdu[6] = { 0 };
+    uint8_t pdu_bdt[20] = { 0 };
+    unsigned i = 0;
+    unsigned count = 0;
+    bool status = false;
+
+    bvlc_clear_bdt_local();
+    bvlc_bbmd_stats_clear();
+    for (i = 0; i < MAX_BBMD_ENTRIES; i++) {
+        entry.dest_address.s_addr = htonl(0xC0A80001 + (i << 8));
+        entry.dest_port = htons(0xBAC0);
+        entry.broadcast_mask.s_addr = 0xFFFFFFFF;
+        status = bvlc_add_bdt_entry_local(&entry);
+        ct_test(pTest, status);
+    }
+    status = bvlc_add_bdt_entry_local(&entry);
+    ct_test(pTest, !status);
+    ct_test(pTest, bvlc_get_bdt_local(&table) == MAX_BBMD_ENTRIES);
+    ct_test(pTest, table[MAX_BBMD_ENTRIES - 1].valid);
+    sin.sin_addr.s_addr = htonl(0xC0A80001 + (7 << 8));
+    sin.sin_port = htons(0xBAC0);
+    ct_test(pTest, bvlc_bdt_member_mask_is_unicast(&sin));
+    sin.sin_port = htons(0xBAC1);
+    ct_test(pTest, !bvlc_bdt_member_mask_is_unicast(&sin));
+    bvlc_clear_bdt_local();
+    ct_test(pTest, bvlc_get_bdt_local(&table) == 0);
+    sin.sin_port = htons(0xBAC0);
+    ct_test(pTest, !bvlc_bdt_member_mask_is_unicast(&sin));
+    /* a BBMD listed twice in a Write-BDT keeps one entry */
+    entry.dest_address.s_addr = htonl(0x0A000001);
+    (void) bvlc_encode_address_entry(&pdu_bdt[0],
+        &entry.dest_address, entry.dest_port, &entry.broadcast_mask);
+    (void) bvlc_encode_address_entry(&pdu_bdt[10],
+        &entry.dest_address, entry.dest_port, &entry.broadcast_mask);
+    status = bvlc_create_bdt(pdu_bdt, 20);
+    ct_test(pTest, status);
+    ct_test(pTest, bvlc_get_bdt_local(&table) == 1);
+
+    /* foreign devices, with a different time to live each */
+    for (i = 0; i < MAX_FD_ENTRIES; i++) {
+        sin.sin_addr.s_addr = htonl(0xAC100001 + i);
+        sin.sin_port = htons(0xBAC0);
+        status = bvlc_register_foreign_device(&sin, (uint16_t) (i + 1));
+        ct_test(pTest, status);
+    }
+    sin.sin_addr.s_addr = htonl(0xAC100001 + MAX_FD_ENTRIES);
+    status = bvlc_register_foreign_device(&sin, 60);
+    ct_test(pTest, !status);
+    /* re-registration restarts the timer of the first one */
+    sin.sin_addr.s_addr = htonl(0xAC100001);
+    status = bvlc_register_foreign_device(&sin, 60000);
+    ct_test(pTest, status);
+    bvlc_bbmd_stats(&stats);
+    ct_test(pTest, stats.fdt_entries == MAX_FD_ENTRIES);
+    ct_test(pTest, stats.fd_registrations == MAX_FD_ENTRIES);
+    ct_test(pTest, stats.fd_renewals == 1);
+    ct_test(pTest, stats.fd_register_naks == 1);
+    /* delete the second one */
+    sin.sin_addr.s_addr = htonl(0xAC100002);
+    (void) bvlc_encode_bip_address(pdu, &sin.sin_addr, sin.sin_port);
+    ct_test(pTest, bvlc_delete_foreign_device(pdu));
+    ct_test(pTest, !bvlc_delete_foreign_device(pdu));
+    /* entries expire at their time to live plus 30 seconds grace */
+    bvlc_maintenance_timer(30 + 2);
+    bvlc_bbmd_stats(&stats);
+    ct_test(pTest, stats.fdt_entries == (MAX_FD_ENTRIES - 1));
+    ct_test(pTest, stats.fd_deletions == 1);
+    ct_test(pTest, stats.fd_expirations == 0);
+    for (i = 0; i < MAX_FD_ENTRIES; i++) {
+        bvlc_maintenance_timer(1);
+        bvlc_bbmd_stats(&stats);
+        count = (MAX_FD_ENTRIES - 2) - i;
+        if (i >= (MAX_FD_ENTRIES - 3)) {
+            count = 1;
+        }
+        ct_test(pTest, stats.fdt_entries == count);
+    }
+    ct_test(pTest, bvlc_fdt_peer_stats(0, &peer));
+    ct_test(pTest, peer.dest_address.s_addr == htonl(0xAC100001));
+    ct_test(pTest, peer.time_to_live == 60000);
+    ct_test(pTest, peer.seconds_remaining ==
+        (60000 + 30) - (30 + 2 + MAX_FD_ENTRIES));
+    ct_test(pTest, !bvlc_fdt_peer_stats(1, &peer));
+    bvlc_maintenance_timer(peer.seconds_remaining);
+    bvlc_bbmd_stats(&stats);
+    ct_test(pTest, stats.fdt_entries == 0);
+    ct_test(pTest, stats.fd_expirations == (MAX_FD_ENTRIES - 1));
+    bvlc_clear_bdt_local();
+}
+#endif
+
 #ifdef TEST_BVLC
 int main(
     void)
@@ -1822,6 +2285,10 @@ int main(
     assert(rc);
     rc = ct_addTestFunction(pTest, testInternetAddress);
     assert(rc);
+#if defined(BBMD_ENABLED) && BBMD_ENABLED
+    rc = ct_addTestFunction(pTest, testBBMDTables);
+    assert(rc);
+#endif
     /* configure output */
     ct_setStream(pTest, stdout);
     ct_run(pTest);
@@ -32,6 +32,7 @@
  -------------------------------------------
 ####COPYRIGHTEND####*/
 #include <stdint.h>
+#include <string.h>
 #include "bacenum.h"
 #include "bacdcode.h"
 #include "bacdef.h"
@@ -334,6 +335,379 @@ int cov_notify_decode_service_request(
     return len;
 }
 
+/*
+COVNotificationMultiple-Request ::= SEQUENCE {
+    subscriberProcessIdentifier  [0] Unsigned32,
+    initiatingDeviceIdentifier   [1] BACnetObjectIdentifier,
+    timeRemaining                [2] Unsigned,
+    timestamp                    [3] BACnetDateTime OPTIONAL,
+    listOfCOVNotifications       [4] SEQUENCE OF SEQUENCE {
+        monitoredObjectIdentifier    [0] BACnetObjectIdentifier,
+        listOfValues                 [1] SEQUENCE OF SEQUENCE {
+            propertyIdentifier           [0] BACnetPropertyIdentifier,
+            propertyArrayIndex           [1] Unsigned OPTIONAL,
+            propertyValue                [2] ABSTRACT-SYNTAX.&Type,
+            timeOfChange                 [3] Time OPTIONAL
+            }
+        }
+    }
+ConfirmedCOVNotificationMultiple and UnconfirmedCOVNotificationMultiple
+are the same.
+*/
+
+/**
+ * Encodes one element of the listOfCOVNotifications.
+ * Useful to find out how many notifications fit in an APDU.
+ *
+ * @param apdu - buffer for the encoding
+ * @param notification - the object and its values
+ * @return number of bytes encoded
+ */
+int cov_notification_encode(
+    uint8_t * apdu,
+    BACNET_COV_NOTIFICATION * notification)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = 0;   /* total length of the apdu, return value */
+    BACNET_PROPERTY_VALUE *value = NULL;        /* value in list */
+    BACNET_APPLICATION_DATA_VALUE *app_data = NULL;
+
+    if (apdu && notification) {
+        /* tag 0 - monitoredObjectIdentifier */
+        len =
+            encode_context_object_id(&apdu[apdu_len], 0,
+            (int) notification->monitoredObjectIdentifier.type,
+            notification->monitoredObjectIdentifier.instance);
+        apdu_len += len;
+        /* tag 1 - listOfValues */
+        len = encode_opening_tag(&apdu[apdu_len], 1);
+        apdu_len += len;
+        value = notification->listOfValues;
+        while (value != NULL) {
+            /* tag 0 - propertyIdentifier */
+            len =
+                encode_context_enumerated(&apdu[apdu_len], 0,
+                value->propertyIdentifier);
+            apdu_len += len;
+            /* tag 1 - propertyArrayIndex OPTIONAL */
+            if (value->propertyArrayIndex != BACNET_ARRAY_ALL) {
+                len =
+                    encode_context_unsigned(&apdu[apdu_len], 1,
+                    value->propertyArrayIndex);
+                apdu_len += len;
+            }
+            /* tag 2 - propertyValue */
+            len = encode_opening_tag(&apdu[apdu_len], 2);
+            apdu_len += len;
+            app_data = &value->value;
+            while (app_data != NULL) {
+                len =
+                    bacapp_encode_application_data(&apdu[apdu_len],
+                    app_data);
+                apdu_len += len;
+                app_data = app_data->next;
+            }
+            len = encode_closing_tag(&apdu[apdu_len], 2);
+            apdu_len += len;
+            /* tag 3 - timeOfChange OPTIONAL - not sent */
+            value = value->next;
+        }
+        len = encode_closing_tag(&apdu[apdu_len], 1);
+        apdu_len += len;
+    }
+
+    return apdu_len;
+}
+
+static int notify_multiple_encode_apdu(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    BACNET_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = 0;   /* total length of the apdu, return value */
+    BACNET_COV_NOTIFICATION *notification = NULL;
+    uint8_t buffer[MAX_APDU];
+
+    if (apdu) {
+        /* tag 0 - subscriberProcessIdentifier */
+        len =
+            encode_context_unsigned(&apdu[apdu_len], 0,
+            data->subscriberProcessIdentifier);
+        apdu_len += len;
+        /* tag 1 - initiatingDeviceIdentifier */
+        len =
+            encode_context_object_id(&apdu[apdu_len], 1, OBJECT_DEVICE,
+            data->initiatingDeviceIdentifier);
+        apdu_len += len;
+        /* tag 2 - timeRemaining */
+        len = encode_context_unsigned(&apdu[apdu_len], 2, data->timeRemaining);
+        apdu_len += len;
+        /* tag 3 - timestamp OPTIONAL - not sent */
+        /* tag 4 - listOfCOVNotifications */
+        len = encode_opening_tag(&apdu[apdu_len], 4);
+        apdu_len += len;
+        notification = data->listOfCOVNotifications;
+        while (notification != NULL) {
+            /* check to see if there is room in the APDU */
+            len = cov_notification_encode(&buffer[0], notification);
+            if ((apdu_len + len + 1) > max_apdu_len) {
+                return BACNET_STATUS_ABORT;
+            }
+            memcpy(&apdu[apdu_len], &buffer[0], len);
+            apdu_len += len;
+            notification = notification->next;
+        }
+        len = encode_closing_tag(&apdu[apdu_len], 4);
+        apdu_len += len;
+    }
+
+    return apdu_len;
+}
+
+int ccov_notify_multiple_encode_apdu(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    uint8_t invoke_id,
+    BACNET_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = BACNET_STATUS_ERROR;   /* return value */
+
+    if (apdu && data && memcopylen(0, max_apdu_len, 4)) {
+        apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+        apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+        apdu[2] = invoke_id;
+        apdu[3] = SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE;
+        apdu_len = 4;
+        len = notify_multiple_encode_apdu(&apdu[apdu_len],
+            max_apdu_len - apdu_len, data);
+        if (len < 0) {
+            /* return the error */
+            apdu_len = len;
+        } else {
+            apdu_len += len;
+        }
+    }
+
+    return apdu_len;
+}
+
+int ucov_notify_multiple_encode_apdu(
+    uint8_t * apdu,
+    unsigned max_apdu_len,
+    BACNET_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;        /* length of each encoding */
+    int apdu_len = BACNET_STATUS_ERROR;   /* return value */
+
+    if (apdu && data && memcopylen(0, max_apdu_len, 2)) {
+        apdu[0] = PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST;
+        apdu[1] = SERVICE_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE;
+        apdu_len = 2;
+        len = notify_multiple_encode_apdu(&apdu[apdu_len],
+            max_apdu_len - apdu_len, data);
+        if (len < 0) {
+            /* return the error */
+            apdu_len = len;
+        } else {
+            apdu_len += len;
+        }
+    }
+
+    return apdu_len;
+}
+
+/* decode the service request only */
+/* COV Multiple and Unconfirmed COV Multiple are the same */
+int cov_notify_multiple_decode_service_request(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    BACNET_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;        /* return value */
+    int app_len = 0;
+    uint8_t tag_number = 0;
+    uint32_t len_value = 0;
+    uint32_t decoded_value = 0; /* for decoding */
+    uint16_t decoded_type = 0;  /* for decoding */
+    uint32_t property = 0;      /* for decoding */
+    BACNET_DATE bdate;
+    BACNET_TIME btime;
+    BACNET_COV_NOTIFICATION *notification = NULL;
+    BACNET_PROPERTY_VALUE *value = NULL;        /* value in list */
+    BACNET_APPLICATION_DATA_VALUE *app_data = NULL;
+
+    if (apdu_len && data) {
+        /* tag 0 - subscriberProcessIdentifier */
+        if (decode_is_context_tag(&apdu[len], 0)) {
+            len +=
+                decode_tag_number_and_value(&apdu[len], &tag_number,
+                &len_value);
+            len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+            data->subscriberProcessIdentifier = decoded_value;
+        } else {
+            return BACNET_STATUS_ERROR;
+        }
+        /* tag 1 - initiatingDeviceIdentifier */
+        if (decode_is_context_tag(&apdu[len], 1)) {
+            len +=
+                decode_tag_number_and_value(&apdu[len], &tag_number,
+                &len_value);
+            len +=
+                decode_object_id(&apdu[len], &decoded_type,
+                &data->initiatingDeviceIdentifier);
+            if (decoded_type != OBJECT_DEVICE) {
+                return BACNET_STATUS_ERROR;
+            }
+        } else {
+            return BACNET_STATUS_ERROR;
+        }
+        /* tag 2 - timeRemaining */
+        if (decode_is_context_tag(&apdu[len], 2)) {
+            len +=
+                decode_tag_number_and_value(&apdu[len], &tag_number,
+                &len_value);
+            len += decode_unsigned(&apdu[len], len_value, &decoded_value);
+            data->timeRemaining = decoded_value;
+        } else {
+            return BACNET_STATUS_ERROR;
+        }
+        /* tag 3 - timestamp OPTIONAL - skipped */
+        if (decode_is_opening_tag_number(&apdu[len], 3)) {
+            len++;
+            app_len = decode_application_date(&apdu[len], &bdate);
+            if (app_len < 0) {
+                return BACNET_STATUS_ERROR;
+            }
+            len += app_len;
+            app_len = decode_application_time(&apdu[len], &btime);
+            if (app_len < 0) {
+                return BACNET_STATUS_ERROR;
+            }
+            len += app_len;
+            if (!decode_is_closing_tag_number(&apdu[len], 3)) {
+                return BACNET_STATUS_ERROR;
+            }
+            len++;
+        }
+        /* tag 4: opening context tag - listOfCOVNotifications */
+        if (!decode_is_opening_tag_number(&apdu[len], 4)) {
+            return BACNET_STATUS_ERROR;
+        }
+        len++;
+        notification = data->listOfCOVNotifications;
+        if (notification == NULL) {
+            /* no space to store any notifications */
+            return BACNET_STATUS_ERROR;
+        }
+        while (notification != NULL) {
+            /* tag 0 - monitoredObjectIdentifier */
+            if (decode_is_context_tag(&apdu[len], 0)) {
+                len +=
+                    decode_tag_number_and_value(&apdu[len], &tag_number,
+                    &len_value);
+                len +=
+                    decode_object_id(&apdu[len], &decoded_type,
+                    &notification->monitoredObjectIdentifier.instance);
+                notification->monitoredObjectIdentifier.type = decoded_type;
+            } else {
+                return BACNET_STATUS_ERROR;
+            }
+            /* tag 1: opening context tag - listOfValues */
+            if (!decode_is_opening_tag_number(&apdu[len], 1)) {
+                return BACNET_STATUS_ERROR;
+            }
+            len++;
+            value = notification->listOfValues;
+            if (value == NULL) {
+                /* no space to store any values */
+                return BACNET_STATUS_ERROR;
+            }
+            while (value != NULL) {
+                /* tag 0 - propertyIdentifier */
+                if (decode_is_context_tag(&apdu[len], 0)) {
+                    len +=
+                        decode_tag_number_and_value(&apdu[len], &tag_number,
+                        &len_value);
+                    len += decode_enumerated(&apdu[len], len_value, &property);
+                    value->propertyIdentifier = (BACNET_PROPERTY_ID) property;
+                } else {
+                    return BACNET_STATUS_ERROR;
+                }
+                /* tag 1 - propertyArrayIndex OPTIONAL */
+                if (decode_is_context_tag(&apdu[len], 1)) {
+                    len +=
+                        decode_tag_number_and_value(&apdu[len], &tag_number,
+                        &len_value);
+                    len +=
+                        decode_unsigned(&apdu[len], len_value,
+                        &decoded_value);
+                    value->propertyArrayIndex = decoded_value;
+                } else {
+                    value->propertyArrayIndex = BACNET_ARRAY_ALL;
+                }
+                /* tag 2: opening context tag - propertyValue */
+                if (!decode_is_opening_tag_number(&apdu[len], 2)) {
+                    return BACNET_STATUS_ERROR;
+                }
+                len++;
+                app_data = &value->value;
+                while (!decode_is_closing_tag_number(&apdu[len], 2)) {
+                    if (app_data == NULL) {
+                        /* out of room to store more values */
+                        return BACNET_STATUS_ERROR;
+                    }
+                    app_len =
+                        bacapp_decode_application_data(&apdu[len],
+                        apdu_len - len, app_data);
+                    if (app_len < 0) {
+                        return BACNET_STATUS_ERROR;
+                    }
+                    len += app_len;
+                    app_data = app_data->next;
+                }
+                len++;
+                /* tag 3 - timeOfChange OPTIONAL - skipped */
+                if (decode_is_context_tag(&apdu[len], 3)) {
+                    app_len = decode_context_bacnet_time(&apdu[len], 3, &btime);
+                    if (app_len < 0) {
+                        return BACNET_STATUS_ERROR;
+                    }
+                    len += app_len;
+                }
+                value->priority = BACNET_NO_PRIORITY;
+                /* end of list? */
+                if (decode_is_closing_tag_number(&apdu[len], 1)) {
+                    value->next = NULL;
+                    break;
+                }
+                /* is there another one to decode? */
+                value = value->next;
+                if (value == NULL) {
+                    /* out of room to store more values */
+                    return BACNET_STATUS_ERROR;
+                }
+            }
+            len++;
+            /* end of list? */
+            if (decode_is_closing_tag_number(&apdu[len], 4)) {
+                notification->next = NULL;
+                break;
+            }
+            /* is there another one to decode? */
+            notification = notification->next;
+            if (notification == NULL) {
+                /* out of room to store more notifications */
+                return BACNET_STATUS_ERROR;
+            }
+        }
+        len++;
+    }
+
+    return len;
+}
+
 /*
 12.11.38Active_COV_Subscriptions
 The Active_COV_Subscriptions property is a List of BACnetCOVSubscription,
@@ -760,6 +1134,62 @@ int ucov_notify_decode_apdu(
     return len;
 }
 
+int ccov_notify_multiple_decode_apdu(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    uint8_t * invoke_id,
+    BACNET_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;
+    unsigned offset = 0;
+
+    if (!apdu) {
+        return -1;
+    }
+    /* optional checking - most likely was already done prior to this call */
+    if (apdu[0] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
+        return -2;
+    *invoke_id = apdu[2];       /* invoke id - filled in by net layer */
+    if (apdu[3] != SERVICE_CONFIRMED_COV_NOTIFICATION_MULTIPLE)
+        return -3;
+    offset = 4;
+
+    /* optional limits - must be used as a pair */
+    if (apdu_len > offset) {
+        len =
+            cov_notify_multiple_decode_service_request(&apdu[offset],
+            apdu_len - offset, data);
+    }
+
+    return len;
+}
+
+int ucov_notify_multiple_decode_apdu(
+    uint8_t * apdu,
+    unsigned apdu_len,
+    BACNET_COV_MULTIPLE_DATA * data)
+{
+    int len = 0;
+    unsigned offset = 0;
+
+    if (!apdu)
+        return -1;
+    /* optional checking - most likely was already done prior to this call */
+    if (apdu[0] != PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST)
+        return -2;
+    if (apdu[1] != SERVICE_UNCONFIRMED_COV_NOTIFICATION_MULTIPLE)
+        return -3;
+    /* optional limits - must be used as a pair */
+    offset = 2;
+    if (apdu_len > offset) {
+        len =
+            cov_notify_multiple_decode_service_request(&apdu[offset],
+            apdu_len - offset, data);
+    }
+
+    return len;
+}
+
 int cov_subscribe_decode_apdu(
     uint8_t * apdu,
     unsigned apdu_len,
@@ -938,6 +1368,102 @@ void testCOVNotify(
     testCCOVNotifyData(pTest, invoke_id, &data);
 }
 
+void testCOVNotifyMultiple(
+    Test * pTest)
+{
+    uint8_t apdu[480] = { 0 };
+    int len = 0;
+    int apdu_len = 0;
+    unsigned i = 0;
+    uint8_t invoke_id = 34;
+    uint8_t test_invoke_id = 0;
+    BACNET_COV_MULTIPLE_DATA data;
+    BACNET_COV_MULTIPLE_DATA test_data;
+    BACNET_COV_NOTIFICATION notification[3];
+    BACNET_COV_NOTIFICATION test_notification[4];
+    BACNET_PROPERTY_VALUE value_list[3][2];
+    BACNET_PROPERTY_VALUE test_value_list[4][2];
+    BACNET_COV_NOTIFICATION *pNotification = NULL;
+    BACNET_COV_NOTIFICATION *pTest_Notification = NULL;
+    BACNET_COV_DATA cov_data = { 0 };
+    BACNET_COV_DATA test_cov_data = { 0 };
+
+    memset(value_list, 0, sizeof(value_list));
+    data.subscriberProcessIdentifier = 1;
+    data.initiatingDeviceIdentifier = 123;
+    data.timeRemaining = 456;
+    data.listOfCOVNotifications = &notification[0];
+    for (i = 0; i < 3; i++) {
+        notification[i].monitoredObjectIdentifier.type = OBJECT_ANALOG_INPUT;
+        notification[i].monitoredObjectIdentifier.instance = 321 + i;
+        cov_data_value_list_link(&cov_data, &value_list[i][0], 2);
+        notification[i].listOfValues = cov_data.listOfValues;
+        notification[i].next = (i < 2) ? &notification[i + 1] : NULL;
+        value_list[i][0].propertyIdentifier = PROP_PRESENT_VALUE;
+        value_list[i][0].propertyArrayIndex = BACNET_ARRAY_ALL;
+        bacapp_parse_application_data(BACNET_APPLICATION_TAG_REAL, "21.0",
+            &value_list[i][0].value);
+        value_list[i][0].priority = BACNET_NO_PRIORITY;
+        value_list[i][1].propertyIdentifier = PROP_STATUS_FLAGS;
+        value_list[i][1].propertyArrayIndex = BACNET_ARRAY_ALL;
+        bacapp_parse_application_data(BACNET_APPLICATION_TAG_BIT_STRING,
+            "0000", &value_list[i][1].value);
+        value_list[i][1].priority = BACNET_NO_PRIORITY;
+    }
+    /* room for more notifications than were sent */
+    memset(test_value_list, 0, sizeof(test_value_list));
+    for (i = 0; i < 4; i++) {
+        cov_data_value_list_link(&test_cov_data, &test_value_list[i][0], 2);
+        test_notification[i].listOfValues = test_cov_data.listOfValues;
+        test_notification[i].next = (i < 3) ? &test_notification[i + 1] : NULL;
+    }
+    test_data.listOfCOVNotifications = &test_notification[0];
+
+    len = ucov_notify_multiple_encode_apdu(&apdu[0], sizeof(apdu), &data);
+    ct_test(pTest, len > 0);
+    apdu_len = len;
+    len = ucov_notify_multiple_decode_apdu(&apdu[0], apdu_len, &test_data);
+    ct_test(pTest, len > 0);
+    ct_test(pTest, len == (apdu_len - 2));
+    len = ccov_notify_multiple_encode_apdu(&apdu[0], sizeof(apdu), invoke_id,
+        &data);
+    ct_test(pTest, len > 0);
+    apdu_len = len;
+    len =
+        ccov_notify_multiple_decode_apdu(&apdu[0], apdu_len, &test_invoke_id,
+        &test_data);
+    ct_test(pTest, len == (apdu_len - 4));
+    ct_test(pTest, test_invoke_id == invoke_id);
+    ct_test(pTest,
+        test_data.subscriberProcessIdentifier ==
+        data.subscriberProcessIdentifier);
+    ct_test(pTest,
+        test_data.initiatingDeviceIdentifier ==
+        data.initiatingDeviceIdentifier);
+    ct_test(pTest, test_data.timeRemaining == data.timeRemaining);
+    pNotification = data.listOfCOVNotifications;
+    pTest_Notification = test_data.listOfCOVNotifications;
+    while (pNotification) {
+        ct_test(pTest, pTest_Notification != NULL);
+        if (!pTest_Notification) {
+            break;
+        }
+        cov_data.listOfValues = pNotification->listOfValues;
+        cov_data.monitoredObjectIdentifier =
+            pNotification->monitoredObjectIdentifier;
+        test_cov_data.listOfValues = pTest_Notification->listOfValues;
+        test_cov_data.monitoredObjectIdentifier =
+            pTest_Notification->monitoredObjectIdentifier;
+        testCOVNotifyData(pTest, &cov_data, &test_cov_data);
+        pNotification = pNotification->next;
+        pTest_Notification = pTest_Notification->next;
+    }
+    ct_test(pTest, pTest_Notification == NULL);
+    /* the notifications have to fit */
+    len = ucov_notify_multiple_encode_apdu(&apdu[0], 40, &data);
+    ct_test(pTest, len == BACNET_STATUS_ABORT);
+}
+
 void testCOVSubscribeData(
     Test * pTest,
     BACNET_SUBSCRIBE_COV_DATA * data,
@@ -1088,6 +1614,8 @@ int main(
     /* individual tests */
     rc = ct_addTestFunction(pTest, testCOVNotify);
     assert(rc);
+    rc = ct_addTestFunction(pTest, testCOVNotifyMultiple);
+    assert(rc);
     rc = ct_addTestFunction(pTest, testCOVSubscribe);
     assert(rc);
     rc = ct_addTestFunction(pTest, testCOVSubscribeProperty);
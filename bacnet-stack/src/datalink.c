@@ -75,6 +75,23 @@ int (
 uint16_t(*datalink_receive) (BACNET_ADDRESS * src, uint8_t * pdu,
     uint16_t max_pdu, unsigned timeout);
 
+/** Function template to get the number of packets that were already
+ * received in a batch, which datalink_receive returns without waiting.
+ * @ingroup DLTemplates
+ *
+ * @return The number of packets waiting, or zero.
+ */
+unsigned (
+    *datalink_receive_pending) (
+    void);
+
+/* for the datalinks that receive one packet at a time */
+static unsigned datalink_no_receive_pending(
+    void)
+{
+    return 0;
+}
+
 /** Function template to close the DataLink services and perform any cleanup.
  * @ingroup DLTemplates
  */
@@ -97,6 +114,7 @@ void datalink_set(
         datalink_init = bip_init;
         datalink_send_pdu = bip_send_pdu;
         datalink_receive = bip_receive;
+        datalink_receive_pending = bip_receive_pending;
         datalink_cleanup = bip_cleanup;
         datalink_get_broadcast_address = bip_get_broadcast_address;
         datalink_get_my_address = bip_get_my_address;
@@ -104,6 +122,7 @@ void datalink_set(
         datalink_init = bip_init;
         datalink_send_pdu = bvlc_send_pdu;
         datalink_receive = bvlc_receive;
+        datalink_receive_pending = bip_receive_pending;
         datalink_cleanup = bip_cleanup;
         datalink_get_broadcast_address = bip_get_broadcast_address;
         datalink_get_my_address = bip_get_my_address;
@@ -111,6 +130,7 @@ void datalink_set(
         datalink_init = ethernet_init;
         datalink_send_pdu = ethernet_send_pdu;
         datalink_receive = ethernet_receive;
+        datalink_receive_pending = datalink_no_receive_pending;
         datalink_cleanup = ethernet_cleanup;
         datalink_get_broadcast_address = ethernet_get_broadcast_address;
         datalink_get_my_address = ethernet_get_my_address;
@@ -118,6 +138,7 @@ void datalink_set(
         datalink_init = arcnet_init;
         datalink_send_pdu = arcnet_send_pdu;
         datalink_receive = arcnet_receive;
+        datalink_receive_pending = datalink_no_receive_pending;
         datalink_cleanup = arcnet_cleanup;
         datalink_get_broadcast_address = arcnet_get_broadcast_address;
         datalink_get_my_address = arcnet_get_my_address;
@@ -125,6 +146,7 @@ void datalink_set(
         datalink_init = dlmstp_init;
         datalink_send_pdu = dlmstp_send_pdu;
         datalink_receive = dlmstp_receive;
+        datalink_receive_pending = datalink_no_receive_pending;
         datalink_cleanup = dlmstp_cleanup;
         datalink_get_broadcast_address = dlmstp_get_broadcast_address;
         datalink_get_my_address = dlmstp_get_my_address;
@@ -0,0 +1,451 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "hashindex.h"
+
+/** @file hashindex.c  Open addressing hash index of a table of entries */
+
+/* The index uses linear probing.  An entry that is removed leaves no
+   tombstone: the entries that follow it in the probe run are moved
+   back into the hole when their home slot allows it, so that a lookup
+   always stops at the first empty slot. */
+
+/**
+ * Mix the bits of a key, so that keys that only differ in their high
+ * bits, or that are sequential, spread over the slots.
+ *
+ * @param key - the key, or a combination of the fields of a key
+ * @return the hash of the key
+ */
+uint32_t hash_index_mix(
+    uint32_t key)
+{
+    /* Fibonacci hashing, so that the varying bits reach the low bits */
+    key *= (uint32_t) 2654435761UL;
+    key ^= key >> 16;
+
+    return key;
+}
+
+/**
+ * Start an empty index.
+ *
+ * @param h - the index
+ * @param slots - array of size slots of width octets each
+ * @param width - size of a slot: 2 for uint16_t or 4 for uint32_t
+ * @param size - number of slots, more than the number of entries
+ * @param home - gives the hash of the key of the entry at an index
+ */
+void hash_index_init(
+    HASH_INDEX * h,
+    void *slots,
+    unsigned width,
+    unsigned size,
+    uint32_t(*home) (uint32_t index))
+{
+    h->slots = slots;
+    h->width = width;
+    h->size = size;
+    h->home = home;
+    hash_index_clear(h);
+}
+
+/**
+ * Remove every entry from the index.
+ *
+ * @param h - the index
+ */
+void hash_index_clear(
+    HASH_INDEX * h)
+{
+    if (h->slots && h->size) {
+        memset(h->slots, 0, (size_t) h->size * h->width);
+    }
+}
+
+/**
+ * @param h - the index
+ * @param hash - the hash of a key
+ * @return the home slot of the key, where its probe run starts
+ */
+unsigned hash_index_start(
+    HASH_INDEX const *h,
+    uint32_t hash)
+{
+    return (unsigned) (hash % h->size);
+}
+
+/**
+ * @param h - the index
+ * @param slot - a slot of the probe run
+ * @return the slot after it, wrapping around to the first slot
+ */
+unsigned hash_index_next(
+    HASH_INDEX const *h,
+    unsigned slot)
+{
+    slot++;
+    if (slot >= h->size)
+        slot = 0;
+
+    return slot;
+}
+
+/**
+ * @param h - the index
+ * @param slot - the slot
+ * @return the index plus one of the entry in the slot,
+ *  or zero if the slot is empty
+ */
+uint32_t hash_index_get(
+    HASH_INDEX const *h,
+    unsigned slot)
+{
+    if (h->width == sizeof(uint16_t)) {
+        return ((uint16_t *) h->slots)[slot];
+    }
+
+    return ((uint32_t *) h->slots)[slot];
+}
+
+/**
+ * Put an entry in a slot, which is normally an empty slot found
+ * by probing from the home slot of its key.
+ *
+ * @param h - the index
+ * @param slot - the slot
+ * @param index - the index of the entry
+ */
+void hash_index_set(
+    HASH_INDEX * h,
+    unsigned slot,
+    uint32_t index)
+{
+    if (h->width == sizeof(uint16_t)) {
+        ((uint16_t *) h->slots)[slot] = (uint16_t) (index + 1);
+    } else {
+        ((uint32_t *) h->slots)[slot] = index + 1;
+    }
+}
+
+static void hash_index_empty(
+    HASH_INDEX * h,
+    unsigned slot)
+{
+    if (h->width == sizeof(uint16_t)) {
+        ((uint16_t *) h->slots)[slot] = 0;
+    } else {
+        ((uint32_t *) h->slots)[slot] = 0;
+    }
+}
+
+/**
+ * Find the slot that holds an entry.  The key of the entry must not
+ * have changed since it was added.
+ *
+ * @param h - the index
+ * @param index - the index of the entry
+ * @return the slot of the entry, or an empty slot if it is not indexed
+ */
+unsigned hash_index_slot(
+    HASH_INDEX const *h,
+    uint32_t index)
+{
+    unsigned slot;
+    uint32_t value;
+
+    slot = hash_index_start(h, h->home(index));
+    for (;;) {
+        value = hash_index_get(h, slot);
+        if ((value == 0) || (value == (index + 1))) {
+            break;
+        }
+        slot = hash_index_next(h, slot);
+    }
+
+    return slot;
+}
+
+/**
+ * Add an entry, by the hash of its key.  The index must have room.
+ *
+ * @param h - the index
+ * @param index - the index of the entry
+ */
+void hash_index_insert(
+    HASH_INDEX * h,
+    uint32_t index)
+{
+    unsigned slot;
+
+    slot = hash_index_start(h, h->home(index));
+    while (hash_index_get(h, slot) != 0) {
+        slot = hash_index_next(h, slot);
+    }
+    hash_index_set(h, slot, index);
+}
+
+/**
+ * Remove an entry, and move back any following entries of the probe
+ * run, so that no lookup needs tombstones.  The key of the entry must
+ * not have changed since it was added.
+ *
+ * @param h - the index
+ * @param index - the index of the entry, which may not be indexed
+ */
+void hash_index_remove(
+    HASH_INDEX * h,
+    uint32_t index)
+{
+    unsigned hole, next, slot_home;
+    uint32_t value;
+
+    hole = hash_index_slot(h, index);
+    if (hash_index_get(h, hole) == 0) {
+        return;
+    }
+    hash_index_empty(h, hole);
+    next = hole;
+    for (;;) {
+        next = hash_index_next(h, next);
+        value = hash_index_get(h, next);
+        if (value == 0)
+            break;
+        slot_home = hash_index_start(h, h->home(value - 1));
+        /* move it if its home slot is not cyclically in (hole, next] */
+        if ((hole <= next) ? ((slot_home <= hole) ||
+                (slot_home > next)) : ((slot_home <= hole) &&
+                (slot_home > next))) {
+            hash_index_set(h, hole, value - 1);
+            hash_index_empty(h, next);
+            hole = next;
+        }
+    }
+}
+
+/**
+ * Give an entry a new index, as a packed table does when its last
+ * entry is moved into the place of one that was removed.  It must be
+ * called before the entry is copied, while the key at the old index
+ * is still the key of the entry.
+ *
+ * @param h - the index
+ * @param from - the old index of the entry
+ * @param to - the new index of the entry
+ */
+void hash_index_move(
+    HASH_INDEX * h,
+    uint32_t from,
+    uint32_t to)
+{
+    unsigned slot;
+
+    slot = hash_index_slot(h, from);
+    if (hash_index_get(h, slot) != 0) {
+        hash_index_set(h, slot, to);
+    }
+}
+
+#ifdef TEST
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include "ctest.h"
+
+#define TEST_HASH_ENTRIES 64
+static uint32_t Test_Keys[TEST_HASH_ENTRIES];
+static unsigned Test_Key_Count;
+static uint16_t Test_Slots[HASH_INDEX_SIZE(TEST_HASH_ENTRIES)];
+
+static uint32_t(*Test_Key_Hash) (uint32_t key);
+
+/* every key is in the same home slot, so that each probe run is long */
+static uint32_t test_key_same(
+    uint32_t key)
+{
+    (void) key;
+
+    return 7;
+}
+
+static uint32_t test_home(
+    uint32_t index)
+{
+    return Test_Key_Hash(Test_Keys[index]);
+}
+
+static int test_find(
+    HASH_INDEX * h,
+    uint32_t key)
+{
+    unsigned slot;
+    uint32_t value;
+
+    slot = hash_index_start(h, Test_Key_Hash(key));
+    while ((value = hash_index_get(h, slot)) != 0) {
+        if (Test_Keys[value - 1] == key) {
+            return (int) (value - 1);
+        }
+        slot = hash_index_next(h, slot);
+    }
+
+    return -1;
+}
+
+/* remove an entry, and pack the table with its last entry */
+static void test_remove(
+    HASH_INDEX * h,
+    unsigned index)
+{
+    unsigned last = Test_Key_Count - 1;
+
+    hash_index_remove(h, index);
+    if (index != last) {
+        hash_index_move(h, last, index);
+        Test_Keys[index] = Test_Keys[last];
+    }
+    Test_Key_Count = last;
+}
+
+static void testHashIndexKeys(
+    Test * pTest,
+    uint32_t(*key_hash) (uint32_t key))
+{
+    HASH_INDEX h;
+    uint32_t used[HASH_INDEX_SIZE(TEST_HASH_ENTRIES)];
+    unsigned i, j, slot, count;
+
+    Test_Key_Hash = key_hash;
+    hash_index_init(&h, Test_Slots, sizeof(Test_Slots[0]),
+        HASH_INDEX_SIZE(TEST_HASH_ENTRIES), test_home);
+    Test_Key_Count = 0;
+    for (i = 0; i < TEST_HASH_ENTRIES; i++) {
+        Test_Keys[i] = (i * 1000) + 1;
+        hash_index_insert(&h, i);
+        Test_Key_Count++;
+    }
+    for (i = 0; i < TEST_HASH_ENTRIES; i++) {
+        ct_test(pTest, test_find(&h, (i * 1000) + 1) == (int) i);
+        slot = hash_index_slot(&h, i);
+        ct_test(pTest, hash_index_get(&h, slot) == (i + 1));
+    }
+    ct_test(pTest, test_find(&h, 2) == -1);
+    /* remove every third key, packing the table as it goes */
+    for (i = 0; i < TEST_HASH_ENTRIES; i += 3) {
+        j = (unsigned) test_find(&h, (i * 1000) + 1);
+        test_remove(&h, j);
+    }
+    for (i = 0; i < TEST_HASH_ENTRIES; i++) {
+        if ((i % 3) == 0) {
+            ct_test(pTest, test_find(&h, (i * 1000) + 1) == -1);
+        } else {
+            j = (unsigned) test_find(&h, (i * 1000) + 1);
+            ct_test(pTest, j < Test_Key_Count);
+            ct_test(pTest, Test_Keys[j] == (i * 1000) + 1);
+        }
+    }
+    /* each entry is in exactly one slot */
+    memset(used, 0, sizeof(used));
+    count = 0;
+    for (slot = 0; slot < h.size; slot++) {
+        if (hash_index_get(&h, slot)) {
+            used[hash_index_get(&h, slot) - 1]++;
+            count++;
+        }
+    }
+    ct_test(pTest, count == Test_Key_Count);
+    for (i = 0; i < Test_Key_Count; i++) {
+        ct_test(pTest, used[i] == 1);
+    }
+    /* an entry that is not indexed is not removed */
+    Test_Keys[Test_Key_Count] = 2;
+    hash_index_remove(&h, Test_Key_Count);
+    for (slot = 0, count = 0; slot < h.size; slot++) {
+        if (hash_index_get(&h, slot)) {
+            count++;
+        }
+    }
+    ct_test(pTest, count == Test_Key_Count);
+    hash_index_clear(&h);
+    ct_test(pTest, test_find(&h, 1001) == -1);
+}
+
+/**
+* Unit Test for the hash index
+*
+* @param pTest - test tracking pointer
+*/
+void testHashIndex(
+    Test * pTest)
+{
+    HASH_INDEX h;
+    uint32_t slots[HASH_INDEX_SIZE(4)];
+
+    testHashIndexKeys(pTest, hash_index_mix);
+    testHashIndexKeys(pTest, test_key_same);
+    /* slots of four octets */
+    hash_index_init(&h, slots, sizeof(slots[0]), HASH_INDEX_SIZE(4),
+        test_home);
+    Test_Keys[0] = 70000;
+    Test_Key_Count = 1;
+    hash_index_insert(&h, 0);
+    ct_test(pTest, test_find(&h, 70000) == 0);
+    hash_index_remove(&h, 0);
+    ct_test(pTest, test_find(&h, 70000) == -1);
+    ct_test(pTest, hash_index_mix(1) != hash_index_mix(2));
+
+    return;
+}
+
+#ifdef TEST_HASH_INDEX
+/**
+* Main program entry for Unit Test
+*
+* @return  returns 0 on success, and non-zero on fail.
+*/
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("Hash Index", NULL);
+
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testHashIndex);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+
+    ct_destroy(pTest);
+
+    return 0;
+}
+#endif
+#endif
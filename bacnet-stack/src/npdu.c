@@ -581,6 +581,14 @@ void tsm_free_invoke_id(
     (void) invokeID;
 }
 
+void tsm_free_peer_invoke_id(
+    BACNET_ADDRESS * src,
+    uint8_t invokeID)
+{
+    (void) src;
+    (void) invokeID;
+}
+
 void iam_handler(
     uint8_t * service_request,
     uint16_t service_len,
@@ -0,0 +1,931 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "config.h"
+#include "bacdef.h"
+#include "bacapp.h"
+#include "hashindex.h"
+#include "propcache.h"
+
+/** @file propcache.c  Cache of property values read from other devices */
+
+/* The values are kept as encoded application data, as they arrive in
+   a ReadProperty ack, keyed by device, object, property and array index.
+   The entries are packed at the start of the table, and indexed with a
+   hash index (see hashindex.c).  An entry can also hold the invoke ID
+   of a ReadProperty in flight for its property, so that other readers
+   of the same property wait for that reply instead of sending their own,
+   and the invoke IDs are mapped back to their entry. */
+typedef uint16_t PROPERTY_CACHE_INDEX;
+
+/* the entry holds a value, which may be fresh or stale */
+#define PROPERTY_CACHE_VALUE 0x01
+/* the value came from a COV notification */
+#define PROPERTY_CACHE_COV 0x02
+
+struct Property_Cache_Entry {
+    uint32_t device_id;
+    uint32_t object_instance;
+    uint32_t object_property;
+    uint32_t array_index;
+    uint16_t object_type;
+    uint8_t flags;
+    /* invoke ID of a read in flight for this property, or 0 */
+    uint8_t invoke_id;
+    /* seconds since the value was updated, and how long it is fresh */
+    uint32_t age;
+    uint32_t ttl;
+    uint16_t data_len;
+    uint8_t data[MAX_PROPERTY_CACHE_DATA];
+};
+
+static struct Property_Cache_Entry Property_Cache[MAX_PROPERTY_CACHE];
+static PROPERTY_CACHE_INDEX
+    Property_Cache_Hash[HASH_INDEX_SIZE(MAX_PROPERTY_CACHE)];
+static PROPERTY_CACHE_INDEX Property_Cache_Invoke[256];
+/* number of entries in use, at the start of the table */
+static unsigned Property_Cache_Count;
+static PROPERTY_CACHE_STATS Property_Cache_Stats;
+
+static uint32_t property_cache_hash(
+    uint32_t device_id,
+    uint16_t object_type,
+    uint32_t object_instance,
+    uint32_t object_property,
+    uint32_t array_index)
+{
+    uint32_t hash;
+
+    hash = device_id;
+    hash = (hash * 31) ^ (((uint32_t) object_type << 22) ^ object_instance);
+    hash = (hash * 31) ^ object_property;
+    hash = (hash * 31) ^ array_index;
+
+    return hash_index_mix(hash);
+}
+
+static uint32_t property_cache_home(
+    uint32_t index)
+{
+    struct Property_Cache_Entry *pEntry = &Property_Cache[index];
+
+    return property_cache_hash(pEntry->device_id, pEntry->object_type,
+        pEntry->object_instance, pEntry->object_property,
+        pEntry->array_index);
+}
+
+static HASH_INDEX Property_Cache_Index = {
+    Property_Cache_Hash, sizeof(PROPERTY_CACHE_INDEX),
+    HASH_INDEX_SIZE(MAX_PROPERTY_CACHE), property_cache_home
+};
+
+/* Find the entry for a property.  Returns the index, or -1 if not found. */
+static int property_cache_find(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index)
+{
+    struct Property_Cache_Entry *pEntry;
+    unsigned slot;
+    uint32_t value;
+
+    slot =
+        hash_index_start(&Property_Cache_Index,
+        property_cache_hash(device_id, (uint16_t) object_type,
+            object_instance, (uint32_t) object_property, array_index));
+    while ((value = hash_index_get(&Property_Cache_Index, slot)) != 0) {
+        pEntry = &Property_Cache[value - 1];
+        if ((pEntry->device_id == device_id) &&
+            (pEntry->object_type == (uint16_t) object_type) &&
+            (pEntry->object_instance == object_instance) &&
+            (pEntry->object_property == (uint32_t) object_property) &&
+            (pEntry->array_index == array_index)) {
+            return (int) (value - 1);
+        }
+        slot = hash_index_next(&Property_Cache_Index, slot);
+    }
+
+    return -1;
+}
+
+/* Remove an entry, and move the last entry into its place
+   so that the table stays packed. */
+static void property_cache_remove(
+    unsigned index)
+{
+    unsigned last;
+
+    hash_index_remove(&Property_Cache_Index, index);
+    if (Property_Cache[index].invoke_id) {
+        Property_Cache_Invoke[Property_Cache[index].invoke_id] = 0;
+    }
+    last = Property_Cache_Count - 1;
+    if (index != last) {
+        hash_index_move(&Property_Cache_Index, last, index);
+        if (Property_Cache[last].invoke_id) {
+            Property_Cache_Invoke[Property_Cache[last].invoke_id] =
+                (PROPERTY_CACHE_INDEX) (index + 1);
+        }
+        Property_Cache[index] = Property_Cache[last];
+    }
+    Property_Cache_Count--;
+}
+
+static bool property_cache_fresh(
+    struct Property_Cache_Entry *pEntry)
+{
+    return ((pEntry->flags & PROPERTY_CACHE_VALUE) &&
+        (pEntry->age < pEntry->ttl));
+}
+
+/* Choose the entry to reuse when the cache is full: one that is not
+   waiting on a reply, with a stale value before a fresh one, and
+   the oldest of those. */
+static unsigned property_cache_victim(
+    void)
+{
+    struct Property_Cache_Entry *pEntry;
+    unsigned index, victim = 0;
+    unsigned rank, victim_rank = 0;
+    uint32_t victim_age = 0;
+
+    for (index = 0; index < Property_Cache_Count; index++) {
+        pEntry = &Property_Cache[index];
+        rank = 0;
+        if (pEntry->invoke_id == 0) {
+            rank += 2;
+        }
+        if (!property_cache_fresh(pEntry)) {
+            rank += 1;
+        }
+        if ((rank > victim_rank) || ((rank == victim_rank) &&
+                (pEntry->age > victim_age))) {
+            victim = index;
+            victim_rank = rank;
+            victim_age = pEntry->age;
+        }
+    }
+
+    return victim;
+}
+
+/* Add an entry for a property that is not in the cache, reusing
+   an entry if the cache is full.  Returns the index. */
+static unsigned property_cache_add(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index)
+{
+    struct Property_Cache_Entry *pEntry;
+    unsigned index;
+
+    if (Property_Cache_Count >= MAX_PROPERTY_CACHE) {
+        property_cache_remove(property_cache_victim());
+        Property_Cache_Stats.evictions++;
+    }
+    index = Property_Cache_Count++;
+    pEntry = &Property_Cache[index];
+    pEntry->device_id = device_id;
+    pEntry->object_type = (uint16_t) object_type;
+    pEntry->object_instance = object_instance;
+    pEntry->object_property = (uint32_t) object_property;
+    pEntry->array_index = array_index;
+    pEntry->flags = 0;
+    pEntry->invoke_id = 0;
+    pEntry->age = 0;
+    pEntry->ttl = 0;
+    pEntry->data_len = 0;
+    hash_index_insert(&Property_Cache_Index, index);
+
+    return index;
+}
+
+void property_cache_init(
+    void)
+{
+    Property_Cache_Count = 0;
+    hash_index_clear(&Property_Cache_Index);
+    memset(Property_Cache_Invoke, 0, sizeof(Property_Cache_Invoke));
+    memset(&Property_Cache_Stats, 0, sizeof(Property_Cache_Stats));
+}
+
+static bool property_cache_update(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index,
+    uint8_t * application_data,
+    int application_data_len,
+    uint32_t ttl,
+    uint8_t flags)
+{
+    struct Property_Cache_Entry *pEntry;
+    int index;
+
+    index =
+        property_cache_find(device_id, object_type, object_instance,
+        object_property, array_index);
+    if ((application_data_len < 0) ||
+        (application_data_len > MAX_PROPERTY_CACHE_DATA)) {
+        /* keep no older value in place of one that did not fit */
+        if (index >= 0) {
+            Property_Cache[index].flags = 0;
+            if (Property_Cache[index].invoke_id == 0) {
+                property_cache_remove((unsigned) index);
+            }
+        }
+        Property_Cache_Stats.oversize++;
+        return false;
+    }
+    if (index < 0) {
+        index =
+            (int) property_cache_add(device_id, object_type,
+            object_instance, object_property, array_index);
+    }
+    pEntry = &Property_Cache[index];
+    if (application_data_len) {
+        memcpy(pEntry->data, application_data, application_data_len);
+    }
+    pEntry->data_len = (uint16_t) application_data_len;
+    pEntry->flags = PROPERTY_CACHE_VALUE | flags;
+    pEntry->age = 0;
+    if (ttl) {
+        pEntry->ttl = ttl;
+    } else {
+        pEntry->ttl = PROPERTY_CACHE_TTL;
+    }
+
+    return true;
+}
+
+/* Store the encoded value of a property, which stays fresh for ttl
+   seconds, or for PROPERTY_CACHE_TTL seconds if ttl is zero.
+   Returns false if the value is too large for the cache. */
+bool property_cache_store(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index,
+    uint8_t * application_data,
+    int application_data_len,
+    uint32_t ttl)
+{
+    return property_cache_update(device_id, object_type, object_instance,
+        object_property, array_index, application_data,
+        application_data_len, ttl, 0);
+}
+
+/* Copy the fresh value of a property into application_data, and give
+   the seconds since it was updated in age, if age is not NULL.
+   Returns the length of the value, or -1 if there is no fresh value
+   or it does not fit. */
+int property_cache_read(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index,
+    uint8_t * application_data,
+    size_t application_data_size,
+    uint32_t * age)
+{
+    struct Property_Cache_Entry *pEntry;
+    int index;
+
+    index =
+        property_cache_find(device_id, object_type, object_instance,
+        object_property, array_index);
+    if ((index < 0) || !(Property_Cache[index].flags & PROPERTY_CACHE_VALUE)) {
+        Property_Cache_Stats.misses++;
+        return -1;
+    }
+    pEntry = &Property_Cache[index];
+    if (age) {
+        *age = pEntry->age;
+    }
+    if (!property_cache_fresh(pEntry)) {
+        Property_Cache_Stats.stale_reads++;
+        return -1;
+    }
+    if (pEntry->data_len > application_data_size) {
+        return -1;
+    }
+    if (pEntry->data_len) {
+        memcpy(application_data, pEntry->data, pEntry->data_len);
+    }
+    Property_Cache_Stats.hits++;
+
+    return pEntry->data_len;
+}
+
+/* Forget the value of a property, e.g. after writing it */
+void property_cache_invalidate(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index)
+{
+    int index;
+
+    index =
+        property_cache_find(device_id, object_type, object_instance,
+        object_property, array_index);
+    if (index >= 0) {
+        if (Property_Cache[index].invoke_id) {
+            Property_Cache[index].flags = 0;
+        } else {
+            property_cache_remove((unsigned) index);
+        }
+    }
+}
+
+/* Forget the values of all the properties of a device,
+   e.g. when it has restarted */
+void property_cache_invalidate_device(
+    uint32_t device_id)
+{
+    unsigned index = Property_Cache_Count;
+
+    /* from the end, since removing moves the last entry into the hole */
+    while (index > 0) {
+        index--;
+        if (Property_Cache[index].device_id == device_id) {
+            if (Property_Cache[index].invoke_id) {
+                Property_Cache[index].flags = 0;
+            } else {
+                property_cache_remove(index);
+            }
+        }
+    }
+}
+
+/* Returns the invoke ID of a read in flight for the property, or 0 */
+uint8_t property_cache_pending(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index)
+{
+    int index;
+
+    index =
+        property_cache_find(device_id, object_type, object_instance,
+        object_property, array_index);
+    if (index < 0) {
+        return 0;
+    }
+
+    return Property_Cache[index].invoke_id;
+}
+
+/* Note the invoke ID of a read in flight for the property.  Setting the
+   invoke ID that is already in flight counts a request that joined it.
+   Returns false if invoke_id is zero. */
+bool property_cache_pending_set(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    uint32_t object_instance,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index,
+    uint8_t invoke_id)
+{
+    struct Property_Cache_Entry *pEntry;
+    int index;
+
+    if (invoke_id == 0) {
+        return false;
+    }
+    index =
+        property_cache_find(device_id, object_type, object_instance,
+        object_property, array_index);
+    if ((index >= 0) && (Property_Cache[index].invoke_id == invoke_id)) {
+        Property_Cache_Stats.collapsed++;
+        return true;
+    }
+    /* the TSM has reused the invoke ID, so its last request is done */
+    property_cache_pending_clear(invoke_id);
+    index =
+        property_cache_find(device_id, object_type, object_instance,
+        object_property, array_index);
+    if (index < 0) {
+        index =
+            (int) property_cache_add(device_id, object_type,
+            object_instance, object_property, array_index);
+    }
+    pEntry = &Property_Cache[index];
+    if (pEntry->invoke_id) {
+        Property_Cache_Invoke[pEntry->invoke_id] = 0;
+    }
+    pEntry->invoke_id = invoke_id;
+    Property_Cache_Invoke[invoke_id] = (PROPERTY_CACHE_INDEX) (index + 1);
+
+    return true;
+}
+
+/* The read with this invoke ID has completed or failed */
+void property_cache_pending_clear(
+    uint8_t invoke_id)
+{
+    unsigned index;
+
+    if (Property_Cache_Invoke[invoke_id] == 0) {
+        return;
+    }
+    index = Property_Cache_Invoke[invoke_id] - 1;
+    Property_Cache_Invoke[invoke_id] = 0;
+    Property_Cache[index].invoke_id = 0;
+    if (!(Property_Cache[index].flags & PROPERTY_CACHE_VALUE)) {
+        property_cache_remove(index);
+    }
+}
+
+/* Store the value from a ReadProperty ack from the device */
+void property_cache_rp_ack(
+    uint32_t device_id,
+    uint8_t invoke_id,
+    BACNET_READ_PROPERTY_DATA * rp_data)
+{
+    if (rp_data) {
+        if (property_cache_update(device_id, rp_data->object_type,
+                rp_data->object_instance, rp_data->object_property,
+                rp_data->array_index, rp_data->application_data,
+                rp_data->application_data_len, 0, 0)) {
+            Property_Cache_Stats.ack_updates++;
+        }
+    }
+    if (invoke_id) {
+        property_cache_pending_clear(invoke_id);
+    }
+}
+
+/* Encode a list of decoded values, as long as they could fit in an
+   entry.  Returns the length, which is more than MAX_PROPERTY_CACHE_DATA
+   if they do not fit. */
+static int property_cache_encode(
+    uint8_t * apdu,
+    BACNET_APPLICATION_DATA_VALUE * value)
+{
+    int len = 0;
+
+    while (value && (len <= MAX_PROPERTY_CACHE_DATA)) {
+        len += bacapp_encode_application_data(&apdu[len], value);
+        value = value->next;
+    }
+
+    return len;
+}
+
+/* Store the values from a ReadPropertyMultiple ack from the device */
+void property_cache_rpm_ack(
+    uint32_t device_id,
+    uint8_t invoke_id,
+    BACNET_READ_ACCESS_DATA * rpm_data)
+{
+    /* room for one more value of the largest size after an entry */
+    uint8_t apdu[MAX_PROPERTY_CACHE_DATA + MAX_APDU];
+    BACNET_PROPERTY_REFERENCE *rpm_property;
+    int len;
+
+    while (rpm_data) {
+        rpm_property = rpm_data->listOfProperties;
+        while (rpm_property) {
+            /* a NULL value is a property that could not be read,
+               whose cached value is no longer to be trusted */
+            if (rpm_property->value) {
+                len = property_cache_encode(apdu, rpm_property->value);
+                if (property_cache_update(device_id, rpm_data->object_type,
+                        rpm_data->object_instance,
+                        rpm_property->propertyIdentifier,
+                        rpm_property->propertyArrayIndex, apdu, len, 0, 0)) {
+                    Property_Cache_Stats.ack_updates++;
+                }
+            } else {
+                property_cache_invalidate(device_id, rpm_data->object_type,
+                    rpm_data->object_instance,
+                    rpm_property->propertyIdentifier,
+                    rpm_property->propertyArrayIndex);
+            }
+            rpm_property = rpm_property->next;
+        }
+        rpm_data = rpm_data->next;
+    }
+    if (invoke_id) {
+        property_cache_pending_clear(invoke_id);
+    }
+}
+
+/* Store the values from a COV notification.  They stay fresh for the
+   time remaining of the subscription, since any change before then
+   will be notified. */
+void property_cache_cov(
+    BACNET_COV_DATA * cov_data)
+{
+    uint8_t apdu[MAX_PROPERTY_CACHE_DATA + MAX_APDU];
+    BACNET_PROPERTY_VALUE *pValue;
+    int len;
+
+    if (!cov_data) {
+        return;
+    }
+    pValue = cov_data->listOfValues;
+    while (pValue) {
+        len = property_cache_encode(apdu, &pValue->value);
+        if (property_cache_update(cov_data->initiatingDeviceIdentifier,
+                cov_data->monitoredObjectIdentifier.type,
+                cov_data->monitoredObjectIdentifier.instance,
+                pValue->propertyIdentifier, pValue->propertyArrayIndex, apdu,
+                len, cov_data->timeRemaining, PROPERTY_CACHE_COV)) {
+            Property_Cache_Stats.cov_updates++;
+        }
+        pValue = pValue->next;
+    }
+}
+
+void property_cache_timer(
+    uint16_t uSeconds)
+{       /* Approximate number of seconds since last call to this function */
+    struct Property_Cache_Entry *pEntry;
+
+    pEntry = Property_Cache;
+    while (pEntry < &Property_Cache[Property_Cache_Count]) {
+        if ((pEntry->flags & PROPERTY_CACHE_VALUE) &&
+            (pEntry->age < UINT32_MAX - uSeconds)) {
+            pEntry->age += uSeconds;
+        }
+        pEntry++;
+    }
+}
+
+void property_cache_stats(
+    PROPERTY_CACHE_STATS * stats)
+{
+    struct Property_Cache_Entry *pEntry;
+    uint32_t reads;
+    uint64_t age_total = 0;
+    unsigned index;
+
+    if (!stats) {
+        return;
+    }
+    *stats = Property_Cache_Stats;
+    reads = stats->hits + stats->misses + stats->stale_reads;
+    if (reads) {
+        stats->hit_ratio = (unsigned) (((uint64_t) stats->hits * 100) / reads);
+    }
+    stats->entries = Property_Cache_Count;
+    for (index = 0; index < Property_Cache_Count; index++) {
+        pEntry = &Property_Cache[index];
+        if (pEntry->invoke_id) {
+            stats->pending++;
+        }
+        if (property_cache_fresh(pEntry)) {
+            stats->fresh++;
+            age_total += pEntry->age;
+            if (pEntry->age > stats->age_max) {
+                stats->age_max = pEntry->age;
+            }
+        } else if (pEntry->flags & PROPERTY_CACHE_VALUE) {
+            stats->stale++;
+        }
+    }
+    if (stats->fresh) {
+        stats->age_mean = (uint32_t) (age_total / stats->fresh);
+    }
+}
+
+void property_cache_stats_reset(
+    void)
+{
+    memset(&Property_Cache_Stats, 0, sizeof(Property_Cache_Stats));
+}
+
+#ifdef TEST
+#include <assert.h>
+#include "bacdcode.h"
+#include "ctest.h"
+
+static void testPropertyCacheReadProperty(
+    Test * pTest)
+{
+    PROPERTY_CACHE_STATS stats;
+    BACNET_READ_PROPERTY_DATA rp_data;
+    BACNET_APPLICATION_DATA_VALUE value;
+    uint8_t apdu[MAX_APDU];
+    uint8_t buffer[MAX_PROPERTY_CACHE_DATA];
+    uint32_t age = 0;
+    int len;
+
+    property_cache_init();
+    len = encode_application_real(apdu, 72.5);
+    rp_data.object_type = OBJECT_ANALOG_INPUT;
+    rp_data.object_instance = 3;
+    rp_data.object_property = PROP_PRESENT_VALUE;
+    rp_data.array_index = BACNET_ARRAY_ALL;
+    rp_data.application_data = apdu;
+    rp_data.application_data_len = len;
+    /* nothing cached yet */
+    ct_test(pTest, property_cache_read(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, buffer, sizeof(buffer),
+            &age) == -1);
+    /* a read in flight is shared by the same request */
+    ct_test(pTest, property_cache_pending(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL) == 0);
+    ct_test(pTest, property_cache_pending_set(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, 7));
+    ct_test(pTest, property_cache_pending(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL) == 7);
+    ct_test(pTest, property_cache_pending_set(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, 7));
+    /* waiting on a reply is not a value */
+    ct_test(pTest, property_cache_read(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, buffer, sizeof(buffer),
+            &age) == -1);
+    /* the ack fills the entry and ends the read in flight */
+    property_cache_rp_ack(1234, 7, &rp_data);
+    ct_test(pTest, property_cache_pending(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL) == 0);
+    ct_test(pTest, property_cache_read(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, buffer, sizeof(buffer),
+            &age) == len);
+    ct_test(pTest, age == 0);
+    ct_test(pTest, bacapp_decode_application_data(buffer, len, &value) == len);
+    ct_test(pTest, value.tag == BACNET_APPLICATION_TAG_REAL);
+    ct_test(pTest, value.type.Real == 72.5);
+    /* other devices, objects, properties and indexes are not cached */
+    ct_test(pTest, property_cache_read(1235, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, buffer, sizeof(buffer),
+            NULL) == -1);
+    ct_test(pTest, property_cache_read(1234, OBJECT_ANALOG_VALUE, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, buffer, sizeof(buffer),
+            NULL) == -1);
+    ct_test(pTest, property_cache_read(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_UNITS, BACNET_ARRAY_ALL, buffer, sizeof(buffer),
+            NULL) == -1);
+    ct_test(pTest, property_cache_read(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, 1, buffer, sizeof(buffer), NULL) == -1);
+    /* the value ages, and goes stale after its time to live */
+    property_cache_timer(PROPERTY_CACHE_TTL - 1);
+    ct_test(pTest, property_cache_read(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, buffer, sizeof(buffer),
+            &age) == len);
+    ct_test(pTest, age == (PROPERTY_CACHE_TTL - 1));
+    property_cache_stats(&stats);
+    ct_test(pTest, stats.fresh == 1);
+    ct_test(pTest, stats.age_max == (PROPERTY_CACHE_TTL - 1));
+    property_cache_timer(1);
+    ct_test(pTest, property_cache_read(1234, OBJECT_ANALOG_INPUT, 3,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, buffer, sizeof(buffer),
+            &age) == -1);
+    ct_test(pTest, age == PROPERTY_CACHE_TTL);
+    property_cache_stats(&stats);
+    ct_test(pTest, stats.hits == 2);
+    ct_test(pTest, stats.misses == 6);
+    ct_test(pTest, stats.stale_reads == 1);
+    ct_test(pTest, stats.collapsed == 1);
+    ct_test(pTest, stats.ack_updates == 1);
+    ct_test(pTest, stats.hit_ratio == 22);
+    ct_test(pTest, stats.entries == 1);
+    ct_test(pTest, stats.fresh == 0);
+    ct_test(pTest, stats.stale == 1);
+    ct_test(pTest, stats.pending == 0);
+    /* a new invoke ID for another property ends the old read */
+    ct_test(pTest, property_cache_pending_set(1234, OBJECT_ANALOG_INPUT, 4,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, 9));
+    ct_test(pTest, property_cache_pending_set(1234, OBJECT_ANALOG_INPUT, 5,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, 9));
+    ct_test(pTest, property_cache_pending(1234, OBJECT_ANALOG_INPUT, 4,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL) == 0);
+    ct_test(pTest, property_cache_pending(1234, OBJECT_ANALOG_INPUT, 5,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL) == 9);
+    property_cache_pending_clear(9);
+    property_cache_stats(&stats);
+    ct_test(pTest, stats.entries == 1);
+    ct_test(pTest, stats.pending == 0);
+    property_cache_stats_reset();
+    property_cache_stats(&stats);
+    ct_test(pTest, stats.hits == 0);
+    ct_test(pTest, stats.entries == 1);
+}
+
+static void testPropertyCacheCOV(
+    Test * pTest)
+{
+    BACNET_COV_DATA cov_data;
+    BACNET_PROPERTY_VALUE value_list[2];
+    BACNET_READ_ACCESS_DATA rpm_data;
+    BACNET_PROPERTY_REFERENCE rpm_property[2];
+    BACNET_APPLICATION_DATA_VALUE rpm_value, value;
+    PROPERTY_CACHE_STATS stats;
+    uint8_t buffer[MAX_PROPERTY_CACHE_DATA];
+    int len;
+
+    property_cache_init();
+    /* an RPM ack, with one property that could not be read, whose
+       value was cached before */
+    value.context_specific = false;
+    value.tag = BACNET_APPLICATION_TAG_ENUMERATED;
+    value.type.Enumerated = 1;
+    value.next = NULL;
+    len = bacapp_encode_application_data(buffer, &value);
+    ct_test(pTest, property_cache_store(99, OBJECT_BINARY_INPUT, 1,
+            PROP_DESCRIPTION, BACNET_ARRAY_ALL, buffer, len, 0));
+    rpm_data.object_type = OBJECT_BINARY_INPUT;
+    rpm_data.object_instance = 1;
+    rpm_data.listOfProperties = &rpm_property[0];
+    rpm_data.next = NULL;
+    rpm_property[0].propertyIdentifier = PROP_PRESENT_VALUE;
+    rpm_property[0].propertyArrayIndex = BACNET_ARRAY_ALL;
+    rpm_property[0].value = &rpm_value;
+    rpm_property[0].next = &rpm_property[1];
+    rpm_property[1].propertyIdentifier = PROP_DESCRIPTION;
+    rpm_property[1].propertyArrayIndex = BACNET_ARRAY_ALL;
+    rpm_property[1].value = NULL;
+    rpm_property[1].next = NULL;
+    rpm_value.context_specific = false;
+    rpm_value.tag = BACNET_APPLICATION_TAG_ENUMERATED;
+    rpm_value.type.Enumerated = BINARY_INACTIVE;
+    rpm_value.next = NULL;
+    property_cache_rpm_ack(99, 0, &rpm_data);
+    len = property_cache_read(99, OBJECT_BINARY_INPUT, 1, PROP_PRESENT_VALUE,
+        BACNET_ARRAY_ALL, buffer, sizeof(buffer), NULL);
+    ct_test(pTest, len > 0);
+    ct_test(pTest, bacapp_decode_application_data(buffer, len, &value) == len);
+    ct_test(pTest, value.type.Enumerated == BINARY_INACTIVE);
+    ct_test(pTest, property_cache_read(99, OBJECT_BINARY_INPUT, 1,
+            PROP_DESCRIPTION, BACNET_ARRAY_ALL, buffer, sizeof(buffer),
+            NULL) == -1);
+    /* a COV notification refreshes the value for the subscription */
+    property_cache_timer(PROPERTY_CACHE_TTL);
+    cov_data.subscriberProcessIdentifier = 1;
+    cov_data.initiatingDeviceIdentifier = 99;
+    cov_data.monitoredObjectIdentifier.type = OBJECT_BINARY_INPUT;
+    cov_data.monitoredObjectIdentifier.instance = 1;
+    cov_data.timeRemaining = PROPERTY_CACHE_TTL * 2;
+    cov_data.listOfValues = &value_list[0];
+    value_list[0].propertyIdentifier = PROP_PRESENT_VALUE;
+    value_list[0].propertyArrayIndex = BACNET_ARRAY_ALL;
+    value_list[0].value.context_specific = false;
+    value_list[0].value.tag = BACNET_APPLICATION_TAG_ENUMERATED;
+    value_list[0].value.type.Enumerated = BINARY_ACTIVE;
+    value_list[0].value.next = NULL;
+    value_list[0].next = &value_list[1];
+    value_list[1].propertyIdentifier = PROP_STATUS_FLAGS;
+    value_list[1].propertyArrayIndex = BACNET_ARRAY_ALL;
+    value_list[1].value.context_specific = false;
+    value_list[1].value.tag = BACNET_APPLICATION_TAG_BIT_STRING;
+    bitstring_init(&value_list[1].value.type.Bit_String);
+    bitstring_set_bit(&value_list[1].value.type.Bit_String,
+        STATUS_FLAG_IN_ALARM, false);
+    bitstring_set_bit(&value_list[1].value.type.Bit_String, STATUS_FLAG_FAULT,
+        false);
+    bitstring_set_bit(&value_list[1].value.type.Bit_String,
+        STATUS_FLAG_OVERRIDDEN, false);
+    bitstring_set_bit(&value_list[1].value.type.Bit_String,
+        STATUS_FLAG_OUT_OF_SERVICE, false);
+    value_list[1].value.next = NULL;
+    value_list[1].next = NULL;
+    property_cache_cov(&cov_data);
+    property_cache_timer(PROPERTY_CACHE_TTL);
+    len = property_cache_read(99, OBJECT_BINARY_INPUT, 1, PROP_PRESENT_VALUE,
+        BACNET_ARRAY_ALL, buffer, sizeof(buffer), NULL);
+    ct_test(pTest, len > 0);
+    ct_test(pTest, bacapp_decode_application_data(buffer, len, &value) == len);
+    ct_test(pTest, value.type.Enumerated == BINARY_ACTIVE);
+    ct_test(pTest, property_cache_read(99, OBJECT_BINARY_INPUT, 1,
+            PROP_STATUS_FLAGS, BACNET_ARRAY_ALL, buffer, sizeof(buffer),
+            NULL) > 0);
+    property_cache_stats(&stats);
+    ct_test(pTest, stats.ack_updates == 1);
+    ct_test(pTest, stats.cov_updates == 2);
+    ct_test(pTest, stats.entries == 2);
+    /* values of a device are forgotten together */
+    property_cache_invalidate_device(99);
+    property_cache_stats(&stats);
+    ct_test(pTest, stats.entries == 0);
+}
+
+static void testPropertyCacheFull(
+    Test * pTest)
+{
+    PROPERTY_CACHE_STATS stats;
+    uint8_t apdu[MAX_APDU];
+    uint8_t buffer[MAX_PROPERTY_CACHE_DATA];
+    uint32_t i;
+    int len;
+
+    property_cache_init();
+    len = encode_application_unsigned(apdu, 42);
+    for (i = 0; i < MAX_PROPERTY_CACHE; i++) {
+        ct_test(pTest, property_cache_store(i / 16, OBJECT_ANALOG_VALUE,
+                i % 16, PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, apdu, len, 0));
+    }
+    /* the first half of the values go stale */
+    property_cache_timer(PROPERTY_CACHE_TTL);
+    for (i = MAX_PROPERTY_CACHE / 2; i < MAX_PROPERTY_CACHE; i++) {
+        ct_test(pTest, property_cache_store(i / 16, OBJECT_ANALOG_VALUE,
+                i % 16, PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, apdu, len, 0));
+    }
+    /* new values replace the stale ones */
+    for (i = 0; i < MAX_PROPERTY_CACHE / 2; i++) {
+        ct_test(pTest, property_cache_store(i, OBJECT_DEVICE, i,
+                PROP_OBJECT_NAME, BACNET_ARRAY_ALL, apdu, len, 0));
+    }
+    property_cache_stats(&stats);
+    ct_test(pTest, stats.entries == MAX_PROPERTY_CACHE);
+    ct_test(pTest, stats.fresh == MAX_PROPERTY_CACHE);
+    ct_test(pTest, stats.evictions == (MAX_PROPERTY_CACHE / 2));
+    for (i = 0; i < MAX_PROPERTY_CACHE; i++) {
+        if (i < (MAX_PROPERTY_CACHE / 2)) {
+            ct_test(pTest, property_cache_read(i, OBJECT_DEVICE, i,
+                    PROP_OBJECT_NAME, BACNET_ARRAY_ALL, buffer,
+                    sizeof(buffer), NULL) == len);
+        } else {
+            ct_test(pTest, property_cache_read(i / 16, OBJECT_ANALOG_VALUE,
+                    i % 16, PROP_PRESENT_VALUE, BACNET_ARRAY_ALL, buffer,
+                    sizeof(buffer), NULL) == len);
+        }
+    }
+    /* a value too large for an entry is not kept */
+    ct_test(pTest, !property_cache_store(0, OBJECT_DEVICE, 0,
+            PROP_OBJECT_NAME, BACNET_ARRAY_ALL, apdu,
+            MAX_PROPERTY_CACHE_DATA + 1, 0));
+    ct_test(pTest, property_cache_read(0, OBJECT_DEVICE, 0, PROP_OBJECT_NAME,
+            BACNET_ARRAY_ALL, buffer, sizeof(buffer), NULL) == -1);
+    property_cache_invalidate(1, OBJECT_DEVICE, 1, PROP_OBJECT_NAME,
+        BACNET_ARRAY_ALL);
+    property_cache_stats(&stats);
+    ct_test(pTest, stats.oversize == 1);
+    ct_test(pTest, stats.entries == (MAX_PROPERTY_CACHE - 2));
+    /* the rest are still found after the table was repacked */
+    for (i = 2; i < MAX_PROPERTY_CACHE / 2; i++) {
+        ct_test(pTest, property_cache_read(i, OBJECT_DEVICE, i,
+                PROP_OBJECT_NAME, BACNET_ARRAY_ALL, buffer,
+                sizeof(buffer), NULL) == len);
+    }
+}
+
+void testPropertyCache(
+    Test * pTest)
+{
+    testPropertyCacheReadProperty(pTest);
+    testPropertyCacheCOV(pTest);
+    testPropertyCacheFull(pTest);
+}
+
+#ifdef TEST_PROPERTY_CACHE
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("BACnet Property Cache", NULL);
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testPropertyCacheReadProperty);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testPropertyCacheCOV);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testPropertyCacheFull);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+    ct_destroy(pTest);
+
+    return 0;
+}
+#endif /* TEST_PROPERTY_CACHE */
+#endif /* TEST */
@@ -32,6 +32,7 @@
  -------------------------------------------
 ####COPYRIGHTEND####*/
 #include <stdint.h>
+#include <string.h>
 #include "bacenum.h"
 #include "bacdcode.h"
 #include "bacdef.h"
@@ -75,8 +76,14 @@ int rr_encode_apdu(
     int apdu_len = 0;   /* total length of the apdu, return value */
 
     if (apdu) {
+#if BACNET_SEGMENTATION_ENABLED
+        /* segmented-response-accepted */
+        apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST | 0x02;
+        apdu[1] = encode_max_segs_max_apdu(MAX_SEGMENTS_ACCEPTED, MAX_APDU);
+#else
         apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
         apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+#endif
         apdu[2] = invoke_id;
         apdu[3] = SERVICE_CONFIRMED_READ_RANGE; /* service choice */
         apdu_len = 4;
@@ -175,6 +182,7 @@ int rr_decode_service_request(
         len += decode_enumerated(&apdu[len], len_value_type, &UnsignedTemp);
         rrdata->object_property = (BACNET_PROPERTY_ID) UnsignedTemp;
         rrdata->Overhead = RR_OVERHEAD; /* Start with the fixed overhead */
+        rrdata->MaxApdu = MAX_APDU;
 
         /* Tag 2: Optional Array Index - set to ALL if not present */
         rrdata->array_index = BACNET_ARRAY_ALL; /* Assuming this is the most common outcome... */
@@ -300,7 +308,6 @@ int rr_ack_encode_apdu(
     uint8_t invoke_id,
     BACNET_READ_RANGE_DATA * rrdata)
 {
-    int len = 0;        /* length of each encoding */
     int apdu_len = 0;   /* total length of the apdu, return value */
 
     if (apdu) {
@@ -332,9 +339,10 @@ int rr_ack_encode_apdu(
          */
         apdu_len += encode_opening_tag(&apdu[apdu_len], 5);
         if (rrdata->ItemCount != 0) {
-            for (len = 0; len < rrdata->application_data_len; len++) {
-                apdu[apdu_len++] = rrdata->application_data[len];
-            }
+            /* the items may already be in the apdu, a little further on */
+            memmove(&apdu[apdu_len], rrdata->application_data,
+                (size_t) rrdata->application_data_len);
+            apdu_len += rrdata->application_data_len;
         }
         apdu_len += encode_closing_tag(&apdu[apdu_len], 5);
 
@@ -51,8 +51,14 @@ int rpm_encode_apdu_init(
     int apdu_len = 0;   /* total length of the apdu, return value */
 
     if (apdu) {
+#if BACNET_SEGMENTATION_ENABLED
+        /* segmented-response-accepted */
+        apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST | 0x02;
+        apdu[1] = encode_max_segs_max_apdu(MAX_SEGMENTS_ACCEPTED, MAX_APDU);
+#else
         apdu[0] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
         apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU);
+#endif
         apdu[2] = invoke_id;
         apdu[3] = SERVICE_CONFIRMED_READ_PROP_MULTIPLE; /* service choice */
         apdu_len = 4;
@@ -565,7 +571,7 @@ int rpm_decode_apdu(
     if (!apdu)
         return -1;
     /* optional checking - most likely was already done prior to this call */
-    if (apdu[0] != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
+    if ((apdu[0] & 0xF0) != PDU_TYPE_CONFIRMED_SERVICE_REQUEST)
         return -1;
     /*  apdu[1] = encode_max_segs_max_apdu(0, MAX_APDU); */
     *invoke_id = apdu[2];       /* invoke id - filled in by net layer */
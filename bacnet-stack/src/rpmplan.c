@@ -0,0 +1,1039 @@
+/**************************************************************************
+*
+* Copyright (C) 2026 agent <agent@local>
+*
+* Permission is hereby granted, free of charge, to any person obtaining
+* a copy of this software and associated documentation files (the
+* "Software"), to deal in the Software without restriction, including
+* without limitation the rights to use, copy, modify, merge, publish,
+* distribute, sublicense, and/or sell copies of the Software, and to
+* permit persons to whom the Software is furnished to do so, subject to
+* the following conditions:
+*
+* The above copyright notice and this permission notice shall be included
+* in all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+* IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+* CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+* TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+* SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*********************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "config.h"
+#include "bacdef.h"
+#include "bacdcode.h"
+#include "bacapp.h"
+#include "address.h"
+#include "hashindex.h"
+#include "rpmplan.h"
+
+/** @file rpmplan.c  Pack a list of properties into ReadPropertyMultiple
+ *  requests that fit the max APDU of the device. */
+
+/* A plan splits the points, in the order given, into runs that are
+   each read with one request.  The sizes of a request and its ack grow
+   with each point, so taking as many points as fit into each request,
+   one after another, gives the fewest requests for that order.  Points
+   of the same object should be next to each other, since a point of
+   another object adds its object identifier to the request.
+
+   The size of each value in the ack is predicted from the values seen
+   before for the same device, object type and property, which are kept
+   in a table of sets of RPM_PLAN_WAYS entries.  The hash of a property
+   picks its set, and a new property takes the place of the one in the
+   set that was learned least recently, so that a few properties with
+   the same set do not push each other out.  A value that is larger
+   than the prediction replaces it, and a smaller one lowers it slowly.
+
+   The devices that do not support ReadPropertyMultiple, or that could
+   not send an ack of the size that was planned, are kept in a table
+   that only grows, indexed with a hash index (see hashindex.c). */
+
+struct Rpm_Plan_Device {
+    uint32_t device_id;
+    /* largest ack to plan for, or zero for the max APDU */
+    uint16_t ack_limit;
+    bool rpm_unsupported;
+};
+
+struct Rpm_Plan_Size {
+    uint32_t device_id;
+    uint32_t object_property;
+    uint16_t object_type;
+    /* the size of an element of an array, rather than the property */
+    bool element;
+    /* encoded size of the value, or zero for an empty entry */
+    uint16_t size;
+};
+
+static struct Rpm_Plan_Device Rpm_Plan_Devices[MAX_RPM_PLAN_DEVICES];
+static uint16_t
+    Rpm_Plan_Device_Hash[HASH_INDEX_SIZE(MAX_RPM_PLAN_DEVICES)];
+static unsigned Rpm_Plan_Device_Count;
+static struct Rpm_Plan_Size Rpm_Plan_Sizes[RPM_PLAN_SETS * RPM_PLAN_WAYS];
+/* a value is encoded here to learn its size */
+static uint8_t Rpm_Plan_Buffer[MAX_APDU];
+
+static uint32_t rpm_plan_device_home(
+    uint32_t index)
+{
+    return hash_index_mix(Rpm_Plan_Devices[index].device_id);
+}
+
+static HASH_INDEX Rpm_Plan_Device_Index = {
+    Rpm_Plan_Device_Hash, sizeof(uint16_t),
+    HASH_INDEX_SIZE(MAX_RPM_PLAN_DEVICES), rpm_plan_device_home
+};
+
+/* Find a device.  Returns the index, or -1 if not found. */
+static int rpm_plan_device_find(
+    uint32_t device_id)
+{
+    unsigned slot;
+    uint32_t value;
+
+    slot =
+        hash_index_start(&Rpm_Plan_Device_Index, hash_index_mix(device_id));
+    while ((value = hash_index_get(&Rpm_Plan_Device_Index, slot)) != 0) {
+        if (Rpm_Plan_Devices[value - 1].device_id == device_id) {
+            return (int) (value - 1);
+        }
+        slot = hash_index_next(&Rpm_Plan_Device_Index, slot);
+    }
+
+    return -1;
+}
+
+/* Find a device, adding it if there is room.
+   Returns the index, or -1 if the table is full. */
+static int rpm_plan_device_add(
+    uint32_t device_id)
+{
+    struct Rpm_Plan_Device *pDevice;
+    int index;
+
+    index = rpm_plan_device_find(device_id);
+    if (index >= 0) {
+        return index;
+    }
+    if (Rpm_Plan_Device_Count >= MAX_RPM_PLAN_DEVICES) {
+        return -1;
+    }
+    pDevice = &Rpm_Plan_Devices[Rpm_Plan_Device_Count];
+    pDevice->device_id = device_id;
+    pDevice->ack_limit = 0;
+    pDevice->rpm_unsupported = false;
+    hash_index_insert(&Rpm_Plan_Device_Index, Rpm_Plan_Device_Count);
+    Rpm_Plan_Device_Count++;
+
+    return (int) (Rpm_Plan_Device_Count - 1);
+}
+
+/* the first entry of the set of a property */
+static struct Rpm_Plan_Size *rpm_plan_size_set(
+    uint32_t device_id,
+    uint16_t object_type,
+    uint32_t object_property,
+    bool element)
+{
+    uint32_t hash;
+
+    hash = device_id;
+    hash = (hash * 31) ^ (((uint32_t) object_type << 22) ^ object_property);
+    hash = (hash * 31) ^ (element ? 1 : 0);
+
+    return &Rpm_Plan_Sizes[(hash_index_mix(hash) % RPM_PLAN_SETS) *
+        RPM_PLAN_WAYS];
+}
+
+/* Find the entry of a property, or NULL if its size is not known.
+   The entries of a set are kept from the most recently learned. */
+static struct Rpm_Plan_Size *rpm_plan_size_find(
+    uint32_t device_id,
+    uint16_t object_type,
+    uint32_t object_property,
+    bool element)
+{
+    struct Rpm_Plan_Size *pSet, *pSize;
+    unsigned way;
+
+    pSet = rpm_plan_size_set(device_id, object_type, object_property,
+        element);
+    for (way = 0; way < RPM_PLAN_WAYS; way++) {
+        pSize = &pSet[way];
+        if (pSize->size == 0) {
+            break;
+        }
+        if ((pSize->device_id == device_id) &&
+            (pSize->object_type == object_type) &&
+            (pSize->object_property == object_property) &&
+            (pSize->element == element)) {
+            return pSize;
+        }
+    }
+
+    return NULL;
+}
+
+static void rpm_plan_size_learn(
+    uint32_t device_id,
+    uint16_t object_type,
+    uint32_t object_property,
+    uint32_t array_index,
+    unsigned size)
+{
+    struct Rpm_Plan_Size *pSet, *pSize;
+    struct Rpm_Plan_Size entry;
+    bool element = (array_index != BACNET_ARRAY_ALL);
+    unsigned way;
+
+    if (size > UINT16_MAX) {
+        size = UINT16_MAX;
+    } else if (size == 0) {
+        return;
+    }
+    pSet = rpm_plan_size_set(device_id, object_type, object_property,
+        element);
+    pSize = rpm_plan_size_find(device_id, object_type, object_property,
+        element);
+    if (pSize) {
+        entry = *pSize;
+        if (size < entry.size) {
+            /* a smaller value lowers it by an eighth of the difference */
+            entry.size -= (uint16_t) ((entry.size - size + 7) / 8);
+        } else {
+            entry.size = (uint16_t) size;
+        }
+        way = (unsigned) (pSize - pSet);
+    } else {
+        entry.device_id = device_id;
+        entry.object_type = object_type;
+        entry.object_property = object_property;
+        entry.element = element;
+        entry.size = (uint16_t) size;
+        /* in place of the least recently learned */
+        way = RPM_PLAN_WAYS - 1;
+    }
+    /* move it to the front of the set */
+    while (way > 0) {
+        pSet[way] = pSet[way - 1];
+        way--;
+    }
+    pSet[0] = entry;
+}
+
+/* encoded size of a context tagged unsigned or enumerated value */
+static unsigned rpm_plan_tag_size(
+    uint32_t value)
+{
+    if (value < 0x100UL) {
+        return 2;
+    } else if (value < 0x10000UL) {
+        return 3;
+    } else if (value < 0x1000000UL) {
+        return 4;
+    }
+
+    return 5;
+}
+
+/* encoded size of the property identifier and array index */
+static unsigned rpm_plan_property_size(
+    RPM_PLAN_POINT * pPoint)
+{
+    unsigned size;
+
+    size = rpm_plan_tag_size(pPoint->object_property);
+    if (pPoint->array_index != BACNET_ARRAY_ALL) {
+        size += rpm_plan_tag_size(pPoint->array_index);
+    }
+
+    return size;
+}
+
+/** Initialize the planner, forgetting the learned sizes and devices */
+void rpm_plan_init(
+    void)
+{
+    Rpm_Plan_Device_Count = 0;
+    hash_index_clear(&Rpm_Plan_Device_Index);
+    memset(Rpm_Plan_Sizes, 0, sizeof(Rpm_Plan_Sizes));
+}
+
+/** Predict the encoded size of a value in an ack, without the tags
+ *  around it, from the values seen before or from its property.
+ */
+unsigned rpm_plan_value_size(
+    uint32_t device_id,
+    BACNET_OBJECT_TYPE object_type,
+    BACNET_PROPERTY_ID object_property,
+    uint32_t array_index)
+{
+    struct Rpm_Plan_Size *pSize;
+    bool element = (array_index != BACNET_ARRAY_ALL);
+
+    pSize = rpm_plan_size_find(device_id, (uint16_t) object_type,
+        object_property, element);
+    if (pSize) {
+        return pSize->size;
+    }
+    if (array_index == 0) {
+        /* the size of the array, as an unsigned */
+        return 5;
+    }
+    switch (object_property) {
+        case PROP_OBJECT_NAME:
+        case PROP_DESCRIPTION:
+        case PROP_LOCATION:
+        case PROP_VENDOR_NAME:
+        case PROP_MODEL_NAME:
+        case PROP_FIRMWARE_REVISION:
+        case PROP_APPLICATION_SOFTWARE_VERSION:
+        case PROP_PROFILE_NAME:
+        case PROP_DEVICE_TYPE:
+        case PROP_ACTIVE_TEXT:
+        case PROP_INACTIVE_TEXT:
+            return RPM_PLAN_STRING_SIZE;
+        case PROP_PRIORITY_ARRAY:
+            if (array_index == BACNET_ARRAY_ALL) {
+                return BACNET_MAX_PRIORITY * RPM_PLAN_VALUE_SIZE;
+            }
+            break;
+        default:
+            break;
+    }
+
+    return RPM_PLAN_VALUE_SIZE;
+}
+
+/** Learn the size of the value in a ReadProperty ack.
+ *
+ * @param device_id [in] Device that sent the ack.
+ * @param rp_data [in] The decoded ack.
+ */
+void rpm_plan_learn_rp(
+    uint32_t device_id,
+    BACNET_READ_PROPERTY_DATA * rp_data)
+{
+    if (rp_data && (rp_data->application_data_len > 0)) {
+        rpm_plan_size_learn(device_id, (uint16_t) rp_data->object_type,
+            rp_data->object_property, rp_data->array_index,
+            (unsigned) rp_data->application_data_len);
+    }
+}
+
+/** Learn the sizes of the values, and of the errors in place of values,
+ *  in a ReadPropertyMultiple ack.
+ *
+ * @param device_id [in] Device that sent the ack.
+ * @param read_access_data [in] The decoded ack.
+ */
+void rpm_plan_learn_rpm(
+    uint32_t device_id,
+    BACNET_READ_ACCESS_DATA * read_access_data)
+{
+    BACNET_PROPERTY_REFERENCE *rpm_property;
+    BACNET_APPLICATION_DATA_VALUE *value;
+    unsigned size;
+
+    while (read_access_data) {
+        rpm_property = read_access_data->listOfProperties;
+        while (rpm_property) {
+            size = 0;
+            if (rpm_property->value) {
+                value = rpm_property->value;
+                while (value) {
+                    size +=
+                        (unsigned) bacapp_encode_application_data(
+                        &Rpm_Plan_Buffer[0], value);
+                    value = value->next;
+                }
+            } else {
+                size =
+                    (unsigned) encode_application_enumerated(
+                    &Rpm_Plan_Buffer[0], rpm_property->error.error_class);
+                size +=
+                    (unsigned) encode_application_enumerated(
+                    &Rpm_Plan_Buffer[0], rpm_property->error.error_code);
+            }
+            rpm_plan_size_learn(device_id,
+                (uint16_t) read_access_data->object_type,
+                rpm_property->propertyIdentifier,
+                rpm_property->propertyArrayIndex, size);
+            rpm_property = rpm_property->next;
+        }
+        read_access_data = read_access_data->next;
+    }
+}
+
+/** Note that the ack of a planned request did not fit what the device
+ *  can send - it was aborted with buffer overflow or segmentation not
+ *  supported - so that its later requests are planned for smaller acks.
+ *
+ * @param device_id [in] Device that aborted the request.
+ * @param request [in] The request from the plan.
+ */
+void rpm_plan_overflow(
+    uint32_t device_id,
+    RPM_PLAN_REQUEST * request)
+{
+    unsigned limit;
+    int index;
+
+    if (!request || (request->count < 2)) {
+        return;
+    }
+    index = rpm_plan_device_add(device_id);
+    if (index >= 0) {
+        limit = request->ack_size - (request->ack_size / 4);
+        if ((Rpm_Plan_Devices[index].ack_limit == 0) ||
+            (limit < Rpm_Plan_Devices[index].ack_limit)) {
+            Rpm_Plan_Devices[index].ack_limit = (uint16_t) limit;
+        }
+    }
+}
+
+/** Returns false if the device is known not to support
+ *  ReadPropertyMultiple, in which case its points are planned as
+ *  ReadProperty requests. */
+bool rpm_plan_rpm_supported(
+    uint32_t device_id)
+{
+    int index;
+
+    index = rpm_plan_device_find(device_id);
+    if (index >= 0) {
+        return !Rpm_Plan_Devices[index].rpm_unsupported;
+    }
+
+    return true;
+}
+
+/** Set whether the device supports ReadPropertyMultiple, for example
+ *  from its Protocol_Services_Supported, or after it rejected a request
+ *  as an unrecognized service.
+ *
+ * @return true if it was set, or false if there is no room.
+ */
+bool rpm_plan_rpm_supported_set(
+    uint32_t device_id,
+    bool supported)
+{
+    int index;
+
+    index = rpm_plan_device_add(device_id);
+    if (index < 0) {
+        return false;
+    }
+    Rpm_Plan_Devices[index].rpm_unsupported = !supported;
+
+    return true;
+}
+
+/** Plan the requests that read the points from a device with the given
+ *  max APDU, whose acks can be sent in segments.  Each request, with its
+ *  NPDU, fits within the max APDU and within our own MAX_APDU, and its
+ *  predicted ack within that many segments of them.
+ *
+ * @param device_id [in] Device whose points are read.
+ * @param max_apdu [in] Max APDU length accepted by the device.
+ * @param ack_segments [in] Segments of an ack to plan for, or 1 if the
+ *                          device cannot send a segmented ack.
+ * @param points [in] Points to read, with those of each object together.
+ * @param point_count [in] Number of points.
+ * @param requests [out] The requests of the plan.
+ * @param max_requests [in] Number of requests there is room for.
+ * @return the number of requests, or -1 if there is not room for them.
+ */
+int rpm_plan_build_segmented(
+    uint32_t device_id,
+    unsigned max_apdu,
+    unsigned ack_segments,
+    RPM_PLAN_POINT * points,
+    unsigned point_count,
+    RPM_PLAN_REQUEST * requests,
+    unsigned max_requests)
+{
+    RPM_PLAN_REQUEST *request;
+    RPM_PLAN_POINT *pPoint, *pLast;
+    unsigned request_limit, ack_limit, request_size, ack_size;
+    unsigned size, object_size, value_size;
+    unsigned point = 0, count = 0;
+    bool rpm;
+    int index;
+
+    if (max_apdu > MAX_APDU) {
+        max_apdu = MAX_APDU;
+    }
+    request_limit = 0;
+    if (max_apdu > RPM_PLAN_NPDU_SIZE) {
+        request_limit = max_apdu - RPM_PLAN_NPDU_SIZE;
+    }
+    if (ack_segments == 0) {
+        ack_segments = 1;
+    }
+    ack_limit = max_apdu * ack_segments;
+    index = rpm_plan_device_find(device_id);
+    if ((index >= 0) && Rpm_Plan_Devices[index].ack_limit &&
+        (Rpm_Plan_Devices[index].ack_limit < ack_limit)) {
+        ack_limit = Rpm_Plan_Devices[index].ack_limit;
+    }
+    rpm = rpm_plan_rpm_supported(device_id);
+    while (point < point_count) {
+        if (count >= max_requests) {
+            return -1;
+        }
+        request = &requests[count++];
+        request->first = point;
+        request->count = 0;
+        request->rpm = rpm;
+        if (rpm) {
+            /* the confirmed request and complex ack headers */
+            request_size = 4;
+            ack_size = 3;
+        } else {
+            /* ...and the object identifier of the one point */
+            request_size = 4 + 5;
+            ack_size = 3 + 5;
+        }
+        pLast = NULL;
+        while (point < point_count) {
+            pPoint = &points[point];
+            size = rpm_plan_property_size(pPoint);
+            object_size = 0;
+            if (rpm && (!pLast || (pLast->object_type != pPoint->object_type)
+                    || (pLast->object_instance != pPoint->object_instance))) {
+                /* object identifier, and the tags around its list */
+                object_size = 7;
+            }
+            value_size =
+                rpm_plan_value_size(device_id, pPoint->object_type,
+                pPoint->object_property, pPoint->array_index);
+            /* the value, or an error, is between a pair of tags */
+            if (request->count &&
+                (((request_size + object_size + size) > request_limit) ||
+                    ((ack_size + object_size + size + 2 + value_size) >
+                        ack_limit))) {
+                break;
+            }
+            request_size += object_size + size;
+            ack_size += object_size + size + 2 + value_size;
+            request->count++;
+            point++;
+            pLast = pPoint;
+            if (!rpm || (request->count >= RPM_PLAN_REQUEST_POINTS)) {
+                break;
+            }
+        }
+        request->request_size = (uint16_t) request_size;
+        if (ack_size > UINT16_MAX) {
+            ack_size = UINT16_MAX;
+        }
+        request->ack_size = (uint16_t) ack_size;
+    }
+
+    return (int) count;
+}
+
+/** Plan the requests that read the points from a device with the given
+ *  max APDU.  Each request, with its NPDU, and its predicted ack fit
+ *  within the max APDU and within our own MAX_APDU.
+ *
+ * @return the number of requests, or -1 if there is not room for them.
+ */
+int rpm_plan_build_max_apdu(
+    uint32_t device_id,
+    unsigned max_apdu,
+    RPM_PLAN_POINT * points,
+    unsigned point_count,
+    RPM_PLAN_REQUEST * requests,
+    unsigned max_requests)
+{
+    return rpm_plan_build_segmented(device_id, max_apdu, 1, points,
+        point_count, requests, max_requests);
+}
+
+/** Plan the requests that read the points from a device, for the max
+ *  APDU of the device in the address cache.
+ *
+ * @return the number of requests, or -1 if the device is not bound or
+ *         there is not room for the requests.
+ */
+int rpm_plan_build(
+    uint32_t device_id,
+    RPM_PLAN_POINT * points,
+    unsigned point_count,
+    RPM_PLAN_REQUEST * requests,
+    unsigned max_requests)
+{
+    BACNET_ADDRESS dest;
+    unsigned max_apdu = 0;
+
+    if (!address_get_by_device(device_id, &max_apdu, &dest)) {
+        return -1;
+    }
+
+    return rpm_plan_build_max_apdu(device_id, max_apdu, points, point_count,
+        requests, max_requests);
+}
+
+/** Build the list of properties to read for one request of a plan, as
+ *  given to Send_Read_Property_Multiple_Request().
+ *
+ * @param points [in] The points of the plan.
+ * @param request [in] The request from the plan.
+ * @param objects [out] Room for as many objects as the request has points.
+ * @param properties [out] Room for the points of the request.
+ * @return the first object of the list, or NULL if there are no points.
+ */
+BACNET_READ_ACCESS_DATA *rpm_plan_read_access_data(
+    RPM_PLAN_POINT * points,
+    RPM_PLAN_REQUEST * request,
+    BACNET_READ_ACCESS_DATA * objects,
+    BACNET_PROPERTY_REFERENCE * properties)
+{
+    BACNET_READ_ACCESS_DATA *rpm_object = NULL;
+    BACNET_PROPERTY_REFERENCE *rpm_property;
+    RPM_PLAN_POINT *pPoint, *pLast = NULL;
+    unsigned count;
+
+    if (!request || (request->count == 0)) {
+        return NULL;
+    }
+    for (count = 0; count < request->count; count++) {
+        pPoint = &points[request->first + count];
+        rpm_property = &properties[count];
+        rpm_property->propertyIdentifier = pPoint->object_property;
+        rpm_property->propertyArrayIndex = pPoint->array_index;
+        rpm_property->value = NULL;
+        rpm_property->next = NULL;
+        if (!pLast || (pLast->object_type != pPoint->object_type) ||
+            (pLast->object_instance != pPoint->object_instance)) {
+            if (rpm_object) {
+                rpm_object->next = rpm_object + 1;
+                rpm_object++;
+            } else {
+                rpm_object = &objects[0];
+            }
+            rpm_object->object_type = pPoint->object_type;
+            rpm_object->object_instance = pPoint->object_instance;
+            rpm_object->listOfProperties = rpm_property;
+            rpm_object->next = NULL;
+        } else {
+            properties[count - 1].next = rpm_property;
+        }
+        pLast = pPoint;
+    }
+
+    return &objects[0];
+}
+
+#ifdef TEST
+#include <assert.h>
+#include "ctest.h"
+
+#define TEST_DEVICE 4321
+
+static RPM_PLAN_POINT Test_Points[300];
+static RPM_PLAN_REQUEST Test_Requests[300];
+static BACNET_READ_ACCESS_DATA Test_Objects[RPM_PLAN_REQUEST_POINTS];
+static BACNET_PROPERTY_REFERENCE Test_Properties[RPM_PLAN_REQUEST_POINTS];
+
+/* analog inputs, each with its present value and status flags */
+static unsigned testRpmPlanPoints(
+    void)
+{
+    unsigned i;
+
+    for (i = 0; i < 300; i++) {
+        Test_Points[i].object_type = OBJECT_ANALOG_INPUT;
+        Test_Points[i].object_instance = i / 2;
+        Test_Points[i].object_property =
+            (i & 1) ? PROP_STATUS_FLAGS : PROP_PRESENT_VALUE;
+        Test_Points[i].array_index = BACNET_ARRAY_ALL;
+    }
+
+    return 300;
+}
+
+/* encode the ack of a request, with a value for each point */
+static int testRpmPlanAck(
+    RPM_PLAN_REQUEST * request,
+    uint8_t * apdu)
+{
+    BACNET_RPM_DATA rpmdata;
+    BACNET_BIT_STRING status_flags;
+    RPM_PLAN_POINT *pPoint, *pLast = NULL;
+    uint8_t value[8];
+    int value_len;
+    int len;
+    unsigned i;
+
+    bitstring_init(&status_flags);
+    for (i = 0; i < 4; i++) {
+        bitstring_set_bit(&status_flags, (uint8_t) i, false);
+    }
+
+    len = rpm_ack_encode_apdu_init(&apdu[0], 1);
+    for (i = 0; i < request->count; i++) {
+        pPoint = &Test_Points[request->first + i];
+        if (!pLast || (pLast->object_instance != pPoint->object_instance)) {
+            if (pLast) {
+                len += rpm_ack_encode_apdu_object_end(&apdu[len]);
+            }
+            rpmdata.object_type = pPoint->object_type;
+            rpmdata.object_instance = pPoint->object_instance;
+            len += rpm_ack_encode_apdu_object_begin(&apdu[len], &rpmdata);
+        }
+        len +=
+            rpm_ack_encode_apdu_object_property(&apdu[len],
+            pPoint->object_property, pPoint->array_index);
+        if (pPoint->object_property == PROP_STATUS_FLAGS) {
+            value_len =
+                encode_application_bitstring(&value[0], &status_flags);
+        } else {
+            value_len = encode_application_real(&value[0], 1.0);
+        }
+        len +=
+            rpm_ack_encode_apdu_object_property_value(&apdu[len], &value[0],
+            value_len);
+        pLast = pPoint;
+    }
+    len += rpm_ack_encode_apdu_object_end(&apdu[len]);
+
+    return len;
+}
+
+static void testRpmPlanPacking(
+    Test * pTest)
+{
+    static const unsigned max_apdus[] = { 50, 128, 206, 480, 1476 };
+    RPM_PLAN_REQUEST merged[2];
+    BACNET_READ_ACCESS_DATA *rpm_object;
+    uint8_t apdu[MAX_APDU * 2];
+    unsigned point_count, max_apdu, limit, next, i, m;
+    int count, len;
+
+    rpm_plan_init();
+    point_count = testRpmPlanPoints();
+    for (m = 0; m < sizeof(max_apdus) / sizeof(max_apdus[0]); m++) {
+        max_apdu = max_apdus[m];
+        limit = (max_apdu < MAX_APDU) ? max_apdu : MAX_APDU;
+        count =
+            rpm_plan_build_max_apdu(TEST_DEVICE, max_apdu, Test_Points,
+            point_count, Test_Requests, 300);
+        ct_test(pTest, count > 0);
+        next = 0;
+        for (i = 0; i < (unsigned) count; i++) {
+            /* the points are covered in order */
+            ct_test(pTest, Test_Requests[i].first == next);
+            ct_test(pTest, Test_Requests[i].count > 0);
+            ct_test(pTest, Test_Requests[i].count <= RPM_PLAN_REQUEST_POINTS);
+            ct_test(pTest, Test_Requests[i].rpm);
+            next += Test_Requests[i].count;
+            /* the size of the request is as predicted, and it fits */
+            rpm_object =
+                rpm_plan_read_access_data(Test_Points, &Test_Requests[i],
+                Test_Objects, Test_Properties);
+            ct_test(pTest, rpm_object != NULL);
+            len = rpm_encode_apdu(apdu, sizeof(apdu), 1, rpm_object);
+            ct_test(pTest, len == Test_Requests[i].request_size);
+            ct_test(pTest, (len + RPM_PLAN_NPDU_SIZE) <= (int) limit);
+            ct_test(pTest, Test_Requests[i].ack_size <= limit);
+            /* the ack is no larger than predicted */
+            len = testRpmPlanAck(&Test_Requests[i], apdu);
+            ct_test(pTest, len <= Test_Requests[i].ack_size);
+            /* and the next point would not have fit */
+            if ((i + 1) < (unsigned) count) {
+                ct_test(pTest,
+                    (Test_Requests[i].count == RPM_PLAN_REQUEST_POINTS) ||
+                    (rpm_plan_build_max_apdu(TEST_DEVICE, max_apdu,
+                            &Test_Points[Test_Requests[i].first],
+                            Test_Requests[i].count + 1, merged, 2) == 2));
+            }
+        }
+        ct_test(pTest, next == point_count);
+    }
+    /* not enough room for the requests */
+    count =
+        rpm_plan_build_max_apdu(TEST_DEVICE, 50, Test_Points, point_count,
+        Test_Requests, 2);
+    ct_test(pTest, count == -1);
+    /* no points, no requests */
+    count =
+        rpm_plan_build_max_apdu(TEST_DEVICE, 480, Test_Points, 0,
+        Test_Requests, 300);
+    ct_test(pTest, count == 0);
+}
+
+static void testRpmPlanLearn(
+    Test * pTest)
+{
+    BACNET_READ_ACCESS_DATA rpm_data[2];
+    BACNET_PROPERTY_REFERENCE rpm_property[3];
+    BACNET_APPLICATION_DATA_VALUE value[3];
+    BACNET_READ_PROPERTY_DATA rp_data;
+    uint8_t apdu[MAX_APDU * 2];
+    unsigned point_count, size, i;
+    int count, before, len;
+
+    rpm_plan_init();
+    point_count = testRpmPlanPoints();
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL) == RPM_PLAN_VALUE_SIZE);
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+            PROP_OBJECT_NAME, BACNET_ARRAY_ALL) == RPM_PLAN_STRING_SIZE);
+    before =
+        rpm_plan_build_max_apdu(TEST_DEVICE, 480, Test_Points, point_count,
+        Test_Requests, 300);
+    /* an ack with a real, a bit string, and an error */
+    rpm_data[0].object_type = OBJECT_ANALOG_INPUT;
+    rpm_data[0].object_instance = 0;
+    rpm_data[0].listOfProperties = &rpm_property[0];
+    rpm_data[0].next = &rpm_data[1];
+    rpm_property[0].propertyIdentifier = PROP_PRESENT_VALUE;
+    rpm_property[0].propertyArrayIndex = BACNET_ARRAY_ALL;
+    rpm_property[0].value = &value[0];
+    rpm_property[0].next = &rpm_property[1];
+    value[0].tag = BACNET_APPLICATION_TAG_REAL;
+    value[0].type.Real = 1.0;
+    value[0].next = NULL;
+    rpm_property[1].propertyIdentifier = PROP_STATUS_FLAGS;
+    rpm_property[1].propertyArrayIndex = BACNET_ARRAY_ALL;
+    rpm_property[1].value = &value[1];
+    rpm_property[1].next = NULL;
+    value[1].tag = BACNET_APPLICATION_TAG_BIT_STRING;
+    bitstring_init(&value[1].type.Bit_String);
+    for (i = 0; i < 4; i++) {
+        bitstring_set_bit(&value[1].type.Bit_String, (uint8_t) i, false);
+    }
+    value[1].next = NULL;
+    rpm_data[1].object_type = OBJECT_ANALOG_INPUT;
+    rpm_data[1].object_instance = 1;
+    rpm_data[1].listOfProperties = &rpm_property[2];
+    rpm_data[1].next = NULL;
+    rpm_property[2].propertyIdentifier = PROP_DESCRIPTION;
+    rpm_property[2].propertyArrayIndex = BACNET_ARRAY_ALL;
+    rpm_property[2].value = NULL;
+    rpm_property[2].error.error_class = ERROR_CLASS_PROPERTY;
+    rpm_property[2].error.error_code = ERROR_CODE_UNKNOWN_PROPERTY;
+    rpm_property[2].next = NULL;
+    rpm_plan_learn_rpm(TEST_DEVICE, &rpm_data[0]);
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL) == 5);
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+            PROP_STATUS_FLAGS, BACNET_ARRAY_ALL) == 3);
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+            PROP_DESCRIPTION, BACNET_ARRAY_ALL) == 4);
+    /* only for that device */
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE + 1, OBJECT_ANALOG_INPUT,
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL) == RPM_PLAN_VALUE_SIZE);
+    /* the learned sizes predict the ack exactly, and need fewer requests */
+    count =
+        rpm_plan_build_max_apdu(TEST_DEVICE, 480, Test_Points, point_count,
+        Test_Requests, 300);
+    ct_test(pTest, count > 0);
+    ct_test(pTest, count < before);
+    for (i = 0; i < (unsigned) count; i++) {
+        len = testRpmPlanAck(&Test_Requests[i], apdu);
+        ct_test(pTest, len == Test_Requests[i].ack_size);
+    }
+    /* a larger value replaces the size, and a smaller one lowers it */
+    rp_data.object_type = OBJECT_ANALOG_INPUT;
+    rp_data.object_instance = 1;
+    rp_data.object_property = PROP_DESCRIPTION;
+    rp_data.array_index = BACNET_ARRAY_ALL;
+    rp_data.application_data = apdu;
+    rp_data.application_data_len = 100;
+    rpm_plan_learn_rp(TEST_DEVICE, &rp_data);
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+            PROP_DESCRIPTION, BACNET_ARRAY_ALL) == 100);
+    rp_data.application_data_len = 20;
+    rpm_plan_learn_rp(TEST_DEVICE, &rp_data);
+    size =
+        rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+        PROP_DESCRIPTION, BACNET_ARRAY_ALL);
+    ct_test(pTest, size == 90);
+    for (i = 0; i < 100; i++) {
+        rpm_plan_learn_rp(TEST_DEVICE, &rp_data);
+    }
+    size =
+        rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+        PROP_DESCRIPTION, BACNET_ARRAY_ALL);
+    ct_test(pTest, size == 20);
+    /* an element of an array is learned apart from the whole array */
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+            PROP_PRESENT_VALUE, 1) == RPM_PLAN_VALUE_SIZE);
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+            PROP_PRIORITY_ARRAY, 0) == 5);
+}
+
+static void testRpmPlanDevice(
+    Test * pTest)
+{
+    BACNET_ADDRESS src;
+    unsigned point_count, i;
+    int count, before;
+
+    rpm_plan_init();
+    point_count = testRpmPlanPoints();
+    /* a device that does not support ReadPropertyMultiple */
+    ct_test(pTest, rpm_plan_rpm_supported(TEST_DEVICE));
+    ct_test(pTest, rpm_plan_rpm_supported_set(TEST_DEVICE, false));
+    ct_test(pTest, !rpm_plan_rpm_supported(TEST_DEVICE));
+    ct_test(pTest, rpm_plan_rpm_supported(TEST_DEVICE + 1));
+    count =
+        rpm_plan_build_max_apdu(TEST_DEVICE, 480, Test_Points, 10,
+        Test_Requests, 300);
+    ct_test(pTest, count == 10);
+    for (i = 0; i < 10; i++) {
+        ct_test(pTest, !Test_Requests[i].rpm);
+        ct_test(pTest, Test_Requests[i].first == i);
+        ct_test(pTest, Test_Requests[i].count == 1);
+    }
+    ct_test(pTest, Test_Requests[0].request_size == 11);
+    ct_test(pTest, Test_Requests[0].ack_size == 20);
+    ct_test(pTest, rpm_plan_rpm_supported_set(TEST_DEVICE, true));
+    ct_test(pTest, rpm_plan_rpm_supported(TEST_DEVICE));
+    /* an ack that did not fit makes the next acks smaller */
+    before =
+        rpm_plan_build_max_apdu(TEST_DEVICE, 480, Test_Points, point_count,
+        Test_Requests, 300);
+    ct_test(pTest, before > 0);
+    rpm_plan_overflow(TEST_DEVICE, &Test_Requests[0]);
+    count =
+        rpm_plan_build_max_apdu(TEST_DEVICE, 480, Test_Points, point_count,
+        Test_Requests, 300);
+    ct_test(pTest, count > before);
+    for (i = 0; i < (unsigned) count; i++) {
+        ct_test(pTest, Test_Requests[i].ack_size <= 360);
+    }
+    /* the max APDU of the device comes from the address cache */
+    address_init();
+    ct_test(pTest, rpm_plan_build(TEST_DEVICE + 1, Test_Points,
+            point_count, Test_Requests, 300) == -1);
+    memset(&src, 0, sizeof(src));
+    src.mac_len = 1;
+    src.mac[0] = 7;
+    address_add(TEST_DEVICE + 1, 128, &src);
+    count =
+        rpm_plan_build(TEST_DEVICE + 1, Test_Points, point_count,
+        Test_Requests, 300);
+    ct_test(pTest, count > 0);
+    ct_test(pTest, count == rpm_plan_build_max_apdu(TEST_DEVICE + 1, 128,
+            Test_Points, point_count, Test_Requests, 300));
+    for (i = 0; i < (unsigned) count; i++) {
+        ct_test(pTest, Test_Requests[i].ack_size <= 128);
+    }
+}
+
+static void testRpmPlanSets(
+    Test * pTest)
+{
+    BACNET_READ_PROPERTY_DATA rp_data;
+    struct Rpm_Plan_Size *pSet;
+    uint32_t property[RPM_PLAN_WAYS + 1];
+    uint8_t apdu[4] = { 0 };
+    unsigned count = 0, i;
+    uint32_t p;
+    int requests, segmented;
+
+    rpm_plan_init();
+    /* properties that all have the same set */
+    pSet = rpm_plan_size_set(TEST_DEVICE, OBJECT_ANALOG_INPUT, 0, false);
+    for (p = 0; (p < 100000) && (count <= RPM_PLAN_WAYS); p++) {
+        if (rpm_plan_size_set(TEST_DEVICE, OBJECT_ANALOG_INPUT, p,
+                false) == pSet) {
+            property[count++] = p;
+        }
+    }
+    ct_test(pTest, count == (RPM_PLAN_WAYS + 1));
+    rp_data.object_type = OBJECT_ANALOG_INPUT;
+    rp_data.object_instance = 1;
+    rp_data.array_index = BACNET_ARRAY_ALL;
+    rp_data.application_data = apdu;
+    /* each of them is kept, with its own size */
+    for (i = 0; i < RPM_PLAN_WAYS; i++) {
+        rp_data.object_property = (BACNET_PROPERTY_ID) property[i];
+        rp_data.application_data_len = (int) (10 + i);
+        rpm_plan_learn_rp(TEST_DEVICE, &rp_data);
+    }
+    for (i = 0; i < RPM_PLAN_WAYS; i++) {
+        ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+                (BACNET_PROPERTY_ID) property[i], BACNET_ARRAY_ALL) ==
+            (10 + i));
+    }
+    /* one more takes the place of the least recently learned */
+    rp_data.object_property = (BACNET_PROPERTY_ID) property[0];
+    rp_data.application_data_len = 10;
+    rpm_plan_learn_rp(TEST_DEVICE, &rp_data);
+    rp_data.object_property = (BACNET_PROPERTY_ID) property[RPM_PLAN_WAYS];
+    rp_data.application_data_len = 50;
+    rpm_plan_learn_rp(TEST_DEVICE, &rp_data);
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+            (BACNET_PROPERTY_ID) property[RPM_PLAN_WAYS],
+            BACNET_ARRAY_ALL) == 50);
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+            (BACNET_PROPERTY_ID) property[0], BACNET_ARRAY_ALL) == 10);
+    ct_test(pTest, rpm_plan_value_size(TEST_DEVICE, OBJECT_ANALOG_INPUT,
+            (BACNET_PROPERTY_ID) property[1], BACNET_ARRAY_ALL) ==
+        RPM_PLAN_VALUE_SIZE);
+    /* an ack in segments holds more points than one APDU */
+    testRpmPlanPoints();
+    requests =
+        rpm_plan_build_max_apdu(TEST_DEVICE, 206, Test_Points, 300,
+        Test_Requests, 300);
+    segmented =
+        rpm_plan_build_segmented(TEST_DEVICE, 206, 4, Test_Points, 300,
+        Test_Requests, 300);
+    ct_test(pTest, segmented > 0);
+    ct_test(pTest, segmented < requests);
+    for (i = 0; i < (unsigned) segmented; i++) {
+        ct_test(pTest, Test_Requests[i].ack_size <= (206 * 4));
+        ct_test(pTest,
+            (Test_Requests[i].request_size + RPM_PLAN_NPDU_SIZE) <= 206);
+    }
+}
+
+void testRpmPlan(
+    Test * pTest)
+{
+    testRpmPlanPacking(pTest);
+    testRpmPlanLearn(pTest);
+    testRpmPlanDevice(pTest);
+    testRpmPlanSets(pTest);
+}
+
+#ifdef TEST_RPM_PLAN
+int main(
+    void)
+{
+    Test *pTest;
+    bool rc;
+
+    pTest = ct_create("BACnet RPM Plan", NULL);
+    /* individual tests */
+    rc = ct_addTestFunction(pTest, testRpmPlanPacking);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testRpmPlanLearn);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testRpmPlanDevice);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testRpmPlanSets);
+    assert(rc);
+
+    ct_setStream(pTest, stdout);
+    ct_run(pTest);
+    (void) ct_report(pTest);
+    ct_destroy(pTest);
+
+    return 0;
+}
+#endif /* TEST_RPM_PLAN */
+#endif /* TEST */
@@ -46,6 +46,11 @@
 #include "handlers.h"
 #include "address.h"
 #include "bacaddr.h"
+#if BACNET_SEGMENTATION_ENABLED
+#include <stdlib.h>
+#include <string.h>
+#include "abort.h"
+#endif
 
 /** @file tsm.c  BACnet Transaction State Machine operations  */
 
@@ -55,16 +60,79 @@
 /* If we are only a server and only initiate broadcasts, */
 /* then we don't need a TSM layer. */
 
-/* FIXME: not coded for segmentation */
-
-/* declare space for the TSM transactions, and set it up in the init. */
-/* table rules: an Invoke ID = 0 is an unused spot in the table */
+/* declare space for the TSM transactions. */
+/* With segmentation, the table also holds the server side of the
+   segmented messages we receive or send as a responding BACnet-user.
+   Those are keyed by peer address and the peer's invoke ID, and are
+   never returned by the client invoke ID lookups. */
 static BACNET_TSM_DATA TSM_List[MAX_TSM_TRANSACTIONS];
 
+/* The table is indexed so that no call scans it:
+   - unused entries are kept on a free list,
+   - entries that know their peer are chained in a hash table keyed by
+     (peer address, invoke ID, client or server),
+   - the invoke IDs of tsm_next_free_invokeID() are unique across all
+     peers, and are indexed by invoke ID,
+   - the invoke IDs of tsm_next_free_peer_invokeID() are only unique
+     for the peer, so each peer has 255 of its own,
+   - the running timers are kept on a hierarchical timer wheel.
+   The links hold the index plus one, so that zero is "none" and the
+   static tables need no initialization. */
+#if (MAX_TSM_TRANSACTIONS > 65000)
+#error MAX_TSM_TRANSACTIONS is too large for the TSM table indexes
+#endif
+typedef uint16_t TSM_INDEX;
+
+#define TSM_INDEX_OF(tsm) ((TSM_INDEX) ((tsm) - &TSM_List[0]))
+#if BACNET_SEGMENTATION_ENABLED
+#define TSM_SERVER(index) (TSM_List[index].server)
+#else
+#define TSM_SERVER(index) (false)
+#endif
+
+/* The wheel has TSM_WHEEL_LEVELS levels of TSM_WHEEL_SIZE slots of one,
+   64, and 4096 milliseconds, which covers the 16-bit timeouts.  Timers
+   move down a level as their time comes closer, so a tick only looks
+   at one slot. */
+#define TSM_WHEEL_BITS 6
+#define TSM_WHEEL_SIZE (1 << TSM_WHEEL_BITS)
+#define TSM_WHEEL_MASK (TSM_WHEEL_SIZE - 1)
+#define TSM_WHEEL_LEVELS 3
+
+typedef struct tsm_link {
+    /* next entry on the free list, or in the hash chain */
+    TSM_INDEX next;
+    /* the timer wheel slot list */
+    TSM_INDEX timer_next;
+    TSM_INDEX timer_prev;
+    /* wheel slot plus one, or zero when the timer is stopped */
+    uint8_t timer_slot;
+    /* expiration time of the timer, in milliseconds */
+    uint32_t timer_expires;
+    bool used;
+    bool hashed;
+} TSM_LINK;
+
+static TSM_LINK TSM_Link[MAX_TSM_TRANSACTIONS];
+static TSM_INDEX TSM_Free_List;
+/* entries from here up have never been used, and are not on the list */
+static TSM_INDEX TSM_Free_Unused;
+static TSM_INDEX TSM_Used_Count;
+static TSM_INDEX TSM_Hash[MAX_TSM_TRANSACTIONS];
+/* the entry of each invoke ID from tsm_next_free_invokeID() */
+static TSM_INDEX TSM_Invoke_ID_Index[256];
+/* the number of client transactions using each invoke ID, any peer */
+static TSM_INDEX TSM_Invoke_ID_Count[256];
+static TSM_INDEX TSM_Wheel[TSM_WHEEL_LEVELS * TSM_WHEEL_SIZE];
+static TSM_INDEX TSM_Timer_Count;
+/* milliseconds counted by tsm_timer_milliseconds() */
+static uint32_t TSM_Clock;
+
 /* invoke ID for incrementing between subsequent calls. */
 static uint8_t Current_Invoke_ID = 1;
 
 static tsm_timeout_function Timeout_Function;
+static tsm_peer_timeout_function Peer_Timeout_Function;
 
 void tsm_set_timeout_handler(
     tsm_timeout_function pFunction)
@@ -72,71 +140,644 @@ void tsm_set_timeout_handler(
     Timeout_Function = pFunction;
 }
 
-/* returns MAX_TSM_TRANSACTIONS if not found */
-static uint8_t tsm_find_invokeID_index(
-    uint8_t invokeID)
+void tsm_set_peer_timeout_handler(
+    tsm_peer_timeout_function pFunction)
+{
+    Peer_Timeout_Function = pFunction;
+}
+
+static void tsm_timer_insert(
+    TSM_INDEX index)
+{
+    TSM_LINK *link = &TSM_Link[index];
+    uint32_t expires = link->timer_expires;
+    uint32_t delta = expires - TSM_Clock;
+    unsigned slot = 0;
+
+    if (delta < TSM_WHEEL_SIZE) {
+        slot = expires & TSM_WHEEL_MASK;
+    } else if (delta < (1UL << (2 * TSM_WHEEL_BITS))) {
+        slot = TSM_WHEEL_SIZE + ((expires >> TSM_WHEEL_BITS) & TSM_WHEEL_MASK);
+    } else {
+        slot = (2 * TSM_WHEEL_SIZE) +
+            ((expires >> (2 * TSM_WHEEL_BITS)) & TSM_WHEEL_MASK);
+    }
+    link->timer_prev = 0;
+    link->timer_next = TSM_Wheel[slot];
+    if (link->timer_next) {
+        TSM_Link[link->timer_next - 1].timer_prev = index + 1;
+    }
+    TSM_Wheel[slot] = index + 1;
+    link->timer_slot = (uint8_t) (slot + 1);
+    TSM_Timer_Count++;
+}
+
+static void tsm_timer_stop(
+    TSM_INDEX index)
+{
+    TSM_LINK *link = &TSM_Link[index];
+
+    if (link->timer_slot == 0) {
+        return;
+    }
+    if (link->timer_prev) {
+        TSM_Link[link->timer_prev - 1].timer_next = link->timer_next;
+    } else {
+        TSM_Wheel[link->timer_slot - 1] = link->timer_next;
+    }
+    if (link->timer_next) {
+        TSM_Link[link->timer_next - 1].timer_prev = link->timer_prev;
+    }
+    link->timer_next = 0;
+    link->timer_prev = 0;
+    link->timer_slot = 0;
+    TSM_Timer_Count--;
+}
+
+/* (re)starts the timer of the transaction - RequestTimer or SegmentTimer,
+   which are never running at the same time */
+static void tsm_timer_start(
+    TSM_INDEX index,
+    uint16_t milliseconds)
+{
+    tsm_timer_stop(index);
+    if (milliseconds == 0) {
+        milliseconds = 1;
+    }
+    TSM_Link[index].timer_expires = TSM_Clock + milliseconds;
+    tsm_timer_insert(index);
+}
+
+/* moves the timers of a slot down to the lower levels */
+static void tsm_timer_cascade(
+    unsigned slot)
+{
+    TSM_INDEX next = TSM_Wheel[slot];
+    TSM_INDEX index = 0;
+
+    TSM_Wheel[slot] = 0;
+    while (next) {
+        index = next - 1;
+        next = TSM_Link[index].timer_next;
+        TSM_Link[index].timer_slot = 0;
+        TSM_Timer_Count--;
+        tsm_timer_insert(index);
+    }
+}
+
+static TSM_INDEX tsm_hash(
+    BACNET_ADDRESS * peer,
+    uint8_t invokeID,
+    bool server)
 {
-    unsigned i = 0;     /* counter */
-    uint8_t index = MAX_TSM_TRANSACTIONS;       /* return value */
+    uint32_t hash = bacnet_address_hash(peer);
+
+    hash = (hash ^ invokeID) * 16777619UL;
+    if (server) {
+        hash = (hash ^ 0xFF) * 16777619UL;
+    }
 
-    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
-        if (TSM_List[i].InvokeID == invokeID) {
-            index = (uint8_t) i;
+    return (TSM_INDEX) (hash % MAX_TSM_TRANSACTIONS);
+}
+
+static void tsm_hash_remove(
+    TSM_INDEX index)
+{
+    TSM_INDEX *next = NULL;
+
+    if (!TSM_Link[index].hashed) {
+        return;
+    }
+    next =
+        &TSM_Hash[tsm_hash(&TSM_List[index].dest, TSM_List[index].InvokeID,
+            TSM_SERVER(index))];
+    while (*next) {
+        if (*next == (index + 1)) {
+            *next = TSM_Link[index].next;
             break;
         }
+        next = &TSM_Link[*next - 1].next;
     }
+    TSM_Link[index].next = 0;
+    TSM_Link[index].hashed = false;
+}
 
-    return index;
+/* sets the peer of the transaction, which keys it in the hash table */
+static void tsm_peer_set(
+    TSM_INDEX index,
+    BACNET_ADDRESS * peer)
+{
+    TSM_INDEX hash = 0;
+
+    if (TSM_Link[index].hashed) {
+        if (bacnet_address_same(&TSM_List[index].dest, peer)) {
+            return;
+        }
+        tsm_hash_remove(index);
+    }
+    bacnet_address_copy(&TSM_List[index].dest, peer);
+    hash = tsm_hash(peer, TSM_List[index].InvokeID, TSM_SERVER(index));
+    TSM_Link[index].next = TSM_Hash[hash];
+    TSM_Hash[hash] = index + 1;
+    TSM_Link[index].hashed = true;
 }
 
-static uint8_t tsm_find_first_free_index(
-    void)
+/* returns MAX_TSM_TRANSACTIONS if not found */
+static TSM_INDEX tsm_find_peer_index(
+    BACNET_ADDRESS * peer,
+    uint8_t invokeID,
+    bool server)
 {
-    unsigned i = 0;     /* counter */
-    uint8_t index = MAX_TSM_TRANSACTIONS;       /* return value */
+    TSM_INDEX next = TSM_Hash[tsm_hash(peer, invokeID, server)];
+    TSM_INDEX index = 0;
 
-    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
-        if (TSM_List[i].InvokeID == 0) {
-            index = (uint8_t) i;
-            break;
+    while (next) {
+        index = next - 1;
+        if ((TSM_List[index].InvokeID == invokeID) &&
+            (TSM_SERVER(index) == server) &&
+            bacnet_address_same(&TSM_List[index].dest, peer)) {
+            return index;
         }
+        next = TSM_Link[index].next;
     }
 
+    return MAX_TSM_TRANSACTIONS;
+}
+
+/* finds an invoke ID from tsm_next_free_invokeID() -
+   returns MAX_TSM_TRANSACTIONS if not found */
+static TSM_INDEX tsm_find_invokeID_index(
+    uint8_t invokeID)
+{
+    if (TSM_Invoke_ID_Index[invokeID]) {
+        return TSM_Invoke_ID_Index[invokeID] - 1;
+    }
+
+    return MAX_TSM_TRANSACTIONS;
+}
+
+/* takes an entry off the free list -
+   returns MAX_TSM_TRANSACTIONS if the table is full */
+static TSM_INDEX tsm_entry_alloc(
+    void)
+{
+    TSM_INDEX index = MAX_TSM_TRANSACTIONS;
+
+    if (TSM_Free_List) {
+        index = TSM_Free_List - 1;
+        TSM_Free_List = TSM_Link[index].next;
+    } else if (TSM_Free_Unused < MAX_TSM_TRANSACTIONS) {
+        index = TSM_Free_Unused++;
+    } else {
+        return MAX_TSM_TRANSACTIONS;
+    }
+    TSM_Link[index].next = 0;
+    TSM_Link[index].used = true;
+    TSM_Link[index].hashed = false;
+    TSM_Used_Count++;
+    TSM_List[index].state = TSM_STATE_IDLE;
+    TSM_List[index].InvokeID = 0;
+    TSM_List[index].RetryCount = 0;
+    TSM_List[index].apdu_len = 0;
+#if BACNET_SEGMENTATION_ENABLED
+    TSM_List[index].server = false;
+    TSM_List[index].segment_data = NULL;
+    TSM_List[index].segment_data_len = 0;
+    TSM_List[index].segment_data_size = 0;
+    TSM_List[index].segment_index = 0;
+#endif
+
     return index;
 }
 
-bool tsm_transaction_available(
+/* takes a client entry with the invoke ID */
+static TSM_INDEX tsm_client_alloc(
+    uint8_t invokeID)
+{
+    TSM_INDEX index = tsm_entry_alloc();
+
+    if (index < MAX_TSM_TRANSACTIONS) {
+        TSM_List[index].InvokeID = invokeID;
+        TSM_Invoke_ID_Count[invokeID]++;
+    }
+
+    return index;
+}
+
+static void tsm_entry_free(
+    TSM_INDEX index)
+{
+    uint8_t invokeID = TSM_List[index].InvokeID;
+
+    if (!TSM_Link[index].used) {
+        return;
+    }
+    tsm_timer_stop(index);
+    tsm_hash_remove(index);
+    if (!TSM_SERVER(index)) {
+        TSM_Invoke_ID_Count[invokeID]--;
+        if (TSM_Invoke_ID_Index[invokeID] == (index + 1)) {
+            TSM_Invoke_ID_Index[invokeID] = 0;
+        }
+    }
+#if BACNET_SEGMENTATION_ENABLED
+    free(TSM_List[index].segment_data);
+    TSM_List[index].segment_data = NULL;
+    TSM_List[index].server = false;
+#endif
+    TSM_List[index].state = TSM_STATE_IDLE;
+    TSM_List[index].InvokeID = 0;
+    TSM_Link[index].used = false;
+    TSM_Link[index].next = TSM_Free_List;
+    TSM_Free_List = index + 1;
+    TSM_Used_Count--;
+}
+
+/* the transaction failed: IDLE with a valid invoke ID */
+static void tsm_transaction_timeout(
+    TSM_INDEX index)
+{
+    BACNET_TSM_DATA *tsm = &TSM_List[index];
+
+    if (Timeout_Function &&
+        (TSM_Invoke_ID_Index[tsm->InvokeID] == (index + 1))) {
+        Timeout_Function(tsm->InvokeID);
+    }
+    if (Peer_Timeout_Function) {
+        Peer_Timeout_Function(&tsm->dest, tsm->InvokeID);
+    }
+}
+
+#if BACNET_SEGMENTATION_ENABLED
+/* scratch buffer for the segments, segment acks and aborts we send */
+static uint8_t Segment_PDU[MAX_PDU];
+
+static void tsm_segment_data_free(
+    BACNET_TSM_DATA * tsm)
+{
+    free(tsm->segment_data);
+    tsm->segment_data = NULL;
+    tsm->segment_data_len = 0;
+    tsm->segment_data_size = 0;
+    tsm->segment_index = 0;
+}
+
+/* T_wait_for_seg is four times the segment timeout */
+static uint16_t tsm_segment_wait_timeout(
     void)
 {
-    bool status = false;        /* return value */
-    unsigned i = 0;     /* counter */
+    uint32_t timeout = 4UL * apdu_segment_timeout();
 
-    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
-        if (TSM_List[i].InvokeID == 0) {
-            /* one is available! */
-            status = true;
+    if (timeout > UINT16_MAX) {
+        timeout = UINT16_MAX;
+    }
+
+    return (uint16_t) timeout;
+}
+
+static void tsm_send_abort(
+    BACNET_ADDRESS * dest,
+    uint8_t invokeID,
+    uint8_t abort_reason,
+    bool server)
+{
+    BACNET_ADDRESS my_address;
+    BACNET_NPDU_DATA npdu_data;
+    int pdu_len = 0;
+
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    pdu_len = npdu_encode_pdu(&Segment_PDU[0], dest, &my_address, &npdu_data);
+    pdu_len +=
+        abort_encode_apdu(&Segment_PDU[pdu_len], invokeID, abort_reason,
+        server);
+    (void) datalink_send_pdu(dest, &npdu_data, &Segment_PDU[0], pdu_len);
+}
+
+static void tsm_send_segment_ack(
+    BACNET_TSM_DATA * tsm,
+    bool nak,
+    uint8_t sequence_number)
+{
+    BACNET_ADDRESS my_address;
+    BACNET_NPDU_DATA npdu_data;
+    int pdu_len = 0;
+
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, false, tsm->npdu_data.priority);
+    pdu_len =
+        npdu_encode_pdu(&Segment_PDU[0], &tsm->dest, &my_address, &npdu_data);
+    Segment_PDU[pdu_len] = PDU_TYPE_SEGMENT_ACK;
+    if (nak) {
+        Segment_PDU[pdu_len] |= BIT(1);
+    }
+    if (tsm->server) {
+        Segment_PDU[pdu_len] |= BIT(0);
+    }
+    pdu_len++;
+    Segment_PDU[pdu_len++] = tsm->InvokeID;
+    Segment_PDU[pdu_len++] = sequence_number;
+    Segment_PDU[pdu_len++] = tsm->ActualWindowSize;
+    (void) datalink_send_pdu(&tsm->dest, &npdu_data, &Segment_PDU[0],
+        pdu_len);
+}
+
+static uint32_t tsm_segment_count(
+    BACNET_TSM_DATA * tsm)
+{
+    return (tsm->segment_data_len + tsm->segment_size - 1) /
+        tsm->segment_size;
+}
+
+/* sends one segment of a Confirmed-Request or Complex-ACK */
+static void tsm_send_segment(
+    BACNET_TSM_DATA * tsm,
+    uint32_t segment)
+{
+    BACNET_ADDRESS my_address;
+    uint32_t offset = segment * tsm->segment_size;
+    uint32_t len = tsm->segment_data_len - offset;
+    bool more_follows = false;
+    int pdu_len = 0;
+
+    if (len > tsm->segment_size) {
+        len = tsm->segment_size;
+        more_follows = true;
+    }
+    datalink_get_my_address(&my_address);
+    pdu_len =
+        npdu_encode_pdu(&Segment_PDU[0], &tsm->dest, &my_address,
+        &tsm->npdu_data);
+    if (tsm->server) {
+        Segment_PDU[pdu_len] = PDU_TYPE_COMPLEX_ACK | BIT(3);
+        if (more_follows) {
+            Segment_PDU[pdu_len] |= BIT(2);
+        }
+        pdu_len++;
+    } else {
+        /* we accept a segmented response to our segmented request */
+        Segment_PDU[pdu_len] =
+            PDU_TYPE_CONFIRMED_SERVICE_REQUEST | BIT(3) | BIT(1);
+        if (more_follows) {
+            Segment_PDU[pdu_len] |= BIT(2);
+        }
+        pdu_len++;
+        Segment_PDU[pdu_len++] = tsm->max_segs_max_apdu;
+    }
+    Segment_PDU[pdu_len++] = tsm->InvokeID;
+    /* sequence numbers are modulo 256 */
+    Segment_PDU[pdu_len++] = (uint8_t) segment;
+    Segment_PDU[pdu_len++] = tsm->ProposedWindowSize;
+    Segment_PDU[pdu_len++] = tsm->service_choice;
+    memcpy(&Segment_PDU[pdu_len], &tsm->segment_data[offset], len);
+    pdu_len += len;
+    (void) datalink_send_pdu(&tsm->dest, &tsm->npdu_data, &Segment_PDU[0],
+        pdu_len);
+}
+
+/* sends the segments of the window starting at segment_index */
+static void tsm_send_window(
+    BACNET_TSM_DATA * tsm)
+{
+    uint32_t count = tsm_segment_count(tsm);
+    uint32_t segment = 0;
+    unsigned i = 0;
+
+    for (i = 0; i < tsm->ActualWindowSize; i++) {
+        segment = tsm->segment_index + i;
+        if (segment >= count) {
             break;
         }
+        tsm_send_segment(tsm, segment);
+        if ((segment + 1) == count) {
+            tsm->SentAllSegments = true;
+        }
     }
+    tsm_timer_start(TSM_INDEX_OF(tsm), apdu_segment_timeout());
+}
 
-    return status;
+/* the first segment is sent alone - the SegmentACK for it
+   carries the window size the receiver accepts */
+static void tsm_segmented_send_start(
+    BACNET_TSM_DATA * tsm)
+{
+    tsm->SegmentRetryCount = 0;
+    tsm->SentAllSegments = false;
+    tsm->InitialSequenceNumber = 0;
+    tsm->ActualWindowSize = 1;
+    tsm->ProposedWindowSize = BACNET_SEGMENT_WINDOW_SIZE;
+    tsm->segment_index = 0;
+    tsm_send_window(tsm);
+}
+
+/* stores the service data of an in-order segment */
+static bool tsm_segment_append(
+    BACNET_TSM_DATA * tsm,
+    uint8_t * data,
+    uint16_t data_len,
+    uint32_t max_len)
+{
+    uint32_t size = 0;
+    uint8_t *buffer = NULL;
+
+    if ((tsm->segment_index >= MAX_SEGMENTS_ACCEPTED) ||
+        ((tsm->segment_data_len + data_len) > max_len)) {
+        return false;
+    }
+    if ((tsm->segment_data_len + data_len) > tsm->segment_data_size) {
+        size = tsm->segment_data_size;
+        if (size == 0) {
+            size = 4 * MAX_APDU;
+        }
+        while (size < (tsm->segment_data_len + data_len)) {
+            size *= 2;
+        }
+        if (size > max_len) {
+            size = max_len;
+        }
+        buffer = realloc(tsm->segment_data, size);
+        if (!buffer) {
+            return false;
+        }
+        tsm->segment_data = buffer;
+        tsm->segment_data_size = size;
+    }
+    memcpy(&tsm->segment_data[tsm->segment_data_len], data, data_len);
+    tsm->segment_data_len += data_len;
+    tsm->segment_index++;
+
+    return true;
 }
 
-uint8_t tsm_transaction_idle_count(
+/* processes a received segment as the receiver of a segmented message.
+   Returns false and sets the abort reason if the message can't be
+   received, and sets complete when the final segment arrived. */
+static bool tsm_segment_receive(
+    BACNET_TSM_DATA * tsm,
+    uint8_t sequence_number,
+    uint8_t proposed_window_size,
+    bool more_follows,
+    uint8_t * data,
+    uint16_t data_len,
+    uint32_t max_len,
+    bool * complete,
+    uint8_t * abort_reason)
+{
+    *complete = false;
+    tsm_timer_start(TSM_INDEX_OF(tsm), tsm_segment_wait_timeout());
+    if (tsm->segment_index == 0) {
+        if (sequence_number != 0) {
+            *abort_reason = ABORT_REASON_INVALID_APDU_IN_THIS_STATE;
+            return false;
+        }
+        if ((proposed_window_size == 0) || (proposed_window_size > 127)) {
+            *abort_reason = ABORT_REASON_OTHER;
+            return false;
+        }
+        /* negotiate the window size */
+        tsm->ProposedWindowSize = proposed_window_size;
+        tsm->ActualWindowSize = proposed_window_size;
+        if (tsm->ActualWindowSize > BACNET_SEGMENT_WINDOW_SIZE) {
+            tsm->ActualWindowSize = BACNET_SEGMENT_WINDOW_SIZE;
+        }
+        if (!tsm_segment_append(tsm, data, data_len, max_len)) {
+            *abort_reason = ABORT_REASON_BUFFER_OVERFLOW;
+            return false;
+        }
+        tsm->InitialSequenceNumber = 0;
+        tsm->LastSequenceNumber = 0;
+        tsm_send_segment_ack(tsm, false, 0);
+        *complete = !more_follows;
+        return true;
+    }
+    if (sequence_number != (uint8_t) (tsm->LastSequenceNumber + 1)) {
+        /* SegmentReceivedOutOfOrder - discard and request a resend */
+        tsm_send_segment_ack(tsm, true, tsm->LastSequenceNumber);
+        tsm->InitialSequenceNumber = tsm->LastSequenceNumber;
+        return true;
+    }
+    if (!tsm_segment_append(tsm, data, data_len, max_len)) {
+        *abort_reason = ABORT_REASON_BUFFER_OVERFLOW;
+        return false;
+    }
+    tsm->LastSequenceNumber = sequence_number;
+    if (!more_follows) {
+        tsm_send_segment_ack(tsm, false, sequence_number);
+        *complete = true;
+    } else if (sequence_number ==
+        (uint8_t) (tsm->InitialSequenceNumber + tsm->ActualWindowSize)) {
+        tsm_send_segment_ack(tsm, false, sequence_number);
+        tsm->InitialSequenceNumber = sequence_number;
+    }
+
+    return true;
+}
+
+/* the SegmentTimer expired */
+static void tsm_segment_timeout(
+    TSM_INDEX index)
+{
+    BACNET_TSM_DATA *tsm = &TSM_List[index];
+    bool sending = false;
+
+    if (tsm->server) {
+        sending = (tsm->state == TSM_STATE_SEGMENTED_RESPONSE);
+    } else {
+        sending = (tsm->state == TSM_STATE_SEGMENTED_REQUEST);
+    }
+    if (sending && (tsm->SegmentRetryCount < apdu_retries())) {
+        /* resend the window that was not acknowledged */
+        tsm->SegmentRetryCount++;
+        tsm_send_window(tsm);
+        return;
+    }
+    /* FinalTimeout - give up on the transaction */
+    if (tsm->server) {
+        tsm_entry_free(index);
+    } else {
+        tsm_segment_data_free(tsm);
+        tsm->state = TSM_STATE_IDLE;
+        tsm_transaction_timeout(index);
+    }
+}
+#endif
+
+/* called when the timer of a transaction expires */
+static void tsm_timer_expired(
+    TSM_INDEX index)
+{
+    BACNET_TSM_DATA *tsm = &TSM_List[index];
+
+#if BACNET_SEGMENTATION_ENABLED
+    if ((tsm->state == TSM_STATE_SEGMENTED_REQUEST) ||
+        (tsm->state == TSM_STATE_SEGMENTED_CONFIRMATION) ||
+        (tsm->state == TSM_STATE_SEGMENTED_RESPONSE)) {
+        tsm_segment_timeout(index);
+        return;
+    }
+#endif
+    if (tsm->state == TSM_STATE_AWAIT_CONFIRMATION) {
+        if (tsm->RetryCount < apdu_retries()) {
+            tsm->RetryCount++;
+            tsm_timer_start(index, apdu_timeout());
+#if BACNET_SEGMENTATION_ENABLED
+            if (tsm->segment_data) {
+                /* start the segmented request over */
+                tsm->state = TSM_STATE_SEGMENTED_REQUEST;
+                tsm_segmented_send_start(tsm);
+                return;
+            }
+#endif
+            datalink_send_pdu(&tsm->dest, &tsm->npdu_data, &tsm->apdu[0],
+                tsm->apdu_len);
+        } else {
+            /* note: the invoke id has not been cleared yet
+               and this indicates a failed message:
+               IDLE and a valid invoke id */
+            tsm->state = TSM_STATE_IDLE;
+#if BACNET_SEGMENTATION_ENABLED
+            tsm_segment_data_free(tsm);
+#endif
+            tsm_transaction_timeout(index);
+        }
+    }
+}
+
+/* advances the wheel by one millisecond, and runs the expired timers */
+static void tsm_timer_tick(
     void)
 {
-    uint8_t count = 0;  /* return value */
-    unsigned i = 0;     /* counter */
+    unsigned slot = 0;
 
-    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
-        if ((TSM_List[i].InvokeID == 0) &&
-            (TSM_List[i].state == TSM_STATE_IDLE)) {
-            /* one is available! */
-            count++;
+    TSM_Clock++;
+    if ((TSM_Clock & TSM_WHEEL_MASK) == 0) {
+        slot = (TSM_Clock >> TSM_WHEEL_BITS) & TSM_WHEEL_MASK;
+        tsm_timer_cascade(TSM_WHEEL_SIZE + slot);
+        if (slot == 0) {
+            slot = (TSM_Clock >> (2 * TSM_WHEEL_BITS)) & TSM_WHEEL_MASK;
+            tsm_timer_cascade((2 * TSM_WHEEL_SIZE) + slot);
         }
     }
+    slot = TSM_Clock & TSM_WHEEL_MASK;
+    /* an expired timer may be started again, but never in this slot */
+    while (TSM_Wheel[slot]) {
+        TSM_INDEX index = TSM_Wheel[slot] - 1;
+
+        tsm_timer_stop(index);
+        tsm_timer_expired(index);
+    }
+}
 
-    return count;
+bool tsm_transaction_available(
+    void)
+{
+    return (TSM_Used_Count < MAX_TSM_TRANSACTIONS);
+}
+
+uint16_t tsm_transaction_idle_count(
+    void)
+{
+    return (uint16_t) (MAX_TSM_TRANSACTIONS - TSM_Used_Count);
 }
 
 /* sets the invokeID */
@@ -150,49 +791,93 @@ void tsm_invokeID_set(
     Current_Invoke_ID = invokeID;
 }
 
+/* returns the current invoke ID, and moves on to the next */
+static uint8_t tsm_invokeID_next(
+    void)
+{
+    uint8_t invokeID = Current_Invoke_ID;
+
+    Current_Invoke_ID++;
+    /* skip zero - we treat that internally as invalid or no free */
+    if (Current_Invoke_ID == 0) {
+        Current_Invoke_ID = 1;
+    }
+
+    return invokeID;
+}
+
 /* gets the next free invokeID,
    and reserves a spot in the table
    returns 0 if none are available */
 uint8_t tsm_next_free_invokeID(
     void)
 {
-    uint8_t index = 0;
+    TSM_INDEX index = 0;
     uint8_t invokeID = 0;
-    bool found = false;
+    unsigned i = 0;
 
     /* is there even space available? */
     if (tsm_transaction_available()) {
-        while (!found) {
-            index = tsm_find_invokeID_index(Current_Invoke_ID);
-            if (index == MAX_TSM_TRANSACTIONS) {
-                /* Not found, so this invokeID is not used */
-                found = true;
-                /* set this id into the table */
-                index = tsm_find_first_free_index();
-                if (index != MAX_TSM_TRANSACTIONS) {
-                    TSM_List[index].InvokeID = invokeID = Current_Invoke_ID;
-                    TSM_List[index].state = TSM_STATE_IDLE;
-                    TSM_List[index].RequestTimer = apdu_timeout();
-                    /* update for the next call or check */
-                    Current_Invoke_ID++;
-                    /* skip zero - we treat that internally as invalid or no free */
-                    if (Current_Invoke_ID == 0) {
-                        Current_Invoke_ID = 1;
-                    }
-                }
-            } else {
-                /* found! This invokeID is already used */
-                /* try next one */
-                Current_Invoke_ID++;
-                /* skip zero - we treat that internally as invalid or no free */
-                if (Current_Invoke_ID == 0) {
-                    Current_Invoke_ID = 1;
-                }
+        for (i = 0; i < 255; i++) {
+            invokeID = tsm_invokeID_next();
+            /* not used with any peer */
+            if (TSM_Invoke_ID_Count[invokeID] == 0) {
+                index = tsm_client_alloc(invokeID);
+                TSM_Invoke_ID_Index[invokeID] = index + 1;
+                return invokeID;
             }
         }
     }
 
-    return invokeID;
+    return 0;
+}
+
+/** Gets the next invoke ID that is free for the peer, and reserves a
+ * spot in the table.  The invoke ID is only unique for this peer, so
+ * use the tsm_peer_ functions - or the functions that take the peer
+ * address - with it.
+ * @param dest [in] the BACNET_ADDRESS of the peer
+ * @return the invoke ID, or 0 if none are available
+ */
+uint8_t tsm_next_free_peer_invokeID(
+    BACNET_ADDRESS * dest)
+{
+    TSM_INDEX index = 0;
+    uint8_t invokeID = 0;
+    unsigned i = 0;
+
+    if (tsm_transaction_available()) {
+        for (i = 0; i < 255; i++) {
+            invokeID = tsm_invokeID_next();
+            if ((TSM_Invoke_ID_Index[invokeID] == 0) &&
+                (tsm_find_peer_index(dest, invokeID,
+                        false) == MAX_TSM_TRANSACTIONS)) {
+                index = tsm_client_alloc(invokeID);
+                tsm_peer_set(index, dest);
+                return invokeID;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/* finds the client transaction with the peer, or the transaction of
+   an invoke ID from tsm_next_free_invokeID() */
+static TSM_INDEX tsm_find_client_index(
+    BACNET_ADDRESS * peer,
+    uint8_t invokeID)
+{
+    TSM_INDEX index = MAX_TSM_TRANSACTIONS;
+
+    if (peer) {
+        index = tsm_find_peer_index(peer, invokeID, false);
+    }
+    if (index == MAX_TSM_TRANSACTIONS) {
+        index = tsm_find_invokeID_index(invokeID);
+    }
+
+    return index;
 }
 
 void tsm_set_confirmed_unsegmented_transaction(
@@ -203,23 +888,26 @@ void tsm_set_confirmed_unsegmented_transaction(
     uint16_t apdu_len)
 {
     uint16_t j = 0;
-    uint8_t index;
+    TSM_INDEX index;
 
     if (invokeID) {
-        index = tsm_find_invokeID_index(invokeID);
+        index = tsm_find_client_index(dest, invokeID);
         if (index < MAX_TSM_TRANSACTIONS) {
             /* SendConfirmedUnsegmented */
             TSM_List[index].state = TSM_STATE_AWAIT_CONFIRMATION;
             TSM_List[index].RetryCount = 0;
             /* start the timer */
-            TSM_List[index].RequestTimer = apdu_timeout();
+            tsm_timer_start(index, apdu_timeout());
             /* copy the data */
             for (j = 0; j < apdu_len; j++) {
                 TSM_List[index].apdu[j] = apdu[j];
             }
             TSM_List[index].apdu_len = apdu_len;
             npdu_copy_data(&TSM_List[index].npdu_data, ndpu_data);
-            bacnet_address_copy(&TSM_List[index].dest, dest);
+            tsm_peer_set(index, dest);
+#if BACNET_SEGMENTATION_ENABLED
+            tsm_segment_data_free(&TSM_List[index]);
+#endif
         }
     }
 
@@ -236,7 +924,7 @@ bool tsm_get_transaction_pdu(
     uint16_t * apdu_len)
 {
     uint16_t j = 0;
-    uint8_t index;
+    TSM_INDEX index;
     bool found = false;
 
     if (invokeID) {
@@ -263,35 +951,14 @@ bool tsm_get_transaction_pdu(
 void tsm_timer_milliseconds(
     uint16_t milliseconds)
 {
-    unsigned i = 0;     /* counter */
-
-    for (i = 0; i < MAX_TSM_TRANSACTIONS; i++) {
-        if (TSM_List[i].state == TSM_STATE_AWAIT_CONFIRMATION) {
-            if (TSM_List[i].RequestTimer > milliseconds)
-                TSM_List[i].RequestTimer -= milliseconds;
-            else
-                TSM_List[i].RequestTimer = 0;
-            /* AWAIT_CONFIRMATION */
-            if (TSM_List[i].RequestTimer == 0) {
-                if (TSM_List[i].RetryCount < apdu_retries()) {
-                    TSM_List[i].RequestTimer = apdu_timeout();
-                    TSM_List[i].RetryCount++;
-                    datalink_send_pdu(&TSM_List[i].dest,
-                        &TSM_List[i].npdu_data, &TSM_List[i].apdu[0],
-                        TSM_List[i].apdu_len);
-                } else {
-                    /* note: the invoke id has not been cleared yet
-                       and this indicates a failed message:
-                       IDLE and a valid invoke id */
-                    TSM_List[i].state = TSM_STATE_IDLE;
-                    if (TSM_List[i].InvokeID != 0) {
-                        if (Timeout_Function) {
-                            Timeout_Function(TSM_List[i].InvokeID);
-                        }
-                    }
-                }
-            }
+    while (milliseconds) {
+        if (TSM_Timer_Count == 0) {
+            /* nothing is running - no need to turn the wheel */
+            TSM_Clock += milliseconds;
+            break;
         }
+        tsm_timer_tick();
+        milliseconds--;
     }
 }
 
@@ -299,12 +966,29 @@ void tsm_timer_milliseconds(
 void tsm_free_invoke_id(
     uint8_t invokeID)
 {
-    uint8_t index;
+    TSM_INDEX index;
 
     index = tsm_find_invokeID_index(invokeID);
     if (index < MAX_TSM_TRANSACTIONS) {
-        TSM_List[index].state = TSM_STATE_IDLE;
-        TSM_List[index].InvokeID = 0;
+        tsm_entry_free(index);
+    }
+}
+
+/** Frees the transaction with the peer when its reply comes back.
+ * Falls back to the invoke ID from tsm_next_free_invokeID(), so that
+ * it can be used for any reply.
+ * @param src [in] the BACNET_ADDRESS of the peer
+ * @param invokeID [in] the invoke ID of the reply
+ */
+void tsm_free_peer_invoke_id(
+    BACNET_ADDRESS * src,
+    uint8_t invokeID)
+{
+    TSM_INDEX index;
+
+    index = tsm_find_client_index(src, invokeID);
+    if (index < MAX_TSM_TRANSACTIONS) {
+        tsm_entry_free(index);
     }
 }
 
@@ -316,7 +1000,7 @@ bool tsm_invoke_id_free(
     uint8_t invokeID)
 {
     bool status = true;
-    uint8_t index;
+    TSM_INDEX index;
 
     index = tsm_find_invokeID_index(invokeID);
     if (index < MAX_TSM_TRANSACTIONS)
@@ -335,7 +1019,7 @@ bool tsm_invoke_id_failed(
     uint8_t invokeID)
 {
     bool status = false;
-    uint8_t index;
+    TSM_INDEX index;
 
     index = tsm_find_invokeID_index(invokeID);
     if (index < MAX_TSM_TRANSACTIONS) {
@@ -348,6 +1032,433 @@ bool tsm_invoke_id_failed(
     return status;
 }
 
+/** Check if the invoke ID of a transaction with the peer is free.
+ * @param dest [in] the BACNET_ADDRESS of the peer
+ * @param invokeID [in] the invoke ID from tsm_next_free_peer_invokeID()
+ * @return True if it is free (done with), False if still pending in the TSM.
+ */
+bool tsm_peer_invoke_id_free(
+    BACNET_ADDRESS * dest,
+    uint8_t invokeID)
+{
+    return (tsm_find_peer_index(dest, invokeID,
+            false) == MAX_TSM_TRANSACTIONS);
+}
+
+/** See if a transaction with the peer failed to get a confirmation.
+ * @param dest [in] the BACNET_ADDRESS of the peer
+ * @param invokeID [in] the invoke ID from tsm_next_free_peer_invokeID()
+ * @return True if already failed, False if done or still waiting.
+ */
+bool tsm_peer_invoke_id_failed(
+    BACNET_ADDRESS * dest,
+    uint8_t invokeID)
+{
+    TSM_INDEX index;
+
+    index = tsm_find_peer_index(dest, invokeID, false);
+    if ((index < MAX_TSM_TRANSACTIONS) &&
+        (TSM_List[index].state == TSM_STATE_IDLE)) {
+        return true;
+    }
+
+    return false;
+}
+
+#if BACNET_SEGMENTATION_ENABLED
+/** Send the service data of a Confirmed-Request that does not fit into
+ * one APDU as a segmented request.
+ * @param invokeID [in] invoke ID from tsm_next_free_invokeID()
+ * @param dest [in] the BACNET_ADDRESS of the server
+ * @param ndpu_data [in] the network layer info for each segment
+ * @param service_choice [in] the BACNET_CONFIRMED_SERVICE
+ * @param max_apdu [in] the max-APDU-length-accepted of the server
+ * @param service_data [in] the encoded service request, without header
+ * @param service_data_len [in] number of octets of service data
+ * @return true if the transaction was started
+ */
+bool tsm_set_confirmed_segmented_transaction(
+    uint8_t invokeID,
+    BACNET_ADDRESS * dest,
+    BACNET_NPDU_DATA * ndpu_data,
+    uint8_t service_choice,
+    uint16_t max_apdu,
+    uint8_t * service_data,
+    uint32_t service_data_len)
+{
+    BACNET_TSM_DATA *tsm = NULL;
+    uint8_t *buffer = NULL;
+    TSM_INDEX index;
+
+    if ((invokeID == 0) || (service_data_len == 0)) {
+        return false;
+    }
+    index = tsm_find_client_index(dest, invokeID);
+    if (index >= MAX_TSM_TRANSACTIONS) {
+        return false;
+    }
+    if (max_apdu > MAX_APDU) {
+        max_apdu = MAX_APDU;
+    }
+    buffer = malloc(service_data_len);
+    if (!buffer) {
+        return false;
+    }
+    memcpy(buffer, service_data, service_data_len);
+    tsm = &TSM_List[index];
+    tsm_segment_data_free(tsm);
+    tsm->segment_data = buffer;
+    tsm->segment_data_len = service_data_len;
+    tsm->segment_data_size = service_data_len;
+    /* a segmented request header is 6 octets */
+    tsm->segment_size = max_apdu - 6;
+    tsm->service_choice = service_choice;
+    tsm->max_segs_max_apdu =
+        encode_max_segs_max_apdu(MAX_SEGMENTS_ACCEPTED, MAX_APDU);
+    tsm->apdu_len = 0;
+    tsm->RetryCount = 0;
+    npdu_copy_data(&tsm->npdu_data, ndpu_data);
+    tsm_peer_set(index, dest);
+    tsm->state = TSM_STATE_SEGMENTED_REQUEST;
+    tsm_segmented_send_start(tsm);
+
+    return true;
+}
+
+/** Send an encoded Complex-ACK that is larger than the max-APDU of the
+ * client as a segmented response, if the client accepts one.
+ * @param dest [in] the BACNET_ADDRESS of the client
+ * @param ndpu_data [in] the network layer info for each segment
+ * @param service_data [in] the header data of the client request
+ * @param apdu [in] the unsegmented Complex-ACK APDU
+ * @param apdu_len [in] the length of the Complex-ACK APDU
+ * @return true if the segmented response was started, false if
+ *  the client doesn't accept segments or that many segments.
+ */
+bool tsm_set_segmented_complex_ack_transaction(
+    BACNET_ADDRESS * dest,
+    BACNET_NPDU_DATA * ndpu_data,
+    BACNET_CONFIRMED_SERVICE_DATA * service_data,
+    uint8_t * apdu,
+    uint32_t apdu_len)
+{
+    BACNET_TSM_DATA *tsm = NULL;
+    uint8_t *buffer = NULL;
+    uint32_t max_apdu = 0;
+    uint32_t segment_size = 0;
+    uint32_t segments = 0;
+    TSM_INDEX index;
+
+    /* the unsegmented Complex-ACK header is 3 octets */
+    if ((!service_data->segmented_response_accepted) || (apdu_len <= 3)) {
+        return false;
+    }
+    max_apdu = service_data->max_resp;
+    if (max_apdu > MAX_APDU) {
+        max_apdu = MAX_APDU;
+    }
+    /* a segmented Complex-ACK header is 5 octets */
+    segment_size = max_apdu - 5;
+    apdu_len -= 3;
+    segments = (apdu_len + segment_size - 1) / segment_size;
+    /* zero is an unspecified number of segments, and
+       65 is more than 64 segments accepted */
+    if ((service_data->max_segs > 0) && (service_data->max_segs <= 64) &&
+        (segments > (uint32_t) service_data->max_segs)) {
+        return false;
+    }
+    index = tsm_find_peer_index(dest, service_data->invoke_id, true);
+    if (index < MAX_TSM_TRANSACTIONS) {
+        if (TSM_List[index].state == TSM_STATE_SEGMENTED_RESPONSE) {
+            /* a duplicate request - we are already responding */
+            return true;
+        }
+    } else {
+        index = tsm_entry_alloc();
+        if (index >= MAX_TSM_TRANSACTIONS) {
+            return false;
+        }
+        TSM_List[index].server = true;
+        TSM_List[index].InvokeID = service_data->invoke_id;
+        tsm_peer_set(index, dest);
+    }
+    buffer = malloc(apdu_len);
+    if (!buffer) {
+        if (TSM_List[index].state == TSM_STATE_IDLE) {
+            tsm_entry_free(index);
+        }
+        return false;
+    }
+    memcpy(buffer, &apdu[3], apdu_len);
+    tsm = &TSM_List[index];
+    tsm_segment_data_free(tsm);
+    tsm->segment_data = buffer;
+    tsm->segment_data_len = apdu_len;
+    tsm->segment_data_size = apdu_len;
+    tsm->segment_size = (uint16_t) segment_size;
+    tsm->service_choice = apdu[2];
+    tsm->RetryCount = 0;
+    npdu_copy_data(&tsm->npdu_data, ndpu_data);
+    tsm->state = TSM_STATE_SEGMENTED_RESPONSE;
+    tsm_segmented_send_start(tsm);
+
+    return true;
+}
+
+/** The largest Complex-ACK that the client takes as a segmented response,
+ * so that a server can trim a response to it instead of aborting.
+ * @param service_data [in] the header data of the client request
+ * @return the length of the largest unsegmented Complex-ACK APDU,
+ *  including its 3 octet header, that fits in the client segments,
+ *  and no more than MAX_SEGMENTED_APDU.
+ */
+uint32_t tsm_segmented_complex_ack_max_len(
+    BACNET_CONFIRMED_SERVICE_DATA * service_data)
+{
+    uint32_t max_apdu = 0;
+    uint32_t max_len = MAX_SEGMENTED_APDU;
+
+    max_apdu = service_data->max_resp;
+    if (max_apdu > MAX_APDU) {
+        max_apdu = MAX_APDU;
+    }
+    if (!service_data->segmented_response_accepted) {
+        return max_apdu;
+    }
+    /* a segmented Complex-ACK header is 5 octets, and zero or 65 is an
+       unspecified number of segments */
+    if ((service_data->max_segs > 0) && (service_data->max_segs <= 64) &&
+        (max_apdu > 5)) {
+        max_len = 3 + ((uint32_t) service_data->max_segs * (max_apdu - 5));
+        if (max_len > MAX_SEGMENTED_APDU) {
+            max_len = MAX_SEGMENTED_APDU;
+        }
+    }
+
+    return max_len;
+}
+
+/** Reassemble the segments of a Confirmed-Request we receive as a server.
+ * @param src [in] the BACNET_ADDRESS of the client
+ * @param service_data [in] the decoded header of the segment
+ * @param service_choice [in] the service choice of the segment
+ * @param service_request [in] the service data of the segment
+ * @param service_request_len [in] number of octets of service data
+ * @param data [out] the reassembled service request, to be free()d
+ * @param data_len [out] the length of the reassembled service request
+ * @return true when the final segment has been received
+ */
+bool tsm_segmented_request_received(
+    BACNET_ADDRESS * src,
+    BACNET_CONFIRMED_SERVICE_DATA * service_data,
+    uint8_t service_choice,
+    uint8_t * service_request,
+    uint16_t service_request_len,
+    uint8_t ** data,
+    uint32_t * data_len)
+{
+    BACNET_TSM_DATA *tsm = NULL;
+    TSM_INDEX index;
+    uint8_t abort_reason = ABORT_REASON_OTHER;
+    bool complete = false;
+    /* the confirmed service handlers take a 16-bit length */
+    uint32_t max_len = MAX_SEGMENTED_APDU;
+
+    if (max_len > UINT16_MAX) {
+        max_len = UINT16_MAX;
+    }
+    index = tsm_find_peer_index(src, service_data->invoke_id, true);
+    if (index >= MAX_TSM_TRANSACTIONS) {
+        if (service_data->sequence_number != 0) {
+            /* not a transaction of ours */
+            return false;
+        }
+        index = tsm_entry_alloc();
+        if (index >= MAX_TSM_TRANSACTIONS) {
+            tsm_send_abort(src, service_data->invoke_id,
+                ABORT_REASON_PREEMPTED_BY_HIGHER_PRIORITY_TASK, true);
+            return false;
+        }
+        tsm = &TSM_List[index];
+        tsm->server = true;
+        tsm->InvokeID = service_data->invoke_id;
+        tsm->service_choice = service_choice;
+        npdu_encode_npdu_data(&tsm->npdu_data, false,
+            MESSAGE_PRIORITY_NORMAL);
+        tsm_peer_set(index, src);
+        tsm->state = TSM_STATE_SEGMENTED_REQUEST;
+    } else {
+        tsm = &TSM_List[index];
+        if (tsm->state != TSM_STATE_SEGMENTED_REQUEST) {
+            /* we are already responding to this request */
+            return false;
+        }
+    }
+    if (!tsm_segment_receive(tsm, service_data->sequence_number,
+            service_data->proposed_window_number, service_data->more_follows,
+            service_request, service_request_len, max_len, &complete,
+            &abort_reason)) {
+        tsm_send_abort(src, tsm->InvokeID, abort_reason, true);
+        tsm_entry_free(index);
+        return false;
+    }
+    if (complete) {
+        *data = tsm->segment_data;
+        *data_len = tsm->segment_data_len;
+        tsm->segment_data = NULL;
+        tsm_entry_free(index);
+    }
+
+    return complete;
+}
+
+/** Reassemble the segments of a Complex-ACK we receive as a client.
+ * @param src [in] the BACNET_ADDRESS of the server
+ * @param service_data [in] the decoded header of the segment
+ * @param service_choice [in] the service choice of the segment
+ * @param service_request [in] the service data of the segment
+ * @param service_request_len [in] number of octets of service data
+ * @param data [out] the reassembled service ack data, to be free()d
+ * @param data_len [out] the length of the reassembled service ack data
+ * @return true when the final segment has been received
+ */
+bool tsm_segmented_complex_ack_received(
+    BACNET_ADDRESS * src,
+    BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data,
+    uint8_t service_choice,
+    uint8_t * service_request,
+    uint16_t service_request_len,
+    uint8_t ** data,
+    uint32_t * data_len)
+{
+    BACNET_TSM_DATA *tsm = NULL;
+    TSM_INDEX index;
+    uint8_t abort_reason = ABORT_REASON_OTHER;
+    bool complete = false;
+
+    index = tsm_find_peer_index(src, service_data->invoke_id, false);
+    if (index >= MAX_TSM_TRANSACTIONS) {
+        return false;
+    }
+    tsm = &TSM_List[index];
+    if (tsm->state == TSM_STATE_AWAIT_CONFIRMATION) {
+        if (service_data->sequence_number != 0) {
+            return false;
+        }
+        /* done with any segmented request we sent */
+        tsm_segment_data_free(tsm);
+        tsm->service_choice = service_choice;
+        tsm->state = TSM_STATE_SEGMENTED_CONFIRMATION;
+    } else if (tsm->state != TSM_STATE_SEGMENTED_CONFIRMATION) {
+        return false;
+    }
+    if (!tsm_segment_receive(tsm, service_data->sequence_number,
+            service_data->proposed_window_number, service_data->more_follows,
+            service_request, service_request_len, MAX_SEGMENTED_APDU,
+            &complete, &abort_reason)) {
+        tsm_send_abort(src, tsm->InvokeID, abort_reason, false);
+        /* IDLE with a valid invoke id indicates a failed message */
+        tsm_segment_data_free(tsm);
+        tsm->state = TSM_STATE_IDLE;
+        return false;
+    }
+    if (complete) {
+        *data = tsm->segment_data;
+        *data_len = tsm->segment_data_len;
+        tsm->segment_data = NULL;
+        tsm_segment_data_free(tsm);
+    }
+
+    return complete;
+}
+
+/** Process a SegmentACK PDU for a segmented message we are sending.
+ * @param src [in] the BACNET_ADDRESS of the peer
+ * @param apdu [in] the SegmentACK APDU
+ * @param apdu_len [in] the length of the APDU
+ */
+void tsm_segment_ack_received(
+    BACNET_ADDRESS * src,
+    uint8_t * apdu,
+    uint16_t apdu_len)
+{
+    BACNET_TSM_DATA *tsm = NULL;
+    TSM_INDEX index;
+    uint8_t invokeID;
+    uint8_t sequence_number;
+    uint8_t window_size;
+    uint8_t offset;
+    uint32_t acked;
+
+    if (apdu_len < 4) {
+        return;
+    }
+    invokeID = apdu[1];
+    sequence_number = apdu[2];
+    window_size = apdu[3];
+    if (apdu[0] & BIT(0)) {
+        /* sent by a server - acknowledges our segmented request */
+        index = tsm_find_peer_index(src, invokeID, false);
+        if ((index >= MAX_TSM_TRANSACTIONS) ||
+            (TSM_List[index].state != TSM_STATE_SEGMENTED_REQUEST)) {
+            return;
+        }
+    } else {
+        index = tsm_find_peer_index(src, invokeID, true);
+        if ((index >= MAX_TSM_TRANSACTIONS) ||
+            (TSM_List[index].state != TSM_STATE_SEGMENTED_RESPONSE)) {
+            return;
+        }
+    }
+    tsm = &TSM_List[index];
+    offset = (uint8_t) (sequence_number - tsm->InitialSequenceNumber);
+    if (offset >= tsm->ActualWindowSize) {
+        /* DuplicateACK, or a NAK we already resent for */
+        tsm_timer_start(index, apdu_segment_timeout());
+        return;
+    }
+    acked = tsm->segment_index + offset;
+    if ((acked + 1) >= tsm_segment_count(tsm)) {
+        /* FinalSegmentACK */
+        if (tsm->server) {
+            tsm_entry_free(index);
+        } else {
+            tsm->state = TSM_STATE_AWAIT_CONFIRMATION;
+            tsm_timer_start(index, apdu_timeout());
+        }
+        return;
+    }
+    /* NewACK, or a NAK asking to resend what followed - both
+       continue with the segment after the acknowledged one */
+    if (window_size == 0) {
+        window_size = 1;
+    } else if (window_size > 127) {
+        window_size = 127;
+    }
+    tsm->ActualWindowSize = window_size;
+    tsm->segment_index = acked + 1;
+    tsm->InitialSequenceNumber = (uint8_t) tsm->segment_index;
+    tsm->SegmentRetryCount = 0;
+    tsm_send_window(tsm);
+}
+
+/** A client aborted the transaction we were serving.
+ * @param src [in] the BACNET_ADDRESS of the client
+ * @param invokeID [in] the invoke ID of the client
+ */
+void tsm_free_server_transaction(
+    BACNET_ADDRESS * src,
+    uint8_t invokeID)
+{
+    TSM_INDEX index;
+
+    index = tsm_find_peer_index(src, invokeID, true);
+    if (index < MAX_TSM_TRANSACTIONS) {
+        tsm_entry_free(index);
+    }
+}
+#endif
+
 
 #ifdef TEST
 #include <assert.h>
@@ -357,21 +1468,334 @@ bool tsm_invoke_id_failed(
 /* flag to send an I-Am */
 bool I_Am_Request = true;
 
-/* dummy function stubs */
+/* loopback datalink: every PDU sent is handed back to the APDU handler,
+   so this one TSM is both the client and the server in the tests */
+#define LOOPBACK_PDU_MAX 64
+static uint8_t Loopback_PDU[LOOPBACK_PDU_MAX][MAX_PDU];
+static unsigned Loopback_PDU_Len[LOOPBACK_PDU_MAX];
+static BACNET_ADDRESS Loopback_Dest[LOOPBACK_PDU_MAX];
+static unsigned Loopback_Head;
+static unsigned Loopback_Tail;
+/* statistics and lossy link simulation */
+static unsigned Loopback_Sent;
+static unsigned Loopback_Segment_Acks;
+static unsigned Loopback_Drop_Modulo;
+
 int datalink_send_pdu(
     BACNET_ADDRESS * dest,
     BACNET_NPDU_DATA * npdu_data,
     uint8_t * pdu,
     unsigned pdu_len)
 {
-    (void) dest;
+    BACNET_ADDRESS npdu_dest, npdu_src;
+    BACNET_NPDU_DATA data;
+    int offset = 0;
+    unsigned next = (Loopback_Head + 1) % LOOPBACK_PDU_MAX;
+
     (void) npdu_data;
-    (void) pdu;
-    (void) pdu_len;
+    Loopback_Sent++;
+    offset = npdu_decode(pdu, &npdu_dest, &npdu_src, &data);
+    if ((offset > 0) && ((pdu[offset] & 0xF0) == PDU_TYPE_SEGMENT_ACK)) {
+        Loopback_Segment_Acks++;
+    }
+    if (Loopback_Drop_Modulo && ((Loopback_Sent % Loopback_Drop_Modulo) == 0)) {
+        return (int) pdu_len;
+    }
+    assert(next != Loopback_Tail);
+    assert(pdu_len <= MAX_PDU);
+    memcpy(&Loopback_PDU[Loopback_Head][0], pdu, pdu_len);
+    Loopback_PDU_Len[Loopback_Head] = pdu_len;
+    bacnet_address_copy(&Loopback_Dest[Loopback_Head], dest);
+    Loopback_Head = next;
 
-    return 0;
+    return (int) pdu_len;
+}
+
+void datalink_get_my_address(
+    BACNET_ADDRESS * my_address)
+{
+    memset(my_address, 0, sizeof(BACNET_ADDRESS));
+    my_address->mac_len = 1;
+    my_address->mac[0] = 0x01;
+}
+
+/* deliver the queued PDUs until the link is quiet */
+static void loopback_pump(
+    void)
+{
+    static uint8_t pdu[MAX_PDU];
+    BACNET_ADDRESS src, npdu_dest, npdu_src;
+    BACNET_NPDU_DATA npdu_data;
+    unsigned pdu_len = 0;
+    int offset = 0;
+
+    while (Loopback_Head != Loopback_Tail) {
+        pdu_len = Loopback_PDU_Len[Loopback_Tail];
+        memcpy(pdu, &Loopback_PDU[Loopback_Tail][0], pdu_len);
+        /* loopback: the message comes from where it was sent */
+        bacnet_address_copy(&src, &Loopback_Dest[Loopback_Tail]);
+        Loopback_Tail = (Loopback_Tail + 1) % LOOPBACK_PDU_MAX;
+        offset = npdu_decode(pdu, &npdu_dest, &npdu_src, &npdu_data);
+        if ((offset > 0) && (!npdu_data.network_layer_message)) {
+            apdu_handler(&src, &pdu[offset], (uint16_t) (pdu_len - offset));
+        }
+    }
+}
+
+static void loopback_reset(
+    void)
+{
+    Loopback_Head = 0;
+    Loopback_Tail = 0;
+    Loopback_Sent = 0;
+    Loopback_Segment_Acks = 0;
+    Loopback_Drop_Modulo = 0;
+}
+
+#if BACNET_SEGMENTATION_ENABLED
+#include "rpm.h"
+
+/* the large ReadPropertyMultiple-ACK that the server sends */
+static uint8_t Test_Ack_APDU[MAX_SEGMENTED_APDU];
+static uint32_t Test_Ack_APDU_Len;
+static bool Test_Ack_Status;
+static bool Test_Ack_Received;
+static bool Test_Ack_Match;
+static uint32_t Test_Ack_First_Instance;
+/* the large request that the client sends */
+static uint8_t Test_Request[UINT16_MAX];
+static uint32_t Test_Request_Len;
+static bool Test_Request_Match;
+
+static void testRPMAckEncode(
+    unsigned objects)
+{
+    BACNET_RPM_DATA rpmdata;
+    uint8_t value[8];
+    uint32_t apdu_len = 0;
+    int len = 0;
+    unsigned i = 0;
+
+    apdu_len = rpm_ack_encode_apdu_init(&Test_Ack_APDU[0], 0);
+    for (i = 0; i < objects; i++) {
+        rpmdata.object_type = OBJECT_ANALOG_INPUT;
+        rpmdata.object_instance = i;
+        apdu_len +=
+            rpm_ack_encode_apdu_object_begin(&Test_Ack_APDU[apdu_len],
+            &rpmdata);
+        apdu_len +=
+            rpm_ack_encode_apdu_object_property(&Test_Ack_APDU[apdu_len],
+            PROP_PRESENT_VALUE, BACNET_ARRAY_ALL);
+        len = encode_application_real(&value[0], (float) i);
+        apdu_len +=
+            rpm_ack_encode_apdu_object_property_value(&Test_Ack_APDU
+            [apdu_len], &value[0], len);
+        apdu_len += rpm_ack_encode_apdu_object_end(&Test_Ack_APDU[apdu_len]);
+    }
+    Test_Ack_APDU_Len = apdu_len;
+}
+
+static void testReadPropertyMultipleHandler(
+    uint8_t * service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS * src,
+    BACNET_CONFIRMED_SERVICE_DATA * service_data)
+{
+    BACNET_NPDU_DATA npdu_data;
+
+    (void) service_request;
+    (void) service_len;
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    Test_Ack_APDU[1] = service_data->invoke_id;
+    Test_Ack_Status =
+        tsm_set_segmented_complex_ack_transaction(src, &npdu_data,
+        service_data, &Test_Ack_APDU[0], Test_Ack_APDU_Len);
+}
+
+static void testReadPropertyMultipleAckHandler(
+    uint8_t * service_request,
+    uint32_t service_len,
+    BACNET_ADDRESS * src,
+    BACNET_CONFIRMED_SERVICE_ACK_DATA * service_data)
+{
+    BACNET_OBJECT_TYPE object_type = MAX_BACNET_OBJECT_TYPE;
+
+    (void) src;
+    (void) service_data;
+    Test_Ack_Received = true;
+    Test_Ack_Match = (service_len == (Test_Ack_APDU_Len - 3)) &&
+        (memcmp(service_request, &Test_Ack_APDU[3], service_len) == 0);
+    rpm_ack_decode_object_id(service_request, service_len, &object_type,
+        &Test_Ack_First_Instance);
+}
+
+static void testWritePropertyMultipleHandler(
+    uint8_t * service_request,
+    uint16_t service_len,
+    BACNET_ADDRESS * src,
+    BACNET_CONFIRMED_SERVICE_DATA * service_data)
+{
+    BACNET_ADDRESS my_address;
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t pdu[MAX_PDU];
+    int pdu_len = 0;
+
+    Test_Request_Match = (service_len == Test_Request_Len) &&
+        (memcmp(service_request, &Test_Request[0], service_len) == 0);
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, false, MESSAGE_PRIORITY_NORMAL);
+    pdu_len = npdu_encode_pdu(&pdu[0], src, &my_address, &npdu_data);
+    pdu[pdu_len++] = PDU_TYPE_SIMPLE_ACK;
+    pdu[pdu_len++] = service_data->invoke_id;
+    pdu[pdu_len++] = SERVICE_CONFIRMED_WRITE_PROP_MULTIPLE;
+    datalink_send_pdu(src, &npdu_data, &pdu[0], pdu_len);
+}
+
+static uint8_t testSendReadPropertyMultiple(
+    void)
+{
+    BACNET_ADDRESS my_address;
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t pdu[MAX_PDU];
+    uint8_t invoke_id = 0;
+    int pdu_len = 0;
+
+    invoke_id = tsm_next_free_invokeID();
+    if (invoke_id) {
+        /* loopback: send to ourself */
+        datalink_get_my_address(&my_address);
+        npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+        pdu_len = npdu_encode_pdu(&pdu[0], &my_address, &my_address,
+            &npdu_data);
+        pdu_len += rpm_encode_apdu_init(&pdu[pdu_len], invoke_id);
+        pdu_len +=
+            rpm_encode_apdu_object_begin(&pdu[pdu_len], OBJECT_DEVICE,
+            BACNET_MAX_INSTANCE);
+        pdu_len +=
+            rpm_encode_apdu_object_property(&pdu[pdu_len], PROP_ALL,
+            BACNET_ARRAY_ALL);
+        pdu_len += rpm_encode_apdu_object_end(&pdu[pdu_len]);
+        tsm_set_confirmed_unsegmented_transaction(invoke_id, &my_address,
+            &npdu_data, &pdu[0], (uint16_t) pdu_len);
+        datalink_send_pdu(&my_address, &npdu_data, &pdu[0], pdu_len);
+    }
+
+    return invoke_id;
+}
+
+/* run the timers until the transaction is complete or gives up */
+static void testTSMRun(
+    void)
+{
+    unsigned i = 0;
+
+    loopback_pump();
+    for (i = 0; i < 1000; i++) {
+        if (tsm_transaction_idle_count() == MAX_TSM_TRANSACTIONS) {
+            break;
+        }
+        tsm_timer_milliseconds(apdu_segment_timeout());
+        loopback_pump();
+    }
+}
+
+static void testTSMSegmentedResponse(
+    Test * pTest)
+{
+    uint8_t invoke_id = 0;
+    unsigned segments = 0;
+    BACNET_CONFIRMED_SERVICE_DATA service_data;
+
+    loopback_reset();
+    apdu_set_confirmed_handler(SERVICE_CONFIRMED_READ_PROP_MULTIPLE,
+        testReadPropertyMultipleHandler);
+    apdu_set_confirmed_ack_handler(SERVICE_CONFIRMED_READ_PROP_MULTIPLE,
+        testReadPropertyMultipleAckHandler);
+    /* a few hundred KB - the sequence numbers wrap several times */
+    testRPMAckEncode(20000);
+    ct_test(pTest, Test_Ack_APDU_Len > 300000);
+    segments = (Test_Ack_APDU_Len - 3) / (MAX_APDU - 5);
+    ct_test(pTest, segments > 512);
+    Test_Ack_Status = false;
+    Test_Ack_Received = false;
+    Test_Ack_Match = false;
+    Test_Ack_First_Instance = BACNET_MAX_INSTANCE;
+    invoke_id = testSendReadPropertyMultiple();
+    ct_test(pTest, invoke_id != 0);
+    testTSMRun();
+    ct_test(pTest, Test_Ack_Status);
+    ct_test(pTest, Test_Ack_Received);
+    ct_test(pTest, Test_Ack_Match);
+    ct_test(pTest, Test_Ack_First_Instance == 0);
+    ct_test(pTest, tsm_invoke_id_free(invoke_id));
+    ct_test(pTest, tsm_transaction_idle_count() == MAX_TSM_TRANSACTIONS);
+    /* the window was negotiated up, so far fewer acks than segments */
+    ct_test(pTest, Loopback_Segment_Acks > 0);
+    ct_test(pTest, Loopback_Segment_Acks < (segments / 8));
+
+    /* the same transfer over a lossy link */
+    loopback_reset();
+    Loopback_Drop_Modulo = 97;
+    Test_Ack_Status = false;
+    Test_Ack_Received = false;
+    Test_Ack_Match = false;
+    invoke_id = testSendReadPropertyMultiple();
+    ct_test(pTest, invoke_id != 0);
+    testTSMRun();
+    ct_test(pTest, Test_Ack_Status);
+    ct_test(pTest, Test_Ack_Received);
+    ct_test(pTest, Test_Ack_Match);
+    ct_test(pTest, tsm_invoke_id_free(invoke_id));
+    ct_test(pTest, tsm_transaction_idle_count() == MAX_TSM_TRANSACTIONS);
+
+    /* the largest response that fits the segments of a client */
+    memset(&service_data, 0, sizeof(service_data));
+    service_data.max_resp = 206;
+    service_data.max_segs = 4;
+    ct_test(pTest, tsm_segmented_complex_ack_max_len(&service_data) == 206);
+    service_data.segmented_response_accepted = true;
+    ct_test(pTest,
+        tsm_segmented_complex_ack_max_len(&service_data) == 3 + (4 * 201));
+    service_data.max_segs = 0;
+    ct_test(pTest,
+        tsm_segmented_complex_ack_max_len(&service_data) ==
+        MAX_SEGMENTED_APDU);
 }
 
+static void testTSMSegmentedRequest(
+    Test * pTest)
+{
+    BACNET_ADDRESS my_address;
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t invoke_id = 0;
+    uint32_t i = 0;
+    bool status = false;
+
+    loopback_reset();
+    apdu_set_confirmed_handler(SERVICE_CONFIRMED_WRITE_PROP_MULTIPLE,
+        testWritePropertyMultipleHandler);
+    Test_Request_Len = 40000;
+    for (i = 0; i < Test_Request_Len; i++) {
+        Test_Request[i] = (uint8_t) (i * 7);
+    }
+    Test_Request_Match = false;
+    datalink_get_my_address(&my_address);
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+    invoke_id = tsm_next_free_invokeID();
+    ct_test(pTest, invoke_id != 0);
+    status =
+        tsm_set_confirmed_segmented_transaction(invoke_id, &my_address,
+        &npdu_data, SERVICE_CONFIRMED_WRITE_PROP_MULTIPLE, MAX_APDU,
+        &Test_Request[0], Test_Request_Len);
+    ct_test(pTest, status);
+    testTSMRun();
+    ct_test(pTest, Test_Request_Match);
+    ct_test(pTest, tsm_invoke_id_free(invoke_id));
+    ct_test(pTest, tsm_transaction_idle_count() == MAX_TSM_TRANSACTIONS);
+    ct_test(pTest, Loopback_Segment_Acks < (Test_Request_Len / MAX_APDU));
+}
+#endif
+
 /* dummy function stubs */
 void datalink_get_broadcast_address(
     BACNET_ADDRESS * dest)
@@ -379,12 +1803,155 @@ void datalink_get_broadcast_address(
     (void) dest;
 }
 
+static unsigned Test_Timeout_Count;
+
+static void testTimeoutHandler(
+    BACNET_ADDRESS * dest,
+    uint8_t invoke_id)
+{
+    (void) dest;
+    (void) invoke_id;
+    Test_Timeout_Count++;
+}
+
+static void testPeerAddress(
+    BACNET_ADDRESS * dest,
+    uint8_t mac)
+{
+    memset(dest, 0, sizeof(BACNET_ADDRESS));
+    dest->mac_len = 1;
+    dest->mac[0] = mac;
+}
+
+/* sends a request that is never answered */
+static void testSendRequest(
+    uint8_t invoke_id,
+    BACNET_ADDRESS * dest)
+{
+    BACNET_NPDU_DATA npdu_data;
+    uint8_t apdu[4] = { PDU_TYPE_CONFIRMED_SERVICE_REQUEST, 0, 0,
+        SERVICE_CONFIRMED_READ_PROPERTY
+    };
+
+    npdu_encode_npdu_data(&npdu_data, true, MESSAGE_PRIORITY_NORMAL);
+    apdu[2] = invoke_id;
+    tsm_set_confirmed_unsegmented_transaction(invoke_id, dest, &npdu_data,
+        &apdu[0], sizeof(apdu));
+}
+
 void testTSM(
     Test * pTest)
 {
-    /* FIXME: add some unit testing... */
-    return;
+    BACNET_ADDRESS dest;
+    uint8_t invoke_id = 0;
+    uint32_t timeout = 0;
+    unsigned i = 0;
+
+    loopback_reset();
+    Loopback_Drop_Modulo = 1;
+    Test_Timeout_Count = 0;
+    tsm_set_peer_timeout_handler(testTimeoutHandler);
+    testPeerAddress(&dest, 1);
+    invoke_id = tsm_next_free_invokeID();
+    ct_test(pTest, invoke_id != 0);
+    ct_test(pTest, !tsm_invoke_id_free(invoke_id));
+    testSendRequest(invoke_id, &dest);
+    ct_test(pTest, !tsm_invoke_id_failed(invoke_id));
+    /* the request is retried until the last timeout, to the millisecond */
+    timeout = (uint32_t) apdu_timeout() * (apdu_retries() + 1);
+    for (i = 0; i < (timeout - 1); i++) {
+        tsm_timer_milliseconds(1);
+    }
+    ct_test(pTest, Loopback_Sent == apdu_retries());
+    ct_test(pTest, !tsm_invoke_id_failed(invoke_id));
+    ct_test(pTest, Test_Timeout_Count == 0);
+    tsm_timer_milliseconds(1);
+    ct_test(pTest, tsm_invoke_id_failed(invoke_id));
+    ct_test(pTest, Test_Timeout_Count == 1);
+    tsm_free_invoke_id(invoke_id);
+    ct_test(pTest, tsm_invoke_id_free(invoke_id));
+    ct_test(pTest, tsm_transaction_idle_count() == MAX_TSM_TRANSACTIONS);
+
+    /* large steps of the timer give the same result */
+    loopback_reset();
+    Loopback_Drop_Modulo = 1;
+    invoke_id = tsm_next_free_invokeID();
+    testSendRequest(invoke_id, &dest);
+    tsm_timer_milliseconds(apdu_timeout() - 1);
+    ct_test(pTest, Loopback_Sent == 0);
+    tsm_timer_milliseconds(1);
+    ct_test(pTest, Loopback_Sent == 1);
+    for (i = 0; i < apdu_retries(); i++) {
+        tsm_timer_milliseconds(apdu_timeout());
+    }
+    ct_test(pTest, tsm_invoke_id_failed(invoke_id));
+    ct_test(pTest, Test_Timeout_Count == 2);
+    /* a reply from the peer frees it */
+    tsm_free_peer_invoke_id(&dest, invoke_id);
+    ct_test(pTest, tsm_invoke_id_free(invoke_id));
+    tsm_set_peer_timeout_handler(NULL);
+}
+
+#if (MAX_TSM_TRANSACTIONS > 510)
+/* more than 255 requests in flight with invoke IDs for each peer */
+static void testTSMPeerInvokeID(
+    Test * pTest)
+{
+    BACNET_ADDRESS dest[2];
+    uint8_t invoke_id[2][255];
+    uint8_t id = 0;
+    unsigned i = 0;
+    unsigned d = 0;
+
+    loopback_reset();
+    Loopback_Drop_Modulo = 1;
+    testPeerAddress(&dest[0], 1);
+    testPeerAddress(&dest[1], 2);
+    for (d = 0; d < 2; d++) {
+        for (i = 0; i < 255; i++) {
+            invoke_id[d][i] = tsm_next_free_peer_invokeID(&dest[d]);
+            ct_test(pTest, invoke_id[d][i] != 0);
+            testSendRequest(invoke_id[d][i], &dest[d]);
+        }
+        /* every invoke ID of the peer is in use */
+        ct_test(pTest, tsm_next_free_peer_invokeID(&dest[d]) == 0);
+    }
+    ct_test(pTest, tsm_transaction_idle_count() ==
+        (MAX_TSM_TRANSACTIONS - 510));
+    for (i = 0; i < 255; i++) {
+        ct_test(pTest, !tsm_peer_invoke_id_free(&dest[1], invoke_id[1][i]));
+    }
+    /* and so are the global ones */
+    ct_test(pTest, tsm_next_free_invokeID() == 0);
+    /* a reply frees the invoke ID of that peer only */
+    id = invoke_id[0][100];
+    tsm_free_peer_invoke_id(&dest[0], id);
+    ct_test(pTest, tsm_peer_invoke_id_free(&dest[0], id));
+    ct_test(pTest, !tsm_peer_invoke_id_free(&dest[1], id));
+    ct_test(pTest, tsm_next_free_peer_invokeID(&dest[1]) == 0);
+    ct_test(pTest, tsm_next_free_peer_invokeID(&dest[0]) == id);
+    ct_test(pTest, tsm_next_free_peer_invokeID(&dest[0]) == 0);
+    testSendRequest(id, &dest[0]);
+    /* all of them time out */
+    for (i = 0; i <= apdu_retries(); i++) {
+        tsm_timer_milliseconds(apdu_timeout());
+    }
+    ct_test(pTest, tsm_peer_invoke_id_failed(&dest[1], invoke_id[1][0]));
+    ct_test(pTest, tsm_peer_invoke_id_failed(&dest[0], id));
+    ct_test(pTest, Loopback_Sent == (510 * apdu_retries()));
+    for (d = 0; d < 2; d++) {
+        for (i = 0; i < 255; i++) {
+            tsm_free_peer_invoke_id(&dest[d], invoke_id[d][i]);
+        }
+    }
+    ct_test(pTest, tsm_transaction_idle_count() == MAX_TSM_TRANSACTIONS);
+    /* the global invoke IDs are free again */
+    id = tsm_next_free_invokeID();
+    ct_test(pTest, id != 0);
+    tsm_free_invoke_id(id);
+    ct_test(pTest, tsm_transaction_idle_count() == MAX_TSM_TRANSACTIONS);
 }
+#endif
 
 #ifdef TEST_TSM
 int main(
@@ -397,6 +1964,16 @@ int main(
     /* individual tests */
     rc = ct_addTestFunction(pTest, testTSM);
     assert(rc);
+#if (MAX_TSM_TRANSACTIONS > 510)
+    rc = ct_addTestFunction(pTest, testTSMPeerInvokeID);
+    assert(rc);
+#endif
+#if BACNET_SEGMENTATION_ENABLED
+    rc = ct_addTestFunction(pTest, testTSMSegmentedRequest);
+    assert(rc);
+    rc = ct_addTestFunction(pTest, testTSMSegmentedResponse);
+    assert(rc);
+#endif
 
     ct_setStream(pTest, stdout);
     ct_run(pTest);
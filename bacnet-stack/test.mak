@@ -9,11 +9,15 @@
 
 LOGFILE = test.log
 
-all: abort address arf awf bvlc6 bacapp bacdcode bacerror bacint bacstr \
-	cov crc datetime dcc event filename fifo getevent iam ihave \
-	indtext keylist key memcopy npdu proplist ptransfer \
-	rd reject ringbuf rp rpm sbuf timesync vmac \
-	whohas whois wp objects lighting
+all: abort address arf awf bvlc bvlc6 bacapp bacdcode bacerror bacint bacstr \
+	cov crc datetime dcc event filename fifo getevent h_cov h_rpm_a hashindex \
+	iam ihave indtext keylist key memcopy npdu pollsched propcache proplist \
+	ptransfer rd reject ringbuf routing_table rp rpm rpmplan sbuf timesync \
+	tsm vmac whohas whois wp objects lighting
+
+# benchmarks report timings rather than pass/fail, so are not in "all"
+benchmarks: address_bench bacapp_bench crc_bench device_bench msgqueue_bench \
+	trendlog_bench
 
 clean: logfile
 	rm ${LOGFILE}
@@ -31,6 +35,28 @@ address: logfile test/address.mak
 	( ./test/address >> ${LOGFILE} )
 	$(MAKE) -s -C test -f address.mak clean
 
+address_bench: logfile test/address_bench.mak
+	$(MAKE) -s -C test -f address_bench.mak clean all
+	( ./test/address_bench >> ${LOGFILE} )
+	$(MAKE) -s -C test -f address_bench.mak clean
+
+msgqueue_bench: logfile test/msgqueue_bench.mak
+	$(MAKE) -s -C test -f msgqueue_bench.mak clean all
+	( ./test/msgqueue_bench >> ${LOGFILE} )
+	$(MAKE) -s -C test -f msgqueue_bench.mak clean
+
+# links with the object modules and library of the demo server
+device_bench: logfile demo/object/device_bench.mak
+	$(MAKE) -s library
+	$(MAKE) -s -C demo/object -f device_bench.mak clean all
+	( ./demo/object/device_bench >> ${LOGFILE} )
+	$(MAKE) -s -C demo/object -f device_bench.mak clean
+
+trendlog_bench: logfile demo/object/trendlog_bench.mak
+	$(MAKE) -s -C demo/object -f trendlog_bench.mak clean all
+	( ./demo/object/trendlog_bench >> ${LOGFILE} )
+	$(MAKE) -s -C demo/object -f trendlog_bench.mak clean
+
 arf: logfile test/arf.mak
 	$(MAKE) -s -C test -f arf.mak clean all
 	( ./test/arf >> ${LOGFILE} )
@@ -66,6 +92,21 @@ bacstr: logfile test/bacstr.mak
 	( ./test/bacstr >> ${LOGFILE} )
 	$(MAKE) -s -C test -f bacstr.mak clean
 
+bacapp_bench: logfile test/bacapp_bench.mak
+	$(MAKE) -s -C test -f bacapp_bench.mak clean all
+	( ./test/bacapp_bench >> ${LOGFILE} )
+	$(MAKE) -s -C test -f bacapp_bench.mak clean
+
+crc_bench: logfile test/crc_bench.mak
+	$(MAKE) -s -C test -f crc_bench.mak clean all
+	( ./test/crc_bench >> ${LOGFILE} )
+	$(MAKE) -s -C test -f crc_bench.mak clean
+
+bvlc: logfile test/bvlc.mak
+	$(MAKE) -s -C test -f bvlc.mak clean all
+	( ./test/bvlc >> ${LOGFILE} )
+	$(MAKE) -s -C test -f bvlc.mak clean
+
 bvlc6: logfile test/bvlc6.mak
 	$(MAKE) -s -C test -f bvlc6.mak clean all
 	( ./test/bvlc6 >> ${LOGFILE} )
@@ -111,6 +152,21 @@ getevent: logfile test/getevent.mak
 	( ./test/getevent >> ${LOGFILE} )
 	$(MAKE) -s -C test -f getevent.mak clean
 
+h_cov: logfile test/h_cov.mak
+	$(MAKE) -s -C test -f h_cov.mak clean all
+	( ./test/h_cov >> ${LOGFILE} )
+	$(MAKE) -s -C test -f h_cov.mak clean
+
+h_rpm_a: logfile test/h_rpm_a.mak
+	$(MAKE) -s -C test -f h_rpm_a.mak clean all
+	( ./test/h_rpm_a >> ${LOGFILE} )
+	$(MAKE) -s -C test -f h_rpm_a.mak clean
+
+hashindex: logfile test/hashindex.mak
+	$(MAKE) -s -C test -f hashindex.mak clean all
+	( ./test/hashindex >> ${LOGFILE} )
+	$(MAKE) -s -C test -f hashindex.mak clean
+
 iam: logfile test/iam.mak
 	$(MAKE) -s -C test -f iam.mak clean all
 	( ./test/iam >> ${LOGFILE} )
@@ -151,6 +207,16 @@ npdu: logfile test/npdu.mak
 	( ./test/npdu >> ${LOGFILE} )
 	$(MAKE) -s -C test -f npdu.mak clean
 
+pollsched: logfile test/pollsched.mak
+	$(MAKE) -s -C test -f pollsched.mak clean all
+	( ./test/pollsched >> ${LOGFILE} )
+	$(MAKE) -s -C test -f pollsched.mak clean
+
+propcache: logfile test/propcache.mak
+	$(MAKE) -s -C test -f propcache.mak clean all
+	( ./test/propcache >> ${LOGFILE} )
+	$(MAKE) -s -C test -f propcache.mak clean
+
 proplist: logfile test/proplist.mak
 	$(MAKE) -s -C test -f proplist.mak clean all
 	( ./test/proplist >> ${LOGFILE} )
@@ -176,6 +242,11 @@ ringbuf: logfile test/ringbuf.mak
 	( ./test/ringbuf >> ${LOGFILE} )
 	$(MAKE) -s -C test -f ringbuf.mak clean
 
+routing_table: logfile test/routing_table.mak
+	$(MAKE) -s -C test -f routing_table.mak clean all
+	( ./test/routing_table >> ${LOGFILE} )
+	$(MAKE) -s -C test -f routing_table.mak clean
+
 rp: logfile test/rp.mak
 	$(MAKE) -s -C test -f rp.mak clean all
 	( ./test/rp >> ${LOGFILE} )
@@ -186,6 +257,11 @@ rpm: logfile test/rpm.mak
 	( ./test/rpm >> ${LOGFILE} )
 	$(MAKE) -s -C test -f rpm.mak clean
 
+rpmplan: logfile test/rpmplan.mak
+	$(MAKE) -s -C test -f rpmplan.mak clean all
+	( ./test/rpmplan >> ${LOGFILE} )
+	$(MAKE) -s -C test -f rpmplan.mak clean
+
 sbuf: logfile test/sbuf.mak
 	$(MAKE) -s -C test -f sbuf.mak clean all
 	( ./test/sbuf >> ${LOGFILE} )
@@ -196,6 +272,11 @@ timesync: logfile test/timesync.mak
 	( ./test/timesync >> ${LOGFILE} )
 	$(MAKE) -s -C test -f timesync.mak clean
 
+tsm: logfile test/tsm.mak
+	$(MAKE) -s -C test -f tsm.mak clean all
+	( ./test/tsm >> ${LOGFILE} )
+	$(MAKE) -s -C test -f tsm.mak clean
+
 vmac: logfile test/vmac.mak
 	$(MAKE) -s -C test -f vmac.mak clean all
 	( ./test/vmac >> ${LOGFILE} )
@@ -216,10 +297,10 @@ wp: logfile test/wp.mak
 	( ./test/wp >> ${LOGFILE} )
 	$(MAKE) -s -C test -f wp.mak clean
 
-objects: ai ao av bi bo bv csv lc lo lso lsp \
+objects: ai ao av bi bo bv csv device lc lo lso lsp \
 	mso msv ms-input osv piv command \
 	access_credential access_door access_point access_rights \
-	access_user access_zone credential_data_input
+	access_user access_zone credential_data_input trendlog
 
 access_credential: logfile demo/object/access_credential.mak
 	$(MAKE) -s -C demo/object -f access_credential.mak clean all
@@ -256,6 +337,11 @@ credential_data_input: logfile demo/object/credential_data_input.mak
 	( ./demo/object/credential_data_input >> ${LOGFILE} )
 	$(MAKE) -s -C demo/object -f credential_data_input.mak clean
 
+trendlog: logfile demo/object/trendlog.mak
+	$(MAKE) -s -C demo/object -f trendlog.mak clean all
+	( ./demo/object/trendlog >> ${LOGFILE} )
+	$(MAKE) -s -C demo/object -f trendlog.mak clean
+
 ai: logfile demo/object/ai.mak
 	$(MAKE) -s -C demo/object -f ai.mak clean all
 	( ./demo/object/analog_input >> ${LOGFILE} )
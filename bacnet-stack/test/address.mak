@@ -2,11 +2,12 @@
 CC      = gcc
 SRC_DIR = ../src
 INCLUDES = -I../include -I.
-DEFINES = -DBIG_ENDIAN=0 -DTEST -DTEST_ADDRESS
+DEFINES = -DBIG_ENDIAN=0 -DTEST -DTEST_ADDRESS -DADDRESS_CACHE_DYNAMIC=1
 
 CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -g
 
 SRCS = $(SRC_DIR)/address.c \
+	$(SRC_DIR)/hashindex.c \
 	$(SRC_DIR)/bacaddr.c \
 	$(SRC_DIR)/bacdcode.c \
 	$(SRC_DIR)/bacint.c \
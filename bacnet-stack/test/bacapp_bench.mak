@@ -0,0 +1,40 @@
+#Makefile to build test case
+CC      = gcc
+
+SRC_DIR = ../src
+INCLUDES = -I../include -I.
+DEFINES = -DBIG_ENDIAN=0 -DTEST -DTEST_BACAPP_BENCH
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -O2
+
+SRCS = $(SRC_DIR)/bacdcode.c \
+	$(SRC_DIR)/bacint.c \
+	$(SRC_DIR)/bacstr.c \
+	$(SRC_DIR)/bacreal.c \
+	$(SRC_DIR)/bacapp.c \
+	$(SRC_DIR)/bacdevobjpropref.c \
+	$(SRC_DIR)/datetime.c \
+	$(SRC_DIR)/bactext.c \
+	$(SRC_DIR)/lighting.c \
+	$(SRC_DIR)/indtext.c \
+	ctest.c
+
+OBJS = ${SRCS:.c=.o}
+
+TARGET = bacapp_bench
+
+all: ${TARGET}
+
+${TARGET}: ${OBJS}
+	${CC} -o $@ ${OBJS}
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+
+clean:
+	rm -rf ${TARGET} $(OBJS)
+
+include: .depend
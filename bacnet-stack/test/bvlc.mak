@@ -11,6 +11,10 @@ SRCS = $(SRC_DIR)/bacdcode.c \
 	$(SRC_DIR)/bacstr.c \
 	$(SRC_DIR)/bacreal.c \
 	$(SRC_DIR)/bvlc.c \
+	$(SRC_DIR)/hashindex.c \
+	$(SRC_DIR)/bip.c \
+	$(SRC_DIR)/debug.c \
+	../ports/linux/bip-init.c \
 	ctest.c
 
 OBJS = ${SRCS:.c=.o}
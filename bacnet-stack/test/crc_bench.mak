@@ -0,0 +1,30 @@
+#Makefile to build the CRC benchmark
+CC      = gcc
+SRC_DIR = ../src
+INCLUDES = -I../include -I.
+DEFINES = -DBIG_ENDIAN=0 -DTEST_CRC_BENCH -DCRC_USE_TABLE -DCRC_USE_SLICE_BY_8
+
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -O2
+
+SRCS = $(SRC_DIR)/crc.c
+
+OBJS = ${SRCS:.c=.o}
+
+TARGET = crc_bench
+
+all: ${TARGET}
+
+${TARGET}: ${OBJS}
+	${CC} -o $@ ${OBJS}
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+
+clean:
+	rm -rf ${TARGET} $(OBJS)
+
+include: .depend
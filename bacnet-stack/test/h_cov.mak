@@ -0,0 +1,50 @@
+#Makefile to build test case
+CC      = gcc
+SRC_DIR = ../src
+HANDLER_DIR = ../demo/handler
+INCLUDES = -I../include -I. -I$(HANDLER_DIR) -I../demo/object
+DEFINES = -DBIG_ENDIAN=0 -DBACDL_ALL -DTEST -DTEST_COV_HANDLER
+
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -g
+
+SRCS = $(HANDLER_DIR)/h_cov.c \
+	$(SRC_DIR)/cov.c \
+	$(SRC_DIR)/npdu.c \
+	$(SRC_DIR)/abort.c \
+	$(SRC_DIR)/reject.c \
+	$(SRC_DIR)/bacerror.c \
+	$(SRC_DIR)/bacaddr.c \
+	$(SRC_DIR)/hashindex.c \
+	$(SRC_DIR)/memcopy.c \
+	$(SRC_DIR)/bacdcode.c \
+	$(SRC_DIR)/bacint.c \
+	$(SRC_DIR)/bacstr.c \
+	$(SRC_DIR)/bacreal.c \
+	$(SRC_DIR)/bacapp.c \
+	$(SRC_DIR)/bacdevobjpropref.c \
+	$(SRC_DIR)/datetime.c \
+	$(SRC_DIR)/lighting.c \
+	$(SRC_DIR)/bactext.c \
+	$(SRC_DIR)/indtext.c \
+	ctest.c
+
+OBJS = ${SRCS:.c=.o}
+
+TARGET = h_cov
+
+all: ${TARGET}
+
+${TARGET}: ${OBJS}
+	${CC} -o $@ ${OBJS}
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+
+clean:
+	rm -rf ${TARGET} $(OBJS)
+
+include: .depend
@@ -0,0 +1,36 @@
+#Makefile to build test case
+CC      = gcc
+SRC_DIR = ../src
+INCLUDES = -I../include -I../demo/router -I.
+DEFINES = -DBIG_ENDIAN=0 -DTEST -DTEST_MSGQUEUE_BENCH
+
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -O2
+
+SRCS = ../demo/router/msgqueue.c \
+	$(SRC_DIR)/bacdcode.c \
+	$(SRC_DIR)/bacint.c \
+	$(SRC_DIR)/bacstr.c \
+	$(SRC_DIR)/bacreal.c \
+	$(SRC_DIR)/npdu.c \
+	ctest.c
+
+OBJS = ${SRCS:.c=.o}
+
+TARGET = msgqueue_bench
+
+all: ${TARGET}
+
+${TARGET}: ${OBJS}
+	${CC} -o $@ ${OBJS} -lpthread
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+
+clean:
+	rm -rf ${TARGET} $(OBJS)
+
+include: .depend
@@ -0,0 +1,31 @@
+#Makefile to build test case
+CC      = gcc
+SRC_DIR = ../src
+INCLUDES = -I../include -I../demo/router -I.
+DEFINES = -DBIG_ENDIAN=0 -DTEST -DTEST_ROUTING_TABLE
+
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -g
+
+SRCS = ../demo/router/routing_table.c \
+	ctest.c
+
+OBJS = ${SRCS:.c=.o}
+
+TARGET = routing_table
+
+all: ${TARGET}
+
+${TARGET}: ${OBJS}
+	${CC} -o $@ ${OBJS}
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+
+clean:
+	rm -rf ${TARGET} $(OBJS)
+
+include: .depend
@@ -0,0 +1,51 @@
+#Makefile to build test case
+CC      = gcc
+SRC_DIR = ../src
+INCLUDES = -I../include -I.
+DEFINES = -DBIG_ENDIAN=0 -DTEST -DTEST_TSM -DBACDL_TEST \
+	-DBACNET_SEGMENTATION_ENABLED=1 -DMAX_APDU=480 -DMAX_SEGMENTS_ACCEPTED=1024 \
+	-DMAX_TSM_TRANSACTIONS=1024
+
+CFLAGS  = -Wall $(INCLUDES) $(DEFINES) -g
+
+SRCS = $(SRC_DIR)/bacdcode.c \
+	$(SRC_DIR)/bacint.c \
+	$(SRC_DIR)/bacstr.c \
+	$(SRC_DIR)/bacreal.c \
+	$(SRC_DIR)/npdu.c \
+	$(SRC_DIR)/apdu.c \
+	$(SRC_DIR)/dcc.c \
+	$(SRC_DIR)/abort.c \
+	$(SRC_DIR)/bacaddr.c \
+	$(SRC_DIR)/bacerror.c \
+	$(SRC_DIR)/bacapp.c \
+	$(SRC_DIR)/bacdevobjpropref.c \
+	$(SRC_DIR)/bactext.c \
+	$(SRC_DIR)/indtext.c \
+	$(SRC_DIR)/datetime.c \
+	$(SRC_DIR)/lighting.c \
+	$(SRC_DIR)/memcopy.c \
+	$(SRC_DIR)/rpm.c \
+	$(SRC_DIR)/tsm.c \
+	ctest.c
+
+TARGET = tsm
+
+all: ${TARGET}
+ 
+OBJS = ${SRCS:.c=.o}
+
+${TARGET}: ${OBJS}
+	${CC} -o $@ ${OBJS} 
+
+.c.o:
+	${CC} -c ${CFLAGS} $*.c -o $@
+	
+depend:
+	rm -f .depend
+	${CC} -MM ${CFLAGS} *.c >> .depend
+	
+clean:
+	rm -rf core ${TARGET} $(OBJS) *.bak *.1 *.ini
+
+include: .depend